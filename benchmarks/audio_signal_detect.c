@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_audio.h"
+#include "igt_core.h"
+
+#define FREQS_PER_CHANNEL 4
+
+static const int base_freqs[FREQS_PER_CHANNEL] = { 300, 700, 2000, 5000 };
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static struct audio_signal *create_signal(int channels, int rate, int len)
+{
+	struct audio_signal *signal;
+	int step = 2 * rate / len;
+	int i, c;
+
+	signal = audio_signal_init(channels, rate);
+	for (i = 0; i < FREQS_PER_CHANNEL; i++)
+		for (c = 0; c < channels; c++)
+			audio_signal_add_frequency(signal,
+						   base_freqs[i] + c * step, c);
+	audio_signal_synthesize(signal);
+
+	return signal;
+}
+
+/* The historical capture loop: extract each channel, then detect */
+static unsigned long run_oneshot(struct audio_signal *signal, int channels,
+				 int rate, const int32_t *samples,
+				 size_t frames, size_t len, size_t hop)
+{
+	double *channel = malloc(len * sizeof(double));
+	unsigned long detected = 0;
+	size_t pos;
+	int c;
+
+	for (pos = 0; pos + len <= frames; pos += hop) {
+		for (c = 0; c < channels; c++) {
+			audio_extract_channel_s32_le(channel, len,
+						     (int32_t *)&samples[pos * channels],
+						     len * channels, channels, c);
+			detected += audio_signal_detect(signal, rate, c,
+							channel, len);
+		}
+	}
+
+	free(channel);
+	return detected;
+}
+
+static unsigned long run_detector(struct audio_signal *signal, int channels,
+				  int rate, const int32_t *samples,
+				  size_t frames, size_t len, size_t hop,
+				  size_t page)
+{
+	struct audio_signal_detector *det;
+	bool detected[channels];
+	unsigned long count = 0;
+	size_t pushed, total = frames * channels;
+	int c;
+
+	det = audio_signal_detector_init(signal, rate, channels, len, hop);
+
+	pushed = 0;
+	while (pushed < total) {
+		size_t n = page * channels;
+
+		if (n > total - pushed)
+			n = total - pushed;
+
+		pushed += audio_signal_detector_push_s32_le(det,
+							    &samples[pushed],
+							    n, channels, NULL);
+		if (!audio_signal_detector_ready(det))
+			continue;
+
+		audio_signal_detector_detect(det, detected);
+		for (c = 0; c < channels; c++)
+			count += detected[c];
+	}
+
+	audio_signal_detector_fini(det);
+	return count;
+}
+
+int main(int argc, char **argv)
+{
+	struct audio_signal *signal;
+	struct timespec start, end;
+	int channels = 8, rate = 192000, len = 2048, hop = 0, page = 128;
+	int seconds = 10;
+	unsigned long detected;
+	double *buf;
+	int32_t *samples;
+	size_t frames, windows;
+	int c;
+
+	while ((c = getopt(argc, argv, "c:r:l:h:p:s:")) != -1) {
+		switch (c) {
+		case 'c':
+			channels = atoi(optarg);
+			break;
+		case 'r':
+			rate = atoi(optarg);
+			break;
+		case 'l':
+			len = atoi(optarg);
+			break;
+		case 'h':
+			hop = atoi(optarg);
+			break;
+		case 'p':
+			page = atoi(optarg);
+			break;
+		case 's':
+			seconds = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (channels < 1)
+		channels = 1;
+	if (hop < 1 || hop > len)
+		hop = len;
+	if (page < 1)
+		page = 1;
+
+	signal = create_signal(channels, rate, len);
+
+	frames = (size_t)rate * seconds;
+	buf = malloc(frames * channels * sizeof(double));
+	samples = malloc(frames * channels * sizeof(int32_t));
+	audio_signal_fill(signal, buf, frames);
+	audio_convert_to(samples, buf, frames * channels,
+			 SND_PCM_FORMAT_S32_LE);
+	free(buf);
+
+	windows = (frames - len) / hop + 1;
+	printf("%d channels, %d Hz, %zu windows of %d samples, hop %d\n",
+	       channels, rate, windows, len, hop);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	detected = run_oneshot(signal, channels, rate, samples,
+			       frames, len, hop);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("oneshot:  %7.3f us/window, %lu/%zu detected\n",
+	       1e6 * elapsed(&start, &end) / windows,
+	       detected, windows * channels);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	detected = run_detector(signal, channels, rate, samples,
+				frames, len, hop, page);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("detector: %7.3f us/window, %lu/%zu detected\n",
+	       1e6 * elapsed(&start, &end) / windows,
+	       detected, windows * channels);
+
+	free(samples);
+	audio_signal_fini(signal);
+
+	return 0;
+}
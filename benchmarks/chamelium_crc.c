@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_chamelium_crc.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+
+/*
+ * Reference Chamelium CRCs of 4k and 8k XRGB8888 frames, with each
+ * implementation and split across threads, against the four passes of one
+ * division per pixel that chamelium_xrgb_hash16() used to take:
+ *
+ *   chamelium_crc -l 10
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static uint32_t fourpass_hash16(const unsigned char *buffer, size_t count,
+				unsigned int k, unsigned int m)
+{
+	uint64_t sum = 0, n = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t value;
+
+		if ((i % m) != k)
+			continue;
+
+		value = buffer[4 * i + 2] |
+			buffer[4 * i + 1] << 8 |
+			buffer[4 * i + 0] << 16;
+		sum += ++n * value;
+	}
+
+	return (sum ^ sum >> 16 ^ sum >> 32 ^ sum >> 48) & 0xffff;
+}
+
+static void fourpass(const void *pixels, size_t count,
+		     uint32_t crc[IGT_CHAMELIUM_CRC_WORDS])
+{
+	for (int i = 0; i < IGT_CHAMELIUM_CRC_WORDS; i++)
+		crc[i] = fourpass_hash16(pixels, count,
+					 IGT_CHAMELIUM_CRC_WORDS - i - 1,
+					 IGT_CHAMELIUM_CRC_WORDS);
+}
+
+static void report(const char *name,
+		   void (*fn)(const void *, size_t, uint32_t *),
+		   const void *pixels, size_t count, int loops)
+{
+	uint32_t crc[IGT_CHAMELIUM_CRC_WORDS];
+	struct timespec start, end;
+	double t;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++)
+		fn(pixels, count, crc);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t = elapsed(&start, &end) / loops;
+
+	printf("  %-10s %04x:%04x:%04x:%04x %8.2f ms %7.3f GB/s\n",
+	       name, crc[0], crc[1], crc[2], crc[3],
+	       1e3 * t, 1e-9 * 4 * count / t);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct {
+		const char *name;
+		int width, height;
+	} frames[] = {
+		{ "4k", 3840, 2160 },
+		{ "8k", 7680, 4320 },
+	};
+	const struct igt_chamelium_crc_impl *impl;
+	uint32_t seed = 0x1234;
+	uint32_t *pixels;
+	size_t largest = 0;
+	int loops = 5;
+	int c;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(frames); i++)
+		largest = max(largest, (size_t)frames[i].width * frames[i].height);
+
+	pixels = malloc(largest * sizeof(*pixels));
+	igt_assert(pixels);
+	for (size_t i = 0; i < largest; i++)
+		pixels[i] = hars_petruska_f54_1_random(&seed);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(frames); i++) {
+		size_t count = (size_t)frames[i].width * frames[i].height;
+
+		printf("%s (%dx%d):\n",
+		       frames[i].name, frames[i].width, frames[i].height);
+
+		report("fourpass", fourpass, pixels, count, loops);
+
+		for (impl = igt_chamelium_crc_impls; impl->name; impl++) {
+			if (!impl->supported())
+				continue;
+
+			report(impl->name, impl->crc, pixels, count, loops);
+		}
+
+		report("default", igt_chamelium_xrgb_crc,
+		       pixels, count, loops);
+		report("parallel", igt_chamelium_xrgb_crc_parallel,
+		       pixels, count, loops);
+	}
+
+	free(pixels);
+
+	return 0;
+}
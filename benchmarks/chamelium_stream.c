@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xmlrpc-c/base.h>
+
+#include "igt_chamelium_stream.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "../lib/tests/chamelium_stream_server.h"
+
+/*
+ * Receives captured frames from a local stand-in for the Chamelium stream
+ * server, against decoding the same frames out of the XML-RPC responses
+ * ReadCapturedFrame used to be limited to. Only the client side parsing of
+ * the latter is measured, not the transfer of the 4/3 larger text:
+ *
+ *   chamelium_stream -w 3840 -h 2160 -n 8
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static double run_stream(struct chamelium_stream *client, int count,
+			 int loops, unsigned char **frames, size_t size)
+{
+	struct timespec start, end;
+	unsigned char *buf = NULL;
+	size_t buf_size = 0;
+	int w, h;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++)
+		for (int i = 0; i < count; i++)
+			igt_assert(chamelium_stream_read_captured_frame(client, i,
+									&buf,
+									&buf_size,
+									&w, &h));
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	igt_assert(!memcmp(buf, frames[count - 1], size));
+	free(buf);
+
+	return elapsed(&start, &end);
+}
+
+static double run_xmlrpc(int count, int loops, unsigned char **frames,
+			 size_t size)
+{
+	xmlrpc_mem_block **xml = calloc(count, sizeof(*xml));
+	struct timespec start, end;
+	xmlrpc_env env;
+
+	igt_assert(xml);
+
+	xmlrpc_env_init(&env);
+	xmlrpc_limit_set(XMLRPC_XML_SIZE_LIMIT_ID, 2 * size + 4096);
+
+	for (int i = 0; i < count; i++) {
+		xmlrpc_value *value = xmlrpc_base64_new(&env, size, frames[i]);
+
+		xml[i] = XMLRPC_MEMBLOCK_NEW(char, &env, 0);
+		xmlrpc_serialize_response(&env, xml[i], value);
+		igt_assert(!env.fault_occurred);
+		xmlrpc_DECREF(value);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++) {
+		for (int i = 0; i < count; i++) {
+			const unsigned char *bgr;
+			const char *fault_string;
+			xmlrpc_value *res;
+			int fault_code;
+			size_t len;
+
+			xmlrpc_parse_response2(&env,
+					       XMLRPC_MEMBLOCK_CONTENTS(char, xml[i]),
+					       XMLRPC_MEMBLOCK_SIZE(char, xml[i]),
+					       &res, &fault_code, &fault_string);
+			igt_assert(!env.fault_occurred && res);
+
+			xmlrpc_read_base64(&env, res, &len, &bgr);
+			igt_assert_eq(len, size);
+
+			free((void *)bgr);
+			xmlrpc_DECREF(res);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (int i = 0; i < count; i++)
+		XMLRPC_MEMBLOCK_FREE(char, xml[i]);
+	free(xml);
+	xmlrpc_env_clean(&env);
+
+	return elapsed(&start, &end);
+}
+
+int main(int argc, char **argv)
+{
+	int width = 3840, height = 2160, count = 4, loops = 3;
+	struct chamelium_stream_server *server;
+	struct chamelium_stream *client;
+	uint32_t seed = 0x1234;
+	unsigned char **frames;
+	igt_crc_t *crcs;
+	double mib, t;
+	size_t size;
+	int c;
+
+	while ((c = getopt(argc, argv, "w:h:n:l:")) != -1) {
+		switch (c) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'h':
+			height = atoi(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-w width] [-h height] [-n frames] [-l loops]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	if (width < 1 || height < 1 || count < 1 || loops < 1)
+		return 1;
+
+	size = (size_t)width * height * 3;
+	mib = (double)size * count * loops / (1 << 20);
+
+	frames = calloc(count, sizeof(*frames));
+	crcs = calloc(count, sizeof(*crcs));
+	igt_assert(frames && crcs);
+	for (int i = 0; i < count; i++) {
+		frames[i] = malloc(size);
+		igt_assert(frames[i]);
+		for (size_t j = 0; j < size; j++)
+			frames[i][j] = hars_petruska_f54_1_random(&seed);
+		crcs[i].n_words = 4;
+	}
+
+	server = chamelium_stream_server_create(width, height, frames,
+						crcs, count);
+	igt_assert(server);
+	client = chamelium_stream_init_host("127.0.0.1",
+					    chamelium_stream_server_port(server));
+	igt_assert(client);
+
+	printf("%d frames of %dx%d, %.1f MiB each\n",
+	       count, width, height, size / 1048576.);
+
+	t = run_stream(client, count, loops, frames, size);
+	printf("  stream: %8.2f ms/frame, %8.1f MiB/s\n",
+	       1e3 * t / (count * loops), mib / t);
+
+	t = run_xmlrpc(count, loops, frames, size);
+	printf("  xmlrpc: %8.2f ms/frame, %8.1f MiB/s\n",
+	       1e3 * t / (count * loops), mib / t);
+
+	chamelium_stream_deinit(client);
+	chamelium_stream_server_destroy(server);
+
+	for (int i = 0; i < count; i++)
+		free(frames[i]);
+	free(frames);
+	free(crcs);
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_crc.h"
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static void report(const char *name, uint32_t (*fn)(const void *, size_t),
+		   const void *buf, size_t size, int loops)
+{
+	struct timespec start, end;
+	uint32_t crc = 0;
+	int n;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (n = 0; n < loops; n++)
+		crc = fn(buf, size);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	printf("%-10s %08x %7.3f GB/s\n", name, crc,
+	       1e-9 * size * loops / elapsed(&start, &end));
+}
+
+static const struct igt_crc32_impl *impl;
+
+static uint32_t impl_crc32(const void *buf, size_t size)
+{
+	return impl->update(0, buf, size);
+}
+
+int main(int argc, char **argv)
+{
+	/* Default to a 8k XRGB8888 framebuffer */
+	size_t size = 7680 * 4320 * 4;
+	int loops = 5;
+	uint8_t *buf;
+	size_t i;
+	int c;
+
+	while ((c = getopt(argc, argv, "s:l:")) != -1) {
+		switch (c) {
+		case 's':
+			size = strtoull(optarg, NULL, 0);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	buf = malloc(size);
+	igt_assert(buf);
+	for (i = 0; i < size; i++)
+		buf[i] = i * 7 + (i >> 12);
+
+	for (impl = igt_crc32_impls; impl->name; impl++) {
+		if (!impl->supported())
+			continue;
+
+		report(impl->name, impl_crc32, buf, size, loops);
+	}
+
+	report("default", igt_cpu_crc32, buf, size, loops);
+	report("parallel", igt_cpu_crc32_parallel, buf, size, loops);
+
+	free(buf);
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_device_scan.h"
+
+/*
+ * Scan of the devices of the host through udev, every time against read back
+ * from the scan cache:
+ *
+ *   device_scan -l 100
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static double scan(int loops)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++) {
+		igt_devices_free();
+		igt_devices_scan(false);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/device_scan.XXXXXX";
+	char path[sizeof(dir) + 8];
+	double udev, cached;
+	int loops = 20;
+	int c;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	igt_assert(mkdtemp(dir));
+	snprintf(path, sizeof(path), "%s/devices", dir);
+
+	unsetenv("IGT_DEVICE_SCAN_CACHE");
+	udev = scan(loops);
+
+	/* The first scan fills the cache, and is not counted */
+	setenv("IGT_DEVICE_SCAN_CACHE", path, 1);
+	scan(1);
+	cached = scan(loops);
+
+	printf("ms per scan: udev %.3f, cached %.3f\n", 1e3 * udev, 1e3 * cached);
+
+	igt_devices_free();
+	unlink(path);
+	rmdir(dir);
+
+	return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xf86drmMode.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_fb_cache.h"
+
+/*
+ * Creation of pattern framebuffers, painted and converted every time against
+ * copied from the framebuffer cache, in memory or on disk, for every format
+ * a plane of the device supports:
+ *
+ *   fb_cache -w 3840 -h 2160 -l 5
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static bool has_format(const uint32_t *formats, int count, uint32_t format)
+{
+	for (int i = 0; i < count; i++)
+		if (formats[i] == format)
+			return true;
+
+	return false;
+}
+
+/* The union of the formats of all planes, which igt_fb can draw into */
+static int plane_formats(int fd, uint32_t **formats)
+{
+	drmModePlaneResPtr res;
+	int count = 0;
+
+	drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+	res = drmModeGetPlaneResources(fd);
+	igt_assert(res);
+
+	*formats = NULL;
+	for (int i = 0; i < res->count_planes; i++) {
+		drmModePlanePtr plane = drmModeGetPlane(fd, res->planes[i]);
+
+		igt_assert(plane);
+		for (int j = 0; j < plane->count_formats; j++) {
+			uint32_t format = plane->formats[j];
+
+			if (!igt_fb_supported_format(format) ||
+			    has_format(*formats, count, format))
+				continue;
+
+			*formats = realloc(*formats, (count + 1) * sizeof(**formats));
+			igt_assert(*formats);
+			(*formats)[count++] = format;
+		}
+		drmModeFreePlane(plane);
+	}
+
+	drmModeFreePlaneResources(res);
+
+	return count;
+}
+
+static double create_fbs(int fd, int width, int height, uint32_t format,
+			 int loops, bool drop)
+{
+	struct timespec start, end;
+	struct igt_fb fb;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++) {
+		if (drop)
+			igt_fb_cache_drop();
+
+		igt_create_pattern_fb(fd, width, height, format,
+				      DRM_FORMAT_MOD_LINEAR, &fb);
+		igt_remove_fb(fd, &fb);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+int main(int argc, char **argv)
+{
+	char dir[] = "/tmp/fb_cache.XXXXXX";
+	char cmd[64];
+	int width = 1920, height = 1080;
+	uint32_t *formats;
+	int loops = 3;
+	int fd, count, c;
+
+	while ((c = getopt(argc, argv, "w:h:l:")) != -1) {
+		switch (c) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'h':
+			height = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	fd = drm_open_driver_master(DRIVER_ANY);
+	count = plane_formats(fd, &formats);
+	igt_assert(mkdtemp(dir));
+
+	printf("%dx%d, ms per framebuffer:\n", width, height);
+	printf("  %-8s %10s %10s %10s\n", "format", "uncached", "memory", "disk");
+
+	for (int i = 0; i < count; i++) {
+		double uncached, memory, disk;
+
+		igt_fb_cache_set_dir(NULL);
+		igt_fb_cache_set_limit(0);
+		uncached = create_fbs(fd, width, height, formats[i], loops, false);
+
+		/* The first framebuffer fills the cache, and is not counted */
+		igt_fb_cache_set_limit(1ull << 30);
+		igt_fb_cache_set_dir(dir);
+		create_fbs(fd, width, height, formats[i], 1, false);
+
+		memory = create_fbs(fd, width, height, formats[i], loops, false);
+		disk = create_fbs(fd, width, height, formats[i], loops, true);
+
+		printf("  %-8s %10.2f %10.2f %10.2f\n",
+		       igt_format_str(formats[i]),
+		       1e3 * uncached, 1e3 * memory, 1e3 * disk);
+	}
+
+	igt_fb_cache_set_dir(NULL);
+	igt_fb_cache_drop();
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+	igt_assert_eq(system(cmd), 0);
+
+	free(formats);
+	close(fd);
+
+	return 0;
+}
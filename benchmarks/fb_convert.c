@@ -0,0 +1,179 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xf86drmMode.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_fb_cache.h"
+
+/*
+ * Conversion of framebuffers to and from the format cairo draws them in, for
+ * every format a plane of the device supports. Reading in is timed by
+ * creating a cairo context and releasing it without drawing anything, and
+ * writing back by igt_create_color_fb(), which doesn't read in:
+ *
+ *   fb_convert -w 3840 -h 2160 -l 5
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static bool has_format(const uint32_t *formats, int count, uint32_t format)
+{
+	for (int i = 0; i < count; i++)
+		if (formats[i] == format)
+			return true;
+
+	return false;
+}
+
+/* The union of the formats of all planes, which igt_fb can draw into */
+static int plane_formats(int fd, uint32_t **formats)
+{
+	drmModePlaneResPtr res;
+	int count = 0;
+
+	drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+	res = drmModeGetPlaneResources(fd);
+	igt_assert(res);
+
+	*formats = NULL;
+	for (int i = 0; i < res->count_planes; i++) {
+		drmModePlanePtr plane = drmModeGetPlane(fd, res->planes[i]);
+
+		igt_assert(plane);
+		for (int j = 0; j < plane->count_formats; j++) {
+			uint32_t format = plane->formats[j];
+
+			if (!igt_fb_supported_format(format) ||
+			    has_format(*formats, count, format))
+				continue;
+
+			*formats = realloc(*formats, (count + 1) * sizeof(**formats));
+			igt_assert(*formats);
+			(*formats)[count++] = format;
+		}
+		drmModeFreePlane(plane);
+	}
+
+	drmModeFreePlaneResources(res);
+
+	return count;
+}
+
+static double read_in(int fd, struct igt_fb *fb, int loops)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++)
+		igt_put_cairo_ctx(igt_get_cairo_ctx(fd, fb));
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+static double write_back(int fd, int width, int height, uint32_t format,
+			 int loops)
+{
+	struct timespec start, end;
+	struct igt_fb fb;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++) {
+		igt_create_color_fb(fd, width, height, format,
+				    DRM_FORMAT_MOD_LINEAR, 0.25, 0.5, 0.75, &fb);
+		igt_remove_fb(fd, &fb);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+int main(int argc, char **argv)
+{
+	int width = 1920, height = 1080;
+	uint32_t *formats;
+	int loops = 3;
+	int fd, count, c;
+
+	while ((c = getopt(argc, argv, "w:h:l:")) != -1) {
+		switch (c) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'h':
+			height = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	fd = drm_open_driver_master(DRIVER_ANY);
+	count = plane_formats(fd, &formats);
+
+	/* Every framebuffer gets converted */
+	igt_fb_cache_set_limit(0);
+
+	printf("%dx%d, ms per conversion:\n", width, height);
+	printf("  %-8s %10s %10s\n", "format", "read in", "write back");
+
+	for (int i = 0; i < count; i++) {
+		double in, out;
+		struct igt_fb fb;
+
+		igt_create_color_fb(fd, width, height, formats[i],
+				    DRM_FORMAT_MOD_LINEAR, 0.25, 0.5, 0.75, &fb);
+		in = read_in(fd, &fb, loops);
+		igt_remove_fb(fd, &fb);
+
+		out = write_back(fd, width, height, formats[i], loops);
+
+		printf("  %-8s %10.2f %10.2f\n", igt_format_str(formats[i]),
+		       1e3 * in, 1e3 * out);
+	}
+
+	free(formats);
+	close(fd);
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xf86drmMode.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_fb_cache.h"
+
+/*
+ * Drawing into large framebuffers cairo can't draw into directly: a small
+ * rectangle drawn with raw cairo calls, which converts the whole framebuffer
+ * back, against one drawn with igt_paint_color(), which only converts that
+ * rectangle back, and a framebuffer created and filled by hand against
+ * igt_create_color_fb(), which doesn't read the framebuffer in first:
+ *
+ *   fb_damage -w 3840 -h 2160 -l 5
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static bool plane_supports(int fd, uint32_t format)
+{
+	drmModePlaneResPtr res;
+	bool found = false;
+
+	drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+	res = drmModeGetPlaneResources(fd);
+	igt_assert(res);
+
+	for (int i = 0; i < res->count_planes && !found; i++) {
+		drmModePlanePtr plane = drmModeGetPlane(fd, res->planes[i]);
+
+		igt_assert(plane);
+		for (int j = 0; j < plane->count_formats; j++)
+			if (plane->formats[j] == format)
+				found = true;
+		drmModeFreePlane(plane);
+	}
+
+	drmModeFreePlaneResources(res);
+
+	return found;
+}
+
+enum draw {
+	SMALL_RAW,
+	SMALL_HELPER,
+	FULL_READ_IN,
+	FULL_WRITE_ONLY,
+};
+
+static void draw(int fd, struct igt_fb *fb, enum draw mode)
+{
+	cairo_t *cr;
+
+	switch (mode) {
+	case SMALL_RAW:
+		cr = igt_get_cairo_ctx(fd, fb);
+		cairo_rectangle(cr, 64, 64, 64, 64);
+		cairo_set_source_rgb(cr, 1, 0, 0);
+		cairo_fill(cr);
+		igt_put_cairo_ctx(cr);
+		break;
+	case SMALL_HELPER:
+		cr = igt_get_cairo_ctx(fd, fb);
+		igt_paint_color(cr, 64, 64, 64, 64, 1, 0, 0);
+		igt_put_cairo_ctx(cr);
+		break;
+	case FULL_READ_IN:
+		igt_create_fb(fd, fb->width, fb->height, fb->drm_format,
+			      DRM_FORMAT_MOD_LINEAR, fb);
+		cr = igt_get_cairo_ctx(fd, fb);
+		igt_paint_color(cr, 0, 0, fb->width, fb->height, 1, 0, 0);
+		igt_put_cairo_ctx(cr);
+		igt_remove_fb(fd, fb);
+		break;
+	case FULL_WRITE_ONLY:
+		igt_create_color_fb(fd, fb->width, fb->height, fb->drm_format,
+				    DRM_FORMAT_MOD_LINEAR, 1, 0, 0, fb);
+		igt_remove_fb(fd, fb);
+		break;
+	}
+}
+
+static double time_draw(int fd, struct igt_fb *fb, enum draw mode, int loops)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++)
+		draw(fd, fb, mode);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+int main(int argc, char **argv)
+{
+	static const uint32_t formats[] = {
+		DRM_FORMAT_NV12,
+		DRM_FORMAT_P010,
+		DRM_FORMAT_YUYV,
+		DRM_FORMAT_XVYU2101010,
+		DRM_FORMAT_XRGB16161616F,
+		DRM_FORMAT_ARGB16161616F,
+	};
+	int width = 3840, height = 2160;
+	int loops = 3;
+	int fd, c;
+
+	while ((c = getopt(argc, argv, "w:h:l:")) != -1) {
+		switch (c) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'h':
+			height = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	fd = drm_open_driver_master(DRIVER_ANY);
+
+	/* Every framebuffer gets drawn */
+	igt_fb_cache_set_limit(0);
+
+	printf("%dx%d, ms per draw:\n", width, height);
+	printf("  %-8s %10s %10s %10s %10s\n", "format",
+	       "small raw", "small", "full", "write-only");
+
+	for (int i = 0; i < ARRAY_SIZE(formats); i++) {
+		double t[4];
+		struct igt_fb fb;
+
+		if (!igt_fb_supported_format(formats[i]) ||
+		    !plane_supports(fd, formats[i]))
+			continue;
+
+		igt_create_fb(fd, width, height, formats[i],
+			      DRM_FORMAT_MOD_LINEAR, &fb);
+		t[SMALL_RAW] = time_draw(fd, &fb, SMALL_RAW, loops);
+		t[SMALL_HELPER] = time_draw(fd, &fb, SMALL_HELPER, loops);
+		igt_remove_fb(fd, &fb);
+
+		t[FULL_READ_IN] = time_draw(fd, &fb, FULL_READ_IN, loops);
+		t[FULL_WRITE_ONLY] = time_draw(fd, &fb, FULL_WRITE_ONLY, loops);
+
+		printf("  %-8s %10.2f %10.2f %10.2f %10.2f\n",
+		       igt_format_str(formats[i]),
+		       1e3 * t[SMALL_RAW], 1e3 * t[SMALL_HELPER],
+		       1e3 * t[FULL_READ_IN], 1e3 * t[FULL_WRITE_ONLY]);
+	}
+
+	close(fd);
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <cairo.h>
+
+#include "igt_core.h"
+#include "igt_frame.h"
+#include "igt_rand.h"
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+/*
+ * Fill a reference checkerboard and a capture of it with a linear, DAC-ADC
+ * like error plus some noise.
+ */
+static void fill_frames(cairo_surface_t *reference, cairo_surface_t *capture,
+			int square)
+{
+	int width = cairo_image_surface_get_width(reference);
+	int height = cairo_image_surface_get_height(reference);
+	int ref_stride = cairo_image_surface_get_stride(reference);
+	int cap_stride = cairo_image_surface_get_stride(capture);
+	uint8_t *ref = cairo_image_surface_get_data(reference);
+	uint8_t *cap = cairo_image_surface_get_data(capture);
+	uint32_t seed = 0x12345678;
+	int x, y, c;
+
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			uint8_t *r = ref + y * ref_stride + 4 * x;
+			uint8_t *p = cap + y * cap_stride + 4 * x;
+			bool odd = ((x / square) + (y / square)) & 1;
+
+			for (c = 0; c < 3; c++) {
+				int v = odd ? (x + 3 * c) % 250 : (y + c) % 250;
+				int e = v / 16 + hars_petruska_f54_1_random(&seed) % 3;
+
+				r[c] = v;
+				p[c] = v + e > 255 ? 255 : v + e;
+			}
+			r[3] = p[3] = 0;
+		}
+	}
+
+	cairo_surface_mark_dirty(reference);
+	cairo_surface_mark_dirty(capture);
+}
+
+int main(int argc, char **argv)
+{
+	cairo_surface_t *reference, *capture;
+	struct timespec start, end;
+	int width = 3840, height = 2160, loops = 10;
+	bool analog, checkerboard;
+	int c, n;
+
+	while ((c = getopt(argc, argv, "w:h:l:")) != -1) {
+		switch (c) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'h':
+			height = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	reference = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+					       width, height);
+	capture = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+					     width, height);
+	fill_frames(reference, capture, 64);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (n = 0; n < loops; n++)
+		analog = igt_check_analog_frame_match(reference, capture);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("analog:       %8.3f ms/frame (%s)\n",
+	       1e3 * elapsed(&start, &end) / loops,
+	       analog ? "match" : "no match");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (n = 0; n < loops; n++)
+		checkerboard = igt_check_checkerboard_frame_match(reference,
+								  capture);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("checkerboard: %8.3f ms/frame (%s)\n",
+	       1e3 * elapsed(&start, &end) / loops,
+	       checkerboard ? "match" : "no match");
+
+	cairo_surface_destroy(capture);
+	cairo_surface_destroy(reference);
+
+	return 0;
+}
@@ -41,57 +41,12 @@
 
 #include "drm.h"
 #include "drmtest.h"
+#include "gem_exec_trace.h"
 #include "i915/gem_create.h"
 #include "igt_stats.h"
 #include "intel_io.h"
 #include "ioctl_wrappers.h"
 
-enum {
-	ADD_BO = 0,
-	DEL_BO,
-	ADD_CTX,
-	DEL_CTX,
-	EXEC,
-	WAIT,
-};
-
-struct trace_add_bo {
-	uint32_t handle;
-	uint64_t size;
-} __attribute__((packed));
-
-struct trace_del_bo {
-	uint32_t handle;
-} __attribute__((packed));
-
-struct trace_add_ctx {
-	uint32_t handle;
-} __attribute__((packed));
-
-struct trace_del_ctx {
-	uint32_t handle;
-} __attribute__((packed));
-
-struct trace_exec {
-	uint32_t object_count;
-	uint64_t flags;
-	uint32_t context;
-}__attribute__((packed));
-
-struct trace_exec_object {
-	uint32_t handle;
-	uint32_t relocation_count;
-	uint64_t alignment;
-	uint64_t offset;
-	uint64_t flags;
-	uint64_t rsvd1;
-	uint64_t rsvd2;
-}__attribute__((packed));
-
-struct trace_wait {
-	uint32_t handle;
-} __attribute__((packed));
-
 static uint32_t hars_petruska_f54_1_random(void)
 {
 	static uint32_t state = 0x12345678;
@@ -113,52 +68,57 @@ static uint32_t __gem_context_create_local(int fd)
 	return arg.ctx_id;
 }
 
-static double replay(const char *filename, long nop, long range)
+static void sleep_until(const struct timespec *start, uint64_t ns)
+{
+	struct timespec ts = {
+		.tv_sec = start->tv_sec + ns / 1000000000,
+		.tv_nsec = start->tv_nsec + ns % 1000000000,
+	};
+
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_nsec -= 1000000000;
+		ts.tv_sec++;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+			       &ts, NULL) == EINTR)
+		;
+}
+
+static bool next_chunk(struct trace_reader *r, uint8_t **ptr, uint8_t **end)
+{
+	size_t len;
+
+	do {
+		*ptr = trace_reader_next(r, &len);
+		if (!*ptr)
+			return false;
+	} while (!len);
+
+	*end = *ptr + len;
+	return true;
+}
+
+static double replay(const char *filename, long nop, long range,
+		     bool dry_run, bool timed)
 {
 	struct timespec t_start, t_end;
 	struct drm_i915_gem_execbuffer2 eb = {};
-	const struct trace_version {
-		uint32_t magic;
-		uint32_t version;
-	} *tv;
 	const uint32_t bbe = 0xa << 23;
 	struct drm_i915_gem_exec_object2 *exec_objects = NULL;
+	struct trace_reader_stats stats;
+	struct trace_reader *r;
+	unsigned long records = 0;
 	uint32_t *bo, *ctx;
 	int num_bo, num_ctx;
 	int max_objects = 0;
-	struct stat st;
 	uint8_t *ptr, *end;
-	int fd;
-
-	fd = open(filename, O_RDONLY);
-	if (fd < 0)
-		return -1;
-
-	if (fstat(fd, &st) < 0) {
-		close(fd);
-		return -1;
-	}
-
-	ptr = mmap(0, st.st_size, PROT_WRITE, MAP_PRIVATE, fd, 0);
-	close(fd);
-
-	if (ptr == MAP_FAILED)
-		return -1;
+	double ms;
+	int fd = -1;
 
-	madvise(ptr, st.st_size, MADV_SEQUENTIAL);
-	end = ptr + st.st_size;
-
-	tv = (struct trace_version *)ptr;
-	if (tv->magic != 0xdeadbeef) {
-		fprintf(stderr, "%s: invalid magic\n", filename);
-		return -1;
-	}
-	if (tv->version != 1) {
-		fprintf(stderr, "%s: unhandled version %d\n",
-			filename, tv->version);
+	r = trace_reader_open(filename, true);
+	if (!r)
 		return -1;
-	}
-	ptr = (void *)(tv + 1);
 
 	ctx = calloc(1024, sizeof(*ctx));
 	num_ctx = 1024;
@@ -166,24 +126,32 @@ static double replay(const char *filename, long nop, long range)
 	bo = calloc(4096, sizeof(*bo));
 	num_bo = 4096;
 
-	fd = drm_open_driver(DRIVER_INTEL);
-	if (nop > 0) {
+	if (dry_run) {
+		/* Only decode the trace, without a device to replay on */
+	} else if (nop > 0) {
+		fd = drm_open_driver(DRIVER_INTEL);
 		bo[0] = gem_create(fd, nop + range);
 		gem_write(fd, bo[0], nop + range - sizeof(bbe),
 			  &bbe, sizeof(bbe));
 		range *= 2;
 		range -= 64;
 	} else {
+		fd = drm_open_driver(DRIVER_INTEL);
 		bo[0] = gem_create(fd, 4096);
 		gem_write(fd, bo[0], 0, &bbe, sizeof(bbe));
 	}
 
 	clock_gettime(CLOCK_MONOTONIC, &t_start);
-	do switch (*ptr++) {
+	if (!next_chunk(r, &ptr, &end))
+		goto done;
+
+	do switch (records++, *ptr++) {
 	case ADD_BO:
 		{
 			struct trace_add_bo *t = (void *)ptr;
 			ptr = (void *)(t + 1);
+			if (dry_run)
+				break;
 
 			if (t->handle >= num_bo) {
 				int new_bo = ALIGN(t->handle, 4096);
@@ -199,6 +167,8 @@ static double replay(const char *filename, long nop, long range)
 		{
 			struct trace_del_bo *t = (void *)ptr;
 			ptr = (void *)(t + 1);
+			if (dry_run)
+				break;
 
 			assert(t->handle && t->handle < num_bo && bo[t->handle]);
 			gem_close(fd, bo[t->handle]);
@@ -209,6 +179,8 @@ static double replay(const char *filename, long nop, long range)
 		{
 			struct trace_add_ctx *t = (void *)ptr;
 			ptr = (void *)(t + 1);
+			if (dry_run)
+				break;
 
 			if (t->handle >= num_ctx) {
 				int new_ctx = ALIGN(t->handle, 1024);
@@ -224,6 +196,8 @@ static double replay(const char *filename, long nop, long range)
 		{
 			struct trace_del_ctx *t = (void *)ptr;
 			ptr = (void *)(t + 1);
+			if (dry_run)
+				break;
 
 			assert(t->handle < num_ctx && ctx[t->handle]);
 			gem_context_destroy(fd, ctx[t->handle]);
@@ -237,7 +211,7 @@ static double replay(const char *filename, long nop, long range)
 
 			eb.buffer_count = t->object_count;
 			eb.flags = t->flags;
-			eb.rsvd1 = ctx[t->context];
+			eb.rsvd1 = dry_run ? 0 : ctx[t->context];
 
 			if (eb.buffer_count >= max_objects) {
 				free(exec_objects);
@@ -252,7 +226,7 @@ static double replay(const char *filename, long nop, long range)
 				struct trace_exec_object *to = (void *)ptr;
 				ptr = (void *)(to + 1);
 
-				exec_objects[i].handle = bo[to->handle];
+				exec_objects[i].handle = dry_run ? 0 : bo[to->handle];
 				exec_objects[i].alignment = to->alignment;
 				exec_objects[i].offset = to->offset;
 				exec_objects[i].flags = to->flags;
@@ -262,7 +236,7 @@ static double replay(const char *filename, long nop, long range)
 				exec_objects[i].relocation_count = to->relocation_count;
 				exec_objects[i].relocs_ptr = (uintptr_t)ptr;
 
-				if (!(eb.flags & I915_EXEC_HANDLE_LUT)) {
+				if (!dry_run && !(eb.flags & I915_EXEC_HANDLE_LUT)) {
 					struct drm_i915_gem_relocation_entry *relocs =
 						(struct drm_i915_gem_relocation_entry *)ptr;
 					for (uint32_t j = 0; j < to->relocation_count; j++)
@@ -271,6 +245,8 @@ static double replay(const char *filename, long nop, long range)
 
 				ptr += sizeof(struct drm_i915_gem_relocation_entry) * to->relocation_count;
 			}
+			if (dry_run)
+				break;
 
 			((struct drm_i915_gem_exec_object2 *)
 			 memset(&exec_objects[eb.buffer_count++], 0,
@@ -290,19 +266,55 @@ static double replay(const char *filename, long nop, long range)
 		{
 			struct trace_wait *t = (void *)ptr;
 			ptr = (void *)(t + 1);
+			if (dry_run)
+				break;
 
 			assert(t->handle && t->handle < num_bo && bo[t->handle]);
 			gem_wait(fd, bo[t->handle], NULL);
 			break;
 		}
 
+	case TIMESTAMP:
+		{
+			struct trace_timestamp *t = (void *)ptr;
+			ptr = (void *)(t + 1);
+			records--;
+
+			if (timed && !dry_run)
+				sleep_until(&t_start, t->time);
+			break;
+		}
+
 	default:
-		fprintf(stderr, "Unknown cmd: %x\n", *ptr);
+		fprintf(stderr, "Unknown cmd: %x\n", *--ptr);
+		trace_reader_close(r);
 		return -1;
-	} while (ptr < end);
+	} while (ptr < end || next_chunk(r, &ptr, &end));
+done:
 	clock_gettime(CLOCK_MONOTONIC, &t_end);
 
-	return elapsed(&t_start, &t_end);
+	ms = elapsed(&t_start, &t_end);
+	trace_reader_stats(r, &stats);
+	if (trace_reader_error(r))
+		ms = -1;
+	trace_reader_close(r);
+
+	if (dry_run)
+		printf("%s: version %u, %lu records in %lu blocks, %.1fMiB decoded from %.1fMiB (%.1fMiB raw), %.1fMiB/s\n",
+		       filename, stats.version, records,
+		       (unsigned long)stats.blocks,
+		       stats.decoded_bytes / 1048576.,
+		       stats.file_bytes / 1048576.,
+		       stats.raw_bytes / 1048576.,
+		       stats.decoded_bytes / 1048576. / (ms * 1e-3));
+
+	free(exec_objects);
+	free(bo);
+	free(ctx);
+	if (fd != -1)
+		close(fd);
+
+	return ms;
 }
 
 static long calibrate_nop(int usecs)
@@ -367,6 +379,8 @@ static int measure_nop(long nop)
 int main(int argc, char **argv)
 {
 	int delay = 1000;
+	bool dry_run = false;
+	bool timed = false;
 	double *results;
 	long nop = 0;
 	long range = 0;
@@ -375,8 +389,14 @@ int main(int argc, char **argv)
 	results = mmap(NULL, ALIGN(argc*sizeof(double), 4096),
 		       PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
 
-	while ((c = getopt(argc, argv, "d:n:r:")) != -1) {
+	while ((c = getopt(argc, argv, "d:n:r:tD")) != -1) {
 		switch (c) {
+		case 't':
+			timed = true;
+			break;
+		case 'D':
+			dry_run = true;
+			break;
 		case 'd':
 			delay = atoi(optarg);
 			break;
@@ -395,6 +415,8 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (dry_run)
+		nop = -1;
 	if (!nop)
 		nop = calibrate_nop(delay);
 	if (!range)
@@ -407,7 +429,8 @@ int main(int argc, char **argv)
 	}
 
 	igt_fork(child, argc-optind)
-		results[child] = replay(argv[child + optind], nop, range);
+		results[child] = replay(argv[child + optind], nop, range,
+					dry_run, timed);
 	igt_waitchildren();
 
 	for (i = 0; i < argc - optind; i++) {
@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GEM_EXEC_TRACE_H
+#define GEM_EXEC_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Trace files as written by gem_exec_tracer.
+ *
+ * Every file starts with a struct trace_version.
+ *
+ * Version 1 follows it with the records back to back, each a command byte
+ * and the packed structure for the command. Execs are followed by their
+ * objects, each object by its drm_i915_gem_relocation_entry array.
+ *
+ * Version 2 follows it with blocks, each a struct trace_block and its
+ * payload, LZ4 compressed or stored. Uncompressed, the payload is a
+ * sequence of whole records, a command byte and varint encoded fields:
+ *
+ *   ADD_BO:  handle, size
+ *   DEL_BO:  handle
+ *   ADD_CTX: handle
+ *   DEL_CTX: handle
+ *   WAIT:    time, handle
+ *   EXEC:    time, object count, flags, context, then per object:
+ *            zigzag handle delta, relocation count, alignment,
+ *            zigzag offset delta, flags, rsvd1, rsvd2, then per relocation:
+ *              zigzag target handle delta, delta, zigzag offset delta,
+ *              zigzag presumed offset delta, read domains, write domain
+ *
+ * Time is in nanoseconds since the previous timed record of the block, or
+ * since the trace was started for the first one. Other deltas are against
+ * the previous object or relocation of the same exec, starting from zero,
+ * so every block decodes on its own. A closed trace ends with an index of its blocks, an
+ * array of struct trace_block_index followed by a struct trace_index.
+ * Traces of processes which did not exit cleanly lack the index and can
+ * still be read by walking the blocks.
+ */
+
+#define TRACE_MAGIC 0xdeadbeef
+#define TRACE_BLOCK_MAGIC 0x4b4c4254 /* "TBLK" */
+#define TRACE_INDEX_MAGIC 0x58444954 /* "TIDX" */
+
+#define TRACE_BLOCK_SIZE (256 << 10)
+
+enum {
+	ADD_BO = 0,
+	DEL_BO,
+	ADD_CTX,
+	DEL_CTX,
+	EXEC,
+	WAIT,
+	/* Only produced by the reader, for version 2 timestamps. */
+	TIMESTAMP = 0x80,
+};
+
+struct trace_version {
+	uint32_t magic;
+	uint32_t version;
+} __attribute__((packed));
+
+#define TRACE_BLOCK_LZ4 (1 << 0)
+
+struct trace_block {
+	uint32_t magic;
+	uint32_t flags;
+	uint32_t raw_size;
+	uint32_t size;
+} __attribute__((packed));
+
+struct trace_block_index {
+	uint64_t offset;
+	uint64_t time; /* ns since the start of the trace of its first record */
+} __attribute__((packed));
+
+struct trace_index {
+	uint32_t magic;
+	uint32_t count;
+	uint64_t offset;
+} __attribute__((packed));
+
+/* Records as laid out in version 1 and handed out by the reader. */
+struct trace_add_bo {
+	uint32_t handle;
+	uint64_t size;
+} __attribute__((packed));
+
+struct trace_del_bo {
+	uint32_t handle;
+} __attribute__((packed));
+
+struct trace_add_ctx {
+	uint32_t handle;
+} __attribute__((packed));
+
+struct trace_del_ctx {
+	uint32_t handle;
+} __attribute__((packed));
+
+struct trace_exec {
+	uint32_t object_count;
+	uint64_t flags;
+	uint32_t context;
+} __attribute__((packed));
+
+struct trace_exec_object {
+	uint32_t handle;
+	uint32_t relocation_count;
+	uint64_t alignment;
+	uint64_t offset;
+	uint64_t flags;
+	uint64_t rsvd1;
+	uint64_t rsvd2;
+} __attribute__((packed));
+
+/* Same layout as struct drm_i915_gem_relocation_entry */
+struct trace_exec_relocation {
+	uint32_t target_handle;
+	uint32_t delta;
+	uint64_t offset;
+	uint64_t presumed_offset;
+	uint32_t read_domains;
+	uint32_t write_domain;
+} __attribute__((packed));
+
+struct trace_wait {
+	uint32_t handle;
+} __attribute__((packed));
+
+struct trace_timestamp {
+	uint64_t time; /* ns since the start of the trace */
+} __attribute__((packed));
+
+static inline uint8_t *trace_put_varint(uint8_t *p, uint64_t v)
+{
+	while (v >= 0x80) {
+		*p++ = v | 0x80;
+		v >>= 7;
+	}
+	*p++ = v;
+
+	return p;
+}
+
+static inline const uint8_t *
+trace_get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v)
+{
+	unsigned int shift = 0;
+
+	*v = 0;
+	do {
+		if (p == end || shift > 63)
+			return NULL;
+
+		*v |= (uint64_t)(*p & 0x7f) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+
+	return p;
+}
+
+static inline uint64_t trace_zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t trace_unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/* Worst case encoded sizes, for sizing buffers. */
+#define TRACE_VARINT_MAX 10
+#define TRACE_EXEC_MAX(objects, relocs) \
+	(1 + 4 * TRACE_VARINT_MAX + \
+	 (objects) * 7 * TRACE_VARINT_MAX + (relocs) * 6 * TRACE_VARINT_MAX)
+
+struct trace_reader;
+
+struct trace_reader_stats {
+	unsigned int version;
+	uint64_t blocks;
+	uint64_t file_bytes;
+	uint64_t raw_bytes;
+	uint64_t decoded_bytes;
+};
+
+struct trace_reader *trace_reader_open(const char *filename, bool threaded);
+uint8_t *trace_reader_next(struct trace_reader *r, size_t *len);
+bool trace_reader_error(const struct trace_reader *r);
+void trace_reader_stats(const struct trace_reader *r,
+			struct trace_reader_stats *stats);
+void trace_reader_close(struct trace_reader *r);
+
+#endif /* GEM_EXEC_TRACE_H */
@@ -0,0 +1,637 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Offline analysis of gem_exec_tracer captures, without a GPU.
+ *
+ * The trace is streamed once through the trace reader and every record is
+ * accounted as it goes past, with objects and contexts looked up in hash
+ * tables keyed by handle. Reported are the working set of each window of
+ * execs, the reuse distance of objects (the number of distinct objects
+ * used in between two uses of the same object), the objects and
+ * relocations per exec, the use of each context, and the minimum GTT
+ * footprint (the largest set of objects a single exec needs bound).
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "igt_map.h"
+#include "gem_exec_trace.h"
+
+#define GOLDEN_RATIO_PRIME_32 0x9e370001UL
+
+#define NO_SLOT UINT64_MAX
+
+struct bo {
+	uint32_t handle;
+	uint64_t size;
+	uint64_t window;
+	uint64_t slot;
+};
+
+struct ctx {
+	uint32_t handle;
+	unsigned int lifetimes;
+	uint64_t execs;
+	uint64_t objects;
+	uint64_t relocs;
+};
+
+struct histogram {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t bucket[65];
+};
+
+/*
+ * Reuse distances are counted with a Fenwick tree over access slots, which
+ * holds a one in the slot of the most recent access to each live object.
+ * The distance of an access is then the number of ones after the previous
+ * access of the same object. Once the slots run out, the live ones are
+ * packed back to the start so the tree stays proportional to the number
+ * of objects, not to the length of the trace.
+ */
+struct reuse {
+	int32_t *tree;
+	struct bo **owner;
+	uint64_t size;
+	uint64_t next;
+	uint64_t cold;
+	struct histogram hist;
+};
+
+struct analysis {
+	struct igt_map *bos;
+	struct igt_map *ctxs;
+	struct reuse reuse;
+
+	uint64_t window_size;
+	bool timeline;
+
+	uint64_t records;
+	uint64_t execs;
+	uint64_t time;
+
+	uint64_t created;
+	uint64_t destroyed;
+	uint64_t unknown;
+	uint64_t waits;
+
+	uint64_t live_objects;
+	uint64_t live_bytes;
+	uint64_t peak_live_objects;
+	uint64_t peak_live_bytes;
+
+	uint64_t window;
+	uint64_t window_objects;
+	uint64_t window_bytes;
+	uint64_t peak_window_objects;
+	uint64_t peak_window_bytes;
+	uint64_t peak_window_exec;
+
+	uint64_t footprint;
+	uint64_t footprint_objects;
+	uint64_t footprint_exec;
+
+	uint32_t last_ctx;
+	uint64_t ctx_switches;
+
+	struct histogram objects;
+	struct histogram relocs;
+};
+
+static uint32_t hash_handle(const void *key)
+{
+	return *(const uint32_t *)key * GOLDEN_RATIO_PRIME_32;
+}
+
+static int equal_handle(const void *a, const void *b)
+{
+	return *(const uint32_t *)a == *(const uint32_t *)b;
+}
+
+static void free_entry(struct igt_map_entry *entry)
+{
+	free(entry->data);
+}
+
+static double mib(uint64_t bytes)
+{
+	return bytes / 1048576.;
+}
+
+static void histogram_add(struct histogram *h, uint64_t v)
+{
+	h->count++;
+	h->sum += v;
+	if (v > h->max)
+		h->max = v;
+	h->bucket[v ? 64 - __builtin_clzll(v) : 0]++;
+}
+
+static void histogram_print(const char *name, const struct histogram *h)
+{
+	printf("%s: mean %.1f, max %" PRIu64 "\n",
+	       name, h->count ? (double)h->sum / h->count : 0., h->max);
+
+	for (int i = 0; i < 65; i++) {
+		if (!h->bucket[i])
+			continue;
+
+		if (i < 2)
+			printf("  %20d: ", i);
+		else
+			printf("  %9" PRIu64 "-%-10" PRIu64 ": ",
+			       (uint64_t)1 << (i - 1), ((uint64_t)1 << i) - 1);
+		printf("%" PRIu64 " (%.1f%%)\n",
+		       h->bucket[i], 100. * h->bucket[i] / h->count);
+	}
+}
+
+static void reuse_add(struct reuse *r, uint64_t slot, int32_t v)
+{
+	for (; slot < r->size; slot |= slot + 1)
+		r->tree[slot] += v;
+}
+
+/* Number of accesses marked in [0, slot] */
+static int64_t reuse_sum(const struct reuse *r, int64_t slot)
+{
+	int64_t sum = 0;
+
+	for (; slot >= 0; slot = (slot & (slot + 1)) - 1)
+		sum += r->tree[slot];
+
+	return sum;
+}
+
+static void reuse_compact(struct reuse *r)
+{
+	uint64_t count = 0;
+
+	for (uint64_t i = 0; i < r->next; i++) {
+		struct bo *bo = r->owner[i];
+
+		if (bo) {
+			bo->slot = count;
+			r->owner[count++] = bo;
+		}
+	}
+
+	if (count > r->size / 2 || !r->size) {
+		r->size = r->size ? 2 * r->size : 4096;
+		r->tree = realloc(r->tree, r->size * sizeof(*r->tree));
+		r->owner = realloc(r->owner, r->size * sizeof(*r->owner));
+		if (!r->tree || !r->owner) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+
+	/* Linear time rebuild, each node pushing its sum to its parent */
+	memset(r->tree, 0, r->size * sizeof(*r->tree));
+	for (uint64_t i = 0; i < count; i++)
+		r->tree[i] = 1;
+	for (uint64_t i = 0; i < r->size; i++) {
+		uint64_t parent = i | (i + 1);
+
+		if (parent < r->size)
+			r->tree[parent] += r->tree[i];
+	}
+
+	r->next = count;
+}
+
+static void reuse_forget(struct reuse *r, struct bo *bo)
+{
+	if (bo->slot == NO_SLOT)
+		return;
+
+	reuse_add(r, bo->slot, -1);
+	r->owner[bo->slot] = NULL;
+	bo->slot = NO_SLOT;
+}
+
+static void reuse_access(struct reuse *r, struct bo *bo)
+{
+	if (bo->slot != NO_SLOT) {
+		histogram_add(&r->hist,
+			      reuse_sum(r, r->next - 1) -
+			      reuse_sum(r, bo->slot));
+		reuse_forget(r, bo);
+	} else {
+		r->cold++;
+	}
+
+	if (r->next == r->size)
+		reuse_compact(r);
+
+	reuse_add(r, r->next, 1);
+	r->owner[r->next] = bo;
+	bo->slot = r->next++;
+}
+
+static struct bo *add_bo(struct analysis *a, uint32_t handle, uint64_t size)
+{
+	struct bo *bo;
+
+	bo = calloc(1, sizeof(*bo));
+	if (!bo) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	bo->handle = handle;
+	bo->size = size;
+	bo->window = UINT64_MAX;
+	bo->slot = NO_SLOT;
+	igt_map_insert(a->bos, &bo->handle, bo);
+
+	a->live_objects++;
+	a->live_bytes += size;
+	if (a->live_bytes > a->peak_live_bytes) {
+		a->peak_live_bytes = a->live_bytes;
+		a->peak_live_objects = a->live_objects;
+	}
+
+	return bo;
+}
+
+static void del_bo(struct analysis *a, uint32_t handle)
+{
+	struct igt_map_entry *entry;
+	struct bo *bo;
+
+	entry = igt_map_search_entry(a->bos, &handle);
+	if (!entry)
+		return;
+
+	bo = entry->data;
+	reuse_forget(&a->reuse, bo);
+	a->live_objects--;
+	a->live_bytes -= bo->size;
+
+	igt_map_remove_entry(a->bos, entry);
+	free(bo);
+}
+
+static struct ctx *get_ctx(struct analysis *a, uint32_t handle)
+{
+	struct ctx *ctx;
+
+	ctx = igt_map_search(a->ctxs, &handle);
+	if (ctx)
+		return ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	ctx->handle = handle;
+	igt_map_insert(a->ctxs, &ctx->handle, ctx);
+
+	return ctx;
+}
+
+static void end_window(struct analysis *a)
+{
+	if (a->timeline)
+		printf("  %12" PRIu64 " %12.3f %10" PRIu64 " %12.1f\n",
+		       a->execs, a->time * 1e-6,
+		       a->window_objects, mib(a->window_bytes));
+
+	if (a->window_bytes > a->peak_window_bytes) {
+		a->peak_window_bytes = a->window_bytes;
+		a->peak_window_objects = a->window_objects;
+		a->peak_window_exec = a->execs;
+	}
+
+	a->window++;
+	a->window_objects = 0;
+	a->window_bytes = 0;
+}
+
+static uint8_t *analyze_exec(struct analysis *a, uint8_t *ptr)
+{
+	const struct trace_exec *t = (void *)ptr;
+	uint64_t footprint = 0, relocs = 0;
+	struct ctx *ctx;
+
+	ptr = (void *)(t + 1);
+	for (uint32_t i = 0; i < t->object_count; i++) {
+		const struct trace_exec_object *to = (void *)ptr;
+		uint64_t align = to->alignment > 4096 ? to->alignment : 4096;
+		uint32_t handle = to->handle;
+		struct bo *bo;
+
+		ptr = (void *)(to + 1);
+		ptr += to->relocation_count * sizeof(struct trace_exec_relocation);
+		relocs += to->relocation_count;
+
+		bo = igt_map_search(a->bos, &handle);
+		if (!bo) {
+			/* Created before tracing started, or imported */
+			bo = add_bo(a, handle, 0);
+			a->unknown++;
+		}
+
+		footprint += (bo->size + align - 1) & -align;
+		if (bo->window != a->window) {
+			bo->window = a->window;
+			a->window_objects++;
+			a->window_bytes += bo->size;
+		}
+
+		reuse_access(&a->reuse, bo);
+	}
+
+	if (footprint > a->footprint) {
+		a->footprint = footprint;
+		a->footprint_objects = t->object_count;
+		a->footprint_exec = a->execs;
+	}
+
+	histogram_add(&a->objects, t->object_count);
+	histogram_add(&a->relocs, relocs);
+
+	ctx = get_ctx(a, t->context);
+	ctx->execs++;
+	ctx->objects += t->object_count;
+	ctx->relocs += relocs;
+	if (a->execs && t->context != a->last_ctx)
+		a->ctx_switches++;
+	a->last_ctx = t->context;
+
+	if (++a->execs % a->window_size == 0)
+		end_window(a);
+
+	return ptr;
+}
+
+static bool analyze_chunk(struct analysis *a, uint8_t *ptr, uint8_t *end)
+{
+	while (ptr < end) {
+		a->records++;
+		switch (*ptr++) {
+		case ADD_BO: {
+			struct trace_add_bo *t = (void *)ptr;
+
+			ptr = (void *)(t + 1);
+			del_bo(a, t->handle);
+			add_bo(a, t->handle, t->size);
+			a->created++;
+			break;
+		}
+
+		case DEL_BO: {
+			struct trace_del_bo *t = (void *)ptr;
+
+			ptr = (void *)(t + 1);
+			del_bo(a, t->handle);
+			a->destroyed++;
+			break;
+		}
+
+		case ADD_CTX: {
+			struct trace_add_ctx *t = (void *)ptr;
+
+			ptr = (void *)(t + 1);
+			get_ctx(a, t->handle)->lifetimes++;
+			break;
+		}
+
+		case DEL_CTX: {
+			struct trace_del_ctx *t = (void *)ptr;
+
+			ptr = (void *)(t + 1);
+			break;
+		}
+
+		case EXEC:
+			ptr = analyze_exec(a, ptr);
+			break;
+
+		case WAIT: {
+			struct trace_wait *t = (void *)ptr;
+
+			ptr = (void *)(t + 1);
+			a->waits++;
+			break;
+		}
+
+		case TIMESTAMP: {
+			struct trace_timestamp *t = (void *)ptr;
+
+			ptr = (void *)(t + 1);
+			a->time = t->time;
+			a->records--;
+			break;
+		}
+
+		default:
+			fprintf(stderr, "Unknown cmd: %x\n", *--ptr);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int cmp_ctx(const void *A, const void *B)
+{
+	const struct ctx *a = *(const struct ctx **)A;
+	const struct ctx *b = *(const struct ctx **)B;
+
+	if (a->execs != b->execs)
+		return a->execs < b->execs ? 1 : -1;
+
+	return a->handle < b->handle ? -1 : a->handle > b->handle;
+}
+
+static void print_contexts(struct analysis *a, unsigned int max)
+{
+	struct igt_map_entry *entry;
+	struct ctx **ctxs;
+	unsigned int count = 0;
+
+	ctxs = malloc(a->ctxs->entries * sizeof(*ctxs));
+	if (!ctxs)
+		return;
+
+	igt_map_foreach(a->ctxs, entry)
+		ctxs[count++] = entry->data;
+	qsort(ctxs, count, sizeof(*ctxs), cmp_ctx);
+
+	printf("Contexts: %u, %" PRIu64 " switches between execs\n",
+	       count, a->ctx_switches);
+	for (unsigned int i = 0; i < count && i < max; i++) {
+		const struct ctx *ctx = ctxs[i];
+
+		printf("  %10u: %" PRIu64 " execs (%.1f%%), %.1f objects and %.1f relocations per exec, created %u times\n",
+		       ctx->handle, ctx->execs,
+		       a->execs ? 100. * ctx->execs / a->execs : 0.,
+		       ctx->execs ? (double)ctx->objects / ctx->execs : 0.,
+		       ctx->execs ? (double)ctx->relocs / ctx->execs : 0.,
+		       ctx->lifetimes);
+	}
+	if (count > max)
+		printf("  ... %u more\n", count - max);
+
+	free(ctxs);
+}
+
+static double elapsed(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static int analyze(const char *filename, uint64_t window_size, bool timeline,
+		   unsigned int max_contexts)
+{
+	struct analysis a = {
+		.window_size = window_size,
+		.timeline = timeline,
+	};
+	struct trace_reader_stats stats;
+	struct timespec t_start, t_end;
+	struct trace_reader *r;
+	bool ok = true;
+	uint8_t *ptr;
+	size_t len;
+	double t;
+
+	r = trace_reader_open(filename, true);
+	if (!r) {
+		fprintf(stderr, "%s: failed to open\n", filename);
+		return -1;
+	}
+
+	a.bos = igt_map_create(hash_handle, equal_handle);
+	a.ctxs = igt_map_create(hash_handle, equal_handle);
+
+	printf("%s:\n", filename);
+	if (timeline)
+		printf("  %12s %12s %10s %12s\n",
+		       "execs", "time (ms)", "objects", "MiB");
+
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
+	while (ok && (ptr = trace_reader_next(r, &len)))
+		ok = analyze_chunk(&a, ptr, ptr + len);
+	if (a.execs % window_size)
+		end_window(&a);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+	ok &= !trace_reader_error(r);
+	trace_reader_stats(r, &stats);
+	trace_reader_close(r);
+
+	t = elapsed(&t_start, &t_end);
+	printf("Trace: version %u, %" PRIu64 " records, %.1fMiB on disk, %.1fMiB decoded in %.3fs (%.1fMiB/s)%s\n",
+	       stats.version, a.records,
+	       mib(stats.file_bytes), mib(stats.decoded_bytes),
+	       t, mib(stats.file_bytes) / t,
+	       ok ? "" : ", incomplete");
+	if (a.time)
+		printf("Duration: %.3fs\n", a.time * 1e-9);
+	printf("Execs: %" PRIu64 ", waits: %" PRIu64 "\n", a.execs, a.waits);
+	printf("Objects: %" PRIu64 " created, %" PRIu64 " closed, %" PRIu64 " of unknown size, peak %" PRIu64 " live using %.1fMiB\n",
+	       a.created, a.destroyed, a.unknown,
+	       a.peak_live_objects, mib(a.peak_live_bytes));
+	printf("Working set per %" PRIu64 " execs: peak %" PRIu64 " objects, %.1fMiB, at exec %" PRIu64 "\n",
+	       window_size, a.peak_window_objects,
+	       mib(a.peak_window_bytes), a.peak_window_exec);
+	printf("Minimum GTT footprint: %.1fMiB, %" PRIu64 " objects at exec %" PRIu64 "\n",
+	       mib(a.footprint), a.footprint_objects, a.footprint_exec);
+	histogram_print("Objects per exec", &a.objects);
+	histogram_print("Relocations per exec", &a.relocs);
+	printf("Reuse distance: %" PRIu64 " first uses\n", a.reuse.cold);
+	histogram_print("Reuse distance", &a.reuse.hist);
+	print_contexts(&a, max_contexts);
+
+	igt_map_destroy(a.bos, free_entry);
+	igt_map_destroy(a.ctxs, free_entry);
+	free(a.reuse.tree);
+	free(a.reuse.owner);
+
+	return ok ? 0 : -1;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [options] trace...\n"
+	       "  -w N  Working set window, in execs (default 1000)\n"
+	       "  -t    Print the working set of every window\n"
+	       "  -c N  Number of contexts to list (default 16)\n",
+	       name);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int max_contexts = 16;
+	uint64_t window_size = 1000;
+	bool timeline = false;
+	int ret = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "w:tc:h")) != -1) {
+		switch (c) {
+		case 'w':
+			window_size = strtoull(optarg, NULL, 0);
+			if (!window_size)
+				window_size = 1;
+			break;
+		case 't':
+			timeline = true;
+			break;
+		case 'c':
+			max_contexts = atoi(optarg);
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (int i = optind; i < argc; i++)
+		ret |= analyze(argv[i], window_size, timeline, max_contexts);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,598 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Reads gem_exec_tracer files of either version and hands out the records
+ * in the version 1 layout, in chunks of whole records. Version 2 blocks are
+ * decompressed and expanded by a helper thread a few blocks ahead of the
+ * consumer, so that decoding overlaps with replay.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "igt_lz4.h"
+#include "gem_exec_trace.h"
+
+#define NUM_CHUNKS 4
+
+struct trace_chunk {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+};
+
+struct trace_reader {
+	const char *filename;
+	unsigned int version;
+
+	uint8_t *map;
+	size_t map_size;
+
+	/* Version 2 block cursor, either walking the index or the file. */
+	const struct trace_block_index *index;
+	unsigned int index_count;
+	unsigned int next_block;
+	size_t next_offset;
+	size_t blocks_end;
+
+	uint8_t *raw;
+	size_t raw_size;
+
+	struct trace_chunk chunks[NUM_CHUNKS];
+	unsigned int produced;
+	unsigned int consumed;
+	bool holding;
+	bool done;
+	bool stop;
+	bool error;
+
+	bool threaded;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+
+	struct trace_reader_stats stats;
+};
+
+static uint8_t *chunk_reserve(struct trace_chunk *c, size_t len)
+{
+	if (c->len + len > c->size) {
+		size_t size = c->size ? 2 * c->size : TRACE_BLOCK_SIZE;
+		uint8_t *data;
+
+		while (size < c->len + len)
+			size *= 2;
+
+		data = realloc(c->data, size);
+		if (!data)
+			return NULL;
+
+		c->data = data;
+		c->size = size;
+	}
+
+	return c->data + c->len;
+}
+
+#define get(x) do { \
+	uint64_t v__; \
+	p = trace_get_varint(p, end, &v__); \
+	if (!p) \
+		return false; \
+	(x) = v__; \
+} while (0)
+
+/* Deltas wrap around, prev is a uint64_t */
+#define get_delta(x, prev) do { \
+	uint64_t v__; \
+	p = trace_get_varint(p, end, &v__); \
+	if (!p) \
+		return false; \
+	(x) = (prev) + (uint64_t)trace_unzigzag(v__); \
+	(prev) = (x); \
+} while (0)
+
+static bool emit_timestamp(struct trace_chunk *c, uint64_t time)
+{
+	struct trace_timestamp t = { time };
+	uint8_t *out;
+
+	out = chunk_reserve(c, 1 + sizeof(t));
+	if (!out)
+		return false;
+
+	*out++ = TIMESTAMP;
+	memcpy(out, &t, sizeof(t));
+	c->len += 1 + sizeof(t);
+
+	return true;
+}
+
+static bool emit_handle(struct trace_chunk *c, uint8_t cmd, uint32_t handle)
+{
+	uint8_t *out;
+
+	/* All single handle records share the same layout */
+	out = chunk_reserve(c, 1 + sizeof(struct trace_del_bo));
+	if (!out)
+		return false;
+
+	*out++ = cmd;
+	memcpy(out, &handle, sizeof(handle));
+	c->len += 1 + sizeof(struct trace_del_bo);
+
+	return true;
+}
+
+static bool expand_exec(struct trace_chunk *c,
+			const uint8_t **ptr, const uint8_t *end)
+{
+	const uint8_t *p = *ptr;
+	struct trace_exec t;
+	uint64_t handle = 0, offset = 0;
+	uint8_t *out;
+
+	get(t.object_count);
+	get(t.flags);
+	get(t.context);
+
+	out = chunk_reserve(c, 1 + sizeof(t));
+	if (!out)
+		return false;
+
+	*out++ = EXEC;
+	memcpy(out, &t, sizeof(t));
+	c->len += 1 + sizeof(t);
+
+	for (uint32_t i = 0; i < t.object_count; i++) {
+		struct trace_exec_object obj;
+		uint64_t target = 0, roffset = 0, presumed = 0;
+
+		get_delta(obj.handle, handle);
+		get(obj.relocation_count);
+		get(obj.alignment);
+		get_delta(obj.offset, offset);
+		get(obj.flags);
+		get(obj.rsvd1);
+		get(obj.rsvd2);
+
+		/* Each relocation takes at least 6 bytes to encode */
+		if (obj.relocation_count > (end - p) / 6)
+			return false;
+
+		out = chunk_reserve(c, sizeof(obj) +
+				    obj.relocation_count *
+				    sizeof(struct trace_exec_relocation));
+		if (!out)
+			return false;
+
+		memcpy(out, &obj, sizeof(obj));
+		c->len += sizeof(obj);
+
+		for (uint32_t j = 0; j < obj.relocation_count; j++) {
+			struct trace_exec_relocation r;
+
+			get_delta(r.target_handle, target);
+			get(r.delta);
+			get_delta(r.offset, roffset);
+			get_delta(r.presumed_offset, presumed);
+			get(r.read_domains);
+			get(r.write_domain);
+
+			memcpy(c->data + c->len, &r, sizeof(r));
+			c->len += sizeof(r);
+		}
+	}
+
+	*ptr = p;
+	return true;
+}
+
+static bool expand_block(struct trace_chunk *c,
+			 const uint8_t *p, const uint8_t *end)
+{
+	uint64_t time = 0;
+
+	c->len = 0;
+	while (p < end) {
+		uint8_t cmd = *p++;
+		uint64_t handle, v;
+
+		switch (cmd) {
+		case ADD_BO: {
+			struct trace_add_bo t;
+			uint8_t *out;
+
+			get(t.handle);
+			get(t.size);
+
+			out = chunk_reserve(c, 1 + sizeof(t));
+			if (!out)
+				return false;
+
+			*out++ = ADD_BO;
+			memcpy(out, &t, sizeof(t));
+			c->len += 1 + sizeof(t);
+			break;
+		}
+
+		case DEL_BO:
+		case ADD_CTX:
+		case DEL_CTX:
+			get(handle);
+			if (!emit_handle(c, cmd, handle))
+				return false;
+			break;
+
+		case WAIT:
+			get(v);
+			get(handle);
+			time += v;
+			if (!emit_timestamp(c, time) ||
+			    !emit_handle(c, WAIT, handle))
+				return false;
+			break;
+
+		case EXEC:
+			get(v);
+			time += v;
+			if (!emit_timestamp(c, time) ||
+			    !expand_exec(c, &p, end))
+				return false;
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#undef get
+#undef get_delta
+
+static const struct trace_block *next_block(struct trace_reader *r)
+{
+	const struct trace_block *blk;
+	size_t offset;
+
+	if (r->index) {
+		if (r->next_block == r->index_count)
+			return NULL;
+
+		offset = r->index[r->next_block++].offset;
+		if (offset > r->blocks_end ||
+		    r->blocks_end - offset < sizeof(*blk))
+			goto err;
+	} else {
+		offset = r->next_offset;
+		if (offset == r->blocks_end)
+			return NULL;
+
+		/* A crashed tracer may leave the last block incomplete */
+		if (r->blocks_end - offset < sizeof(*blk))
+			return NULL;
+	}
+
+	blk = (const void *)(r->map + offset);
+	if (blk->magic != TRACE_BLOCK_MAGIC)
+		goto err;
+
+	if (blk->size > r->blocks_end - offset - sizeof(*blk)) {
+		if (r->index)
+			goto err;
+		return NULL;
+	}
+
+	r->next_offset = offset + sizeof(*blk) + blk->size;
+	return blk;
+
+err:
+	fprintf(stderr, "%s: corrupt block at offset %zu\n",
+		r->filename, offset);
+	r->error = true;
+	return NULL;
+}
+
+static bool decode_block(struct trace_reader *r, const struct trace_block *blk,
+			 struct trace_chunk *c)
+{
+	const uint8_t *data = (const void *)(blk + 1);
+
+	if (blk->flags & TRACE_BLOCK_LZ4) {
+		if (blk->raw_size > r->raw_size) {
+			uint8_t *raw = realloc(r->raw, blk->raw_size);
+
+			if (!raw)
+				return false;
+
+			r->raw = raw;
+			r->raw_size = blk->raw_size;
+		}
+
+		if (igt_lz4_decompress(data, blk->size,
+				       r->raw, blk->raw_size) != blk->raw_size)
+			return false;
+
+		data = r->raw;
+	} else if (blk->raw_size != blk->size) {
+		return false;
+	}
+
+	if (!expand_block(c, data, data + blk->raw_size))
+		return false;
+
+	r->stats.blocks++;
+	r->stats.raw_bytes += blk->raw_size;
+	r->stats.decoded_bytes += c->len;
+
+	return true;
+}
+
+static void *decode_thread(void *arg)
+{
+	struct trace_reader *r = arg;
+
+	pthread_mutex_lock(&r->mutex);
+	while (!r->stop) {
+		const struct trace_block *blk;
+		struct trace_chunk *c;
+		bool ok;
+
+		if (r->produced - r->consumed == NUM_CHUNKS) {
+			pthread_cond_wait(&r->cond, &r->mutex);
+			continue;
+		}
+
+		/* The slot is not visible to the consumer until produced */
+		c = &r->chunks[r->produced % NUM_CHUNKS];
+		pthread_mutex_unlock(&r->mutex);
+
+		blk = next_block(r);
+		ok = blk && decode_block(r, blk, c);
+
+		pthread_mutex_lock(&r->mutex);
+		if (!ok) {
+			r->error |= blk != NULL;
+			break;
+		}
+
+		r->produced++;
+		pthread_cond_broadcast(&r->cond);
+	}
+	r->done = true;
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->mutex);
+
+	return NULL;
+}
+
+static void find_index(struct trace_reader *r)
+{
+	const struct trace_index *idx;
+	size_t len;
+
+	r->blocks_end = r->map_size;
+	r->next_offset = sizeof(struct trace_version);
+
+	if (r->map_size < sizeof(struct trace_version) + sizeof(*idx))
+		return;
+
+	idx = (const void *)(r->map + r->map_size - sizeof(*idx));
+	if (idx->magic != TRACE_INDEX_MAGIC)
+		return;
+
+	len = (size_t)idx->count * sizeof(*r->index);
+	if (idx->offset < sizeof(struct trace_version) ||
+	    idx->offset > r->map_size - sizeof(*idx) ||
+	    len != r->map_size - sizeof(*idx) - idx->offset)
+		return;
+
+	r->index = (const void *)(r->map + idx->offset);
+	r->index_count = idx->count;
+	r->blocks_end = idx->offset;
+}
+
+struct trace_reader *trace_reader_open(const char *filename, bool threaded)
+{
+	const struct trace_version *tv;
+	struct trace_reader *r;
+	struct stat st;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*tv)) {
+		close(fd);
+		return NULL;
+	}
+
+	r = calloc(1, sizeof(*r));
+	if (!r) {
+		close(fd);
+		return NULL;
+	}
+
+	r->filename = filename;
+	r->map_size = st.st_size;
+	r->stats.file_bytes = st.st_size;
+	r->map = mmap(0, r->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		      fd, 0);
+	close(fd);
+	if (r->map == MAP_FAILED) {
+		free(r);
+		return NULL;
+	}
+
+	madvise(r->map, r->map_size, MADV_SEQUENTIAL);
+
+	tv = (const void *)r->map;
+	if (tv->magic != TRACE_MAGIC) {
+		fprintf(stderr, "%s: invalid magic\n", filename);
+		goto err;
+	}
+
+	r->version = tv->version;
+	r->stats.version = tv->version;
+	switch (tv->version) {
+	case 1:
+		/* Records are used in place, as a single chunk. */
+		r->chunks[0].data = r->map + sizeof(*tv);
+		r->chunks[0].len = r->map_size - sizeof(*tv);
+		r->stats.blocks = 1;
+		r->stats.raw_bytes = r->chunks[0].len;
+		r->stats.decoded_bytes = r->chunks[0].len;
+		r->produced = 1;
+		r->done = true;
+		return r;
+
+	case 2:
+		break;
+
+	default:
+		fprintf(stderr, "%s: unhandled version %d\n",
+			filename, tv->version);
+		goto err;
+	}
+
+	find_index(r);
+
+	pthread_mutex_init(&r->mutex, NULL);
+	pthread_cond_init(&r->cond, NULL);
+	if (threaded &&
+	    pthread_create(&r->thread, NULL, decode_thread, r) == 0)
+		r->threaded = true;
+
+	return r;
+
+err:
+	munmap(r->map, r->map_size);
+	free(r);
+	return NULL;
+}
+
+/*
+ * Returns the next chunk of records, which stays valid (and writable) until
+ * the following call, or NULL at the end of the trace.
+ */
+uint8_t *trace_reader_next(struct trace_reader *r, size_t *len)
+{
+	struct trace_chunk *c;
+
+	if (r->version == 1) {
+		if (r->consumed++)
+			return NULL;
+
+		*len = r->chunks[0].len;
+		return r->chunks[0].data;
+	}
+
+	if (!r->threaded) {
+		const struct trace_block *blk;
+
+		c = &r->chunks[0];
+		if (r->done)
+			return NULL;
+
+		blk = next_block(r);
+		if (!blk || !decode_block(r, blk, c)) {
+			r->error |= blk != NULL;
+			r->done = true;
+			return NULL;
+		}
+
+		*len = c->len;
+		return c->data;
+	}
+
+	pthread_mutex_lock(&r->mutex);
+	if (r->holding) {
+		r->consumed++;
+		r->holding = false;
+		pthread_cond_broadcast(&r->cond);
+	}
+
+	while (r->produced == r->consumed && !r->done)
+		pthread_cond_wait(&r->cond, &r->mutex);
+
+	c = NULL;
+	if (r->produced != r->consumed) {
+		c = &r->chunks[r->consumed % NUM_CHUNKS];
+		r->holding = true;
+	}
+	pthread_mutex_unlock(&r->mutex);
+
+	if (!c)
+		return NULL;
+
+	*len = c->len;
+	return c->data;
+}
+
+/* Whether reading stopped at a corrupt block rather than the end. */
+bool trace_reader_error(const struct trace_reader *r)
+{
+	return r->error;
+}
+
+/* Only complete once the last chunk has been read. */
+void trace_reader_stats(const struct trace_reader *r,
+			struct trace_reader_stats *stats)
+{
+	*stats = r->stats;
+}
+
+void trace_reader_close(struct trace_reader *r)
+{
+	if (r->threaded) {
+		pthread_mutex_lock(&r->mutex);
+		r->stop = true;
+		pthread_cond_broadcast(&r->cond);
+		pthread_mutex_unlock(&r->mutex);
+
+		pthread_join(r->thread, NULL);
+	}
+
+	if (r->version == 2) {
+		pthread_cond_destroy(&r->cond);
+		pthread_mutex_destroy(&r->mutex);
+
+		for (int i = 0; i < NUM_CHUNKS; i++)
+			free(r->chunks[i].data);
+	}
+
+	free(r->raw);
+	munmap(r->map, r->map_size);
+	free(r);
+}
@@ -37,9 +37,12 @@
 #include <dlfcn.h>
 #include <i915_drm.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "intel_aub.h"
 #include "intel_chipset.h"
+#include "igt_lz4.h"
+#include "gem_exec_trace.h"
 
 #ifdef __FreeBSD__
 #include "igt_freebsd.h"
@@ -49,81 +52,48 @@ static int (*libc_close)(int fd);
 static int (*libc_ioctl)(int fd, unsigned long request, void *argp);
 
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t scratch_key;
 
+/*
+ * Records are encoded into a block in memory and only written out, LZ4
+ * compressed, once the block is full or the traced fd is closed. Execs are
+ * encoded outside of the lock into a per-thread scratch buffer, so that
+ * only the copy into the block is serialised between threads.
+ */
 struct trace {
 	int fd;
-	FILE *file;
+	int file;
+	pthread_mutex_t lock;
+
+	uint8_t *block;
+	size_t len;
+	size_t size;
+	uint64_t block_time;
+	uint64_t last;
+	uint64_t start;
+
+	uint8_t *lz4;
+	size_t lz4_size;
+	off_t offset;
+
+	struct trace_block_index *index;
+	size_t count;
+	size_t max;
+
 	struct trace *next;
 } *traces;
 
-#define DRM_MAJOR 226
-
-enum {
-	ADD_BO = 0,
-	DEL_BO,
-	ADD_CTX,
-	DEL_CTX,
-	EXEC,
-	WAIT,
+struct scratch {
+	uint8_t *data;
+	size_t size;
 };
 
-static struct trace_verion {
-	uint32_t magic;
-	uint32_t version;
-} version = {
-	.magic = 0xdeadbeef,
-	.version = 1
-};
+#define DRM_MAJOR 226
 
-struct trace_add_bo {
-	uint8_t cmd;
-	uint32_t handle;
-	uint64_t size;
-} __attribute__((packed));
-struct trace_del_bo {
-	uint8_t cmd;
-	uint32_t handle;
-}__attribute__((packed));
-
-struct trace_add_ctx {
-	uint8_t cmd;
-	uint32_t handle;
-} __attribute__((packed));
-struct trace_del_ctx {
-	uint8_t cmd;
-	uint32_t handle;
-}__attribute__((packed));
-
-struct trace_exec {
-	uint8_t cmd;
-	uint32_t object_count;
-	uint64_t flags;
-	uint32_t context;
-}__attribute__((packed));
-
-struct trace_exec_object {
-	uint32_t handle;
-	uint32_t relocation_count;
-	uint64_t alignment;
-	uint64_t offset;
-	uint64_t flags;
-	uint64_t rsvd1;
-	uint64_t rsvd2;
-}__attribute__((packed));
-
-struct trace_exec_relocation {
-	uint32_t target_handle;
-	uint32_t delta;
-	uint64_t offset;
-	uint64_t presumed_offset;
-	uint32_t read_domains;
-	uint32_t write_domain;
-}__attribute__((packed));
-
-struct trace_wait {
-	uint8_t cmd;
-	uint32_t handle;
-} __attribute__((packed));
+static const struct trace_version version = {
+	.magic = TRACE_MAGIC,
+	.version = 2
+};
 
 static void __attribute__ ((format(__printf__, 2, 3)))
 fail_if(int cond, const char *format, ...)
@@ -140,6 +110,173 @@ fail_if(int cond, const char *format, ...)
 	abort();
 }
 
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void write_all(struct trace *trace, const void *data, size_t len)
+{
+	trace->offset += len;
+	while (len) {
+		ssize_t ret = write(trace->file, data, len);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+		fail_if(ret <= 0, "failed to write trace: %m\n");
+
+		data = (const uint8_t *)data + ret;
+		len -= ret;
+	}
+}
+
+static void *grow(void *ptr, size_t *size, size_t min, size_t elem)
+{
+	size_t new_size = *size ? *size : 1;
+
+	while (new_size < min)
+		new_size *= 2;
+
+	ptr = realloc(ptr, new_size * elem);
+	fail_if(!ptr, "out of memory\n");
+
+	*size = new_size;
+	return ptr;
+}
+
+static void trace_flush(struct trace *trace)
+{
+	struct trace_block blk = {
+		.magic = TRACE_BLOCK_MAGIC,
+		.raw_size = trace->len,
+	};
+	const void *data = trace->block;
+	size_t bound;
+	ssize_t ret;
+
+	if (!trace->len)
+		return;
+
+	bound = igt_lz4_compress_bound(trace->len);
+	if (bound > trace->lz4_size)
+		trace->lz4 = grow(trace->lz4, &trace->lz4_size, bound, 1);
+
+	/* Store the block as is if it does not compress */
+	blk.size = trace->len;
+	ret = igt_lz4_compress(trace->block, trace->len,
+			       trace->lz4, trace->lz4_size);
+	if (ret > 0 && (size_t)ret < trace->len) {
+		blk.flags = TRACE_BLOCK_LZ4;
+		blk.size = ret;
+		data = trace->lz4;
+	}
+
+	if (trace->count == trace->max)
+		trace->index = grow(trace->index, &trace->max, trace->count + 1,
+				    sizeof(*trace->index));
+	trace->index[trace->count].offset = trace->offset;
+	trace->index[trace->count].time = trace->block_time - trace->start;
+	trace->count++;
+
+	write_all(trace, &blk, sizeof(blk));
+	write_all(trace, data, blk.size);
+
+	trace->len = 0;
+	trace->last = trace->start;
+}
+
+static void trace_finish(struct trace *trace)
+{
+	struct trace_index idx = {
+		.magic = TRACE_INDEX_MAGIC,
+		.count = trace->count,
+	};
+
+	pthread_mutex_lock(&trace->lock);
+	trace_flush(trace);
+
+	idx.count = trace->count;
+	idx.offset = trace->offset;
+	write_all(trace, trace->index, trace->count * sizeof(*trace->index));
+	write_all(trace, &idx, sizeof(idx));
+	pthread_mutex_unlock(&trace->lock);
+}
+
+static void trace_free(struct trace *trace)
+{
+	libc_close(trace->file);
+	pthread_mutex_destroy(&trace->lock);
+	free(trace->block);
+	free(trace->lz4);
+	free(trace->index);
+	free(trace);
+}
+
+/*
+ * Reserves space for a record in the current block, with the trace lock
+ * held until trace_commit(). Blocks are grown to fit records larger than
+ * the block size.
+ */
+static uint8_t *trace_reserve(struct trace *trace, size_t len)
+{
+	pthread_mutex_lock(&trace->lock);
+
+	if (!trace->len)
+		trace->block_time = now();
+
+	if (trace->len + len > trace->size)
+		trace->block = grow(trace->block, &trace->size,
+				    trace->len + len, 1);
+
+	return trace->block + trace->len;
+}
+
+static void trace_commit(struct trace *trace, uint8_t *end)
+{
+	trace->len = end - trace->block;
+	if (trace->len >= TRACE_BLOCK_SIZE)
+		trace_flush(trace);
+
+	pthread_mutex_unlock(&trace->lock);
+}
+
+static uint8_t *trace_put_time(struct trace *trace, uint8_t *p)
+{
+	uint64_t t = now();
+
+	p = trace_put_varint(p, t - trace->last);
+	trace->last = t;
+
+	return p;
+}
+
+static uint8_t *scratch_reserve(size_t len)
+{
+	struct scratch *s = pthread_getspecific(scratch_key);
+
+	if (!s) {
+		s = calloc(1, sizeof(*s));
+		fail_if(!s, "out of memory\n");
+		pthread_setspecific(scratch_key, s);
+	}
+
+	if (len > s->size)
+		s->data = grow(s->data, &s->size, len, 1);
+
+	return s->data;
+}
+
+static void scratch_free(void *arg)
+{
+	struct scratch *s = arg;
+
+	free(s->data);
+	free(s);
+}
+
 static void
 trace_exec(struct trace *trace,
 	   const struct drm_i915_gem_execbuffer2 *execbuffer2)
@@ -147,79 +284,133 @@ trace_exec(struct trace *trace,
 #define to_ptr(T, x) ((T *)(uintptr_t)(x))
 	const struct drm_i915_gem_exec_object2 *exec_objects =
 		to_ptr(typeof(*exec_objects), execbuffer2->buffers_ptr);
+	uint64_t relocs = 0;
+	uint64_t handle = 0, offset = 0;
+	uint8_t *buf, *p;
+	size_t len;
 
 	fail_if(execbuffer2->flags & (I915_EXEC_FENCE_IN | I915_EXEC_FENCE_OUT),
 		"fences not supported yet\n");
 
-	flockfile(trace->file);
-	{
-		struct trace_exec t = {
-			EXEC,
-			execbuffer2->buffer_count,
-			execbuffer2->flags,
-			execbuffer2->rsvd1,
-		};
-		fwrite(&t, sizeof(t), 1, trace->file);
-	}
+	for (uint32_t i = 0; i < execbuffer2->buffer_count; i++)
+		relocs += exec_objects[i].relocation_count;
+
+	buf = p = scratch_reserve(TRACE_EXEC_MAX(execbuffer2->buffer_count,
+						 relocs));
+	p = trace_put_varint(p, execbuffer2->buffer_count);
+	p = trace_put_varint(p, execbuffer2->flags);
+	p = trace_put_varint(p, execbuffer2->rsvd1);
 
 	for (uint32_t i = 0; i < execbuffer2->buffer_count; i++) {
 		const struct drm_i915_gem_exec_object2 *obj = &exec_objects[i];
-		const struct drm_i915_gem_relocation_entry *relocs =
-			to_ptr(typeof(*relocs), obj->relocs_ptr);
-		{
-			struct trace_exec_object t = {
-				obj->handle,
-				obj->relocation_count,
-				obj->alignment,
-				obj->offset,
-				obj->flags,
-				obj->rsvd1,
-				obj->rsvd2
-			};
-			fwrite(&t, sizeof(t), 1, trace->file);
+		const struct drm_i915_gem_relocation_entry *reloc =
+			to_ptr(typeof(*reloc), obj->relocs_ptr);
+		uint64_t target = 0, roffset = 0, presumed = 0;
+
+		p = trace_put_varint(p, trace_zigzag(obj->handle - handle));
+		p = trace_put_varint(p, obj->relocation_count);
+		p = trace_put_varint(p, obj->alignment);
+		p = trace_put_varint(p, trace_zigzag(obj->offset - offset));
+		p = trace_put_varint(p, obj->flags);
+		p = trace_put_varint(p, obj->rsvd1);
+		p = trace_put_varint(p, obj->rsvd2);
+		handle = obj->handle;
+		offset = obj->offset;
+
+		for (uint32_t j = 0; j < obj->relocation_count; j++, reloc++) {
+			p = trace_put_varint(p, trace_zigzag(reloc->target_handle - target));
+			p = trace_put_varint(p, reloc->delta);
+			p = trace_put_varint(p, trace_zigzag(reloc->offset - roffset));
+			p = trace_put_varint(p, trace_zigzag(reloc->presumed_offset - presumed));
+			p = trace_put_varint(p, reloc->read_domains);
+			p = trace_put_varint(p, reloc->write_domain);
+			target = reloc->target_handle;
+			roffset = reloc->offset;
+			presumed = reloc->presumed_offset;
 		}
-		fwrite(relocs, sizeof(*relocs), obj->relocation_count,
-		       trace->file);
 	}
+	len = p - buf;
 
-	fflush(trace->file);
-	funlockfile(trace->file);
+	p = trace_reserve(trace, 1 + TRACE_VARINT_MAX + len);
+	*p++ = EXEC;
+	p = trace_put_time(trace, p);
+	memcpy(p, buf, len);
+	trace_commit(trace, p + len);
 #undef to_ptr
 }
 
 static void
 trace_wait(struct trace *trace, uint32_t handle)
 {
-	struct trace_wait t = { WAIT, handle };
-	fwrite(&t, sizeof(t), 1, trace->file);
+	uint8_t *p = trace_reserve(trace, 1 + 2 * TRACE_VARINT_MAX);
+
+	*p++ = WAIT;
+	p = trace_put_time(trace, p);
+	p = trace_put_varint(p, handle);
+	trace_commit(trace, p);
 }
 
 static void
 trace_add(struct trace *trace, uint32_t handle, uint64_t size)
 {
-	struct trace_add_bo t = { ADD_BO, handle, size };
-	fwrite(&t, sizeof(t), 1, trace->file);
+	uint8_t *p = trace_reserve(trace, 1 + 2 * TRACE_VARINT_MAX);
+
+	*p++ = ADD_BO;
+	p = trace_put_varint(p, handle);
+	p = trace_put_varint(p, size);
+	trace_commit(trace, p);
+}
+
+static void
+trace_handle(struct trace *trace, uint8_t cmd, uint32_t handle)
+{
+	uint8_t *p = trace_reserve(trace, 1 + TRACE_VARINT_MAX);
+
+	*p++ = cmd;
+	p = trace_put_varint(p, handle);
+	trace_commit(trace, p);
 }
 
 static void
 trace_del(struct trace *trace, uint32_t handle)
 {
-	struct trace_del_bo t = { DEL_BO, handle };
-	fwrite(&t, sizeof(t), 1, trace->file);
+	trace_handle(trace, DEL_BO, handle);
 }
 
 static void
 trace_add_context(struct trace *trace, uint32_t handle)
 {
-	struct trace_add_ctx t = { ADD_CTX, handle };
-	fwrite(&t, sizeof(t), 1, trace->file);
+	trace_handle(trace, ADD_CTX, handle);
 }
 
 static void
 trace_del_context(struct trace *trace, uint32_t handle)
 {
-	struct trace_del_ctx t = { DEL_CTX, handle };
-	fwrite(&t, sizeof(t), 1, trace->file);
+	trace_handle(trace, DEL_CTX, handle);
+}
+
+static struct trace *trace_create(int fd)
+{
+	struct trace *t;
+	char filename[80];
+
+	t = calloc(1, sizeof(*t));
+	if (!t)
+		return NULL;
+
+	sprintf(filename, "/tmp/trace-%d.%d", getpid(), fd);
+	t->file = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (t->file < 0) {
+		free(t);
+		return NULL;
+	}
+
+	t->fd = fd;
+	pthread_mutex_init(&t->lock, NULL);
+	t->start = t->last = now();
+	write_all(t, &version, sizeof(version));
+
+	return t;
 }
 
 int
@@ -231,8 +422,8 @@ close(int fd)
 	for (p = &traces; (t = *p); p = &t->next) {
 		if (t->fd == fd) {
 			*p = t->next;
-			fclose(t->file);
-			free(t);
+			trace_finish(t);
+			trace_free(t);
 			break;
 		}
 	}
@@ -297,30 +488,17 @@ ioctl(int fd, unsigned long request, ...)
 		}
 	}
 	if (!t) {
-		char filename[80];
-
 		if (!is_i915(fd)) {
 			pthread_mutex_unlock(&mutex);
 			goto untraced;
 		}
 
-		t = malloc(sizeof(*t));
+		t = trace_create(fd);
 		if (!t) {
 			pthread_mutex_unlock(&mutex);
 			return -ENOMEM;
 		}
 
-		sprintf(filename, "/tmp/trace-%d.%d", getpid(), fd);
-		t->file = fopen(filename, "w+");
-		t->fd = fd;
-
-		if (!fwrite(&version, sizeof(version), 1, t->file)) {
-			pthread_mutex_unlock(&mutex);
-			fclose(t->file);
-			free(t);
-			return -ENOMEM;
-		}
-
 		t->next = traces;
 		traces = t;
 	}
@@ -407,6 +585,33 @@ untraced:
 	return libc_ioctl(fd, request, argp);
 }
 
+/*
+ * The child inherits the parent's unwritten blocks, which must not end up
+ * in the parent's trace file a second time. Its own use of the device is
+ * traced afresh under its pid.
+ */
+static void fork_prepare(void)
+{
+	pthread_mutex_lock(&mutex);
+}
+
+static void fork_parent(void)
+{
+	pthread_mutex_unlock(&mutex);
+}
+
+static void fork_child(void)
+{
+	struct trace *t;
+
+	pthread_mutex_init(&mutex, NULL);
+	while ((t = traces)) {
+		traces = t->next;
+		pthread_mutex_init(&t->lock, NULL);
+		trace_free(t);
+	}
+}
+
 static void __attribute__ ((constructor))
 init(void)
 {
@@ -414,4 +619,22 @@ init(void)
 	libc_ioctl = dlsym(RTLD_NEXT, "ioctl");
 	fail_if(libc_close == NULL || libc_ioctl == NULL,
 		"failed to get libc ioctl or close\n");
+
+	fail_if(pthread_key_create(&scratch_key, scratch_free),
+		"failed to create scratch key\n");
+	pthread_atfork(fork_prepare, fork_parent, fork_child);
+}
+
+static void __attribute__ ((destructor))
+fini(void)
+{
+	struct trace *t;
+
+	pthread_mutex_lock(&mutex);
+	while ((t = traces)) {
+		traces = t->next;
+		trace_finish(t);
+		trace_free(t);
+	}
+	pthread_mutex_unlock(&mutex);
 }
@@ -35,12 +35,14 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/prctl.h>
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <assert.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sched.h>
 #include <math.h>
 
 #include "drm.h"
@@ -181,6 +183,11 @@ struct w_step
 	struct drm_i915_gem_relocation_entry reloc[3];
 	uint32_t bb_handle;
 	uint32_t *bb_duration;
+
+	/* Submission overhead, CPU time spent in execbuf. */
+	unsigned long submits;
+	uint64_t submit_ns;
+	uint64_t submit_max_ns;
 };
 
 struct ctx {
@@ -194,6 +201,17 @@ struct ctx {
 	uint64_t sseu;
 };
 
+#define LATENESS_BUCKETS 16
+
+struct overhead {
+	unsigned int missed;
+	unsigned long sleeps;
+	uint64_t late_ns;
+	uint64_t late_max_ns;
+	/* Wakeups by lateness, [2^(i-1), 2^i) us with the last one open. */
+	unsigned long late[LATENESS_BUCKETS];
+};
+
 struct workload
 {
 	unsigned int id;
@@ -204,6 +222,7 @@ struct workload
 	bool sseu;
 
 	pthread_t thread;
+	int cpu;
 	bool run;
 	bool background;
 	unsigned int repeat;
@@ -226,12 +245,17 @@ struct workload
 
 	struct igt_list_head requests[NUM_ENGINES];
 	unsigned int nrequest[NUM_ENGINES];
+
+	struct overhead overhead;
 };
 
 static unsigned int master_prng;
 
 static int verbose = 1;
 static int fd;
+static bool simulate;
+static bool overhead_report;
+static uint64_t tick_ns;
 static struct drm_i915_gem_context_param_sseu device_sseu = {
 	.slice_mask = -1 /* Force read on first use. */
 };
@@ -1127,7 +1151,8 @@ parse_workload(struct w_arg *arg, unsigned int flags, double scale_dur,
 			fstart = NULL;
 
 			if (field[0] == '*') {
-				check_arg(intel_gen(intel_get_drm_devid(fd)) < 8,
+				check_arg(!simulate &&
+					  intel_gen(intel_get_drm_devid(fd)) < 8,
 					  "Infinite batch at step %u needs Gen8+!\n",
 					  nr_steps);
 				step.unbound_duration = true;
@@ -1334,7 +1359,7 @@ clone_workload(struct workload *_wrk)
 	}
 
 	/* Check if we need a sw sync timeline. */
-	for (i = 0; i < wrk->nr_steps; i++) {
+	for (i = 0; !simulate && i < wrk->nr_steps; i++) {
 		if (wrk->steps[i].type == SW_FENCE) {
 			wrk->sync_timeline = sw_sync_timeline_create();
 			igt_assert(wrk->sync_timeline >= 0);
@@ -1548,8 +1573,13 @@ get_ctxid(struct workload *wrk, struct w_step *w)
 	return wrk->ctx_list[w->context].id;
 }
 
+static uint32_t sim_alloc_buffer(void);
+
 static uint32_t alloc_bo(int i915, unsigned long size)
 {
+	if (simulate)
+		return sim_alloc_buffer();
+
 	return gem_create(i915, size);
 }
 
@@ -1848,20 +1878,12 @@ static void measure_active_set(struct workload *wrk)
 
 #define alloca0(sz) ({ size_t sz__ = (sz); memset(alloca(sz__), 0, sz__); })
 
-static int prepare_workload(unsigned int id, struct workload *wrk)
+static int prepare_contexts(struct workload *wrk)
 {
-	struct working_set **sets;
-	unsigned long total = 0;
-	uint32_t share_vm = 0;
 	int max_ctx = -1;
 	struct w_step *w;
 	int i, j;
 
-	wrk->id = id;
-	wrk->bb_prng = (wrk->flags & SYNCEDCLIENTS) ? master_prng : rand();
-	wrk->bo_prng = (wrk->flags & SYNCEDCLIENTS) ? master_prng : rand();
-	wrk->run = true;
-
 	/*
 	 * Pre-scan workload steps to allocate context list storage.
 	 */
@@ -1903,7 +1925,8 @@ static int prepare_workload(unsigned int id, struct workload *wrk)
 					wsim_err("Load balancing needs an engine map!\n");
 					return 1;
 				}
-				if (intel_gen(intel_get_drm_devid(fd)) < 11) {
+				if (!simulate &&
+				    intel_gen(intel_get_drm_devid(fd)) < 11) {
 					wsim_err("Load balancing needs relative mmio support, gen11+!\n");
 					return 1;
 				}
@@ -1926,6 +1949,79 @@ static int prepare_workload(unsigned int id, struct workload *wrk)
 		}
 	}
 
+	return 0;
+}
+
+static void prepare_working_sets(struct workload *wrk)
+{
+	struct working_set **sets;
+	unsigned long total = 0;
+	struct w_step *w;
+	int i;
+
+	/*
+	 * Allocate working sets.
+	 */
+	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
+		if (w->type == WORKINGSET && !w->working_set.shared)
+			total += allocate_working_set(wrk, &w->working_set);
+	}
+
+	if (verbose > 2)
+		printf("%u: %lu bytes in working sets.\n", wrk->id, total);
+
+	/*
+	 * Map of working set ids.
+	 */
+	wrk->max_working_set_id = -1;
+	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
+		if (w->type == WORKINGSET &&
+		    w->working_set.id > wrk->max_working_set_id)
+			wrk->max_working_set_id = w->working_set.id;
+	}
+
+	sets = wrk->working_sets;
+	wrk->working_sets = calloc(wrk->max_working_set_id + 1,
+				   sizeof(*wrk->working_sets));
+	igt_assert(wrk->working_sets);
+
+	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
+		struct working_set *set;
+
+		if (w->type != WORKINGSET)
+			continue;
+
+		if (!w->working_set.shared) {
+			set = &w->working_set;
+		} else {
+			igt_assert(sets);
+
+			set = sets[w->working_set.id];
+			igt_assert(set->shared);
+			igt_assert(set->sizes);
+		}
+
+		wrk->working_sets[w->working_set.id] = set;
+	}
+
+	if (sets)
+		free(sets);
+}
+
+static int prepare_workload(unsigned int id, struct workload *wrk)
+{
+	uint32_t share_vm = 0;
+	struct w_step *w;
+	int i, j;
+
+	wrk->id = id;
+	wrk->bb_prng = (wrk->flags & SYNCEDCLIENTS) ? master_prng : rand();
+	wrk->bo_prng = (wrk->flags & SYNCEDCLIENTS) ? master_prng : rand();
+	wrk->run = true;
+
+	if (prepare_contexts(wrk))
+		return 1;
+
 	/*
 	 * Create and configure contexts.
 	 */
@@ -2091,53 +2187,7 @@ static int prepare_workload(unsigned int id, struct workload *wrk)
 		}
 	}
 
-	/*
-	 * Allocate working sets.
-	 */
-	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
-		if (w->type == WORKINGSET && !w->working_set.shared)
-			total += allocate_working_set(wrk, &w->working_set);
-	}
-
-	if (verbose > 2)
-		printf("%u: %lu bytes in working sets.\n", wrk->id, total);
-
-	/*
-	 * Map of working set ids.
-	 */
-	wrk->max_working_set_id = -1;
-	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
-		if (w->type == WORKINGSET &&
-		    w->working_set.id > wrk->max_working_set_id)
-			wrk->max_working_set_id = w->working_set.id;
-	}
-
-	sets = wrk->working_sets;
-	wrk->working_sets = calloc(wrk->max_working_set_id + 1,
-				   sizeof(*wrk->working_sets));
-	igt_assert(wrk->working_sets);
-
-	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
-		struct working_set *set;
-
-		if (w->type != WORKINGSET)
-			continue;
-
-		if (!w->working_set.shared) {
-			set = &w->working_set;
-		} else {
-			igt_assert(sets);
-
-			set = sets[w->working_set.id];
-			igt_assert(set->shared);
-			igt_assert(set->sizes);
-		}
-
-		wrk->working_sets[w->working_set.id] = set;
-	}
-
-	if (sets)
-		free(sets);
+	prepare_working_sets(wrk);
 
 	/*
 	 * Allocate batch buffers.
@@ -2165,6 +2215,64 @@ static int elapsed_us(const struct timespec *start, const struct timespec *end)
 	return elapsed(start, end) * 1e6;
 }
 
+static uint64_t ts_to_ns(const struct timespec *ts)
+{
+	return ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static struct timespec ns_to_ts(uint64_t ns)
+{
+	return (struct timespec){ .tv_sec = ns / NSEC_PER_SEC,
+				  .tv_nsec = ns % NSEC_PER_SEC };
+}
+
+static uint64_t thread_cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+	return ts_to_ns(&ts);
+}
+
+/*
+ * Sleeps until an absolute deadline so time spent in the driver does not add
+ * up over the steps. With a tick the deadline is rounded up to the next tick,
+ * so clients due at about the same time share a timer wakeup. Each client
+ * still submits its own batches.
+ */
+static void sleep_until(struct workload *wrk, uint64_t deadline)
+{
+	struct overhead *o = &wrk->overhead;
+	struct timespec ts, now;
+	uint64_t late;
+	unsigned int bucket;
+
+	if (tick_ns)
+		deadline = (deadline + tick_ns - 1) / tick_ns * tick_ns;
+
+	ts = ns_to_ts(deadline);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+
+	if (!overhead_report)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	late = ts_to_ns(&now) > deadline ? ts_to_ns(&now) - deadline : 0;
+
+	bucket = 0;
+	while (bucket < LATENESS_BUCKETS - 1 && late >= 1000ull << bucket)
+		bucket++;
+
+	o->sleeps++;
+	o->late_ns += late;
+	if (late > o->late_max_ns)
+		o->late_max_ns = late;
+	o->late[bucket]++;
+}
+
 static void
 update_bb_start(struct workload *wrk, struct w_step *w)
 {
@@ -2265,15 +2373,30 @@ static void *run_workload(void *data)
 	int qd_throttle = -1;
 	int count, missed = 0;
 	unsigned long time_tot = 0, time_min = ULONG_MAX, time_max = 0;
+	uint64_t period_end = 0;
 	int i;
 
+	/* Default timer slack would add tens of microseconds to every sleep. */
+	prctl(PR_SET_TIMERSLACK, 1);
+
 	clock_gettime(CLOCK_MONOTONIC, &t_start);
 
 	for (count = 0; wrk->run && (wrk->background || count < wrk->repeat);
 	     count++) {
 		unsigned int cur_seqno = wrk->sync_seqno;
 
-		clock_gettime(CLOCK_MONOTONIC, &wrk->repeat_start);
+		/*
+		 * A loop ending in a period starts the next one where that
+		 * period ends, not where the wakeup landed, so late wakeups
+		 * and tick rounding are made up for instead of stretching
+		 * the period. Lateness running into the next period shows
+		 * up as a missed one.
+		 */
+		if (period_end)
+			wrk->repeat_start = ns_to_ts(period_end);
+		else
+			clock_gettime(CLOCK_MONOTONIC, &wrk->repeat_start);
+		period_end = 0;
 
 		for (i = 0, w = wrk->steps; wrk->run && (i < wrk->nr_steps);
 		     i++, w++) {
@@ -2371,7 +2494,21 @@ static void *run_workload(void *data)
 			}
 
 			if (do_sleep || w->type == PERIOD) {
-				usleep(do_sleep);
+				struct timespec now;
+				uint64_t deadline;
+
+				if (w->type == PERIOD) {
+					deadline = ts_to_ns(&wrk->repeat_start) +
+						   w->period * 1000ull;
+					if (i == wrk->nr_steps - 1)
+						period_end = deadline;
+				} else {
+					clock_gettime(CLOCK_MONOTONIC, &now);
+					deadline = ts_to_ns(&now) +
+						   do_sleep * 1000ull;
+				}
+
+				sleep_until(wrk, deadline);
 				continue;
 			}
 
@@ -2383,7 +2520,19 @@ static void *run_workload(void *data)
 			if (throttle > 0)
 				w_sync_to(wrk, w, i - throttle);
 
-			do_eb(wrk, w, engine);
+			if (overhead_report) {
+				uint64_t cpu = thread_cpu_ns();
+
+				do_eb(wrk, w, engine);
+
+				cpu = thread_cpu_ns() - cpu;
+				w->submits++;
+				w->submit_ns += cpu;
+				if (cpu > w->submit_max_ns)
+					w->submit_max_ns = cpu;
+			} else {
+				do_eb(wrk, w, engine);
+			}
 
 			if (w->request != -1) {
 				igt_list_del(&w->rq_link);
@@ -2443,6 +2592,8 @@ static void *run_workload(void *data)
 
 	clock_gettime(CLOCK_MONOTONIC, &t_end);
 
+	wrk->overhead.missed = missed;
+
 	if (wrk->print_stats) {
 		double t = elapsed(&t_start, &t_end);
 
@@ -2458,93 +2609,1254 @@ static void *run_workload(void *data)
 	return NULL;
 }
 
-static void fini_workload(struct workload *wrk)
-{
-	free(wrk->steps);
-	free(wrk);
-}
+/*
+ * Virtual time simulation.
+ *
+ * With -V workloads are not submitted to the GPU but fed to a discrete
+ * event model of a configurable set of engines. Batches occupy an engine
+ * for their duration in virtual time, delays and periods advance the
+ * virtual clock, and each request tracks its dependencies: context
+ * ordering, implicit sync on the buffers it uses, and in and submit
+ * fences. Clients step through their workloads like run_workload() does.
+ * The statistics are those of a real run, in virtual time, so many
+ * configurations can be swept quickly and without a GPU.
+ *
+ * Preemption and SSEU steps are accepted but not modelled.
+ */
 
-static void print_help(void)
-{
-	puts(
-"Usage: gem_wsim [OPTIONS]\n"
-"\n"
-"Runs a simulated workload on the GPU.\n"
-"Options:\n"
-"  -h                This text.\n"
-"  -q                Be quiet - do not output anything to stdout.\n"
-"  -I <n>            Initial randomness seed.\n"
-"  -p <n>            Context priority to use for the following workload on the\n"
-"                    command line.\n"
-"  -w <desc|path>    Filename or a workload descriptor.\n"
-"                    Can be given multiple times.\n"
-"  -W <desc|path>    Filename or a master workload descriptor.\n"
-"                    Only one master workload can be optinally specified in which\n"
-"                    case all other workloads become background ones and run as\n"
-"                    long as the master.\n"
-"  -a <desc|path>    Append a workload to all other workloads.\n"
-"  -r <n>            How many times to emit the workload.\n"
-"  -c <n>            Fork N clients emitting the workload simultaneously.\n"
-"  -s                Turn on small SSEU config for the next workload on the\n"
-"                    command line. Subsequent -s switches it off.\n"
-"  -S                Synchronize the sequence of random batch durations between\n"
-"                    clients.\n"
-"  -d                Sync between data dependencies in userspace.\n"
-"  -f <scale>        Scale factor for batch durations.\n"
-"  -F <scale>        Scale factor for delays.\n"
-"  -L                List GPUs.\n"
-"  -D <gpu>          One of the GPUs from -L.\n"
-	);
-}
+enum sim_state {
+	SIM_QUEUED = 0,
+	SIM_RUNNING,
+	SIM_DONE,
+};
 
-static char *load_workload_descriptor(char *filename)
-{
-	struct stat sbuf;
-	char *buf;
-	int infd, ret, i;
-	ssize_t len;
+struct sim_request;
+struct sim_client;
 
-	ret = stat(filename, &sbuf);
-	if (ret || !S_ISREG(sbuf.st_mode))
-		return filename;
+/* Requests are recycled, so references also carry the sequence number. */
+struct sim_ref {
+	struct sim_request *rq;
+	uint64_t seq;
+};
 
-	igt_assert(sbuf.st_size < 1024 * 1024); /* Just so. */
-	buf = malloc(sbuf.st_size);
-	igt_assert(buf);
+struct sim_dep {
+	struct sim_ref ref;
+	bool submit; /* Satisfied once the signaler starts executing. */
+};
 
-	infd = open(filename, O_RDONLY);
-	igt_assert(infd >= 0);
-	len = read(infd, buf, sbuf.st_size);
-	igt_assert(len == sbuf.st_size);
-	close(infd);
+struct sim_request {
+	uint64_t seq;
+	enum sim_state state;
+	struct igt_list_head link;
 
-	for (i = 0; i < len; i++) {
-		if (buf[i] == '\n')
-			buf[i] = ',';
-	}
+	struct sim_client *client;
+	struct w_step *w; /* NULL for software fences. */
+	uint64_t siblings;
+	int prio;
+	uint64_t duration; /* In ns, UINT64_MAX until terminated. */
+	uint64_t start, end;
+	enum intel_engine_id engine;
 
-	len--;
-	while (buf[len] == ',')
-		buf[len--] = 0;
+	unsigned int nr_deps, max_deps;
+	struct sim_dep *deps;
+};
 
-	return buf;
-}
+struct sim_buffer {
+	struct sim_ref write;
+	unsigned int nr_reads, max_reads;
+	struct sim_ref *reads;
+};
 
-static struct w_arg *
-add_workload_arg(struct w_arg *w_args, unsigned int nr_args, char *w_arg,
-		 int prio, bool sseu)
-{
-	w_args = realloc(w_args, sizeof(*w_args) * nr_args);
-	igt_assert(w_args);
-	w_args[nr_args - 1] = (struct w_arg) { w_arg, NULL, prio, sseu };
+struct sim_engine {
+	bool present;
+	double speed;
+	struct sim_request *rq;
+	unsigned int queued;
+	uint64_t busy;
+};
 
-	return w_args;
-}
+struct sim_client {
+	struct workload *wrk;
+	bool master;
 
-int main(int argc, char **argv)
+	struct sim_ref *rq; /* Last request of each step. */
+	uint32_t *bo; /* Output buffer of each batch step. */
+	enum intel_engine_id *ran_on;
+	struct sim_ref *timeline; /* Last request per context and engine. */
+
+	struct sim_ref wait;
+	uint64_t wake;
+	uint64_t repeat_start, end;
+
+	unsigned int step, count, missed;
+	int throttle, qd_throttle;
+	unsigned long time_tot, time_min, time_max;
+	bool iterating, submitted, draining, finished;
+};
+
+struct sim_scheduler {
+	const char *name;
+	/* Picks an engine at submission, NULL to bind when one goes idle. */
+	enum intel_engine_id (*bind)(const struct sim_request *rq);
+	/* Whether @a should run before @b when both are ready. */
+	bool (*before)(const struct sim_request *a, const struct sim_request *b);
+};
+
+static struct sim_engine sim_engines[NUM_ENGINES];
+static const struct sim_scheduler *sim_scheduler;
+static struct sim_buffer *sim_buffers;
+static unsigned int sim_nr_buffers, sim_max_buffers;
+static struct sim_client *sim_clients;
+static unsigned int sim_nr_clients;
+static IGT_LIST_HEAD(sim_pending);
+static IGT_LIST_HEAD(sim_free);
+static uint64_t sim_seqno;
+static uint64_t sim_now;
+
+static uint32_t sim_alloc_buffer(void)
+{
+	/* Handle zero is never used, like with GEM. */
+	if (!sim_nr_buffers)
+		sim_nr_buffers = 1;
+
+	if (sim_nr_buffers == sim_max_buffers || !sim_buffers) {
+		sim_max_buffers = sim_max_buffers ? 2 * sim_max_buffers : 64;
+		sim_buffers = realloc(sim_buffers,
+				      sim_max_buffers * sizeof(*sim_buffers));
+		igt_assert(sim_buffers);
+	}
+
+	memset(&sim_buffers[sim_nr_buffers], 0, sizeof(*sim_buffers));
+
+	return sim_nr_buffers++;
+}
+
+static struct sim_ref sim_ref(struct sim_request *rq)
+{
+	return (struct sim_ref){ .rq = rq, .seq = rq->seq };
+}
+
+static bool sim_ref_done(struct sim_ref ref)
+{
+	return !ref.rq || ref.rq->seq != ref.seq || ref.rq->state == SIM_DONE;
+}
+
+static bool sim_ref_started(struct sim_ref ref)
+{
+	return !ref.rq || ref.rq->seq != ref.seq ||
+	       ref.rq->state != SIM_QUEUED;
+}
+
+static struct sim_request *sim_request_alloc(struct sim_client *c)
+{
+	struct sim_request *rq;
+
+	if (igt_list_empty(&sim_free)) {
+		rq = calloc(1, sizeof(*rq));
+		igt_assert(rq);
+	} else {
+		rq = igt_list_first_entry(&sim_free, rq, link);
+		igt_list_del(&rq->link);
+	}
+
+	rq->seq = ++sim_seqno;
+	rq->state = SIM_QUEUED;
+	rq->client = c;
+	rq->w = NULL;
+	rq->nr_deps = 0;
+
+	return rq;
+}
+
+static void sim_request_retire(struct sim_request *rq)
+{
+	rq->state = SIM_DONE;
+	igt_list_add(&rq->link, &sim_free);
+}
+
+static void
+sim_add_dep(struct sim_request *rq, struct sim_ref ref, bool submit)
+{
+	if (ref.rq == rq ||
+	    (submit ? sim_ref_started(ref) : sim_ref_done(ref)))
+		return;
+
+	if (rq->nr_deps == rq->max_deps) {
+		rq->max_deps = rq->max_deps ? 2 * rq->max_deps : 4;
+		rq->deps = realloc(rq->deps, rq->max_deps * sizeof(*rq->deps));
+		igt_assert(rq->deps);
+	}
+
+	rq->deps[rq->nr_deps++] = (struct sim_dep){ .ref = ref,
+						    .submit = submit };
+}
+
+/*
+ * Implicit synchronisation: readers wait for the last writer, writers wait
+ * for the last writer and all readers since.
+ */
+static void
+sim_use_buffer(struct sim_request *rq, uint32_t handle, bool write)
+{
+	struct sim_buffer *b = &sim_buffers[handle];
+	unsigned int i, j;
+
+	sim_add_dep(rq, b->write, false);
+
+	if (write) {
+		for (i = 0; i < b->nr_reads; i++)
+			sim_add_dep(rq, b->reads[i], false);
+		b->nr_reads = 0;
+		b->write = sim_ref(rq);
+		return;
+	}
+
+	for (i = j = 0; i < b->nr_reads; i++) {
+		if (!sim_ref_done(b->reads[i]))
+			b->reads[j++] = b->reads[i];
+	}
+	b->nr_reads = j;
+
+	if (b->nr_reads == b->max_reads) {
+		b->max_reads = b->max_reads ? 2 * b->max_reads : 4;
+		b->reads = realloc(b->reads, b->max_reads * sizeof(*b->reads));
+		igt_assert(b->reads);
+	}
+
+	b->reads[b->nr_reads++] = sim_ref(rq);
+}
+
+static uint64_t sim_present_mask(void)
+{
+	uint64_t mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < NUM_ENGINES; i++) {
+		if (sim_engines[i].present)
+			mask |= 1ull << i;
+	}
+
+	return mask;
+}
+
+/* Engines a batch can execute on, following eb_update_flags(). */
+static uint64_t sim_siblings(struct workload *wrk, const struct w_step *w)
+{
+	struct ctx *ctx = __get_ctx(wrk, w);
+	uint64_t mask = 0;
+	unsigned int i;
+
+	if (ctx->engine_map) {
+		for (i = 0; i < ctx->engine_map_count; i++) {
+			if (ctx->engine_map[i] == w->engine)
+				return (1ull << w->engine) & sim_present_mask();
+		}
+
+		/* Not in the map means the load balanced virtual engine. */
+		for (i = 0; i < ctx->engine_map_count; i++)
+			mask |= 1ull << ctx->engine_map[i];
+	} else if (w->engine == DEFAULT) {
+		mask = 1ull << RCS;
+	} else if (w->engine == VCS) {
+		mask = 1ull << VCS1 | 1ull << VCS2;
+	} else {
+		mask = 1ull << w->engine;
+	}
+
+	return mask & sim_present_mask();
+}
+
+static bool sim_bonded(struct sim_client *c, const struct w_step *w)
+{
+	return w->fence_deps.nr && w->fence_deps.submit_fence &&
+	       __get_ctx(c->wrk, w)->bond_count;
+}
+
+/* Further restricts a ready request by the engine of its bond master. */
+static uint64_t sim_bond_mask(const struct sim_request *rq)
+{
+	struct w_step *w = rq->w;
+	enum intel_engine_id master;
+	uint64_t mask = rq->siblings;
+	struct ctx *ctx;
+	unsigned int i;
+
+	if (!sim_bonded(rq->client, w))
+		return mask;
+
+	ctx = __get_ctx(rq->client->wrk, w);
+	master = rq->client->ran_on[w->idx + w->fence_deps.list[0].target];
+
+	for (i = 0; i < ctx->bond_count; i++) {
+		if (ctx->bonds[i].master == master)
+			mask &= ctx->bonds[i].mask;
+	}
+
+	return mask;
+}
+
+static enum intel_engine_id sim_bind_rr(const struct sim_request *rq)
+{
+	static unsigned int next;
+	unsigned int i;
+
+	for (i = 0; i < NUM_ENGINES; i++) {
+		enum intel_engine_id engine = (next + i) % NUM_ENGINES;
+
+		if (rq->siblings & (1ull << engine)) {
+			next = engine + 1;
+			return engine;
+		}
+	}
+
+	igt_assert(0);
+	return DEFAULT;
+}
+
+static enum intel_engine_id sim_bind_qd(const struct sim_request *rq)
+{
+	enum intel_engine_id engine, best = DEFAULT;
+	unsigned int queued = UINT_MAX;
+
+	for (engine = 0; engine < NUM_ENGINES; engine++) {
+		if (!(rq->siblings & (1ull << engine)))
+			continue;
+
+		if (sim_engines[engine].queued < queued) {
+			queued = sim_engines[engine].queued;
+			best = engine;
+		}
+	}
+
+	igt_assert(queued != UINT_MAX);
+	return best;
+}
+
+static bool
+sim_before_fifo(const struct sim_request *a, const struct sim_request *b)
+{
+	return a->seq < b->seq;
+}
+
+static bool
+sim_before_prio(const struct sim_request *a, const struct sim_request *b)
+{
+	if (a->prio != b->prio)
+		return a->prio > b->prio;
+
+	return a->seq < b->seq;
+}
+
+static const struct sim_scheduler sim_schedulers[] = {
+	{ .name = "prio", .before = sim_before_prio },
+	{ .name = "fifo", .before = sim_before_fifo },
+	{ .name = "rr", .bind = sim_bind_rr, .before = sim_before_prio },
+	{ .name = "qd", .bind = sim_bind_qd, .before = sim_before_prio },
+};
+
+static const struct sim_scheduler *sim_find_scheduler(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sim_schedulers); i++) {
+		if (!strcmp(sim_schedulers[i].name, name))
+			return &sim_schedulers[i];
+	}
+
+	return NULL;
+}
+
+static const struct {
+	const char *name;
+	enum intel_engine_id first;
+	unsigned int max;
+	unsigned int class;
+} sim_classes[] = {
+	{ "rcs", RCS, 1, I915_ENGINE_CLASS_RENDER },
+	{ "bcs", BCS, 1, I915_ENGINE_CLASS_COPY },
+	{ "vcs", VCS1, 2, I915_ENGINE_CLASS_VIDEO },
+	{ "vecs", VECS, 1, I915_ENGINE_CLASS_VIDEO_ENHANCE },
+};
+
+static int sim_add_engines(unsigned int class, unsigned int count,
+			   double speed)
+{
+	unsigned int i;
+
+	if (count > sim_classes[class].max || speed <= 0)
+		return -1;
+
+	for (i = 0; i < sim_classes[class].max; i++) {
+		struct sim_engine *engine =
+			&sim_engines[sim_classes[class].first + i];
+
+		engine->present = i < count;
+		engine->speed = speed;
+	}
+
+	return 0;
+}
+
+/*
+ * Parses "<class>=<count>[@<speed>],..." or "default", and fakes the engine
+ * query results to match so engine maps resolve as on real hardware.
+ */
+static int sim_parse_engines(const char *spec)
+{
+	char *str = strdup(spec), *token, *tctx = NULL, *tstart = str;
+	struct i915_engine_class_instance *engines;
+	unsigned int i, j, num = 0;
+	int ret = 0;
+
+	igt_assert(str);
+
+	while ((token = strtok_r(tstart, ",", &tctx))) {
+		char *count, *speed;
+
+		tstart = NULL;
+
+		if (!strcmp(token, "default")) {
+			for (i = 0; i < ARRAY_SIZE(sim_classes); i++)
+				sim_add_engines(i, sim_classes[i].max, 1.0);
+			continue;
+		}
+
+		count = index(token, '=');
+		if (!count) {
+			ret = -1;
+			break;
+		}
+		*count++ = 0;
+
+		speed = index(count, '@');
+		if (speed)
+			*speed++ = 0;
+
+		for (i = 0; i < ARRAY_SIZE(sim_classes); i++) {
+			if (!strcasecmp(token, sim_classes[i].name))
+				break;
+		}
+
+		if (i == ARRAY_SIZE(sim_classes) ||
+		    sim_add_engines(i, atoi(count),
+				    speed ? atof(speed) : 1.0)) {
+			ret = -1;
+			break;
+		}
+	}
+
+	free(str);
+
+	if (ret || !sim_present_mask())
+		return -1;
+
+	engines = calloc(NUM_ENGINES, sizeof(*engines));
+	igt_assert(engines);
+
+	for (i = 0; i < ARRAY_SIZE(sim_classes); i++) {
+		for (j = 0; j < sim_classes[i].max; j++) {
+			if (!sim_engines[sim_classes[i].first + j].present)
+				continue;
+
+			engines[num].engine_class = sim_classes[i].class;
+			engines[num].engine_instance = j;
+			num++;
+		}
+	}
+
+	free(__engines);
+	__engines = engines;
+	__num_engines = num;
+	__engines_queried = true;
+
+	return 0;
+}
+
+static int sim_prepare_workload(unsigned int id, struct workload *wrk)
+{
+	struct w_step *w;
+	int i;
+
+	wrk->id = id;
+	wrk->bb_prng = (wrk->flags & SYNCEDCLIENTS) ? master_prng : rand();
+	wrk->bo_prng = (wrk->flags & SYNCEDCLIENTS) ? master_prng : rand();
+	wrk->run = true;
+
+	if (prepare_contexts(wrk))
+		return 1;
+
+	for (i = 0; i < wrk->nr_ctxs; i++)
+		wrk->ctx_list[i].priority = wrk->prio;
+
+	for (i = 0, w = wrk->steps; i < wrk->nr_steps; i++, w++) {
+		if (w->type == BATCH && !sim_siblings(wrk, w)) {
+			wsim_err("Step %u uses an engine which is not simulated!\n",
+				 i);
+			return 1;
+		}
+	}
+
+	prepare_working_sets(wrk);
+
+	return 0;
+}
+
+static void sim_submit(struct sim_client *c, struct w_step *w)
+{
+	struct workload *wrk = c->wrk;
+	struct sim_request *rq = sim_request_alloc(c);
+	struct sim_ref *timeline =
+		&c->timeline[w->context * NUM_ENGINES + w->engine];
+	unsigned int i;
+
+	rq->w = w;
+	rq->siblings = sim_siblings(wrk, w);
+	rq->prio = __get_ctx(wrk, w)->priority;
+	rq->duration = w->unbound_duration ?
+		       UINT64_MAX : 1000ull * get_duration(wrk, w);
+
+	sim_add_dep(rq, *timeline, false);
+	*timeline = sim_ref(rq);
+
+	sim_use_buffer(rq, c->bo[w->idx], true);
+
+	for (i = 0; i < w->data_deps.nr; i++) {
+		struct dep_entry *entry = &w->data_deps.list[i];
+
+		if (entry->working_set == -1) {
+			sim_use_buffer(rq, c->bo[w->idx + entry->target],
+				       false);
+		} else {
+			struct working_set *set =
+				wrk->working_sets[entry->working_set];
+
+			sim_use_buffer(rq, set->handles[entry->target],
+				       entry->write);
+		}
+	}
+
+	for (i = 0; i < w->fence_deps.nr; i++) {
+		int tgt = w->idx + w->fence_deps.list[i].target;
+
+		sim_add_dep(rq, c->rq[tgt], w->fence_deps.submit_fence);
+	}
+
+	/* Bonds are resolved once the master runs so keep those late. */
+	if (sim_scheduler->bind && !sim_bonded(c, w) &&
+	    __builtin_popcountll(rq->siblings) > 1)
+		rq->siblings = 1ull << sim_scheduler->bind(rq);
+
+	if (__builtin_popcountll(rq->siblings) == 1)
+		sim_engines[__builtin_ctzll(rq->siblings)].queued++;
+
+	c->rq[w->idx] = sim_ref(rq);
+	igt_list_add_tail(&rq->link, &sim_pending);
+}
+
+static void sim_start(struct sim_request *rq, enum intel_engine_id id)
+{
+	struct sim_engine *engine = &sim_engines[id];
+
+	igt_list_del(&rq->link);
+
+	if (__builtin_popcountll(rq->siblings) > 1)
+		engine->queued++;
+
+	rq->state = SIM_RUNNING;
+	rq->engine = id;
+	rq->start = sim_now;
+	if (rq->duration == UINT64_MAX)
+		rq->end = UINT64_MAX;
+	else
+		rq->end = sim_now + llround(rq->duration / engine->speed);
+
+	engine->rq = rq;
+	rq->client->ran_on[rq->w->idx] = id;
+}
+
+static void sim_complete(struct sim_engine *engine)
+{
+	struct sim_request *rq = engine->rq;
+
+	engine->busy += rq->end - rq->start;
+	engine->queued--;
+	engine->rq = NULL;
+
+	sim_request_retire(rq);
+}
+
+static bool sim_ready(struct sim_request *rq)
+{
+	while (rq->nr_deps) {
+		struct sim_dep *dep = &rq->deps[rq->nr_deps - 1];
+
+		if (dep->submit ? !sim_ref_started(dep->ref) :
+				  !sim_ref_done(dep->ref))
+			return false;
+
+		rq->nr_deps--;
+	}
+
+	return true;
+}
+
+static bool sim_dispatch(void)
+{
+	bool progress = false;
+	unsigned int i;
+
+	for (i = 0; i < NUM_ENGINES; i++) {
+		struct sim_request *rq, *best = NULL;
+		uint64_t bit = 1ull << i;
+
+		if (!sim_engines[i].present || sim_engines[i].rq)
+			continue;
+
+		igt_list_for_each_entry(rq, &sim_pending, link) {
+			if (!(rq->siblings & bit))
+				continue;
+
+			if (best && !sim_scheduler->before(rq, best))
+				continue;
+
+			if (sim_ready(rq) && (sim_bond_mask(rq) & bit))
+				best = rq;
+		}
+
+		if (best) {
+			sim_start(best, i);
+			progress = true;
+		}
+	}
+
+	return progress;
+}
+
+static void sim_terminate(struct sim_ref ref)
+{
+	struct sim_request *rq = ref.rq;
+
+	if (sim_ref_done(ref) || rq->duration != UINT64_MAX)
+		return;
+
+	rq->duration = 0;
+	if (rq->state == SIM_RUNNING)
+		rq->end = sim_now;
+}
+
+/* Signals the software fences up to and including step @last. */
+static void sim_signal_fences(struct sim_client *c, int last)
+{
+	int i;
+
+	for (i = 0; i <= last; i++) {
+		if (c->wrk->steps[i].type == SW_FENCE &&
+		    !sim_ref_done(c->rq[i]))
+			sim_request_retire(c->rq[i].rq);
+	}
+}
+
+static bool sim_wait(struct sim_client *c, struct sim_ref ref)
+{
+	if (sim_ref_done(ref))
+		return false;
+
+	c->wait = ref;
+	return true;
+}
+
+/* Like gem_sync(), waits for all readers and the writer of a buffer. */
+static bool sim_wait_buffer(struct sim_client *c, uint32_t handle)
+{
+	struct sim_buffer *b = &sim_buffers[handle];
+	unsigned int i;
+
+	if (sim_wait(c, b->write))
+		return true;
+
+	for (i = 0; i < b->nr_reads; i++) {
+		if (sim_wait(c, b->reads[i]))
+			return true;
+	}
+
+	return false;
+}
+
+/* Finds the batch w_sync_to() would wait for. */
+static int sim_sync_target(struct workload *wrk, int target)
+{
+	if (target < 0)
+		target = wrk->nr_steps + target;
+
+	while (wrk->steps[target].type != BATCH) {
+		if (--target < 0)
+			target = wrk->nr_steps + target;
+	}
+
+	return target;
+}
+
+/* Returns true when the client has to wait before completing the batch. */
+static bool sim_client_batch(struct sim_client *c, struct w_step *w)
+{
+	struct workload *wrk = c->wrk;
+	enum intel_engine_id engine = w->engine;
+	unsigned int i;
+
+	if (!c->submitted) {
+		if (wrk->flags & DEPSYNC) {
+			for (i = 0; i < w->data_deps.nr; i++) {
+				struct dep_entry *entry = &w->data_deps.list[i];
+
+				if (entry->working_set == -1 && entry->target &&
+				    sim_wait_buffer(c, c->bo[w->idx + entry->target]))
+					return true;
+			}
+		}
+
+		if (c->throttle > 0 &&
+		    sim_wait_buffer(c, c->bo[sim_sync_target(wrk, w->idx - c->throttle)]))
+			return true;
+
+		sim_submit(c, w);
+		c->submitted = true;
+
+		if (w->request != -1) {
+			igt_list_del(&w->rq_link);
+			wrk->nrequest[w->request]--;
+		}
+		w->request = engine;
+		igt_list_add_tail(&w->rq_link, &wrk->requests[engine]);
+		wrk->nrequest[engine]++;
+
+		if (!wrk->run) {
+			c->submitted = false;
+			return false;
+		}
+	}
+
+	if (w->sync && sim_wait_buffer(c, c->bo[w->idx]))
+		return true;
+
+	if (c->qd_throttle > 0) {
+		while (wrk->nrequest[engine] > c->qd_throttle) {
+			struct w_step *s;
+
+			s = igt_list_first_entry(&wrk->requests[engine],
+						 s, rq_link);
+
+			if (sim_wait_buffer(c, c->bo[s->idx]))
+				return true;
+
+			s->request = -1;
+			igt_list_del(&s->rq_link);
+			wrk->nrequest[engine]--;
+		}
+	}
+
+	c->submitted = false;
+
+	return false;
+}
+
+/* Returns true when the client has to wait before completing the step. */
+static bool sim_client_step(struct sim_client *c, struct w_step *w)
+{
+	struct workload *wrk = c->wrk;
+	int elapsed, do_sleep;
+
+	switch (w->type) {
+	case BATCH:
+		return sim_client_batch(c, w);
+	case DELAY:
+		c->wake = sim_now + 1000ull * w->delay;
+		break;
+	case PERIOD:
+		elapsed = (sim_now - c->repeat_start) / 1000;
+		do_sleep = w->period - elapsed;
+		c->time_tot += elapsed;
+		if (elapsed < c->time_min)
+			c->time_min = elapsed;
+		if (elapsed > c->time_max)
+			c->time_max = elapsed;
+		if (do_sleep < 0) {
+			c->missed++;
+			if (verbose > 2)
+				printf("%u: Dropped period @ %u/%u (%dus late)!\n",
+				       wrk->id, c->count, w->idx, do_sleep);
+		} else {
+			c->wake = sim_now + 1000ull * do_sleep;
+		}
+		break;
+	case SYNC:
+		return sim_wait_buffer(c, c->bo[w->idx + w->target]);
+	case THROTTLE:
+		c->throttle = w->throttle;
+		break;
+	case QD_THROTTLE:
+		c->qd_throttle = w->throttle;
+		break;
+	case SW_FENCE:
+		c->rq[w->idx] = sim_ref(sim_request_alloc(c));
+		break;
+	case SW_FENCE_SIGNAL:
+		sim_signal_fences(c, w->idx + w->target);
+		break;
+	case CTX_PRIORITY:
+		wrk->ctx_list[w->context].priority = w->priority;
+		break;
+	case TERMINATE:
+		sim_terminate(c->rq[w->idx + w->target]);
+		break;
+	default:
+		/* Nothing to model at execution time. */
+		break;
+	}
+
+	return false;
+}
+
+/* Like the end of run_workload(), waits for the last request per engine. */
+static bool sim_client_drain(struct sim_client *c)
+{
+	struct workload *wrk = c->wrk;
+	unsigned int i;
+
+	for (i = 0; i < NUM_ENGINES; i++) {
+		struct w_step *w;
+
+		if (!wrk->nrequest[i])
+			continue;
+
+		w = igt_list_last_entry(&wrk->requests[i], w, rq_link);
+		if (sim_wait_buffer(c, c->bo[w->idx]))
+			return true;
+	}
+
+	return false;
+}
+
+/* Runs a client until it blocks, returns whether anything changed. */
+static bool sim_client_run(struct sim_client *c)
+{
+	struct workload *wrk = c->wrk;
+	bool progress = false;
+	unsigned int i;
+
+	while (!c->finished && c->wake <= sim_now && sim_ref_done(c->wait)) {
+		progress = true;
+
+		if (c->draining) {
+			if (sim_client_drain(c))
+				continue;
+
+			c->finished = true;
+			c->end = sim_now;
+
+			if (c->master) {
+				for (i = 0; i < sim_nr_clients; i++)
+					sim_clients[i].wrk->run = false;
+			}
+		} else if (!c->iterating) {
+			if (wrk->run &&
+			    (wrk->background || c->count < wrk->repeat)) {
+				c->iterating = true;
+				c->step = 0;
+				c->repeat_start = sim_now;
+			} else {
+				c->draining = true;
+			}
+		} else if (!wrk->run || c->step == wrk->nr_steps) {
+			sim_signal_fences(c, wrk->nr_steps - 1);
+			c->iterating = false;
+			c->count++;
+		} else if (!sim_client_step(c, &wrk->steps[c->step])) {
+			c->step++;
+		}
+	}
+
+	return progress;
+}
+
+static void sim_client_init(struct sim_client *c, struct workload *wrk,
+			    bool master)
+{
+	unsigned int i;
+
+	c->wrk = wrk;
+	c->master = master;
+	c->throttle = -1;
+	c->qd_throttle = -1;
+	c->time_min = ULONG_MAX;
+
+	c->rq = calloc(wrk->nr_steps, sizeof(*c->rq));
+	c->bo = calloc(wrk->nr_steps, sizeof(*c->bo));
+	c->ran_on = calloc(wrk->nr_steps, sizeof(*c->ran_on));
+	c->timeline = calloc(wrk->nr_ctxs * NUM_ENGINES, sizeof(*c->timeline));
+	igt_assert(c->rq && c->bo && c->ran_on && c->timeline);
+
+	for (i = 0; i < wrk->nr_steps; i++) {
+		if (wrk->steps[i].type == BATCH)
+			c->bo[i] = sim_alloc_buffer();
+	}
+}
+
+static void sim_client_fini(struct sim_client *c)
+{
+	free(c->rq);
+	free(c->bo);
+	free(c->ran_on);
+	free(c->timeline);
+}
+
+static void sim_print_stats(struct sim_client *c)
+{
+	struct workload *wrk = c->wrk;
+	double t = c->end / 1e9;
+
+	printf("%c%u: %.3fs elapsed (%u cycles, %.3f workloads/s).",
+	       wrk->background ? ' ' : '*', wrk->id,
+	       t, c->count, c->count / t);
+	if (c->time_tot)
+		printf(" Time avg/min/max=%lu/%lu/%luus; %u missed.",
+		       c->time_tot / c->count, c->time_min, c->time_max,
+		       c->missed);
+	putchar('\n');
+}
+
+/*
+ * Runs all clients to completion in virtual time and returns the elapsed
+ * virtual time in seconds, or a negative value on deadlock.
+ */
+static double sim_run(struct workload **w, unsigned int clients, int master)
+{
+	uint64_t end = 0;
+	unsigned int i;
+	bool deadlock = false;
+
+	sim_clients = calloc(clients, sizeof(*sim_clients));
+	igt_assert(sim_clients);
+	sim_nr_clients = clients;
+
+	for (i = 0; i < clients; i++)
+		sim_client_init(&sim_clients[i], w[i], master == i);
+
+	for (;;) {
+		uint64_t next = UINT64_MAX;
+		bool progress, finished = true;
+
+		do {
+			progress = false;
+			for (i = 0; i < clients; i++)
+				progress |= sim_client_run(&sim_clients[i]);
+			progress |= sim_dispatch();
+		} while (progress);
+
+		for (i = 0; i < clients; i++) {
+			struct sim_client *c = &sim_clients[i];
+
+			if (c->finished)
+				continue;
+
+			finished = false;
+			if (c->wake > sim_now && c->wake < next)
+				next = c->wake;
+		}
+
+		if (finished)
+			break;
+
+		for (i = 0; i < NUM_ENGINES; i++) {
+			if (sim_engines[i].rq && sim_engines[i].rq->end < next)
+				next = sim_engines[i].rq->end;
+		}
+
+		if (next == UINT64_MAX) {
+			wsim_err("Simulation deadlocked at %.6fs!\n",
+				 sim_now / 1e9);
+			deadlock = true;
+			break;
+		}
+
+		sim_now = next;
+
+		for (i = 0; i < NUM_ENGINES; i++) {
+			if (sim_engines[i].rq && sim_engines[i].rq->end <= sim_now)
+				sim_complete(&sim_engines[i]);
+		}
+	}
+
+	for (i = 0; i < clients; i++) {
+		struct sim_client *c = &sim_clients[i];
+
+		if (!deadlock && c->wrk->print_stats)
+			sim_print_stats(c);
+
+		if (c->end > end)
+			end = c->end;
+
+		sim_client_fini(c);
+	}
+
+	if (!deadlock && verbose > 1) {
+		for (i = 0; i < NUM_ENGINES; i++) {
+			if (sim_engines[i].present)
+				printf("%s: %.1f%% busy\n", ring_str_map[i],
+				       end ? 100.0 * sim_engines[i].busy / end : 0);
+		}
+	}
+
+	free(sim_clients);
+	sim_clients = NULL;
+	sim_nr_clients = 0;
+
+	return deadlock ? -1 : end / 1e9;
+}
+
+static void print_overhead(struct workload **w, unsigned int clients)
+{
+	unsigned long submits = 0, late[LATENESS_BUCKETS] = { };
+	uint64_t submit_ns = 0, submit_max_ns = 0;
+	uint64_t late_ns = 0, late_max_ns = 0;
+	unsigned long sleeps = 0;
+	unsigned int missed = 0;
+	unsigned int i, j;
+
+	for (i = 0; i < clients; i++) {
+		struct overhead *o = &w[i]->overhead;
+
+		for (j = 0; j < w[i]->nr_steps; j++) {
+			struct w_step *s = &w[i]->steps[j];
+
+			if (!s->submits)
+				continue;
+
+			if (verbose > 1)
+				printf("%u.%u: %lu execbufs, avg/max=%.1f/%.1fus CPU time.\n",
+				       i, j, s->submits,
+				       s->submit_ns / s->submits / 1e3,
+				       s->submit_max_ns / 1e3);
+
+			submits += s->submits;
+			submit_ns += s->submit_ns;
+			if (s->submit_max_ns > submit_max_ns)
+				submit_max_ns = s->submit_max_ns;
+		}
+
+		missed += o->missed;
+		sleeps += o->sleeps;
+		late_ns += o->late_ns;
+		if (o->late_max_ns > late_max_ns)
+			late_max_ns = o->late_max_ns;
+		for (j = 0; j < LATENESS_BUCKETS; j++)
+			late[j] += o->late[j];
+	}
+
+	if (submits)
+		printf("Submission: %lu execbufs, avg/max=%.1f/%.1fus CPU time.\n",
+		       submits, submit_ns / submits / 1e3, submit_max_ns / 1e3);
+
+	if (missed)
+		printf("Missed periods: %u.\n", missed);
+
+	if (!sleeps)
+		return;
+
+	printf("Wakeups: %lu, late avg/max=%.1f/%.1fus.\n",
+	       sleeps, late_ns / sleeps / 1e3, late_max_ns / 1e3);
+
+	for (j = 0; j < LATENESS_BUCKETS; j++) {
+		if (!late[j])
+			continue;
+
+		if (j == 0)
+			printf("  <1us");
+		else if (j == LATENESS_BUCKETS - 1)
+			printf("  >=%uus", 1u << (j - 1));
+		else
+			printf("  %u-%uus", 1u << (j - 1), 1u << j);
+
+		printf(": %lu (%.1f%%)\n", late[j], 100.0 * late[j] / sleeps);
+	}
+}
+
+static int bind_cpu(pthread_attr_t *attr, int cpu)
+{
+	cpu_set_t mask;
+
+	if (cpu == -1)
+		return 0;
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+
+	return pthread_attr_setaffinity_np(attr, sizeof(mask), &mask);
+}
+
+/* Spreads clients round-robin over the CPUs we are allowed to run on. */
+static int client_cpu(unsigned int client)
+{
+	cpu_set_t mask;
+	int cpu, n;
+
+	if (sched_getaffinity(0, sizeof(mask), &mask))
+		return -1;
+
+	n = client % CPU_COUNT(&mask);
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &mask) && !n--)
+			return cpu;
+	}
+
+	return -1;
+}
+
+static void fini_workload(struct workload *wrk)
+{
+	free(wrk->steps);
+	free(wrk);
+}
+
+static void print_help(void)
+{
+	puts(
+"Usage: gem_wsim [OPTIONS]\n"
+"\n"
+"Runs a simulated workload on the GPU.\n"
+"Options:\n"
+"  -h                This text.\n"
+"  -q                Be quiet - do not output anything to stdout.\n"
+"  -I <n>            Initial randomness seed.\n"
+"  -p <n>            Context priority to use for the following workload on the\n"
+"                    command line.\n"
+"  -w <desc|path>    Filename or a workload descriptor.\n"
+"                    Can be given multiple times.\n"
+"  -W <desc|path>    Filename or a master workload descriptor.\n"
+"                    Only one master workload can be optinally specified in which\n"
+"                    case all other workloads become background ones and run as\n"
+"                    long as the master.\n"
+"  -a <desc|path>    Append a workload to all other workloads.\n"
+"  -r <n>            How many times to emit the workload.\n"
+"  -c <n>            Fork N clients emitting the workload simultaneously.\n"
+"  -s                Turn on small SSEU config for the next workload on the\n"
+"                    command line. Subsequent -s switches it off.\n"
+"  -S                Synchronize the sequence of random batch durations between\n"
+"                    clients.\n"
+"  -d                Sync between data dependencies in userspace.\n"
+"  -f <scale>        Scale factor for batch durations.\n"
+"  -F <scale>        Scale factor for delays.\n"
+"  -L                List GPUs.\n"
+"  -D <gpu>          One of the GPUs from -L.\n"
+"  -V <engines>      Simulate in virtual time on the given engines instead of\n"
+"                    running on the GPU. Engines are given as a list of\n"
+"                    <class>=<count>[@<speed>], eg. rcs=1,bcs=1,vcs=2@0.5,vecs=1,\n"
+"                    where the optional speed scales the throughput of a class.\n"
+"                    'default' adds one of each class and two vcs.\n"
+"  -b <scheduler>    Scheduler to simulate with: prio (default), fifo, rr or qd.\n"
+"  -P                Pin client threads to CPUs, round-robin.\n"
+"  -T <us>           Round wakeup deadlines up to a tick of this length so\n"
+"                    clients due in the same tick share a timer wakeup.\n"
+"  -O                Report driver overhead: CPU time spent submitting and a\n"
+"                    histogram of how late delays and periods woke up.\n"
+	);
+}
+
+static char *load_workload_descriptor(char *filename)
+{
+	struct stat sbuf;
+	char *buf;
+	int infd, ret, i;
+	ssize_t len;
+
+	ret = stat(filename, &sbuf);
+	if (ret || !S_ISREG(sbuf.st_mode))
+		return filename;
+
+	igt_assert(sbuf.st_size < 1024 * 1024); /* Just so. */
+	buf = malloc(sbuf.st_size);
+	igt_assert(buf);
+
+	infd = open(filename, O_RDONLY);
+	igt_assert(infd >= 0);
+	len = read(infd, buf, sbuf.st_size);
+	igt_assert(len == sbuf.st_size);
+	close(infd);
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] == '\n')
+			buf[i] = ',';
+	}
+
+	len--;
+	while (buf[len] == ',')
+		buf[len--] = 0;
+
+	return buf;
+}
+
+static struct w_arg *
+add_workload_arg(struct w_arg *w_args, unsigned int nr_args, char *w_arg,
+		 int prio, bool sseu)
+{
+	w_args = realloc(w_args, sizeof(*w_args) * nr_args);
+	igt_assert(w_args);
+	w_args[nr_args - 1] = (struct w_arg) { w_arg, NULL, prio, sseu };
+
+	return w_args;
+}
+
+static int open_device(char *device_arg)
 {
 	struct igt_device_card card = { };
+	char *drm_dev;
+	int ret, i915;
+
+	igt_devices_scan(false);
+
+	if (device_arg) {
+		ret = igt_device_card_match(device_arg, &card);
+		if (!ret) {
+			wsim_err("Requested device %s not found!\n",
+				 device_arg);
+			free(device_arg);
+			return -1;
+		}
+		free(device_arg);
+	} else {
+		ret = igt_device_find_first_i915_discrete_card(&card);
+		if (!ret)
+			ret = igt_device_find_integrated_card(&card);
+		if (!ret) {
+			wsim_err("No device filter specified and no i915 devices found!\n");
+			return -1;
+		}
+	}
+
+	if (strlen(card.card)) {
+		drm_dev = card.card;
+	} else if (strlen(card.render)) {
+		drm_dev = card.render;
+	} else {
+		wsim_err("Failed to detect device!\n");
+		return -1;
+	}
+
+	i915 = open(drm_dev, O_RDWR);
+	if (i915 < 0) {
+		wsim_err("Failed to open '%s'! (%s)\n",
+			 drm_dev, strerror(errno));
+		return -1;
+	}
+	if (verbose > 1)
+		printf("Using device %s\n", drm_dev);
+
+	return i915;
+}
+
+int main(int argc, char **argv)
+{
 	bool list_devices_arg = false;
+	bool pin_cpus = false;
 	unsigned int repeat = 1;
 	unsigned int clients = 1;
 	unsigned int flags = 0;
@@ -2562,13 +3874,36 @@ int main(int argc, char **argv)
 	int prio = 0;
 	double t;
 	int i, c, ret;
-	char *drm_dev;
 
 	master_prng = time(NULL);
 
 	while ((c = getopt(argc, argv,
-			   "LhqvsSdc:r:w:W:a:p:I:f:F:D:")) != -1) {
+			   "LhqvsSdc:r:w:W:a:p:I:f:F:D:V:b:PT:O")) != -1) {
 		switch (c) {
+		case 'V':
+			if (sim_parse_engines(optarg)) {
+				wsim_err("Invalid simulated engines '%s'!\n",
+					 optarg);
+				goto err;
+			}
+			simulate = true;
+			break;
+		case 'P':
+			pin_cpus = true;
+			break;
+		case 'T':
+			tick_ns = strtoull(optarg, NULL, 0) * 1000;
+			break;
+		case 'O':
+			overhead_report = true;
+			break;
+		case 'b':
+			sim_scheduler = sim_find_scheduler(optarg);
+			if (!sim_scheduler) {
+				wsim_err("Unknown scheduler '%s'!\n", optarg);
+				goto err;
+			}
+			break;
 		case 'L':
 			list_devices_arg = true;
 			break;
@@ -2635,54 +3970,28 @@ int main(int argc, char **argv)
 		}
 	}
 
-	igt_devices_scan(false);
-
 	if (list_devices_arg) {
 		struct igt_devices_print_format fmt = {
 			.type = IGT_PRINT_USER,
 			.option = IGT_PRINT_DRM,
 		};
 
+		igt_devices_scan(false);
 		igt_devices_print(&fmt);
 		return EXIT_SUCCESS;
 	}
 
-	if (device_arg) {
-		ret = igt_device_card_match(device_arg, &card);
-		if (!ret) {
-			wsim_err("Requested device %s not found!\n",
-				 device_arg);
-			free(device_arg);
-			return EXIT_FAILURE;
-		}
-		free(device_arg);
+	if (simulate) {
+		if (!sim_scheduler)
+			sim_scheduler = &sim_schedulers[0];
+		if (verbose > 1)
+			printf("Simulating with the %s scheduler.\n",
+			       sim_scheduler->name);
 	} else {
-		ret = igt_device_find_first_i915_discrete_card(&card);
-		if (!ret)
-			ret = igt_device_find_integrated_card(&card);
-		if (!ret) {
-			wsim_err("No device filter specified and no i915 devices found!\n");
+		fd = open_device(device_arg);
+		if (fd < 0)
 			return EXIT_FAILURE;
-		}
-	}
-
-	if (strlen(card.card)) {
-		drm_dev = card.card;
-	} else if (strlen(card.render)) {
-		drm_dev = card.render;
-	} else {
-		wsim_err("Failed to detect device!\n");
-		return EXIT_FAILURE;
-	}
-
-	fd = open(drm_dev, O_RDWR);
-	if (fd < 0) {
-		wsim_err("Failed to open '%s'! (%s)\n",
-			 drm_dev, strerror(errno));
-		return EXIT_FAILURE;
 	}
-	if (verbose > 1)
-		printf("Using device %s\n", drm_dev);
 
 	if (!nr_w_args) {
 		wsim_err("No workload descriptor(s)!\n");
@@ -2756,17 +4065,40 @@ int main(int argc, char **argv)
 		w[i]->background = master_workload >= 0 && i != master_workload;
 		w[i]->print_stats = verbose > 1 ||
 				    (verbose > 0 && master_workload == i);
+		w[i]->cpu = -1;
+		if (pin_cpus) {
+			w[i]->cpu = client_cpu(i);
+			if (w[i]->cpu < 0) {
+				wsim_err("Failed to pick a CPU for client %u!\n", i);
+				goto err;
+			}
+		}
 
-		if (prepare_workload(i, w[i])) {
+		if (simulate ? sim_prepare_workload(i, w[i]) :
+			       prepare_workload(i, w[i])) {
 			wsim_err("Failed to prepare workload %u!\n", i);
 			goto err;
 		}
 	}
 
+	if (simulate) {
+		t = sim_run(w, clients, master_workload);
+		if (t < 0)
+			goto err;
+		goto done;
+	}
+
 	clock_gettime(CLOCK_MONOTONIC, &t_start);
 
 	for (i = 0; i < clients; i++) {
-		ret = pthread_create(&w[i]->thread, NULL, run_workload, w[i]);
+		pthread_attr_t attr;
+
+		pthread_attr_init(&attr);
+		ret = bind_cpu(&attr, w[i]->cpu);
+		igt_assert_f(ret == 0, "Failed to pin client %u to CPU %d: %s\n",
+			     i, w[i]->cpu, strerror(ret));
+		ret = pthread_create(&w[i]->thread, &attr, run_workload, w[i]);
+		pthread_attr_destroy(&attr);
 		igt_assert_eq(ret, 0);
 	}
 
@@ -2788,6 +4120,10 @@ int main(int argc, char **argv)
 	clock_gettime(CLOCK_MONOTONIC, &t_end);
 
 	t = elapsed(&t_start, &t_end);
+
+	if (overhead_report)
+		print_overhead(w, clients);
+done:
 	if (verbose)
 		printf("%.3fs elapsed (%.3f workloads/s)\n",
 		       t, clients * repeat / t);
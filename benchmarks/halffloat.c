@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_halffloat.h"
+
+static const unsigned char swizzle_bgrx[] = { 2, 1, 0, 3 };
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+/* The igt_fb converters used to go row by row, and pixel by pixel to swizzle */
+static void rows_half_to_float(const uint16_t *h, float *f,
+			       unsigned int width, unsigned int height,
+			       const unsigned char *swz)
+{
+	unsigned int x, y;
+	float rgb[4];
+
+	for (y = 0; y < height; y++) {
+		if (!swz) {
+			igt_half_to_float(h, f, width * 4);
+		} else {
+			for (x = 0; x < width; x++) {
+				igt_half_to_float(h + x * 4, rgb, 4);
+				f[x * 4 + 0] = rgb[swz[0]];
+				f[x * 4 + 1] = rgb[swz[1]];
+				f[x * 4 + 2] = rgb[swz[2]];
+				f[x * 4 + 3] = rgb[swz[3]];
+			}
+		}
+
+		h += width * 4;
+		f += width * 4;
+	}
+}
+
+static void rows_float_to_half(const float *f, uint16_t *h,
+			       unsigned int width, unsigned int height,
+			       const unsigned char *swz)
+{
+	unsigned int x, y;
+	float rgb[4];
+
+	for (y = 0; y < height; y++) {
+		if (!swz) {
+			igt_float_to_half(f, h, width * 4);
+		} else {
+			for (x = 0; x < width; x++) {
+				rgb[0] = f[x * 4 + swz[0]];
+				rgb[1] = f[x * 4 + swz[1]];
+				rgb[2] = f[x * 4 + swz[2]];
+				rgb[3] = f[x * 4 + swz[3]];
+				igt_float_to_half(rgb, h + x * 4, 4);
+			}
+		}
+
+		h += width * 4;
+		f += width * 4;
+	}
+}
+
+static void run(unsigned int width, unsigned int height, int loops)
+{
+	size_t pixels = (size_t)width * height;
+	const unsigned char *swz;
+	struct timespec start, end;
+	uint16_t *h;
+	float *f;
+	size_t i;
+	int n, s;
+
+	f = malloc(pixels * 4 * sizeof(*f));
+	h = malloc(pixels * 4 * sizeof(*h));
+	igt_assert(f && h);
+
+	for (i = 0; i < pixels * 4; i++)
+		f[i] = (i % 1021) / 1020.0f;
+
+	for (s = 0; s < 2; s++) {
+		swz = s ? swizzle_bgrx : NULL;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (n = 0; n < loops; n++)
+			rows_float_to_half(f, h, width, height, swz);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("%ux%u %s f32->f16 rows: %8.3f ms\n", width, height,
+		       s ? "bgrx" : "rgbx", 1e3 * elapsed(&start, &end) / loops);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (n = 0; n < loops; n++)
+			igt_float_to_half_2d(f, width * 16, h, width * 8,
+					     width, height, swz);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("%ux%u %s f32->f16 2d:   %8.3f ms\n", width, height,
+		       s ? "bgrx" : "rgbx", 1e3 * elapsed(&start, &end) / loops);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (n = 0; n < loops; n++)
+			rows_half_to_float(h, f, width, height, swz);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("%ux%u %s f16->f32 rows: %8.3f ms\n", width, height,
+		       s ? "bgrx" : "rgbx", 1e3 * elapsed(&start, &end) / loops);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (n = 0; n < loops; n++)
+			igt_half_to_float_2d(h, width * 8, f, width * 16,
+					     width, height, swz);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("%ux%u %s f16->f32 2d:   %8.3f ms\n", width, height,
+		       s ? "bgrx" : "rgbx", 1e3 * elapsed(&start, &end) / loops);
+	}
+
+	free(h);
+	free(f);
+}
+
+int main(int argc, char **argv)
+{
+	int loops = 5;
+	int c;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	run(3840, 2160, loops);
+	run(7680, 4320, loops);
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "igt_aux.h"
+#include "igt_codec.h"
+#include "igt_core.h"
+#include "../tools/intel_error_blob.h"
+
+/*
+ * Decodes the buffers of a synthetic error state, deflated and ascii85
+ * encoded as i915 captures them, with intel_error_decode's worker pool at
+ * increasing thread counts:
+ *
+ *   intel_error_decode -b 256 -s 4096 -j 8
+ *
+ * The first line, with no threads, decodes each buffer as it is submitted
+ * as intel_error_decode used to.
+ */
+
+struct buffer {
+	uint32_t *data;
+	size_t count;
+	char *text;
+	size_t len;
+	bool inflate;
+};
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+/* One line, as i915_gpu_error.c prints it */
+static char *ascii85_encode(const uint32_t *in, size_t count, size_t *len)
+{
+	char *out = malloc(igt_ascii85_encode_bound(count) + 2);
+	size_t n;
+
+	igt_assert(out);
+
+	n = igt_ascii85_encode(in, count, out);
+	out[n++] = '\n';
+	out[n] = '\0';
+
+	*len = n;
+	return out;
+}
+
+/* Mostly empty space, commands and small operands, as batches are */
+static void fill(uint32_t *data, size_t count, unsigned int *seed)
+{
+	for (size_t i = 0; i < count; i++) {
+		unsigned int r = rand_r(seed) % 10;
+
+		if (r < 4)
+			data[i] = 0;
+		else if (r < 6)
+			data[i] = 0x7a000004;
+		else
+			data[i] = rand_r(seed) & 0xffff;
+	}
+}
+
+static void build(struct buffer *b, size_t count, bool inflate,
+		  unsigned int *seed)
+{
+	b->data = malloc(4 * count);
+	igt_assert(b->data);
+	b->count = count;
+	b->inflate = inflate;
+	fill(b->data, count, seed);
+
+	if (inflate) {
+		uLongf size = compressBound(4 * count);
+		uint32_t *z = calloc(1, size + 3);
+
+		igt_assert(z);
+		igt_assert(compress2((Bytef *)z, &size, (Bytef *)b->data,
+				     4 * count, Z_BEST_SPEED) == Z_OK);
+		b->text = ascii85_encode(z, DIV_ROUND_UP(size, 4), &b->len);
+		free(z);
+	} else {
+		b->text = ascii85_encode(b->data, count, &b->len);
+	}
+}
+
+static double run(struct buffer *buffers, int nbuffers,
+		  unsigned int nthreads, bool dump)
+{
+	struct error_blob_pool *pool = error_blob_pool_create(nthreads);
+	struct error_blob **blobs = calloc(nbuffers, sizeof(*blobs));
+	struct timespec start, end;
+
+	igt_assert(pool && blobs);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < nbuffers; i++)
+		blobs[i] = error_blob_submit(pool,
+					     buffers[i].text, buffers[i].len,
+					     buffers[i].inflate, dump);
+	for (int i = 0; i < nbuffers; i++)
+		error_blob_wait(pool, blobs[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (int i = 0; i < nbuffers; i++) {
+		igt_assert(blobs[i]);
+		igt_assert_eq(blobs[i]->count, buffers[i].count);
+		igt_assert(!memcmp(blobs[i]->data, buffers[i].data,
+				   4 * buffers[i].count));
+		igt_assert(!dump || blobs[i]->dump);
+		error_blob_free(blobs[i]);
+	}
+
+	error_blob_pool_destroy(pool);
+	free(blobs);
+
+	return elapsed(&start, &end);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int nbuffers = 128, size = 1024, reps = 3;
+	unsigned int seed = 0x1234;
+	struct buffer *buffers;
+	size_t text = 0, data = 0;
+	bool dump = false;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:s:j:r:d")) != -1) {
+		switch (c) {
+		case 'b':
+			nbuffers = max(atoi(optarg), 1);
+			break;
+		case 's':
+			size = max(atoi(optarg), 1);
+			break;
+		case 'j':
+			max_threads = atoi(optarg);
+			break;
+		case 'r':
+			reps = max(atoi(optarg), 1);
+			break;
+		case 'd':
+			dump = true;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-b buffers] [-s KiB per buffer] [-j max threads] [-r reps] [-d]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	buffers = calloc(nbuffers, sizeof(*buffers));
+	igt_assert(buffers);
+
+	/* One in five buffers is captured uncompressed, as '~' lines */
+	for (int i = 0; i < nbuffers; i++) {
+		build(&buffers[i], (size_t)size * 1024 / 4, i % 5 != 4, &seed);
+		text += buffers[i].len;
+		data += 4 * buffers[i].count;
+	}
+
+	printf("%d buffers, %.1f MiB of ascii85 decoding to %.1f MiB%s\n",
+	       nbuffers, text / 1048576., data / 1048576.,
+	       dump ? ", with dumps" : "");
+
+	for (unsigned int n = 0; n <= max_threads; n = n ? 2 * n : 1) {
+		double best = 0;
+
+		for (int r = 0; r < reps; r++) {
+			double t = run(buffers, nbuffers, n, dump);
+
+			if (!r || t < best)
+				best = t;
+		}
+
+		printf("  %2u threads: %8.1f ms, %8.1f MiB/s of ascii85\n",
+		       n, 1e3 * best, text / 1048576. / best);
+	}
+
+	for (int i = 0; i < nbuffers; i++) {
+		free(buffers[i].data);
+		free(buffers[i].text);
+	}
+	free(buffers);
+
+	return 0;
+}
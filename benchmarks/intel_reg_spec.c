@@ -0,0 +1,198 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "../tools/intel_reg_spec.h"
+
+/*
+ * Compares what each intel_reg invocation pays for its register spec,
+ * parsing the spec files and searching them linearly against mapping the
+ * precompiled database and looking registers up in its hash indices:
+ *
+ *   intel_reg_spec tools/registers/skylake
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+/* As set_reg_by_name() and set_reg_by_addr() in intel_reg search */
+static const struct reg *find_name(const struct reg *regs, ssize_t count,
+				   enum port_addr port, const char *name)
+{
+	for (ssize_t i = 0; i < count; i++)
+		if (regs[i].port_desc.port == port &&
+		    strcasecmp(regs[i].name, name) == 0)
+			return &regs[i];
+
+	return NULL;
+}
+
+static const struct reg *find_addr(const struct reg *regs, ssize_t count,
+				   enum port_addr port, uint32_t addr)
+{
+	for (ssize_t i = 0; i < count; i++)
+		if (regs[i].port_desc.port == port &&
+		    regs[i].addr + regs[i].mmio_offset == addr)
+			return &regs[i];
+
+	return NULL;
+}
+
+static void bench_startup(const char *spec, const char *db, int reps)
+{
+	struct timespec start, end;
+	double t[2];
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		struct reg *regs;
+		ssize_t count;
+
+		count = intel_reg_spec_file(&regs, spec);
+		igt_assert(count > 0);
+		intel_reg_spec_free(regs, count);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[0] = elapsed(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		struct reg_db *regdb = intel_reg_db_open(db);
+
+		igt_assert(regdb);
+		intel_reg_db_close(regdb);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[1] = elapsed(&start, &end);
+
+	printf("startup:\n");
+	printf("  spec:     %10.3f us\n", 1e6 * t[0] / reps);
+	printf("  database: %10.3f us\n", 1e6 * t[1] / reps);
+}
+
+static void bench_lookup(const char *db, const struct reg *regs,
+			 ssize_t count, int reps)
+{
+	struct reg_db *regdb = intel_reg_db_open(db);
+	unsigned int found[2] = {};
+	struct timespec start, end;
+	double t[2];
+
+	igt_assert(regdb);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		for (ssize_t i = 0; i < count; i++) {
+			const struct reg *reg = &regs[i];
+
+			found[0] += !!find_name(regs, count,
+						reg->port_desc.port, reg->name);
+			found[0] += !!find_addr(regs, count,
+						reg->port_desc.port,
+						reg->addr + reg->mmio_offset);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[0] = elapsed(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		for (ssize_t i = 0; i < count; i++) {
+			const struct reg *reg = &regs[i];
+			struct reg tmp;
+
+			found[1] += !intel_reg_db_find_name(regdb,
+							    reg->port_desc.port,
+							    reg->name, &tmp);
+			found[1] += !intel_reg_db_find_addr(regdb,
+							    reg->port_desc.port,
+							    reg->addr + reg->mmio_offset,
+							    &tmp);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[1] = elapsed(&start, &end);
+
+	igt_assert_eq(found[0], found[1]);
+
+	printf("lookup: %zd registers by name and address\n", count);
+	printf("  linear:   %10.3f us/lookup\n", 1e6 * t[0] / reps / count / 2);
+	printf("  hashed:   %10.3f us/lookup\n", 1e6 * t[1] / reps / count / 2);
+
+	intel_reg_db_close(regdb);
+}
+
+int main(int argc, char **argv)
+{
+	char db[] = "/tmp/intel_reg_spec.XXXXXX";
+	struct reg *regs;
+	ssize_t count;
+	int reps = 100;
+	int c, fd;
+
+	while ((c = getopt(argc, argv, "r:")) != -1) {
+		switch (c) {
+		case 'r':
+			reps = max(atoi(optarg), 1);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-r reps] spec\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		fprintf(stderr, "usage: %s [-r reps] spec\n", argv[0]);
+		return 1;
+	}
+
+	count = intel_reg_spec_file(&regs, argv[optind]);
+	igt_assert_f(count > 0, "Cannot read %s\n", argv[optind]);
+
+	fd = mkstemp(db);
+	igt_assert(fd >= 0);
+	close(fd);
+	igt_assert(intel_reg_db_write(db, regs, count, NULL, 0) == 0);
+
+	bench_startup(argv[optind], db, reps);
+	bench_lookup(db, regs, count, reps);
+
+	intel_reg_spec_free(regs, count);
+	unlink(db);
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "i915/gem_create.h"
+#include "i915/gem_mman.h"
+#include "igt_x86.h"
+#include "ioctl_wrappers.h"
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static void report(const char *mem, const char *dir, const char *name,
+		   void (*copy)(void *, const void *, unsigned long),
+		   void *dst, const void *src, unsigned long size, int loops)
+{
+	struct timespec start, end;
+	int n;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (n = 0; n < loops; n++)
+		copy(dst, src, size);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	printf("%s %s %-10s %7.3f GB/s\n", mem, dir, name,
+	       1e-9 * size * loops / elapsed(&start, &end));
+}
+
+static void run(const char *mem, void *wc, void *cpu, unsigned long size,
+		int loops)
+{
+	const struct igt_memcpy_wc_impl *impl;
+	unsigned features = igt_x86_features();
+
+	for (impl = igt_memcpy_from_wc_impls; impl->name; impl++) {
+		if ((impl->features & features) != impl->features)
+			continue;
+
+		report(mem, "from", impl->name, impl->copy,
+		       cpu, wc, size, loops);
+	}
+	report(mem, "from", "parallel", igt_memcpy_from_wc_parallel,
+	       cpu, wc, size, loops);
+
+	for (impl = igt_memcpy_to_wc_impls; impl->name; impl++) {
+		if ((impl->features & features) != impl->features)
+			continue;
+
+		report(mem, "to  ", impl->name, impl->copy,
+		       wc, cpu, size, loops);
+	}
+	report(mem, "to  ", "parallel", igt_memcpy_to_wc_parallel,
+	       wc, cpu, size, loops);
+}
+
+static void *map_wc(int fd, uint32_t handle, unsigned long size)
+{
+	void *ptr;
+
+	ptr = __gem_mmap_offset__wc(fd, handle, 0, size,
+				    PROT_READ | PROT_WRITE);
+	if (!ptr)
+		ptr = __gem_mmap__wc(fd, handle, 0, size,
+				     PROT_READ | PROT_WRITE);
+
+	return ptr;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long size = 64 << 20;
+	char features[1024];
+	int loops = 10;
+	void *src, *dst, *wc;
+	uint32_t handle;
+	int fd, c;
+
+	while ((c = getopt(argc, argv, "s:l:")) != -1) {
+		switch (c) {
+		case 's':
+			size = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	printf("%s, %lu bytes\n",
+	       igt_x86_features_to_string(igt_x86_features(), features), size);
+
+	src = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	dst = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	igt_assert(src != MAP_FAILED && dst != MAP_FAILED);
+	memset(src, 0x5a, size);
+	memset(dst, 0xa5, size);
+
+	run("anon", src, dst, size, loops);
+
+	fd = __drm_open_driver(DRIVER_INTEL);
+	if (fd >= 0) {
+		handle = gem_create(fd, size);
+		wc = map_wc(fd, handle, size);
+		if (wc) {
+			gem_set_domain(fd, handle,
+				       I915_GEM_DOMAIN_WC, I915_GEM_DOMAIN_WC);
+			run("wc  ", wc, dst, size, loops);
+			munmap(wc, size);
+		}
+		gem_close(fd, handle);
+		close(fd);
+	}
+
+	munmap(dst, size);
+	munmap(src, size);
+
+	return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_name_filter.h"
+#include "uwildmat/uwildmat.h"
+
+/*
+ * Compares matching test names one pattern at a time against a
+ * combined name filter, using CI blacklists as igt_runner exclude
+ * regexes and CI testlists both as names and as a --run-subtest list:
+ *
+ *   name_filter -b tests/intel-ci/blacklist.txt \
+ *               -l tests/intel-ci/fast-feedback.testlist
+ */
+
+struct strings {
+	char **v;
+	unsigned int count;
+};
+
+static void push(struct strings *s, char *str)
+{
+	s->v = realloc(s->v, (s->count + 1) * sizeof(*s->v));
+	igt_assert(s->v);
+	s->v[s->count++] = str;
+}
+
+/* Lines without comments and surrounding whitespace, like the runner */
+static void read_lines(const char *filename, struct strings *s)
+{
+	char *line = NULL;
+	size_t len = 0;
+	FILE *f;
+
+	f = fopen(filename, "r");
+	igt_assert_f(f, "Cannot open %s\n", filename);
+
+	while (getline(&line, &len, f) > 0) {
+		char *start = line, *end;
+
+		line[strcspn(line, "#\n")] = '\0';
+		while (isspace(*start))
+			start++;
+		end = start + strlen(start);
+		while (end > start && isspace(end[-1]))
+			*--end = '\0';
+
+		if (*start)
+			push(s, strdup(start));
+	}
+
+	free(line);
+	fclose(f);
+}
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static void bench_regex(struct strings *patterns, struct strings *names,
+			int reps)
+{
+	struct igt_name_filter *filter = igt_name_filter_create();
+	GRegex **regexes = calloc(patterns->count, sizeof(*regexes));
+	unsigned int matched[2] = {};
+	struct timespec start, end;
+	double t[2];
+
+	for (unsigned int i = 0; i < patterns->count; i++) {
+		regexes[i] = g_regex_new(patterns->v[i], G_REGEX_OPTIMIZE, 0, NULL);
+		igt_assert_f(regexes[i], "Invalid regex '%s'\n", patterns->v[i]);
+		igt_name_filter_add_regex(filter, patterns->v[i], regexes[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		for (unsigned int n = 0; n < names->count; n++) {
+			for (unsigned int i = 0; i < patterns->count; i++) {
+				if (g_regex_match(regexes[i], names->v[n], 0, NULL)) {
+					matched[0]++;
+					break;
+				}
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[0] = elapsed(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		for (unsigned int n = 0; n < names->count; n++)
+			matched[1] += igt_name_filter_match(filter, names->v[n]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[1] = elapsed(&start, &end);
+
+	igt_assert_eq(matched[0], matched[1]);
+
+	printf("regex:   %u patterns x %u names, %u matches\n",
+	       patterns->count, names->count, matched[0] / reps);
+	printf("  per pattern: %8.3f us/name\n", 1e6 * t[0] / reps / names->count);
+	printf("  filter:      %8.3f us/name\n", 1e6 * t[1] / reps / names->count);
+
+	igt_name_filter_destroy(filter);
+	for (unsigned int i = 0; i < patterns->count; i++)
+		g_regex_unref(regexes[i]);
+	free(regexes);
+}
+
+static void bench_wildmat(struct strings *names, int reps)
+{
+	struct igt_name_filter *filter = igt_name_filter_create();
+	struct strings subtests = {};
+	unsigned int matched[2] = {};
+	struct timespec start, end;
+	size_t len = 1;
+	double t[2];
+	char *expr;
+
+	/* What the runner passes to --run-subtest in multiple mode */
+	for (unsigned int n = 0; n < names->count; n++) {
+		char *subtest = strrchr(names->v[n], '@');
+
+		if (subtest && subtest != names->v[n] + 3) {
+			push(&subtests, subtest + 1);
+			len += strlen(subtest);
+		}
+	}
+
+	if (!subtests.count)
+		return;
+
+	expr = calloc(1, len);
+	for (unsigned int n = 0; n < subtests.count; n++) {
+		if (n)
+			strcat(expr, ",");
+		strcat(expr, subtests.v[n]);
+	}
+	igt_name_filter_add_wildmat(filter, expr);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		for (unsigned int n = 0; n < subtests.count; n++)
+			matched[0] += uwildmat(subtests.v[n], expr);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[0] = elapsed(&start, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < reps; r++) {
+		for (unsigned int n = 0; n < subtests.count; n++)
+			matched[1] += igt_name_filter_match(filter, subtests.v[n]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t[1] = elapsed(&start, &end);
+
+	igt_assert_eq(matched[0], matched[1]);
+
+	printf("wildmat: %u patterns x %u names\n",
+	       subtests.count, subtests.count);
+	printf("  uwildmat:    %8.3f us/name\n", 1e6 * t[0] / reps / subtests.count);
+	printf("  filter:      %8.3f us/name\n", 1e6 * t[1] / reps / subtests.count);
+
+	igt_name_filter_destroy(filter);
+	free(subtests.v);
+	free(expr);
+}
+
+int main(int argc, char **argv)
+{
+	struct strings patterns = {}, names = {};
+	int reps = 10;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:l:r:")) != -1) {
+		switch (c) {
+		case 'b':
+			read_lines(optarg, &patterns);
+			break;
+		case 'l':
+			read_lines(optarg, &names);
+			break;
+		case 'r':
+			reps = max(atoi(optarg), 1);
+			break;
+		default:
+			fprintf(stderr, "usage: %s -b blacklist... -l testlist... [-r reps]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	if (!names.count) {
+		fprintf(stderr, "No test names given\n");
+		return 1;
+	}
+
+	if (patterns.count)
+		bench_regex(&patterns, &names, reps);
+	bench_wildmat(&names, reps);
+
+	return 0;
+}
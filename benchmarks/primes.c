@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_primes.h"
+
+/*
+ * Enumeration of all the primes below 2^bits, with an iterator and by
+ * repeated calls to igt_next_prime_number():
+ *
+ *   primes -b 32
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+	struct igt_primes_iter *it;
+	struct timespec start, end;
+	unsigned long limit, count;
+	int bits = 32, c;
+
+	while ((c = getopt(argc, argv, "b:")) != -1) {
+		switch (c) {
+		case 'b':
+			bits = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (bits < 2)
+		bits = 2;
+	if (bits > 8 * sizeof(long) - 1)
+		bits = 8 * sizeof(long) - 1;
+	limit = 1ul << bits;
+
+	it = malloc(sizeof(*it));
+	igt_assert(it);
+
+	count = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for_each_prime_in_range(p, it, 0, limit)
+		count++;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("for_each_prime_in_range: %lu primes below 2^%d in %.3fs\n",
+	       count, bits, elapsed(&start, &end));
+
+	count = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long p = 2; p < limit; p = igt_next_prime_number(p))
+		count++;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("igt_next_prime_number:   %lu primes below 2^%d in %.3fs\n",
+	       count, bits, elapsed(&start, &end));
+
+	free(it);
+
+	return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "i915_drm.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "igt_ref.h"
+#include "igt_tiling.h"
+#include "intel_batchbuffer.h"
+
+/*
+ * Computing and checking the result of a render copy between two Y tiled
+ * surfaces, by converting them to linear around per-pixel loops as
+ * gem_render_copy used to, against the CPU reference renderer:
+ *
+ *   ref_render -w 16384 -h 16384 -l 3
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static void surface_init(struct igt_ref_surface *s, unsigned int width,
+			 unsigned int height, uint32_t seed)
+{
+	uint64_t size = (uint64_t)width * 4 * ALIGN(height, 32);
+	uint32_t *ptr = malloc(size);
+
+	igt_assert(ptr);
+	for (uint64_t i = 0; i < size / 4; i++)
+		ptr[i] = hars_petruska_f54_1_random(&seed);
+
+	*s = (struct igt_ref_surface) {
+		.ptr = ptr,
+		.tiling = igt_tiling_create_intel(I915_TILING_Y,
+						  I915_BIT_6_SWIZZLE_NONE,
+						  width * 4),
+		.stride = width * 4,
+		.cpp = 4,
+		.width = width,
+		.height = height,
+	};
+}
+
+static void to_linear(const struct igt_ref_surface *s, uint32_t *linear)
+{
+	igt_tiling_from_tiled(s->tiling, linear, s->stride, s->ptr,
+			      0, 0, s->stride, s->height);
+}
+
+static void from_linear(const struct igt_ref_surface *s, uint32_t *linear)
+{
+	igt_tiling_to_tiled(s->tiling, s->ptr, linear, s->stride,
+			    0, 0, s->stride, s->height);
+}
+
+/* The lower right quarter of src to the upper left of dst */
+static void copy_linear(struct igt_ref_surface *dst,
+			struct igt_ref_surface *src)
+{
+	unsigned int w = dst->width / 2, h = dst->height / 2;
+	uint64_t size = (uint64_t)dst->stride * dst->height;
+	uint32_t *linear_dst = malloc(size), *linear_src = malloc(size);
+
+	igt_assert(linear_dst && linear_src);
+	to_linear(src, linear_src);
+	to_linear(dst, linear_dst);
+
+	for (unsigned int y = 0; y < h; y++)
+		memcpy(&linear_dst[(uint64_t)y * dst->width],
+		       &linear_src[(uint64_t)(h + y) * src->width + w], w * 4);
+
+	from_linear(dst, linear_dst);
+	free(linear_src);
+	free(linear_dst);
+}
+
+static void copy_ref(struct igt_ref_surface *dst, struct igt_ref_surface *src)
+{
+	unsigned int w = dst->width / 2, h = dst->height / 2;
+
+	igt_ref_copy(dst, 0, 0, src, w, h, w, h);
+}
+
+static bool compare_linear(struct igt_ref_surface *a, struct igt_ref_surface *b)
+{
+	uint64_t size = (uint64_t)a->stride * a->height;
+	uint32_t *linear_a = malloc(size), *linear_b = malloc(size);
+	bool differ = false;
+
+	igt_assert(linear_a && linear_b);
+	to_linear(a, linear_a);
+	to_linear(b, linear_b);
+
+	for (uint64_t i = 0; i < size / 4 && !differ; i++)
+		differ = linear_a[i] != linear_b[i];
+
+	free(linear_b);
+	free(linear_a);
+
+	return differ;
+}
+
+static bool compare_ref(struct igt_ref_surface *a, struct igt_ref_surface *b)
+{
+	unsigned int x, y;
+
+	return igt_ref_compare(a, b, 0, 0, a->width, a->height, &x, &y);
+}
+
+static double run(void (*copy)(struct igt_ref_surface *dst,
+			       struct igt_ref_surface *src),
+		  bool (*compare)(struct igt_ref_surface *a,
+				  struct igt_ref_surface *b),
+		  struct igt_ref_surface *dst, struct igt_ref_surface *src,
+		  int loops)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++) {
+		if (copy)
+			copy(dst, src);
+		if (compare)
+			igt_assert(!compare(dst, src));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int width = 16384, height = 4096;
+	struct igt_ref_surface src, dst, ref;
+	int loops = 3;
+	int c;
+
+	while ((c = getopt(argc, argv, "w:h:l:")) != -1) {
+		switch (c) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'h':
+			height = atoi(optarg);
+			break;
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	/* Y tiles are 32 pixels wide */
+	width = ALIGN(width, 32);
+
+	surface_init(&src, width, height, 1);
+	surface_init(&dst, width, height, 2);
+	surface_init(&ref, width, height, 3);
+
+	printf("%ux%u, Y tiled, ms per operation:\n", width, height);
+	printf("  %-8s %10s %10s\n", "", "linear", "igt_ref");
+	printf("  %-8s %10.2f %10.2f\n", "copy",
+	       1e3 * run(copy_linear, NULL, &dst, &src, loops),
+	       1e3 * run(copy_ref, NULL, &dst, &src, loops));
+
+	/* Compared against a copy of itself, in full */
+	igt_ref_copy(&ref, 0, 0, &dst, 0, 0, width, height);
+	printf("  %-8s %10.2f %10.2f\n", "compare",
+	       1e3 * run(NULL, compare_linear, &dst, &ref, loops),
+	       1e3 * run(NULL, compare_ref, &dst, &ref, loops));
+
+	free(src.ptr);
+	free(dst.ptr);
+	free(ref.ptr);
+	igt_ref_surface_fini(&src);
+	igt_ref_surface_fini(&dst);
+	igt_ref_surface_fini(&ref);
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_sysfs.h"
+
+/*
+ * Sampling of the frequency attributes of a fake, tmpfs backed, sysfs
+ * directory, opened on every read against kept open and read with pread():
+ *
+ *   sysfs_attr -l 100000
+ */
+
+static const char *attrs[] = {
+	"gt_act_freq_mhz",
+	"gt_cur_freq_mhz",
+	"gt_min_freq_mhz",
+	"gt_max_freq_mhz",
+	"gt_boost_freq_mhz",
+	"power/rc6_residency_ms",
+};
+
+#define NUM_ATTRS (sizeof(attrs) / sizeof(attrs[0]))
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static void create_attr(int dir, const char *attr, int value)
+{
+	int fd = openat(dir, attr, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	igt_assert(fd >= 0);
+	igt_assert(dprintf(fd, "%d\n", value) > 0);
+	close(fd);
+}
+
+enum method {
+	SCANF,
+	GET_U64,
+	ATTR_GET_U64,
+	ATTR_SAMPLE,
+};
+
+static double sample(int dir, const int *fds, enum method method, int loops)
+{
+	struct timespec start, end;
+	uint64_t values[NUM_ATTRS];
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int n = 0; n < loops; n++) {
+		switch (method) {
+		case SCANF:
+			for (int i = 0; i < NUM_ATTRS; i++)
+				igt_sysfs_scanf(dir, attrs[i], "%"PRIu64, &values[i]);
+			break;
+		case GET_U64:
+			for (int i = 0; i < NUM_ATTRS; i++)
+				values[i] = igt_sysfs_get_u64(dir, attrs[i]);
+			break;
+		case ATTR_GET_U64:
+			for (int i = 0; i < NUM_ATTRS; i++)
+				values[i] = igt_sysfs_attr_get_u64(fds[i]);
+			break;
+		case ATTR_SAMPLE:
+			igt_sysfs_attr_sample(fds, NUM_ATTRS, values);
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end) / loops;
+}
+
+int main(int argc, char **argv)
+{
+	char path[] = "/tmp/sysfs_attr.XXXXXX";
+	char cmd[64];
+	int fds[NUM_ATTRS];
+	int loops = 10000;
+	int dir, c;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	igt_assert(mkdtemp(path));
+	dir = open(path, O_RDONLY | O_DIRECTORY);
+	igt_assert(dir >= 0);
+	igt_assert_eq(mkdirat(dir, "power", 0755), 0);
+
+	for (int i = 0; i < NUM_ATTRS; i++) {
+		create_attr(dir, attrs[i], 300 + 50 * i);
+
+		fds[i] = igt_sysfs_attr_open(dir, attrs[i]);
+		igt_assert(fds[i] >= 0);
+	}
+
+	printf("us per sample of %d attributes:\n", (int)NUM_ATTRS);
+	printf("  igt_sysfs_scanf        %8.3f\n", 1e6 * sample(dir, fds, SCANF, loops));
+	printf("  igt_sysfs_get_u64      %8.3f\n", 1e6 * sample(dir, fds, GET_U64, loops));
+	printf("  igt_sysfs_attr_get_u64 %8.3f\n", 1e6 * sample(dir, fds, ATTR_GET_U64, loops));
+	printf("  igt_sysfs_attr_sample  %8.3f\n", 1e6 * sample(dir, fds, ATTR_SAMPLE, loops));
+
+	for (int i = 0; i < NUM_ATTRS; i++)
+		close(fds[i]);
+	close(dir);
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", path);
+	igt_assert_eq(system(cmd), 0);
+
+	return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_amd.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_rand.h"
+#include "igt_tiling.h"
+
+/*
+ * Tiling and detiling of a 4k plane for each modifier igt_tiling handles,
+ * through its tables against computing the address of every pixel, as the
+ * igt_draw, igt_vc4 and igt_amd loops used to:
+ *
+ *   tiling -l 5
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static uint64_t tile(unsigned int x, unsigned int y,
+		     unsigned int x_tile_size, unsigned int y_tile_size,
+		     uint32_t line_size, bool xmajor)
+{
+	unsigned int tiles_per_line = line_size / x_tile_size;
+	uint64_t tile_n;
+
+	tile_n = (uint64_t)(y / y_tile_size) * tiles_per_line + x / x_tile_size;
+
+	if (xmajor)
+		return tile_n * x_tile_size * y_tile_size +
+			y % y_tile_size * x_tile_size + x % x_tile_size;
+	else
+		return tile_n * x_tile_size * y_tile_size +
+			x % x_tile_size * y_tile_size + y % y_tile_size;
+}
+
+static uint64_t pixel_x_tiled(const struct igt_fb *fb,
+			      unsigned int x, unsigned int y)
+{
+	return tile(x * fb->plane_bpp[0] / 8, y, 512, 8, fb->strides[0], true);
+}
+
+static uint64_t pixel_y_tiled(const struct igt_fb *fb,
+			      unsigned int x, unsigned int y)
+{
+	unsigned int byte_x = x * fb->plane_bpp[0] / 8;
+
+	return tile(byte_x / 16, y, 8, 32, fb->strides[0] / 16, false) * 16 +
+		byte_x % 16;
+}
+
+static uint64_t pixel_4_tiled(const struct igt_fb *fb,
+			      unsigned int x, unsigned int y)
+{
+	static const int subtile_map[] = {
+		0,  1,  2,  3,  8,  9, 10, 11,
+		4,  5,  6,  7, 12, 13, 14, 15,
+		16, 17, 18, 19, 24, 25, 26, 27,
+		20, 21, 22, 23, 28, 29, 30, 31,
+		32, 33, 34, 35, 40, 41, 42, 43,
+		36, 37, 38, 39, 44, 45, 46, 47,
+		48, 49, 50, 51, 56, 57, 58, 59,
+		52, 53, 54, 55, 60, 61, 62, 63
+	};
+	unsigned int byte_x = x * fb->plane_bpp[0] / 8;
+	unsigned int tile_x = byte_x % 128, tile_y = y % 32;
+
+	return (uint64_t)(y / 32) * fb->strides[0] * 32 + 4096 * (byte_x / 128) +
+		subtile_map[tile_y / 4 * 8 + tile_x / 16] * 64 +
+		tile_y % 4 * 16 + tile_x % 16;
+}
+
+static uint64_t pixel_vc4_t_tiled(const struct igt_fb *fb,
+				  unsigned int x, unsigned int y)
+{
+	static const unsigned int t1k_map_even[] = { 0, 3, 1, 2 };
+	static const unsigned int t1k_map_odd[] = { 2, 1, 3, 0 };
+	unsigned int cpp = fb->plane_bpp[0] / 8;
+	unsigned int t4k_t_w = 4096 / 32 / cpp;
+	unsigned int t1k_t_w = 1024 / 16 / cpp;
+	unsigned int t64_t_w = 64 / 4 / cpp;
+	unsigned int t4k_w = fb->strides[0] / cpp / t4k_t_w;
+	unsigned int t4k_x = x / t4k_t_w, t4k_y = y / 32;
+	unsigned int index = 2 * ((y % 32) / 16) + (x % t4k_t_w) / t1k_t_w;
+	uint64_t offset = (uint64_t)t4k_y * t4k_w * 4096;
+
+	if (t4k_y % 2)
+		offset += (t4k_w - t4k_x - 1) * 4096 +
+			t1k_map_odd[index] * 1024;
+	else
+		offset += t4k_x * 4096 + t1k_map_even[index] * 1024;
+
+	offset += ((y % 16) / 4 * (t1k_t_w / t64_t_w) +
+		   (x % t1k_t_w) / t64_t_w) * 64;
+
+	return offset + ((y % 4) * t64_t_w + x % t64_t_w) * cpp;
+}
+
+static uint64_t pixel_sand128(const struct igt_fb *fb,
+			      unsigned int x, unsigned int y)
+{
+	unsigned int column_height = fourcc_mod_broadcom_param(fb->modifier);
+
+	return (uint64_t)(x / 128) * 128 * column_height +
+		(128 * y + x % 128) * fb->plane_bpp[0] / 8;
+}
+
+static uint64_t pixel_amd_64k_s(const struct igt_fb *fb,
+				unsigned int x, unsigned int y)
+{
+	return igt_amd_fb_tiled_offset(fb->plane_bpp[0], x, y,
+				       fb->plane_width[0]);
+}
+
+static const struct {
+	const char *name;
+	uint64_t modifier;
+	unsigned int bpp;
+	uint32_t stride_align;
+	uint64_t (*offset)(const struct igt_fb *fb,
+			   unsigned int x, unsigned int y);
+} layouts[] = {
+	{ "x-tiled", I915_FORMAT_MOD_X_TILED, 32, 512, pixel_x_tiled },
+	{ "y-tiled", I915_FORMAT_MOD_Y_TILED, 32, 128, pixel_y_tiled },
+	{ "4-tiled", I915_FORMAT_MOD_4_TILED, 32, 128, pixel_4_tiled },
+	{ "vc4-t-tiled", DRM_FORMAT_MOD_BROADCOM_VC4_T_TILED, 32, 128,
+	  pixel_vc4_t_tiled },
+	{ "sand128", DRM_FORMAT_MOD_BROADCOM_SAND128_COL_HEIGHT(2176), 8, 128,
+	  pixel_sand128 },
+	{ "amd-64k-s", AMD_FMT_MOD |
+	  AMD_FMT_MOD_SET(TILE, AMD_FMT_MOD_TILE_GFX9_64K_S) |
+	  AMD_FMT_MOD_SET(TILE_VERSION, AMD_FMT_MOD_TILE_VER_GFX9), 32, 512,
+	  pixel_amd_64k_s },
+};
+
+#define WIDTH 3840
+#define HEIGHT 2160
+
+static void per_pixel(const struct igt_fb *fb,
+		      uint64_t (*offset)(const struct igt_fb *fb,
+					 unsigned int x, unsigned int y),
+		      uint8_t *tiled, uint8_t *linear, bool to_tiled)
+{
+	unsigned int cpp = fb->plane_bpp[0] / 8;
+
+	for (unsigned int y = 0; y < HEIGHT; y++) {
+		for (unsigned int x = 0; x < WIDTH; x++) {
+			uint8_t *t = tiled + offset(fb, x, y);
+			uint8_t *l = linear + (size_t)y * WIDTH * cpp + x * cpp;
+
+			switch (cpp) {
+			case 1:
+				if (to_tiled)
+					*t = *l;
+				else
+					*l = *t;
+				break;
+			case 4:
+				if (to_tiled)
+					*(uint32_t *)t = *(uint32_t *)l;
+				else
+					*(uint32_t *)l = *(uint32_t *)t;
+				break;
+			}
+		}
+	}
+}
+
+static void report(const char *name, double t, size_t size)
+{
+	printf("  %-14s %8.2f ms %8.1f MB/s\n", name, 1e3 * t, 1e-6 * size / t);
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t *linear, *tiled;
+	uint32_t seed = 0x1234;
+	size_t size;
+	int loops = 3;
+	int c;
+
+	while ((c = getopt(argc, argv, "l:")) != -1) {
+		switch (c) {
+		case 'l':
+			loops = atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	/* Generous for every layout, up to a full row of 64KiB AMD tiles */
+	size = (size_t)ALIGN(WIDTH * 4, 512) * ALIGN(HEIGHT, 128);
+	linear = malloc(size);
+	tiled = malloc(size);
+	igt_assert(linear && tiled);
+	for (size_t i = 0; i < size; i++)
+		linear[i] = hars_petruska_f54_1_random(&seed);
+	memset(tiled, 0, size);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(layouts); i++) {
+		unsigned int cpp = layouts[i].bpp / 8;
+		struct timespec start, end;
+		struct igt_tiling *t;
+		struct igt_fb fb = {
+			.modifier = layouts[i].modifier,
+			.width = WIDTH,
+			.height = HEIGHT,
+			.num_planes = 1,
+			.plane_bpp = { layouts[i].bpp },
+			.plane_width = { WIDTH },
+			.plane_height = { HEIGHT },
+			.strides = { ALIGN(WIDTH * cpp, layouts[i].stride_align) },
+		};
+		size_t bytes = (size_t)WIDTH * HEIGHT * cpp;
+
+		t = igt_tiling_create_fb(&fb, 0);
+		igt_assert(t);
+
+		printf("%s (%dx%d, %d bpp, %u byte chunks):\n", layouts[i].name,
+		       WIDTH, HEIGHT, layouts[i].bpp, igt_tiling_chunk_size(t));
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int n = 0; n < loops; n++)
+			per_pixel(&fb, layouts[i].offset, tiled, linear, true);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		report("per-pixel to", elapsed(&start, &end) / loops, bytes);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int n = 0; n < loops; n++)
+			igt_tiling_to_tiled(t, tiled, linear, WIDTH * cpp,
+					    0, 0, WIDTH * cpp, HEIGHT);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		report("tables to", elapsed(&start, &end) / loops, bytes);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int n = 0; n < loops; n++)
+			per_pixel(&fb, layouts[i].offset, tiled, linear, false);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		report("per-pixel from", elapsed(&start, &end) / loops, bytes);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int n = 0; n < loops; n++)
+			igt_tiling_from_tiled(t, linear, WIDTH * cpp, tiled,
+					      0, 0, WIDTH * cpp, HEIGHT);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		report("tables from", elapsed(&start, &end) / loops, bytes);
+
+		igt_tiling_destroy(t);
+	}
+
+	free(tiled);
+	free(linear);
+
+	return 0;
+}
@@ -26,6 +26,7 @@
 #include "igt_amd.h"
 #include "igt.h"
 #include "igt_sysfs.h"
+#include "igt_tiling.h"
 #include <amdgpu_drm.h>
 
 #define X0 1
@@ -203,32 +204,15 @@ uint32_t igt_amd_fb_tiled_offset(unsigned int bpp, unsigned int x_input,
 void igt_amd_fb_to_tiled(struct igt_fb *dst, void *dst_buf, struct igt_fb *src,
 				       void *src_buf, unsigned int plane)
 {
-	uint32_t src_offset, dst_offset;
+	struct igt_tiling *t = igt_tiling_create_fb(dst, plane);
 	unsigned int bpp = src->plane_bpp[plane];
-	unsigned int width = dst->plane_width[plane];
-	unsigned int height = dst->plane_height[plane];
-	unsigned int x, y;
-
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			src_offset = src->offsets[plane];
-			dst_offset = dst->offsets[plane];
-
-			src_offset += src->strides[plane] * y + x * bpp / 8;
-			dst_offset += igt_amd_fb_tiled_offset(bpp, x, y, width);
-
-			switch (bpp) {
-			case 16:
-				*(uint16_t *)(dst_buf + dst_offset) =
-					*(uint16_t *)(src_buf + src_offset);
-				break;
-			case 32:
-				*(uint32_t *)(dst_buf + dst_offset) =
-					*(uint32_t *)(src_buf + src_offset);
-				break;
-			}
-		}
-	}
+
+	igt_tiling_to_tiled(t, dst_buf + dst->offsets[plane],
+			    src_buf + src->offsets[plane], src->strides[plane],
+			    0, 0, dst->plane_width[plane] * bpp / 8,
+			    dst->plane_height[plane]);
+
+	igt_tiling_destroy(t);
 }
 
 void igt_amd_fb_convert_plane_to_tiled(struct igt_fb *dst, void *dst_buf,
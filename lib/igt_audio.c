@@ -33,6 +33,7 @@
 #include <unistd.h>
 
 #include "igt_audio.h"
+#include "igt_aux.h"
 #include "igt_core.h"
 
 #define FREQS_MAX 64
@@ -323,65 +324,27 @@ static double hann_window(double v, size_t i, size_t N)
 }
 
 /**
- * Checks that frequencies specified in signal, and only those, are included
- * in the input data.
+ * audio_signal_detect_bins:
  *
- * sampling_rate is given in Hz. samples_len is the number of elements in
- * samples.
+ * Checks that frequencies specified in signal, and only those, are present in
+ * the FFT bins' power. bin_power is normalized in-place, data_len is the number
+ * of samples the FFT was computed on.
  */
-bool audio_signal_detect(struct audio_signal *signal, int sampling_rate,
-			 int channel, const double *samples, size_t samples_len)
+static bool audio_signal_detect_bins(struct audio_signal *signal,
+				     int sampling_rate, int channel,
+				     double *bin_power, size_t bin_power_len,
+				     size_t data_len)
 {
-	double *data;
-	size_t data_len = samples_len;
-	size_t bin_power_len = data_len / 2 + 1;
-	double bin_power[bin_power_len];
 	bool detected[FREQS_MAX];
-	int ret, freq_accuracy, freq, local_max_freq;
+	int freq_accuracy, freq, local_max_freq;
 	double max, local_max, threshold;
 	size_t i, j;
 	bool above, success;
 
-	/* gsl will mutate the array in-place, so make a copy */
-	data = malloc(samples_len * sizeof(double));
-	memcpy(data, samples, samples_len * sizeof(double));
-
-	/* Apply a Hann window to the input signal, to reduce frequency leaks
-	 * due to the endpoints of the signal being discontinuous.
-	 *
-	 * For more info:
-	 * - https://download.ni.com/evaluation/pxi/Understanding%20FFTs%20and%20Windowing.pdf
-	 * - https://en.wikipedia.org/wiki/Window_function
-	 */
-	for (i = 0; i < data_len; i++)
-		data[i] = hann_window(data[i], i, data_len);
-
 	/* Allowed error in Hz due to FFT step */
 	freq_accuracy = sampling_rate / data_len;
 	igt_debug("Allowed freq. error: %d Hz\n", freq_accuracy);
 
-	ret = gsl_fft_real_radix2_transform(data, 1, data_len);
-	if (ret != 0) {
-		free(data);
-		igt_assert(0);
-	}
-
-	/* Compute the power received by every bin of the FFT.
-	 *
-	 * For i < data_len / 2, the real part of the i-th term is stored at
-	 * data[i] and its imaginary part is stored at data[data_len - i].
-	 * i = 0 and i = data_len / 2 are special cases, they are purely real
-	 * so their imaginary part isn't stored.
-	 *
-	 * The power is encoded as the magnitude of the complex number and the
-	 * phase is encoded as its angle.
-	 */
-	bin_power[0] = data[0];
-	for (i = 1; i < bin_power_len - 1; i++) {
-		bin_power[i] = hypot(data[i], data[data_len - i]);
-	}
-	bin_power[bin_power_len - 1] = data[data_len / 2];
-
 	/* Normalize the power */
 	for (i = 0; i < bin_power_len; i++)
 		bin_power[i] = 2 * bin_power[i] / data_len;
@@ -487,8 +450,326 @@ bool audio_signal_detect(struct audio_signal *signal, int sampling_rate,
 		}
 	}
 
+	return success;
+}
+
+/**
+ * Checks that frequencies specified in signal, and only those, are included
+ * in the input data.
+ *
+ * sampling_rate is given in Hz. samples_len is the number of elements in
+ * samples.
+ *
+ * This allocates and windows a fresh copy of the input on every call. Callers
+ * repeatedly analysing captured audio should use #audio_signal_detector
+ * instead.
+ */
+bool audio_signal_detect(struct audio_signal *signal, int sampling_rate,
+			 int channel, const double *samples, size_t samples_len)
+{
+	double *data;
+	size_t data_len = samples_len;
+	size_t bin_power_len = data_len / 2 + 1;
+	double bin_power[bin_power_len];
+	int ret;
+	size_t i;
+
+	/* gsl will mutate the array in-place, so make a copy */
+	data = malloc(samples_len * sizeof(double));
+	memcpy(data, samples, samples_len * sizeof(double));
+
+	/* Apply a Hann window to the input signal, to reduce frequency leaks
+	 * due to the endpoints of the signal being discontinuous.
+	 *
+	 * For more info:
+	 * - https://download.ni.com/evaluation/pxi/Understanding%20FFTs%20and%20Windowing.pdf
+	 * - https://en.wikipedia.org/wiki/Window_function
+	 */
+	for (i = 0; i < data_len; i++)
+		data[i] = hann_window(data[i], i, data_len);
+
+	ret = gsl_fft_real_radix2_transform(data, 1, data_len);
+	if (ret != 0) {
+		free(data);
+		igt_assert(0);
+	}
+
+	/* Compute the power received by every bin of the FFT.
+	 *
+	 * For i < data_len / 2, the real part of the i-th term is stored at
+	 * data[i] and its imaginary part is stored at data[data_len - i].
+	 * i = 0 and i = data_len / 2 are special cases, they are purely real
+	 * so their imaginary part isn't stored.
+	 *
+	 * The power is encoded as the magnitude of the complex number and the
+	 * phase is encoded as its angle.
+	 */
+	bin_power[0] = data[0];
+	for (i = 1; i < bin_power_len - 1; i++) {
+		bin_power[i] = hypot(data[i], data[data_len - i]);
+	}
+	bin_power[bin_power_len - 1] = data[data_len / 2];
+
 	free(data);
 
+	return audio_signal_detect_bins(signal, sampling_rate, channel,
+					bin_power, bin_power_len, data_len);
+}
+
+struct audio_signal_detector {
+	struct audio_signal *signal;
+	int sampling_rate;
+	int channels;
+
+	/* Number of samples per channel each detection works on, and the
+	 * number of new samples required between two detections. */
+	size_t len;
+	size_t hop;
+
+	/* Precomputed Hann window coefficients, len entries. */
+	double *window;
+
+	/* FFT twiddle factors and scratch space, shared by all channels. */
+	gsl_fft_real_wavetable *wavetable;
+	gsl_fft_real_workspace *workspace;
+
+	/* Per-channel ring of the last len samples, channels * len entries.
+	 * head is the index of the oldest sample. */
+	double *ring;
+	size_t head;
+	size_t filled;
+	size_t pending;
+
+	/* FFT input/output and bin power, len and len / 2 + 1 entries. */
+	double *data;
+	double *bin_power;
+};
+
+/**
+ * audio_signal_detector_init:
+ * @signal: The signal describing the expected frequencies
+ * @sampling_rate: The sampling rate of the analysed audio, in Hz
+ * @channels: The number of channels to analyse
+ * @samples_len: The number of samples per channel each detection works on
+ * @hop: The number of new samples per channel between two detections, at
+ * most @samples_len
+ *
+ * Allocate a detector that can be used to repeatedly check a stream of
+ * captured audio for the frequencies of @signal. The Hann window and the FFT
+ * tables are computed once here, instead of on every #audio_signal_detect
+ * call.
+ *
+ * Captured samples are queued with #audio_signal_detector_push_s32_le. Once
+ * @samples_len samples have been received, a detection is possible every @hop
+ * samples, on the last @samples_len samples. Setting @hop to @samples_len
+ * analyses consecutive, non-overlapping windows.
+ *
+ * Returns: A newly-allocated detector, to be freed with
+ * #audio_signal_detector_fini
+ */
+struct audio_signal_detector *
+audio_signal_detector_init(struct audio_signal *signal, int sampling_rate,
+			   int channels, size_t samples_len, size_t hop)
+{
+	struct audio_signal_detector *det;
+	size_t i;
+
+	igt_assert(channels > 0);
+	igt_assert(channels <= CHANNELS_MAX);
+	igt_assert(samples_len > 0);
+	igt_assert(hop > 0 && hop <= samples_len);
+
+	det = calloc(1, sizeof(*det));
+	igt_assert(det);
+
+	det->signal = signal;
+	det->sampling_rate = sampling_rate;
+	det->channels = channels;
+	det->len = samples_len;
+	det->hop = hop;
+
+	det->window = malloc(samples_len * sizeof(double));
+	for (i = 0; i < samples_len; i++)
+		det->window[i] = hann_window(1.0, i, samples_len);
+
+	det->wavetable = gsl_fft_real_wavetable_alloc(samples_len);
+	det->workspace = gsl_fft_real_workspace_alloc(samples_len);
+	igt_assert(det->wavetable && det->workspace);
+
+	det->ring = calloc(channels * samples_len, sizeof(double));
+	det->data = malloc(samples_len * sizeof(double));
+	det->bin_power = malloc((samples_len / 2 + 1) * sizeof(double));
+	igt_assert(det->ring && det->data && det->bin_power);
+
+	return det;
+}
+
+/**
+ * audio_signal_detector_fini:
+ * @det: The detector to release
+ *
+ * Release the detector. The signal it was created with is not freed.
+ */
+void audio_signal_detector_fini(struct audio_signal_detector *det)
+{
+	gsl_fft_real_workspace_free(det->workspace);
+	gsl_fft_real_wavetable_free(det->wavetable);
+	free(det->bin_power);
+	free(det->data);
+	free(det->ring);
+	free(det->window);
+	free(det);
+}
+
+/**
+ * audio_signal_detector_reset:
+ * @det: The target detector
+ *
+ * Drop all queued samples, e.g. after a discontinuity in the captured stream.
+ */
+void audio_signal_detector_reset(struct audio_signal_detector *det)
+{
+	det->head = 0;
+	det->filled = 0;
+	det->pending = 0;
+}
+
+/**
+ * audio_signal_detector_ready:
+ * @det: The target detector
+ *
+ * Returns: whether enough samples have been queued for a detection
+ */
+bool audio_signal_detector_ready(struct audio_signal_detector *det)
+{
+	return det->filled == det->len && det->pending >= det->hop;
+}
+
+/**
+ * audio_signal_detector_push_s32_le:
+ * @det: The target detector
+ * @src: Interleaved S32_LE captured samples
+ * @src_len: The number of elements in @src
+ * @src_channels: The number of interleaved channels in @src
+ * @channel_map: For each of the detector's channels, the index of the
+ * matching channel in @src, or NULL for an identity mapping
+ *
+ * Extract, normalize and queue captured samples, for all channels at once.
+ *
+ * Samples are only consumed until the detector becomes ready, so that no
+ * window is skipped: the caller is expected to run
+ * #audio_signal_detector_detect and push the remainder.
+ *
+ * Returns: the number of elements of @src consumed
+ */
+size_t audio_signal_detector_push_s32_le(struct audio_signal_detector *det,
+					 const int32_t *src, size_t src_len,
+					 int src_channels,
+					 const int *channel_map)
+{
+	size_t frames, n, count, pos, i;
+	const int32_t *s;
+	double *ring;
+	int c, src_chan;
+
+	igt_assert(src_len % src_channels == 0);
+	frames = src_len / src_channels;
+
+	n = 0;
+	while (n < frames && !audio_signal_detector_ready(det)) {
+		/* Write contiguously, up to the end of the ring or up to the
+		 * point where a detection is due, whichever comes first. */
+		if (det->filled < det->len) {
+			pos = det->filled;
+			count = det->len - det->filled;
+		} else {
+			pos = det->head;
+			count = min(det->len - det->head,
+				    det->hop - det->pending);
+		}
+		count = min(count, frames - n);
+
+		for (c = 0; c < det->channels; c++) {
+			src_chan = channel_map ? channel_map[c] : c;
+			igt_assert(src_chan >= 0 && src_chan < src_channels);
+
+			ring = &det->ring[c * det->len + pos];
+			s = &src[n * src_channels + src_chan];
+			for (i = 0; i < count; i++)
+				ring[i] = (double) s[i * src_channels] / INT32_MAX;
+		}
+
+		if (det->filled < det->len)
+			det->filled += count;
+		else
+			det->head = (det->head + count) % det->len;
+		det->pending += count;
+		n += count;
+	}
+
+	return n * src_channels;
+}
+
+/**
+ * audio_signal_detector_detect:
+ * @det: The target detector
+ * @detected: If non-NULL, an array of the detector's number of channels
+ * entries, set to whether the signal was detected on each channel
+ *
+ * Check the last queued samples of every channel for the frequencies of the
+ * detector's signal. The detector must be ready, see
+ * #audio_signal_detector_ready.
+ *
+ * Returns: true if the signal was detected on all channels
+ */
+bool audio_signal_detector_detect(struct audio_signal_detector *det,
+				  bool *detected)
+{
+	size_t len = det->len;
+	size_t bin_power_len = len / 2 + 1;
+	size_t tail = len - det->head;
+	double *data = det->data;
+	double *bin_power = det->bin_power;
+	const double *ring;
+	bool ok, success = true;
+	int c, ret;
+	size_t i;
+
+	igt_assert(audio_signal_detector_ready(det));
+
+	for (c = 0; c < det->channels; c++) {
+		ring = &det->ring[c * len];
+
+		/* Unroll the ring and apply the window in the same pass */
+		for (i = 0; i < tail; i++)
+			data[i] = ring[det->head + i] * det->window[i];
+		for (i = tail; i < len; i++)
+			data[i] = ring[i - tail] * det->window[i];
+
+		ret = gsl_fft_real_transform(data, 1, len, det->wavetable,
+					     det->workspace);
+		igt_assert(ret == 0);
+
+		/* The mixed-radix transform stores its result in half-complex
+		 * form: the real and imaginary parts of the i-th term are
+		 * stored at data[2 * i - 1] and data[2 * i], except for the
+		 * purely real i = 0 and (for even lengths) i = len / 2 terms.
+		 */
+		bin_power[0] = data[0];
+		for (i = 1; i < (len + 1) / 2; i++)
+			bin_power[i] = hypot(data[2 * i - 1], data[2 * i]);
+		if (len % 2 == 0)
+			bin_power[len / 2] = data[len - 1];
+
+		ok = audio_signal_detect_bins(det->signal, det->sampling_rate,
+					      c, bin_power, bin_power_len, len);
+		if (detected)
+			detected[c] = ok;
+		success &= ok;
+	}
+
+	det->pending = 0;
+
 	return success;
 }
 
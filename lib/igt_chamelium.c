@@ -38,6 +38,8 @@
 #include <cairo.h>
 
 #include "igt_chamelium.h"
+#include "igt_chamelium_crc.h"
+#include "igt_chamelium_stream.h"
 #include "igt_core.h"
 #include "igt_aux.h"
 #include "igt_edid.h"
@@ -124,6 +126,10 @@ struct chamelium {
 	/* Indicates the last port to have been used for capturing video */
 	struct chamelium_port *capturing_port;
 
+	/* Binary transfer of frames and CRCs, when the stream server has it */
+	struct chamelium_stream *stream;
+	bool stream_probed;
+
 	int drm_fd;
 
 	struct igt_list_head edids;
@@ -1290,6 +1296,77 @@ static void chamelium_get_captured_resolution(struct chamelium *chamelium,
 	xmlrpc_DECREF(res);
 }
 
+static struct chamelium_stream *chamelium_capture_stream(struct chamelium *chamelium)
+{
+	if (chamelium->stream_probed)
+		return chamelium->stream;
+
+	chamelium->stream_probed = true;
+	chamelium->stream = chamelium_stream_init_host(NULL, 0);
+	if (chamelium->stream &&
+	    !chamelium_stream_supports_capture(chamelium->stream)) {
+		chamelium_stream_deinit(chamelium->stream);
+		chamelium->stream = NULL;
+	}
+
+	igt_debug("Receiving frames and CRCs through %s\n",
+		  chamelium->stream ? "the stream server" : "XML-RPC");
+
+	return chamelium->stream;
+}
+
+/*
+ * After a failed transfer the stream may be out of sync, so XML-RPC is used
+ * from then on.
+ */
+static void chamelium_drop_stream(struct chamelium *chamelium)
+{
+	igt_debug("Falling back to XML-RPC for frames and CRCs\n");
+
+	chamelium_stream_deinit(chamelium->stream);
+	chamelium->stream = NULL;
+}
+
+/*
+ * Receives the captured frame @index, or with a negative @index the frame
+ * currently displayed on @port cropped to @x, @y, @w, @h, straight into the
+ * frame dump.
+ */
+static struct chamelium_frame_dump *frame_from_stream(struct chamelium *chamelium,
+						      struct chamelium_port *port,
+						      int index, int x, int y,
+						      int w, int h)
+{
+	struct chamelium_stream *stream = chamelium_capture_stream(chamelium);
+	struct chamelium_frame_dump *ret;
+	bool ok;
+
+	if (!stream)
+		return NULL;
+
+	ret = calloc(1, sizeof(*ret));
+	igt_assert(ret);
+
+	if (index < 0)
+		ok = chamelium_stream_dump_pixels(stream, port->id, x, y, w, h,
+						  &ret->bgr, &ret->size,
+						  &ret->width, &ret->height);
+	else
+		ok = chamelium_stream_read_captured_frame(stream, index,
+							  &ret->bgr, &ret->size,
+							  &ret->width,
+							  &ret->height);
+	if (!ok) {
+		chamelium_drop_stream(chamelium);
+		free(ret->bgr);
+		free(ret);
+		return NULL;
+	}
+
+	ret->port = port;
+	return ret;
+}
+
 static struct chamelium_frame_dump *frame_from_xml(struct chamelium *chamelium,
 						   xmlrpc_value *frame_xml)
 {
@@ -1341,10 +1418,15 @@ struct chamelium_frame_dump *chamelium_port_dump_pixels(struct chamelium *chamel
 	xmlrpc_value *res;
 	struct chamelium_frame_dump *frame;
 
+	chamelium->capturing_port = port;
+
+	frame = frame_from_stream(chamelium, port, -1, x, y, w, h);
+	if (frame)
+		return frame;
+
 	res = chamelium_rpc(chamelium, port, "DumpPixels",
 			    (w && h) ? "(iiiii)" : "(innnn)",
 			    port->id, x, y, w, h);
-	chamelium->capturing_port = port;
 
 	frame = frame_from_xml(chamelium, res);
 	xmlrpc_DECREF(res);
@@ -1508,10 +1590,19 @@ void chamelium_capture(struct chamelium *chamelium, struct chamelium_port *port,
 igt_crc_t *chamelium_read_captured_crcs(struct chamelium *chamelium,
 					int *frame_count)
 {
+	struct chamelium_stream *stream = chamelium_capture_stream(chamelium);
 	igt_crc_t *ret;
 	xmlrpc_value *res, *elem;
 	int i;
 
+	if (stream) {
+		ret = chamelium_stream_read_captured_crcs(stream, frame_count);
+		if (ret)
+			return ret;
+
+		chamelium_drop_stream(chamelium);
+	}
+
 	res = chamelium_rpc(chamelium, NULL, "GetCapturedChecksums", "(in)", 0);
 
 	*frame_count = xmlrpc_array_size(&chamelium->env, res);
@@ -1548,6 +1639,11 @@ struct chamelium_frame_dump *chamelium_read_captured_frame(struct chamelium *cha
 	xmlrpc_value *res;
 	struct chamelium_frame_dump *frame;
 
+	frame = frame_from_stream(chamelium, chamelium->capturing_port,
+				  index, 0, 0, 0, 0);
+	if (frame)
+		return frame;
+
 	res = chamelium_rpc(chamelium, NULL, "ReadCapturedFrame", "(i)", index);
 	frame = frame_from_xml(chamelium, res);
 	xmlrpc_DECREF(res);
@@ -2189,54 +2285,18 @@ int chamelium_get_frame_limit(struct chamelium *chamelium,
 	return ret;
 }
 
-static uint32_t chamelium_xrgb_hash16(const unsigned char *buffer, int width,
-				      int height, int k, int m)
-{
-	unsigned char r, g, b;
-	uint64_t sum = 0;
-	uint64_t count = 0;
-	uint64_t value;
-	uint32_t hash;
-	int index;
-	int i;
-
-	for (i=0; i < width * height; i++) {
-		if ((i % m) != k)
-			continue;
-
-		index = i * 4;
-
-		r = buffer[index + 2];
-		g = buffer[index + 1];
-		b = buffer[index + 0];
-
-		value = r | (g << 8) | (b << 16);
-		sum += ++count * value;
-	}
-
-	hash = ((sum >> 0) ^ (sum >> 16) ^ (sum >> 32) ^ (sum >> 48)) & 0xffff;
-
-	return hash;
-}
-
 static void chamelium_do_calculate_fb_crc(cairo_surface_t *fb_surface,
 					  igt_crc_t *out)
 {
 	unsigned char *buffer;
-	int n = 4;
 	int w, h;
-	int i, j;
 
 	buffer = cairo_image_surface_get_data(fb_surface);
 	w = cairo_image_surface_get_width(fb_surface);
 	h = cairo_image_surface_get_height(fb_surface);
 
-	for (i = 0; i < n; i++) {
-		j = n - i - 1;
-		out->crc[i] = chamelium_xrgb_hash16(buffer, w, h, j, n);
-	}
-
-	out->n_words = n;
+	igt_chamelium_xrgb_crc_parallel(buffer, (size_t)w * h, out->crc);
+	out->n_words = IGT_CHAMELIUM_CRC_WORDS;
 }
 
 /**
@@ -2802,6 +2862,8 @@ static void chamelium_exit_handler(int sig)
  */
 void chamelium_deinit_rpc_only(struct chamelium *chamelium)
 {
+	if (chamelium->stream)
+		chamelium_stream_deinit(chamelium->stream);
 	xmlrpc_env_clean(&chamelium->env);
 	free(chamelium);
 }
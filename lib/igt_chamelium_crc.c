@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_chamelium_crc.h"
+#include "igt_core.h"
+#include "igt_thread.h"
+#include "igt_x86.h"
+
+/**
+ * SECTION:igt_chamelium_crc
+ * @short_description: CPU computation of the Chamelium frame CRC
+ * @title: Chamelium CRC
+ * @include: igt_chamelium_crc.h
+ *
+ * The Chamelium reports four 16 bit hashes per frame, one for each pixel
+ * index modulo 4. Each hash folds the sum over its pixels of the 24 bit RGB
+ * value weighted by the position of the pixel in its lane, starting at 1,
+ * wrapping at 64 bits.
+ *
+ * The functions here compute the four hashes in a single pass over an
+ * XRGB8888 frame, so that reference CRCs can be computed for a framebuffer
+ * without the Chamelium dependencies.
+ */
+
+/*
+ * Per lane sums over a run of pixels starting on a multiple of 4: the plain
+ * sum of the values, and the sum weighted by their position in the run.
+ * A run starting at group q0 of the frame contributes q0 * sum + weighted
+ * to the frame's weighted sum, which lets runs be hashed independently.
+ */
+struct xrgb_sums {
+	uint64_t sum[IGT_CHAMELIUM_CRC_WORDS];
+	uint64_t weighted[IGT_CHAMELIUM_CRC_WORDS];
+};
+
+static inline uint32_t xrgb_value(uint32_t pixel)
+{
+	return (pixel >> 16 & 0xff) | (pixel & 0xff00) | (pixel & 0xff) << 16;
+}
+
+/* Accumulates pixels whose first one is in group q of the run */
+static void xrgb_sums_scalar(const uint32_t *pixels, size_t count, size_t q,
+			     struct xrgb_sums *s)
+{
+	size_t i, k;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		q++;
+		for (k = 0; k < 4; k++) {
+			uint64_t v = xrgb_value(pixels[i + k]);
+
+			s->sum[k] += v;
+			s->weighted[k] += q * v;
+		}
+	}
+
+	q++;
+	for (k = 0; i + k < count; k++) {
+		uint64_t v = xrgb_value(pixels[i + k]);
+
+		s->sum[k] += v;
+		s->weighted[k] += q * v;
+	}
+}
+
+#if defined(__x86_64__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+
+/*
+ * Two groups of 4 pixels per step, one per 128 bit half, widened into the
+ * four 64 bit lanes. Rather than multiplying by the weights, the running sum
+ * of the prefix sums is kept: after n groups, sum[k] * (n + 1) - prefix[k]
+ * is the weighted sum of lane k.
+ */
+static void xrgb_sums_avx2(const uint32_t *pixels, size_t count,
+			   struct xrgb_sums *s)
+{
+	const __m256i rgb = _mm256_setr_epi8(2, 1, 0, -1, 6, 5, 4, -1,
+					     10, 9, 8, -1, 14, 13, 12, -1,
+					     2, 1, 0, -1, 6, 5, 4, -1,
+					     10, 9, 8, -1, 14, 13, 12, -1);
+	__m256i sum = _mm256_setzero_si256();
+	__m256i prefix = _mm256_setzero_si256();
+	uint64_t sums[4], prefixes[4];
+	size_t i, n;
+
+	for (i = 0; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(pixels + i));
+
+		v = _mm256_shuffle_epi8(v, rgb);
+
+		sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+		prefix = _mm256_add_epi64(prefix, sum);
+		sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+		prefix = _mm256_add_epi64(prefix, sum);
+	}
+
+	_mm256_storeu_si256((__m256i *)sums, sum);
+	_mm256_storeu_si256((__m256i *)prefixes, prefix);
+	_mm256_zeroupper();
+
+	n = i / 4;
+	for (int k = 0; k < 4; k++) {
+		s->sum[k] += sums[k];
+		s->weighted[k] += sums[k] * (n + 1) - prefixes[k];
+	}
+
+	xrgb_sums_scalar(pixels + i, count - i, n, s);
+}
+
+#pragma GCC pop_options
+
+static bool xrgb_avx2_supported(void)
+{
+	return igt_x86_features() & AVX2;
+}
+#endif
+
+static void xrgb_sums_portable(const uint32_t *pixels, size_t count,
+			       struct xrgb_sums *s)
+{
+	xrgb_sums_scalar(pixels, count, 0, s);
+}
+
+static bool xrgb_always_supported(void)
+{
+	return true;
+}
+
+static void xrgb_crc(const struct xrgb_sums *s,
+		     uint32_t crc[IGT_CHAMELIUM_CRC_WORDS])
+{
+	/* The Chamelium reports the last lane first */
+	for (int i = 0; i < IGT_CHAMELIUM_CRC_WORDS; i++) {
+		uint64_t sum = s->weighted[IGT_CHAMELIUM_CRC_WORDS - 1 - i];
+
+		crc[i] = (sum ^ sum >> 16 ^ sum >> 32 ^ sum >> 48) & 0xffff;
+	}
+}
+
+#define XRGB_CRC(impl) \
+static void xrgb_crc_##impl(const void *pixels, size_t count, \
+			    uint32_t crc[IGT_CHAMELIUM_CRC_WORDS]) \
+{ \
+	struct xrgb_sums s = {}; \
+\
+	xrgb_sums_##impl(pixels, count, &s); \
+	xrgb_crc(&s, crc); \
+}
+
+XRGB_CRC(portable)
+#if defined(__x86_64__) && !defined(__clang__)
+XRGB_CRC(avx2)
+#endif
+
+const struct igt_chamelium_crc_impl igt_chamelium_crc_impls[] = {
+	{ "scalar", xrgb_crc_portable, xrgb_always_supported },
+#if defined(__x86_64__) && !defined(__clang__)
+	{ "avx2", xrgb_crc_avx2, xrgb_avx2_supported },
+#endif
+	{ }
+};
+
+typedef void (*xrgb_sums_fn)(const uint32_t *, size_t, struct xrgb_sums *);
+
+#if defined(__x86_64__) && !defined(__clang__)
+static xrgb_sums_fn resolve_xrgb_sums(void)
+{
+	if (xrgb_avx2_supported())
+		return xrgb_sums_avx2;
+
+	return xrgb_sums_portable;
+}
+
+static void xrgb_sums(const uint32_t *pixels, size_t count,
+		      struct xrgb_sums *s)
+	__attribute__((ifunc("resolve_xrgb_sums")));
+#else
+static void xrgb_sums(const uint32_t *pixels, size_t count,
+		      struct xrgb_sums *s)
+{
+	xrgb_sums_portable(pixels, count, s);
+}
+#endif
+
+/**
+ * igt_chamelium_xrgb_crc:
+ * @pixels: XRGB8888 pixels, with no padding between the lines
+ * @count: number of pixels
+ * @crc: the CRC words, in the order the Chamelium reports them
+ *
+ * Computes the CRC the Chamelium would report for a frame, using the
+ * fastest implementation available on this machine.
+ */
+void igt_chamelium_xrgb_crc(const void *pixels, size_t count,
+			    uint32_t crc[IGT_CHAMELIUM_CRC_WORDS])
+{
+	struct xrgb_sums s = {};
+
+	xrgb_sums(pixels, count, &s);
+	xrgb_crc(&s, crc);
+}
+
+/* Minimum number of pixels worth handing over to a thread */
+#define XRGB_PIXELS_PER_THREAD (1 << 20)
+
+struct xrgb_parallel {
+	const uint32_t *pixels;
+	size_t count;
+	struct xrgb_sums *sums;
+	size_t *starts;
+};
+
+static void xrgb_parallel_worker(void *data, unsigned int idx,
+				 unsigned int count)
+{
+	struct xrgb_parallel *p = data;
+	size_t start, end;
+
+	/* Start every run on a cacheline, which is also a lane 0 pixel */
+	start = (p->count / count * idx) & ~(size_t)15;
+	end = idx == count - 1 ? p->count :
+	      (p->count / count * (idx + 1)) & ~(size_t)15;
+
+	p->starts[idx] = start;
+	xrgb_sums(p->pixels + start, end - start, &p->sums[idx]);
+}
+
+/**
+ * igt_chamelium_xrgb_crc_parallel:
+ * @pixels: XRGB8888 pixels, with no padding between the lines
+ * @count: number of pixels
+ * @crc: the CRC words, in the order the Chamelium reports them
+ *
+ * As igt_chamelium_xrgb_crc(), splitting large frames in runs hashed
+ * concurrently and combined exactly afterwards.
+ */
+void igt_chamelium_xrgb_crc_parallel(const void *pixels, size_t count,
+				     uint32_t crc[IGT_CHAMELIUM_CRC_WORDS])
+{
+	struct xrgb_parallel p = { .pixels = pixels, .count = count };
+	struct xrgb_sums s = {};
+	unsigned int n, i, k;
+
+	n = igt_thread_parallel_count(count, XRGB_PIXELS_PER_THREAD);
+	if (n == 1) {
+		igt_chamelium_xrgb_crc(pixels, count, crc);
+		return;
+	}
+
+	p.sums = calloc(n, sizeof(*p.sums));
+	p.starts = calloc(n, sizeof(*p.starts));
+	igt_assert(p.sums && p.starts);
+
+	igt_thread_parallel(n, xrgb_parallel_worker, &p);
+
+	for (i = 0; i < n; i++) {
+		uint64_t q = p.starts[i] / 4;
+
+		for (k = 0; k < IGT_CHAMELIUM_CRC_WORDS; k++)
+			s.weighted[k] += q * p.sums[i].sum[k] +
+					 p.sums[i].weighted[k];
+	}
+	xrgb_crc(&s, crc);
+
+	free(p.starts);
+	free(p.sums);
+}
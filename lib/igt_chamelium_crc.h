@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef __IGT_CHAMELIUM_CRC_H__
+#define __IGT_CHAMELIUM_CRC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * IGT_CHAMELIUM_CRC_WORDS:
+ *
+ * Number of words in a Chamelium frame CRC.
+ */
+#define IGT_CHAMELIUM_CRC_WORDS 4
+
+void igt_chamelium_xrgb_crc(const void *pixels, size_t count,
+			    uint32_t crc[IGT_CHAMELIUM_CRC_WORDS]);
+void igt_chamelium_xrgb_crc_parallel(const void *pixels, size_t count,
+				     uint32_t crc[IGT_CHAMELIUM_CRC_WORDS]);
+
+/**
+ * igt_chamelium_crc_impl:
+ * @name: short name of the implementation
+ * @crc: the igt_chamelium_xrgb_crc() implementation
+ * @supported: whether the implementation can be used on this machine
+ *
+ * Individual implementations, exposed for testing and benchmarking. The
+ * #igt_chamelium_crc_impls array is terminated by an entry with a NULL
+ * @name.
+ */
+struct igt_chamelium_crc_impl {
+	const char *name;
+	void (*crc)(const void *pixels, size_t count,
+		    uint32_t crc[IGT_CHAMELIUM_CRC_WORDS]);
+	bool (*supported)(void);
+};
+
+extern const struct igt_chamelium_crc_impl igt_chamelium_crc_impls[];
+
+#endif /* __IGT_CHAMELIUM_CRC_H__ */
@@ -30,8 +30,10 @@
 #include <netdb.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include "igt_chamelium_stream.h"
 #include "igt_core.h"
@@ -40,6 +42,8 @@
 #define STREAM_PORT 9994
 #define STREAM_VERSION_MAJOR 1
 #define STREAM_VERSION_MINOR 0
+/* Servers from this version on can send captured frames and CRCs */
+#define STREAM_VERSION_MINOR_CAPTURE 1
 
 enum stream_error {
 	STREAM_ERROR_NONE = 0,
@@ -69,11 +73,15 @@ enum stream_message_type {
 	STREAM_MESSAGE_STOP_DUMP_VIDEO = 6,
 	STREAM_MESSAGE_DUMP_REALTIME_AUDIO = 7,
 	STREAM_MESSAGE_STOP_DUMP_AUDIO = 8,
+	STREAM_MESSAGE_READ_CAPTURED_FRAME = 9,
+	STREAM_MESSAGE_READ_CAPTURED_CRCS = 10,
+	STREAM_MESSAGE_DUMP_PIXELS = 11,
 };
 
 struct chamelium_stream {
 	char *host;
 	unsigned int port;
+	uint8_t minor;
 
 	int fd;
 };
@@ -312,17 +320,21 @@ static bool chamelium_stream_write_header(struct chamelium_stream *client,
 	return write_whole(client->fd, buf, sizeof(buf));
 }
 
-static bool chamelium_stream_read_response(struct chamelium_stream *client,
-					   enum stream_message_type type,
-					   void *buf, size_t buf_len)
+/*
+ * Reads the header of the response to a request of the given type, leaving
+ * its body of *len bytes to be read. An error response is skipped over, so
+ * that the connection can still be used afterwards.
+ */
+static bool chamelium_stream_read_response_header(struct chamelium_stream *client,
+						  enum stream_message_type type,
+						  size_t *len)
 {
 	enum stream_message_kind read_kind;
 	enum stream_message_type read_type;
 	enum stream_error read_err;
-	size_t read_len;
 
 	if (!chamelium_stream_read_header(client, &read_kind, &read_type,
-					  &read_err, &read_len))
+					  &read_err, len))
 		return false;
 
 	if (read_kind != STREAM_MESSAGE_RESPONSE) {
@@ -337,8 +349,22 @@ static bool chamelium_stream_read_response(struct chamelium_stream *client,
 	if (read_err != STREAM_ERROR_NONE) {
 		igt_warn("Received error: %s (%d)\n",
 			 stream_error_str(read_err), read_err);
+		read_and_discard(client->fd, *len);
 		return false;
 	}
+
+	return true;
+}
+
+static bool chamelium_stream_read_response(struct chamelium_stream *client,
+					   enum stream_message_type type,
+					   void *buf, size_t buf_len)
+{
+	size_t read_len;
+
+	if (!chamelium_stream_read_response_header(client, type, &read_len))
+		return false;
+
 	if (buf_len != read_len) {
 		igt_warn("Received invalid message body size "
 			 "(got %zu bytes, want %zu bytes)\n",
@@ -349,6 +375,63 @@ static bool chamelium_stream_read_response(struct chamelium_stream *client,
 	return read_whole(client->fd, buf, buf_len);
 }
 
+/** Read a frame response from the socket.
+ *
+ * The body is laid out as follows:
+ * - u16: width
+ * - u16: height
+ * - width * height * 3 bytes: the pixels
+ */
+static bool chamelium_stream_read_frame(struct chamelium_stream *client,
+					enum stream_message_type type,
+					unsigned char **buf, size_t *buf_size,
+					int *width, int *height)
+{
+	unsigned char *ptr;
+	uint16_t size[2];
+	size_t len;
+
+	if (!chamelium_stream_read_response_header(client, type, &len))
+		return false;
+
+	/*
+	 * The body of a frame we can't take is skipped over, so that the next
+	 * response isn't read from the middle of it.
+	 */
+	if (len < sizeof(size)) {
+		igt_warn("Received invalid frame (%zu bytes)\n", len);
+		read_and_discard(client->fd, len);
+		return false;
+	}
+
+	if (!read_whole(client->fd, size, sizeof(size)))
+		return false;
+	len -= sizeof(size);
+
+	*width = ntohs(size[0]);
+	*height = ntohs(size[1]);
+	if (len != (size_t)*width * *height * 3) {
+		igt_warn("Received invalid frame size "
+			 "(got %zu bytes for %dx%d)\n",
+			 len, *width, *height);
+		read_and_discard(client->fd, len);
+		return false;
+	}
+
+	if (*buf_size < len) {
+		ptr = realloc(*buf, len);
+		if (!ptr) {
+			igt_warn("realloc failed: %s\n", strerror(errno));
+			read_and_discard(client->fd, len);
+			return false;
+		}
+		*buf = ptr;
+		*buf_size = len;
+	}
+
+	return read_whole(client->fd, *buf, len);
+}
+
 static bool chamelium_stream_write_request(struct chamelium_stream *client,
 					   enum stream_message_type type,
 					   void *buf, size_t buf_len)
@@ -391,6 +474,7 @@ static bool chamelium_stream_check_version(struct chamelium_stream *client)
 			 major, minor);
 		return false;
 	}
+	client->minor = minor;
 
 	return true;
 }
@@ -538,18 +622,168 @@ bool chamelium_stream_stop_realtime_audio(struct chamelium_stream *client)
 }
 
 /**
- * chamelium_stream_init:
+ * chamelium_stream_read_captured_frame:
+ * @index: the index of the frame in the last video capture
+ * @buf: must either point to a dynamically allocated memory region or NULL
+ * @buf_size: size of *@buf, or zero if @buf is NULL
+ * @width: set to the width of the frame
+ * @height: set to the height of the frame
  *
- * Connects to the Chamelium streaming server.
+ * Receives a frame captured by the last video capture, as 3 bytes per
+ * pixel, straight into *@buf. *@buf is only reallocated, updating
+ * @buf_size, when too small for the frame, so that it can be reused from
+ * one frame to the next. The caller is responsible for calling free(3) on
+ * *@buf.
+ *
+ * Requires chamelium_stream_supports_capture().
  */
-struct chamelium_stream *chamelium_stream_init(void)
+bool chamelium_stream_read_captured_frame(struct chamelium_stream *client,
+					  unsigned int index,
+					  unsigned char **buf, size_t *buf_size,
+					  int *width, int *height)
+{
+	uint32_t req = htonl(index);
+
+	if (!chamelium_stream_write_request(client,
+					    STREAM_MESSAGE_READ_CAPTURED_FRAME,
+					    &req, sizeof(req)))
+		return false;
+
+	return chamelium_stream_read_frame(client,
+					   STREAM_MESSAGE_READ_CAPTURED_FRAME,
+					   buf, buf_size, width, height);
+}
+
+/**
+ * chamelium_stream_dump_pixels:
+ * @port_id: the Chamelium port to capture from
+ * @x: the X coordinate to crop the capture to
+ * @y: the Y coordinate to crop the capture to
+ * @w: the width of the area to crop the capture to, or 0 for the whole screen
+ * @h: the height of the area to crop the capture to, or 0 for the whole screen
+ * @buf: as for chamelium_stream_read_captured_frame()
+ * @buf_size: as for chamelium_stream_read_captured_frame()
+ * @width: set to the width of the frame
+ * @height: set to the height of the frame
+ *
+ * Captures the currently displayed frame on @port_id and receives it as
+ * chamelium_stream_read_captured_frame() does.
+ *
+ * Requires chamelium_stream_supports_capture().
+ */
+bool chamelium_stream_dump_pixels(struct chamelium_stream *client, int port_id,
+				  int x, int y, int w, int h,
+				  unsigned char **buf, size_t *buf_size,
+				  int *width, int *height)
+{
+	uint32_t req[5] = {
+		htonl(port_id), htonl(x), htonl(y), htonl(w), htonl(h)
+	};
+
+	if (!chamelium_stream_write_request(client, STREAM_MESSAGE_DUMP_PIXELS,
+					    req, sizeof(req)))
+		return false;
+
+	return chamelium_stream_read_frame(client, STREAM_MESSAGE_DUMP_PIXELS,
+					   buf, buf_size, width, height);
+}
+
+/**
+ * chamelium_stream_read_captured_crcs:
+ * @frame_count: set to the number of CRCs read
+ *
+ * Receives the CRCs of all the frames of the last video capture.
+ *
+ * Requires chamelium_stream_supports_capture().
+ *
+ * Returns: an array of @frame_count CRCs, to be freed by the caller, or NULL
+ * on error.
+ */
+igt_crc_t *chamelium_stream_read_captured_crcs(struct chamelium_stream *client,
+					       int *frame_count)
+{
+	size_t len, count, n_words;
+	uint32_t words[DRM_MAX_CRC_NR];
+	igt_crc_t *crcs;
+
+	if (!chamelium_stream_write_request(client,
+					    STREAM_MESSAGE_READ_CAPTURED_CRCS,
+					    NULL, 0))
+		return NULL;
+
+	if (!chamelium_stream_read_response_header(client,
+						   STREAM_MESSAGE_READ_CAPTURED_CRCS,
+						   &len))
+		return NULL;
+
+	if (len < sizeof(uint32_t)) {
+		igt_warn("Received invalid CRCs (%zu bytes)\n", len);
+		read_and_discard(client->fd, len);
+		return NULL;
+	}
+
+	if (!read_whole(client->fd, words, sizeof(uint32_t)))
+		return NULL;
+	len -= sizeof(uint32_t);
+
+	n_words = ntohl(words[0]);
+	if (!n_words || n_words > DRM_MAX_CRC_NR ||
+	    len % (n_words * sizeof(uint32_t))) {
+		igt_warn("Received invalid CRCs (%zu words, %zu bytes)\n",
+			 n_words, len);
+		read_and_discard(client->fd, len);
+		return NULL;
+	}
+	count = len / (n_words * sizeof(uint32_t));
+
+	crcs = calloc(count ?: 1, sizeof(*crcs));
+	if (!crcs) {
+		read_and_discard(client->fd, len);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!read_whole(client->fd, words, n_words * sizeof(uint32_t))) {
+			free(crcs);
+			return NULL;
+		}
+
+		crcs[i].frame = i;
+		crcs[i].n_words = n_words;
+		for (size_t j = 0; j < n_words; j++)
+			crcs[i].crc[j] = ntohl(words[j]);
+	}
+
+	*frame_count = count;
+	return crcs;
+}
+
+/**
+ * chamelium_stream_supports_capture:
+ *
+ * Returns: whether the server can send captured frames and CRCs, with
+ * chamelium_stream_read_captured_frame(), chamelium_stream_dump_pixels() and
+ * chamelium_stream_read_captured_crcs().
+ */
+bool chamelium_stream_supports_capture(struct chamelium_stream *client)
+{
+	return client->minor >= STREAM_VERSION_MINOR_CAPTURE;
+}
+
+static struct chamelium_stream *chamelium_stream_open(char *host,
+						      unsigned int port)
 {
 	struct chamelium_stream *client;
 
 	client = calloc(1, sizeof(*client));
+	if (!client) {
+		free(host);
+		return NULL;
+	}
+
+	client->host = host;
+	client->port = port;
 
-	if (!chamelium_stream_read_config(client))
-		goto error_client;
 	if (!chamelium_stream_connect(client))
 		goto error_client;
 	if (!chamelium_stream_check_version(client))
@@ -560,13 +794,60 @@ struct chamelium_stream *chamelium_stream_init(void)
 error_fd:
 	close(client->fd);
 error_client:
+	free(client->host);
 	free(client);
 	return NULL;
 }
 
+/**
+ * chamelium_stream_init:
+ *
+ * Connects to the Chamelium streaming server.
+ */
+struct chamelium_stream *chamelium_stream_init(void)
+{
+	struct chamelium_stream config = {};
+	struct chamelium_stream *client;
+
+	if (!chamelium_stream_read_config(&config))
+		return NULL;
+
+	client = chamelium_stream_open(config.host, config.port);
+	if (!client)
+		igt_warn("Failed to connect to Chamelium stream server\n");
+
+	return client;
+}
+
+/**
+ * chamelium_stream_init_host:
+ * @host: the host to connect to, or NULL for the configured Chamelium
+ * @port: the port to connect to, or 0 for the Chamelium's
+ *
+ * Connects to a streaming server, such as the one of
+ * chamelium_stream_server_create(). Unlike chamelium_stream_init(), failing
+ * to connect is not worth a warning, so that the server can be probed for.
+ */
+struct chamelium_stream *chamelium_stream_init_host(const char *host,
+						    unsigned int port)
+{
+	struct chamelium_stream config = {};
+
+	if (host) {
+		config.host = strdup(host);
+		if (!config.host)
+			return NULL;
+	} else if (!chamelium_stream_read_config(&config)) {
+		return NULL;
+	}
+
+	return chamelium_stream_open(config.host, port ?: STREAM_PORT);
+}
+
 void chamelium_stream_deinit(struct chamelium_stream *client)
 {
 	if (close(client->fd) != 0)
 		igt_warn("close failed: %s\n", strerror(errno));
+	free(client->host);
 	free(client);
 }
@@ -28,6 +28,12 @@
 
 #include "config.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "igt_pipe_crc.h"
+
 enum chamelium_stream_realtime_mode {
 	CHAMELIUM_STREAM_REALTIME_NONE = 0,
 	/* stop dumping when overflow */
@@ -39,6 +45,8 @@ enum chamelium_stream_realtime_mode {
 struct chamelium_stream;
 
 struct chamelium_stream *chamelium_stream_init(void);
+struct chamelium_stream *chamelium_stream_init_host(const char *host,
+						    unsigned int port);
 void chamelium_stream_deinit(struct chamelium_stream *client);
 bool chamelium_stream_dump_realtime_audio(struct chamelium_stream *client,
 					  enum chamelium_stream_realtime_mode mode);
@@ -47,4 +55,16 @@ bool chamelium_stream_receive_realtime_audio(struct chamelium_stream *client,
 					     int32_t **buf, size_t *buf_len);
 bool chamelium_stream_stop_realtime_audio(struct chamelium_stream *client);
 
+bool chamelium_stream_supports_capture(struct chamelium_stream *client);
+bool chamelium_stream_read_captured_frame(struct chamelium_stream *client,
+					  unsigned int index,
+					  unsigned char **buf, size_t *buf_size,
+					  int *width, int *height);
+bool chamelium_stream_dump_pixels(struct chamelium_stream *client, int port_id,
+				  int x, int y, int w, int h,
+				  unsigned char **buf, size_t *buf_size,
+				  int *width, int *height);
+igt_crc_t *chamelium_stream_read_captured_crcs(struct chamelium_stream *client,
+					       int *frame_count);
+
 #endif
@@ -0,0 +1,684 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "igt_codec.h"
+#include "igt_x86.h"
+
+/**
+ * SECTION:igt_codec
+ * @short_description: ascii85 and base64 codecs
+ * @title: Codecs
+ * @include: igt_codec.h
+ *
+ * The text encodings binary data is dumped with: the ascii85 variant of
+ * the i915 error state, and base64 for batch and image dumps. Both
+ * directions are vectorized with AVX2 where the CPU has it, so that
+ * reading an error state or a dump runs at close to memory bandwidth.
+ *
+ * The i915 ascii85 variant encodes each dword on its own, as 'z' if it is
+ * zero or else as five digits from '!' to 'u', most significant first.
+ * There is no framing and the final group is never partial. base64 uses
+ * the standard alphabet with '=' padding, without line breaks.
+ */
+
+static inline bool ascii85_digit(char c)
+{
+	return c >= '!' && c <= 'u';
+}
+
+static inline uint32_t ascii85_group(const char *s)
+{
+	uint32_t v = 0;
+
+	for (int i = 0; i < 5; i++)
+		v = v * 85 + (uint8_t)(s[i] - '!');
+
+	return v;
+}
+
+static inline bool ascii85_valid_group(const char *s)
+{
+	return ascii85_digit(s[0]) && ascii85_digit(s[1]) &&
+		ascii85_digit(s[2]) && ascii85_digit(s[3]) &&
+		ascii85_digit(s[4]);
+}
+
+static size_t ascii85_encode(const uint32_t *in, size_t count, char *out)
+{
+	char *s = out;
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t v = in[i];
+
+		if (!v) {
+			*s++ = 'z';
+			continue;
+		}
+
+		for (int j = 4; j >= 0; j--) {
+			s[j] = '!' + v % 85;
+			v /= 85;
+		}
+		s += 5;
+	}
+
+	return s - out;
+}
+
+static size_t ascii85_decode(const char **in, const char *end,
+			     uint32_t *out, size_t count)
+{
+	const char *s = *in;
+	size_t n = 0;
+
+	while (n < count && s < end) {
+		if (*s == 'z') {
+			out[n++] = 0;
+			s++;
+			continue;
+		}
+
+		if (end - s < 5 || !ascii85_valid_group(s))
+			break;
+
+		out[n++] = ascii85_group(s);
+		s += 5;
+	}
+
+	*in = s;
+	return n;
+}
+
+static const char base64_alphabet[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const int8_t base64_values[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+	-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+	-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+	[128 ... 255] = -1,
+};
+
+static inline int base64_value(char c)
+{
+	return base64_values[(uint8_t)c];
+}
+
+static size_t base64_encode(const void *in, size_t len, char *out)
+{
+	const uint8_t *s = in;
+	char *o = out;
+
+	for (; len >= 3; len -= 3, s += 3) {
+		uint32_t v = s[0] << 16 | s[1] << 8 | s[2];
+
+		*o++ = base64_alphabet[v >> 18];
+		*o++ = base64_alphabet[(v >> 12) & 63];
+		*o++ = base64_alphabet[(v >> 6) & 63];
+		*o++ = base64_alphabet[v & 63];
+	}
+
+	if (len) {
+		uint32_t v = s[0] << 16 | (len > 1 ? s[1] << 8 : 0);
+
+		*o++ = base64_alphabet[v >> 18];
+		*o++ = base64_alphabet[(v >> 12) & 63];
+		*o++ = len > 1 ? base64_alphabet[(v >> 6) & 63] : '=';
+		*o++ = '=';
+	}
+
+	return o - out;
+}
+
+static ssize_t base64_decode(const char *in, size_t len, void *out)
+{
+	uint8_t *o = out;
+
+	if (len % 4)
+		return -1;
+
+	for (size_t i = 0; i < len; i += 4) {
+		bool last = i + 4 == len;
+		int a, b, c, d;
+
+		a = base64_value(in[i]);
+		b = base64_value(in[i + 1]);
+		if (a < 0 || b < 0)
+			return -1;
+		*o++ = a << 2 | b >> 4;
+
+		if (last && in[i + 2] == '=' && in[i + 3] == '=')
+			break;
+
+		c = base64_value(in[i + 2]);
+		if (c < 0)
+			return -1;
+		*o++ = b << 4 | c >> 2;
+
+		if (last && in[i + 3] == '=')
+			break;
+
+		d = base64_value(in[i + 3]);
+		if (d < 0)
+			return -1;
+		*o++ = c << 6 | d;
+	}
+
+	return o - (uint8_t *)out;
+}
+
+#if defined(__x86_64__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+
+/* v / 85 for all unsigned 32 bit v, multiplying by 2^38 / 85 */
+static inline __m256i div85_avx2(__m256i v)
+{
+	const __m256i m = _mm256_set1_epi32((int)0xc0c0c0c1);
+	__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(v, m), 38);
+	__m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(v, 32), m), 38);
+
+	return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+}
+
+/*
+ * Eight dwords at a time. The digits are interleaved with two byte shuffles
+ * per lane, the first four digits of each group from one vector and the
+ * last digit from the other, giving 20 characters per lane. Zero dwords
+ * take a single 'z' instead, squeezed out of the groups afterwards.
+ */
+static size_t ascii85_encode_avx2(const uint32_t *in, size_t count, char *out)
+{
+	const __m256i k85 = _mm256_set1_epi32(85);
+	const __m256i bias = _mm256_set1_epi8('!');
+	const __m256i head_lo = _mm256_setr_epi8(0, 1, 2, 3, -1,
+						 4, 5, 6, 7, -1,
+						 8, 9, 10, 11, -1,
+						 12,
+						 0, 1, 2, 3, -1,
+						 4, 5, 6, 7, -1,
+						 8, 9, 10, 11, -1,
+						 12);
+	const __m256i tail_lo = _mm256_setr_epi8(-1, -1, -1, -1, 0,
+						 -1, -1, -1, -1, 4,
+						 -1, -1, -1, -1, 8,
+						 -1,
+						 -1, -1, -1, -1, 0,
+						 -1, -1, -1, -1, 4,
+						 -1, -1, -1, -1, 8,
+						 -1);
+	const __m256i head_hi = _mm256_setr_epi8(13, 14, 15, -1,
+						 -1, -1, -1, -1, -1, -1, -1, -1,
+						 -1, -1, -1, -1,
+						 13, 14, 15, -1,
+						 -1, -1, -1, -1, -1, -1, -1, -1,
+						 -1, -1, -1, -1);
+	const __m256i tail_hi = _mm256_setr_epi8(-1, -1, -1, 12,
+						 -1, -1, -1, -1, -1, -1, -1, -1,
+						 -1, -1, -1, -1,
+						 -1, -1, -1, 12,
+						 -1, -1, -1, -1, -1, -1, -1, -1,
+						 -1, -1, -1, -1);
+	char *s = out;
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+		__m256i q, d[5], head, tail, lo, hi;
+		char tmp[40], *dst;
+		uint32_t w;
+		int zero;
+
+		zero = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, _mm256_setzero_si256())));
+		if (zero == 0xff) {
+			memset(s, 'z', 8);
+			s += 8;
+			continue;
+		}
+
+		q = div85_avx2(v);
+		d[4] = _mm256_sub_epi32(v, _mm256_mullo_epi32(q, k85));
+		v = q;
+		q = div85_avx2(v);
+		d[3] = _mm256_sub_epi32(v, _mm256_mullo_epi32(q, k85));
+		v = q;
+		q = div85_avx2(v);
+		d[2] = _mm256_sub_epi32(v, _mm256_mullo_epi32(q, k85));
+		v = q;
+		/* v < 85^2, small enough to divide as (v * 2^24 / 85) >> 24 */
+		q = _mm256_srli_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(197380)), 24);
+		d[1] = _mm256_sub_epi32(v, _mm256_mullo_epi32(q, k85));
+		d[0] = q;
+
+		head = _mm256_or_si256(_mm256_or_si256(d[0], _mm256_slli_epi32(d[1], 8)),
+				       _mm256_or_si256(_mm256_slli_epi32(d[2], 16),
+						       _mm256_slli_epi32(d[3], 24)));
+		head = _mm256_add_epi8(head, bias);
+		tail = _mm256_add_epi8(d[4], bias);
+
+		lo = _mm256_or_si256(_mm256_shuffle_epi8(head, head_lo),
+				     _mm256_shuffle_epi8(tail, tail_lo));
+		hi = _mm256_or_si256(_mm256_shuffle_epi8(head, head_hi),
+				     _mm256_shuffle_epi8(tail, tail_hi));
+
+		dst = zero ? tmp : s;
+		_mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(lo));
+		w = _mm256_extract_epi32(hi, 0);
+		memcpy(dst + 16, &w, sizeof(w));
+		_mm_storeu_si128((__m128i *)(dst + 20), _mm256_extracti128_si256(lo, 1));
+		w = _mm256_extract_epi32(hi, 4);
+		memcpy(dst + 36, &w, sizeof(w));
+		if (!zero) {
+			s += 40;
+			continue;
+		}
+
+		/* Squeeze the zero dwords down to their 'z' */
+		for (int j = 0; j < 8; j++) {
+			if (zero & (1 << j)) {
+				*s++ = 'z';
+			} else {
+				memcpy(s, tmp + 5 * j, 5);
+				s += 5;
+			}
+		}
+	}
+
+	_mm256_zeroupper();
+
+	return s - out + ascii85_encode(in + i, count - i, s);
+}
+
+/*
+ * Six groups at a time: the two lanes are loaded 15 characters apart and
+ * each holds three groups, which are taken apart with a byte shuffle. The
+ * first four digits are combined pairwise by pmaddubsw and pmaddwd, and
+ * the last digit added after one more multiply. Runs of 'z' are expanded
+ * 32 at a time, and anything else is left to the scalar code one group at
+ * a time.
+ */
+static size_t ascii85_decode_avx2(const char **in, const char *end,
+				  uint32_t *out, size_t count)
+{
+	const __m256i bias = _mm256_set1_epi8('!');
+	const __m256i top = _mm256_set1_epi8(84);
+	const __m256i zeds = _mm256_set1_epi8('z');
+	const __m256i head = _mm256_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8,
+					      10, 11, 12, 13, -1, -1, -1, -1,
+					      0, 1, 2, 3, 5, 6, 7, 8,
+					      10, 11, 12, 13, -1, -1, -1, -1);
+	const __m256i tail = _mm256_setr_epi8(4, -1, -1, -1, 9, -1, -1, -1,
+					      14, -1, -1, -1, -1, -1, -1, -1,
+					      4, -1, -1, -1, 9, -1, -1, -1,
+					      14, -1, -1, -1, -1, -1, -1, -1);
+	const __m256i pairs = _mm256_set1_epi16(85 | 1 << 8);
+	const __m256i quads = _mm256_set1_epi32(85 * 85 | 1 << 16);
+	const __m256i k85 = _mm256_set1_epi32(85);
+	const __m128i three = _mm_setr_epi32(-1, -1, -1, 0);
+	const char *s = *in;
+	size_t n = 0;
+
+	while (n < count && s < end) {
+		if (n + 6 <= count && end - s >= 31) {
+			__m256i x, v;
+			uint32_t valid;
+
+			x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+						    _mm_loadu_si128((const __m128i *)(s + 15)), 1);
+			x = _mm256_sub_epi8(x, bias);
+
+			/* Digits are 0..84 once unbiased; byte 15 of each lane is not ours */
+			valid = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(x, top), top));
+			if ((valid & 0x7fff7fff) == 0x7fff7fff) {
+				v = _mm256_maddubs_epi16(_mm256_shuffle_epi8(x, head), pairs);
+				v = _mm256_madd_epi16(v, quads);
+				v = _mm256_add_epi32(_mm256_mullo_epi32(v, k85),
+						     _mm256_shuffle_epi8(x, tail));
+
+				/*
+				 * The 4th dword of the first lane is overwritten by
+				 * the second, whose own 4th is masked off so that
+				 * nothing past the six decoded dwords is written.
+				 */
+				_mm_storeu_si128((__m128i *)(out + n), _mm256_castsi256_si128(v));
+				_mm_maskstore_epi32((int *)(out + n + 3), three,
+						    _mm256_extracti128_si256(v, 1));
+				n += 6;
+				s += 30;
+				continue;
+			}
+		}
+
+		if (*s == 'z' && n + 32 <= count && end - s >= 32 &&
+		    _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)s), zeds)) == -1) {
+			memset(out + n, 0, 32 * sizeof(*out));
+			n += 32;
+			s += 32;
+			continue;
+		}
+
+		if (*s == 'z') {
+			out[n++] = 0;
+			s++;
+			continue;
+		}
+
+		if (end - s < 5 || !ascii85_valid_group(s))
+			break;
+
+		out[n++] = ascii85_group(s);
+		s += 5;
+	}
+
+	_mm256_zeroupper();
+
+	*in = s;
+	return n;
+}
+
+/*
+ * The base64 codecs follow Muła and Lemire, "Faster Base64 Encoding and
+ * Decoding Using AVX2 Instructions": 24 bytes are spread over 32 six bit
+ * fields with shuffles and multiplies, and mapped to and from the alphabet
+ * by adding a per range offset looked up with pshufb.
+ */
+static size_t base64_encode_avx2(const void *in, size_t len, char *out)
+{
+	const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+						7, 6, 8, 7, 10, 9, 11, 10,
+						1, 0, 2, 1, 4, 3, 5, 4,
+						7, 6, 8, 7, 10, 9, 11, 10);
+	const __m256i offsets = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+						 -4, -4, -4, -4, -19, -16, 0, 0,
+						 65, 71, -4, -4, -4, -4, -4, -4,
+						 -4, -4, -4, -4, -19, -16, 0, 0);
+	const uint8_t *s = in;
+	char *o = out;
+	size_t i;
+
+	for (i = 0; i + 28 <= len; i += 24) {
+		__m256i x, t0, t1, idx;
+
+		x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(s + i))),
+					    _mm_loadu_si128((const __m128i *)(s + i + 12)), 1);
+		x = _mm256_shuffle_epi8(x, spread);
+
+		/* Move each six bit field into the low bits of its own byte */
+		t0 = _mm256_mulhi_epu16(_mm256_and_si256(x, _mm256_set1_epi32(0x0fc0fc00)),
+					_mm256_set1_epi32(0x04000040));
+		t1 = _mm256_mullo_epi16(_mm256_and_si256(x, _mm256_set1_epi32(0x003f03f0)),
+					_mm256_set1_epi32(0x01000010));
+		x = _mm256_or_si256(t0, t1);
+
+		/* 0..25 -> 0, 26..51 -> 1, 52..61 -> 2..11, 62 -> 12, 63 -> 13 */
+		idx = _mm256_subs_epu8(x, _mm256_set1_epi8(51));
+		idx = _mm256_sub_epi8(idx, _mm256_cmpgt_epi8(x, _mm256_set1_epi8(25)));
+		x = _mm256_add_epi8(x, _mm256_shuffle_epi8(offsets, idx));
+
+		_mm256_storeu_si256((__m256i *)o, x);
+		o += 32;
+	}
+
+	_mm256_zeroupper();
+
+	return o - out + base64_encode(s + i, len - i, o);
+}
+
+static ssize_t base64_decode_avx2(const char *in, size_t len, void *out)
+{
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+						0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+						0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+						0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+						0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+						0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+						0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+						  0, 0, 0, 0, 0, 0, 0, 0,
+						  0, 16, 19, 4, -65, -65, -71, -71,
+						  0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9,
+					      8, 14, 13, 12, -1, -1, -1, -1,
+					      2, 1, 0, 6, 5, 4, 10, 9,
+					      8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+	uint8_t *o = out;
+	ssize_t tail;
+	size_t i;
+
+	if (len % 4)
+		return -1;
+
+	/* Each step stores 32 bytes of which 24 are output, keep clear of the end */
+	for (i = 0; i + 48 <= len; i += 32) {
+		__m256i x, hi_nibbles, lo_nibbles, roll;
+
+		x = _mm256_loadu_si256((const __m256i *)(in + i));
+
+		/* Every byte outside the alphabet, '=' included, has a bit in common in both tables */
+		hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(x, 4), mask_2f);
+		lo_nibbles = _mm256_and_si256(x, mask_2f);
+		if (!_mm256_testz_si256(_mm256_shuffle_epi8(lut_lo, lo_nibbles),
+					_mm256_shuffle_epi8(lut_hi, hi_nibbles)))
+			break;
+
+		/* '/' shares its high nibble with '+' but not its offset */
+		roll = _mm256_add_epi8(_mm256_cmpeq_epi8(x, mask_2f), hi_nibbles);
+		x = _mm256_add_epi8(x, _mm256_shuffle_epi8(lut_roll, roll));
+
+		/* Merge the six bit fields into three bytes per four */
+		x = _mm256_maddubs_epi16(x, _mm256_set1_epi32(0x01400140));
+		x = _mm256_madd_epi16(x, _mm256_set1_epi32(0x00011000));
+		x = _mm256_shuffle_epi8(x, pack);
+		x = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+		_mm256_storeu_si256((__m256i *)o, x);
+		o += 24;
+	}
+
+	_mm256_zeroupper();
+
+	tail = base64_decode(in + i, len - i, o);
+	if (tail < 0)
+		return -1;
+
+	return o - (uint8_t *)out + tail;
+}
+
+#pragma GCC pop_options
+
+const struct igt_ascii85_impl igt_ascii85_impls[] = {
+	{ "scalar", ascii85_encode, ascii85_decode, 0 },
+	{ "avx2", ascii85_encode_avx2, ascii85_decode_avx2, AVX2 },
+	{ }
+};
+
+const struct igt_base64_impl igt_base64_impls[] = {
+	{ "scalar", base64_encode, base64_decode, 0 },
+	{ "avx2", base64_encode_avx2, base64_decode_avx2, AVX2 },
+	{ }
+};
+
+typedef size_t (*ascii85_encode_fn)(const uint32_t *, size_t, char *);
+typedef size_t (*ascii85_decode_fn)(const char **, const char *,
+				    uint32_t *, size_t);
+typedef size_t (*base64_encode_fn)(const void *, size_t, char *);
+typedef ssize_t (*base64_decode_fn)(const char *, size_t, void *);
+
+static ascii85_encode_fn resolve_ascii85_encode(void)
+{
+	return igt_x86_features() & AVX2 ? ascii85_encode_avx2 : ascii85_encode;
+}
+
+static ascii85_decode_fn resolve_ascii85_decode(void)
+{
+	return igt_x86_features() & AVX2 ? ascii85_decode_avx2 : ascii85_decode;
+}
+
+static base64_encode_fn resolve_base64_encode(void)
+{
+	return igt_x86_features() & AVX2 ? base64_encode_avx2 : base64_encode;
+}
+
+static base64_decode_fn resolve_base64_decode(void)
+{
+	return igt_x86_features() & AVX2 ? base64_decode_avx2 : base64_decode;
+}
+
+/**
+ * igt_ascii85_encode:
+ * @in: dwords to encode
+ * @count: number of dwords in @in
+ * @out: destination, at least igt_ascii85_encode_bound() characters
+ *
+ * Encodes @in in the ascii85 variant of the i915 error state. @out is not
+ * NUL terminated.
+ *
+ * Returns: the number of characters written to @out.
+ */
+size_t igt_ascii85_encode(const uint32_t *in, size_t count, char *out)
+	__attribute__((ifunc("resolve_ascii85_encode")));
+
+/**
+ * igt_ascii85_decode:
+ * @in: pointer to the text to decode, advanced past the decoded groups
+ * @end: end of the text
+ * @out: destination
+ * @count: maximum number of dwords to write to @out
+ *
+ * Decodes ascii85 from *@in until @count dwords are decoded, or up to the
+ * first character which does not start a complete group, such as the end
+ * of the line. As *@in is left at the next group to decode, a long text
+ * can be decoded in pieces through a small buffer, for example straight
+ * into the input of inflate().
+ *
+ * Returns: the number of dwords written to @out, nothing past them is
+ * written to.
+ */
+size_t igt_ascii85_decode(const char **in, const char *end,
+			  uint32_t *out, size_t count)
+	__attribute__((ifunc("resolve_ascii85_decode")));
+
+/**
+ * igt_base64_encode:
+ * @in: bytes to encode
+ * @len: number of bytes in @in
+ * @out: destination, igt_base64_encode_length() characters
+ *
+ * Encodes @in as padded base64. @out is not NUL terminated.
+ *
+ * Returns: the number of characters written to @out.
+ */
+size_t igt_base64_encode(const void *in, size_t len, char *out)
+	__attribute__((ifunc("resolve_base64_encode")));
+
+/**
+ * igt_base64_decode:
+ * @in: text to decode
+ * @len: number of characters in @in, a multiple of 4
+ * @out: destination, at least igt_base64_decode_bound() bytes
+ *
+ * Decodes padded base64, rejecting any character outside the alphabet
+ * including whitespace.
+ *
+ * Returns: the number of bytes written to @out, or -1 if @in is not valid
+ * base64.
+ */
+ssize_t igt_base64_decode(const char *in, size_t len, void *out)
+	__attribute__((ifunc("resolve_base64_decode")));
+
+#else
+
+const struct igt_ascii85_impl igt_ascii85_impls[] = {
+	{ "scalar", ascii85_encode, ascii85_decode, 0 },
+	{ }
+};
+
+const struct igt_base64_impl igt_base64_impls[] = {
+	{ "scalar", base64_encode, base64_decode, 0 },
+	{ }
+};
+
+size_t igt_ascii85_encode(const uint32_t *in, size_t count, char *out)
+{
+	return ascii85_encode(in, count, out);
+}
+
+size_t igt_ascii85_decode(const char **in, const char *end,
+			  uint32_t *out, size_t count)
+{
+	return ascii85_decode(in, end, out, count);
+}
+
+size_t igt_base64_encode(const void *in, size_t len, char *out)
+{
+	return base64_encode(in, len, out);
+}
+
+ssize_t igt_base64_decode(const char *in, size_t len, void *out)
+{
+	return base64_decode(in, len, out);
+}
+
+#endif
+
+/**
+ * igt_ascii85_length:
+ * @in: text to decode
+ * @len: length of @in
+ *
+ * Counts the dwords igt_ascii85_decode() would decode from @in, so that
+ * the destination can be allocated exactly.
+ *
+ * Returns: the number of dwords encoded at the start of @in.
+ */
+size_t igt_ascii85_length(const char *in, size_t len)
+{
+	const char *end = in + len;
+	size_t count = 0;
+
+	while (in < end) {
+		if (*in == 'z') {
+			in++;
+		} else {
+			if (end - in < 5 || !ascii85_valid_group(in))
+				break;
+			in += 5;
+		}
+		count++;
+	}
+
+	return count;
+}
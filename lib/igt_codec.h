@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef __IGT_CODEC_H__
+#define __IGT_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * igt_ascii85_encode_bound:
+ * @count: number of dwords to encode
+ *
+ * Returns: the largest number of characters igt_ascii85_encode() can
+ * produce for @count dwords.
+ */
+static inline size_t igt_ascii85_encode_bound(size_t count)
+{
+	return 5 * count;
+}
+
+size_t igt_ascii85_encode(const uint32_t *in, size_t count, char *out);
+size_t igt_ascii85_decode(const char **in, const char *end,
+			  uint32_t *out, size_t count);
+size_t igt_ascii85_length(const char *in, size_t len);
+
+/**
+ * igt_base64_encode_length:
+ * @len: number of bytes to encode
+ *
+ * Returns: the number of characters igt_base64_encode() produces for @len
+ * bytes.
+ */
+static inline size_t igt_base64_encode_length(size_t len)
+{
+	return 4 * ((len + 2) / 3);
+}
+
+/**
+ * igt_base64_decode_bound:
+ * @len: number of characters to decode
+ *
+ * Returns: the largest number of bytes igt_base64_decode() can produce for
+ * @len characters.
+ */
+static inline size_t igt_base64_decode_bound(size_t len)
+{
+	return len / 4 * 3;
+}
+
+size_t igt_base64_encode(const void *in, size_t len, char *out);
+ssize_t igt_base64_decode(const char *in, size_t len, void *out);
+
+/**
+ * igt_ascii85_impl:
+ * @name: short name of the implementation
+ * @encode: the igt_ascii85_encode() implementation
+ * @decode: the igt_ascii85_decode() implementation
+ * @features: the igt_x86_features() required by the implementation
+ *
+ * Individual ascii85 implementations, exposed for testing and benchmarking.
+ * The table is terminated by an entry with a NULL @name.
+ */
+struct igt_ascii85_impl {
+	const char *name;
+	size_t (*encode)(const uint32_t *in, size_t count, char *out);
+	size_t (*decode)(const char **in, const char *end,
+			 uint32_t *out, size_t count);
+	unsigned features;
+};
+
+/**
+ * igt_base64_impl:
+ * @name: short name of the implementation
+ * @encode: the igt_base64_encode() implementation
+ * @decode: the igt_base64_decode() implementation
+ * @features: the igt_x86_features() required by the implementation
+ *
+ * As #igt_ascii85_impl, for base64.
+ */
+struct igt_base64_impl {
+	const char *name;
+	size_t (*encode)(const void *in, size_t len, char *out);
+	ssize_t (*decode)(const char *in, size_t len, void *out);
+	unsigned features;
+};
+
+extern const struct igt_ascii85_impl igt_ascii85_impls[];
+extern const struct igt_base64_impl igt_base64_impls[];
+
+#endif /* __IGT_CODEC_H__ */
@@ -43,6 +43,7 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #if defined(__linux__) || defined(__FreeBSD__)
 #include <sys/syscall.h>
 #endif
@@ -54,7 +55,6 @@
 #include <ctype.h>
 #include <limits.h>
 #include <locale.h>
-#include <uwildmat/uwildmat.h>
 #include <glib.h>
 
 #include "drmtest.h"
@@ -74,6 +74,7 @@
 #include "igt_sysrq.h"
 #include "igt_rc.h"
 #include "igt_list.h"
+#include "igt_name_filter.h"
 #include "igt_device_scan.h"
 #include "igt_thread.h"
 #include "runnercomms.h"
@@ -278,7 +279,10 @@ static bool list_subtests = false;
 static bool describe_subtests = false;
 static char *run_single_subtest = NULL;
 static char *run_single_dynamic_subtest = NULL;
+static struct igt_name_filter *run_subtest_filter;
+static struct igt_name_filter *run_dynamic_subtest_filter;
 static bool run_single_subtest_found = false;
+static int fork_server_fd = -1;
 static const char *in_subtest = NULL;
 static const char *in_dynamic_subtest = NULL;
 static struct timespec subtest_time;
@@ -330,6 +334,7 @@ enum {
 	OPT_TRACE_OOPS,
 	OPT_DEVICE,
 	OPT_VERSION,
+	OPT_FORK_SERVER,
 	OPT_HELP = 'h'
 };
 
@@ -898,6 +903,7 @@ static void print_usage(const char *help_str, bool output_on_stderr)
 		   "  --describe\n"
 		   "  --device filters\n"
 		   "  --version\n"
+		   "  --fork-server <fd>\n"
 		   "  --help|-h\n");
 	if (help_str)
 		fprintf(f, "%s\n", help_str);
@@ -1058,6 +1064,24 @@ static void common_init_env(void)
 	}
 }
 
+static void build_subtest_filters(void)
+{
+	igt_name_filter_destroy(run_subtest_filter);
+	run_subtest_filter = NULL;
+	if (run_single_subtest) {
+		run_subtest_filter = igt_name_filter_create();
+		igt_name_filter_add_wildmat(run_subtest_filter, run_single_subtest);
+	}
+
+	igt_name_filter_destroy(run_dynamic_subtest_filter);
+	run_dynamic_subtest_filter = NULL;
+	if (run_single_dynamic_subtest) {
+		run_dynamic_subtest_filter = igt_name_filter_create();
+		igt_name_filter_add_wildmat(run_dynamic_subtest_filter,
+					    run_single_dynamic_subtest);
+	}
+}
+
 static int common_init(int *argc, char **argv,
 		       const char *extra_short_opts,
 		       const struct option *extra_long_opts,
@@ -1078,6 +1102,7 @@ static int common_init(int *argc, char **argv,
 		{"trace-on-oops",     no_argument,       NULL, OPT_TRACE_OOPS},
 		{"device",            required_argument, NULL, OPT_DEVICE},
 		{"version",           no_argument,       NULL, OPT_VERSION},
+		{"fork-server",       required_argument, NULL, OPT_FORK_SERVER},
 		{"help",              no_argument,       NULL, OPT_HELP},
 		{0, 0, 0, 0}
 	};
@@ -1221,6 +1246,10 @@ static int common_init(int *argc, char **argv,
 			print_version();
 			ret = -1;
 			goto out;
+		case OPT_FORK_SERVER:
+			assert(optarg);
+			fork_server_fd = atoi(optarg);
+			break;
 		case OPT_HELP:
 			print_usage(help_str, false);
 			ret = -1;
@@ -1242,6 +1271,8 @@ out:
 	free(short_opts);
 	free(combined_opts);
 
+	build_subtest_filters();
+
 	/* exit immediately if this test has no subtests and a subtest or the
 	 * list of subtests has been requested */
 	if (!test_with_subtests) {
@@ -1249,10 +1280,13 @@ out:
 			igt_warn("Unknown subtest: %s\n", run_single_subtest);
 			exit(IGT_EXIT_INVALID);
 		}
-		if (list_subtests)
+		if (list_subtests || fork_server_fd >= 0)
 			exit(IGT_EXIT_INVALID);
 	}
 
+	if (list_subtests)
+		fork_server_fd = -1;
+
 	if (ret < 0)
 		/* exit with no error for -h/--help */
 		exit(ret == -1 ? 0 : IGT_EXIT_INVALID);
@@ -1411,6 +1445,119 @@ static bool valid_name_for_subtest(const char *subtest_name)
 	return true;
 }
 
+static void fork_server_reply(int sock, int32_t pid)
+{
+	struct runnerpacket *packet = runnerpacket_fork_spawned(pid);
+
+	send_packet_with_fds(sock, packet, NULL, 0);
+	free(packet);
+}
+
+static void fork_server_become_subtest(const char *subtest,
+				       const char *dynamic_subtest,
+				       int *fds, int nfds)
+{
+	dup2(fds[0], STDOUT_FILENO);
+	dup2(fds[1], STDERR_FILENO);
+	close(fds[0]);
+	close(fds[1]);
+
+	if (nfds > 2) {
+		/* dup() drops O_CLOEXEC, like the runner's own socket */
+		set_runner_socket(dup(fds[2]));
+		close(fds[2]);
+	}
+
+	free(run_single_subtest);
+	run_single_subtest = strdup(subtest);
+	free(run_single_dynamic_subtest);
+	run_single_dynamic_subtest =
+		*dynamic_subtest ? strdup(dynamic_subtest) : NULL;
+	build_subtest_filters();
+
+	print_version();
+}
+
+/*
+ * The fork server, started by igt_runner with --fork-server, runs the
+ * test once up to its first subtest and then forks a new process for
+ * every subtest the runner asks for. Each request carries the outputs
+ * for the new process, which then carries on as if it had been executed
+ * with --run-subtest: everything after the first subtest, fixtures
+ * included, runs in the forked process. Forking goes through a short
+ * lived intermediate process so the subtest process gets reparented to
+ * the runner, a child subreaper, which supervises it like any other test
+ * process.
+ *
+ * Returns only in the forked subtest processes.
+ */
+static void fork_server_loop(void)
+{
+	struct runnerpacket *packet;
+	int sock = fork_server_fd;
+
+	fork_server_fd = -1;
+
+	packet = runnerpacket_fork_server_ready();
+	if (!send_packet_with_fds(sock, packet, NULL, 0))
+		exit(IGT_EXIT_INVALID);
+	free(packet);
+
+	for (;;) {
+		runnerpacket_read_helper helper;
+		int fds[RUNNERPACKET_MAX_FDS];
+		int nfds, i;
+		pid_t pid;
+
+		packet = recv_packet_with_fds(sock, fds, &nfds);
+		if (!packet) {
+			/* The runner is done with us */
+			for (i = 0; i < nfds; i++)
+				close(fds[i]);
+			exit(IGT_EXIT_SUCCESS);
+		}
+
+		helper = read_runnerpacket(packet);
+		if (helper.type != PACKETTYPE_FORK_REQUEST || nfds < 2) {
+			fork_server_reply(sock, -EINVAL);
+			goto next;
+		}
+
+		fflush(NULL);
+
+		pid = fork();
+		if (pid == 0) {
+			pid_t child = fork();
+
+			if (child == 0) {
+				setpgid(0, 0);
+				close(sock);
+				fork_server_become_subtest(helper.forkrequest.subtest,
+							   helper.forkrequest.dynamic_subtest,
+							   fds, nfds);
+				free(packet);
+				return;
+			}
+
+			if (child > 0)
+				setpgid(child, child);
+
+			fork_server_reply(sock, child < 0 ? -errno : child);
+			_exit(0);
+		} else if (pid < 0) {
+			fork_server_reply(sock, -errno);
+		} else {
+			while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+				;
+		}
+
+next:
+		for (i = 0; i < nfds; i++)
+			close(fds[i]);
+		free(packet);
+	}
+}
+
 /*
  * Note: Testcases which use these helpers MUST NOT output anything to stdout
  * outside of places protected by igt_run_subtest checks - the piglit
@@ -1428,8 +1575,11 @@ bool __igt_run_subtest(const char *subtest_name, const char *file, const int lin
 		igt_exit();
 	}
 
+	if (fork_server_fd >= 0)
+		fork_server_loop();
+
 	if (run_single_subtest) {
-		if (uwildmat(subtest_name, run_single_subtest) == 0) {
+		if (!igt_name_filter_match(run_subtest_filter, subtest_name)) {
 			_clear_current_description();
 			return false;
 		} else {
@@ -1479,7 +1629,7 @@ bool __igt_run_dynamic_subtest(const char *dynamic_subtest_name)
 	}
 
 	if (run_single_dynamic_subtest &&
-	    uwildmat(dynamic_subtest_name, run_single_dynamic_subtest) == 0)
+	    !igt_name_filter_match(run_dynamic_subtest_filter, dynamic_subtest_name))
 		return false;
 
 	igt_kmsg(KMSG_INFO "%s: starting dynamic subtest %s\n",
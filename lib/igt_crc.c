@@ -42,9 +42,16 @@
  * CRC32 code derived from work by Gary S. Brown.
  */
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+#include "igt_core.h"
 #include "igt_crc.h"
+#include "igt_thread.h"
+#include "igt_x86.h"
 
 const uint32_t igt_crc32_tab[256] = {
 	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
@@ -92,16 +99,340 @@ const uint32_t igt_crc32_tab[256] = {
 	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
+/*
+ * The implementations below all work on the raw shift register value, i.e.
+ * without the initial and final inversion.
+ */
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *p, size_t size)
+{
+	while (size--)
+		crc = igt_crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+/*
+ * Slicing-by-N: crc32_slice_tab[k][b] is the crc contribution of byte b
+ * followed by k zero bytes, so N bytes can be folded in with N independent
+ * lookups instead of a chain of N dependent ones.
+ */
+static uint32_t crc32_slice_tab[16][256];
+static pthread_once_t crc32_slice_once = PTHREAD_ONCE_INIT;
+
+static void crc32_slice_init(void)
+{
+	int i, k;
+
+	for (i = 0; i < 256; i++)
+		crc32_slice_tab[0][i] = igt_crc32_tab[i];
+
+	for (k = 1; k < 16; k++)
+		for (i = 0; i < 256; i++)
+			crc32_slice_tab[k][i] =
+				(crc32_slice_tab[k - 1][i] >> 8) ^
+				igt_crc32_tab[crc32_slice_tab[k - 1][i] & 0xFF];
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+#define T crc32_slice_tab
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *p, size_t size)
+{
+	uint32_t a, b;
+
+	pthread_once(&crc32_slice_once, crc32_slice_init);
+
+	while (size >= 8) {
+		a = get_le32(p) ^ crc;
+		b = get_le32(p + 4);
+
+		crc = T[7][a & 0xFF] ^ T[6][(a >> 8) & 0xFF] ^
+		      T[5][(a >> 16) & 0xFF] ^ T[4][a >> 24] ^
+		      T[3][b & 0xFF] ^ T[2][(b >> 8) & 0xFF] ^
+		      T[1][(b >> 16) & 0xFF] ^ T[0][b >> 24];
+
+		p += 8;
+		size -= 8;
+	}
+
+	return crc32_bytewise(crc, p, size);
+}
+
+static uint32_t crc32_slice16(uint32_t crc, const uint8_t *p, size_t size)
+{
+	uint32_t a, b, c, d;
+
+	pthread_once(&crc32_slice_once, crc32_slice_init);
+
+	while (size >= 16) {
+		a = get_le32(p) ^ crc;
+		b = get_le32(p + 4);
+		c = get_le32(p + 8);
+		d = get_le32(p + 12);
+
+		crc = T[15][a & 0xFF] ^ T[14][(a >> 8) & 0xFF] ^
+		      T[13][(a >> 16) & 0xFF] ^ T[12][a >> 24] ^
+		      T[11][b & 0xFF] ^ T[10][(b >> 8) & 0xFF] ^
+		      T[9][(b >> 16) & 0xFF] ^ T[8][b >> 24] ^
+		      T[7][c & 0xFF] ^ T[6][(c >> 8) & 0xFF] ^
+		      T[5][(c >> 16) & 0xFF] ^ T[4][c >> 24] ^
+		      T[3][d & 0xFF] ^ T[2][(d >> 8) & 0xFF] ^
+		      T[1][(d >> 16) & 0xFF] ^ T[0][d >> 24];
+
+		p += 16;
+		size -= 16;
+	}
+
+	return crc32_bytewise(crc, p, size);
+}
+#undef T
+
+#if defined(__x86_64__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1,pclmul")
+
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+/*
+ * Carry-less multiplication folding, as described in Intel's "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction" white
+ * paper, with the bit-reflected constants for the crc32 polynomial.
+ */
+static uint32_t crc32_pclmul(uint32_t crc, const uint8_t *p, size_t size)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	__m128i x1, x2, x3, x4, x5, x6, x7, x8;
+	size_t len;
+
+	if (size < 64)
+		return crc32_slice16(crc, p, size);
+
+	len = size & ~(size_t)15;
+	size -= len;
+
+	x1 = _mm_loadu_si128((const __m128i *)(p + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *)(p + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *)(p + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *)(p + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	p += 64;
+	len -= 64;
+
+	/* Fold 4x128 bits at a time */
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+				   _mm_loadu_si128((const __m128i *)(p + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+				   _mm_loadu_si128((const __m128i *)(p + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+				   _mm_loadu_si128((const __m128i *)(p + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+				   _mm_loadu_si128((const __m128i *)(p + 0x30)));
+
+		p += 64;
+		len -= 64;
+	}
+
+	/* Fold into 128 bits */
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	/* Fold the remaining 128 bit blocks */
+	while (len >= 16) {
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+				   _mm_loadu_si128((const __m128i *)p));
+
+		p += 16;
+		len -= 16;
+	}
+
+	/* Fold 128 bits to 64 bits */
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits */
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	crc = _mm_extract_epi32(x1, 1);
+
+	return crc32_slice16(crc, p, size);
+}
+
+#pragma GCC pop_options
+
+static bool crc32_pclmul_supported(void)
+{
+	return (igt_x86_features() & (SSE4_1 | PCLMUL)) == (SSE4_1 | PCLMUL);
+}
+#endif
+
+static bool crc32_always_supported(void)
+{
+	return true;
+}
+
+#define CRC32_UPDATE(impl) \
+static uint32_t crc32_update_##impl(uint32_t crc, const void *buf, \
+				    size_t size) \
+{ \
+	return ~crc32_##impl(~crc, buf, size); \
+}
+
+CRC32_UPDATE(bytewise)
+CRC32_UPDATE(slice8)
+CRC32_UPDATE(slice16)
+#if defined(__x86_64__) && !defined(__clang__)
+CRC32_UPDATE(pclmul)
+#endif
+
+const struct igt_crc32_impl igt_crc32_impls[] = {
+	{ "bytewise", crc32_update_bytewise, crc32_always_supported },
+	{ "slice8", crc32_update_slice8, crc32_always_supported },
+	{ "slice16", crc32_update_slice16, crc32_always_supported },
+#if defined(__x86_64__) && !defined(__clang__)
+	{ "pclmul", crc32_update_pclmul, crc32_pclmul_supported },
+#endif
+	{ }
+};
+
+/**
+ * igt_cpu_crc32_update:
+ * @crc: the crc32 of the preceding data, or 0 for the start of the data
+ * @buf: the data to add to the crc32
+ * @size: the size of @buf in bytes
+ *
+ * Update a running crc32 with the content of @buf, using the fastest
+ * implementation available on this machine. The result is compatible with
+ * zlib's crc32(), and thus with crc32_combine().
+ *
+ * Returns: the crc32 of the preceding data followed by @buf
+ */
+#if defined(__x86_64__) && !defined(__clang__)
+static uint32_t (*resolve_cpu_crc32_update(void))(uint32_t, const void *,
+						  size_t)
+{
+	if (crc32_pclmul_supported())
+		return crc32_update_pclmul;
+
+	return crc32_update_slice16;
+}
+
+uint32_t igt_cpu_crc32_update(uint32_t crc, const void *buf, size_t size)
+	__attribute__((ifunc("resolve_cpu_crc32_update")));
+#else
+uint32_t igt_cpu_crc32_update(uint32_t crc, const void *buf, size_t size)
+{
+	return crc32_update_slice16(crc, buf, size);
+}
+#endif
+
+/**
+ * igt_cpu_crc32:
+ * @buf: the data to compute the crc32 of
+ * @size: the size of @buf in bytes
+ *
+ * Returns: the crc32 of @buf
+ */
 uint32_t igt_cpu_crc32(const void *buf, size_t size)
 {
+	return igt_cpu_crc32_update(0, buf, size);
+}
+
+/* Minimum number of bytes worth handing over to a thread */
+#define CRC32_BYTES_PER_THREAD (4 << 20)
+
+struct crc32_parallel {
+	const uint8_t *buf;
+	size_t size;
+	uint32_t *crcs;
+	size_t *lens;
+};
+
+static void crc32_parallel_worker(void *data, unsigned int idx,
+				  unsigned int count)
+{
+	struct crc32_parallel *c = data;
+	size_t start, end;
 
-	const uint8_t *p = buf;
+	/* Keep the chunks cacheline aligned */
+	start = (c->size / count * idx) & ~(size_t)63;
+	end = idx == count - 1 ? c->size :
+	      (c->size / count * (idx + 1)) & ~(size_t)63;
+
+	c->lens[idx] = end - start;
+	c->crcs[idx] = igt_cpu_crc32_update(0, c->buf + start, end - start);
+}
+
+/**
+ * igt_cpu_crc32_parallel:
+ * @buf: the data to compute the crc32 of
+ * @size: the size of @buf in bytes
+ *
+ * Compute the crc32 of large buffers by splitting them in chunks hashed
+ * concurrently, whose crc32 are combined afterwards.
+ *
+ * Returns: the crc32 of @buf, same as igt_cpu_crc32()
+ */
+uint32_t igt_cpu_crc32_parallel(const void *buf, size_t size)
+{
+	struct crc32_parallel c = { .buf = buf, .size = size };
+	unsigned int count, i;
 	uint32_t crc;
 
-	crc = ~0U;
+	count = igt_thread_parallel_count(size, CRC32_BYTES_PER_THREAD);
+	if (count == 1)
+		return igt_cpu_crc32(buf, size);
 
-	while (size--)
-		crc = igt_crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	c.crcs = calloc(count, sizeof(*c.crcs));
+	c.lens = calloc(count, sizeof(*c.lens));
+	igt_assert(c.crcs && c.lens);
+
+	igt_thread_parallel(count, crc32_parallel_worker, &c);
+
+	crc = c.crcs[0];
+	for (i = 1; i < count; i++)
+		crc = crc32_combine(crc, c.crcs[i], c.lens[i]);
+
+	free(c.lens);
+	free(c.crcs);
 
-	return crc ^ ~0U;
+	return crc;
 }
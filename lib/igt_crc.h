@@ -6,6 +6,7 @@
 #ifndef __IGT_CRC_H__
 #define __IGT_CRC_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -27,5 +28,24 @@
 const uint32_t igt_crc32_tab[256];
 
 uint32_t igt_cpu_crc32(const void *buf, size_t size);
+uint32_t igt_cpu_crc32_update(uint32_t crc, const void *buf, size_t size);
+uint32_t igt_cpu_crc32_parallel(const void *buf, size_t size);
+
+/**
+ * igt_crc32_impl:
+ * @name: short name of the implementation
+ * @update: running crc32 computation, see igt_cpu_crc32_update()
+ * @supported: whether the implementation can be used on this machine
+ *
+ * Individual crc32 implementations, exposed for testing and benchmarking.
+ * The #igt_crc32_impls array is terminated by an entry with a NULL @name.
+ */
+struct igt_crc32_impl {
+	const char *name;
+	uint32_t (*update)(uint32_t crc, const void *buf, size_t size);
+	bool (*supported)(void);
+};
+
+extern const struct igt_crc32_impl igt_crc32_impls[];
 
 #endif
@@ -35,6 +35,7 @@
 #ifdef __linux__
 #include <linux/limits.h>
 #endif
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -182,6 +183,14 @@
  *   sriov:vendor=Intel,device=1234,card=0,pf=1,vf=0
  *   ]|
  *
+ * # Scan cache
+ *
+ * When the IGT_DEVICE_SCAN_CACHE environment variable names a file, scanned
+ * devices are saved there and read back by the following scans instead of
+ * going through udev again, as long as the system wasn't rebooted, no uevent
+ * was sent and /dev/dri didn't change since. Sysattrs aren't saved, they are
+ * read from sysfs when first used.
+ *
  */
 
 #ifdef DEBUG_DEVICE_SCAN
@@ -223,6 +232,7 @@ struct igt_device {
 	/* Properties / sysattrs rewriten from udev lists */
 	GHashTable *props_ht;
 	GHashTable *attrs_ht;
+	bool attrs_scanned; /* Otherwise only holds the sysattrs queried so far */
 
 	/* Most usable variables from udev device */
 	char *subsystem;
@@ -565,15 +575,99 @@ static void get_attrs(struct udev_device *dev, struct igt_device *idev)
 	}
 }
 
+/* Reads a single sysattr the way get_attrs() would get it from udev */
+static char *read_attr(const struct igt_device *dev, const char *key)
+{
+	char path[PATH_MAX], buf[4096];
+	struct stat st;
+	ssize_t len;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dev->syspath, key);
+	if (lstat(path, &st))
+		return NULL;
+
+	if (S_ISLNK(st.st_mode)) {
+		const char *v;
+
+		len = readlink(path, buf, sizeof(buf));
+		if (len <= 0 || len == sizeof(buf))
+			return NULL;
+		buf[len] = '\0';
+
+		v = strrchr(buf, '/');
+		return v ? strdup(v + 1) : NULL;
+	}
+
+	if (!S_ISREG(st.st_mode) || !(st.st_mode & S_IRUSR))
+		return NULL;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len < 0)
+		return NULL;
+
+	while (len && buf[len - 1] == '\n')
+		len--;
+	buf[len] = '\0';
+
+	return strdup(buf);
+}
+
+/*
+ * Sysattrs are only read when first asked for, as only a few of them are
+ * ever used by filters while reading them all takes a while.
+ */
+static const char *get_attr(struct igt_device *dev, const char *key)
+{
+	char *value = g_hash_table_lookup(dev->attrs_ht, key);
+
+	if (value || dev->attrs_scanned || is_on_blacklist(key))
+		return value;
+
+	value = read_attr(dev, key);
+	if (value)
+		g_hash_table_insert(dev->attrs_ht, strdup(key), value);
+
+	return value;
+}
+
+/* For printing them all */
+static void scan_attrs(struct igt_device *dev)
+{
+	struct udev_device *udev_dev;
+	struct udev *udev;
+
+	if (dev->attrs_scanned)
+		return;
+
+	udev = udev_new();
+	igt_assert(udev);
+
+	udev_dev = udev_device_new_from_syspath(udev, dev->syspath);
+	if (udev_dev) {
+		get_attrs(udev_dev, dev);
+		udev_device_unref(udev_dev);
+	}
+	udev_unref(udev);
+
+	dev->attrs_scanned = true;
+}
+
 #define get_prop(dev, prop) ((char *) g_hash_table_lookup(dev->props_ht, prop))
-#define get_attr(dev, attr) ((char *) g_hash_table_lookup(dev->attrs_ht, attr))
 #define get_prop_subsystem(dev) get_prop(dev, "SUBSYSTEM")
 #define is_drm_subsystem(dev)  (strequal(get_prop_subsystem(dev), "drm"))
 #define is_pci_subsystem(dev)  (strequal(get_prop_subsystem(dev), "pci"))
 
 static void print_ht(GHashTable *ht);
-static void dump_props_and_attrs(const struct igt_device *dev)
+static void dump_props_and_attrs(struct igt_device *dev)
 {
+	scan_attrs(dev);
+
 	printf("\n[properties]\n");
 	print_ht(dev->props_ht);
 	printf("\n[attributes]\n");
@@ -632,8 +726,8 @@ static char* strdup_nullsafe(const char* str)
 }
 
 /* Create new igt_device from udev device.
- * Fills structure with most usable udev device variables, properties
- * and sysattrs.
+ * Fills structure with most usable udev device variables and properties,
+ * sysattrs are read on demand.
  */
 static struct igt_device *igt_device_new_from_udev(struct udev_device *dev)
 {
@@ -650,7 +744,6 @@ static struct igt_device *igt_device_new_from_udev(struct udev_device *dev)
 		idev->drm_render = strdup(idev->devnode);
 
 	get_props(dev, idev);
-	get_attrs(dev, idev);
 
 	if (is_pci_subsystem(idev)) {
 		uint16_t vendor, device;
@@ -965,7 +1058,6 @@ static void scan_drm_devices(void)
 	struct udev *udev;
 	struct udev_enumerate *enumerate;
 	struct udev_list_entry *devices, *dev_list_entry;
-	struct igt_device *dev;
 	int ret;
 
 	udev = udev_new();
@@ -1006,6 +1098,11 @@ static void scan_drm_devices(void)
 
 	sort_all_devices();
 	index_pci_devices();
+}
+
+static void fill_filtered_devices(void)
+{
+	struct igt_device *dev;
 
 	igt_list_for_each_entry(dev, &igt_devs.all, link) {
 		struct igt_device *dev_dup = duplicate_device(dev);
@@ -1013,6 +1110,329 @@ static void scan_drm_devices(void)
 	}
 }
 
+#define SCAN_CACHE_MAGIC "igt-devs"
+#define SCAN_CACHE_VERSION 1
+#define SCAN_CACHE_NO_STRING UINT32_MAX
+
+/* What the scanned devices depend on */
+struct scan_cache_stamp {
+	char boot_id[40];
+	uint64_t uevent_seqnum;
+	int64_t dri_mtime_sec;
+	int64_t dri_mtime_nsec;
+};
+
+/*
+ * The cache file is the header, an array of devices in the order of
+ * igt_devs.all and the strings they point to, as offsets from the start of
+ * the strings. Properties are consecutive key and value strings.
+ */
+struct scan_cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+	uint64_t size;
+	struct scan_cache_stamp stamp;
+};
+
+struct scan_cache_device {
+	uint32_t subsystem, syspath, devnode;
+	uint32_t drm_card, drm_render;
+	uint32_t vendor, device, pci_slot_name;
+	uint32_t props, props_size;
+	int32_t parent;
+	int32_t gpu_index;
+};
+
+static bool read_line(const char *path, char *buf, int size)
+{
+	FILE *f = fopen(path, "r");
+	bool ok;
+
+	if (!f)
+		return false;
+
+	ok = fgets(buf, size, f) != NULL;
+	fclose(f);
+	if (ok)
+		buf[strcspn(buf, "\n")] = '\0';
+
+	return ok;
+}
+
+static bool get_scan_cache_stamp(struct scan_cache_stamp *stamp)
+{
+	char seqnum[32];
+	struct stat st;
+
+	memset(stamp, 0, sizeof(*stamp));
+
+	if (!read_line("/proc/sys/kernel/random/boot_id",
+		       stamp->boot_id, sizeof(stamp->boot_id)) ||
+	    !read_line("/sys/kernel/uevent_seqnum", seqnum, sizeof(seqnum)))
+		return false;
+
+	stamp->uevent_seqnum = strtoull(seqnum, NULL, 10);
+
+	if (stat("/dev/dri", &st) == 0) {
+		stamp->dri_mtime_sec = st.st_mtim.tv_sec;
+		stamp->dri_mtime_nsec = st.st_mtim.tv_nsec;
+	}
+
+	return true;
+}
+
+static uint32_t scan_cache_string(GString *strings, const char *str)
+{
+	uint32_t offset = strings->len;
+
+	if (!str)
+		return SCAN_CACHE_NO_STRING;
+
+	g_string_append_len(strings, str, strlen(str) + 1);
+
+	return offset;
+}
+
+static int device_index(struct igt_device *dev)
+{
+	struct igt_device *pos;
+	int i = 0;
+
+	igt_list_for_each_entry(pos, &igt_devs.all, link) {
+		if (pos == dev)
+			return i;
+		i++;
+	}
+
+	return -1;
+}
+
+static void write_scan_cache(const char *path,
+			     const struct scan_cache_stamp *stamp)
+{
+	struct scan_cache_header header = {
+		.magic = SCAN_CACHE_MAGIC,
+		.version = SCAN_CACHE_VERSION,
+		.stamp = *stamp,
+	};
+	struct scan_cache_device *cdevs;
+	struct igt_device *dev;
+	GString *strings;
+	char *tmp;
+	FILE *f;
+	int fd, i = 0;
+	bool ok;
+
+	header.count = igt_list_length(&igt_devs.all);
+	cdevs = calloc(header.count, sizeof(*cdevs));
+	if (header.count && !cdevs)
+		return;
+
+	/* Keeps the strings area NUL terminated, even when empty */
+	strings = g_string_new(NULL);
+	g_string_append_c(strings, '\0');
+
+	igt_list_for_each_entry(dev, &igt_devs.all, link) {
+		struct scan_cache_device *cdev = &cdevs[i++];
+		GHashTableIter iter;
+		gpointer key, value;
+
+		cdev->subsystem = scan_cache_string(strings, dev->subsystem);
+		cdev->syspath = scan_cache_string(strings, dev->syspath);
+		cdev->devnode = scan_cache_string(strings, dev->devnode);
+		cdev->drm_card = scan_cache_string(strings, dev->drm_card);
+		cdev->drm_render = scan_cache_string(strings, dev->drm_render);
+		cdev->vendor = scan_cache_string(strings, dev->vendor);
+		cdev->device = scan_cache_string(strings, dev->device);
+		cdev->pci_slot_name = scan_cache_string(strings, dev->pci_slot_name);
+		cdev->parent = dev->parent ? device_index(dev->parent) : -1;
+		cdev->gpu_index = dev->gpu_index;
+
+		cdev->props = strings->len;
+		g_hash_table_iter_init(&iter, dev->props_ht);
+		while (g_hash_table_iter_next(&iter, &key, &value)) {
+			scan_cache_string(strings, key);
+			scan_cache_string(strings, value);
+		}
+		cdev->props_size = strings->len - cdev->props;
+	}
+
+	header.size = sizeof(header) + header.count * sizeof(*cdevs) +
+		      strings->len;
+
+	/* Written aside and renamed, concurrent scans never see a partial file */
+	igt_assert(asprintf(&tmp, "%s.XXXXXX", path) > 0);
+	fd = mkstemp(tmp);
+	f = fd >= 0 ? fdopen(fd, "w") : NULL;
+	if (f) {
+		ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		     fwrite(cdevs, sizeof(*cdevs), header.count, f) == header.count &&
+		     fwrite(strings->str, strings->len, 1, f) == 1;
+		ok &= fclose(f) == 0;
+
+		if (!ok || rename(tmp, path)) {
+			igt_debug("Failed to write the device scan cache %s\n", path);
+			unlink(tmp);
+		}
+	} else if (fd >= 0) {
+		close(fd);
+		unlink(tmp);
+	}
+
+	free(tmp);
+	g_string_free(strings, TRUE);
+	free(cdevs);
+}
+
+static char *scan_cache_strdup(const char *strings, uint32_t size,
+			       uint32_t offset, bool *ok)
+{
+	if (offset == SCAN_CACHE_NO_STRING)
+		return NULL;
+
+	if (offset >= size) {
+		*ok = false;
+		return NULL;
+	}
+
+	return strdup(strings + offset);
+}
+
+static struct igt_device *
+device_from_scan_cache(const struct scan_cache_device *cdev,
+		       const char *strings, uint32_t size)
+{
+	struct igt_device *dev = igt_device_new();
+	const char *prop, *end;
+	bool ok = true;
+
+	igt_assert(dev);
+	dev->subsystem = scan_cache_strdup(strings, size, cdev->subsystem, &ok);
+	dev->syspath = scan_cache_strdup(strings, size, cdev->syspath, &ok);
+	dev->devnode = scan_cache_strdup(strings, size, cdev->devnode, &ok);
+	dev->drm_card = scan_cache_strdup(strings, size, cdev->drm_card, &ok);
+	dev->drm_render = scan_cache_strdup(strings, size, cdev->drm_render, &ok);
+	dev->vendor = scan_cache_strdup(strings, size, cdev->vendor, &ok);
+	dev->device = scan_cache_strdup(strings, size, cdev->device, &ok);
+	dev->pci_slot_name = scan_cache_strdup(strings, size,
+					       cdev->pci_slot_name, &ok);
+	dev->gpu_index = cdev->gpu_index;
+
+	if (!ok || !dev->subsystem || !dev->syspath ||
+	    cdev->props > size || cdev->props_size > size - cdev->props)
+		goto err;
+
+	prop = strings + cdev->props;
+	end = prop + cdev->props_size;
+	while (prop < end) {
+		const char *value = prop + strlen(prop) + 1;
+
+		if (value >= end)
+			goto err;
+
+		igt_device_add_prop(dev, prop, value);
+		prop = value + strlen(value) + 1;
+	}
+
+	/* Not saved, igt may know more devices than the one which wrote it */
+	if (is_pci_subsystem(dev)) {
+		uint16_t vendor, device;
+
+		if (!dev->vendor || !dev->device || !dev->pci_slot_name)
+			goto err;
+
+		get_pci_vendor_device(dev, &vendor, &device);
+		dev->codename = __pci_codename(vendor, device);
+		dev->dev_type = __pci_devtype(vendor, device, dev->pci_slot_name);
+	}
+
+	return dev;
+
+err:
+	igt_device_free(dev);
+	free(dev);
+	return NULL;
+}
+
+static bool load_scan_cache(const char *path,
+			    const struct scan_cache_stamp *stamp)
+{
+	const struct scan_cache_header *header;
+	const struct scan_cache_device *cdevs;
+	struct igt_device **devs = NULL;
+	const char *strings;
+	uint32_t strings_size;
+	bool ok = false;
+	struct stat st;
+	void *map;
+	int fd, i;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	if (fstat(fd, &st) || st.st_size < sizeof(*header)) {
+		close(fd);
+		return false;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	header = map;
+	if (memcmp(header->magic, SCAN_CACHE_MAGIC, sizeof(header->magic)) ||
+	    header->version != SCAN_CACHE_VERSION ||
+	    header->size != st.st_size ||
+	    memcmp(&header->stamp, stamp, sizeof(*stamp)) ||
+	    header->count > (st.st_size - sizeof(*header)) / sizeof(*cdevs))
+		goto out;
+
+	cdevs = map + sizeof(*header);
+	strings = (const char *)(cdevs + header->count);
+	strings_size = st.st_size - sizeof(*header) -
+		       header->count * sizeof(*cdevs);
+	if (!strings_size || strings[strings_size - 1])
+		goto out;
+
+	devs = calloc(header->count, sizeof(*devs));
+	if (header->count && !devs)
+		goto out;
+
+	for (i = 0; i < header->count; i++) {
+		devs[i] = device_from_scan_cache(&cdevs[i], strings, strings_size);
+		if (!devs[i])
+			goto err;
+
+		if (cdevs[i].parent >= (int32_t)header->count)
+			goto err;
+	}
+
+	for (i = 0; i < header->count; i++) {
+		if (cdevs[i].parent >= 0)
+			devs[i]->parent = devs[cdevs[i].parent];
+		igt_list_add_tail(&devs[i]->link, &igt_devs.all);
+	}
+
+	ok = true;
+	goto out;
+
+err:
+	while (i >= 0) {
+		if (devs[i]) {
+			igt_device_free(devs[i]);
+			free(devs[i]);
+		}
+		i--;
+	}
+out:
+	free(devs);
+	munmap(map, st.st_size);
+	return ok;
+}
+
 static void igt_device_free(struct igt_device *dev)
 {
 	free(dev->codename);
@@ -1053,9 +1473,16 @@ void igt_devices_free(void)
  * called with @force = false. If something changes during the the test
  * or test does some module loading (new drm devices occurs during execution)
  * function must be called again with @force = true to refresh device array.
+ *
+ * With IGT_DEVICE_SCAN_CACHE set, devices are read from the scan cache when
+ * it is still valid, unless @force is true.
  */
 void igt_devices_scan(bool force)
 {
+	const char *cache = getenv("IGT_DEVICE_SCAN_CACHE");
+	struct scan_cache_stamp stamp;
+	bool use_cache;
+
 	if (force && igt_devs.devs_scanned)
 		igt_devices_free();
 
@@ -1063,7 +1490,16 @@ void igt_devices_scan(bool force)
 		return;
 
 	prepare_scan();
-	scan_drm_devices();
+
+	/* Stamped before scanning, changes made meanwhile invalidate the cache */
+	use_cache = cache && *cache && get_scan_cache_stamp(&stamp);
+	if (!use_cache || force || !load_scan_cache(cache, &stamp)) {
+		scan_drm_devices();
+		if (use_cache)
+			write_scan_cache(cache, &stamp);
+	}
+
+	fill_filtered_devices();
 
 	igt_devs.devs_scanned = true;
 }
@@ -32,6 +32,7 @@
 #include "intel_chipset.h"
 #include "igt_core.h"
 #include "igt_fb.h"
+#include "igt_tiling.h"
 #include "ioctl_wrappers.h"
 #include "i830_reg.h"
 #include "i915/gem_create.h"
@@ -108,254 +109,6 @@ const char *igt_draw_get_method_name(enum igt_draw_method method)
 	}
 }
 
-static unsigned long swizzle_bit(unsigned int bit, unsigned long offset)
-{
-	return (offset & (1ul << bit)) >> (bit - 6);
-}
-
-static int swizzle_addr(unsigned long addr, int swizzle)
-{
-	switch (swizzle) {
-	case I915_BIT_6_SWIZZLE_NONE:
-		return addr;
-	case I915_BIT_6_SWIZZLE_9:
-		return addr ^ swizzle_bit(9, addr);
-	case I915_BIT_6_SWIZZLE_9_10:
-		return addr ^ swizzle_bit(9, addr) ^ swizzle_bit(10, addr);
-	case I915_BIT_6_SWIZZLE_9_11:
-		return addr ^ swizzle_bit(9, addr) ^ swizzle_bit(11, addr);
-	case I915_BIT_6_SWIZZLE_9_10_11:
-		return (addr ^
-			swizzle_bit(9, addr) ^
-			swizzle_bit(10, addr) ^
-			swizzle_bit(11, addr));
-
-	case I915_BIT_6_SWIZZLE_UNKNOWN:
-	case I915_BIT_6_SWIZZLE_9_17:
-	case I915_BIT_6_SWIZZLE_9_10_17:
-	default:
-		/* If we hit this case, we need to implement support for the
-		 * appropriate swizzling method. */
-		igt_require(false);
-		return addr;
-	}
-}
-
-static int tile(int x, int y, uint32_t x_tile_size, uint32_t y_tile_size,
-		uint32_t line_size, bool xmajor)
-{
-	int tile_size, tiles_per_line, x_tile_n, y_tile_n, tile_off, pos;
-	int tile_n, x_tile_off, y_tile_off;
-
-	tiles_per_line = line_size / x_tile_size;
-	tile_size = x_tile_size * y_tile_size;
-
-	x_tile_n = x / x_tile_size;
-	y_tile_n = y / y_tile_size;
-	tile_n = y_tile_n * tiles_per_line + x_tile_n;
-
-	x_tile_off = x % x_tile_size;
-	y_tile_off = y % y_tile_size;
-
-	if (xmajor)
-		tile_off = y_tile_off * x_tile_size + x_tile_off;
-	else
-		tile_off = x_tile_off * y_tile_size + y_tile_off;
-
-	pos = tile_n * tile_size + tile_off;
-
-	return pos;
-}
-
-static void untile(int tiled_pos, int x_tile_size, int y_tile_size,
-		   uint32_t line_size, bool xmajor, int *x, int *y)
-{
-	int tile_n, tile_off, tiles_per_line;
-	int x_tile_off, y_tile_off;
-	int x_tile_n, y_tile_n;
-	int tile_size;
-
-	tile_size = x_tile_size * y_tile_size;
-	tiles_per_line = line_size / x_tile_size;
-
-	tile_n = tiled_pos / tile_size;
-	tile_off = tiled_pos % tile_size;
-
-	if (xmajor) {
-		y_tile_off = tile_off / x_tile_size;
-		x_tile_off = tile_off % x_tile_size;
-	} else {
-		y_tile_off = tile_off % y_tile_size;
-		x_tile_off = tile_off / y_tile_size;
-	}
-
-	x_tile_n = tile_n % tiles_per_line;
-	y_tile_n = tile_n / tiles_per_line;
-
-	*x = (x_tile_n * x_tile_size + x_tile_off);
-	*y = y_tile_n * y_tile_size + y_tile_off;
-}
-
-static int linear_x_y_to_xtiled_pos(int x, int y, uint32_t stride, int swizzle,
-				    int bpp)
-{
-	int pos;
-	int pixel_size = bpp / 8;
-
-	x *= pixel_size;
-	pos = tile(x, y, 512, 8, stride, true);
-	pos = swizzle_addr(pos, swizzle);
-	return pos / pixel_size;
-}
-
-static int linear_x_y_to_ytiled_pos(int x, int y, uint32_t stride, int swizzle,
-				    int bpp)
-{
-	int ow_tile_n, pos;
-	int ow_size = 16;
-	int pixel_size = bpp / 8;
-
-	/* We have an Y tiling of OWords, so use the tile() function to get the
-	 * OW number, then adjust to the fact that the OW may have more than one
-	 * pixel. */
-	x *= pixel_size;
-	ow_tile_n = tile(x / ow_size, y, 128 / ow_size, 32,
-			 stride / ow_size, false);
-	pos = ow_tile_n * ow_size + (x % ow_size);
-	pos = swizzle_addr(pos, swizzle);
-	return pos / pixel_size;
-}
-
-#define OW_SIZE 16			/* in bytes */
-#define TILE_4_SUBTILE_SIZE 64		/* in bytes */
-#define TILE_4_WIDTH 128		/* in bytes */
-#define TILE_4_HEIGHT 32		/* in pixels */
-#define TILE_4_SUBTILE_WIDTH  OW_SIZE	/* in bytes */
-#define TILE_4_SUBTILE_HEIGHT 4		/* in pixels */
-
-/*
- * Subtile remapping for tile 4.  Note that map[a]==b implies map[b]==a
- * so we can use the same table to tile and until.
- */
-static const int tile4_subtile_map[] = {
-	0,  1,  2,  3,  8,  9, 10, 11,
-	4,  5,  6,  7, 12, 13, 14, 15,
-	16, 17, 18, 19, 24, 25, 26, 27,
-	20, 21, 22, 23, 28, 29, 30, 31,
-	32, 33, 34, 35, 40, 41, 42, 43,
-	36, 37, 38, 39, 44, 45, 46, 47,
-	48, 49, 50, 51, 56, 57, 58, 59,
-	52, 53, 54, 55, 60, 61, 62, 63
-};
-
-static int linear_x_y_to_4tiled_pos(int x, int y, uint32_t stride, int swizzle,
-				    int bpp)
-{
-	int tile_base_pos;
-	int tile_x, tile_y;
-	int subtile_col, subtile_row, subtile_num, new_subtile_num;
-	int pixel_size = bpp / 8;
-	int byte_x = x * pixel_size;
-	int pos;
-
-	/* Modern platforms that have 4-tiling don't use old bit 6 swizzling */
-	igt_assert_eq(swizzle, I915_BIT_6_SWIZZLE_NONE);
-
-	/*
-	* Where does the 4k tile start (in bytes)?  This is the same for Y and
-	* F so we can use the Y-tile algorithm to get to that point.
-	*/
-	tile_base_pos = (y / TILE_4_HEIGHT) * stride * TILE_4_HEIGHT +
-		4096 * (byte_x / TILE_4_WIDTH);
-
-	/* Find pixel within tile */
-	tile_x = (byte_x % TILE_4_WIDTH);
-	tile_y = y % TILE_4_HEIGHT;
-
-	/* And figure out the subtile within the 4k tile */
-	subtile_col = tile_x / TILE_4_SUBTILE_WIDTH;
-	subtile_row = tile_y / TILE_4_SUBTILE_HEIGHT;
-	subtile_num = subtile_row * 8 + subtile_col;
-
-	/* Swizzle the subtile number according to the bspec diagram */
-	new_subtile_num = tile4_subtile_map[subtile_num];
-
-	/* Calculate new position */
-	pos = tile_base_pos +
-		new_subtile_num * TILE_4_SUBTILE_SIZE +
-		(tile_y % TILE_4_SUBTILE_HEIGHT) * OW_SIZE +
-		tile_x % TILE_4_SUBTILE_WIDTH;
-	igt_assert(pos % pixel_size == 0);
-	pos /= pixel_size;
-
-	return pos;
-}
-
-static void xtiled_pos_to_x_y_linear(int tiled_pos, uint32_t stride,
-				     int swizzle, int bpp, int *x, int *y)
-{
-	int pixel_size = bpp / 8;
-
-	tiled_pos = swizzle_addr(tiled_pos, swizzle);
-
-	untile(tiled_pos, 512, 8, stride, true, x, y);
-	*x /= pixel_size;
-}
-
-static void ytiled_pos_to_x_y_linear(int tiled_pos, uint32_t stride,
-				     int swizzle, int bpp, int *x, int *y)
-{
-	int ow_tile_n;
-	int ow_size = 16;
-	int pixel_size = bpp / 8;
-
-	tiled_pos = swizzle_addr(tiled_pos, swizzle);
-
-	ow_tile_n = tiled_pos / ow_size;
-	untile(ow_tile_n, 128 / ow_size, 32, stride / ow_size, false, x, y);
-	*x *= ow_size;
-	*x += tiled_pos % ow_size;
-	*x /= pixel_size;
-}
-
-static void tile4_pos_to_x_y_linear(int tiled_pos, uint32_t stride,
-				    int swizzle, int bpp, int *x, int *y)
-{
-	int pixel_size = bpp / 8;
-	int tiles_per_line = stride / TILE_4_WIDTH;
-	int tile_num, tile_offset, tile_row, tile_col;
-	int tile_origin_x, tile_origin_y;
-	int subtile_num, subtile_offset, subtile_row, subtile_col;
-	int subtile_origin_x, subtile_origin_y;
-	int oword_num, byte_num;
-
-	/* Modern platforms that have 4-tiling don't use old bit 6 swizzling */
-	igt_assert_eq(swizzle, I915_BIT_6_SWIZZLE_NONE);
-
-	/* Calculate the x,y of the start of the 4k tile */
-	tile_num = tiled_pos / 4096;
-	tile_row = tile_num / tiles_per_line;
-	tile_col = tile_num % tiles_per_line;
-	tile_origin_x = tile_col * TILE_4_WIDTH;
-	tile_origin_y = tile_row * TILE_4_HEIGHT;
-
-	/* Now calculate the x,y offset of the start of the subtile */
-	tile_offset = tiled_pos % 4096;
-	subtile_num = tile4_subtile_map[tile_offset / TILE_4_SUBTILE_SIZE];
-	subtile_row = subtile_num / 8;
-	subtile_col = subtile_num % 8;
-	subtile_origin_x = subtile_col * TILE_4_SUBTILE_WIDTH;
-	subtile_origin_y = subtile_row * TILE_4_SUBTILE_HEIGHT;
-
-	/* Next the oword and byte within the subtile */
-	subtile_offset = tiled_pos % TILE_4_SUBTILE_SIZE;
-	oword_num = subtile_offset / OW_SIZE;
-	byte_num = subtile_offset % OW_SIZE;
-
-	*x = (tile_origin_x + subtile_origin_x + byte_num) / pixel_size;
-	*y = tile_origin_y + subtile_origin_y + oword_num;
-}
-
 static void set_pixel(void *_ptr, int index, uint32_t color, int bpp)
 {
 	if (bpp == 16) {
@@ -411,29 +164,23 @@ static void draw_rect_ptr_tiled(void *ptr, uint32_t stride, uint32_t tiling,
 				int swizzle, struct rect *rect, uint32_t color,
 				int bpp)
 {
-	int x, y, pos;
+	int pixel_size = bpp / 8;
+	struct igt_tiling *t;
+	uint8_t *line;
+	int i;
 
-	for (y = rect->y; y < rect->y + rect->h; y++) {
-		for (x = rect->x; x < rect->x + rect->w; x++) {
-			switch (tiling) {
-			case I915_TILING_X:
-				pos = linear_x_y_to_xtiled_pos(x, y, stride,
-							       swizzle, bpp);
-				break;
-			case I915_TILING_Y:
-				pos = linear_x_y_to_ytiled_pos(x, y, stride,
-							       swizzle, bpp);
-				break;
-			case I915_TILING_4:
-				pos = linear_x_y_to_4tiled_pos(x, y, stride,
-							       swizzle, bpp);
-				break;
-			default:
-				igt_assert(false);
-			}
-			set_pixel(ptr, pos, color, bpp);
-		}
-	}
+	line = malloc(rect->w * pixel_size);
+	igt_assert(line);
+	for (i = 0; i < rect->w; i++)
+		set_pixel(line, i, color, bpp);
+
+	/* Every row of the rectangle is the same line */
+	t = igt_tiling_create_intel(tiling, swizzle, stride);
+	igt_tiling_to_tiled(t, ptr, line, 0, rect->x * pixel_size, rect->y,
+			    rect->w * pixel_size, rect->h);
+	igt_tiling_destroy(t);
+
+	free(line);
 }
 
 static void draw_rect_mmap_cpu(int fd, struct buf_data *buf, struct rect *rect,
@@ -545,69 +292,71 @@ static void draw_rect_pwrite_untiled(int fd, struct buf_data *buf,
 	}
 }
 
+struct pwrite_run {
+	uint64_t offset;
+	uint32_t len;
+};
+
+static int pwrite_run_cmp(const void *a, const void *b)
+{
+	const struct pwrite_run *ra = a, *rb = b;
+
+	return ra->offset < rb->offset ? -1 : ra->offset > rb->offset;
+}
+
 static void draw_rect_pwrite_tiled(int fd, struct buf_data *buf,
 				   uint32_t tiling, struct rect *rect,
 				   uint32_t color, uint32_t swizzle)
 {
-	int i;
-	int tiled_pos, x, y, pixel_size;
+	int pixel_size = buf->bpp / 8;
+	struct pwrite_run *runs, *run = NULL;
+	int i, x, y, count = 0;
+	struct igt_tiling *t;
 	uint8_t tmp[4096];
-	int tmp_used = 0, tmp_size;
-	bool flush_tmp = false;
-	int tmp_start_pos = 0;
-	int pixels_written = 0;
 
 	/* We didn't implement suport for the older tiling methods yet. */
 	igt_require(intel_display_ver(intel_get_drm_devid(fd)) >= 5);
 
-	pixel_size = buf->bpp / 8;
-	tmp_size = sizeof(tmp) / pixel_size;
-
-	/* Instead of doing one pwrite per pixel, we try to group the maximum
-	 * amount of consecutive pixels we can in a single pwrite: that's why we
-	 * use the "tmp" variables. */
-	for (i = 0; i < tmp_size; i++)
+	for (i = 0; i < sizeof(tmp) / pixel_size; i++)
 		set_pixel(tmp, i, color, buf->bpp);
 
-	for (tiled_pos = 0; tiled_pos < buf->size; tiled_pos += pixel_size) {
-		switch (tiling) {
-		case I915_TILING_X:
-			xtiled_pos_to_x_y_linear(tiled_pos, buf->stride,
-						 swizzle, buf->bpp, &x, &y);
-			break;
-		case I915_TILING_Y:
-			ytiled_pos_to_x_y_linear(tiled_pos, buf->stride,
-						 swizzle, buf->bpp, &x, &y);
-			break;
-		case I915_TILING_4:
-			tile4_pos_to_x_y_linear(tiled_pos, buf->stride,
-						swizzle, buf->bpp, &x, &y);
-			break;
-		default:
-			igt_assert(false);
-		}
+	/* The runs of pixels of each row that are consecutive when tiled */
+	runs = malloc(sizeof(*runs) * rect->w * rect->h);
+	igt_assert(runs);
 
-		if (x >= rect->x && x < rect->x + rect->w &&
-		    y >= rect->y && y < rect->y + rect->h) {
-			if (tmp_used == 0)
-				tmp_start_pos = tiled_pos;
-			tmp_used++;
-		} else {
-			flush_tmp = true;
+	t = igt_tiling_create_intel(tiling, swizzle, buf->stride);
+	for (y = rect->y; y < rect->y + rect->h; y++) {
+		for (x = rect->x; x < rect->x + rect->w; x++) {
+			uint64_t offset = igt_tiling_offset(t, x * pixel_size, y);
+
+			if (x > rect->x && run->offset + run->len == offset) {
+				run->len += pixel_size;
+			} else {
+				run = &runs[count++];
+				run->offset = offset;
+				run->len = pixel_size;
+			}
 		}
+	}
+	igt_tiling_destroy(t);
 
-		if (tmp_used == tmp_size || (flush_tmp && tmp_used > 0) ||
-		    tiled_pos + pixel_size >= buf->size) {
-			gem_write(fd, buf->handle, tmp_start_pos, tmp,
-				  tmp_used * pixel_size);
-			flush_tmp = false;
-			pixels_written += tmp_used;
-			tmp_used = 0;
+	/* Instead of doing one pwrite per run, we try to group the maximum
+	 * amount of them we can in a single pwrite, in the order they are
+	 * in the buffer: that's why we use the "tmp" buffer. */
+	qsort(runs, count, sizeof(*runs), pwrite_run_cmp);
 
-			if (pixels_written == rect->w * rect->h)
-				break;
-		}
+	for (i = 0; i < count; i++) {
+		struct pwrite_run w = runs[i];
+
+		while (i + 1 < count &&
+		       runs[i + 1].offset == w.offset + w.len &&
+		       w.len + runs[i + 1].len <= sizeof(tmp))
+			w.len += runs[++i].len;
+
+		gem_write(fd, buf->handle, w.offset, tmp, w.len);
 	}
+
+	free(runs);
 }
 
 static void draw_rect_pwrite(int fd, struct buf_data *buf,
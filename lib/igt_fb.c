@@ -27,6 +27,7 @@
  */
 
 #include <stdio.h>
+#include <limits.h>
 #include <math.h>
 #include <wchar.h>
 #include <inttypes.h>
@@ -38,9 +39,11 @@
 #include "igt_aux.h"
 #include "igt_color_encoding.h"
 #include "igt_fb.h"
+#include "igt_fb_cache.h"
 #include "igt_halffloat.h"
 #include "igt_kms.h"
 #include "igt_matrix.h"
+#include "igt_tiling.h"
 #include "igt_vc4.h"
 #include "igt_amd.h"
 #include "igt_x86.h"
@@ -379,6 +382,12 @@ static const struct format_desc_struct *lookup_drm_format(uint32_t drm_format)
 	return NULL;
 }
 
+struct fb_convert_blit_upload;
+static cairo_t *get_cairo_ctx(int fd, struct igt_fb *fb, bool read_in);
+static struct fb_convert_blit_upload *damage_begin(cairo_t *cr);
+static void damage_end(cairo_t *cr, struct fb_convert_blit_upload *blit,
+		       double x1, double y1, double x2, double y2);
+
 /**
  * igt_format_is_yuv_semiplanar:
  * @format: drm fourcc pixel format code
@@ -1477,9 +1486,13 @@ void igt_fb_calc_crc(struct igt_fb *fb, igt_crc_t *crc)
 void igt_paint_color(cairo_t *cr, int x, int y, int w, int h,
 		     double r, double g, double b)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
+
 	cairo_rectangle(cr, x, y, w, h);
 	cairo_set_source_rgb(cr, r, g, b);
 	cairo_fill(cr);
+
+	damage_end(cr, blit, x, y, x + w, y + h);
 }
 
 /**
@@ -1749,9 +1762,13 @@ int igt_fill_cts_color_ramp_framebuffer(uint32_t *pixmap, uint32_t video_width,
 void igt_paint_color_alpha(cairo_t *cr, int x, int y, int w, int h,
 			   double r, double g, double b, double a)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
+
 	cairo_rectangle(cr, x, y, w, h);
 	cairo_set_source_rgba(cr, r, g, b, a);
 	cairo_fill(cr);
+
+	damage_end(cr, blit, x, y, x + w, y + h);
 }
 
 /**
@@ -1772,6 +1789,7 @@ void
 igt_paint_color_gradient(cairo_t *cr, int x, int y, int w, int h,
 			 int r, int g, int b)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
 	cairo_pattern_t *pat;
 
 	pat = cairo_pattern_create_linear(x, y, x + w, y + h);
@@ -1782,6 +1800,8 @@ igt_paint_color_gradient(cairo_t *cr, int x, int y, int w, int h,
 	cairo_set_source(cr, pat);
 	cairo_fill(cr);
 	cairo_pattern_destroy(pat);
+
+	damage_end(cr, blit, x, y, x + w, y + h);
 }
 
 /**
@@ -1806,6 +1826,7 @@ igt_paint_color_gradient_range(cairo_t *cr, int x, int y, int w, int h,
 			       double sr, double sg, double sb,
 			       double er, double eg, double eb)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
 	cairo_pattern_t *pat;
 
 	pat = cairo_pattern_create_linear(x, y, x + w, y + h);
@@ -1816,6 +1837,8 @@ igt_paint_color_gradient_range(cairo_t *cr, int x, int y, int w, int h,
 	cairo_set_source(cr, pat);
 	cairo_fill(cr);
 	cairo_pattern_destroy(pat);
+
+	damage_end(cr, blit, x, y, x + w, y + h);
 }
 
 static void
@@ -1859,7 +1882,9 @@ paint_test_patterns(cairo_t *cr, int width, int height)
 int igt_cairo_printf_line(cairo_t *cr, enum igt_text_align align,
 				double yspacing, const char *fmt, ...)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
 	double x, y, xofs, yofs;
+	double x1, y1, x2, y2;
 	cairo_text_extents_t extents;
 	char *text;
 	va_list ap;
@@ -1888,11 +1913,14 @@ int igt_cairo_printf_line(cairo_t *cr, enum igt_text_align align,
 		cairo_rel_move_to(cr, xofs, yofs);
 
 	cairo_text_path(cr, text);
+	cairo_stroke_extents(cr, &x1, &y1, &x2, &y2);
 	cairo_set_source_rgb(cr, 0, 0, 0);
 	cairo_stroke_preserve(cr);
 	cairo_set_source_rgb(cr, 1, 1, 1);
 	cairo_fill(cr);
 
+	damage_end(cr, blit, x1, y1, x2, y2);
+
 	cairo_move_to(cr, x, y + extents.height + yspacing);
 
 	free(text);
@@ -1903,6 +1931,7 @@ int igt_cairo_printf_line(cairo_t *cr, enum igt_text_align align,
 static void
 paint_marker(cairo_t *cr, int x, int y)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
 	enum igt_text_align align;
 	int xoff, yoff;
 
@@ -1919,6 +1948,8 @@ paint_marker(cairo_t *cr, int x, int y)
 	cairo_set_line_width(cr, 2);
 	cairo_stroke(cr);
 
+	damage_end(cr, blit, x - 22, y - 22, x + 22, y + 22);
+
 	xoff = x ? -20 : 20;
 	align = x ? align_right : align_left;
 
@@ -1946,6 +1977,8 @@ paint_marker(cairo_t *cr, int x, int y)
  */
 void igt_paint_test_pattern(cairo_t *cr, int width, int height)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
+
 	paint_test_patterns(cr, width, height);
 
 	cairo_set_line_cap(cr, CAIRO_LINE_CAP_SQUARE);
@@ -1956,6 +1989,9 @@ void igt_paint_test_pattern(cairo_t *cr, int width, int height)
 	paint_marker(cr, 0, height);
 	paint_marker(cr, width, height);
 
+	/* The markers stick out of the visible area */
+	damage_end(cr, blit, -22, -22, width + 22, height + 22);
+
 	igt_assert(!cairo_status(cr));
 }
 
@@ -1995,6 +2031,7 @@ cairo_surface_t *igt_cairo_image_surface_create_from_png(const char *filename)
 void igt_paint_image(cairo_t *cr, const char *filename,
 		     int dst_x, int dst_y, int dst_width, int dst_height)
 {
+	struct fb_convert_blit_upload *blit = damage_begin(cr);
 	cairo_surface_t *image;
 	int img_width, img_height;
 	double scale_x, scale_y;
@@ -2018,6 +2055,9 @@ void igt_paint_image(cairo_t *cr, const char *filename,
 	cairo_surface_destroy(image);
 
 	cairo_restore(cr);
+
+	damage_end(cr, blit, dst_x, dst_y,
+		   dst_x + dst_width, dst_y + dst_height);
 }
 
 /**
@@ -2130,6 +2170,8 @@ unsigned int igt_create_fb(int fd, int width, int height, uint32_t format,
  *
  * Compared to igt_create_fb() this function also fills the entire framebuffer
  * with the given color, which is useful for some simple pipe crc based tests.
+ * The contents are only drawn once for a given format and size, see
+ * igt_fb_load_cached().
  *
  * Returns:
  * The kms id of the created framebuffer on success or a negative error code on
@@ -2142,14 +2184,21 @@ unsigned int igt_create_color_fb(int fd, int width, int height,
 {
 	unsigned int fb_id;
 	cairo_t *cr;
+	char pattern[128];
 
 	fb_id = igt_create_fb(fd, width, height, format, modifier, fb);
 	igt_assert(fb_id);
 
-	cr = igt_get_cairo_ctx(fd, fb);
+	snprintf(pattern, sizeof(pattern), "color %a %a %a", r, g, b);
+	if (igt_fb_load_cached(fb, pattern))
+		return fb_id;
+
+	cr = get_cairo_ctx(fd, fb, false);
 	igt_paint_color(cr, 0, 0, width, height, r, g, b);
 	igt_put_cairo_ctx(cr);
 
+	igt_fb_save_cached(fb, pattern);
+
 	return fb_id;
 }
 
@@ -2168,6 +2217,8 @@ unsigned int igt_create_color_fb(int fd, int width, int height,
  *
  * Compared to igt_create_fb() this function also draws the standard test pattern
  * into the framebuffer.
+ * The contents are only drawn once for a given format and size, see
+ * igt_fb_load_cached().
  *
  * Returns:
  * The kms id of the created framebuffer on success or a negative error code on
@@ -2183,10 +2234,15 @@ unsigned int igt_create_pattern_fb(int fd, int width, int height,
 	fb_id = igt_create_fb(fd, width, height, format, modifier, fb);
 	igt_assert(fb_id);
 
-	cr = igt_get_cairo_ctx(fd, fb);
+	if (igt_fb_load_cached(fb, "pattern"))
+		return fb_id;
+
+	cr = get_cairo_ctx(fd, fb, false);
 	igt_paint_test_pattern(cr, width, height);
 	igt_put_cairo_ctx(cr);
 
+	igt_fb_save_cached(fb, "pattern");
+
 	return fb_id;
 }
 
@@ -2209,6 +2265,8 @@ unsigned int igt_create_pattern_fb(int fd, int width, int height,
  * Compared to igt_create_fb() this function also fills the entire framebuffer
  * with the given color, and then draws the standard test pattern into the
  * framebuffer.
+ * The contents are only drawn once for a given format and size, see
+ * igt_fb_load_cached().
  *
  * Returns:
  * The kms id of the created framebuffer on success or a negative error code on
@@ -2221,15 +2279,22 @@ unsigned int igt_create_color_pattern_fb(int fd, int width, int height,
 {
 	unsigned int fb_id;
 	cairo_t *cr;
+	char pattern[128];
 
 	fb_id = igt_create_fb(fd, width, height, format, modifier, fb);
 	igt_assert(fb_id);
 
-	cr = igt_get_cairo_ctx(fd, fb);
+	snprintf(pattern, sizeof(pattern), "color-pattern %a %a %a", r, g, b);
+	if (igt_fb_load_cached(fb, pattern))
+		return fb_id;
+
+	cr = get_cairo_ctx(fd, fb, false);
 	igt_paint_color(cr, 0, 0, width, height, r, g, b);
 	igt_paint_test_pattern(cr, width, height);
 	igt_put_cairo_ctx(cr);
 
+	igt_fb_save_cached(fb, pattern);
+
 	return fb_id;
 }
 
@@ -2499,6 +2564,15 @@ static bool use_blitter(const struct igt_fb *fb)
 	       !gem_has_mappable_ggtt(fb->fd);
 }
 
+/* Whether the CPU can only access @fb through a linear copy */
+static bool use_linear_copy(const struct igt_fb *fb)
+{
+	return use_blitter(fb) || use_enginecopy(fb) ||
+	       igt_vc4_is_tiled(fb->modifier) ||
+	       igt_amd_is_tiled(fb->modifier) ||
+	       is_nouveau_device(fb->fd);
+}
+
 static void init_buf_ccs(struct intel_buf *buf, int ccs_idx,
 			 uint32_t offset, uint32_t stride)
 {
@@ -2761,13 +2835,13 @@ static void free_linear_mapping(struct fb_blit_upload *blit)
 	if (igt_vc4_is_tiled(fb->modifier)) {
 		void *map = igt_vc4_mmap_bo(fd, fb->gem_handle, fb->size, PROT_WRITE);
 
-		vc4_fb_convert_plane_to_tiled(fb, map, &linear->fb, &linear->map);
+		igt_tiling_convert_fb(fb, map, &linear->fb, linear->map);
 
 		munmap(map, fb->size);
 	} else if (igt_amd_is_tiled(fb->modifier)) {
 		void *map = igt_amd_mmap_bo(fd, fb->gem_handle, fb->size, PROT_WRITE);
 
-		igt_amd_fb_convert_plane_to_tiled(fb, map, &linear->fb, linear->map);
+		igt_tiling_convert_fb(fb, map, &linear->fb, linear->map);
 
 		munmap(map, fb->size);
 	} else if (is_nouveau_device(fd)) {
@@ -2836,13 +2910,19 @@ static void setup_linear_mapping(struct fb_blit_upload *blit)
 					      linear->fb.size,
 					      PROT_READ | PROT_WRITE);
 
-		vc4_fb_convert_plane_from_tiled(&linear->fb, &linear->map, fb, map);
+		igt_tiling_convert_fb(&linear->fb, linear->map, fb, map);
 
 		munmap(map, fb->size);
 	} else if (igt_amd_is_tiled(fb->modifier)) {
+		void *map = igt_amd_mmap_bo(fd, fb->gem_handle, fb->size, PROT_READ);
+
 		linear->map = igt_amd_mmap_bo(fd, linear->fb.gem_handle,
 					      linear->fb.size,
 					      PROT_READ | PROT_WRITE);
+
+		igt_tiling_convert_fb(&linear->fb, linear->map, fb, map);
+
+		munmap(map, fb->size);
 	} else if (is_nouveau_device(fd)) {
 		/* Currently we also blit linear bos instead of mapping them as-is, as mmap() on
 		 * nouveau is quite slow right now
@@ -2986,6 +3066,14 @@ struct fb_convert_blit_upload {
 
 	struct igt_fb shadow_fb;
 	uint8_t *shadow_ptr;
+
+	/*
+	 * What was drawn into the shadow buffer, in pixels, as long as only
+	 * the contexts from get_cairo_ctx() and the igt_paint helpers draw.
+	 */
+	bool track_damage;
+	int contexts;
+	int damage_x1, damage_y1, damage_x2, damage_y2;
 };
 
 static void *igt_fb_create_cairo_shadow_buffer(int fd,
@@ -3023,21 +3111,6 @@ static uint8_t clamprgb(float val)
 	return clamp((int)(val + 0.5f), 0, 255);
 }
 
-static void read_rgb(struct igt_vec4 *rgb, const uint8_t *rgb24)
-{
-	rgb->d[0] = rgb24[2];
-	rgb->d[1] = rgb24[1];
-	rgb->d[2] = rgb24[0];
-	rgb->d[3] = 1.0f;
-}
-
-static void write_rgb(uint8_t *rgb24, const struct igt_vec4 *rgb)
-{
-	rgb24[2] = clamprgb(rgb->d[0]);
-	rgb24[1] = clamprgb(rgb->d[1]);
-	rgb24[0] = clamprgb(rgb->d[2]);
-}
-
 struct fb_convert_buf {
 	void			*ptr;
 	struct igt_fb		*fb;
@@ -3065,7 +3138,7 @@ static void *convert_src_get(const struct fb_convert *cvt)
 	if (!buf)
 		return cvt->src.ptr;
 
-	igt_memcpy_from_wc(buf, cvt->src.ptr, cvt->src.fb->size);
+	igt_memcpy_from_wc_parallel(buf, cvt->src.ptr, cvt->src.fb->size);
 
 	return buf;
 }
@@ -3077,801 +3150,504 @@ static void convert_src_put(const struct fb_convert *cvt,
 		free(src_buf);
 }
 
-struct yuv_parameters {
-	unsigned	ay_inc;
-	unsigned	uv_inc;
-	unsigned	ay_stride;
-	unsigned	uv_stride;
-	unsigned	a_offset;
-	unsigned	y_offset;
-	unsigned	u_offset;
-	unsigned	v_offset;
+/*
+ * The converters below are templates, only ever called with a pointer to one
+ * of the constant layouts listed in YUV8_FORMATS and YUV16_FORMATS. Inlined
+ * in the wrappers generated for each format, the layout folds into constant
+ * strides, subsampling shifts and offsets, which leaves the inner loops
+ * without any branch on the format.
+ */
+#define __convert_template static inline __attribute__((always_inline))
+
+struct yuv_layout {
+	unsigned int hsub, vsub;
+	/* in samples, from a pixel to the next and from a chroma pair to the next */
+	unsigned int ay_inc, uv_inc;
+	unsigned int u_plane, v_plane;
+	/* in bytes, from the start of the plane */
+	unsigned int a, y, u, v;
+	bool alpha;
 };
 
-static void get_yuv_parameters(struct igt_fb *fb, struct yuv_parameters *params)
-{
-	igt_assert(igt_format_is_yuv(fb->drm_format));
-
-	switch (fb->drm_format) {
-	case DRM_FORMAT_NV12:
-	case DRM_FORMAT_NV16:
-	case DRM_FORMAT_NV21:
-	case DRM_FORMAT_NV61:
-	case DRM_FORMAT_P010:
-	case DRM_FORMAT_P012:
-	case DRM_FORMAT_P016:
-		params->ay_inc = 1;
-		params->uv_inc = 2;
-		break;
-
-	case DRM_FORMAT_YUV420:
-	case DRM_FORMAT_YUV422:
-	case DRM_FORMAT_YVU420:
-	case DRM_FORMAT_YVU422:
-		params->ay_inc = 1;
-		params->uv_inc = 1;
-		break;
-
-	case DRM_FORMAT_YUYV:
-	case DRM_FORMAT_YVYU:
-	case DRM_FORMAT_UYVY:
-	case DRM_FORMAT_VYUY:
-	case DRM_FORMAT_Y210:
-	case DRM_FORMAT_Y212:
-	case DRM_FORMAT_Y216:
-		params->ay_inc = 2;
-		params->uv_inc = 4;
-		break;
-
-	case DRM_FORMAT_XVYU12_16161616:
-	case DRM_FORMAT_XVYU16161616:
-	case DRM_FORMAT_Y412:
-	case DRM_FORMAT_Y416:
-	case DRM_FORMAT_XYUV8888:
-		params->ay_inc = 4;
-		params->uv_inc = 4;
-		break;
-	}
-
-	switch (fb->drm_format) {
-	case DRM_FORMAT_NV12:
-	case DRM_FORMAT_NV16:
-	case DRM_FORMAT_NV21:
-	case DRM_FORMAT_NV61:
-	case DRM_FORMAT_YUV420:
-	case DRM_FORMAT_YUV422:
-	case DRM_FORMAT_YVU420:
-	case DRM_FORMAT_YVU422:
-	case DRM_FORMAT_P010:
-	case DRM_FORMAT_P012:
-	case DRM_FORMAT_P016:
-		params->ay_stride = fb->strides[0];
-		params->uv_stride = fb->strides[1];
-		break;
-
-	case DRM_FORMAT_YUYV:
-	case DRM_FORMAT_YVYU:
-	case DRM_FORMAT_UYVY:
-	case DRM_FORMAT_VYUY:
-	case DRM_FORMAT_Y210:
-	case DRM_FORMAT_Y212:
-	case DRM_FORMAT_Y216:
-	case DRM_FORMAT_XYUV8888:
-	case DRM_FORMAT_XVYU12_16161616:
-	case DRM_FORMAT_XVYU16161616:
-	case DRM_FORMAT_Y412:
-	case DRM_FORMAT_Y416:
-		params->ay_stride = fb->strides[0];
-		params->uv_stride = fb->strides[0];
-		break;
-	}
-
-	switch (fb->drm_format) {
-	case DRM_FORMAT_NV12:
-	case DRM_FORMAT_NV16:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[1];
-		params->v_offset = fb->offsets[1] + 1;
-		break;
-
-	case DRM_FORMAT_NV21:
-	case DRM_FORMAT_NV61:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[1] + 1;
-		params->v_offset = fb->offsets[1];
-		break;
-
-	case DRM_FORMAT_YUV420:
-	case DRM_FORMAT_YUV422:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[1];
-		params->v_offset = fb->offsets[2];
-		break;
-
-	case DRM_FORMAT_YVU420:
-	case DRM_FORMAT_YVU422:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[2];
-		params->v_offset = fb->offsets[1];
-		break;
-
-	case DRM_FORMAT_P010:
-	case DRM_FORMAT_P012:
-	case DRM_FORMAT_P016:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[1];
-		params->v_offset = fb->offsets[1] + 2;
-		break;
-
-	case DRM_FORMAT_YUYV:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[0] + 1;
-		params->v_offset = fb->offsets[0] + 3;
-		break;
-
-	case DRM_FORMAT_YVYU:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[0] + 3;
-		params->v_offset = fb->offsets[0] + 1;
-		break;
-
-	case DRM_FORMAT_UYVY:
-		params->y_offset = fb->offsets[0] + 1;
-		params->u_offset = fb->offsets[0];
-		params->v_offset = fb->offsets[0] + 2;
-		break;
-
-	case DRM_FORMAT_VYUY:
-		params->y_offset = fb->offsets[0] + 1;
-		params->u_offset = fb->offsets[0] + 2;
-		params->v_offset = fb->offsets[0];
-		break;
+struct yuv_planes {
+	uint8_t *a, *y, *u, *v;
+	unsigned int ay_stride, uv_stride;
+};
 
-	case DRM_FORMAT_Y210:
-	case DRM_FORMAT_Y212:
-	case DRM_FORMAT_Y216:
-		params->y_offset = fb->offsets[0];
-		params->u_offset = fb->offsets[0] + 2;
-		params->v_offset = fb->offsets[0] + 6;
-		break;
+__convert_template void
+get_yuv_planes(struct yuv_planes *p, const struct yuv_layout *l,
+	       const struct igt_fb *fb, uint8_t *buf)
+{
+	p->a = buf + fb->offsets[0] + l->a;
+	p->y = buf + fb->offsets[0] + l->y;
+	p->u = buf + fb->offsets[l->u_plane] + l->u;
+	p->v = buf + fb->offsets[l->v_plane] + l->v;
+	p->ay_stride = fb->strides[0];
+	p->uv_stride = fb->strides[l->u_plane];
+}
 
-	case DRM_FORMAT_XVYU12_16161616:
-	case DRM_FORMAT_XVYU16161616:
-	case DRM_FORMAT_Y412:
-	case DRM_FORMAT_Y416:
-		params->a_offset = fb->offsets[0] + 6;
-		params->y_offset = fb->offsets[0] + 2;
-		params->u_offset = fb->offsets[0];
-		params->v_offset = fb->offsets[0] + 4;
-		break;
+/*
+ * Row @r of igt_matrix_transform() for (@x, @y, @z, 1), with the same result,
+ * only computing what is needed of the vector.
+ */
+static inline float transform_row(const struct igt_mat4 *m, int r,
+				  float x, float y, float z)
+{
+	return m->d[m(r, 0)] * x + m->d[m(r, 1)] * y +
+	       m->d[m(r, 2)] * z + m->d[m(r, 3)];
+}
 
-	case DRM_FORMAT_XYUV8888:
-		params->y_offset = fb->offsets[0] + 2;
-		params->u_offset = fb->offsets[0] + 1;
-		params->v_offset = fb->offsets[0] + 0;
-		break;
-	}
+/*
+ * We assume the MPEG2 chroma siting convention, where pixel center for Cb'Cr'
+ * is between the left top and bottom pixel in a 2x2 block, so take the
+ * average.
+ *
+ * Therefore, if we use subsampling, we only really care about two pixels all
+ * the time, either the two subsequent pixels horizontally, vertically, or the
+ * two corners in a 2x2 block.
+ *
+ * The only corner case is when we have an odd number of pixels, but this can
+ * be handled pretty easily by pairing the last pixel with itself in the
+ * direction it's odd in.
+ */
+static inline unsigned int pair_offset(unsigned int i, unsigned int sub,
+				       unsigned int size)
+{
+	return min(i + sub - 1, size - 1) - i;
 }
 
-static void convert_yuv_to_rgb24(struct fb_convert *cvt)
+__convert_template void
+yuv_to_rgb24(struct fb_convert *cvt, const struct yuv_layout *l)
 {
-	const struct format_desc_struct *src_fmt =
-		lookup_drm_format(cvt->src.fb->drm_format);
-	int i, j;
-	uint8_t bpp = 4;
-	uint8_t *y, *u, *v;
-	uint8_t *rgb24 = cvt->dst.ptr;
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
 	unsigned int rgb24_stride = cvt->dst.fb->strides[0];
 	struct igt_mat4 m = igt_ycbcr_to_rgb_matrix(cvt->src.fb->drm_format,
 						    cvt->dst.fb->drm_format,
 						    cvt->src.fb->color_encoding,
 						    cvt->src.fb->color_range);
+	struct yuv_planes p;
 	uint8_t *buf;
-	struct yuv_parameters params = { };
 
-	igt_assert(cvt->dst.fb->drm_format == DRM_FORMAT_XRGB8888 &&
-		   igt_format_is_yuv(cvt->src.fb->drm_format));
+	igt_assert(cvt->dst.fb->drm_format == DRM_FORMAT_XRGB8888);
 
 	buf = convert_src_get(cvt);
-	get_yuv_parameters(cvt->src.fb, &params);
-	y = buf + params.y_offset;
-	u = buf + params.u_offset;
-	v = buf + params.v_offset;
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		const uint8_t *y_tmp = y;
-		const uint8_t *u_tmp = u;
-		const uint8_t *v_tmp = v;
-		uint8_t *rgb_tmp = rgb24;
-
-		for (j = 0; j < cvt->dst.fb->width; j++) {
-			struct igt_vec4 rgb, yuv;
-
-			yuv.d[0] = *y_tmp;
-			yuv.d[1] = *u_tmp;
-			yuv.d[2] = *v_tmp;
-			yuv.d[3] = 1.0f;
-
-			rgb = igt_matrix_transform(&m, &yuv);
-			write_rgb(rgb_tmp, &rgb);
-
-			rgb_tmp += bpp;
-			y_tmp += params.ay_inc;
-
-			if ((src_fmt->hsub == 1) || (j % src_fmt->hsub)) {
-				u_tmp += params.uv_inc;
-				v_tmp += params.uv_inc;
-			}
-		}
-
-		rgb24 += rgb24_stride;
-		y += params.ay_stride;
-
-		if ((src_fmt->vsub == 1) || (i % src_fmt->vsub)) {
-			u += params.uv_stride;
-			v += params.uv_stride;
+	get_yuv_planes(&p, l, cvt->src.fb, buf);
+
+	for (unsigned int i = 0; i < height; i++) {
+		const uint8_t *y = p.y + (size_t)i * p.ay_stride;
+		const uint8_t *u = p.u + (size_t)(i / l->vsub) * p.uv_stride;
+		const uint8_t *v = p.v + (size_t)(i / l->vsub) * p.uv_stride;
+		uint8_t *rgb24 = cvt->dst.ptr + (size_t)i * rgb24_stride;
+
+		for (size_t j = 0; j < width; j++) {
+			float Y = y[j * l->ay_inc];
+			float U = u[j / l->hsub * l->uv_inc];
+			float V = v[j / l->hsub * l->uv_inc];
+
+			rgb24[4 * j + 2] = clamprgb(transform_row(&m, 0, Y, U, V));
+			rgb24[4 * j + 1] = clamprgb(transform_row(&m, 1, Y, U, V));
+			rgb24[4 * j + 0] = clamprgb(transform_row(&m, 2, Y, U, V));
 		}
 	}
 
 	convert_src_put(cvt, buf);
 }
 
-static void convert_rgb24_to_yuv(struct fb_convert *cvt)
+__convert_template void
+rgb24_to_yuv(struct fb_convert *cvt, const struct yuv_layout *l)
 {
-	const struct format_desc_struct *dst_fmt =
-		lookup_drm_format(cvt->dst.fb->drm_format);
-	int i, j;
-	uint8_t *y, *u, *v;
-	const uint8_t *rgb24 = cvt->src.ptr;
-	uint8_t bpp = 4;
-	unsigned rgb24_stride = cvt->src.fb->strides[0];
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int rgb24_stride = cvt->src.fb->strides[0];
 	struct igt_mat4 m = igt_rgb_to_ycbcr_matrix(cvt->src.fb->drm_format,
 						    cvt->dst.fb->drm_format,
 						    cvt->dst.fb->color_encoding,
 						    cvt->dst.fb->color_range);
-	struct yuv_parameters params = { };
-
-	igt_assert(cvt->src.fb->drm_format == DRM_FORMAT_XRGB8888 &&
-		   igt_format_is_yuv(cvt->dst.fb->drm_format));
-
-	get_yuv_parameters(cvt->dst.fb, &params);
-	y = cvt->dst.ptr + params.y_offset;
-	u = cvt->dst.ptr + params.u_offset;
-	v = cvt->dst.ptr + params.v_offset;
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		const uint8_t *rgb_tmp = rgb24;
-		uint8_t *y_tmp = y;
-		uint8_t *u_tmp = u;
-		uint8_t *v_tmp = v;
-
-		for (j = 0; j < cvt->dst.fb->width; j++) {
-			const uint8_t *pair_rgb24 = rgb_tmp;
-			struct igt_vec4 pair_rgb, rgb;
-			struct igt_vec4 pair_yuv, yuv;
-
-			read_rgb(&rgb, rgb_tmp);
-			yuv = igt_matrix_transform(&m, &rgb);
-
-			rgb_tmp += bpp;
-
-			*y_tmp = yuv.d[0];
-			y_tmp += params.ay_inc;
-
-			if ((i % dst_fmt->vsub) || (j % dst_fmt->hsub))
-				continue;
-
-			/*
-			 * We assume the MPEG2 chroma siting convention, where
-			 * pixel center for Cb'Cr' is between the left top and
-			 * bottom pixel in a 2x2 block, so take the average.
-			 *
-			 * Therefore, if we use subsampling, we only really care
-			 * about two pixels all the time, either the two
-			 * subsequent pixels horizontally, vertically, or the
-			 * two corners in a 2x2 block.
-			 *
-			 * The only corner case is when we have an odd number of
-			 * pixels, but this can be handled pretty easily by not
-			 * incrementing the paired pixel pointer in the
-			 * direction it's odd in.
-			 */
-			if (j != (cvt->dst.fb->width - 1))
-				pair_rgb24 += (dst_fmt->hsub - 1) * bpp;
-
-			if (i != (cvt->dst.fb->height - 1))
-				pair_rgb24 += rgb24_stride * (dst_fmt->vsub - 1);
-
-			read_rgb(&pair_rgb, pair_rgb24);
-			pair_yuv = igt_matrix_transform(&m, &pair_rgb);
-
-			*u_tmp = (yuv.d[1] + pair_yuv.d[1]) / 2.0f;
-			*v_tmp = (yuv.d[2] + pair_yuv.d[2]) / 2.0f;
-
-			u_tmp += params.uv_inc;
-			v_tmp += params.uv_inc;
-		}
+	struct yuv_planes p;
 
-		rgb24 += rgb24_stride;
-		y += params.ay_stride;
+	igt_assert(cvt->src.fb->drm_format == DRM_FORMAT_XRGB8888);
 
-		if ((i % dst_fmt->vsub) == (dst_fmt->vsub - 1)) {
-			u += params.uv_stride;
-			v += params.uv_stride;
-		}
-	}
-}
+	get_yuv_planes(&p, l, cvt->dst.fb, cvt->dst.ptr);
 
-static void read_rgbf(struct igt_vec4 *rgb, const float *rgb24)
-{
-	rgb->d[0] = rgb24[0];
-	rgb->d[1] = rgb24[1];
-	rgb->d[2] = rgb24[2];
-	rgb->d[3] = 1.0f;
-}
+	for (unsigned int i = 0; i < height; i++) {
+		const uint8_t *rgb24 = cvt->src.ptr + (size_t)i * rgb24_stride;
+		const uint8_t *pair_rgb24 = rgb24 +
+			pair_offset(i, l->vsub, height) * rgb24_stride;
+		uint8_t *y = p.y + (size_t)i * p.ay_stride;
+		uint8_t *u = p.u + (size_t)(i / l->vsub) * p.uv_stride;
+		uint8_t *v = p.v + (size_t)(i / l->vsub) * p.uv_stride;
 
-static void write_rgbf(float *rgb24, const struct igt_vec4 *rgb)
-{
-	rgb24[0] = rgb->d[0];
-	rgb24[1] = rgb->d[1];
-	rgb24[2] = rgb->d[2];
+		for (size_t j = 0; j < width; j++)
+			y[j * l->ay_inc] = transform_row(&m, 0, rgb24[4 * j + 2],
+							 rgb24[4 * j + 1],
+							 rgb24[4 * j + 0]);
+
+		if (i % l->vsub)
+			continue;
+
+		for (size_t j = 0; j < width; j += l->hsub) {
+			const uint8_t *a = &rgb24[4 * j];
+			const uint8_t *b = &pair_rgb24[4 * (j + pair_offset(j, l->hsub, width))];
+			float cb = transform_row(&m, 1, a[2], a[1], a[0]);
+			float cr = transform_row(&m, 2, a[2], a[1], a[0]);
+
+			if (l->hsub > 1 || l->vsub > 1) {
+				cb = (cb + transform_row(&m, 1, b[2], b[1], b[0])) / 2.0f;
+				cr = (cr + transform_row(&m, 2, b[2], b[1], b[0])) / 2.0f;
+			}
+
+			u[j / l->hsub * l->uv_inc] = cb;
+			v[j / l->hsub * l->uv_inc] = cr;
+		}
+	}
 }
 
-static void convert_yuv16_to_float(struct fb_convert *cvt, bool alpha)
+__convert_template void
+yuv16_to_float(struct fb_convert *cvt, const struct yuv_layout *l)
 {
-	const struct format_desc_struct *src_fmt =
-		lookup_drm_format(cvt->src.fb->drm_format);
-	int i, j;
-	uint8_t fpp = alpha ? 4 : 3;
-	uint16_t *a, *y, *u, *v;
-	float *ptr = cvt->dst.ptr;
-	unsigned int float_stride = cvt->dst.fb->strides[0] / sizeof(*ptr);
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int fpp = l->alpha ? 4 : 3;
+	unsigned int float_stride = cvt->dst.fb->strides[0];
 	struct igt_mat4 m = igt_ycbcr_to_rgb_matrix(cvt->src.fb->drm_format,
 						    cvt->dst.fb->drm_format,
 						    cvt->src.fb->color_encoding,
 						    cvt->src.fb->color_range);
-	uint16_t *buf;
-	struct yuv_parameters params = { };
+	struct yuv_planes p;
+	uint8_t *buf;
 
-	igt_assert(cvt->dst.fb->drm_format == IGT_FORMAT_FLOAT &&
-		   igt_format_is_yuv(cvt->src.fb->drm_format));
+	igt_assert(cvt->dst.fb->drm_format == IGT_FORMAT_FLOAT);
 
 	buf = convert_src_get(cvt);
-	get_yuv_parameters(cvt->src.fb, &params);
-	igt_assert(!(params.y_offset % sizeof(*buf)) &&
-		   !(params.u_offset % sizeof(*buf)) &&
-		   !(params.v_offset % sizeof(*buf)));
-
-	a = buf + params.a_offset / sizeof(*buf);
-	y = buf + params.y_offset / sizeof(*buf);
-	u = buf + params.u_offset / sizeof(*buf);
-	v = buf + params.v_offset / sizeof(*buf);
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		const uint16_t *a_tmp = a;
-		const uint16_t *y_tmp = y;
-		const uint16_t *u_tmp = u;
-		const uint16_t *v_tmp = v;
-		float *rgb_tmp = ptr;
-
-		for (j = 0; j < cvt->dst.fb->width; j++) {
-			struct igt_vec4 rgb, yuv;
-
-			yuv.d[0] = *y_tmp;
-			yuv.d[1] = *u_tmp;
-			yuv.d[2] = *v_tmp;
-			yuv.d[3] = 1.0f;
-
-			rgb = igt_matrix_transform(&m, &yuv);
-			write_rgbf(rgb_tmp, &rgb);
-
-			if (alpha) {
-				rgb_tmp[3] = ((float)*a_tmp) / 65535.f;
-				a_tmp += params.ay_inc;
-			}
-
-			rgb_tmp += fpp;
-			y_tmp += params.ay_inc;
-
-			if ((src_fmt->hsub == 1) || (j % src_fmt->hsub)) {
-				u_tmp += params.uv_inc;
-				v_tmp += params.uv_inc;
-			}
-		}
-
-		ptr += float_stride;
-
-		a += params.ay_stride / sizeof(*a);
-		y += params.ay_stride / sizeof(*y);
-
-		if ((src_fmt->vsub == 1) || (i % src_fmt->vsub)) {
-			u += params.uv_stride / sizeof(*u);
-			v += params.uv_stride / sizeof(*v);
+	get_yuv_planes(&p, l, cvt->src.fb, buf);
+
+	for (unsigned int i = 0; i < height; i++) {
+		const uint16_t *a = (const uint16_t *)(p.a + (size_t)i * p.ay_stride);
+		const uint16_t *y = (const uint16_t *)(p.y + (size_t)i * p.ay_stride);
+		const uint16_t *u = (const uint16_t *)(p.u + (size_t)(i / l->vsub) * p.uv_stride);
+		const uint16_t *v = (const uint16_t *)(p.v + (size_t)(i / l->vsub) * p.uv_stride);
+		float *rgb = cvt->dst.ptr + (size_t)i * float_stride;
+
+		for (size_t j = 0; j < width; j++) {
+			float Y = y[j * l->ay_inc];
+			float U = u[j / l->hsub * l->uv_inc];
+			float V = v[j / l->hsub * l->uv_inc];
+
+			rgb[fpp * j + 0] = transform_row(&m, 0, Y, U, V);
+			rgb[fpp * j + 1] = transform_row(&m, 1, Y, U, V);
+			rgb[fpp * j + 2] = transform_row(&m, 2, Y, U, V);
+			if (l->alpha)
+				rgb[fpp * j + 3] = ((float)a[j * l->ay_inc]) / 65535.f;
 		}
 	}
 
 	convert_src_put(cvt, buf);
 }
 
-static void convert_float_to_yuv16(struct fb_convert *cvt, bool alpha)
+__convert_template void
+float_to_yuv16(struct fb_convert *cvt, const struct yuv_layout *l)
 {
-	const struct format_desc_struct *dst_fmt =
-		lookup_drm_format(cvt->dst.fb->drm_format);
-	int i, j;
-	uint16_t *a, *y, *u, *v;
-	const float *ptr = cvt->src.ptr;
-	uint8_t fpp = alpha ? 4 : 3;
-	unsigned float_stride = cvt->src.fb->strides[0] / sizeof(*ptr);
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int fpp = l->alpha ? 4 : 3;
+	unsigned int float_stride = cvt->src.fb->strides[0];
 	struct igt_mat4 m = igt_rgb_to_ycbcr_matrix(cvt->src.fb->drm_format,
 						    cvt->dst.fb->drm_format,
 						    cvt->dst.fb->color_encoding,
 						    cvt->dst.fb->color_range);
-	struct yuv_parameters params = { };
-
-	igt_assert(cvt->src.fb->drm_format == IGT_FORMAT_FLOAT &&
-		   igt_format_is_yuv(cvt->dst.fb->drm_format));
-
-	get_yuv_parameters(cvt->dst.fb, &params);
-	igt_assert(!(params.a_offset % sizeof(*a)) &&
-		   !(params.y_offset % sizeof(*y)) &&
-		   !(params.u_offset % sizeof(*u)) &&
-		   !(params.v_offset % sizeof(*v)));
-
-	a = cvt->dst.ptr + params.a_offset;
-	y = cvt->dst.ptr + params.y_offset;
-	u = cvt->dst.ptr + params.u_offset;
-	v = cvt->dst.ptr + params.v_offset;
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		const float *rgb_tmp = ptr;
-		uint16_t *a_tmp = a;
-		uint16_t *y_tmp = y;
-		uint16_t *u_tmp = u;
-		uint16_t *v_tmp = v;
-
-		for (j = 0; j < cvt->dst.fb->width; j++) {
-			const float *pair_float = rgb_tmp;
-			struct igt_vec4 pair_rgb, rgb;
-			struct igt_vec4 pair_yuv, yuv;
-
-			read_rgbf(&rgb, rgb_tmp);
-			yuv = igt_matrix_transform(&m, &rgb);
-
-			if (alpha) {
-				*a_tmp = rgb_tmp[3] * 65535.f + .5f;
-				a_tmp += params.ay_inc;
-			}
+	struct yuv_planes p;
+
+	igt_assert(cvt->src.fb->drm_format == IGT_FORMAT_FLOAT);
+
+	get_yuv_planes(&p, l, cvt->dst.fb, cvt->dst.ptr);
 
-			rgb_tmp += fpp;
-
-			*y_tmp = yuv.d[0];
-			y_tmp += params.ay_inc;
-
-			if ((i % dst_fmt->vsub) || (j % dst_fmt->hsub))
-				continue;
-
-			/*
-			 * We assume the MPEG2 chroma siting convention, where
-			 * pixel center for Cb'Cr' is between the left top and
-			 * bottom pixel in a 2x2 block, so take the average.
-			 *
-			 * Therefore, if we use subsampling, we only really care
-			 * about two pixels all the time, either the two
-			 * subsequent pixels horizontally, vertically, or the
-			 * two corners in a 2x2 block.
-			 *
-			 * The only corner case is when we have an odd number of
-			 * pixels, but this can be handled pretty easily by not
-			 * incrementing the paired pixel pointer in the
-			 * direction it's odd in.
-			 */
-			if (j != (cvt->dst.fb->width - 1))
-				pair_float += (dst_fmt->hsub - 1) * fpp;
-
-			if (i != (cvt->dst.fb->height - 1))
-				pair_float += float_stride * (dst_fmt->vsub - 1);
-
-			read_rgbf(&pair_rgb, pair_float);
-			pair_yuv = igt_matrix_transform(&m, &pair_rgb);
-
-			*u_tmp = (yuv.d[1] + pair_yuv.d[1]) / 2.0f;
-			*v_tmp = (yuv.d[2] + pair_yuv.d[2]) / 2.0f;
-
-			u_tmp += params.uv_inc;
-			v_tmp += params.uv_inc;
+	for (unsigned int i = 0; i < height; i++) {
+		const float *rgb = cvt->src.ptr + (size_t)i * float_stride;
+		const float *pair_rgb = (const void *)rgb +
+			pair_offset(i, l->vsub, height) * float_stride;
+		uint16_t *a = (uint16_t *)(p.a + (size_t)i * p.ay_stride);
+		uint16_t *y = (uint16_t *)(p.y + (size_t)i * p.ay_stride);
+		uint16_t *u = (uint16_t *)(p.u + (size_t)(i / l->vsub) * p.uv_stride);
+		uint16_t *v = (uint16_t *)(p.v + (size_t)(i / l->vsub) * p.uv_stride);
+
+		for (size_t j = 0; j < width; j++) {
+			const float *f = &rgb[fpp * j];
+
+			y[j * l->ay_inc] = transform_row(&m, 0, f[0], f[1], f[2]);
+			if (l->alpha)
+				a[j * l->ay_inc] = f[3] * 65535.f + .5f;
 		}
 
-		ptr += float_stride;
-		a += params.ay_stride / sizeof(*a);
-		y += params.ay_stride / sizeof(*y);
+		if (i % l->vsub)
+			continue;
+
+		for (size_t j = 0; j < width; j += l->hsub) {
+			const float *f = &rgb[fpp * j];
+			const float *g = &pair_rgb[fpp * (j + pair_offset(j, l->hsub, width))];
+			float cb = transform_row(&m, 1, f[0], f[1], f[2]);
+			float cr = transform_row(&m, 2, f[0], f[1], f[2]);
+
+			if (l->hsub > 1 || l->vsub > 1) {
+				cb = (cb + transform_row(&m, 1, g[0], g[1], g[2])) / 2.0f;
+				cr = (cr + transform_row(&m, 2, g[0], g[1], g[2])) / 2.0f;
+			}
 
-		if ((i % dst_fmt->vsub) == (dst_fmt->vsub - 1)) {
-			u += params.uv_stride / sizeof(*u);
-			v += params.uv_stride / sizeof(*v);
+			u[j / l->hsub * l->uv_inc] = cb;
+			v[j / l->hsub * l->uv_inc] = cr;
 		}
 	}
 }
 
-static void convert_Y410_to_float(struct fb_convert *cvt, bool alpha)
+__convert_template void
+Y410_to_float(struct fb_convert *cvt, bool alpha)
 {
-	int i, j;
-	const uint32_t *uyv;
-	uint32_t *buf;
-	float *ptr = cvt->dst.ptr;
-	unsigned int float_stride = cvt->dst.fb->strides[0] / sizeof(*ptr);
-	unsigned int uyv_stride = cvt->src.fb->strides[0] / sizeof(*uyv);
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int fpp = alpha ? 4 : 3;
+	unsigned int float_stride = cvt->dst.fb->strides[0];
+	unsigned int uyv_stride = cvt->src.fb->strides[0];
 	struct igt_mat4 m = igt_ycbcr_to_rgb_matrix(cvt->src.fb->drm_format,
 						    cvt->dst.fb->drm_format,
 						    cvt->src.fb->color_encoding,
 						    cvt->src.fb->color_range);
-	unsigned bpp = alpha ? 4 : 3;
-
-	igt_assert((cvt->src.fb->drm_format == DRM_FORMAT_Y410 ||
-		    cvt->src.fb->drm_format == DRM_FORMAT_XVYU2101010) &&
-		   cvt->dst.fb->drm_format == IGT_FORMAT_FLOAT);
+	uint8_t *buf;
 
-	uyv = buf = convert_src_get(cvt);
+	igt_assert(cvt->dst.fb->drm_format == IGT_FORMAT_FLOAT);
 
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		for (j = 0; j < cvt->dst.fb->width; j++) {
-			/* Convert 2x1 pixel blocks */
-			struct igt_vec4 yuv;
-			struct igt_vec4 rgb;
+	buf = convert_src_get(cvt);
 
-			yuv.d[0] = (uyv[j] >> 10) & 0x3ff;
-			yuv.d[1] = uyv[j] & 0x3ff;
-			yuv.d[2] = (uyv[j] >> 20) & 0x3ff;
-			yuv.d[3] = 1.f;
+	for (unsigned int i = 0; i < height; i++) {
+		const uint32_t *uyv = (const uint32_t *)(buf + (size_t)i * uyv_stride);
+		float *rgb = cvt->dst.ptr + (size_t)i * float_stride;
 
-			rgb = igt_matrix_transform(&m, &yuv);
+		for (size_t j = 0; j < width; j++) {
+			float Y = (uyv[j] >> 10) & 0x3ff;
+			float U = uyv[j] & 0x3ff;
+			float V = (uyv[j] >> 20) & 0x3ff;
 
-			write_rgbf(&ptr[j * bpp], &rgb);
+			rgb[fpp * j + 0] = transform_row(&m, 0, Y, U, V);
+			rgb[fpp * j + 1] = transform_row(&m, 1, Y, U, V);
+			rgb[fpp * j + 2] = transform_row(&m, 2, Y, U, V);
 			if (alpha)
-				ptr[j * bpp + 3] = (float)(uyv[j] >> 30) / 3.f;
+				rgb[fpp * j + 3] = (float)(uyv[j] >> 30) / 3.f;
 		}
-
-		ptr += float_stride;
-		uyv += uyv_stride;
 	}
 
 	convert_src_put(cvt, buf);
 }
 
-static void convert_float_to_Y410(struct fb_convert *cvt, bool alpha)
+__convert_template void
+float_to_Y410(struct fb_convert *cvt, bool alpha)
 {
-	int i, j;
-	uint32_t *uyv = cvt->dst.ptr;
-	const float *ptr = cvt->src.ptr;
-	unsigned float_stride = cvt->src.fb->strides[0] / sizeof(*ptr);
-	unsigned uyv_stride = cvt->dst.fb->strides[0] / sizeof(*uyv);
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int fpp = alpha ? 4 : 3;
+	unsigned int float_stride = cvt->src.fb->strides[0];
+	unsigned int uyv_stride = cvt->dst.fb->strides[0];
 	struct igt_mat4 m = igt_rgb_to_ycbcr_matrix(cvt->src.fb->drm_format,
 						    cvt->dst.fb->drm_format,
 						    cvt->dst.fb->color_encoding,
 						    cvt->dst.fb->color_range);
-	unsigned bpp = alpha ? 4 : 3;
 
-	igt_assert(cvt->src.fb->drm_format == IGT_FORMAT_FLOAT &&
-		   (cvt->dst.fb->drm_format == DRM_FORMAT_Y410 ||
-		    cvt->dst.fb->drm_format == DRM_FORMAT_XVYU2101010));
+	igt_assert(cvt->src.fb->drm_format == IGT_FORMAT_FLOAT);
 
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		for (j = 0; j < cvt->dst.fb->width; j++) {
-			struct igt_vec4 rgb;
-			struct igt_vec4 yuv;
-			uint8_t a = 0;
-			uint16_t y, cb, cr;
+	for (unsigned int i = 0; i < height; i++) {
+		const float *rgb = cvt->src.ptr + (size_t)i * float_stride;
+		uint32_t *uyv = cvt->dst.ptr + (size_t)i * uyv_stride;
 
-			read_rgbf(&rgb, &ptr[j * bpp]);
-			if (alpha)
-				 a = ptr[j * bpp + 3] * 3.f + .5f;
-
-			yuv = igt_matrix_transform(&m, &rgb);
-			y = yuv.d[0];
-			cb = yuv.d[1];
-			cr = yuv.d[2];
+		for (size_t j = 0; j < width; j++) {
+			const float *f = &rgb[fpp * j];
+			uint16_t y = transform_row(&m, 0, f[0], f[1], f[2]);
+			uint16_t cb = transform_row(&m, 1, f[0], f[1], f[2]);
+			uint16_t cr = transform_row(&m, 2, f[0], f[1], f[2]);
+			uint8_t a = alpha ? (uint8_t)(f[3] * 3.f + .5f) : 0;
 
 			uyv[j] = ((cb & 0x3ff) << 0) |
 				  ((y & 0x3ff) << 10) |
 				  ((cr & 0x3ff) << 20) |
 				  (a << 30);
 		}
-
-		ptr += float_stride;
-		uyv += uyv_stride;
 	}
 }
 
 /* { R, G, B, X } */
-static const unsigned char swizzle_rgbx[] = { 0, 1, 2, 3 };
 static const unsigned char swizzle_bgrx[] = { 2, 1, 0, 3 };
 
-static const unsigned char *rgbx_swizzle(uint32_t format)
-{
-	switch (format) {
-	default:
-	case DRM_FORMAT_XRGB16161616F:
-	case DRM_FORMAT_ARGB16161616F:
-	case DRM_FORMAT_XRGB16161616:
-	case DRM_FORMAT_ARGB16161616:
-		return swizzle_bgrx;
-	case DRM_FORMAT_XBGR16161616F:
-	case DRM_FORMAT_ABGR16161616F:
-	case DRM_FORMAT_XBGR16161616:
-	case DRM_FORMAT_ABGR16161616:
-		return swizzle_rgbx;
-	}
-}
-
-static void convert_fp16_to_float(struct fb_convert *cvt)
+__convert_template void
+fp16_to_float(struct fb_convert *cvt, bool bgr)
 {
-	int i, j;
-	uint16_t *fp16;
-	float *ptr = cvt->dst.ptr;
-	unsigned int float_stride = cvt->dst.fb->strides[0] / sizeof(*ptr);
-	unsigned int fp16_stride = cvt->src.fb->strides[0] / sizeof(*fp16);
-	const unsigned char *swz = rgbx_swizzle(cvt->src.fb->drm_format);
-	bool needs_reswizzle = swz != swizzle_rgbx;
-
-	uint16_t *buf = convert_src_get(cvt);
-	fp16 = buf + cvt->src.fb->offsets[0] / sizeof(*buf);
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		if (needs_reswizzle) {
-			const uint16_t *fp16_tmp = fp16;
-			float *rgb_tmp = ptr;
-
-			for (j = 0; j < cvt->dst.fb->width; j++) {
-				struct igt_vec4 rgb;
+	uint8_t *buf = convert_src_get(cvt);
 
-				igt_half_to_float(fp16_tmp, rgb.d, 4);
-
-				rgb_tmp[0] = rgb.d[swz[0]];
-				rgb_tmp[1] = rgb.d[swz[1]];
-				rgb_tmp[2] = rgb.d[swz[2]];
-				rgb_tmp[3] = rgb.d[swz[3]];
-
-				rgb_tmp += 4;
-				fp16_tmp += 4;
-			}
-		} else {
-			igt_half_to_float(fp16, ptr, cvt->dst.fb->width * 4);
-		}
-
-		ptr += float_stride;
-		fp16 += fp16_stride;
-	}
+	igt_half_to_float_2d((uint16_t *)(buf + cvt->src.fb->offsets[0]),
+			     cvt->src.fb->strides[0],
+			     cvt->dst.ptr, cvt->dst.fb->strides[0],
+			     cvt->dst.fb->width, cvt->dst.fb->height,
+			     bgr ? swizzle_bgrx : NULL);
 
 	convert_src_put(cvt, buf);
 }
 
-static void convert_float_to_fp16(struct fb_convert *cvt)
+__convert_template void
+float_to_fp16(struct fb_convert *cvt, bool bgr)
 {
-	int i, j;
-	uint16_t *fp16 = cvt->dst.ptr + cvt->dst.fb->offsets[0];
-	const float *ptr = cvt->src.ptr;
-	unsigned float_stride = cvt->src.fb->strides[0] / sizeof(*ptr);
-	unsigned fp16_stride = cvt->dst.fb->strides[0] / sizeof(*fp16);
-	const unsigned char *swz = rgbx_swizzle(cvt->dst.fb->drm_format);
-	bool needs_reswizzle = swz != swizzle_rgbx;
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		if (needs_reswizzle) {
-			const float *rgb_tmp = ptr;
-			uint16_t *fp16_tmp = fp16;
-
-			for (j = 0; j < cvt->dst.fb->width; j++) {
-				struct igt_vec4 rgb;
-
-				rgb.d[0] = rgb_tmp[swz[0]];
-				rgb.d[1] = rgb_tmp[swz[1]];
-				rgb.d[2] = rgb_tmp[swz[2]];
-				rgb.d[3] = rgb_tmp[swz[3]];
-
-				igt_float_to_half(rgb.d, fp16_tmp, 4);
-
-				rgb_tmp += 4;
-				fp16_tmp += 4;
-			}
-		} else {
-			igt_float_to_half(ptr, fp16, cvt->dst.fb->width * 4);
-		}
-
-		ptr += float_stride;
-		fp16 += fp16_stride;
-	}
+	igt_float_to_half_2d(cvt->src.ptr, cvt->src.fb->strides[0],
+			     cvt->dst.ptr + cvt->dst.fb->offsets[0],
+			     cvt->dst.fb->strides[0],
+			     cvt->dst.fb->width, cvt->dst.fb->height,
+			     bgr ? swizzle_bgrx : NULL);
 }
 
-static void float_to_uint16(const float *f, uint16_t *h, unsigned int num)
+__convert_template void
+uint16_to_float(struct fb_convert *cvt, bool bgr)
 {
-	for (int i = 0; i < num; i++)
-		h[i] = f[i] * 65535.0f + 0.5f;
-}
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int float_stride = cvt->dst.fb->strides[0];
+	unsigned int up16_stride = cvt->src.fb->strides[0];
+	uint8_t *buf = convert_src_get(cvt);
 
-static void uint16_to_float(const uint16_t *h, float *f, unsigned int num)
-{
-	for (int i = 0; i < num; i++)
-		f[i] = ((float) h[i]) / 65535.0f;
-}
-
-static void convert_uint16_to_float(struct fb_convert *cvt)
-{
-	int i, j;
-	uint16_t *up16;
-	float *ptr = cvt->dst.ptr;
-	unsigned int float_stride = cvt->dst.fb->strides[0] / sizeof(*ptr);
-	unsigned int up16_stride = cvt->src.fb->strides[0] / sizeof(*up16);
-	const unsigned char *swz = rgbx_swizzle(cvt->src.fb->drm_format);
-	bool needs_reswizzle = swz != swizzle_rgbx;
+	for (unsigned int i = 0; i < height; i++) {
+		const uint16_t *up16 = (const uint16_t *)(buf + cvt->src.fb->offsets[0] +
+							  (size_t)i * up16_stride);
+		float *rgb = cvt->dst.ptr + (size_t)i * float_stride;
 
-	uint16_t *buf = convert_src_get(cvt);
-	up16 = buf + cvt->src.fb->offsets[0] / sizeof(*buf);
-
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		if (needs_reswizzle) {
-			const uint16_t *u16_tmp = up16;
-			float *rgb_tmp = ptr;
-
-			for (j = 0; j < cvt->dst.fb->width; j++) {
-				struct igt_vec4 rgb;
-
-				uint16_to_float(u16_tmp, rgb.d, 4);
-
-				rgb_tmp[0] = rgb.d[swz[0]];
-				rgb_tmp[1] = rgb.d[swz[1]];
-				rgb_tmp[2] = rgb.d[swz[2]];
-				rgb_tmp[3] = rgb.d[swz[3]];
-
-				rgb_tmp += 4;
-				u16_tmp += 4;
-			}
-		} else {
-			uint16_to_float(up16, ptr, cvt->dst.fb->width * 4);
+		for (size_t j = 0; j < 4 * width; j += 4) {
+			rgb[j + 0] = ((float)up16[j + (bgr ? 2 : 0)]) / 65535.0f;
+			rgb[j + 1] = ((float)up16[j + 1]) / 65535.0f;
+			rgb[j + 2] = ((float)up16[j + (bgr ? 0 : 2)]) / 65535.0f;
+			rgb[j + 3] = ((float)up16[j + 3]) / 65535.0f;
 		}
-
-		ptr += float_stride;
-		up16 += up16_stride;
 	}
 
 	convert_src_put(cvt, buf);
 }
 
-static void convert_float_to_uint16(struct fb_convert *cvt)
+__convert_template void
+float_to_uint16(struct fb_convert *cvt, bool bgr)
 {
-	int i, j;
-	uint16_t *up16 = cvt->dst.ptr + cvt->dst.fb->offsets[0];
-	const float *ptr = cvt->src.ptr;
-	unsigned float_stride = cvt->src.fb->strides[0] / sizeof(*ptr);
-	unsigned up16_stride = cvt->dst.fb->strides[0] / sizeof(*up16);
-	const unsigned char *swz = rgbx_swizzle(cvt->dst.fb->drm_format);
-	bool needs_reswizzle = swz != swizzle_rgbx;
+	unsigned int width = cvt->dst.fb->width, height = cvt->dst.fb->height;
+	unsigned int float_stride = cvt->src.fb->strides[0];
+	unsigned int up16_stride = cvt->dst.fb->strides[0];
 
-	for (i = 0; i < cvt->dst.fb->height; i++) {
-		if (needs_reswizzle) {
-			const float *rgb_tmp = ptr;
-			uint16_t *u16_tmp = up16;
+	for (unsigned int i = 0; i < height; i++) {
+		const float *rgb = cvt->src.ptr + (size_t)i * float_stride;
+		uint16_t *up16 = cvt->dst.ptr + cvt->dst.fb->offsets[0] +
+				 (size_t)i * up16_stride;
 
-			for (j = 0; j < cvt->dst.fb->width; j++) {
-				struct igt_vec4 rgb;
-
-				rgb.d[0] = rgb_tmp[swz[0]];
-				rgb.d[1] = rgb_tmp[swz[1]];
-				rgb.d[2] = rgb_tmp[swz[2]];
-				rgb.d[3] = rgb_tmp[swz[3]];
+		for (size_t j = 0; j < 4 * width; j += 4) {
+			up16[j + 0] = rgb[j + (bgr ? 2 : 0)] * 65535.0f + 0.5f;
+			up16[j + 1] = rgb[j + 1] * 65535.0f + 0.5f;
+			up16[j + 2] = rgb[j + (bgr ? 0 : 2)] * 65535.0f + 0.5f;
+			up16[j + 3] = rgb[j + 3] * 65535.0f + 0.5f;
+		}
+	}
+}
 
-				float_to_uint16(rgb.d, u16_tmp, 4);
+/*
+ * The formats converted to and from XRGB8888 (YUV8_FORMATS) and the shadow
+ * float format (YUV16_FORMATS), with their layout:
+ *
+ *   name, fourcc, hsub, vsub, ay_inc, uv_inc, u_plane, v_plane, a, y, u, v,
+ *   alpha
+ */
+#define YUV8_FORMATS(X) \
+	X(NV12,     DRM_FORMAT_NV12,     2, 2, 1, 2, 1, 1, 0, 0, 0, 1, false) \
+	X(NV16,     DRM_FORMAT_NV16,     2, 1, 1, 2, 1, 1, 0, 0, 0, 1, false) \
+	X(NV21,     DRM_FORMAT_NV21,     2, 2, 1, 2, 1, 1, 0, 0, 1, 0, false) \
+	X(NV61,     DRM_FORMAT_NV61,     2, 1, 1, 2, 1, 1, 0, 0, 1, 0, false) \
+	X(YUV420,   DRM_FORMAT_YUV420,   2, 2, 1, 1, 1, 2, 0, 0, 0, 0, false) \
+	X(YUV422,   DRM_FORMAT_YUV422,   2, 1, 1, 1, 1, 2, 0, 0, 0, 0, false) \
+	X(YVU420,   DRM_FORMAT_YVU420,   2, 2, 1, 1, 2, 1, 0, 0, 0, 0, false) \
+	X(YVU422,   DRM_FORMAT_YVU422,   2, 1, 1, 1, 2, 1, 0, 0, 0, 0, false) \
+	X(YUYV,     DRM_FORMAT_YUYV,     2, 1, 2, 4, 0, 0, 0, 0, 1, 3, false) \
+	X(YVYU,     DRM_FORMAT_YVYU,     2, 1, 2, 4, 0, 0, 0, 0, 3, 1, false) \
+	X(UYVY,     DRM_FORMAT_UYVY,     2, 1, 2, 4, 0, 0, 0, 1, 0, 2, false) \
+	X(VYUY,     DRM_FORMAT_VYUY,     2, 1, 2, 4, 0, 0, 0, 1, 2, 0, false) \
+	X(XYUV8888, DRM_FORMAT_XYUV8888, 1, 1, 4, 4, 0, 0, 0, 2, 1, 0, false)
+
+#define YUV16_FORMATS(X) \
+	X(P010,     DRM_FORMAT_P010,     2, 2, 1, 2, 1, 1, 0, 0, 0, 2, false) \
+	X(P012,     DRM_FORMAT_P012,     2, 2, 1, 2, 1, 1, 0, 0, 0, 2, false) \
+	X(P016,     DRM_FORMAT_P016,     2, 2, 1, 2, 1, 1, 0, 0, 0, 2, false) \
+	X(Y210,     DRM_FORMAT_Y210,     2, 1, 2, 4, 0, 0, 0, 0, 2, 6, false) \
+	X(Y212,     DRM_FORMAT_Y212,     2, 1, 2, 4, 0, 0, 0, 0, 2, 6, false) \
+	X(Y216,     DRM_FORMAT_Y216,     2, 1, 2, 4, 0, 0, 0, 0, 2, 6, false) \
+	X(XV36,     DRM_FORMAT_XVYU12_16161616, 1, 1, 4, 4, 0, 0, 6, 2, 0, 4, false) \
+	X(XV48,     DRM_FORMAT_XVYU16161616,    1, 1, 4, 4, 0, 0, 6, 2, 0, 4, false) \
+	X(Y412,     DRM_FORMAT_Y412,     1, 1, 4, 4, 0, 0, 6, 2, 0, 4, true) \
+	X(Y416,     DRM_FORMAT_Y416,     1, 1, 4, 4, 0, 0, 6, 2, 0, 4, true)
+
+#define YUV_LAYOUT(name, fourcc, hs, vs, ay, uv, up, vp, ao, yo, uo, vo, al) \
+static const struct yuv_layout layout_##name = { \
+	.hsub = hs, .vsub = vs, .ay_inc = ay, .uv_inc = uv, \
+	.u_plane = up, .v_plane = vp, .a = ao, .y = yo, .u = uo, .v = vo, \
+	.alpha = al, \
+};
 
-				rgb_tmp += 4;
-				u16_tmp += 4;
-			}
-		} else {
-			float_to_uint16(ptr, up16, cvt->dst.fb->width * 4);
-		}
+#define YUV8_CONVERTERS(name, ...) \
+YUV_LAYOUT(name, __VA_ARGS__) \
+static void convert_##name##_to_rgb24(struct fb_convert *cvt) \
+{ \
+	yuv_to_rgb24(cvt, &layout_##name); \
+} \
+static void convert_rgb24_to_##name(struct fb_convert *cvt) \
+{ \
+	rgb24_to_yuv(cvt, &layout_##name); \
+}
 
-		ptr += float_stride;
-		up16 += up16_stride;
-	}
+#define YUV16_CONVERTERS(name, ...) \
+YUV_LAYOUT(name, __VA_ARGS__) \
+static void convert_##name##_to_float(struct fb_convert *cvt) \
+{ \
+	yuv16_to_float(cvt, &layout_##name); \
+} \
+static void convert_float_to_##name(struct fb_convert *cvt) \
+{ \
+	float_to_yuv16(cvt, &layout_##name); \
 }
 
+/*
+ * The packed formats converted to and from the shadow float format, with the
+ * converter template and its argument: whether the components are in BGR
+ * order, or for Y410 whether there is alpha.
+ */
+#define PACKED_FORMATS(X) \
+	X(XRGB16161616F, DRM_FORMAT_XRGB16161616F, fp16, true) \
+	X(ARGB16161616F, DRM_FORMAT_ARGB16161616F, fp16, true) \
+	X(XBGR16161616F, DRM_FORMAT_XBGR16161616F, fp16, false) \
+	X(ABGR16161616F, DRM_FORMAT_ABGR16161616F, fp16, false) \
+	X(XRGB16161616,  DRM_FORMAT_XRGB16161616,  uint16, true) \
+	X(ARGB16161616,  DRM_FORMAT_ARGB16161616,  uint16, true) \
+	X(XBGR16161616,  DRM_FORMAT_XBGR16161616,  uint16, false) \
+	X(ABGR16161616,  DRM_FORMAT_ABGR16161616,  uint16, false) \
+	X(Y410,          DRM_FORMAT_Y410,          Y410, true) \
+	X(XV30,          DRM_FORMAT_XVYU2101010,   Y410, false)
+
+#define PACKED_CONVERTERS(name, fourcc, type, arg) \
+static void convert_##name##_to_float(struct fb_convert *cvt) \
+{ \
+	type##_to_float(cvt, arg); \
+} \
+static void convert_float_to_##name(struct fb_convert *cvt) \
+{ \
+	float_to_##type(cvt, arg); \
+}
+
+YUV8_FORMATS(YUV8_CONVERTERS)
+YUV16_FORMATS(YUV16_CONVERTERS)
+PACKED_FORMATS(PACKED_CONVERTERS)
+
+static const struct fb_converter {
+	uint32_t src, dst;
+	void (*convert)(struct fb_convert *cvt);
+} fb_converters[] = {
+#define YUV8_ENTRIES(name, fourcc, ...) \
+	{ fourcc, DRM_FORMAT_XRGB8888, convert_##name##_to_rgb24 }, \
+	{ DRM_FORMAT_XRGB8888, fourcc, convert_rgb24_to_##name },
+#define FLOAT_ENTRIES(name, fourcc, ...) \
+	{ fourcc, IGT_FORMAT_FLOAT, convert_##name##_to_float }, \
+	{ IGT_FORMAT_FLOAT, fourcc, convert_float_to_##name },
+	YUV8_FORMATS(YUV8_ENTRIES)
+	YUV16_FORMATS(FLOAT_ENTRIES)
+	PACKED_FORMATS(FLOAT_ENTRIES)
+#undef YUV8_ENTRIES
+#undef FLOAT_ENTRIES
+};
+
 static void convert_pixman(struct fb_convert *cvt)
 {
 	pixman_format_code_t src_pixman = drm_format_to_pixman(cvt->src.fb->drm_format);
@@ -3917,110 +3693,12 @@ static void fb_convert(struct fb_convert *cvt)
 	    (drm_format_to_pixman(cvt->dst.fb->drm_format) != PIXMAN_invalid)) {
 		convert_pixman(cvt);
 		return;
-	} else if (cvt->dst.fb->drm_format == DRM_FORMAT_XRGB8888) {
-		switch (cvt->src.fb->drm_format) {
-		case DRM_FORMAT_XYUV8888:
-		case DRM_FORMAT_NV12:
-		case DRM_FORMAT_NV16:
-		case DRM_FORMAT_NV21:
-		case DRM_FORMAT_NV61:
-		case DRM_FORMAT_UYVY:
-		case DRM_FORMAT_VYUY:
-		case DRM_FORMAT_YUV420:
-		case DRM_FORMAT_YUV422:
-		case DRM_FORMAT_YUYV:
-		case DRM_FORMAT_YVU420:
-		case DRM_FORMAT_YVU422:
-		case DRM_FORMAT_YVYU:
-			convert_yuv_to_rgb24(cvt);
-			return;
-		}
-	} else if (cvt->src.fb->drm_format == DRM_FORMAT_XRGB8888) {
-		switch (cvt->dst.fb->drm_format) {
-		case DRM_FORMAT_XYUV8888:
-		case DRM_FORMAT_NV12:
-		case DRM_FORMAT_NV16:
-		case DRM_FORMAT_NV21:
-		case DRM_FORMAT_NV61:
-		case DRM_FORMAT_UYVY:
-		case DRM_FORMAT_VYUY:
-		case DRM_FORMAT_YUV420:
-		case DRM_FORMAT_YUV422:
-		case DRM_FORMAT_YUYV:
-		case DRM_FORMAT_YVU420:
-		case DRM_FORMAT_YVU422:
-		case DRM_FORMAT_YVYU:
-			convert_rgb24_to_yuv(cvt);
-			return;
-		}
-	} else if (cvt->dst.fb->drm_format == IGT_FORMAT_FLOAT) {
-		switch (cvt->src.fb->drm_format) {
-		case DRM_FORMAT_P010:
-		case DRM_FORMAT_P012:
-		case DRM_FORMAT_P016:
-		case DRM_FORMAT_Y210:
-		case DRM_FORMAT_Y212:
-		case DRM_FORMAT_Y216:
-		case DRM_FORMAT_XVYU12_16161616:
-		case DRM_FORMAT_XVYU16161616:
-			convert_yuv16_to_float(cvt, false);
-			return;
-		case DRM_FORMAT_Y410:
-			convert_Y410_to_float(cvt, true);
-			return;
-		case DRM_FORMAT_XVYU2101010:
-			convert_Y410_to_float(cvt, false);
-			return;
-		case DRM_FORMAT_Y412:
-		case DRM_FORMAT_Y416:
-			convert_yuv16_to_float(cvt, true);
-			return;
-		case DRM_FORMAT_XRGB16161616F:
-		case DRM_FORMAT_XBGR16161616F:
-		case DRM_FORMAT_ARGB16161616F:
-		case DRM_FORMAT_ABGR16161616F:
-			convert_fp16_to_float(cvt);
-			return;
-		case DRM_FORMAT_XRGB16161616:
-		case DRM_FORMAT_XBGR16161616:
-		case DRM_FORMAT_ARGB16161616:
-		case DRM_FORMAT_ABGR16161616:
-			convert_uint16_to_float(cvt);
-			return;
-		}
-	} else if (cvt->src.fb->drm_format == IGT_FORMAT_FLOAT) {
-		switch (cvt->dst.fb->drm_format) {
-		case DRM_FORMAT_P010:
-		case DRM_FORMAT_P012:
-		case DRM_FORMAT_P016:
-		case DRM_FORMAT_Y210:
-		case DRM_FORMAT_Y212:
-		case DRM_FORMAT_Y216:
-		case DRM_FORMAT_XVYU12_16161616:
-		case DRM_FORMAT_XVYU16161616:
-			convert_float_to_yuv16(cvt, false);
-			return;
-		case DRM_FORMAT_Y410:
-			convert_float_to_Y410(cvt, true);
-			return;
-		case DRM_FORMAT_XVYU2101010:
-			convert_float_to_Y410(cvt, false);
-			return;
-		case DRM_FORMAT_Y412:
-		case DRM_FORMAT_Y416:
-			convert_float_to_yuv16(cvt, true);
-			return;
-		case DRM_FORMAT_XRGB16161616F:
-		case DRM_FORMAT_XBGR16161616F:
-		case DRM_FORMAT_ARGB16161616F:
-		case DRM_FORMAT_ABGR16161616F:
-			convert_float_to_fp16(cvt);
-			return;
-		case DRM_FORMAT_XRGB16161616:
-		case DRM_FORMAT_XBGR16161616:
-		case DRM_FORMAT_ARGB16161616:
-		case DRM_FORMAT_ABGR16161616:
-			convert_float_to_uint16(cvt);
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(fb_converters); i++) {
+		if (fb_converters[i].src == cvt->src.fb->drm_format &&
+		    fb_converters[i].dst == cvt->dst.fb->drm_format) {
+			fb_converters[i].convert(cvt);
 			return;
 		}
 	}
@@ -4032,6 +3710,165 @@ static void fb_convert(struct fb_convert *cvt)
 		     IGT_FORMAT_ARGS(cvt->dst.fb->drm_format));
 }
 
+/*
+ * Describes the pixels [x1, x2) x [y1, y2) of @buf as a framebuffer of their
+ * own, for the converters to only convert those.
+ */
+static void fb_convert_buf_rect(struct fb_convert_buf *rect, struct igt_fb *view,
+				const struct fb_convert_buf *buf, unsigned int cpp,
+				int x1, int y1, int x2, int y2)
+{
+	const struct igt_fb *fb = buf->fb;
+	const struct format_desc_struct *f = lookup_drm_format(fb->drm_format);
+	uint64_t start = 0;
+
+	*view = *fb;
+	view->width = x2 - x1;
+	view->height = y2 - y1;
+
+	for (int i = 0; i < fb->num_planes; i++) {
+		int hsub = i ? f->hsub : 1;
+		int vsub = i ? f->vsub : 1;
+		uint64_t offset = fb->offsets[i] +
+			(uint64_t)(y1 / vsub) * fb->strides[i] +
+			(uint64_t)(x1 / hsub) * (i ? fb->plane_bpp[i] / 8 : cpp);
+
+		/* Plane offsets stay relative to the start of the first one */
+		if (!i)
+			start = offset - fb->offsets[0];
+
+		view->offsets[i] = offset - start;
+		view->plane_width[i] = DIV_ROUND_UP(view->width, hsub);
+		view->plane_height[i] = DIV_ROUND_UP(view->height, vsub);
+	}
+	view->size = fb->size - start;
+
+	*rect = *buf;
+	rect->ptr = (uint8_t *)buf->ptr + start;
+	rect->fb = view;
+}
+
+/* Converts back the pixels [x1, x2) x [y1, y2) of a shadow buffer */
+static void fb_convert_rect(const struct fb_convert *cvt,
+			    int x1, int y1, int x2, int y2)
+{
+	const struct format_desc_struct *f =
+		lookup_drm_format(cvt->dst.fb->drm_format);
+	unsigned int src_cpp = cvt->src.fb->plane_bpp[0] / 8;
+	struct igt_fb dst_view, src_view;
+	struct fb_convert rect;
+
+	/* Float shadow buffers only hold 3 channels for formats without alpha */
+	if (f->cairo_id == CAIRO_FORMAT_RGB96F)
+		src_cpp = 3 * sizeof(float);
+
+	/*
+	 * Whole chroma samples, and whole 32 bit words of any pixel size
+	 * for pixman.
+	 */
+	x1 = ALIGN_DOWN(x1, 8);
+	y1 = ALIGN_DOWN(y1, 4);
+	x2 = min(ALIGN(x2, 8), cvt->dst.fb->width);
+	y2 = min(ALIGN(y2, 4), cvt->dst.fb->height);
+
+	fb_convert_buf_rect(&rect.dst, &dst_view, &cvt->dst,
+			    cvt->dst.fb->plane_bpp[0] / 8, x1, y1, x2, y2);
+	fb_convert_buf_rect(&rect.src, &src_view, &cvt->src, src_cpp,
+			    x1, y1, x2, y2);
+	fb_convert(&rect);
+}
+
+#define DAMAGE_MARKER "application/x-igt-fb-damage"
+
+static void create_cairo_surface__convert(int fd, struct igt_fb *fb,
+					  bool read_in);
+
+/*
+ * cairo drops the mime data of a surface when anything is drawn into it, so
+ * the marker is only still there if nothing was drawn since it was set, but
+ * through the helpers recording what they draw.
+ */
+static void damage_mark(cairo_surface_t *surface)
+{
+	static const unsigned char marker = 1;
+
+	cairo_surface_set_mime_data(surface, DAMAGE_MARKER, &marker, 1,
+				    NULL, NULL);
+}
+
+static bool damage_marked(cairo_surface_t *surface)
+{
+	const unsigned char *data;
+	unsigned long length;
+
+	cairo_surface_get_mime_data(surface, DAMAGE_MARKER, &data, &length);
+
+	return data;
+}
+
+static struct fb_convert_blit_upload *convert_blit(cairo_surface_t *surface)
+{
+	return cairo_surface_get_user_data(surface,
+					   (cairo_user_data_key_t *)create_cairo_surface__convert);
+}
+
+static struct fb_convert_blit_upload *damage_begin(cairo_t *cr)
+{
+	cairo_surface_t *surface = cairo_get_target(cr);
+	struct fb_convert_blit_upload *blit = convert_blit(surface);
+
+	if (!blit || !blit->track_damage)
+		return NULL;
+
+	/* Drawn into behind our back, we don't know where */
+	if (!damage_marked(surface)) {
+		blit->track_damage = false;
+		return NULL;
+	}
+
+	return blit;
+}
+
+static void damage_end(cairo_t *cr, struct fb_convert_blit_upload *blit,
+		       double x1, double y1, double x2, double y2)
+{
+	double x[4] = { x1, x2, x1, x2 };
+	double y[4] = { y1, y1, y2, y2 };
+	int dx1 = INT_MAX, dy1 = INT_MAX, dx2 = INT_MIN, dy2 = INT_MIN;
+
+	if (!blit || !blit->track_damage)
+		return;
+
+	for (int i = 0; i < 4; i++) {
+		cairo_user_to_device(cr, &x[i], &y[i]);
+		dx1 = min(dx1, (int)floor(x[i]));
+		dy1 = min(dy1, (int)floor(y[i]));
+		dx2 = max(dx2, (int)ceil(x[i]));
+		dy2 = max(dy2, (int)ceil(y[i]));
+	}
+
+	dx1 = max(dx1, 0);
+	dy1 = max(dy1, 0);
+	dx2 = min(dx2, blit->shadow_fb.width);
+	dy2 = min(dy2, blit->shadow_fb.height);
+
+	if (dx1 < dx2 && dy1 < dy2) {
+		if (blit->damage_x1 < blit->damage_x2) {
+			dx1 = min(dx1, blit->damage_x1);
+			dy1 = min(dy1, blit->damage_y1);
+			dx2 = max(dx2, blit->damage_x2);
+			dy2 = max(dy2, blit->damage_y2);
+		}
+
+		blit->damage_x1 = dx1;
+		blit->damage_y1 = dy1;
+		blit->damage_x2 = dx2;
+		blit->damage_y2 = dy2;
+	}
+
+	damage_mark(cairo_get_target(cr));
+}
+
 static void destroy_cairo_surface__convert(void *arg)
 {
 	struct fb_convert_blit_upload *blit = arg;
@@ -4048,7 +3885,16 @@ static void destroy_cairo_surface__convert(void *arg)
 		},
 	};
 
-	fb_convert(&cvt);
+	/*
+	 * A context released without igt_put_cairo_ctx() may have been drawn
+	 * into since the last helper.
+	 */
+	if (!blit->track_damage || blit->contexts)
+		fb_convert(&cvt);
+	else if (blit->damage_x1 < blit->damage_x2)
+		fb_convert_rect(&cvt, blit->damage_x1, blit->damage_y1,
+				blit->damage_x2, blit->damage_y2);
+
 	igt_fb_destroy_cairo_shadow_buffer(&blit->shadow_fb, blit->shadow_ptr);
 
 	if (blit->base.linear.fb.gem_handle)
@@ -4061,7 +3907,8 @@ static void destroy_cairo_surface__convert(void *arg)
 	fb->cairo_surface = NULL;
 }
 
-static void create_cairo_surface__convert(int fd, struct igt_fb *fb)
+static void create_cairo_surface__convert(int fd, struct igt_fb *fb,
+					  bool read_in)
 {
 	struct fb_convert_blit_upload *blit = calloc(1, sizeof(*blit));
 	struct fb_convert cvt = { };
@@ -4096,11 +3943,14 @@ static void create_cairo_surface__convert(int fd, struct igt_fb *fb)
 		cvt.src.slow_reads = is_i915_device(fd);
 	}
 
-	cvt.dst.ptr = blit->shadow_ptr;
-	cvt.dst.fb = &blit->shadow_fb;
-	cvt.src.ptr = blit->base.linear.map;
-	cvt.src.fb = &blit->base.linear.fb;
-	fb_convert(&cvt);
+	/* Left out when everything is about to be drawn over */
+	if (read_in) {
+		cvt.dst.ptr = blit->shadow_ptr;
+		cvt.dst.fb = &blit->shadow_fb;
+		cvt.src.ptr = blit->base.linear.map;
+		cvt.src.fb = &blit->base.linear.fb;
+		fb_convert(&cvt);
+	}
 
 	fb->cairo_surface =
 		cairo_image_surface_create_for_data(blit->shadow_ptr,
@@ -4111,6 +3961,93 @@ static void create_cairo_surface__convert(int fd, struct igt_fb *fb)
 	cairo_surface_set_user_data(fb->cairo_surface,
 				    (cairo_user_data_key_t *)create_cairo_surface__convert,
 				    blit, destroy_cairo_surface__convert);
+
+	blit->track_damage = true;
+	damage_mark(fb->cairo_surface);
+}
+
+struct fb_convert_shadow {
+	struct igt_fb fb;
+	void *ptr;
+};
+
+static void destroy_convert_shadow(void *arg)
+{
+	struct fb_convert_shadow *shadow = arg;
+
+	igt_fb_destroy_cairo_shadow_buffer(&shadow->fb, shadow->ptr);
+	free(shadow);
+}
+
+/**
+ * igt_fb_convert_to_cairo:
+ * @fb: pointer to a linear #igt_fb in a format cairo can't draw in
+ * @ptr: the contents of @fb
+ *
+ * Converts framebuffer contents held in memory to the format cairo draws in
+ * for @fb, with the same converters as igt_get_cairo_ctx(). Only the layout
+ * of @fb is used, so no device is needed.
+ *
+ * Returns:
+ * An image surface with the converted contents, to be converted back with
+ * igt_fb_convert_from_cairo().
+ */
+cairo_surface_t *igt_fb_convert_to_cairo(struct igt_fb *fb, void *ptr)
+{
+	const struct format_desc_struct *f = lookup_drm_format(fb->drm_format);
+	struct fb_convert_shadow *shadow = calloc(1, sizeof(*shadow));
+	struct fb_convert cvt = { };
+	cairo_surface_t *surface;
+
+	igt_assert(shadow);
+
+	shadow->ptr = igt_fb_create_cairo_shadow_buffer(fb->fd,
+							cairo_format_to_drm_format(f->cairo_id),
+							fb->width, fb->height,
+							&shadow->fb);
+
+	cvt.dst.ptr = shadow->ptr;
+	cvt.dst.fb = &shadow->fb;
+	cvt.src.ptr = ptr;
+	cvt.src.fb = fb;
+	fb_convert(&cvt);
+
+	surface = cairo_image_surface_create_for_data(shadow->ptr, f->cairo_id,
+						      fb->width, fb->height,
+						      shadow->fb.strides[0]);
+	cairo_surface_set_user_data(surface,
+				    (cairo_user_data_key_t *)igt_fb_convert_to_cairo,
+				    shadow, destroy_convert_shadow);
+
+	return surface;
+}
+
+/**
+ * igt_fb_convert_from_cairo:
+ * @fb: pointer to an #igt_fb structure
+ * @ptr: the contents of @fb
+ * @surface: the surface from igt_fb_convert_to_cairo() for @fb
+ *
+ * Converts the whole of @surface back into @ptr, and destroys it.
+ */
+void igt_fb_convert_from_cairo(struct igt_fb *fb, void *ptr,
+			       cairo_surface_t *surface)
+{
+	struct fb_convert_shadow *shadow =
+		cairo_surface_get_user_data(surface,
+					    (cairo_user_data_key_t *)igt_fb_convert_to_cairo);
+	struct fb_convert cvt = { };
+
+	igt_assert(shadow);
+	cairo_surface_flush(surface);
+
+	cvt.dst.ptr = ptr;
+	cvt.dst.fb = fb;
+	cvt.src.ptr = shadow->ptr;
+	cvt.src.fb = &shadow->fb;
+	fb_convert(&cvt);
+
+	cairo_surface_destroy(surface);
 }
 
 
@@ -4162,15 +4099,13 @@ static bool use_convert(const struct igt_fb *fb)
  * Returns:
  * A pointer to a cairo surface with the contents of the framebuffer.
  */
-cairo_surface_t *igt_get_cairo_surface(int fd, struct igt_fb *fb)
+static cairo_surface_t *get_cairo_surface(int fd, struct igt_fb *fb,
+					  bool read_in)
 {
 	if (fb->cairo_surface == NULL) {
 		if (use_convert(fb))
-			create_cairo_surface__convert(fd, fb);
-		else if (use_blitter(fb) || use_enginecopy(fb) ||
-			 igt_vc4_is_tiled(fb->modifier) ||
-			 igt_amd_is_tiled(fb->modifier) ||
-			 is_nouveau_device(fb->fd))
+			create_cairo_surface__convert(fd, fb, read_in);
+		else if (use_linear_copy(fb))
 			create_cairo_surface__gpu(fd, fb);
 		else
 			create_cairo_surface__gtt(fd, fb);
@@ -4180,29 +4115,193 @@ cairo_surface_t *igt_get_cairo_surface(int fd, struct igt_fb *fb)
 	return fb->cairo_surface;
 }
 
+cairo_surface_t *igt_get_cairo_surface(int fd, struct igt_fb *fb)
+{
+	cairo_surface_t *surface = get_cairo_surface(fd, fb, true);
+	struct fb_convert_blit_upload *blit = convert_blit(surface);
+
+	/* The pixels can be written directly, without cairo knowing */
+	if (blit)
+		blit->track_damage = false;
+
+	return surface;
+}
+
+static void fb_cache_key(char *key, size_t len, const struct igt_fb *fb,
+			 const char *pattern)
+{
+	snprintf(key, len, "%08x %dx%d %d %d %s",
+		 fb->drm_format, fb->width, fb->height,
+		 fb->color_encoding, fb->color_range, pattern);
+}
+
+static size_t fb_cache_row_size(const struct igt_fb *fb, int plane)
+{
+	return (size_t)fb->plane_width[plane] * fb->plane_bpp[plane] / 8;
+}
+
+/* Only the format's planes, not the CCS aux and clear color planes */
+static int fb_cache_num_planes(const struct igt_fb *fb)
+{
+	return lookup_drm_format(fb->drm_format)->num_planes;
+}
+
+static size_t fb_cache_size(const struct igt_fb *fb)
+{
+	size_t size = 0;
+
+	for (int i = 0; i < fb_cache_num_planes(fb); i++)
+		size += fb_cache_row_size(fb, i) * fb->plane_height[i];
+
+	return size;
+}
+
+/*
+ * Cached contents are the planes of the framebuffer one after the other,
+ * without any padding, as laid out in a linear buffer. They are independent
+ * of the modifier, and get tiled on the way in like anything drawn with
+ * cairo.
+ */
+static void fb_cache_copy(struct igt_fb *fb, void *data, bool to_fb)
+{
+	struct fb_blit_upload blit = { .fd = fb->fd, .fb = fb };
+	const struct igt_fb *linear;
+	bool slow_reads = false;
+	uint8_t *buf = data;
+	uint8_t *map;
+
+	if (use_linear_copy(fb)) {
+		setup_linear_mapping(&blit);
+		linear = &blit.linear.fb;
+		map = blit.linear.map;
+	} else {
+		linear = fb;
+		map = map_bo(fb->fd, fb);
+		slow_reads = is_i915_device(fb->fd);
+	}
+
+	for (int i = 0; i < fb_cache_num_planes(fb); i++) {
+		size_t row = fb_cache_row_size(fb, i);
+
+		for (int y = 0; y < fb->plane_height[i]; y++) {
+			uint8_t *line = map + linear->offsets[i] +
+					(size_t)y * linear->strides[i];
+
+			if (to_fb)
+				memcpy(line, buf, row);
+			else if (slow_reads)
+				igt_memcpy_from_wc(buf, line, row);
+			else
+				memcpy(buf, line, row);
+
+			buf += row;
+		}
+	}
+
+	if (linear != fb)
+		free_linear_mapping(&blit);
+	else
+		unmap_bo(fb, map);
+}
+
 /**
- * igt_get_cairo_ctx:
- * @fd: open drm file descriptor
+ * igt_fb_load_cached:
  * @fb: pointer to an #igt_fb structure
+ * @pattern: description of the contents
  *
- * This initializes a cairo surface for @fb and then allocates a drawing context
- * for it. The return cairo drawing context should be released by calling
- * igt_put_cairo_ctx(). This also sets a default font for drawing text on
- * framebuffers.
+ * Fills @fb with the contents saved by igt_fb_save_cached() under the same
+ * @pattern for a framebuffer of the same format, size and color encoding, if
+ * they are still cached. @pattern must describe everything drawn, parameters
+ * included; the modifier doesn't matter.
  *
- * Returns:
- * The created cairo drawing context.
+ * Reference images are then only drawn, and converted to the framebuffer
+ * format, once:
+ *
+ * |[<!-- language="C" -->
+ *	if (!igt_fb_load_cached(fb, "gradient")) {
+ *		cr = igt_get_cairo_ctx(fd, fb);
+ *		igt_paint_color_gradient(cr, 0, 0, w, h, 1, 1, 1);
+ *		igt_put_cairo_ctx(cr);
+ *		igt_fb_save_cached(fb, "gradient");
+ *	}
+ * ]|
+ *
+ * IGT_FB_CACHE_SIZE and IGT_FB_CACHE_DIR control the size of the cache and
+ * where it is kept.
+ *
+ * Returns: true if @fb was filled from the cache.
  */
-cairo_t *igt_get_cairo_ctx(int fd, struct igt_fb *fb)
+bool igt_fb_load_cached(struct igt_fb *fb, const char *pattern)
+{
+	size_t size = fb_cache_size(fb);
+	char key[256];
+	void *data;
+	bool hit;
+
+	igt_assert(!fb->cairo_surface);
+
+	data = malloc(size);
+	if (!data)
+		return false;
+
+	fb_cache_key(key, sizeof(key), fb, pattern);
+	hit = igt_fb_cache_lookup(key, data, size);
+	if (hit)
+		fb_cache_copy(fb, data, true);
+
+	free(data);
+	return hit;
+}
+
+/**
+ * igt_fb_save_cached:
+ * @fb: pointer to an #igt_fb structure
+ * @pattern: description of the contents
+ *
+ * Saves the current contents of @fb under @pattern, for igt_fb_load_cached()
+ * to find them.
+ */
+void igt_fb_save_cached(struct igt_fb *fb, const char *pattern)
+{
+	size_t size = fb_cache_size(fb);
+	char key[256];
+	void *data;
+
+	igt_assert(!fb->cairo_surface);
+
+	data = malloc(size);
+	if (!data)
+		return;
+
+	fb_cache_key(key, sizeof(key), fb, pattern);
+	fb_cache_copy(fb, data, false);
+	igt_fb_cache_insert(key, data, size);
+
+	free(data);
+}
+
+/*
+ * With @read_in false the current contents of a framebuffer needing
+ * conversion aren't read in, for callers about to draw over all of it.
+ */
+static cairo_t *get_cairo_ctx(int fd, struct igt_fb *fb, bool read_in)
 {
+	struct fb_convert_blit_upload *blit;
 	cairo_surface_t *surface;
 	cairo_t *cr;
 
-	surface = igt_get_cairo_surface(fd, fb);
+	surface = get_cairo_surface(fd, fb, read_in);
 	cr = cairo_create(surface);
 	cairo_surface_destroy(surface);
 	igt_assert(cairo_status(cr) == CAIRO_STATUS_SUCCESS);
 
+	blit = convert_blit(surface);
+	if (blit) {
+		cairo_set_user_data(cr, (cairo_user_data_key_t *)get_cairo_ctx,
+				    blit, NULL);
+		blit->contexts++;
+	}
+
 	cairo_select_font_face(cr, "Helvetica", CAIRO_FONT_SLANT_NORMAL,
 			       CAIRO_FONT_WEIGHT_NORMAL);
 	igt_assert(cairo_status(cr) == CAIRO_STATUS_SUCCESS);
@@ -4210,6 +4309,29 @@ cairo_t *igt_get_cairo_ctx(int fd, struct igt_fb *fb)
 	return cr;
 }
 
+/**
+ * igt_get_cairo_ctx:
+ * @fd: open drm file descriptor
+ * @fb: pointer to an #igt_fb structure
+ *
+ * This initializes a cairo surface for @fb and then allocates a drawing context
+ * for it. The return cairo drawing context should be released by calling
+ * igt_put_cairo_ctx(). This also sets a default font for drawing text on
+ * framebuffers.
+ *
+ * For formats cairo doesn't support, drawing goes to a copy of @fb converted
+ * to a format it does. As long as only the igt_paint helpers and
+ * igt_cairo_printf_line() draw into it and the context is released with
+ * igt_put_cairo_ctx(), only the area they drew into is converted back.
+ *
+ * Returns:
+ * The created cairo drawing context.
+ */
+cairo_t *igt_get_cairo_ctx(int fd, struct igt_fb *fb)
+{
+	return get_cairo_ctx(fd, fb, true);
+}
+
 /**
  * igt_put_cairo_ctx:
  * @cr: the cairo context returned by igt_get_cairo_ctx.
@@ -4220,9 +4342,17 @@ cairo_t *igt_get_cairo_ctx(int fd, struct igt_fb *fb)
  */
 void igt_put_cairo_ctx(cairo_t *cr)
 {
+	struct fb_convert_blit_upload *blit =
+		cairo_get_user_data(cr, (cairo_user_data_key_t *)get_cairo_ctx);
 	cairo_status_t ret = cairo_status(cr);
 	igt_assert_f(ret == CAIRO_STATUS_SUCCESS, "Cairo failed to draw with %s\n", cairo_status_to_string(ret));
 
+	if (blit) {
+		/* Catches what was drawn since the last helper */
+		damage_begin(cr);
+		blit->contexts--;
+	}
+
 	cairo_destroy(cr);
 }
 
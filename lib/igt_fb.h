@@ -190,6 +190,11 @@ cairo_surface_t *igt_get_cairo_surface(int fd, struct igt_fb *fb);
 cairo_surface_t *igt_cairo_image_surface_create_from_png(const char *filename);
 cairo_t *igt_get_cairo_ctx(int fd, struct igt_fb *fb);
 void igt_put_cairo_ctx(cairo_t *cr);
+cairo_surface_t *igt_fb_convert_to_cairo(struct igt_fb *fb, void *ptr);
+void igt_fb_convert_from_cairo(struct igt_fb *fb, void *ptr,
+			       cairo_surface_t *surface);
+bool igt_fb_load_cached(struct igt_fb *fb, const char *pattern);
+void igt_fb_save_cached(struct igt_fb *fb, const char *pattern);
 void igt_paint_color(cairo_t *cr, int x, int y, int w, int h,
 			 double r, double g, double b);
 void igt_paint_color_rand(cairo_t *cr, int x, int y, int w, int h);
@@ -0,0 +1,366 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_fb_cache.h"
+#include "igt_list.h"
+#include "igt_map.h"
+
+/**
+ * SECTION:igt_fb_cache
+ * @short_description: Cache of rendered framebuffer contents
+ * @title: Framebuffer cache
+ * @include: igt_fb_cache.h
+ *
+ * Tests keep painting the same reference images: the same pattern, in the
+ * same format, at the same size. This is a content-addressed store for such
+ * images, in which the caller names the contents by a key string describing
+ * everything they depend on and gets back a copy of the bytes stored under
+ * that key.
+ *
+ * Entries are kept in memory, the least recently used ones being evicted
+ * beyond a limit of IGT_FB_CACHE_SIZE MiB (64 by default, 0 disabling the
+ * cache). When IGT_FB_CACHE_DIR names a directory, entries are also written
+ * there, so that later test runs start with a warm cache.
+ */
+
+#define DEFAULT_LIMIT (64ull << 20)
+#define MAGIC "igt-fb-cache 1\n"
+
+struct cache_entry {
+	struct igt_list_head link;
+	char *key;
+	size_t size;
+	unsigned char data[];
+};
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+static struct igt_map *cache_map;
+static IGT_LIST_HEAD(cache_lru);
+static size_t cache_used;
+static size_t cache_limit;
+static char *cache_dir;
+
+/* FNV-1a, which also names the entry in the directory */
+static uint64_t key_hash64(const char *key)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (; *key; key++) {
+		hash ^= (unsigned char)*key;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static uint32_t key_hash(const void *key)
+{
+	uint64_t hash = key_hash64(key);
+
+	return hash ^ hash >> 32;
+}
+
+static int key_equal(const void *a, const void *b)
+{
+	return !strcmp(a, b);
+}
+
+static void cache_init(void)
+{
+	const char *env;
+
+	cache_map = igt_map_create(key_hash, key_equal);
+
+	cache_limit = DEFAULT_LIMIT;
+	env = getenv("IGT_FB_CACHE_SIZE");
+	if (env)
+		cache_limit = strtoull(env, NULL, 0) << 20;
+
+	env = getenv("IGT_FB_CACHE_DIR");
+	if (env && *env)
+		cache_dir = strdup(env);
+}
+
+static void entry_remove(struct cache_entry *entry)
+{
+	igt_map_remove(cache_map, entry->key, NULL);
+	igt_list_del(&entry->link);
+	cache_used -= entry->size;
+	free(entry->key);
+	free(entry);
+}
+
+static void evict(size_t limit)
+{
+	struct cache_entry *entry, *tmp;
+
+	igt_list_for_each_entry_safe(entry, tmp, &cache_lru, link) {
+		if (cache_used <= limit)
+			break;
+
+		entry_remove(entry);
+	}
+}
+
+static void memory_insert(const char *key, const void *data, size_t size)
+{
+	struct cache_entry *entry;
+
+	if (size > cache_limit)
+		return;
+
+	entry = igt_map_search(cache_map, key);
+	if (entry)
+		entry_remove(entry);
+
+	evict(cache_limit - size);
+
+	entry = malloc(sizeof(*entry) + size);
+	if (!entry)
+		return;
+
+	entry->key = strdup(key);
+	if (!entry->key) {
+		free(entry);
+		return;
+	}
+
+	entry->size = size;
+	memcpy(entry->data, data, size);
+
+	igt_map_insert(cache_map, entry->key, entry);
+	igt_list_add_tail(&entry->link, &cache_lru);
+	cache_used += size;
+}
+
+static void disk_path(char *path, const char *key, const char *suffix)
+{
+	snprintf(path, PATH_MAX, "%s/%016" PRIx64 ".fb%s",
+		 cache_dir, key_hash64(key), suffix);
+}
+
+static bool read_full(int fd, void *buf, size_t size)
+{
+	while (size) {
+		ssize_t ret = read(fd, buf, size);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf = (char *)buf + ret;
+		size -= ret;
+	}
+
+	return true;
+}
+
+static bool write_full(int fd, const void *buf, size_t size)
+{
+	while (size) {
+		ssize_t ret = write(fd, buf, size);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf = (const char *)buf + ret;
+		size -= ret;
+	}
+
+	return true;
+}
+
+/*
+ * An entry on disk is the magic, the key and its NUL, the size of the data
+ * and then the data, so that hash collisions and stale entries of another
+ * size are told apart from hits.
+ */
+static bool disk_lookup(const char *key, void *data, size_t size)
+{
+	size_t key_len = strlen(key) + 1;
+	char path[PATH_MAX];
+	char *header;
+	uint64_t stored;
+	bool hit = false;
+	int fd;
+
+	disk_path(path, key, "");
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	header = malloc(sizeof(MAGIC) - 1 + key_len);
+	if (!header)
+		goto out;
+
+	if (!read_full(fd, header, sizeof(MAGIC) - 1 + key_len) ||
+	    memcmp(header, MAGIC, sizeof(MAGIC) - 1) ||
+	    memcmp(header + sizeof(MAGIC) - 1, key, key_len))
+		goto out;
+
+	if (!read_full(fd, &stored, sizeof(stored)) || stored != size)
+		goto out;
+
+	hit = read_full(fd, data, size);
+
+out:
+	free(header);
+	close(fd);
+	return hit;
+}
+
+static void disk_insert(const char *key, const void *data, size_t size)
+{
+	char path[PATH_MAX], tmp[PATH_MAX];
+	uint64_t stored = size;
+	bool ok;
+	int fd;
+
+	if (mkdir(cache_dir, 0777) && errno != EEXIST)
+		return;
+
+	disk_path(path, key, "");
+	disk_path(tmp, key, ".XXXXXX");
+	fd = mkstemp(tmp);
+	if (fd < 0)
+		return;
+
+	/* Written aside and renamed, concurrent readers never see a partial entry */
+	ok = write_full(fd, MAGIC, sizeof(MAGIC) - 1) &&
+	     write_full(fd, key, strlen(key) + 1) &&
+	     write_full(fd, &stored, sizeof(stored)) &&
+	     write_full(fd, data, size);
+	close(fd);
+
+	if (!ok || rename(tmp, path)) {
+		igt_debug("Failed to write %s to the framebuffer cache\n", key);
+		unlink(tmp);
+	}
+}
+
+/**
+ * igt_fb_cache_set_limit:
+ * @bytes: size limit of the in memory cache
+ *
+ * Overrides IGT_FB_CACHE_SIZE, evicting entries beyond the new limit. 0
+ * disables the cache, including its on-disk part.
+ */
+void igt_fb_cache_set_limit(size_t bytes)
+{
+	pthread_once(&cache_once, cache_init);
+
+	pthread_mutex_lock(&cache_lock);
+	cache_limit = bytes;
+	evict(cache_limit);
+	pthread_mutex_unlock(&cache_lock);
+}
+
+/**
+ * igt_fb_cache_set_dir:
+ * @dir: directory to keep entries in, or %NULL
+ *
+ * Overrides IGT_FB_CACHE_DIR. The directory is created on the first insert
+ * if it doesn't exist yet. %NULL keeps entries in memory only.
+ */
+void igt_fb_cache_set_dir(const char *dir)
+{
+	pthread_once(&cache_once, cache_init);
+
+	pthread_mutex_lock(&cache_lock);
+	free(cache_dir);
+	cache_dir = dir ? strdup(dir) : NULL;
+	pthread_mutex_unlock(&cache_lock);
+}
+
+/**
+ * igt_fb_cache_lookup:
+ * @key: description of the contents
+ * @data: buffer to copy the contents to
+ * @size: size of @data
+ *
+ * Looks up the contents stored under @key, first in memory and then on disk,
+ * entries found on disk being brought back in memory. Entries of a size other
+ * than @size are ignored.
+ *
+ * Returns: true if @data was filled from the cache.
+ */
+bool igt_fb_cache_lookup(const char *key, void *data, size_t size)
+{
+	struct cache_entry *entry;
+	bool hit = false;
+
+	pthread_once(&cache_once, cache_init);
+
+	pthread_mutex_lock(&cache_lock);
+	if (!cache_limit)
+		goto out;
+
+	entry = igt_map_search(cache_map, key);
+	if (entry && entry->size == size) {
+		memcpy(data, entry->data, size);
+		igt_list_move_tail(&entry->link, &cache_lru);
+		hit = true;
+	} else if (cache_dir && disk_lookup(key, data, size)) {
+		memory_insert(key, data, size);
+		hit = true;
+	}
+
+out:
+	pthread_mutex_unlock(&cache_lock);
+	return hit;
+}
+
+/**
+ * igt_fb_cache_insert:
+ * @key: description of the contents
+ * @data: contents
+ * @size: size of @data
+ *
+ * Stores a copy of @data under @key, replacing what was stored there before.
+ * @key must describe everything the contents depend on.
+ */
+void igt_fb_cache_insert(const char *key, const void *data, size_t size)
+{
+	pthread_once(&cache_once, cache_init);
+
+	pthread_mutex_lock(&cache_lock);
+	if (cache_limit) {
+		memory_insert(key, data, size);
+		if (cache_dir)
+			disk_insert(key, data, size);
+	}
+	pthread_mutex_unlock(&cache_lock);
+}
+
+/**
+ * igt_fb_cache_drop:
+ *
+ * Frees all the entries kept in memory. Those on disk are kept.
+ */
+void igt_fb_cache_drop(void)
+{
+	pthread_once(&cache_once, cache_init);
+
+	pthread_mutex_lock(&cache_lock);
+	evict(0);
+	pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef __IGT_FB_CACHE_H__
+#define __IGT_FB_CACHE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+void igt_fb_cache_set_limit(size_t bytes);
+void igt_fb_cache_set_dir(const char *dir);
+
+bool igt_fb_cache_lookup(const char *key, void *data, size_t size);
+void igt_fb_cache_insert(const char *key, const void *data, size_t size);
+void igt_fb_cache_drop(void);
+
+#endif /* __IGT_FB_CACHE_H__ */
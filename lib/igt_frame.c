@@ -26,14 +26,19 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <string.h>
 #include <pixman.h>
 #include <cairo.h>
 #include <gsl/gsl_statistics_double.h>
 #include <gsl/gsl_fit.h>
 
 #include "igt_frame.h"
+#include "igt_aux.h"
 #include "igt_core.h"
+#include "igt_thread.h"
+#include "igt_x86.h"
 
 /**
  * SECTION:igt_frame
@@ -139,6 +144,277 @@ void igt_write_compared_frames_to_png(cairo_surface_t *reference,
 	close(fd);
 }
 
+/*
+ * Row kernels shared by the frame comparison helpers. All of them work on
+ * XR24 rows and only produce integer results, so the vectorized variants
+ * give bit-identical results to the generic ones.
+ */
+struct frame_row_ops {
+	/* dst[i] = |a[i] - b[i]| for each byte */
+	void (*absdiff)(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+			unsigned int len);
+	/* Mark checkerboard pattern edges of a reference row, see
+	 * igt_check_checkerboard_frame_match(). */
+	void (*edges)(uint8_t *edges, const uint8_t *row,
+		      const uint8_t *above, const uint8_t *below,
+		      unsigned int width, unsigned int span,
+		      unsigned int threshold);
+	/* Mark pixels with any color component differing by more than
+	 * threshold. Returns the number of marked pixels, or -EINVAL if
+	 * threshold isn't supported. Called from worker threads, so it
+	 * must not assert. */
+	int (*errors)(uint8_t *errors, const uint8_t *ref, const uint8_t *cap,
+		      unsigned int width, unsigned int threshold);
+};
+
+static void absdiff_row(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+			unsigned int len)
+{
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+}
+
+static inline bool edge_pixel(const uint8_t *row, const uint8_t *above,
+			      const uint8_t *below, unsigned int x,
+			      unsigned int span, unsigned int threshold)
+{
+	unsigned int xdiff = 0, ydiff = 0;
+	unsigned int c;
+
+	for (c = 0; c < 3; c++) {
+		xdiff += abs(row[4 * (x + span) + c] - row[4 * (x - span) + c]);
+		ydiff += abs(below[4 * x + c] - above[4 * x + c]);
+	}
+
+	return xdiff > threshold || ydiff > threshold;
+}
+
+static void edges_row(uint8_t *edges, const uint8_t *row,
+		      const uint8_t *above, const uint8_t *below,
+		      unsigned int width, unsigned int span,
+		      unsigned int threshold)
+{
+	unsigned int x;
+
+	for (x = 0; x < width; x++) {
+		if (x < span || x > (width - span - 1))
+			edges[x] = 0;
+		else
+			edges[x] = edge_pixel(row, above, below, x,
+					      span, threshold);
+	}
+}
+
+static inline bool error_pixel(const uint8_t *ref, const uint8_t *cap,
+			       unsigned int x, unsigned int threshold)
+{
+	unsigned int c;
+
+	for (c = 0; c < 3; c++)
+		if (abs(ref[4 * x + c] - cap[4 * x + c]) > threshold)
+			return true;
+
+	return false;
+}
+
+static int errors_row(uint8_t *errors, const uint8_t *ref, const uint8_t *cap,
+		      unsigned int width, unsigned int threshold)
+{
+	unsigned int x;
+	int count = 0;
+
+	for (x = 0; x < width; x++) {
+		errors[x] = error_pixel(ref, cap, x, threshold);
+		count += errors[x];
+	}
+
+	return count;
+}
+
+static const struct frame_row_ops frame_row_ops_generic = {
+	.absdiff = absdiff_row,
+	.edges = edges_row,
+	.errors = errors_row,
+};
+
+#if defined(__x86_64__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+
+static inline __m256i absdiff_epu8_avx2(__m256i a, __m256i b)
+{
+	return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+}
+
+static void absdiff_row_avx2(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+			     unsigned int len)
+{
+	unsigned int i;
+
+	for (i = 0; i + 32 <= len; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    absdiff_epu8_avx2(va, vb));
+	}
+
+	absdiff_row(dst + i, a + i, b + i, len - i);
+}
+
+/* Sum the three color components of each of 8 XR24 pixels */
+static inline __m256i sum_rgb_avx2(__m256i v)
+{
+	v = _mm256_and_si256(v, _mm256_set1_epi32(0x00ffffff));
+	v = _mm256_maddubs_epi16(v, _mm256_set1_epi8(1));
+
+	return _mm256_madd_epi16(v, _mm256_set1_epi16(1));
+}
+
+static void edges_row_avx2(uint8_t *edges, const uint8_t *row,
+			   const uint8_t *above, const uint8_t *below,
+			   unsigned int width, unsigned int span,
+			   unsigned int threshold)
+{
+	const __m256i thr = _mm256_set1_epi32(threshold);
+	unsigned int x, k, mask;
+
+	for (x = 0; x < span && x < width; x++)
+		edges[x] = 0;
+
+	for (; x + 8 + span <= width; x += 8) {
+		__m256i xd, yd, m;
+
+		xd = absdiff_epu8_avx2(
+			_mm256_loadu_si256((const __m256i *)(row + 4 * (x + span))),
+			_mm256_loadu_si256((const __m256i *)(row + 4 * (x - span))));
+		yd = absdiff_epu8_avx2(
+			_mm256_loadu_si256((const __m256i *)(below + 4 * x)),
+			_mm256_loadu_si256((const __m256i *)(above + 4 * x)));
+
+		m = _mm256_or_si256(_mm256_cmpgt_epi32(sum_rgb_avx2(xd), thr),
+				    _mm256_cmpgt_epi32(sum_rgb_avx2(yd), thr));
+		mask = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+
+		for (k = 0; k < 8; k++)
+			edges[x + k] = (mask >> k) & 1;
+	}
+
+	for (; x < width; x++) {
+		if (x > (width - span - 1))
+			edges[x] = 0;
+		else
+			edges[x] = edge_pixel(row, above, below, x,
+					      span, threshold);
+	}
+}
+
+static int errors_row_avx2(uint8_t *errors, const uint8_t *ref,
+			   const uint8_t *cap, unsigned int width,
+			   unsigned int threshold)
+{
+	const __m256i thr = _mm256_set1_epi8(threshold);
+	const __m256i rgb = _mm256_set1_epi32(0x00ffffff);
+	unsigned int x, k, mask;
+	int count = 0;
+
+	/* Component differences are compared as saturated bytes */
+	if (threshold > 255)
+		return -EINVAL;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		__m256i d;
+
+		d = absdiff_epu8_avx2(
+			_mm256_loadu_si256((const __m256i *)(ref + 4 * x)),
+			_mm256_loadu_si256((const __m256i *)(cap + 4 * x)));
+		d = _mm256_and_si256(_mm256_subs_epu8(d, thr), rgb);
+		d = _mm256_cmpeq_epi32(d, _mm256_setzero_si256());
+		mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(d)) & 0xff;
+
+		for (k = 0; k < 8; k++)
+			errors[x + k] = (mask >> k) & 1;
+		count += __builtin_popcount(mask);
+	}
+
+	return count + errors_row(errors + x, ref + 4 * x, cap + 4 * x,
+				  width - x, threshold);
+}
+
+#pragma GCC pop_options
+
+static const struct frame_row_ops frame_row_ops_avx2 = {
+	.absdiff = absdiff_row_avx2,
+	.edges = edges_row_avx2,
+	.errors = errors_row_avx2,
+};
+#endif
+
+static const struct frame_row_ops *frame_row_ops(void)
+{
+#if defined(__x86_64__) && !defined(__clang__)
+	if (igt_x86_features() & AVX2)
+		return &frame_row_ops_avx2;
+#endif
+
+	return &frame_row_ops_generic;
+}
+
+/* Minimum number of rows worth handing over to a thread */
+#define FRAME_ROWS_PER_THREAD 64
+
+static void rows_for_worker(unsigned int height, unsigned int idx,
+			    unsigned int count, unsigned int *y0,
+			    unsigned int *y1)
+{
+	*y0 = (uint64_t)height * idx / count;
+	*y1 = (uint64_t)height * (idx + 1) / count;
+}
+
+struct analog_match {
+	const struct frame_row_ops *ops;
+	const uint8_t *reference;
+	const uint8_t *capture;
+	unsigned int width, height;
+
+	/* Per-worker row of absolute differences */
+	uint8_t *diff;
+
+	/* Per-worker absolute error sum and count for each color value */
+	struct analog_histogram {
+		uint64_t error[3][256];
+		uint64_t count[3][256];
+	} *histograms;
+};
+
+static void analog_match_worker(void *data, unsigned int idx,
+				unsigned int count)
+{
+	struct analog_match *m = data;
+	struct analog_histogram *hist = &m->histograms[idx];
+	unsigned int stride = m->width * 4;
+	uint8_t *diff = m->diff + idx * stride;
+	const uint8_t *q, *d;
+	unsigned int x, y, y0, y1, i;
+
+	rows_for_worker(m->height, idx, count, &y0, &y1);
+	for (y = y0; y < y1; y++) {
+		q = m->reference + y * stride;
+		m->ops->absdiff(diff, m->capture + y * stride, q, stride);
+
+		for (x = 0, d = diff; x < m->width; x++, q += 4, d += 4) {
+			for (i = 0; i < 3; i++) {
+				hist->error[i][q[i]] += d[i];
+				hist->count[i][q[i]]++;
+			}
+		}
+	}
+}
+
 /**
  * igt_check_analog_frame_match:
  * @reference: The reference cairo surface
@@ -170,19 +446,16 @@ bool igt_check_analog_frame_match(cairo_surface_t *reference,
 				  cairo_surface_t *capture)
 {
 	pixman_image_t *reference_src, *capture_src;
-	int w, h;
-	int error_count[3][256][2] = { 0 };
+	struct analog_match m = {};
+	uint64_t error_count[3][256][2] = {};
 	double error_average[4][250];
 	double error_trend[250];
 	double c0, c1, cov00, cov01, cov11, sumsq;
 	double correlation;
-	unsigned char *reference_pixels, *capture_pixels;
-	unsigned char *p;
-	unsigned char *q;
+	unsigned int threads;
 	bool match = true;
-	int diff;
-	int x, y;
-	int i, j;
+	int w, h;
+	int i, j, k;
 
 	w = cairo_image_surface_get_width(reference);
 	h = cairo_image_surface_get_height(reference);
@@ -191,30 +464,39 @@ bool igt_check_analog_frame_match(cairo_surface_t *reference,
 	    PIXMAN_x8r8g8b8, w, h,
 	    (void*)cairo_image_surface_get_data(reference),
 	    cairo_image_surface_get_stride(reference));
-	reference_pixels = (unsigned char *) pixman_image_get_data(reference_src);
 
 	capture_src = pixman_image_create_bits(
 	    PIXMAN_x8r8g8b8, w, h,
 	    (void*)cairo_image_surface_get_data(capture),
 	    cairo_image_surface_get_stride(capture));
-	capture_pixels = (unsigned char *) pixman_image_get_data(capture_src);
-
-	/* Collect the absolute error for each color value */
-	for (x = 0; x < w; x++) {
-		for (y = 0; y < h; y++) {
-			p = &capture_pixels[(x + y * w) * 4];
-			q = &reference_pixels[(x + y * w) * 4];
-
-			for (i = 0; i < 3; i++) {
-				diff = (int) p[i] - q[i];
-				if (diff < 0)
-					diff = -diff;
 
-				error_count[i][q[i]][0] += diff;
-				error_count[i][q[i]][1]++;
+	/*
+	 * Collect the absolute error for each color value, in a single pass
+	 * over the frame split by rows across threads.
+	 */
+	m.ops = frame_row_ops();
+	m.reference = (uint8_t *) pixman_image_get_data(reference_src);
+	m.capture = (uint8_t *) pixman_image_get_data(capture_src);
+	m.width = w;
+	m.height = h;
+
+	threads = igt_thread_parallel_count(h, FRAME_ROWS_PER_THREAD);
+	m.histograms = calloc(threads, sizeof(*m.histograms));
+	m.diff = malloc(threads * m.width * 4);
+	igt_assert(m.histograms && m.diff);
+
+	igt_thread_parallel(threads, analog_match_worker, &m);
+
+	for (k = 0; k < threads; k++) {
+		for (i = 0; i < 3; i++) {
+			for (j = 0; j < 256; j++) {
+				error_count[i][j][0] += m.histograms[k].error[i][j];
+				error_count[i][j][1] += m.histograms[k].count[i][j];
 			}
 		}
 	}
+	free(m.histograms);
+	free(m.diff);
 
 	/* Calculate the average absolute error for each color value */
 	for (i = 0; i < 250; i++) {
@@ -268,8 +550,104 @@ complete:
 	return match;
 }
 
-#define XR24_COLOR_VALUE(data, stride, x, y, c) \
-	*((uint8_t *)(data) + (y) * (stride) + 4 * (x) + (c))
+struct checkerboard_match {
+	const struct frame_row_ops *ops;
+	const uint8_t *ref_data, *cap_data;
+	unsigned int ref_stride, cap_stride;
+	unsigned int width, height;
+	unsigned int span;
+	unsigned int edge_threshold;
+	unsigned int color_error_threshold;
+
+	struct checkerboard_count {
+		unsigned long errors;
+		unsigned long pixels;
+		int failed;
+	} *counts;
+};
+
+static void checkerboard_match_worker(void *data, unsigned int idx,
+				      unsigned int count)
+{
+	struct checkerboard_match *m = data;
+	struct checkerboard_count *result = &m->counts[idx];
+	unsigned int width = m->width, height = m->height, span = m->span;
+	unsigned int x, y, y0, y1, e0, e1;
+	uint8_t *edges_map, *errors_row;
+	const uint8_t *row;
+
+	rows_for_worker(height, idx, count, &y0, &y1);
+
+	/*
+	 * Edges are needed up to span rows above and below our band, so
+	 * compute them for the band plus that margin.
+	 */
+	e0 = y0 > span ? y0 - span : 0;
+	e1 = min(y1 + span, height);
+
+	edges_map = calloc(e1 - e0, width);
+	errors_row = malloc(width);
+	if (!edges_map || !errors_row) {
+		result->failed = -ENOMEM;
+		goto out;
+	}
+
+#define EDGES(x, y) edges_map[((y) - e0) * width + (x)]
+
+	/* First pass to detect the pattern edges. */
+	for (y = e0; y < e1; y++) {
+		if (y < span || y > (height - span - 1))
+			continue;
+
+		row = m->ref_data + y * m->ref_stride;
+		m->ops->edges(&EDGES(0, y), row,
+			      row - span * m->ref_stride,
+			      row + span * m->ref_stride,
+			      width, span, m->edge_threshold);
+	}
+
+	/* Second pass to detect errors. */
+	for (y = y0; y < y1; y++) {
+		int ret;
+
+		ret = m->ops->errors(errors_row,
+				     m->ref_data + y * m->ref_stride,
+				     m->cap_data + y * m->cap_stride,
+				     width, m->color_error_threshold);
+		if (ret < 0) {
+			result->failed = ret;
+			goto out;
+		}
+
+		for (x = 0; x < width; x++) {
+			bool error = errors_row[x];
+
+			if (EDGES(x, y))
+				continue;
+
+			/* Allow error if coming on or off an edge (on x). */
+			if (error && x >= span && x <= (width - span - 1) &&
+			    EDGES(x - span, y) != EDGES(x + span, y))
+				continue;
+
+			/* Allow error if coming on or off an edge (on y). */
+			if (error && y >= span && y <= (height - span - 1) &&
+			    EDGES(x, y - span) != EDGES(x, y + span))
+				continue;
+
+			if (error)
+				result->errors++;
+
+			result->pixels++;
+		}
+	}
+
+#undef EDGES
+
+out:
+	free(errors_row);
+	free(edges_map);
+}
 
 /**
  * igt_check_checkerboard_frame_match:
@@ -303,94 +681,46 @@ complete:
 bool igt_check_checkerboard_frame_match(cairo_surface_t *reference,
 					cairo_surface_t *capture)
 {
-	unsigned int width, height, ref_stride, cap_stride;
-	void *ref_data, *cap_data;
-	unsigned char *edges_map;
-	unsigned int x, y, c;
-	unsigned int errors = 0, pixels = 0;
-	unsigned int edge_threshold = 100;
-	unsigned int color_error_threshold = 24;
+	struct checkerboard_match m = {};
+	unsigned int threads, i;
+	unsigned long errors = 0, pixels = 0;
 	double error_rate_threshold = 0.01;
 	double error_rate;
-	unsigned int span = 2;
 	bool match = false;
 
-	width = cairo_image_surface_get_width(reference);
-	height = cairo_image_surface_get_height(reference);
-
-	ref_stride = cairo_image_surface_get_stride(reference);
-	ref_data = cairo_image_surface_get_data(reference);
-	igt_assert(ref_data);
-
-	cap_stride = cairo_image_surface_get_stride(capture);
-	cap_data = cairo_image_surface_get_data(capture);
-	igt_assert(cap_data);
-
-	edges_map = calloc(1, width * height);
-	igt_assert(edges_map);
-
-	/* First pass to detect the pattern edges. */
-	for (y = 0; y < height; y++) {
-		if (y < span || y > (height - span - 1))
-			continue;
-
-		for (x = 0; x < width; x++) {
-			unsigned int xdiff = 0, ydiff = 0;
-
-			if (x < span || x > (width - span - 1))
-				continue;
-
-			for (c = 0; c < 3; c++) {
-				xdiff += abs(XR24_COLOR_VALUE(ref_data, ref_stride, x + span, y, c) -
-					     XR24_COLOR_VALUE(ref_data, ref_stride, x - span, y, c));
-				ydiff += abs(XR24_COLOR_VALUE(ref_data, ref_stride, x, y + span, c) -
-					     XR24_COLOR_VALUE(ref_data, ref_stride, x, y - span, c));
-			}
-
-			edges_map[y * width + x] = (xdiff > edge_threshold ||
-						    ydiff > edge_threshold);
-		}
-	}
-
-	/* Second pass to detect errors. */
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			bool error = false;
-
-			if (edges_map[y * width + x])
-				continue;
-
-			for (c = 0; c < 3; c++) {
-				unsigned int diff;
-
-				/* Compare the reference and capture values. */
-				diff = abs(XR24_COLOR_VALUE(ref_data, ref_stride, x, y, c) -
-					   XR24_COLOR_VALUE(cap_data, cap_stride, x, y, c));
-
-				if (diff > color_error_threshold)
-					error = true;
-			}
-
-			/* Allow error if coming on or off an edge (on x). */
-			if (error && x >= span && x <= (width - span - 1) &&
-			    edges_map[y * width + (x - span)] !=
-			    edges_map[y * width + (x + span)])
-				continue;
+	m.ops = frame_row_ops();
+	m.width = cairo_image_surface_get_width(reference);
+	m.height = cairo_image_surface_get_height(reference);
+	m.span = 2;
+	m.edge_threshold = 100;
+	m.color_error_threshold = 24;
 
-			/* Allow error if coming on or off an edge (on y). */
-			if (error && y >= span && y <= (height - span - 1) &&
-			    edges_map[(y - span) * width + x] !=
-			    edges_map[(y + span) * width + x] && error)
-				continue;
+	m.ref_stride = cairo_image_surface_get_stride(reference);
+	m.ref_data = cairo_image_surface_get_data(reference);
+	igt_assert(m.ref_data);
 
-			if (error)
-				errors++;
+	m.cap_stride = cairo_image_surface_get_stride(capture);
+	m.cap_data = cairo_image_surface_get_data(capture);
+	igt_assert(m.cap_data);
 
-			pixels++;
-		}
+	/*
+	 * Edge detection and error counting are done in a single pass per
+	 * band of rows, with the bands split across threads.
+	 */
+	threads = igt_thread_parallel_count(m.height, FRAME_ROWS_PER_THREAD);
+	m.counts = calloc(threads, sizeof(*m.counts));
+	igt_assert(m.counts);
+
+	igt_thread_parallel(threads, checkerboard_match_worker, &m);
+
+	for (i = 0; i < threads; i++) {
+		igt_assert_f(!m.counts[i].failed,
+			     "Checkerboard comparison of rows band %u failed: %s\n",
+			     i, strerror(-m.counts[i].failed));
+		errors += m.counts[i].errors;
+		pixels += m.counts[i].pixels;
 	}
-
-	free(edges_map);
+	free(m.counts);
 
 	error_rate = (double) errors / pixels;
 
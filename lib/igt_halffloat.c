@@ -26,6 +26,7 @@
 #include <math.h>
 
 #include "igt_halffloat.h"
+#include "igt_thread.h"
 #include "igt_x86.h"
 
 typedef union { float f; int32_t i; uint32_t u; } fi_type;
@@ -162,73 +163,309 @@ static inline float _half_to_float(uint16_t val)
 	return fi.f;
 }
 
+/*
+ * Row converters. num is the number of values, and when swz is non-NULL the
+ * values are treated as 4 channel pixels whose channels are swizzled as
+ * dst[k] = src[swz[k]] on the way.
+ */
+typedef void (*float_to_half_row_fn)(const float *f, uint16_t *h,
+				     unsigned int num,
+				     const unsigned char *swz);
+typedef void (*half_to_float_row_fn)(const uint16_t *h, float *f,
+				     unsigned int num,
+				     const unsigned char *swz);
+
+static void float_to_half(const float *f, uint16_t *h, unsigned int num,
+			  const unsigned char *swz)
+{
+	unsigned int i, k;
+
+	if (!swz) {
+		for (i = 0; i < num; i++)
+			h[i] = _float_to_half(f[i]);
+		return;
+	}
+
+	for (i = 0; i < num; i += 4)
+		for (k = 0; k < 4; k++)
+			h[i + k] = _float_to_half(f[i + swz[k]]);
+}
+
+static void half_to_float(const uint16_t *h, float *f, unsigned int num,
+			  const unsigned char *swz)
+{
+	unsigned int i, k;
+
+	if (!swz) {
+		for (i = 0; i < num; i++)
+			f[i] = _half_to_float(h[i]);
+		return;
+	}
+
+	for (i = 0; i < num; i += 4)
+		for (k = 0; k < 4; k++)
+			f[i + k] = _half_to_float(h[i + swz[k]]);
+}
+
 #if defined(__x86_64__) && !defined(__clang__)
 #pragma GCC push_options
-#pragma GCC target("f16c")
+#pragma GCC target("avx,f16c")
 
 #include <immintrin.h>
 
-static void float_to_half_f16c(const float *f, uint16_t *h, unsigned int num)
+static const unsigned char swizzle_identity[4] = { 0, 1, 2, 3 };
+
+static void float_to_half_f16c(const float *f, uint16_t *h, unsigned int num,
+			       const unsigned char *swz)
 {
-	for (int i = 0; i < num; i++)
-		h[i] = _cvtss_sh(f[i], 0);
+	const unsigned char *s = swz ?: swizzle_identity;
+	const __m256i idx = _mm256_setr_epi32(s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3]);
+	unsigned int i, k;
+
+	for (i = 0; i + 8 <= num; i += 8) {
+		__m256 v = _mm256_permutevar_ps(_mm256_loadu_ps(f + i), idx);
+
+		_mm_storeu_si128((__m128i *)(h + i), _mm256_cvtps_ph(v, 0));
+	}
+
+	/* With a swizzle, num is a multiple of 4 and so is the tail */
+	for (; i < num; i += k)
+		for (k = 0; k < 4 && i + k < num; k++)
+			h[i + k] = _cvtss_sh(f[i + (swz ? swz[k] : k)], 0);
+
+	_mm256_zeroupper();
 }
 
-static void half_to_float_f16c(const uint16_t *h, float *f, unsigned int num)
+static void half_to_float_f16c(const uint16_t *h, float *f, unsigned int num,
+			       const unsigned char *swz)
 {
-	for (int i = 0; i < num; i++)
-		f[i] = _cvtsh_ss(h[i]);
+	const unsigned char *s = swz ?: swizzle_identity;
+	const __m256i idx = _mm256_setr_epi32(s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3]);
+	unsigned int i, k;
+
+	for (i = 0; i + 8 <= num; i += 8) {
+		__m256 v = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(h + i)));
+
+		_mm256_storeu_ps(f + i, _mm256_permutevar_ps(v, idx));
+	}
+
+	for (; i < num; i += k)
+		for (k = 0; k < 4 && i + k < num; k++)
+			f[i + k] = _cvtsh_ss(h[i + (swz ? swz[k] : k)]);
+
+	_mm256_zeroupper();
 }
 
 #pragma GCC pop_options
 
-static void float_to_half(const float *f, uint16_t *h, unsigned int num)
+#pragma GCC push_options
+#pragma GCC target("avx512f,f16c")
+
+/*
+ * 16 values at a time. The AVX-512F vcvtps2ph/vcvtph2ps use the same
+ * round-to-nearest-even conversion as F16C, only wider.
+ */
+static void float_to_half_avx512(const float *f, uint16_t *h,
+				 unsigned int num, const unsigned char *swz)
 {
-	for (int i = 0; i < num; i++)
-		h[i] = _float_to_half(f[i]);
+	const unsigned char *s = swz ?: swizzle_identity;
+	const __m512i idx = _mm512_setr_epi32(s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3]);
+	unsigned int i;
+
+	for (i = 0; i + 16 <= num; i += 16) {
+		__m512 v = _mm512_permutevar_ps(_mm512_loadu_ps(f + i), idx);
+
+		_mm256_storeu_si256((__m256i *)(h + i), _mm512_cvtps_ph(v, 0));
+	}
+
+	_mm256_zeroupper();
+
+	float_to_half_f16c(f + i, h + i, num - i, swz);
 }
 
-static void half_to_float(const uint16_t *h, float *f, unsigned int num)
+static void half_to_float_avx512(const uint16_t *h, float *f,
+				 unsigned int num, const unsigned char *swz)
 {
-	for (int i = 0; i < num; i++)
-		f[i] = _half_to_float(h[i]);
+	const unsigned char *s = swz ?: swizzle_identity;
+	const __m512i idx = _mm512_setr_epi32(s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3],
+					      s[0], s[1], s[2], s[3]);
+	unsigned int i;
+
+	for (i = 0; i + 16 <= num; i += 16) {
+		__m512 v = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)(h + i)));
+
+		_mm512_storeu_ps(f + i, _mm512_permutevar_ps(v, idx));
+	}
+
+	_mm256_zeroupper();
+
+	half_to_float_f16c(h + i, f + i, num - i, swz);
 }
 
-static void (*resolve_float_to_half(void))(const float *f, uint16_t *h, unsigned int num)
+#pragma GCC pop_options
+
+static float_to_half_row_fn resolve_float_to_half_row(void)
 {
-	if (igt_x86_features() & F16C)
+	unsigned features = igt_x86_features();
+
+	if ((features & (AVX512 | F16C)) == (AVX512 | F16C))
+		return float_to_half_avx512;
+
+	if ((features & (AVX | F16C)) == (AVX | F16C))
 		return float_to_half_f16c;
 
 	return float_to_half;
 }
 
-void igt_float_to_half(const float *f, uint16_t *h, unsigned int num)
-	__attribute__((ifunc("resolve_float_to_half")));
-
-static void (*resolve_half_to_float(void))(const uint16_t *h, float *f, unsigned int num)
+static half_to_float_row_fn resolve_half_to_float_row(void)
 {
-	if (igt_x86_features() & F16C)
+	unsigned features = igt_x86_features();
+
+	if ((features & (AVX512 | F16C)) == (AVX512 | F16C))
+		return half_to_float_avx512;
+
+	if ((features & (AVX | F16C)) == (AVX | F16C))
 		return half_to_float_f16c;
 
 	return half_to_float;
 }
 
-void igt_half_to_float(const uint16_t *h, float *f, unsigned int num)
-	__attribute__((ifunc("resolve_half_to_float")));
+static void float_to_half_row(const float *f, uint16_t *h, unsigned int num,
+			      const unsigned char *swz)
+	__attribute__((ifunc("resolve_float_to_half_row")));
+
+static void half_to_float_row(const uint16_t *h, float *f, unsigned int num,
+			      const unsigned char *swz)
+	__attribute__((ifunc("resolve_half_to_float_row")));
 
 #else
 
+static void float_to_half_row(const float *f, uint16_t *h, unsigned int num,
+			      const unsigned char *swz)
+{
+	float_to_half(f, h, num, swz);
+}
+
+static void half_to_float_row(const uint16_t *h, float *f, unsigned int num,
+			      const unsigned char *swz)
+{
+	half_to_float(h, f, num, swz);
+}
+
+#endif
+
 void igt_float_to_half(const float *f, uint16_t *h, unsigned int num)
 {
-	for (int i = 0; i < num; i++)
-		h[i] = _float_to_half(f[i]);
+	float_to_half_row(f, h, num, NULL);
 }
 
 void igt_half_to_float(const uint16_t *h, float *f, unsigned int num)
 {
-	for (int i = 0; i < num; i++)
-		f[i] = _half_to_float(h[i]);
+	half_to_float_row(h, f, num, NULL);
 }
 
-#endif
+/* Minimum number of pixels worth handing over to a thread */
+#define PIXELS_PER_THREAD (1 << 20)
+
+struct halffloat_2d {
+	const void *src;
+	void *dst;
+	unsigned int src_stride, dst_stride;
+	unsigned int width, height;
+	const unsigned char *swz;
+	bool to_half;
+};
+
+static void halffloat_2d_worker(void *data, unsigned int idx,
+				unsigned int count)
+{
+	const struct halffloat_2d *c = data;
+	unsigned int y0 = (uint64_t)c->height * idx / count;
+	unsigned int y1 = (uint64_t)c->height * (idx + 1) / count;
+	const char *src = (const char *)c->src + (size_t)y0 * c->src_stride;
+	char *dst = (char *)c->dst + (size_t)y0 * c->dst_stride;
+	unsigned int y;
 
+	for (y = y0; y < y1; y++) {
+		if (c->to_half)
+			float_to_half_row((const float *)src, (uint16_t *)dst,
+					  c->width * 4, c->swz);
+		else
+			half_to_float_row((const uint16_t *)src, (float *)dst,
+					  c->width * 4, c->swz);
+
+		src += c->src_stride;
+		dst += c->dst_stride;
+	}
+}
+
+static void halffloat_2d(struct halffloat_2d *c)
+{
+	igt_thread_parallel(igt_thread_parallel_count((size_t)c->width *
+						      c->height,
+						      PIXELS_PER_THREAD),
+			    halffloat_2d_worker, c);
+}
+
+/**
+ * igt_float_to_half_2d:
+ * @f: source surface of 4 channel float pixels
+ * @f_stride: stride of @f in bytes
+ * @h: destination surface of 4 channel half float pixels
+ * @h_stride: stride of @h in bytes
+ * @width: width of the surfaces in pixels
+ * @height: height of the surfaces in pixels
+ * @swz: optional channel swizzle, with h[k] converted from f[swz[k]]
+ *
+ * Convert a whole strided surface at once, without intermediate copies.
+ * Large surfaces are split by rows across threads.
+ */
+void igt_float_to_half_2d(const float *f, unsigned int f_stride,
+			  uint16_t *h, unsigned int h_stride,
+			  unsigned int width, unsigned int height,
+			  const unsigned char *swz)
+{
+	struct halffloat_2d c = {
+		.src = f, .src_stride = f_stride,
+		.dst = h, .dst_stride = h_stride,
+		.width = width, .height = height,
+		.swz = swz, .to_half = true,
+	};
+
+	halffloat_2d(&c);
+}
+
+/**
+ * igt_half_to_float_2d:
+ * @h: source surface of 4 channel half float pixels
+ * @h_stride: stride of @h in bytes
+ * @f: destination surface of 4 channel float pixels
+ * @f_stride: stride of @f in bytes
+ * @width: width of the surfaces in pixels
+ * @height: height of the surfaces in pixels
+ * @swz: optional channel swizzle, with f[k] converted from h[swz[k]]
+ *
+ * Convert a whole strided surface at once, without intermediate copies.
+ * Large surfaces are split by rows across threads.
+ */
+void igt_half_to_float_2d(const uint16_t *h, unsigned int h_stride,
+			  float *f, unsigned int f_stride,
+			  unsigned int width, unsigned int height,
+			  const unsigned char *swz)
+{
+	struct halffloat_2d c = {
+		.src = h, .src_stride = h_stride,
+		.dst = f, .dst_stride = f_stride,
+		.width = width, .height = height,
+		.swz = swz, .to_half = false,
+	};
+
+	halffloat_2d(&c);
+}
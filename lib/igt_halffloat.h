@@ -24,4 +24,12 @@
 
 void igt_float_to_half(const float *f, uint16_t *h, unsigned int num);
 void igt_half_to_float(const uint16_t *h, float *f, unsigned int num);
+void igt_float_to_half_2d(const float *f, unsigned int f_stride,
+			  uint16_t *h, unsigned int h_stride,
+			  unsigned int width, unsigned int height,
+			  const unsigned char *swz);
+void igt_half_to_float_2d(const uint16_t *h, unsigned int h_stride,
+			  float *f, unsigned int f_stride,
+			  unsigned int width, unsigned int height,
+			  const unsigned char *swz);
 
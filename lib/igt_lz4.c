@@ -0,0 +1,287 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "igt_lz4.h"
+
+/**
+ * SECTION:igt_lz4
+ * @short_description: LZ4 block compression
+ * @title: LZ4
+ * @include: igt_lz4.h
+ *
+ * A small, dependency free implementation of the LZ4 block format, for
+ * tools which want to store large amounts of data with little CPU
+ * overhead. The output can be decoded by any LZ4 block decoder and vice
+ * versa. Framing, checksums and dictionaries are left to the callers.
+ *
+ * This file deliberately depends on nothing else in the library so that it
+ * can also be built into preloaded modules such as gem_exec_tracer.
+ */
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MF_LIMIT 12
+#define MAX_OFFSET 65535
+#define HASH_BITS 13
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned int hash32(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *op, size_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = len;
+
+	return op;
+}
+
+/* Emits one sequence, returns NULL if it does not fit. */
+static uint8_t *
+put_sequence(uint8_t *op, const uint8_t *oend,
+	     const uint8_t *literals, size_t nlit,
+	     size_t offset, size_t match, bool last)
+{
+	size_t need = 1 + nlit / 255 + 1 + nlit;
+
+	if (!last)
+		need += 2 + match / 255 + 1;
+	if (need > (size_t)(oend - op))
+		return NULL;
+
+	*op++ = (nlit < 15 ? nlit : 15) << 4 |
+		(last ? 0 : match < 15 ? match : 15);
+	if (nlit >= 15)
+		op = put_length(op, nlit - 15);
+
+	memcpy(op, literals, nlit);
+	op += nlit;
+
+	if (last)
+		return op;
+
+	*op++ = offset;
+	*op++ = offset >> 8;
+	if (match >= 15)
+		op = put_length(op, match - 15);
+
+	return op;
+}
+
+/**
+ * igt_lz4_compress_bound:
+ * @len: size of the uncompressed data
+ *
+ * Returns: The worst case compressed size of @len bytes, for sizing the
+ * destination of igt_lz4_compress().
+ */
+size_t igt_lz4_compress_bound(size_t len)
+{
+	return len + len / 255 + 16;
+}
+
+/**
+ * igt_lz4_compress:
+ * @src: data to compress
+ * @len: size of @src
+ * @dst: destination buffer
+ * @size: size of @dst
+ *
+ * Compresses @src into a single LZ4 block using a fast, greedy matcher.
+ *
+ * Returns: The size of the compressed block, or -1 if it does not fit into
+ * @size bytes, in which case storing the data uncompressed is smaller
+ * anyway when @size is @len.
+ */
+ssize_t igt_lz4_compress(const void *src, size_t len, void *dst, size_t size)
+{
+	const uint8_t *base = src, *ip = src, *anchor = src;
+	const uint8_t *iend = base + len;
+	uint8_t *op = dst, *oend = op + size;
+	uint32_t table[1 << HASH_BITS];
+
+	if (len > MF_LIMIT) {
+		const uint8_t *mflimit = iend - MF_LIMIT;
+		const uint8_t *matchlimit = iend - LAST_LITERALS;
+
+		memset(table, 0, sizeof(table));
+
+		while (ip <= mflimit) {
+			uint32_t seq = read32(ip);
+			unsigned int h = hash32(seq);
+			const uint8_t *ref = base + table[h];
+			const uint8_t *end;
+
+			table[h] = ip - base;
+
+			if (ref >= ip || ip - ref > MAX_OFFSET ||
+			    read32(ref) != seq) {
+				/* Skip faster through incompressible data. */
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			end = ip + MIN_MATCH;
+			while (end < matchlimit && *end == ref[end - ip])
+				end++;
+
+			while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+				ip--;
+				ref--;
+			}
+
+			op = put_sequence(op, oend, anchor, ip - anchor,
+					  ip - ref, end - ip - MIN_MATCH,
+					  false);
+			if (!op)
+				return -1;
+
+			/* Prime the table inside the match for the next one. */
+			if (end - 2 > base)
+				table[hash32(read32(end - 2))] = end - 2 - base;
+
+			ip = anchor = end;
+		}
+	}
+
+	op = put_sequence(op, oend, anchor, iend - anchor, 0, 0, true);
+	if (!op)
+		return -1;
+
+	return op - (uint8_t *)dst;
+}
+
+static const uint8_t *
+get_length(const uint8_t *ip, const uint8_t *iend, size_t *len)
+{
+	uint8_t b;
+
+	do {
+		if (ip == iend)
+			return NULL;
+
+		b = *ip++;
+		*len += b;
+	} while (b == 255);
+
+	return ip;
+}
+
+/**
+ * igt_lz4_decompress:
+ * @src: LZ4 block
+ * @len: size of @src
+ * @dst: destination buffer
+ * @size: size of @dst
+ *
+ * Decompresses a single LZ4 block. The input is fully validated so it is
+ * safe to use on untrusted or truncated data.
+ *
+ * Returns: The size of the decompressed data, or -1 if @src is malformed or
+ * the data does not fit into @size bytes.
+ */
+ssize_t igt_lz4_decompress(const void *src, size_t len,
+			   void *dst, size_t size)
+{
+	const uint8_t *ip = src, *iend = ip + len;
+	uint8_t *op = dst, *oend = op + size;
+
+	if (!len)
+		return -1;
+
+	while (ip < iend) {
+		uint8_t token = *ip++;
+		size_t nlit = token >> 4;
+		size_t match = token & 15;
+		size_t offset;
+
+		if (nlit == 15 && !(ip = get_length(ip, iend, &nlit)))
+			return -1;
+
+		if (nlit > (size_t)(iend - ip) || nlit > (size_t)(oend - op))
+			return -1;
+
+		/* Most literal runs are short, copy them in one go if we can. */
+		if (nlit <= 16 && iend - ip >= 16 && oend - op >= 16)
+			memcpy(op, ip, 16);
+		else
+			memcpy(op, ip, nlit);
+		op += nlit;
+		ip += nlit;
+
+		/* The last sequence has only literals. */
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -1;
+
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (!offset || offset > (size_t)(op - (uint8_t *)dst))
+			return -1;
+
+		if (match == 15 && !(ip = get_length(ip, iend, &match)))
+			return -1;
+
+		match += MIN_MATCH;
+		if (match > (size_t)(oend - op))
+			return -1;
+
+		if (offset >= 16 && (size_t)(oend - op) >= match + 16) {
+			const uint8_t *ref = op - offset;
+			size_t i;
+
+			/* Each chunk only reads bytes written before it. */
+			for (i = 0; i < match; i += 16)
+				memcpy(op + i, ref + i, 16);
+			op += match;
+		} else if (offset >= match) {
+			memcpy(op, op - offset, match);
+			op += match;
+		} else {
+			const uint8_t *ref = op - offset;
+
+			while (match--)
+				*op++ = *ref++;
+		}
+	}
+
+	return op - (uint8_t *)dst;
+}
@@ -0,0 +1,675 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_name_filter.h"
+#include "uwildmat/uwildmat.h"
+
+/**
+ * SECTION:igt_name_filter
+ * @short_description: Match test names against many patterns at once
+ * @title: Name filter
+ * @include: igt_name_filter.h
+ *
+ * A name filter answers whether a test name is selected by a list of
+ * patterns, without trying every pattern in turn. It is used for the
+ * --run-subtest wildmats of the test binaries and the include/exclude
+ * regular expressions of igt_runner, both of which can carry thousands
+ * of patterns when generated from CI testlists.
+ *
+ * Each pattern is split into its leading literal and the remainder.
+ * The literals are stored in a prefix trie, so only patterns whose
+ * literal occurs in the name are looked at; the remainder is matched as
+ * a glob. Regular expressions that are really literals or globs (e.g.
+ * "igt@gem_busy@hang.*") are converted to such patterns, the rest stay
+ * regular expressions but are still only tried when their leading
+ * literal is found in the name.
+ *
+ * Patterns are considered in the order they were added and the last
+ * matching one decides, just like in a wildmat expression: a pattern
+ * negated with '!' rejects the name, any other pattern selects it.
+ */
+
+enum filter_kind {
+	FILTER_EXACT,	/* the literal is the whole name */
+	FILTER_PREFIX,	/* the literal is followed by anything */
+	FILTER_WILDMAT,	/* uwildmat_simple() on the rest of the name */
+	FILTER_GLOB,	/* glob_match() on the rest of the name */
+	FILTER_REGEX,	/* g_regex_match() on the whole name */
+};
+
+struct filter_pattern {
+	enum filter_kind kind;
+	bool reject;
+	unsigned int index;
+	union {
+		char *tail;
+		GRegex *regex;
+	};
+};
+
+struct filter_node {
+	int child, sibling;
+	unsigned char c;
+	unsigned int num_patterns;
+	struct filter_pattern *patterns;
+};
+
+struct filter_trie {
+	struct filter_node *nodes;
+	unsigned int num_nodes, size;
+};
+
+struct igt_name_filter {
+	/* wildmats, matched from the start of the name, case folded */
+	struct filter_trie wildmat;
+	/* regular expressions anchored at the start of the name */
+	struct filter_trie anchored;
+	/* regular expressions whose literal may occur anywhere */
+	struct filter_trie unanchored;
+
+	struct {
+		GRegex *regex;
+		unsigned int index;
+	} *regexes;
+	unsigned int num_regexes;
+	unsigned int num_patterns;
+	bool has_reject;
+};
+
+struct filter_match {
+	const char *name;
+	const char *end;
+	bool first_wins;
+	bool found, reject, done;
+	unsigned int index;
+};
+
+static int trie_node_new(struct filter_trie *trie, unsigned char c)
+{
+	struct filter_node *node;
+
+	if (trie->num_nodes == trie->size) {
+		trie->size = trie->size ? 2 * trie->size : 64;
+		trie->nodes = realloc(trie->nodes,
+				      trie->size * sizeof(*trie->nodes));
+		igt_assert(trie->nodes);
+	}
+
+	node = &trie->nodes[trie->num_nodes];
+	memset(node, 0, sizeof(*node));
+	node->child = -1;
+	node->sibling = -1;
+	node->c = c;
+
+	return trie->num_nodes++;
+}
+
+static struct filter_pattern *
+trie_insert(struct filter_trie *trie, const char *literal, size_t len)
+{
+	struct filter_node *node;
+	int n = 0;
+
+	if (!trie->num_nodes)
+		trie_node_new(trie, 0);
+
+	while (len--) {
+		unsigned char c = *literal++;
+		int child;
+
+		for (child = trie->nodes[n].child;
+		     child != -1 && trie->nodes[child].c != c;
+		     child = trie->nodes[child].sibling)
+			;
+
+		if (child == -1) {
+			child = trie_node_new(trie, c);
+			trie->nodes[child].sibling = trie->nodes[n].child;
+			trie->nodes[n].child = child;
+		}
+
+		n = child;
+	}
+
+	node = &trie->nodes[n];
+	node->patterns = realloc(node->patterns,
+				 (node->num_patterns + 1) * sizeof(*node->patterns));
+	igt_assert(node->patterns);
+
+	return memset(&node->patterns[node->num_patterns++], 0,
+		      sizeof(*node->patterns));
+}
+
+static void trie_fini(struct filter_trie *trie)
+{
+	for (unsigned int n = 0; n < trie->num_nodes; n++) {
+		struct filter_node *node = &trie->nodes[n];
+
+		for (unsigned int i = 0; i < node->num_patterns; i++) {
+			if (node->patterns[i].kind == FILTER_WILDMAT ||
+			    node->patterns[i].kind == FILTER_GLOB)
+				free(node->patterns[i].tail);
+		}
+		free(node->patterns);
+	}
+
+	free(trie->nodes);
+}
+
+/*
+ * Case sensitive glob with only '*', '?' and '\' escapes, as produced
+ * from regular expressions. Matches all of [str, end).
+ */
+static bool glob_match(const char *str, const char *end, const char *pat)
+{
+	const char *star = NULL, *star_str = NULL;
+
+	while (str < end) {
+		if (*pat == '*') {
+			star = ++pat;
+			star_str = str;
+			continue;
+		}
+
+		if (*pat == '?' ||
+		    (*pat == '\\' && pat[1] == *str) ||
+		    (*pat && *pat != '\\' && *pat == *str)) {
+			pat += *pat == '\\' ? 2 : 1;
+			str++;
+			continue;
+		}
+
+		if (!star)
+			return false;
+
+		pat = star;
+		str = ++star_str;
+	}
+
+	while (*pat == '*')
+		pat++;
+
+	return !*pat;
+}
+
+static void match_patterns(const struct filter_node *node,
+			   const char *str, struct filter_match *m)
+{
+	for (unsigned int i = 0; i < node->num_patterns; i++) {
+		const struct filter_pattern *p = &node->patterns[i];
+		bool matched = false;
+
+		/* Only a later pattern can change the outcome */
+		if (m->found && p->index < m->index)
+			continue;
+
+		switch (p->kind) {
+		case FILTER_EXACT:
+			matched = str == m->end;
+			break;
+		case FILTER_PREFIX:
+			matched = true;
+			break;
+		case FILTER_WILDMAT:
+			matched = uwildmat_simple(str, p->tail);
+			break;
+		case FILTER_GLOB:
+			matched = glob_match(str, m->end, p->tail);
+			break;
+		case FILTER_REGEX:
+			matched = g_regex_match(p->regex, m->name, 0, NULL);
+			break;
+		}
+
+		if (matched) {
+			m->found = true;
+			m->reject = p->reject;
+			m->index = p->index;
+			m->done = m->first_wins;
+		}
+	}
+}
+
+/*
+ * Walks the trie along str, trying the patterns of every node on the
+ * way. With fold, a lowercase literal also matches an uppercase
+ * character, like in uwildmat().
+ */
+static void trie_match(const struct filter_trie *trie, int n,
+		       const char *str, bool fold, struct filter_match *m)
+{
+	while (n != -1) {
+		const struct filter_node *node = &trie->nodes[n];
+		unsigned char c, lc;
+		int child, next = -1;
+
+		match_patterns(node, str, m);
+		if (m->done || str == m->end)
+			return;
+
+		c = *str++;
+		lc = fold ? tolower(c) : c;
+
+		for (child = node->child; child != -1;
+		     child = trie->nodes[child].sibling) {
+			if (trie->nodes[child].c != c &&
+			    trie->nodes[child].c != lc)
+				continue;
+
+			/* Both cases present, follow one of them recursively */
+			if (next != -1)
+				trie_match(trie, child, str, fold, m);
+			else
+				next = child;
+		}
+
+		n = next;
+	}
+}
+
+/**
+ * igt_name_filter_create:
+ *
+ * Returns: A new filter without any patterns, which matches nothing.
+ */
+struct igt_name_filter *igt_name_filter_create(void)
+{
+	struct igt_name_filter *filter = calloc(1, sizeof(*filter));
+
+	igt_assert(filter);
+
+	return filter;
+}
+
+/**
+ * igt_name_filter_destroy:
+ * @filter: filter to free
+ *
+ * Frees @filter. Regular expressions passed to
+ * igt_name_filter_add_regex() remain owned by the caller.
+ */
+void igt_name_filter_destroy(struct igt_name_filter *filter)
+{
+	if (!filter)
+		return;
+
+	trie_fini(&filter->wildmat);
+	trie_fini(&filter->anchored);
+	trie_fini(&filter->unanchored);
+	free(filter->regexes);
+	free(filter);
+}
+
+/**
+ * igt_name_filter_add_wildmat:
+ * @filter: filter to extend
+ * @expr: wildmat expression
+ *
+ * Adds the comma-separated wildmat patterns of @expr to @filter. On
+ * its own, the filter then matches exactly what uwildmat() would.
+ */
+void igt_name_filter_add_wildmat(struct igt_name_filter *filter,
+				 const char *expr)
+{
+	const char *p = expr, *end = expr + strlen(expr), *split;
+	bool escaped;
+
+	do {
+		struct filter_pattern *pattern;
+		bool reject = *p == '!';
+		size_t literal;
+
+		if (reject)
+			p++;
+
+		/* Find the first unescaped comma, as uwildmat() does */
+		for (escaped = false, split = p; split < end; split++) {
+			if (*split == '[') {
+				split++;
+				if (*split == ']')
+					split++;
+				while (split < end && *split != ']')
+					split++;
+			}
+			if (*split == ',' && !escaped)
+				break;
+			escaped = (*split == '\\') ? !escaped : false;
+		}
+		if (split > end) /* unterminated class */
+			split = end;
+
+		literal = strcspn(p, "*?[\\,");
+		if (p + literal > split)
+			literal = split - p;
+
+		pattern = trie_insert(&filter->wildmat, p, literal);
+		pattern->reject = reject;
+		pattern->index = filter->num_patterns++;
+
+		if (p + literal == split) {
+			pattern->kind = FILTER_EXACT;
+		} else if (p + literal + 1 == split && p[literal] == '*') {
+			pattern->kind = FILTER_PREFIX;
+		} else {
+			pattern->kind = FILTER_WILDMAT;
+			pattern->tail = strndup(p + literal, split - p - literal);
+		}
+
+		filter->has_reject |= reject;
+		p = split + 1;
+	} while (p <= end);
+}
+
+static bool is_quantifier(char c)
+{
+	return c == '*' || c == '+' || c == '?' || c == '{';
+}
+
+/* Returns the '(' matching the ')' at close, or NULL */
+static const char *group_start(const char *start, const char *close)
+{
+	const char *stack[32];
+	int depth = 0;
+
+	for (const char *p = start; p < close; p++) {
+		switch (*p) {
+		case '\\':
+			if (++p >= close)
+				return NULL;
+			break;
+		case '[':
+			p += p[1] == '^';
+			p += p[1] == ']';
+			while (++p < close && *p != ']')
+				p += *p == '\\';
+			if (p >= close)
+				return NULL;
+			break;
+		case '(':
+			if (depth == ARRAY_SIZE(stack))
+				return NULL;
+			stack[depth++] = p;
+			break;
+		case ')':
+			if (!depth--)
+				return NULL;
+			break;
+		}
+	}
+
+	return depth == 1 ? stack[0] : NULL;
+}
+
+/*
+ * Converts the regular expression [p, end) to a leading literal and a
+ * glob for the rest of the match. Returns false if the expression uses
+ * anything beyond literals, '.', '.*', '.+' and a trailing '$'.
+ */
+static bool regex_to_glob(const char *p, const char *end,
+			  char *literal, size_t *literal_len,
+			  char *glob, bool *anchored_end)
+{
+	bool in_literal = true;
+
+	*literal_len = 0;
+	*glob = '\0';
+	*anchored_end = false;
+
+	while (p < end) {
+		char c = *p++;
+
+		if (c == '.') {
+			if (p < end && (*p == '*' || *p == '+')) {
+				if (p + 1 < end && is_quantifier(p[1]))
+					return false;
+				strcat(glob, *p == '+' ? "?*" : "*");
+				p++;
+			} else if (p < end && is_quantifier(*p)) {
+				return false;
+			} else {
+				strcat(glob, "?");
+			}
+			in_literal = false;
+			continue;
+		}
+
+		if (c == '$' && p == end) {
+			*anchored_end = true;
+			break;
+		}
+
+		if (c == '\\') {
+			if (p == end || isalnum(*p))
+				return false;
+			c = *p++;
+		} else if (strchr("[](){}|*+?^$", c)) {
+			return false;
+		}
+
+		if (p < end && is_quantifier(*p))
+			return false;
+
+		if (in_literal) {
+			literal[(*literal_len)++] = c;
+		} else {
+			size_t len = strlen(glob);
+
+			if (strchr("*?\\", c))
+				glob[len++] = '\\';
+			glob[len++] = c;
+			glob[len] = '\0';
+		}
+	}
+
+	return true;
+}
+
+/*
+ * The literal every match of [p, end) has to start with, used to only
+ * try the regular expression on names containing it.
+ */
+static size_t regex_literal(const char *p, const char *end, char *literal)
+{
+	size_t len = 0;
+	int depth = 0;
+
+	/* A top-level alternative makes nothing mandatory */
+	for (const char *q = p; q < end; q++) {
+		if (*q == '\\')
+			q++;
+		else if (*q == '(')
+			depth++;
+		else if (*q == ')')
+			depth--;
+		else if (*q == '|' && !depth)
+			return 0;
+		else if (*q == '[')
+			return 0; /* don't bother parsing classes */
+	}
+
+	while (p < end) {
+		char c = *p;
+		int skip = 1;
+
+		if (c == '\\') {
+			if (p + 1 == end || isalnum(p[1]))
+				break;
+			c = p[1];
+			skip = 2;
+		} else if (strchr(".[](){}|*+?^$", c)) {
+			break;
+		}
+
+		if (p + skip < end && is_quantifier(p[skip]))
+			break;
+
+		literal[len++] = c;
+		p += skip;
+	}
+
+	return len;
+}
+
+/**
+ * igt_name_filter_add_regex:
+ * @filter: filter to extend
+ * @pattern: the source of @regex
+ * @regex: a compiled regular expression
+ *
+ * Adds a regular expression to @filter, which matches the names
+ * g_regex_match() finds @regex in. @regex must have been compiled from
+ * @pattern without any compile options other than G_REGEX_OPTIMIZE and
+ * must outlive @filter.
+ */
+void igt_name_filter_add_regex(struct igt_name_filter *filter,
+			       const char *pattern, GRegex *regex)
+{
+	size_t len = strlen(pattern), literal_len;
+	const char *p = pattern, *end = pattern + len;
+	char *literal = malloc(len + 1), *glob = malloc(2 * len + 3);
+	struct filter_pattern *fp;
+	bool anchored, anchored_end;
+	struct filter_trie *trie;
+
+	igt_assert(literal && glob);
+
+	filter->regexes = realloc(filter->regexes,
+				  (filter->num_regexes + 1) * sizeof(*filter->regexes));
+	igt_assert(filter->regexes);
+	filter->regexes[filter->num_regexes].regex = regex;
+	filter->regexes[filter->num_regexes].index = filter->num_patterns;
+	filter->num_regexes++;
+
+	anchored = *p == '^';
+	p += anchored;
+
+	/*
+	 * An optional trailing group can always match nothing, so it
+	 * doesn't matter when looking for a match anywhere in the name.
+	 */
+	if (end - p >= 3 && (end[-1] == '?' || end[-1] == '*') &&
+	    end[-2] == ')') {
+		const char *start = group_start(p, end - 2);
+
+		if (start)
+			end = start;
+	}
+
+	if (regex_to_glob(p, end, literal, &literal_len, glob, &anchored_end)) {
+		if (!anchored_end)
+			strcat(glob, "*");
+
+		if (!anchored && !literal_len) {
+			/* Matching anywhere is matching *glob from the start */
+			memmove(glob + 1, glob, strlen(glob) + 1);
+			glob[0] = '*';
+			anchored = true;
+		}
+
+		trie = anchored ? &filter->anchored : &filter->unanchored;
+		fp = trie_insert(trie, literal, literal_len);
+
+		if (!*glob) {
+			fp->kind = FILTER_EXACT;
+		} else if (!strcmp(glob, "*")) {
+			fp->kind = FILTER_PREFIX;
+		} else {
+			fp->kind = FILTER_GLOB;
+			fp->tail = strdup(glob);
+		}
+	} else {
+		/* Restart without dropping the trailing group */
+		end = pattern + len;
+		literal_len = regex_literal(p, end, literal);
+
+		trie = anchored || !literal_len ? &filter->anchored : &filter->unanchored;
+		fp = trie_insert(trie, literal, literal_len);
+		fp->kind = FILTER_REGEX;
+		fp->regex = regex;
+	}
+
+	fp->index = filter->num_patterns++;
+
+	free(glob);
+	free(literal);
+}
+
+/**
+ * igt_name_filter_match:
+ * @filter: filter to match against
+ * @name: name to check
+ *
+ * Returns: True if the last pattern of @filter matching @name selects
+ * it, false if it rejects @name or no pattern matches.
+ */
+bool igt_name_filter_match(const struct igt_name_filter *filter,
+			   const char *name)
+{
+	struct filter_match m = {
+		.name = name,
+		.end = name + strlen(name),
+		.first_wins = !filter->has_reject,
+	};
+
+	if (filter->wildmat.num_nodes)
+		trie_match(&filter->wildmat, 0, name, true, &m);
+
+	if (m.done || !filter->num_regexes)
+		return m.found && !m.reject;
+
+	/*
+	 * '$' matches before a trailing newline and '.' doesn't match a
+	 * newline, so only a trailing one can be handled by stripping it.
+	 */
+	if (m.end > name && m.end[-1] == '\n')
+		m.end--;
+
+	if (memchr(name, '\n', m.end - name)) {
+		for (unsigned int i = 0; i < filter->num_regexes; i++) {
+			if (m.found && filter->regexes[i].index < m.index)
+				continue;
+
+			if (g_regex_match(filter->regexes[i].regex, name, 0, NULL)) {
+				m.found = true;
+				m.reject = false;
+				m.index = filter->regexes[i].index;
+			}
+		}
+
+		return m.found && !m.reject;
+	}
+
+	if (filter->anchored.num_nodes)
+		trie_match(&filter->anchored, 0, name, false, &m);
+
+	for (const char *s = name;
+	     !m.done && filter->unanchored.num_nodes && s < m.end; s++)
+		trie_match(&filter->unanchored, 0, s, false, &m);
+
+	return m.found && !m.reject;
+}
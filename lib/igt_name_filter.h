@@ -0,0 +1,43 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef __IGT_NAME_FILTER_H__
+#define __IGT_NAME_FILTER_H__
+
+#include <stdbool.h>
+#include <glib.h>
+
+struct igt_name_filter;
+
+struct igt_name_filter *igt_name_filter_create(void);
+void igt_name_filter_destroy(struct igt_name_filter *filter);
+
+void igt_name_filter_add_wildmat(struct igt_name_filter *filter,
+				 const char *expr);
+void igt_name_filter_add_regex(struct igt_name_filter *filter,
+			       const char *pattern, GRegex *regex);
+
+bool igt_name_filter_match(const struct igt_name_filter *filter,
+			   const char *name);
+
+#endif /* __IGT_NAME_FILTER_H__ */
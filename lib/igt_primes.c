@@ -23,6 +23,8 @@
 
 #include "igt_primes.h"
 
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
@@ -33,143 +35,295 @@
  * @short_description: Prime numbers helper library
  * @title: Primes
  * @include: igt_primes.h
+ *
+ * Primes are found in a sieve of Eratosthenes stored as a mod 30 wheel: one
+ * byte covers 30 numbers, a bit for each of the 8 residues coprime to 2, 3
+ * and 5. The primes below IGT_PRIMES_TABLE_LIMIT are sieved once, on first
+ * use, into a table shared by all threads. Above it, segments of
+ * IGT_PRIMES_SEGMENT_BYTES are sieved on demand with the primes of the
+ * table, up to the square of IGT_PRIMES_TABLE_LIMIT. Each thread, and each
+ * #igt_primes_iter, sieves into its own segment, so that no locking is
+ * needed; that of a thread is allocated the first time it goes past the
+ * table. Beyond the sieve, primes are found by trial division.
  */
 
-#define BITS_PER_CHAR 8
-#define BITS_PER_LONG (sizeof(long)*BITS_PER_CHAR)
+#define WHEEL 30
+#define TABLE_BYTES (IGT_PRIMES_TABLE_LIMIT / WHEEL)
+#define SEGMENT_SPAN ((uint64_t)IGT_PRIMES_SEGMENT_BYTES * WHEEL)
+#define SIEVE_LIMIT ((uint64_t)IGT_PRIMES_TABLE_LIMIT * IGT_PRIMES_TABLE_LIMIT)
+
+_Static_assert(IGT_PRIMES_TABLE_LIMIT % SEGMENT_SPAN == 0,
+	       "the table must be made of whole segments");
+
+static const uint8_t residues[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
 
-#define BITMAP_FIRST_WORD_MASK(start) (~0UL << ((start) & (BITS_PER_LONG - 1)))
-#define BITMAP_LAST_WORD_MASK(nbits) (~0UL >> (-(nbits) & (BITS_PER_LONG - 1)))
+/* Bit of each residue, -1 for those with a common factor with 30 */
+static const int8_t wheel_bit[WHEEL] = {
+	-1,  0, -1, -1, -1, -1, -1,  1, -1, -1,
+	-1,  2, -1,  3, -1, -1, -1,  4, -1,  5,
+	-1, -1, -1,  6, -1, -1, -1, -1, -1,  7,
+};
 
-#define __round_mask(x, y) ((__typeof__(x))((y)-1))
-#define round_up(x, y) ((((x)-1) | __round_mask(x, y))+1)
-#define round_down(x, y) ((x) & ~__round_mask(x, y))
+/* Bits of the residues from n up */
+static const uint8_t residues_from[WHEEL] = {
+	0xff, 0xff, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfc, 0xfc,
+	0xfc, 0xfc, 0xf8, 0xf8, 0xf0, 0xf0, 0xf0, 0xf0, 0xe0, 0xe0,
+	0xc0, 0xc0, 0xc0, 0xc0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
 
-#define min(x, y) ({                            \
-	typeof(x) _min1 = (x);                  \
-	typeof(y) _min2 = (y);                  \
-	(void) (&_min1 == &_min2);              \
-	_min1 < _min2 ? _min1 : _min2;		\
-})
+static uint8_t table[TABLE_BYTES];
+static pthread_once_t table_once = PTHREAD_ONCE_INIT;
 
-#define max(x, y) ({                            \
-	typeof(x) _max1 = (x);                  \
-	typeof(y) _max2 = (y);                  \
-	(void) (&_max1 == &_max2);              \
-	_max1 > _max2 ? _max1 : _max2;		\
-})
+/* The segments of igt_next_prime_number(), per thread */
+static pthread_key_t segment_key;
+static pthread_once_t segment_once = PTHREAD_ONCE_INIT;
 
-static inline unsigned long __bit__(unsigned long nr)
+static unsigned long slow_next_prime_number(unsigned long x)
 {
-	return 1UL << (nr % BITS_PER_LONG);
+	while (x < ULONG_MAX) {
+		unsigned long y = sqrt(++x) + 1;
+		while (y > 1) {
+			if ((x % y) == 0)
+				break;
+			y--;
+		}
+		if (y == 1)
+			return x;
+	}
+
+	return ULONG_MAX;
 }
 
-static inline void clear_bit(unsigned long nr, unsigned long *addr)
+/* First prime in [from, limit) of the wheel @bits starting at @base, or 0 */
+static uint64_t find_prime(const uint8_t *bits, uint64_t base,
+			   uint64_t from, uint64_t limit)
 {
-	addr[nr / BITS_PER_LONG] &= ~__bit__(nr);
+	uint64_t i = (from - base) / WHEEL, end = (limit - base) / WHEEL;
+	unsigned int b;
+
+	if (i >= end)
+		return 0;
+
+	b = bits[i] & residues_from[(from - base) % WHEEL];
+	while (!b) {
+		if (++i == end)
+			return 0;
+
+		b = bits[i];
+	}
+
+	return base + WHEEL * i + residues[__builtin_ctz(b)];
 }
 
-static unsigned long
-__find_next_bit(const unsigned long *addr,
-		unsigned long nbits, unsigned long start,
-		unsigned long invert)
+/*
+ * Strikes out the multiples of @p from p * p up, skipping those of 2, 3 and
+ * 5: p * q for q of each residue of the wheel, every 30 p, so a byte every p
+ * bytes for the same bit.
+ */
+static void mark_multiples(uint8_t *bits, uint64_t base, uint64_t limit,
+			   uint64_t p)
 {
-	unsigned long tmp;
-
-	if (!nbits || start >= nbits)
-		return nbits;
+	uint64_t q0 = (base + p - 1) / p, bytes = (limit - base) / WHEEL;
+	unsigned int r0;
 
-	tmp = addr[start / BITS_PER_LONG] ^ invert;
+	if (q0 < p)
+		q0 = p;
+	r0 = q0 % WHEEL;
 
-	/* Handle 1st word. */
-	tmp &= BITMAP_FIRST_WORD_MASK(start);
-	start = round_down(start, BITS_PER_LONG);
+	for (int j = 0; j < 8; j++) {
+		uint64_t m = p * (q0 + (residues[j] + WHEEL - r0) % WHEEL);
+		uint8_t mask;
 
-	while (!tmp) {
-		start += BITS_PER_LONG;
-		if (start >= nbits)
-			return nbits;
+		if (m >= limit)
+			continue;
 
-		tmp = addr[start / BITS_PER_LONG] ^ invert;
+		mask = ~(1u << wheel_bit[m % WHEEL]);
+		for (uint64_t i = (m - base) / WHEEL; i < bytes; i += p)
+			bits[i] &= mask;
 	}
+}
+
+static void table_init(void)
+{
+	memset(table, 0xff, sizeof(table));
+	table[0] &= ~1; /* 1 is not a prime */
 
-	return min(start + __builtin_ffsl(tmp) - 1, nbits);
+	for (uint64_t p = 7; p * p < IGT_PRIMES_TABLE_LIMIT;
+	     p = find_prime(table, 0, p + 1, IGT_PRIMES_TABLE_LIMIT))
+		mark_multiples(table, 0, IGT_PRIMES_TABLE_LIMIT, p);
 }
 
-static unsigned long find_next_bit(const unsigned long *addr,
-		unsigned long size,
-		unsigned long offset)
+static void sieve_segment(struct igt_primes_iter *it, uint64_t base)
 {
-	return __find_next_bit(addr, size, offset, 0UL);
+	uint64_t limit = base + SEGMENT_SPAN;
+
+	memset(it->bits, 0xff, sizeof(it->bits));
+
+	for (uint64_t p = 7; p && p * p < limit;
+	     p = find_prime(table, 0, p + 1, IGT_PRIMES_TABLE_LIMIT))
+		mark_multiples(it->bits, base, limit, p);
+
+	it->base = base;
 }
 
-static unsigned long slow_next_prime_number(unsigned long x)
+static void segment_key_init(void)
 {
-	for (;;) {
-		unsigned long y = sqrt(++x) + 1;
-		while (y > 1) {
-			if ((x % y) == 0)
-				break;
-			y--;
+	pthread_key_create(&segment_key, free);
+}
+
+static struct igt_primes_iter *thread_segment(void)
+{
+	struct igt_primes_iter *it;
+
+	pthread_once(&segment_once, segment_key_init);
+
+	it = pthread_getspecific(segment_key);
+	if (!it) {
+		it = malloc(sizeof(*it));
+		if (!it)
+			return NULL;
+
+		igt_primes_iter_init(it, 0);
+		if (pthread_setspecific(segment_key, it)) {
+			free(it);
+			return NULL;
 		}
-		if (y == 1)
-			return x;
 	}
+
+	return it;
 }
 
-static unsigned long mark_multiples(unsigned long x,
-				    unsigned long *primes,
-				    unsigned long start,
-				    unsigned long end)
+/* Primes past ULONG_MAX, which isn't one, are clamped to it */
+static unsigned long clamp_prime(uint64_t p)
 {
-	unsigned long m;
+	return p > ULONG_MAX ? ULONG_MAX : p;
+}
+
+/*
+ * The smallest prime above @x, sieving into the segment of @it, or of the
+ * thread if NULL.
+ */
+static unsigned long next_prime(struct igt_primes_iter *it, unsigned long x)
+{
+	static const uint8_t small[7] = { 2, 2, 3, 5, 5, 7, 7 };
+	uint64_t n = (uint64_t)x + 1, p;
+
+	if (x < 7)
+		return small[x];
+
+	if (x == ULONG_MAX)
+		return ULONG_MAX;
+
+	pthread_once(&table_once, table_init);
+
+	if (n < IGT_PRIMES_TABLE_LIMIT) {
+		p = find_prime(table, 0, n, IGT_PRIMES_TABLE_LIMIT);
+		if (p)
+			return p;
+
+		n = IGT_PRIMES_TABLE_LIMIT;
+	}
 
-	m = 2*x;
-	if (m < start)
-		m = (start / x + 1) * x;
+	if (!it)
+		it = thread_segment();
 
-	while (m < end) {
-		clear_bit(m, primes);
-		m += x;
+	while (it && n < SIEVE_LIMIT && n <= ULONG_MAX) {
+		uint64_t base = n - n % SEGMENT_SPAN;
+
+		if (it->base != base)
+			sieve_segment(it, base);
+
+		p = find_prime(it->bits, base, n, base + SEGMENT_SPAN);
+		if (p)
+			return clamp_prime(p);
+
+		n = base + SEGMENT_SPAN;
 	}
 
-	return x;
+	return slow_next_prime_number(clamp_prime(n - 1));
 }
 
+/**
+ * igt_next_prime_number:
+ * @x: a number
+ *
+ * Returns: the smallest prime above @x, except for 0 which returns 1 for the
+ * sake of for_each_prime_number(), and ULONG_MAX if there is none below it.
+ */
 unsigned long igt_next_prime_number(unsigned long x)
 {
-	static unsigned long *primes;
-	static unsigned long last, last_sz;
-
 	if (x == 0)
 		return 1; /* a white lie for for_each_prime_number() */
-	if (x == 1)
-		return 2;
-
-	if (x >= last) {
-		unsigned long sz, y;
-		unsigned long *nprimes;
-
-		sz = x*x;
-		if (sz < x)
-			return slow_next_prime_number(x);
-
-		sz = round_up(sz, BITS_PER_LONG);
-		nprimes = realloc(primes, sz / sizeof(long));
-		if (!nprimes)
-			return slow_next_prime_number(x);
-
-		/* Where memory permits, track the primes using the
-		 * Sieve of Eratosthenes.
-		 */
-		memset(nprimes + last_sz / BITS_PER_LONG,
-		       0xff, (sz - last_sz) / sizeof(long));
-		for (y = 2UL; y < sz; y = find_next_bit(nprimes, sz, y + 1))
-			last = mark_multiples(y, nprimes, last_sz, sz);
-
-		primes = nprimes;
-		last_sz = sz;
+
+	return next_prime(NULL, x);
+}
+
+/**
+ * igt_primes_iter_init:
+ * @it: the iterator
+ * @x: where to start
+ *
+ * Starts iterating over the primes above @x. Iterators keep their own
+ * segment of the sieve, and their position in it, so that consecutive
+ * primes are found in a few instructions.
+ */
+void igt_primes_iter_init(struct igt_primes_iter *it, unsigned long x)
+{
+	it->prime = x;
+	it->index = it->end = 0;
+	it->pending = 0;
+	it->base = 0; /* never the base of a segment, the table covers 0 */
+}
+
+/* Finds the next prime the slow way, and the part of the sieve it is in */
+static unsigned long iter_seek(struct igt_primes_iter *it)
+{
+	unsigned long p = next_prime(it, it->prime);
+	unsigned int r;
+
+	if (p < 7 || p >= SIEVE_LIMIT || p == ULONG_MAX) {
+		it->end = 0;
+		return it->prime = p;
+	}
+
+	if (p < IGT_PRIMES_TABLE_LIMIT) {
+		it->window = table;
+		it->window_base = 0;
+		it->end = TABLE_BYTES;
+	} else {
+		it->window = it->bits;
+		it->window_base = it->base;
+		it->end = IGT_PRIMES_SEGMENT_BYTES;
 	}
 
-	return find_next_bit(primes, last, x + 1);
+	/* What's left of its byte */
+	it->index = (p - it->window_base) / WHEEL;
+	r = (p - it->window_base) % WHEEL;
+	it->pending = r + 1 < WHEEL ?
+		it->window[it->index] & residues_from[r + 1] : 0;
+
+	return it->prime = p;
+}
+
+/**
+ * igt_primes_iter_next:
+ * @it: the iterator
+ *
+ * Returns: the next prime.
+ */
+unsigned long igt_primes_iter_next(struct igt_primes_iter *it)
+{
+	unsigned int b;
+
+	while (!it->pending) {
+		if (++it->index >= it->end)
+			return iter_seek(it);
+
+		it->pending = it->window[it->index];
+	}
+
+	b = __builtin_ctz(it->pending);
+	it->pending &= it->pending - 1;
+
+	return it->prime = it->window_base + WHEEL * it->index + residues[b];
 }
@@ -24,8 +24,49 @@
 #ifndef IGT_PRIMES_H
 #define IGT_PRIMES_H
 
+#include <stdint.h>
+
+/* Primes below are sieved once, and shared */
+#define IGT_PRIMES_TABLE_LIMIT (30 * 32768)
+#define IGT_PRIMES_SEGMENT_BYTES 32768
+
+/**
+ * igt_primes_iter:
+ * @prime: the last prime returned
+ *
+ * Iterator over the primes, see igt_primes_iter_init().
+ */
+struct igt_primes_iter {
+	unsigned long prime;
+	/*< private >*/
+	const uint8_t *window;
+	uint64_t window_base;
+	uint32_t index, end;
+	unsigned int pending;
+	uint64_t base;
+	uint8_t bits[IGT_PRIMES_SEGMENT_BYTES];
+};
+
 unsigned long igt_next_prime_number(unsigned long x);
 
+void igt_primes_iter_init(struct igt_primes_iter *it, unsigned long x);
+unsigned long igt_primes_iter_next(struct igt_primes_iter *it);
+
+/**
+ * for_each_prime_in_range:
+ * @prime: name of the loop variable
+ * @it: pointer to a #igt_primes_iter
+ * @from: first number to consider
+ * @to: first number not to consider
+ *
+ * Iterates over the primes in [@from, @to).
+ */
+#define for_each_prime_in_range(prime, it, from, to)			\
+	for (unsigned long prime = (igt_primes_iter_init((it),		\
+				    (from) ? (from) - 1 : 0),		\
+				    igt_primes_iter_next(it));		\
+	     prime < (to); prime = igt_primes_iter_next(it))
+
 #define for_each_prime_number(prime, count)				\
 	for (unsigned long prime = 0, count__ = (count);		\
 	     count__-- && (prime = igt_next_prime_number(prime)); )
@@ -0,0 +1,516 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_ref.h"
+#include "igt_thread.h"
+#include "igt_tiling.h"
+#include "intel_batchbuffer.h"
+#include "intel_bufops.h"
+
+/**
+ * SECTION:igt_ref
+ * @short_description: CPU reference rendering into tiled surfaces
+ * @title: CPU reference rendering
+ * @include: igt_ref.h
+ *
+ * Tests checking the results of the render copy, media fill and gpgpu fill
+ * functions compute the image they expect on the CPU. This implements the
+ * fill, clear and copy these perform, and the comparison of the results,
+ * directly on the surfaces in their own layout, linear or tiled, instead of
+ * converting whole surfaces to linear and back around per-pixel loops.
+ *
+ * Surfaces are processed in blocks of 32 rows by 4KiB, which covers whole
+ * tiles of the i915 layouts. Tiled blocks go through a scratch buffer that
+ * stays in cache, while linear ones are used in place. The rows of the
+ * blocks are split over as many threads as there are CPUs.
+ */
+
+#define BLOCK_ROWS 32
+#define BLOCK_BYTES 4096
+#define BLOCK_SIZE (BLOCK_ROWS * BLOCK_BYTES)
+
+/* Not worth a thread below that */
+#define MIN_THREAD_BYTES (1u << 20)
+
+/**
+ * igt_ref_intel_buf_supported:
+ * @buf: the buffer
+ *
+ * Returns: whether @buf can be rendered into with igt_ref, i.e. whether it
+ * is uncompressed and in a layout #igt_tiling supports.
+ */
+bool igt_ref_intel_buf_supported(const struct intel_buf *buf)
+{
+	if (intel_buf_compressed(buf) || buf->format_is_yuv_semiplanar)
+		return false;
+
+	switch (buf->tiling) {
+	case I915_TILING_NONE:
+		return true;
+	case I915_TILING_X:
+	case I915_TILING_Y:
+	case I915_TILING_4:
+		break;
+	default:
+		return false;
+	}
+
+	/* Bit 17 swizzling depends on the physical address of the pages */
+	switch (buf->swizzle_mode) {
+	case I915_BIT_6_SWIZZLE_NONE:
+	case I915_BIT_6_SWIZZLE_9:
+	case I915_BIT_6_SWIZZLE_9_10:
+	case I915_BIT_6_SWIZZLE_9_11:
+	case I915_BIT_6_SWIZZLE_9_10_11:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * igt_ref_surface_init_intel_buf:
+ * @s: the surface to initialize
+ * @buf: a buffer mapped with intel_buf_cpu_map() or intel_buf_device_map()
+ *
+ * Describes the main surface of @buf, which must be supported according to
+ * igt_ref_intel_buf_supported(), for the CPU reference renderer. @buf must
+ * stay mapped until igt_ref_surface_fini().
+ */
+void igt_ref_surface_init_intel_buf(struct igt_ref_surface *s,
+				    const struct intel_buf *buf)
+{
+	igt_assert(buf->ptr);
+	igt_assert(igt_ref_intel_buf_supported(buf));
+
+	*s = (struct igt_ref_surface) {
+		.ptr = (uint8_t *)buf->ptr + buf->surface[0].offset,
+		.stride = buf->surface[0].stride,
+		.cpp = buf->bpp / 8,
+		.width = intel_buf_width(buf),
+		.height = intel_buf_height(buf),
+	};
+
+	if (buf->tiling != I915_TILING_NONE)
+		s->tiling = igt_tiling_create_intel(buf->tiling,
+						    buf->swizzle_mode,
+						    buf->surface[0].stride);
+}
+
+/**
+ * igt_ref_surface_fini:
+ * @s: the surface
+ *
+ * Frees the tiling of @s.
+ */
+void igt_ref_surface_fini(struct igt_ref_surface *s)
+{
+	if (s->tiling)
+		igt_tiling_destroy(s->tiling);
+	s->tiling = NULL;
+}
+
+enum ref_op {
+	REF_FILL,
+	REF_COPY,
+	REF_COMPARE,
+	REF_CHECK_FILL,
+};
+
+struct ref_mismatch {
+	bool found;
+	unsigned int x, y;
+};
+
+/*
+ * @dst is the surface written, or the one checked, and decides how rows are
+ * banded. @src is read, or compared against. Fills use @line, a block wide
+ * row of the pixel.
+ */
+struct ref_job {
+	enum ref_op op;
+	const struct igt_ref_surface *dst, *src;
+	unsigned int dx, dy, sx, sy;
+	unsigned int width, height;
+	const uint8_t *line;
+	unsigned int block_width;
+	unsigned int bands;
+	uint8_t *scratch;
+	struct ref_mismatch *mismatch;
+};
+
+static uint8_t *linear_ptr(const struct igt_ref_surface *s,
+			   unsigned int x, unsigned int y)
+{
+	return (uint8_t *)s->ptr + (uint64_t)y * s->stride + x * s->cpp;
+}
+
+/* The rows of a block, read through @scratch when tiled */
+static const uint8_t *read_block(const struct igt_ref_surface *s,
+				 uint8_t *scratch, uint32_t *stride,
+				 unsigned int x, unsigned int y,
+				 unsigned int width, unsigned int height)
+{
+	if (!s->tiling) {
+		*stride = s->stride;
+		return linear_ptr(s, x, y);
+	}
+
+	*stride = width * s->cpp;
+	igt_tiling_from_tiled(s->tiling, scratch, *stride, s->ptr,
+			      x * s->cpp, y, width * s->cpp, height);
+
+	return scratch;
+}
+
+/* @stride 0 writes the same row over the whole block */
+static void write_block(const struct igt_ref_surface *s,
+			const uint8_t *rows, uint32_t stride,
+			unsigned int x, unsigned int y,
+			unsigned int width, unsigned int height)
+{
+	if (s->tiling) {
+		igt_tiling_to_tiled(s->tiling, s->ptr, rows, stride,
+				    x * s->cpp, y, width * s->cpp, height);
+		return;
+	}
+
+	for (unsigned int row = 0; row < height; row++)
+		memcpy(linear_ptr(s, x, y + row), rows + row * stride,
+		       width * s->cpp);
+}
+
+/* First differing pixel of a block, in row major order */
+static bool compare_block(const uint8_t *a, uint32_t a_stride,
+			  const uint8_t *b, uint32_t b_stride,
+			  unsigned int cpp, unsigned int width,
+			  unsigned int height,
+			  unsigned int *bad_x, unsigned int *bad_y)
+{
+	for (unsigned int row = 0; row < height; row++) {
+		const uint8_t *pa = a + row * a_stride;
+		const uint8_t *pb = b + row * b_stride;
+
+		if (!memcmp(pa, pb, width * cpp))
+			continue;
+
+		for (unsigned int x = 0; x < width; x++) {
+			if (memcmp(pa + x * cpp, pb + x * cpp, cpp)) {
+				*bad_x = x;
+				*bad_y = row;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static void ref_block(const struct ref_job *job, uint8_t *scratch,
+		      struct ref_mismatch *m, unsigned int x, unsigned int y,
+		      unsigned int width, unsigned int height)
+{
+	const struct igt_ref_surface *dst = job->dst, *src = job->src;
+	const uint8_t *a, *b;
+	uint32_t a_stride, b_stride;
+	unsigned int bad_x, bad_y;
+
+	switch (job->op) {
+	case REF_FILL:
+		write_block(dst, job->line, 0,
+			    job->dx + x, job->dy + y, width, height);
+		break;
+	case REF_COPY:
+		b = read_block(src, scratch, &b_stride,
+			       job->sx + x, job->sy + y, width, height);
+		write_block(dst, b, b_stride,
+			    job->dx + x, job->dy + y, width, height);
+		break;
+	case REF_COMPARE:
+	case REF_CHECK_FILL:
+		a = read_block(dst, scratch, &a_stride,
+			       job->dx + x, job->dy + y, width, height);
+		if (job->op == REF_COMPARE) {
+			b = read_block(src, scratch + BLOCK_SIZE, &b_stride,
+				       job->sx + x, job->sy + y, width, height);
+		} else {
+			b = job->line;
+			b_stride = 0;
+		}
+
+		if (compare_block(a, a_stride, b, b_stride, dst->cpp,
+				  width, height, &bad_x, &bad_y) &&
+		    (!m->found || y + bad_y < m->y ||
+		     (y + bad_y == m->y && x + bad_x < m->x))) {
+			m->found = true;
+			m->x = x + bad_x;
+			m->y = y + bad_y;
+		}
+		break;
+	}
+}
+
+/* Rows of band n, relative to the rectangle, bands being aligned on dst */
+static void band_rows(const struct ref_job *job, unsigned int band,
+		      unsigned int *start, unsigned int *end)
+{
+	unsigned int first = job->dy / BLOCK_ROWS + band;
+
+	*start = max(first * BLOCK_ROWS, job->dy) - job->dy;
+	*end = min((first + 1) * BLOCK_ROWS, job->dy + job->height) - job->dy;
+}
+
+static void ref_worker(void *data, unsigned int idx, unsigned int count)
+{
+	const struct ref_job *job = data;
+	unsigned int band = job->bands * idx / count;
+	unsigned int last = job->bands * (idx + 1) / count;
+	uint8_t *scratch = job->scratch + (size_t)idx * 2 * BLOCK_SIZE;
+	struct ref_mismatch *m = &job->mismatch[idx];
+
+	/* Bands are in order, the first mismatch is in the first band with one */
+	for (; band < last && !m->found; band++) {
+		unsigned int y, y_end;
+
+		band_rows(job, band, &y, &y_end);
+
+		for (unsigned int x = 0; x < job->width; x += job->block_width)
+			ref_block(job, scratch, m, x, y,
+				  min(job->block_width, job->width - x),
+				  y_end - y);
+	}
+}
+
+static bool ref_run(struct ref_job *job, unsigned int *bad_x,
+		    unsigned int *bad_y)
+{
+	const struct igt_ref_surface *dst = job->dst;
+	unsigned int count, min_bands;
+	uint8_t *line = NULL;
+	bool found = false;
+
+	igt_assert(dst->cpp && dst->cpp <= BLOCK_BYTES);
+	igt_assert(job->dx + job->width <= dst->width &&
+		   job->dy + job->height <= dst->height);
+	if (job->op == REF_COPY || job->op == REF_COMPARE) {
+		igt_assert_eq(job->src->cpp, dst->cpp);
+		igt_assert(job->sx + job->width <= job->src->width &&
+			   job->sy + job->height <= job->src->height);
+	}
+
+	if (!job->width || !job->height)
+		return false;
+
+	job->block_width = BLOCK_BYTES / dst->cpp;
+
+	/* A block wide row of the fill pixel */
+	if (job->line) {
+		line = malloc(job->block_width * dst->cpp);
+		igt_assert(line);
+		for (unsigned int x = 0; x < job->block_width; x++)
+			memcpy(line + x * dst->cpp, job->line, dst->cpp);
+		job->line = line;
+	}
+
+	job->bands = (job->dy + job->height - 1) / BLOCK_ROWS -
+		job->dy / BLOCK_ROWS + 1;
+	min_bands = MIN_THREAD_BYTES /
+		((uint64_t)job->width * dst->cpp * BLOCK_ROWS) + 1;
+	count = igt_thread_parallel_count(job->bands, min_bands);
+
+	job->scratch = malloc((size_t)count * 2 * BLOCK_SIZE);
+	job->mismatch = calloc(count, sizeof(*job->mismatch));
+	igt_assert(job->scratch && job->mismatch);
+
+	igt_thread_parallel(count, ref_worker, job);
+
+	for (unsigned int i = 0; i < count; i++) {
+		if (job->mismatch[i].found) {
+			*bad_x = job->dx + job->mismatch[i].x;
+			*bad_y = job->dy + job->mismatch[i].y;
+			found = true;
+			break;
+		}
+	}
+
+	free(job->mismatch);
+	free(job->scratch);
+	free(line);
+
+	return found;
+}
+
+/**
+ * igt_ref_fill:
+ * @dst: the surface
+ * @x: first pixel to fill in the rows
+ * @y: first row to fill
+ * @width: width of the rectangle, in pixels
+ * @height: height of the rectangle, in rows
+ * @pixel: the value of the pixel, of @dst->cpp bytes
+ *
+ * Fills a rectangle of @dst with @pixel, as the media and gpgpu fills do.
+ */
+void igt_ref_fill(const struct igt_ref_surface *dst,
+		  unsigned int x, unsigned int y,
+		  unsigned int width, unsigned int height,
+		  const void *pixel)
+{
+	struct ref_job job = {
+		.op = REF_FILL,
+		.dst = dst,
+		.dx = x, .dy = y,
+		.width = width, .height = height,
+		.line = pixel,
+	};
+	unsigned int bad_x, bad_y;
+
+	ref_run(&job, &bad_x, &bad_y);
+}
+
+/**
+ * igt_ref_clear:
+ * @dst: the surface
+ * @x: first pixel to clear in the rows
+ * @y: first row to clear
+ * @width: width of the rectangle, in pixels
+ * @height: height of the rectangle, in rows
+ *
+ * Fills a rectangle of @dst with zeroes.
+ */
+void igt_ref_clear(const struct igt_ref_surface *dst,
+		   unsigned int x, unsigned int y,
+		   unsigned int width, unsigned int height)
+{
+	uint8_t zero[BLOCK_BYTES] = {};
+
+	igt_ref_fill(dst, x, y, width, height, zero);
+}
+
+/**
+ * igt_ref_copy:
+ * @dst: the surface to copy to
+ * @dx: first pixel to write in the rows of @dst
+ * @dy: first row to write in @dst
+ * @src: the surface to copy from, which must not overlap the rectangle of
+ *	 @dst
+ * @sx: first pixel to read in the rows of @src
+ * @sy: first row to read in @src
+ * @width: width of the rectangle, in pixels
+ * @height: height of the rectangle, in rows
+ *
+ * Copies a rectangle of @src into @dst, as the render copy does, whatever
+ * their layouts. Both surfaces must have the same number of bytes per pixel.
+ */
+void igt_ref_copy(const struct igt_ref_surface *dst,
+		  unsigned int dx, unsigned int dy,
+		  const struct igt_ref_surface *src,
+		  unsigned int sx, unsigned int sy,
+		  unsigned int width, unsigned int height)
+{
+	struct ref_job job = {
+		.op = REF_COPY,
+		.dst = dst, .src = src,
+		.dx = dx, .dy = dy, .sx = sx, .sy = sy,
+		.width = width, .height = height,
+	};
+	unsigned int bad_x, bad_y;
+
+	ref_run(&job, &bad_x, &bad_y);
+}
+
+/**
+ * igt_ref_compare:
+ * @a: a surface
+ * @b: the surface to compare it to
+ * @x: first pixel to compare in the rows
+ * @y: first row to compare
+ * @width: width of the rectangle, in pixels
+ * @height: height of the rectangle, in rows
+ * @bad_x: set to the column of the first differing pixel
+ * @bad_y: set to the row of the first differing pixel
+ *
+ * Compares the same rectangle of two surfaces, whatever their layouts, for
+ * instance the destination of a render copy against the reference computed
+ * with igt_ref_copy().
+ *
+ * Returns: true if the rectangles differ, @bad_x and @bad_y then locating
+ * the first differing pixel in row major order.
+ */
+bool igt_ref_compare(const struct igt_ref_surface *a,
+		     const struct igt_ref_surface *b,
+		     unsigned int x, unsigned int y,
+		     unsigned int width, unsigned int height,
+		     unsigned int *bad_x, unsigned int *bad_y)
+{
+	struct ref_job job = {
+		.op = REF_COMPARE,
+		.dst = a, .src = b,
+		.dx = x, .dy = y, .sx = x, .sy = y,
+		.width = width, .height = height,
+	};
+
+	return ref_run(&job, bad_x, bad_y);
+}
+
+/**
+ * igt_ref_check_fill:
+ * @s: the surface
+ * @x: first pixel to check in the rows
+ * @y: first row to check
+ * @width: width of the rectangle, in pixels
+ * @height: height of the rectangle, in rows
+ * @pixel: the expected value of the pixels, of @s->cpp bytes
+ * @bad_x: set to the column of the first other pixel
+ * @bad_y: set to the row of the first other pixel
+ *
+ * Checks that a rectangle of @s is filled with @pixel.
+ *
+ * Returns: true if some pixel differs, @bad_x and @bad_y then locating the
+ * first one in row major order.
+ */
+bool igt_ref_check_fill(const struct igt_ref_surface *s,
+			unsigned int x, unsigned int y,
+			unsigned int width, unsigned int height,
+			const void *pixel,
+			unsigned int *bad_x, unsigned int *bad_y)
+{
+	struct ref_job job = {
+		.op = REF_CHECK_FILL,
+		.dst = s,
+		.dx = x, .dy = y,
+		.width = width, .height = height,
+		.line = pixel,
+	};
+
+	return ref_run(&job, bad_x, bad_y);
+}
+
+/**
+ * igt_ref_get_pixel:
+ * @s: the surface
+ * @x: column of the pixel
+ * @y: row of the pixel
+ * @pixel: set to the value of the pixel, of @s->cpp bytes
+ *
+ * Reads a single pixel of @s, such as the one reported by igt_ref_compare().
+ */
+void igt_ref_get_pixel(const struct igt_ref_surface *s,
+		       unsigned int x, unsigned int y, void *pixel)
+{
+	igt_assert(x < s->width && y < s->height);
+
+	if (s->tiling)
+		igt_tiling_from_tiled(s->tiling, pixel, s->cpp, s->ptr,
+				      x * s->cpp, y, s->cpp, 1);
+	else
+		memcpy(pixel, linear_ptr(s, x, y), s->cpp);
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef __IGT_REF_H__
+#define __IGT_REF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct igt_tiling;
+struct intel_buf;
+
+/**
+ * igt_ref_surface:
+ * @ptr: CPU mapping of the surface
+ * @tiling: tiling of the surface, %NULL if linear
+ * @stride: stride of the surface, in bytes
+ * @cpp: bytes per pixel
+ * @width: width of the surface, in pixels
+ * @height: height of the surface, in rows
+ *
+ * A surface the CPU reference renderer reads and writes in place, in its
+ * own layout. @tiling, which must have been created for @stride, is freed
+ * by igt_ref_surface_fini().
+ */
+struct igt_ref_surface {
+	void *ptr;
+	struct igt_tiling *tiling;
+	uint32_t stride;
+	unsigned int cpp;
+	unsigned int width;
+	unsigned int height;
+};
+
+bool igt_ref_intel_buf_supported(const struct intel_buf *buf);
+void igt_ref_surface_init_intel_buf(struct igt_ref_surface *s,
+				    const struct intel_buf *buf);
+void igt_ref_surface_fini(struct igt_ref_surface *s);
+
+void igt_ref_fill(const struct igt_ref_surface *dst,
+		  unsigned int x, unsigned int y,
+		  unsigned int width, unsigned int height,
+		  const void *pixel);
+void igt_ref_clear(const struct igt_ref_surface *dst,
+		   unsigned int x, unsigned int y,
+		   unsigned int width, unsigned int height);
+void igt_ref_copy(const struct igt_ref_surface *dst,
+		  unsigned int dx, unsigned int dy,
+		  const struct igt_ref_surface *src,
+		  unsigned int sx, unsigned int sy,
+		  unsigned int width, unsigned int height);
+
+bool igt_ref_compare(const struct igt_ref_surface *a,
+		     const struct igt_ref_surface *b,
+		     unsigned int x, unsigned int y,
+		     unsigned int width, unsigned int height,
+		     unsigned int *bad_x, unsigned int *bad_y);
+bool igt_ref_check_fill(const struct igt_ref_surface *s,
+			unsigned int x, unsigned int y,
+			unsigned int width, unsigned int height,
+			const void *pixel,
+			unsigned int *bad_x, unsigned int *bad_y);
+void igt_ref_get_pixel(const struct igt_ref_surface *s,
+		       unsigned int x, unsigned int y, void *pixel);
+
+#endif /* __IGT_REF_H__ */
@@ -40,6 +40,8 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 
 #include "igt_core.h"
 #include "igt_sysfs.h"
@@ -54,6 +56,12 @@
  *
  * This library provides helpers to access sysfs features. Right now it only
  * provides basic support for like igt_sysfs_open().
+ *
+ * Helpers such as igt_sysfs_get_u32() open and close the attribute on every
+ * call. Tests sampling the same attributes over and over should rather keep
+ * them open with igt_sysfs_attr_open() and read them through the returned fd
+ * with igt_sysfs_attr_read() and friends, which re-read the attribute from
+ * its start with pread(). Those work the same on debugfs files.
  */
 
 enum {
@@ -513,6 +521,35 @@ int igt_sysfs_printf(int dir, const char *attr, const char *fmt, ...)
 	return ret;
 }
 
+/* Leading decimal integer, as scanf("%" PRIu64) would read it */
+static bool parse_u64(const char *buf, uint64_t *value)
+{
+	char *end;
+
+	errno = 0;
+	*value = strtoull(buf, &end, 10);
+
+	return !errno && end != buf;
+}
+
+/* Enough for any integer and its newline */
+#define INT_ATTR_LEN 32
+
+static bool read_u64(int dir, const char *attr, uint64_t *value)
+{
+	char buf[INT_ATTR_LEN];
+	int fd, len;
+
+	fd = openat(dir, attr, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	len = igt_sysfs_attr_read(fd, buf, sizeof(buf));
+	close(fd);
+
+	return len >= 0 && parse_u64(buf, value);
+}
+
 /**
  * igt_sysfs_get_u32:
  * @dir: directory for the device from igt_sysfs_open()
@@ -525,9 +562,9 @@ int igt_sysfs_printf(int dir, const char *attr, const char *fmt, ...)
  */
 uint32_t igt_sysfs_get_u32(int dir, const char *attr)
 {
-	uint32_t result;
+	uint64_t result;
 
-	if (igt_debug_on(igt_sysfs_scanf(dir, attr, "%u", &result) != 1))
+	if (igt_debug_on(!read_u64(dir, attr, &result)))
 		return 0;
 
 	return result;
@@ -547,7 +584,7 @@ uint64_t igt_sysfs_get_u64(int dir, const char *attr)
 {
 	uint64_t result;
 
-	if (igt_debug_on(igt_sysfs_scanf(dir, attr, "%"PRIu64, &result) != 1))
+	if (igt_debug_on(!read_u64(dir, attr, &result)))
 		return 0;
 
 	return result;
@@ -629,6 +666,230 @@ bool igt_sysfs_set_boolean(int dir, const char *attr, bool value)
 	return igt_sysfs_printf(dir, attr, "%d", value) == 1;
 }
 
+/**
+ * igt_sysfs_attr_open:
+ * @dir: directory for the device from igt_sysfs_open()
+ * @attr: name of the sysfs node to open
+ *
+ * Opens the attribute for reading, to be sampled with igt_sysfs_attr_read()
+ * and friends without opening it again on every read. The fd is closed with
+ * close().
+ *
+ * Returns:
+ * The fd of the attribute, or -errno on error.
+ */
+int igt_sysfs_attr_open(int dir, const char *attr)
+{
+	int fd;
+
+	fd = openat(dir, attr, O_RDONLY | O_CLOEXEC);
+	if (igt_debug_on(fd < 0))
+		return -errno;
+
+	return fd;
+}
+
+/**
+ * igt_sysfs_attr_read:
+ * @fd: attribute from igt_sysfs_attr_open()
+ * @buf: the buffer to read into
+ * @len: the size of @buf
+ *
+ * Reads the current contents of the attribute, from its start, into @buf as
+ * a nul-terminated string without its trailing newlines. Contents longer
+ * than @len - 1 are cut short.
+ *
+ * Returns:
+ * The length of the string read, or -errno on error.
+ */
+int igt_sysfs_attr_read(int fd, char *buf, int len)
+{
+	int offset = 0;
+	ssize_t ret;
+
+	if (len <= 0)
+		return -EINVAL;
+
+	/* sysfs hands out the whole attribute to the first read */
+	while (offset < len - 1) {
+		ret = pread(fd, buf + offset, len - 1 - offset, offset);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			return -errno;
+		if (ret == 0)
+			break;
+
+		offset += ret;
+	}
+
+	buf[offset] = '\0';
+	while (offset > 0 && buf[offset - 1] == '\n')
+		buf[--offset] = '\0';
+
+	return offset;
+}
+
+/**
+ * igt_sysfs_attr_scanf:
+ * @fd: attribute from igt_sysfs_attr_open()
+ * @fmt: scanf format string
+ * @...: Additional paramaters to store the scaned input values
+ *
+ * igt_sysfs_scanf() for an attribute kept open, of at most a page.
+ *
+ * Returns:
+ * Number of values successfully scanned (which can be 0), EOF on errors or
+ * premature end of file.
+ */
+int igt_sysfs_attr_scanf(int fd, const char *fmt, ...)
+{
+	char buf[4096];
+	va_list ap;
+	int ret;
+
+	if (igt_debug_on(igt_sysfs_attr_read(fd, buf, sizeof(buf)) < 0))
+		return EOF;
+
+	va_start(ap, fmt);
+	ret = vsscanf(buf, fmt, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+/**
+ * igt_sysfs_attr_get_u64:
+ * @fd: attribute from igt_sysfs_attr_open()
+ *
+ * Convenience wrapper to read a unsigned 64bit integer from an attribute
+ * kept open.
+ *
+ * Returns:
+ * The value read.
+ */
+uint64_t igt_sysfs_attr_get_u64(int fd)
+{
+	char buf[INT_ATTR_LEN];
+	uint64_t result;
+
+	if (igt_debug_on(igt_sysfs_attr_read(fd, buf, sizeof(buf)) < 0 ||
+			 !parse_u64(buf, &result)))
+		return 0;
+
+	return result;
+}
+
+/**
+ * igt_sysfs_attr_get_u32:
+ * @fd: attribute from igt_sysfs_attr_open()
+ *
+ * Convenience wrapper to read a unsigned 32bit integer from an attribute
+ * kept open.
+ *
+ * Returns:
+ * The value read.
+ */
+uint32_t igt_sysfs_attr_get_u32(int fd)
+{
+	return igt_sysfs_attr_get_u64(fd);
+}
+
+/**
+ * igt_sysfs_attr_sample:
+ * @fds: attributes from igt_sysfs_attr_open()
+ * @count: number of attributes
+ * @values: where to store the value of each attribute
+ *
+ * Reads a set of integer attributes back to back, such as the frequencies
+ * or residencies of a GT, so that the values are as close in time to each
+ * other as sysfs allows. Attributes which can't be read or parsed are left
+ * out, their value being set to 0.
+ *
+ * Returns:
+ * The number of attributes read.
+ */
+int igt_sysfs_attr_sample(const int *fds, int count, uint64_t *values)
+{
+	char buf[INT_ATTR_LEN];
+	int read = 0;
+
+	for (int i = 0; i < count; i++) {
+		if (igt_sysfs_attr_read(fds[i], buf, sizeof(buf)) >= 0 &&
+		    parse_u64(buf, &values[i]))
+			read++;
+		else
+			values[i] = 0;
+	}
+
+	return read;
+}
+
+/* Checked that often when the attribute doesn't notify its changes */
+#define ATTR_POLL_MS 10
+
+/**
+ * igt_sysfs_attr_wait:
+ * @fd: attribute from igt_sysfs_attr_open()
+ * @buf: the contents last read from the attribute
+ * @len: the size of @buf
+ * @timeout_ms: how long to wait for, in milliseconds
+ *
+ * Waits for the contents of the attribute to be different from @buf, as
+ * last read with igt_sysfs_attr_read(), and updates @buf with them.
+ *
+ * Attributes notified by the kernel with sysfs_notify() wake the caller up
+ * through poll(POLLPRI) as soon as they change; the others are only read
+ * again every ATTR_POLL_MS.
+ *
+ * Returns:
+ * The length of the new contents, which may be 0, -ETIMEDOUT if they didn't
+ * change within @timeout_ms or another -errno on error.
+ */
+int igt_sysfs_attr_wait(int fd, char *buf, int len, int timeout_ms)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLPRI };
+	struct timespec start = {};
+	int64_t remaining;
+	char *tmp;
+	int ret;
+
+	tmp = malloc(len);
+	if (igt_debug_on(!tmp))
+		return -ENOMEM;
+
+	igt_nsec_elapsed(&start);
+	do {
+		/* Reading is what arms the next notification */
+		ret = igt_sysfs_attr_read(fd, tmp, len);
+		if (ret < 0)
+			break;
+
+		if (strcmp(tmp, buf)) {
+			memcpy(buf, tmp, ret + 1);
+			break;
+		}
+
+		remaining = timeout_ms - (int64_t)(igt_nsec_elapsed(&start) / 1000000);
+		if (remaining <= 0) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		if (remaining > ATTR_POLL_MS)
+			remaining = ATTR_POLL_MS;
+
+		if (poll(&pfd, 1, remaining) < 0 &&
+		    errno != EINTR) {
+			ret = -errno;
+			break;
+		}
+	} while (1);
+
+	free(tmp);
+	return ret;
+}
+
 static void bind_con(const char *name, bool enable)
 {
 	const char *path = "/sys/class/vtconsole";
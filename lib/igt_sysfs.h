@@ -121,6 +121,15 @@ bool igt_sysfs_set_u64(int dir, const char *attr, uint64_t value);
 bool igt_sysfs_get_boolean(int dir, const char *attr);
 bool igt_sysfs_set_boolean(int dir, const char *attr, bool value);
 
+int igt_sysfs_attr_open(int dir, const char *attr);
+int igt_sysfs_attr_read(int fd, char *buf, int len);
+int igt_sysfs_attr_scanf(int fd, const char *fmt, ...)
+	__attribute__((format(scanf,2,3)));
+uint32_t igt_sysfs_attr_get_u32(int fd);
+uint64_t igt_sysfs_attr_get_u64(int fd);
+int igt_sysfs_attr_sample(const int *fds, int count, uint64_t *values);
+int igt_sysfs_attr_wait(int fd, char *buf, int len, int timeout_ms);
+
 void bind_fbcon(bool enable);
 void kick_snd_hda_intel(void);
 void fbcon_blink_enable(bool enable);
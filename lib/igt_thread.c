@@ -24,6 +24,7 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdatomic.h>
+#include <unistd.h>
 
 #include "igt_core.h"
 #include "igt_thread.h"
@@ -63,6 +64,99 @@ bool igt_thread_is_main(void)
 	return pthread_getspecific(__igt_is_main_thread) != NULL;
 }
 
+/**
+ * igt_thread_parallel_count:
+ * @units: the number of independent work units, e.g. rows of a surface
+ * @min_units: the minimum number of units worth handing over to a thread
+ *
+ * Returns: the number of threads to split @units over with
+ * #igt_thread_parallel, at least 1 and at most the number of online CPUs.
+ */
+unsigned int igt_thread_parallel_count(size_t units, size_t min_units)
+{
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t count;
+
+	if (ncpus < 1)
+		ncpus = 1;
+
+	count = min_units ? units / min_units : units;
+	if (count > (size_t)ncpus)
+		count = ncpus;
+
+	return count ?: 1;
+}
+
+struct parallel_worker {
+	pthread_t thread;
+	void (*fn)(void *data, unsigned int idx, unsigned int count);
+	void *data;
+	unsigned int idx;
+	unsigned int count;
+};
+
+static void *parallel_worker(void *arg)
+{
+	struct parallel_worker *w = arg;
+
+	w->fn(w->data, w->idx, w->count);
+
+	return NULL;
+}
+
+/**
+ * igt_thread_parallel:
+ * @count: the number of workers
+ * @fn: the function to run in each worker
+ * @data: opaque data passed to @fn
+ *
+ * Run @fn @count times concurrently, with idx ranging from 0 to @count - 1,
+ * and wait for all of them to complete. The calling thread runs idx 0 itself,
+ * so this degrades to a plain function call when @count is 1.
+ *
+ * Workers are expected to split the work by their idx and must not use
+ * igt_assert() and friends, as they do not run on the main thread.
+ */
+void igt_thread_parallel(unsigned int count,
+			 void (*fn)(void *data, unsigned int idx,
+				    unsigned int count),
+			 void *data)
+{
+	struct parallel_worker *w;
+	unsigned int i;
+
+	if (count <= 1) {
+		fn(data, 0, 1);
+		return;
+	}
+
+	w = calloc(count, sizeof(*w));
+	igt_assert(w);
+
+	for (i = 0; i < count; i++) {
+		w[i].fn = fn;
+		w[i].data = data;
+		w[i].idx = i;
+		w[i].count = count;
+	}
+
+	/* Fall back to running on the caller if we are out of threads */
+	for (i = 1; i < count; i++)
+		if (pthread_create(&w[i].thread, NULL, parallel_worker, &w[i]))
+			w[i].fn = NULL;
+
+	fn(data, 0, count);
+
+	for (i = 1; i < count; i++) {
+		if (w[i].fn)
+			pthread_join(w[i].thread, NULL);
+		else
+			fn(data, i, count);
+	}
+
+	free(w);
+}
+
 igt_constructor {
 	pthread_key_create(&__igt_is_main_thread, NULL);
 	pthread_setspecific(__igt_is_main_thread, (void*) 0x1);
@@ -21,8 +21,17 @@
  * IN THE SOFTWARE.
  */
 
+#include <stdbool.h>
+#include <stddef.h>
+
 void igt_thread_clear_fail_state(void);
 void igt_thread_fail(void);
 void igt_thread_assert_no_failures(void);
 
 bool igt_thread_is_main(void);
+
+unsigned int igt_thread_parallel_count(size_t units, size_t min_units);
+void igt_thread_parallel(unsigned int count,
+			 void (*fn)(void *data, unsigned int idx,
+				    unsigned int count),
+			 void *data);
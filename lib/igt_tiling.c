@@ -0,0 +1,641 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drmtest.h"
+#include "igt_amd.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_tiling.h"
+#include "igt_vc4.h"
+#include "intel_batchbuffer.h"
+
+/**
+ * SECTION:igt_tiling
+ * @short_description: CPU tiling and detiling of buffers
+ * @title: Tiling
+ * @include: igt_tiling.h
+ *
+ * Tiled layouts only need the address of a byte to be computed once per
+ * tile shape: within a tile, the bytes are stored in runs which are always
+ * laid out the same way, and the tiles themselves follow each other in
+ * rows. A #igt_tiling is created once for a layout and a stride, tabulating
+ * the offset of every run of a tile, and then copies runs at a time, tile
+ * by tile, between a linear and a tiled buffer.
+ *
+ * This is what igt_fb uses to convert the vc4 and amdgpu framebuffers it
+ * cannot blit, and igt_draw to draw into i915 tiled buffers through a CPU
+ * mapping.
+ */
+
+struct igt_tiling {
+	unsigned int tile_width;
+	unsigned int tile_height;
+	unsigned int chunk;
+	unsigned int chunks;
+	unsigned int variants;
+	bool serpentine;
+	unsigned int tiles_per_row;
+	uint64_t tile_size;
+	uint64_t row_pitch;
+	/* Offset of each chunk, per variant and row of a tile */
+	uint32_t offsets[];
+};
+
+static unsigned int gcd(unsigned int a, unsigned int b)
+{
+	while (b) {
+		unsigned int r = a % b;
+
+		a = b;
+		b = r;
+	}
+
+	return a;
+}
+
+/**
+ * igt_tiling_create:
+ * @layout: the tiled layout
+ * @stride: stride of the tiled buffer, in bytes
+ *
+ * Tabulates @layout, looking for the largest runs of bytes that are
+ * contiguous in every row of its tiles.
+ *
+ * Returns: the tiling, to be freed with igt_tiling_destroy()
+ */
+struct igt_tiling *igt_tiling_create(const struct igt_tiling_layout *layout,
+				     uint32_t stride)
+{
+	unsigned int variants = layout->variants ?: 1;
+	unsigned int chunk = layout->tile_width;
+	struct igt_tiling *t;
+	unsigned int v, x, y;
+
+	igt_assert(layout->unit && layout->tile_width % layout->unit == 0);
+	igt_assert(layout->tile_height);
+	igt_assert_f(stride % layout->tile_width == 0,
+		     "stride %u is not a multiple of the tile width %u\n",
+		     stride, layout->tile_width);
+
+	/* Runs may only be broken at the offsets of all the breaks seen */
+	for (v = 0; v < variants; v++) {
+		for (y = 0; y < layout->tile_height; y++) {
+			uint32_t prev = layout->offset(layout->data, v, 0, y);
+
+			for (x = layout->unit; x < layout->tile_width;
+			     x += layout->unit) {
+				uint32_t offset = layout->offset(layout->data,
+								 v, x, y);
+
+				if (offset != prev + layout->unit)
+					chunk = gcd(chunk, x);
+				prev = offset;
+			}
+		}
+	}
+
+	t = malloc(sizeof(*t) + sizeof(t->offsets[0]) * variants *
+		   layout->tile_height * (layout->tile_width / chunk));
+	igt_assert(t);
+
+	t->tile_width = layout->tile_width;
+	t->tile_height = layout->tile_height;
+	t->chunk = chunk;
+	t->chunks = layout->tile_width / chunk;
+	t->variants = variants;
+	t->serpentine = layout->serpentine;
+	t->tiles_per_row = stride / layout->tile_width;
+	t->tile_size = (uint64_t)layout->tile_width * layout->tile_height;
+	t->row_pitch = (uint64_t)stride * layout->tile_height;
+
+	for (v = 0; v < variants; v++)
+		for (y = 0; y < t->tile_height; y++)
+			for (x = 0; x < t->chunks; x++)
+				t->offsets[(v * t->tile_height + y) * t->chunks + x] =
+					layout->offset(layout->data, v,
+						       x * chunk, y);
+
+	return t;
+}
+
+/**
+ * igt_tiling_destroy:
+ * @t: the tiling
+ *
+ * Frees a tiling created with one of the igt_tiling_create() functions.
+ */
+void igt_tiling_destroy(struct igt_tiling *t)
+{
+	free(t);
+}
+
+/**
+ * igt_tiling_chunk_size:
+ * @t: the tiling
+ *
+ * Returns: the number of contiguous bytes copied at once
+ */
+unsigned int igt_tiling_chunk_size(const struct igt_tiling *t)
+{
+	return t->chunk;
+}
+
+static uint64_t tile_offset(const struct igt_tiling *t,
+			    unsigned int tx, unsigned int ty)
+{
+	if (t->serpentine && ty & 1)
+		tx = t->tiles_per_row - 1 - tx;
+
+	return ty * t->row_pitch + tx * t->tile_size;
+}
+
+static const uint32_t *row_offsets(const struct igt_tiling *t, unsigned int y)
+{
+	unsigned int ty = y / t->tile_height;
+
+	return t->offsets + ((ty % t->variants) * t->tile_height +
+			     y % t->tile_height) * t->chunks;
+}
+
+/**
+ * igt_tiling_offset:
+ * @t: the tiling
+ * @x: byte in the row
+ * @y: row
+ *
+ * Returns: the offset of byte @x of row @y in the tiled buffer
+ */
+uint64_t igt_tiling_offset(const struct igt_tiling *t,
+			   unsigned int x, unsigned int y)
+{
+	unsigned int xt = x % t->tile_width;
+
+	return tile_offset(t, x / t->tile_width, y / t->tile_height) +
+		row_offsets(t, y)[xt / t->chunk] + xt % t->chunk;
+}
+
+/*
+ * The whole chunks of a row of a tile, with the chunk size known at compile
+ * time for the common ones so that each copy is a couple of vector moves.
+ */
+#define COPY_CHUNKS(size) do { \
+	if (to_tiled) { \
+		for (; x + (size) <= end; x += (size), linear += (size)) \
+			memcpy(tile + offsets[x / (size)], linear, (size)); \
+	} else { \
+		for (; x + (size) <= end; x += (size), linear += (size)) \
+			memcpy(linear, tile + offsets[x / (size)], (size)); \
+	} \
+} while (0)
+
+static void copy_row(const struct igt_tiling *t, uint8_t *tile,
+		     const uint32_t *offsets, uint8_t *linear,
+		     unsigned int x, unsigned int end, bool to_tiled)
+{
+	unsigned int chunk = t->chunk;
+
+	/* Partial chunk at the start of the span */
+	if (x % chunk) {
+		unsigned int len = min(chunk - x % chunk, end - x);
+		uint8_t *p = tile + offsets[x / chunk] + x % chunk;
+
+		if (to_tiled)
+			memcpy(p, linear, len);
+		else
+			memcpy(linear, p, len);
+
+		x += len;
+		linear += len;
+	}
+
+	switch (chunk) {
+	case 16:
+		COPY_CHUNKS(16);
+		break;
+	case 64:
+		COPY_CHUNKS(64);
+		break;
+	default:
+		COPY_CHUNKS(chunk);
+		break;
+	}
+
+	/* And at its end */
+	if (x < end) {
+		uint8_t *p = tile + offsets[x / chunk];
+
+		if (to_tiled)
+			memcpy(p, linear, end - x);
+		else
+			memcpy(linear, p, end - x);
+	}
+}
+
+static void copy_rect(const struct igt_tiling *t, uint8_t *tiled,
+		      uint8_t *linear, uint32_t linear_stride,
+		      unsigned int x, unsigned int y,
+		      unsigned int width, unsigned int height, bool to_tiled)
+{
+	unsigned int x_end = x + width, y_end = y + height;
+	unsigned int band, band_end, tx, row;
+
+	/* A tile at a time, so that either side only spans a few pages */
+	for (band = y; band < y_end; band = band_end) {
+		unsigned int ty = band / t->tile_height;
+
+		band_end = min((ty + 1) * t->tile_height, y_end);
+
+		for (tx = x / t->tile_width; tx * t->tile_width < x_end; tx++) {
+			unsigned int x0 = max(x, tx * t->tile_width);
+			unsigned int x1 = min(x_end, (tx + 1) * t->tile_width);
+			uint8_t *tile = tiled + tile_offset(t, tx, ty);
+
+			for (row = band; row < band_end; row++)
+				copy_row(t, tile, row_offsets(t, row),
+					 linear + (uint64_t)(row - y) * linear_stride +
+					 (x0 - x),
+					 x0 - tx * t->tile_width,
+					 x1 - tx * t->tile_width, to_tiled);
+		}
+	}
+}
+
+/**
+ * igt_tiling_to_tiled:
+ * @t: the tiling
+ * @tiled: the tiled buffer
+ * @linear: the linear buffer, starting at the first byte to copy
+ * @linear_stride: stride of @linear, 0 to copy the same line to every row
+ * @x: first byte to write in the rows of @tiled
+ * @y: first row to write in @tiled
+ * @width: number of bytes per row
+ * @height: number of rows
+ *
+ * Copies a rectangle of linear data into a tiled buffer.
+ */
+void igt_tiling_to_tiled(const struct igt_tiling *t, void *tiled,
+			 const void *linear, uint32_t linear_stride,
+			 unsigned int x, unsigned int y,
+			 unsigned int width, unsigned int height)
+{
+	copy_rect(t, tiled, (uint8_t *)linear, linear_stride,
+		  x, y, width, height, true);
+}
+
+/**
+ * igt_tiling_from_tiled:
+ * @t: the tiling
+ * @linear: the linear buffer, starting at the first byte to write
+ * @linear_stride: stride of @linear
+ * @tiled: the tiled buffer
+ * @x: first byte to read in the rows of @tiled
+ * @y: first row to read in @tiled
+ * @width: number of bytes per row
+ * @height: number of rows
+ *
+ * Copies a rectangle out of a tiled buffer into a linear one.
+ */
+void igt_tiling_from_tiled(const struct igt_tiling *t, void *linear,
+			   uint32_t linear_stride, const void *tiled,
+			   unsigned int x, unsigned int y,
+			   unsigned int width, unsigned int height)
+{
+	copy_rect(t, (uint8_t *)tiled, linear, linear_stride,
+		  x, y, width, height, false);
+}
+
+static uint64_t swizzle_bit(unsigned int bit, uint64_t offset)
+{
+	return (offset & (1ull << bit)) >> (bit - 6);
+}
+
+/**
+ * igt_tiling_swizzle:
+ * @offset: offset in an i915 X or Y tiled buffer
+ * @swizzle: the I915_BIT_6_SWIZZLE_* mode of the buffer
+ *
+ * Swizzles, or equally unswizzles, bit 6 of @offset. Swizzle modes depending
+ * on the physical address, i.e. on bit 17, aren't supported and skip.
+ *
+ * Returns: @offset with its bit 6 swizzled
+ */
+uint64_t igt_tiling_swizzle(uint64_t offset, int swizzle)
+{
+	switch (swizzle) {
+	case I915_BIT_6_SWIZZLE_NONE:
+		return offset;
+	case I915_BIT_6_SWIZZLE_9:
+		return offset ^ swizzle_bit(9, offset);
+	case I915_BIT_6_SWIZZLE_9_10:
+		return offset ^ swizzle_bit(9, offset) ^ swizzle_bit(10, offset);
+	case I915_BIT_6_SWIZZLE_9_11:
+		return offset ^ swizzle_bit(9, offset) ^ swizzle_bit(11, offset);
+	case I915_BIT_6_SWIZZLE_9_10_11:
+		return offset ^ swizzle_bit(9, offset) ^
+			swizzle_bit(10, offset) ^ swizzle_bit(11, offset);
+	default:
+		/* Swizzling on bit 17 depends on the physical address */
+		igt_require(false);
+		return offset;
+	}
+}
+
+static uint32_t intel_x_offset(const void *data, unsigned int variant,
+			       unsigned int x, unsigned int y)
+{
+	/* X, Y and 4 tiles are 4KiB, where bit 6 swizzling stays within */
+	return igt_tiling_swizzle(y * 512 + x, *(const int *)data);
+}
+
+/* Columns of 16 byte OWords, 32 rows high */
+static uint32_t intel_y_offset(const void *data, unsigned int variant,
+			       unsigned int x, unsigned int y)
+{
+	return igt_tiling_swizzle(x / 16 * 512 + y * 16 + x % 16,
+				  *(const int *)data);
+}
+
+/*
+ * 64 byte subtiles of 4 OWords, in 8 columns and 8 rows. Subtiles are
+ * stored in pairs of 2x2 subtiles, which map[a] == b implies map[b] == a.
+ */
+static uint32_t intel_4_offset(const void *data, unsigned int variant,
+			       unsigned int x, unsigned int y)
+{
+	static const uint8_t subtile_map[] = {
+		0,  1,  2,  3,  8,  9, 10, 11,
+		4,  5,  6,  7, 12, 13, 14, 15,
+		16, 17, 18, 19, 24, 25, 26, 27,
+		20, 21, 22, 23, 28, 29, 30, 31,
+		32, 33, 34, 35, 40, 41, 42, 43,
+		36, 37, 38, 39, 44, 45, 46, 47,
+		48, 49, 50, 51, 56, 57, 58, 59,
+		52, 53, 54, 55, 60, 61, 62, 63
+	};
+
+	return subtile_map[y / 4 * 8 + x / 16] * 64 + y % 4 * 16 + x % 16;
+}
+
+/**
+ * igt_tiling_create_intel:
+ * @tiling: I915_TILING_X, I915_TILING_Y or I915_TILING_4
+ * @swizzle: the I915_BIT_6_SWIZZLE_* mode of the buffer
+ * @stride: stride of the buffer, in bytes
+ *
+ * Returns: the tiling of an i915 buffer
+ */
+struct igt_tiling *igt_tiling_create_intel(uint32_t tiling, int swizzle,
+					   uint32_t stride)
+{
+	struct igt_tiling_layout layout = {
+		.unit = 16,
+		.data = &swizzle,
+	};
+
+	switch (tiling) {
+	case I915_TILING_X:
+		layout.tile_width = 512;
+		layout.tile_height = 8;
+		layout.offset = intel_x_offset;
+		break;
+	case I915_TILING_Y:
+		layout.tile_width = 128;
+		layout.tile_height = 32;
+		layout.offset = intel_y_offset;
+		break;
+	case I915_TILING_4:
+		/* Platforms with tile 4 don't use bit 6 swizzling */
+		igt_assert_eq(swizzle, I915_BIT_6_SWIZZLE_NONE);
+		layout.tile_width = 128;
+		layout.tile_height = 32;
+		layout.offset = intel_4_offset;
+		break;
+	default:
+		igt_assert_f(false, "unsupported tiling %u\n", tiling);
+	}
+
+	return igt_tiling_create(&layout, stride);
+}
+
+/*
+ * VC4 T tiles are 4KiB, 128 bytes by 32 rows, made of 2x2 1KiB subtiles of
+ * 64 byte microtiles, 16 bytes by 4 rows. Odd tile rows run right to left,
+ * with the subtiles in a different order.
+ */
+static uint32_t vc4_t_offset(const void *data, unsigned int variant,
+			     unsigned int x, unsigned int y)
+{
+	static const uint8_t t1k_map[2][4] = {
+		{ 0, 3, 1, 2 },
+		{ 2, 1, 3, 0 },
+	};
+
+	return t1k_map[variant][y / 16 * 2 + x / 64] * 1024 +
+		((y % 16) / 4 * 4 + (x % 64) / 16) * 64 +
+		y % 4 * 16 + x % 16;
+}
+
+static uint32_t column_offset(const void *data, unsigned int variant,
+			      unsigned int x, unsigned int y)
+{
+	return y * *(const unsigned int *)data + x;
+}
+
+static uint32_t amd_64k_s_offset(const void *data, unsigned int variant,
+				 unsigned int x, unsigned int y)
+{
+	unsigned int bpp = *(const unsigned int *)data;
+	unsigned int width, height;
+
+	igt_amd_fb_calculate_tile_dimension(bpp, &width, &height);
+
+	return igt_amd_fb_tiled_offset(bpp, x / (bpp / 8), y, width);
+}
+
+static bool is_amd_64k_s(uint64_t modifier)
+{
+	return IS_AMD_FMT_MOD(modifier) &&
+		AMD_FMT_MOD_GET(TILE, modifier) == AMD_FMT_MOD_TILE_GFX9_64K_S;
+}
+
+static struct igt_tiling *create_amd_64k_s(const struct igt_fb *fb, int plane)
+{
+	unsigned int bpp = fb->plane_bpp[plane];
+	struct igt_tiling_layout layout = {};
+	unsigned int width, height;
+
+	igt_amd_fb_calculate_tile_dimension(bpp, &width, &height);
+
+	layout.tile_width = width * bpp / 8;
+	layout.tile_height = height;
+	layout.unit = bpp / 8;
+	layout.offset = amd_64k_s_offset;
+	layout.data = &bpp;
+
+	return igt_tiling_create(&layout,
+				 ALIGN(fb->plane_width[plane] * bpp / 8,
+				       layout.tile_width));
+}
+
+/**
+ * igt_tiling_fb_supported:
+ * @modifier: a framebuffer modifier
+ *
+ * Returns: whether igt_tiling_create_fb() handles @modifier
+ */
+bool igt_tiling_fb_supported(uint64_t modifier)
+{
+	switch (modifier) {
+	case I915_FORMAT_MOD_X_TILED:
+	case I915_FORMAT_MOD_Y_TILED:
+	case I915_FORMAT_MOD_4_TILED:
+		return true;
+	}
+
+	if (igt_vc4_is_tiled(modifier))
+		return true;
+
+	return is_amd_64k_s(modifier);
+}
+
+/**
+ * igt_tiling_create_fb:
+ * @fb: a tiled framebuffer
+ * @plane: the plane of @fb
+ *
+ * Returns: the tiling of @plane, or NULL when its modifier isn't supported
+ */
+struct igt_tiling *igt_tiling_create_fb(const struct igt_fb *fb, int plane)
+{
+	unsigned int bpp = fb->plane_bpp[plane];
+	struct igt_tiling_layout layout = {};
+	unsigned int column;
+
+	switch (fb->modifier) {
+	case I915_FORMAT_MOD_X_TILED:
+		return igt_tiling_create_intel(I915_TILING_X,
+					       I915_BIT_6_SWIZZLE_NONE,
+					       fb->strides[plane]);
+	case I915_FORMAT_MOD_Y_TILED:
+		return igt_tiling_create_intel(I915_TILING_Y,
+					       I915_BIT_6_SWIZZLE_NONE,
+					       fb->strides[plane]);
+	case I915_FORMAT_MOD_4_TILED:
+		return igt_tiling_create_intel(I915_TILING_4,
+					       I915_BIT_6_SWIZZLE_NONE,
+					       fb->strides[plane]);
+	case DRM_FORMAT_MOD_BROADCOM_VC4_T_TILED:
+		/* T-tiling is only supported for 16 and 32 bpp. */
+		igt_assert(bpp == 16 || bpp == 32);
+
+		layout.tile_width = 128;
+		layout.tile_height = 32;
+		layout.unit = bpp / 8;
+		layout.variants = 2;
+		layout.serpentine = true;
+		layout.offset = vc4_t_offset;
+
+		return igt_tiling_create(&layout, fb->strides[plane]);
+	}
+
+	if (igt_vc4_is_tiled(fb->modifier)) {
+		switch (fourcc_mod_broadcom_mod(fb->modifier)) {
+		case DRM_FORMAT_MOD_BROADCOM_SAND32:
+			column = 32;
+			break;
+		case DRM_FORMAT_MOD_BROADCOM_SAND64:
+			column = 64;
+			break;
+		case DRM_FORMAT_MOD_BROADCOM_SAND128:
+			column = 128;
+			break;
+		case DRM_FORMAT_MOD_BROADCOM_SAND256:
+			column = 256;
+			break;
+		default:
+			return NULL;
+		}
+
+		/*
+		 * Columns are as many pixels wide in every plane, subsampled
+		 * planes having proportionally larger pixels.
+		 */
+		column = column * fb->plane_width[plane] / fb->width * bpp / 8;
+
+		layout.tile_width = column;
+		layout.tile_height = fourcc_mod_broadcom_param(fb->modifier);
+		layout.unit = bpp / 8;
+		layout.offset = column_offset;
+		layout.data = &column;
+
+		return igt_tiling_create(&layout,
+					 ALIGN(fb->plane_width[plane] * bpp / 8,
+					       column));
+	}
+
+	if (is_amd_64k_s(fb->modifier))
+		return create_amd_64k_s(fb, plane);
+
+	return NULL;
+}
+
+/**
+ * igt_tiling_convert_fb:
+ * @dst: the destination framebuffer
+ * @dst_buf: a CPU mapping of @dst
+ * @src: the source framebuffer
+ * @src_buf: a CPU mapping of @src
+ *
+ * Copies every plane of a linear framebuffer into a tiled one, or the other
+ * way around. amdgpu tiled modifiers other than 64K_S are copied with the
+ * 64K_S layout, as igt_fb always did, with a warning.
+ */
+void igt_tiling_convert_fb(struct igt_fb *dst, void *dst_buf,
+			   struct igt_fb *src, void *src_buf)
+{
+	bool to_tiled = src->modifier == DRM_FORMAT_MOD_LINEAR;
+	struct igt_fb *tiled = to_tiled ? dst : src;
+	struct igt_fb *linear = to_tiled ? src : dst;
+	unsigned int plane;
+
+	igt_assert(linear->modifier == DRM_FORMAT_MOD_LINEAR);
+
+	for (plane = 0; plane < tiled->num_planes; plane++) {
+		struct igt_tiling *t = igt_tiling_create_fb(tiled, plane);
+		unsigned int width = min(dst->plane_width[plane],
+					 src->plane_width[plane]);
+		unsigned int height = min(dst->plane_height[plane],
+					  src->plane_height[plane]);
+		unsigned int bpp = tiled->plane_bpp[plane];
+
+		if (!t && igt_amd_is_tiled(tiled->modifier)) {
+			if (plane == 0)
+				igt_warn("amdgpu modifier 0x%"PRIx64" isn't 64K_S, using its layout anyway\n",
+					 tiled->modifier);
+			t = create_amd_64k_s(tiled, plane);
+		}
+		igt_require_f(t, "unsupported modifier 0x%"PRIx64"\n",
+			      tiled->modifier);
+
+		if (to_tiled)
+			igt_tiling_to_tiled(t, dst_buf + dst->offsets[plane],
+					    src_buf + src->offsets[plane],
+					    src->strides[plane], 0, 0,
+					    width * bpp / 8, height);
+		else
+			igt_tiling_from_tiled(t, dst_buf + dst->offsets[plane],
+					      dst->strides[plane],
+					      src_buf + src->offsets[plane],
+					      0, 0, width * bpp / 8, height);
+
+		igt_tiling_destroy(t);
+	}
+}
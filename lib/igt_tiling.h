@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef __IGT_TILING_H__
+#define __IGT_TILING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct igt_fb;
+
+/**
+ * igt_tiling_layout:
+ * @tile_width: width of a tile, in bytes
+ * @tile_height: height of a tile, in rows
+ * @unit: number of bytes @offset is evaluated for at once, which must always
+ *	  be contiguous in the tile
+ * @variants: number of tile rows with a different layout, tile row n using
+ *	      variant n % @variants
+ * @serpentine: whether odd tile rows are laid out right to left
+ * @offset: byte offset in the tile of byte @x of row @y of the tile
+ * @data: passed to @offset
+ *
+ * Describes a tiled layout, in which tiles of @tile_width by @tile_height
+ * bytes are stored one after the other, a tile row at a time. @offset is
+ * only evaluated when creating a #igt_tiling.
+ */
+struct igt_tiling_layout {
+	unsigned int tile_width;
+	unsigned int tile_height;
+	unsigned int unit;
+	unsigned int variants;
+	bool serpentine;
+	uint32_t (*offset)(const void *data, unsigned int variant,
+			   unsigned int x, unsigned int y);
+	const void *data;
+};
+
+struct igt_tiling;
+
+struct igt_tiling *igt_tiling_create(const struct igt_tiling_layout *layout,
+				     uint32_t stride);
+struct igt_tiling *igt_tiling_create_intel(uint32_t tiling, int swizzle,
+					   uint32_t stride);
+uint64_t igt_tiling_swizzle(uint64_t offset, int swizzle);
+struct igt_tiling *igt_tiling_create_fb(const struct igt_fb *fb, int plane);
+void igt_tiling_destroy(struct igt_tiling *t);
+
+unsigned int igt_tiling_chunk_size(const struct igt_tiling *t);
+uint64_t igt_tiling_offset(const struct igt_tiling *t,
+			   unsigned int x, unsigned int y);
+
+void igt_tiling_to_tiled(const struct igt_tiling *t, void *tiled,
+			 const void *linear, uint32_t linear_stride,
+			 unsigned int x, unsigned int y,
+			 unsigned int width, unsigned int height);
+void igt_tiling_from_tiled(const struct igt_tiling *t, void *linear,
+			   uint32_t linear_stride, const void *tiled,
+			   unsigned int x, unsigned int y,
+			   unsigned int width, unsigned int height);
+
+bool igt_tiling_fb_supported(uint64_t modifier);
+void igt_tiling_convert_fb(struct igt_fb *dst, void *dst_buf,
+			   struct igt_fb *src, void *src_buf);
+
+#endif /* __IGT_TILING_H__ */
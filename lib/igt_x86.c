@@ -37,6 +37,7 @@
 
 #include "igt_x86.h"
 #include "igt_aux.h"
+#include "igt_thread.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -68,6 +69,10 @@
 #define bit_SSE3	(1 << 0)
 #endif
 
+#ifndef bit_PCLMUL
+#define bit_PCLMUL	(1 << 1)
+#endif
+
 #ifndef bit_SSSE3
 #define bit_SSSE3	(1 << 9)
 #endif
@@ -96,10 +101,15 @@
 #define bit_AVX2	(1<<5)
 #endif
 
+#ifndef bit_AVX512F
+#define bit_AVX512F	(1<<16)
+#endif
+
 #define xgetbv(index,eax,edx) \
 	__asm__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c" (index))
 
 #define has_YMM 0x1
+#define has_ZMM 0x2
 
 #if defined(__x86_64__) || defined(__i386__)
 unsigned igt_x86_features(void)
@@ -129,6 +139,9 @@ unsigned igt_x86_features(void)
 			xgetbv(0, bv_eax, bv_ecx);
 			if ((bv_eax & 6) == 6)
 				extra |= has_YMM;
+			/* opmask, upper ZMM0-15 and ZMM16-31 state */
+			if ((bv_eax & 0xe6) == 0xe6)
+				extra |= has_ZMM;
 		}
 
 		if ((extra & has_YMM) && (ecx & bit_AVX))
@@ -145,6 +158,9 @@ unsigned igt_x86_features(void)
 
 		if (ecx & bit_F16C)
 			features |= F16C;
+
+		if (ecx & bit_PCLMUL)
+			features |= PCLMUL;
 	}
 
 	if (max >= 7) {
@@ -152,6 +168,9 @@ unsigned igt_x86_features(void)
 
 		if ((extra & has_YMM) && (ebx & bit_AVX2))
 			features |= AVX2;
+
+		if ((extra & has_ZMM) && (ebx & bit_AVX512F))
+			features |= AVX512;
 	}
 
 	return features;
@@ -183,6 +202,10 @@ char *igt_x86_features_to_string(unsigned features, char *line)
 		line += sprintf(line, ", avx2");
 	if (features & F16C)
 		line += sprintf(line, ", f16c");
+	if (features & AVX512)
+		line += sprintf(line, ", avx512");
+	if (features & PCLMUL)
+		line += sprintf(line, ", pclmul");
 
 	(void)line;
 
@@ -191,9 +214,63 @@ char *igt_x86_features_to_string(unsigned features, char *line)
 #endif
 
 #if defined(__x86_64__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+#include <emmintrin.h>
+static void memcpy_to_wc_sse2(void *dst, const void *src, unsigned long len)
+{
+	/* Non-temporal stores need an aligned destination */
+	if ((uintptr_t)dst & 15) {
+		unsigned long copy = min(len, 16 - ((uintptr_t)dst & 15));
+
+		memcpy(dst, src, copy);
+
+		dst += copy;
+		src += copy;
+		len -= copy;
+	}
+
+	while (len >= 64) {
+		__m128i *S = (__m128i *)src;
+		__m128i *D = (__m128i *)dst;
+		__m128i tmp[4];
+
+		tmp[0] = _mm_loadu_si128(S + 0);
+		tmp[1] = _mm_loadu_si128(S + 1);
+		tmp[2] = _mm_loadu_si128(S + 2);
+		tmp[3] = _mm_loadu_si128(S + 3);
+
+		_mm_stream_si128(D + 0, tmp[0]);
+		_mm_stream_si128(D + 1, tmp[1]);
+		_mm_stream_si128(D + 2, tmp[2]);
+		_mm_stream_si128(D + 3, tmp[3]);
+
+		src += 64;
+		dst += 64;
+		len -= 64;
+	}
+
+	while (len >= 16) {
+		_mm_stream_si128((__m128i *)dst,
+				 _mm_loadu_si128((__m128i *)src));
+
+		src += 16;
+		dst += 16;
+		len -= 16;
+	}
+
+	/* Order the streaming stores before any later store */
+	_mm_sfence();
+
+	if (len)
+		memcpy(dst, src, len);
+}
+
+#pragma GCC pop_options
+
 #pragma GCC push_options
 #pragma GCC target("sse4.1")
-#pragma GCC diagnostic ignored "-Wpointer-arith"
 
 #include <smmintrin.h>
 static void memcpy_from_wc_sse41(void *dst, const void *src, unsigned long len)
@@ -279,25 +356,399 @@ static void memcpy_from_wc_sse41(void *dst, const void *src, unsigned long len)
 
 #pragma GCC pop_options
 
-static void memcpy_from_wc(void *dst, const void *src, unsigned long len)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+static void memcpy_from_wc_avx2(void *dst, const void *src, unsigned long len)
 {
-	memcpy(dst, src, len);
+	char buf[32];
+
+	/* Flush the internal buffer of potential stale gfx data */
+	_mm_mfence();
+
+	if ((uintptr_t)src & 31) {
+		__m256i *S = (__m256i *)((uintptr_t)src & ~31);
+		unsigned long misalign = (uintptr_t)src & 31;
+		unsigned long copy = min(len, 32 - misalign);
+
+		_mm256_storeu_si256((__m256i *)buf,
+				    _mm256_stream_load_si256(S));
+
+		memcpy(dst, buf + misalign, copy);
+
+		dst += copy;
+		src += copy;
+		len -= copy;
+	}
+
+	while (len >= 128) {
+		__m256i *S = (__m256i *)src;
+		__m256i *D = (__m256i *)dst;
+		__m256i tmp[4];
+
+		tmp[0] = _mm256_stream_load_si256(S + 0);
+		tmp[1] = _mm256_stream_load_si256(S + 1);
+		tmp[2] = _mm256_stream_load_si256(S + 2);
+		tmp[3] = _mm256_stream_load_si256(S + 3);
+
+		_mm256_storeu_si256(D + 0, tmp[0]);
+		_mm256_storeu_si256(D + 1, tmp[1]);
+		_mm256_storeu_si256(D + 2, tmp[2]);
+		_mm256_storeu_si256(D + 3, tmp[3]);
+
+		src += 128;
+		dst += 128;
+		len -= 128;
+	}
+
+	while (len >= 32) {
+		_mm256_storeu_si256((__m256i *)dst,
+				    _mm256_stream_load_si256((__m256i *)src));
+
+		src += 32;
+		dst += 32;
+		len -= 32;
+	}
+
+	if (len) {
+		_mm256_storeu_si256((__m256i *)buf,
+				    _mm256_stream_load_si256((__m256i *)src));
+		memcpy(dst, buf, len);
+	}
+
+	_mm256_zeroupper();
 }
 
-static void (*resolve_memcpy_from_wc(void))(void *, const void *, unsigned long)
+static void memcpy_to_wc_avx2(void *dst, const void *src, unsigned long len)
 {
-	if (igt_x86_features() & SSE4_1)
-		return memcpy_from_wc_sse41;
+	if ((uintptr_t)dst & 31) {
+		unsigned long copy = min(len, 32 - ((uintptr_t)dst & 31));
+
+		memcpy(dst, src, copy);
+
+		dst += copy;
+		src += copy;
+		len -= copy;
+	}
+
+	while (len >= 128) {
+		__m256i *S = (__m256i *)src;
+		__m256i *D = (__m256i *)dst;
+		__m256i tmp[4];
+
+		tmp[0] = _mm256_loadu_si256(S + 0);
+		tmp[1] = _mm256_loadu_si256(S + 1);
+		tmp[2] = _mm256_loadu_si256(S + 2);
+		tmp[3] = _mm256_loadu_si256(S + 3);
+
+		_mm256_stream_si256(D + 0, tmp[0]);
+		_mm256_stream_si256(D + 1, tmp[1]);
+		_mm256_stream_si256(D + 2, tmp[2]);
+		_mm256_stream_si256(D + 3, tmp[3]);
+
+		src += 128;
+		dst += 128;
+		len -= 128;
+	}
 
-	return memcpy_from_wc;
+	while (len >= 32) {
+		_mm256_stream_si256((__m256i *)dst,
+				    _mm256_loadu_si256((__m256i *)src));
+
+		src += 32;
+		dst += 32;
+		len -= 32;
+	}
+
+	_mm_sfence();
+	_mm256_zeroupper();
+
+	if (len)
+		memcpy(dst, src, len);
 }
 
-void igt_memcpy_from_wc(void *dst, const void *src, unsigned long len)
-	__attribute__((ifunc("resolve_memcpy_from_wc")));
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+static void memcpy_from_wc_avx512(void *dst, const void *src, unsigned long len)
+{
+	char buf[64];
+
+	/* Flush the internal buffer of potential stale gfx data */
+	_mm_mfence();
+
+	if ((uintptr_t)src & 63) {
+		__m512i *S = (__m512i *)((uintptr_t)src & ~63);
+		unsigned long misalign = (uintptr_t)src & 63;
+		unsigned long copy = min(len, 64 - misalign);
+
+		_mm512_storeu_si512(buf, _mm512_stream_load_si512(S));
+
+		memcpy(dst, buf + misalign, copy);
+
+		dst += copy;
+		src += copy;
+		len -= copy;
+	}
+
+	while (len >= 256) {
+		__m512i *S = (__m512i *)src;
+		__m512i *D = (__m512i *)dst;
+		__m512i tmp[4];
+
+		tmp[0] = _mm512_stream_load_si512(S + 0);
+		tmp[1] = _mm512_stream_load_si512(S + 1);
+		tmp[2] = _mm512_stream_load_si512(S + 2);
+		tmp[3] = _mm512_stream_load_si512(S + 3);
+
+		_mm512_storeu_si512(D + 0, tmp[0]);
+		_mm512_storeu_si512(D + 1, tmp[1]);
+		_mm512_storeu_si512(D + 2, tmp[2]);
+		_mm512_storeu_si512(D + 3, tmp[3]);
+
+		src += 256;
+		dst += 256;
+		len -= 256;
+	}
+
+	while (len >= 64) {
+		_mm512_storeu_si512(dst, _mm512_stream_load_si512((void *)src));
+
+		src += 64;
+		dst += 64;
+		len -= 64;
+	}
+
+	if (len) {
+		_mm512_storeu_si512(buf, _mm512_stream_load_si512((void *)src));
+		memcpy(dst, buf, len);
+	}
+
+	_mm256_zeroupper();
+}
+
+static void memcpy_to_wc_avx512(void *dst, const void *src, unsigned long len)
+{
+	if ((uintptr_t)dst & 63) {
+		unsigned long copy = min(len, 64 - ((uintptr_t)dst & 63));
+
+		memcpy(dst, src, copy);
+
+		dst += copy;
+		src += copy;
+		len -= copy;
+	}
+
+	while (len >= 256) {
+		__m512i *S = (__m512i *)src;
+		__m512i *D = (__m512i *)dst;
+		__m512i tmp[4];
+
+		tmp[0] = _mm512_loadu_si512(S + 0);
+		tmp[1] = _mm512_loadu_si512(S + 1);
+		tmp[2] = _mm512_loadu_si512(S + 2);
+		tmp[3] = _mm512_loadu_si512(S + 3);
+
+		_mm512_stream_si512(D + 0, tmp[0]);
+		_mm512_stream_si512(D + 1, tmp[1]);
+		_mm512_stream_si512(D + 2, tmp[2]);
+		_mm512_stream_si512(D + 3, tmp[3]);
+
+		src += 256;
+		dst += 256;
+		len -= 256;
+	}
+
+	while (len >= 64) {
+		_mm512_stream_si512(dst, _mm512_loadu_si512(src));
+
+		src += 64;
+		dst += 64;
+		len -= 64;
+	}
+
+	_mm_sfence();
+	_mm256_zeroupper();
+
+	if (len)
+		memcpy(dst, src, len);
+}
+
+#pragma GCC pop_options
+
+static void memcpy_from_wc(void *dst, const void *src, unsigned long len)
+{
+	memcpy(dst, src, len);
+}
+
+const struct igt_memcpy_wc_impl igt_memcpy_from_wc_impls[] = {
+	{ "memcpy", memcpy_from_wc, 0 },
+	{ "sse4.1", memcpy_from_wc_sse41, SSE4_1 },
+	{ "avx2", memcpy_from_wc_avx2, AVX2 },
+	{ "avx512", memcpy_from_wc_avx512, AVX512 },
+	{ }
+};
+
+const struct igt_memcpy_wc_impl igt_memcpy_to_wc_impls[] = {
+	{ "memcpy", memcpy_from_wc, 0 },
+	{ "sse2", memcpy_to_wc_sse2, SSE2 },
+	{ "avx2", memcpy_to_wc_avx2, AVX2 },
+	{ "avx512", memcpy_to_wc_avx512, AVX512 },
+	{ }
+};
 
 #else
-void igt_memcpy_from_wc(void *dst, const void *src, unsigned long len)
+static void memcpy_from_wc(void *dst, const void *src, unsigned long len)
 {
 	memcpy(dst, src, len);
 }
+
+const struct igt_memcpy_wc_impl igt_memcpy_from_wc_impls[] = {
+	{ "memcpy", memcpy_from_wc, 0 },
+	{ }
+};
+
+const struct igt_memcpy_wc_impl igt_memcpy_to_wc_impls[] = {
+	{ "memcpy", memcpy_from_wc, 0 },
+	{ }
+};
 #endif
+
+typedef void (*memcpy_wc_fn)(void *, const void *, unsigned long);
+
+/* Pick the last, i.e. widest, supported entry of the table */
+static memcpy_wc_fn resolve_memcpy_wc(const struct igt_memcpy_wc_impl *impl)
+{
+	unsigned features = igt_x86_features();
+	memcpy_wc_fn fn = memcpy_from_wc;
+
+	for (; impl->name; impl++)
+		if ((impl->features & features) == impl->features)
+			fn = impl->copy;
+
+	return fn;
+}
+
+/*
+ * Resolved on first use rather than with an ifunc: the dynamic linker runs
+ * ifunc resolvers while relocating libigt, when neither the PLT entry of
+ * igt_x86_features() nor the GOT entries of the tables are usable yet.
+ * Racing threads resolve to the same function.
+ */
+static memcpy_wc_fn get_memcpy_wc(memcpy_wc_fn *fn,
+				  const struct igt_memcpy_wc_impl *impls)
+{
+	memcpy_wc_fn copy = __atomic_load_n(fn, __ATOMIC_RELAXED);
+
+	if (!copy) {
+		copy = resolve_memcpy_wc(impls);
+		__atomic_store_n(fn, copy, __ATOMIC_RELAXED);
+	}
+
+	return copy;
+}
+
+static memcpy_wc_fn get_memcpy_from_wc(void)
+{
+	static memcpy_wc_fn fn;
+
+	return get_memcpy_wc(&fn, igt_memcpy_from_wc_impls);
+}
+
+static memcpy_wc_fn get_memcpy_to_wc(void)
+{
+	static memcpy_wc_fn fn;
+
+	return get_memcpy_wc(&fn, igt_memcpy_to_wc_impls);
+}
+
+void igt_memcpy_from_wc(void *dst, const void *src, unsigned long len)
+{
+	get_memcpy_from_wc()(dst, src, len);
+}
+
+/**
+ * igt_memcpy_to_wc:
+ * @dst: destination buffer, typically a write-combining mapping
+ * @src: source buffer
+ * @len: number of bytes to copy
+ *
+ * Copy into a write-combining mapping using non-temporal stores where
+ * available, which avoids polluting the caches with the source data and
+ * keeps the write-combining buffers full.
+ */
+void igt_memcpy_to_wc(void *dst, const void *src, unsigned long len)
+{
+	get_memcpy_to_wc()(dst, src, len);
+}
+
+/* Minimum number of bytes worth handing over to a thread */
+#define MEMCPY_WC_BYTES_PER_THREAD (8ul << 20)
+
+struct memcpy_wc_parallel {
+	void (*copy)(void *dst, const void *src, unsigned long len);
+	char *dst;
+	const char *src;
+	unsigned long len;
+};
+
+static void memcpy_wc_worker(void *data, unsigned int idx, unsigned int count)
+{
+	struct memcpy_wc_parallel *c = data;
+	unsigned long start, end;
+
+	/* Keep the chunks page aligned relative to the start */
+	start = (c->len / count * idx) & ~4095ul;
+	end = idx == count - 1 ? c->len :
+	      (c->len / count * (idx + 1)) & ~4095ul;
+
+	c->copy(c->dst + start, c->src + start, end - start);
+}
+
+static void memcpy_wc_parallel(void (*copy)(void *, const void *,
+					    unsigned long),
+			       void *dst, const void *src, unsigned long len)
+{
+	struct memcpy_wc_parallel c = {
+		.copy = copy,
+		.dst = dst,
+		.src = src,
+		.len = len,
+	};
+
+	igt_thread_parallel(igt_thread_parallel_count(len,
+						      MEMCPY_WC_BYTES_PER_THREAD),
+			    memcpy_wc_worker, &c);
+}
+
+/**
+ * igt_memcpy_from_wc_parallel:
+ * @dst: destination buffer
+ * @src: source buffer, typically a write-combining mapping
+ * @len: number of bytes to copy
+ *
+ * Same as igt_memcpy_from_wc(), but large copies are split in chunks
+ * copied concurrently, to saturate the bandwidth available for uncached
+ * reads.
+ */
+void igt_memcpy_from_wc_parallel(void *dst, const void *src, unsigned long len)
+{
+	memcpy_wc_parallel(get_memcpy_from_wc(), dst, src, len);
+}
+
+/**
+ * igt_memcpy_to_wc_parallel:
+ * @dst: destination buffer, typically a write-combining mapping
+ * @src: source buffer
+ * @len: number of bytes to copy
+ *
+ * Same as igt_memcpy_to_wc(), but large copies are split in chunks copied
+ * concurrently.
+ */
+void igt_memcpy_to_wc_parallel(void *dst, const void *src, unsigned long len)
+{
+	memcpy_wc_parallel(get_memcpy_to_wc(), dst, src, len);
+}
@@ -40,6 +40,8 @@
 #define AVX	0x80
 #define AVX2	0x100
 #define F16C	0x200
+#define PCLMUL	0x400
+#define AVX512	0x800
 
 #if defined(__x86_64__) || defined(__i386__)
 unsigned igt_x86_features(void);
@@ -56,6 +58,27 @@ static inline char *igt_x86_features_to_string(unsigned features, char *line)
 }
 #endif
 
+/**
+ * igt_memcpy_wc_impl:
+ * @name: short name of the implementation
+ * @copy: the copy function
+ * @features: the igt_x86_features() required by the implementation
+ *
+ * Individual write-combining memcpy implementations, exposed for testing and
+ * benchmarking. The tables are terminated by an entry with a NULL @name.
+ */
+struct igt_memcpy_wc_impl {
+	const char *name;
+	void (*copy)(void *dst, const void *src, unsigned long len);
+	unsigned features;
+};
+
+extern const struct igt_memcpy_wc_impl igt_memcpy_from_wc_impls[];
+extern const struct igt_memcpy_wc_impl igt_memcpy_to_wc_impls[];
+
 void igt_memcpy_from_wc(void *dst, const void *src, unsigned long len);
+void igt_memcpy_to_wc(void *dst, const void *src, unsigned long len);
+void igt_memcpy_from_wc_parallel(void *dst, const void *src, unsigned long len);
+void igt_memcpy_to_wc_parallel(void *dst, const void *src, unsigned long len);
 
 #endif /* IGT_X86_H */
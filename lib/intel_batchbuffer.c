@@ -50,9 +50,9 @@
 #include "media_spin.h"
 #include "gpgpu_fill.h"
 #include "igt_aux.h"
+#include "igt_codec.h"
 #include "i830_reg.h"
 #include "huc_copy.h"
-#include <glib.h>
 
 #include <i915_drm.h>
 
@@ -2539,11 +2539,12 @@ static void intel_bb_dump_execbuf(struct intel_bb *ibb,
 static void intel_bb_dump_base64(struct intel_bb *ibb, int linelen)
 {
 	int outsize;
-	gchar *str, *pos;
+	char *str, *pos;
 
 	igt_info("--- bb ---\n");
-	pos = str = g_base64_encode((const guchar *) ibb->batch, ibb->size);
-	outsize = strlen(str);
+	pos = str = malloc(igt_base64_encode_length(ibb->size));
+	igt_assert(str);
+	outsize = igt_base64_encode(ibb->batch, ibb->size, str);
 
 	while (outsize > 0) {
 		igt_info("%.*s\n", min(outsize, linelen), pos);
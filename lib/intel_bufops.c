@@ -466,8 +466,8 @@ static void __copy_ccs(struct buf_ops *bops, struct intel_buf *buf,
 	case CCS_LINEAR_TO_BUF:
 		gem_set_domain(bops->fd, buf->handle,
 			       I915_GEM_DOMAIN_WC, I915_GEM_DOMAIN_WC);
-		igt_memcpy_from_wc(map + offset, (uint8_t *) linear + offset,
-				   ccs_size);
+		igt_memcpy_to_wc(map + offset, (uint8_t *) linear + offset,
+				 ccs_size);
 	case CCS_BUF_TO_LINEAR:
 		gem_set_domain(bops->fd, buf->handle, I915_GEM_DOMAIN_WC, 0);
 		igt_memcpy_from_wc((uint8_t *) linear + offset, map + offset,
@@ -685,7 +685,7 @@ static void copy_linear_to_gtt(struct buf_ops *bops, struct intel_buf *buf,
 	gem_set_domain(bops->fd, buf->handle,
 		       I915_GEM_DOMAIN_GTT, I915_GEM_DOMAIN_GTT);
 
-	memcpy(map, linear, buf->surface[0].size);
+	igt_memcpy_to_wc(map, linear, buf->surface[0].size);
 
 	munmap(map, buf->surface[0].size);
 }
@@ -703,7 +703,7 @@ static void copy_gtt_to_linear(struct buf_ops *bops, struct intel_buf *buf,
 	gem_set_domain(bops->fd, buf->handle,
 		       I915_GEM_DOMAIN_GTT, 0);
 
-	igt_memcpy_from_wc(linear, map, buf->surface[0].size);
+	igt_memcpy_from_wc_parallel(linear, map, buf->surface[0].size);
 
 	munmap(map, buf->surface[0].size);
 }
@@ -716,7 +716,7 @@ static void copy_linear_to_wc(struct buf_ops *bops, struct intel_buf *buf,
 	DEBUGFN();
 
 	map = mmap_write(bops->fd, buf);
-	memcpy(map, linear, buf->surface[0].size);
+	igt_memcpy_to_wc(map, linear, buf->surface[0].size);
 	munmap(map, buf->surface[0].size);
 }
 
@@ -728,7 +728,7 @@ static void copy_wc_to_linear(struct buf_ops *bops, struct intel_buf *buf,
 	DEBUGFN();
 
 	map = mmap_read(bops->fd, buf);
-	igt_memcpy_from_wc(linear, map, buf->surface[0].size);
+	igt_memcpy_from_wc_parallel(linear, map, buf->surface[0].size);
 	munmap(map, buf->surface[0].size);
 }
 
@@ -4,10 +4,12 @@
  */
 
 #include <assert.h>
+#include <errno.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -210,6 +212,24 @@ runnerpacket_read_helper read_runnerpacket(const struct runnerpacket *packet)
 		if (ret.resultoverride.result == NULL)
 			ret.type = PACKETTYPE_INVALID;
 
+		break;
+	case PACKETTYPE_FORK_SERVER_READY:
+		break;
+	case PACKETTYPE_FORK_REQUEST:
+		read_cstring(&ret.forkrequest.subtest, &p, &sizeleft);
+		read_cstring(&ret.forkrequest.dynamic_subtest, &p, &sizeleft);
+
+		if (ret.forkrequest.subtest == NULL ||
+		    ret.forkrequest.dynamic_subtest == NULL)
+			ret.type = PACKETTYPE_INVALID;
+
+		break;
+	case PACKETTYPE_FORK_SPAWNED:
+		if (sizeleft < sizeof(ret.forkspawned.pid))
+			ret.type = PACKETTYPE_INVALID;
+		else
+			read_integer(&ret.forkspawned.pid, sizeof(ret.forkspawned.pid), &p, &sizeleft);
+
 		break;
 	default:
 		ret.type = PACKETTYPE_INVALID;
@@ -460,6 +480,184 @@ struct runnerpacket *runnerpacket_resultoverride(const char *result)
 	return packet;
 }
 
+struct runnerpacket *runnerpacket_fork_server_ready(void)
+{
+	struct runnerpacket *packet;
+
+	packet = malloc(sizeof(struct runnerpacket));
+
+	packet->size = sizeof(struct runnerpacket);
+	packet->type = PACKETTYPE_FORK_SERVER_READY;
+	packet->senderpid = getpid();
+	packet->sendertid = gettid();
+
+	return packet;
+}
+
+struct runnerpacket *runnerpacket_fork_request(const char *subtest,
+					       const char *dynamic_subtest)
+{
+	struct runnerpacket *packet;
+	uint32_t size;
+	char *p;
+
+	if (dynamic_subtest == NULL)
+		dynamic_subtest = "";
+
+	size = sizeof(struct runnerpacket) + strlen(subtest) + strlen(dynamic_subtest) + 2;
+	packet = malloc(size);
+
+	packet->size = size;
+	packet->type = PACKETTYPE_FORK_REQUEST;
+	packet->senderpid = getpid();
+	packet->sendertid = gettid();
+
+	p = packet->data;
+
+	strcpy(p, subtest);
+	p += strlen(subtest) + 1;
+
+	strcpy(p, dynamic_subtest);
+	p += strlen(dynamic_subtest) + 1;
+
+	return packet;
+}
+
+struct runnerpacket *runnerpacket_fork_spawned(int32_t pid)
+{
+	struct runnerpacket *packet;
+	uint32_t size;
+
+	size = sizeof(struct runnerpacket) + sizeof(pid);
+	packet = malloc(size);
+
+	packet->size = size;
+	packet->type = PACKETTYPE_FORK_SPAWNED;
+	packet->senderpid = getpid();
+	packet->sendertid = gettid();
+
+	memcpy(packet->data, &pid, sizeof(pid));
+
+	return packet;
+}
+
+/**
+ * send_packet_with_fds:
+ * @sock: A connected SOCK_SEQPACKET or SOCK_DGRAM unix socket
+ * @packet: The packet to send
+ * @fds: File descriptors to pass along with the packet
+ * @nfds: Number of entries in @fds, at most #RUNNERPACKET_MAX_FDS
+ *
+ * Sends @packet as a single message on @sock, passing @fds to the
+ * receiver as SCM_RIGHTS ancillary data. Used for the fork server
+ * control protocol.
+ *
+ * Returns: Whether the whole packet was sent.
+ */
+bool send_packet_with_fds(int sock, const struct runnerpacket *packet,
+			  const int *fds, int nfds)
+{
+	union {
+		char buf[CMSG_SPACE(RUNNERPACKET_MAX_FDS * sizeof(int))];
+		struct cmsghdr align;
+	} control = {};
+	struct iovec iov = {
+		.iov_base = (void *)packet,
+		.iov_len = packet->size,
+	};
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+	ssize_t ret;
+
+	assert(nfds >= 0 && nfds <= RUNNERPACKET_MAX_FDS);
+
+	if (nfds) {
+		struct cmsghdr *cmsg;
+
+		msg.msg_control = control.buf;
+		msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+		memcpy(CMSG_DATA(cmsg), fds, nfds * sizeof(int));
+	}
+
+	do {
+		ret = sendmsg(sock, &msg, MSG_NOSIGNAL);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret == packet->size;
+}
+
+/**
+ * recv_packet_with_fds:
+ * @sock: A connected SOCK_SEQPACKET or SOCK_DGRAM unix socket
+ * @fds: Storage for at least #RUNNERPACKET_MAX_FDS file descriptors
+ * @nfds: Set to the number of file descriptors received
+ *
+ * Receives one packet sent with send_packet_with_fds(). Received file
+ * descriptors are close-on-exec and owned by the caller, also when
+ * the packet itself turns out to be malformed.
+ *
+ * Returns: A newly allocated packet, or NULL on errors and when the
+ * peer has closed the connection.
+ */
+struct runnerpacket *recv_packet_with_fds(int sock, int *fds, int *nfds)
+{
+	union {
+		char buf[CMSG_SPACE(RUNNERPACKET_MAX_FDS * sizeof(int))];
+		struct cmsghdr align;
+	} control;
+	struct runnerpacket *packet;
+	struct cmsghdr *cmsg;
+	struct msghdr msg = {};
+	struct iovec iov;
+	char buf[4096];
+	ssize_t ret;
+
+	*nfds = 0;
+
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do {
+		ret = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret <= 0)
+		return NULL;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		int n;
+
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+
+		n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		if (n > RUNNERPACKET_MAX_FDS - *nfds)
+			n = RUNNERPACKET_MAX_FDS - *nfds;
+		memcpy(fds + *nfds, CMSG_DATA(cmsg), n * sizeof(int));
+		*nfds += n;
+	}
+
+	if (ret < sizeof(*packet) || (msg.msg_flags & MSG_TRUNC))
+		return NULL;
+
+	packet = malloc(ret);
+	memcpy(packet, buf, ret);
+	packet->size = ret;
+
+	return packet;
+}
+
 uint32_t socket_dump_canary(void)
 {
 	return 'I' << 24 | 'G' << 16 | 'T' << 8 | '1';
@@ -104,6 +104,19 @@ typedef union runnerpacket_read_helper {
 
 		const char *result;
 	} resultoverride;
+
+	struct {
+		uint32_t type;
+
+		const char *subtest;
+		const char *dynamic_subtest;
+	} forkrequest;
+
+	struct {
+		uint32_t type;
+
+		int32_t pid;
+	} forkspawned;
 } runnerpacket_read_helper;
 
 void set_runner_socket(int fd);
@@ -190,6 +203,29 @@ enum runnerpacket_type {
        * cstring: The result to use, as text. All lowercase.
        */
 
+      PACKETTYPE_FORK_SERVER_READY,
+      /*
+       * Fork server has reached its first subtest and waits for
+       * requests. Sent by the test on the fork server control socket,
+       * never dumped.
+       * No data.
+       */
+
+      PACKETTYPE_FORK_REQUEST,
+      /*
+       * Fork a process to run one subtest. Sent by runner on the fork
+       * server control socket, together with the stdout, stderr and
+       * optionally the comms socket fds for the new process as
+       * SCM_RIGHTS ancillary data. Never dumped.
+       * cstring: Name of the subtest
+       * cstring: Name of the dynamic subtest, empty for none
+       */
+
+      PACKETTYPE_FORK_SPAWNED,
+      /*
+       * Reply to a fork request. Never dumped.
+       * int32_t: pid of the forked process, or a negative errno
+       */
 
       PACKETTYPE_NUM_TYPES /* must be last */
 };
@@ -205,6 +241,16 @@ struct runnerpacket *runnerpacket_dynamic_subtest_result(const char *name, const
 							 const char *timeused, const char *reason);
 struct runnerpacket *runnerpacket_versionstring(const char *text);
 struct runnerpacket *runnerpacket_resultoverride(const char *result);
+struct runnerpacket *runnerpacket_fork_server_ready(void);
+struct runnerpacket *runnerpacket_fork_request(const char *subtest,
+					       const char *dynamic_subtest);
+struct runnerpacket *runnerpacket_fork_spawned(int32_t pid);
+
+#define RUNNERPACKET_MAX_FDS 3
+
+bool send_packet_with_fds(int sock, const struct runnerpacket *packet,
+			  const int *fds, int nfds);
+struct runnerpacket *recv_packet_with_fds(int sock, int *fds, int *nfds);
 
 uint32_t socket_dump_canary(void);
 
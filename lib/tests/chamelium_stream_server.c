@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "chamelium_stream_server.h"
+
+/*
+ * A local stand-in for the Chamelium streaming server, for the lib test and
+ * the chamelium_stream benchmark. The wire values are those of the streaming
+ * protocol, as igt_chamelium_stream.c speaks it.
+ */
+#define STREAM_VERSION_MAJOR 1
+#define STREAM_VERSION_MINOR_CAPTURE 1
+
+enum stream_error {
+	STREAM_ERROR_NONE = 0,
+	STREAM_ERROR_COMMAND = 1,
+	STREAM_ERROR_ARGUMENT = 2,
+	STREAM_ERROR_NO_MEM = 8,
+};
+
+enum stream_message_kind {
+	STREAM_MESSAGE_REQUEST = 0,
+	STREAM_MESSAGE_RESPONSE = 1,
+};
+
+enum stream_message_type {
+	STREAM_MESSAGE_GET_VERSION = 1,
+	STREAM_MESSAGE_READ_CAPTURED_FRAME = 9,
+	STREAM_MESSAGE_READ_CAPTURED_CRCS = 10,
+	STREAM_MESSAGE_DUMP_PIXELS = 11,
+};
+
+struct chamelium_stream_server {
+	int fd;
+	unsigned int port;
+	pthread_t thread;
+
+	/* The connected client, shut down to stop the server */
+	pthread_mutex_t lock;
+	int client;
+	bool stopping;
+
+	int width, height;
+	unsigned char **frames;
+	const igt_crc_t *crcs;
+	int frame_count;
+};
+
+static bool server_recv(int fd, void *buf, size_t len)
+{
+	while (len) {
+		ssize_t ret = recv(fd, buf, len, MSG_WAITALL);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf = (char *)buf + ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+static bool server_send(int fd, const void *buf, size_t len)
+{
+	while (len) {
+		ssize_t ret = send(fd, buf, len, MSG_NOSIGNAL);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf = (const char *)buf + ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+static bool server_send_header(int fd, enum stream_message_type type,
+			       enum stream_error err, size_t len)
+{
+	char buf[8];
+
+	*(uint16_t *) &buf[0] = htons(type | STREAM_MESSAGE_RESPONSE << 8);
+	*(uint16_t *) &buf[2] = htons(err);
+	*(uint32_t *) &buf[4] = htonl(len);
+
+	return server_send(fd, buf, sizeof(buf));
+}
+
+static bool server_respond(int fd, enum stream_message_type type,
+			   enum stream_error err, const void *body, size_t len)
+{
+	return server_send_header(fd, type, err, len) &&
+	       server_send(fd, body, len);
+}
+
+/* The frame is sent from where it lies, a line at a time when cropped */
+static bool server_send_frame(struct chamelium_stream_server *server, int fd,
+			      enum stream_message_type type,
+			      const unsigned char *pixels, int w, int h)
+{
+	uint16_t size[2] = { htons(w), htons(h) };
+	size_t stride = server->width * 3;
+
+	if (!server_send_header(fd, type, STREAM_ERROR_NONE,
+				sizeof(size) + (size_t)w * h * 3) ||
+	    !server_send(fd, size, sizeof(size)))
+		return false;
+
+	if (w == server->width)
+		return server_send(fd, pixels, stride * h);
+
+	for (int y = 0; y < h; y++)
+		if (!server_send(fd, pixels + y * stride, w * 3))
+			return false;
+
+	return true;
+}
+
+static bool server_send_crcs(struct chamelium_stream_server *server, int fd)
+{
+	int n_words = server->frame_count ? server->crcs[0].n_words : 4;
+	size_t len = (1 + (size_t)server->frame_count * n_words) * sizeof(uint32_t);
+	uint32_t *body = malloc(len), *p = body;
+	bool ret;
+
+	if (!body)
+		return server_respond(fd, STREAM_MESSAGE_READ_CAPTURED_CRCS,
+				      STREAM_ERROR_NO_MEM, NULL, 0);
+
+	*p++ = htonl(n_words);
+	for (int i = 0; i < server->frame_count; i++)
+		for (int j = 0; j < n_words; j++)
+			*p++ = htonl(server->crcs[i].crc[j]);
+
+	ret = server_respond(fd, STREAM_MESSAGE_READ_CAPTURED_CRCS,
+			     STREAM_ERROR_NONE, body, len);
+	free(body);
+
+	return ret;
+}
+
+static bool server_handle(struct chamelium_stream_server *server, int fd)
+{
+	enum stream_message_type type;
+	uint32_t body[5];
+	uint16_t hdr[2];
+	uint32_t len;
+
+	if (!server_recv(fd, hdr, sizeof(hdr)) ||
+	    !server_recv(fd, &len, sizeof(len)))
+		return false;
+
+	type = ntohs(hdr[0]) & 0xff;
+	len = ntohl(len);
+
+	if (ntohs(hdr[0]) >> 8 != STREAM_MESSAGE_REQUEST || len > sizeof(body)) {
+		char discard[1024];
+
+		while (len) {
+			uint32_t n = len < sizeof(discard) ? len : sizeof(discard);
+
+			if (!server_recv(fd, discard, n))
+				return false;
+			len -= n;
+		}
+
+		return server_respond(fd, type, STREAM_ERROR_COMMAND, NULL, 0);
+	}
+
+	if (!server_recv(fd, body, len))
+		return false;
+
+	switch (type) {
+	case STREAM_MESSAGE_GET_VERSION: {
+		uint8_t version[2] = {
+			STREAM_VERSION_MAJOR, STREAM_VERSION_MINOR_CAPTURE
+		};
+
+		return server_respond(fd, type, STREAM_ERROR_NONE,
+				      version, sizeof(version));
+	}
+	case STREAM_MESSAGE_READ_CAPTURED_FRAME: {
+		uint32_t index = ntohl(body[0]);
+
+		if (len != sizeof(uint32_t) || index >= (uint32_t)server->frame_count)
+			break;
+
+		return server_send_frame(server, fd, type,
+					 server->frames[index],
+					 server->width, server->height);
+	}
+	case STREAM_MESSAGE_DUMP_PIXELS: {
+		int x = ntohl(body[1]), y = ntohl(body[2]);
+		int w = ntohl(body[3]), h = ntohl(body[4]);
+
+		if (len != sizeof(body) || !server->frame_count)
+			break;
+
+		if (!w || !h) {
+			x = y = 0;
+			w = server->width;
+			h = server->height;
+		}
+		if (x < 0 || y < 0 || w < 0 || h < 0 ||
+		    x + w > server->width || y + h > server->height)
+			break;
+
+		return server_send_frame(server, fd, type,
+					 server->frames[0] +
+					 ((size_t)y * server->width + x) * 3,
+					 w, h);
+	}
+	case STREAM_MESSAGE_READ_CAPTURED_CRCS:
+		return server_send_crcs(server, fd);
+	default:
+		return server_respond(fd, type, STREAM_ERROR_COMMAND, NULL, 0);
+	}
+
+	return server_respond(fd, type, STREAM_ERROR_ARGUMENT, NULL, 0);
+}
+
+static void *server_thread(void *data)
+{
+	struct chamelium_stream_server *server = data;
+	int fd;
+
+	while ((fd = accept(server->fd, NULL, NULL)) >= 0) {
+		bool stopping;
+
+		pthread_mutex_lock(&server->lock);
+		stopping = server->stopping;
+		if (!stopping)
+			server->client = fd;
+		pthread_mutex_unlock(&server->lock);
+
+		if (!stopping)
+			while (server_handle(server, fd))
+				;
+
+		pthread_mutex_lock(&server->lock);
+		server->client = -1;
+		pthread_mutex_unlock(&server->lock);
+		close(fd);
+
+		if (stopping)
+			break;
+	}
+
+	return NULL;
+}
+
+/**
+ * chamelium_stream_server_create:
+ * @width: width of the frames
+ * @height: height of the frames
+ * @frames: @frame_count frames, 3 bytes per pixel
+ * @crcs: the CRCs of the @frames
+ * @frame_count: the number of frames
+ *
+ * Starts a local stand-in for the Chamelium streaming server, serving
+ * @frames and @crcs as those of the last video capture. DumpPixels captures
+ * the first frame. The server listens on the loopback interface, and
+ * handles one client at a time.
+ *
+ * @frames and @crcs must outlive the server.
+ *
+ * Returns: the server, or NULL on failure.
+ */
+struct chamelium_stream_server *
+chamelium_stream_server_create(int width, int height, unsigned char **frames,
+			       const igt_crc_t *crcs, int frame_count)
+{
+	struct chamelium_stream_server *server;
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	socklen_t addr_len = sizeof(addr);
+
+	server = calloc(1, sizeof(*server));
+	if (!server)
+		return NULL;
+
+	server->width = width;
+	server->height = height;
+	server->frames = frames;
+	server->crcs = crcs;
+	server->frame_count = frame_count;
+	server->client = -1;
+	pthread_mutex_init(&server->lock, NULL);
+
+	server->fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (server->fd < 0)
+		goto error_server;
+
+	if (bind(server->fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(server->fd, 1) ||
+	    getsockname(server->fd, (struct sockaddr *)&addr, &addr_len))
+		goto error_fd;
+	server->port = ntohs(addr.sin_port);
+
+	if (pthread_create(&server->thread, NULL, server_thread, server))
+		goto error_fd;
+
+	return server;
+
+error_fd:
+	close(server->fd);
+error_server:
+	pthread_mutex_destroy(&server->lock);
+	free(server);
+	return NULL;
+}
+
+/**
+ * chamelium_stream_server_port:
+ * @server: the stand-in server
+ *
+ * Returns: the port the server listens on, for chamelium_stream_init_host().
+ */
+unsigned int chamelium_stream_server_port(struct chamelium_stream_server *server)
+{
+	return server->port;
+}
+
+/**
+ * chamelium_stream_server_destroy:
+ * @server: the stand-in server
+ *
+ * Stops the server, disconnecting its client if it is still connected.
+ */
+void chamelium_stream_server_destroy(struct chamelium_stream_server *server)
+{
+	pthread_mutex_lock(&server->lock);
+	server->stopping = true;
+	if (server->client >= 0)
+		shutdown(server->client, SHUT_RDWR);
+	pthread_mutex_unlock(&server->lock);
+
+	shutdown(server->fd, SHUT_RDWR);
+	pthread_join(server->thread, NULL);
+
+	close(server->fd);
+	pthread_mutex_destroy(&server->lock);
+	free(server);
+}
@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef CHAMELIUM_STREAM_SERVER_H
+#define CHAMELIUM_STREAM_SERVER_H
+
+#include "igt_pipe_crc.h"
+
+struct chamelium_stream_server;
+
+struct chamelium_stream_server *
+chamelium_stream_server_create(int width, int height, unsigned char **frames,
+			       const igt_crc_t *crcs, int frame_count);
+unsigned int chamelium_stream_server_port(struct chamelium_stream_server *server);
+void chamelium_stream_server_destroy(struct chamelium_stream_server *server);
+
+#endif /* CHAMELIUM_STREAM_SERVER_H */
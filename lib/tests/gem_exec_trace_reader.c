@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_lz4.h"
+#include "../../benchmarks/gem_exec_trace.h"
+
+IGT_TEST_DESCRIPTION("Read back version 2 gem_exec_tracer files as version 1 records");
+
+struct buf {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+};
+
+static uint8_t *buf_reserve(struct buf *b, size_t len)
+{
+	if (b->len + len > b->size) {
+		b->size = 2 * (b->len + len);
+		b->data = realloc(b->data, b->size);
+		igt_assert(b->data);
+	}
+
+	return b->data + b->len;
+}
+
+static void buf_add(struct buf *b, const void *data, size_t len)
+{
+	memcpy(buf_reserve(b, len), data, len);
+	b->len += len;
+}
+
+static void buf_varint(struct buf *b, uint64_t v)
+{
+	uint8_t *p = buf_reserve(b, TRACE_VARINT_MAX);
+
+	b->len = trace_put_varint(p, v) - b->data;
+}
+
+/*
+ * Both the version 2 encoding, as gem_exec_tracer writes it, and the
+ * version 1 records the reader is expected to return.
+ */
+struct trace {
+	struct buf v2;
+	struct buf v1;
+	uint64_t time;
+};
+
+static void trace_cmd(struct trace *t, uint8_t cmd)
+{
+	buf_add(&t->v2, &cmd, 1);
+	buf_add(&t->v1, &cmd, 1);
+}
+
+static void trace_time(struct trace *t, uint64_t delta)
+{
+	uint8_t cmd = TIMESTAMP;
+
+	t->time += delta;
+	buf_varint(&t->v2, delta);
+	buf_add(&t->v1, &cmd, 1);
+	buf_add(&t->v1, &t->time, sizeof(t->time));
+}
+
+static void trace_add(struct trace *t, uint32_t handle, uint64_t size)
+{
+	struct trace_add_bo r = { handle, size };
+
+	trace_cmd(t, ADD_BO);
+	buf_varint(&t->v2, handle);
+	buf_varint(&t->v2, size);
+	buf_add(&t->v1, &r, sizeof(r));
+}
+
+static void trace_handle(struct trace *t, uint8_t cmd, uint32_t handle)
+{
+	trace_cmd(t, cmd);
+	buf_varint(&t->v2, handle);
+	buf_add(&t->v1, &handle, sizeof(handle));
+}
+
+static void trace_wait(struct trace *t, uint64_t delta, uint32_t handle)
+{
+	uint8_t cmd = WAIT;
+
+	buf_add(&t->v2, &cmd, 1);
+	trace_time(t, delta);
+	buf_varint(&t->v2, handle);
+	buf_add(&t->v1, &cmd, 1);
+	buf_add(&t->v1, &handle, sizeof(handle));
+}
+
+static void trace_exec(struct trace *t, uint64_t delta,
+		       const struct trace_exec *exec,
+		       const struct trace_exec_object *objects,
+		       const struct trace_exec_relocation *relocs)
+{
+	uint64_t handle = 0, offset = 0;
+	uint8_t cmd = EXEC;
+
+	buf_add(&t->v2, &cmd, 1);
+	trace_time(t, delta);
+	buf_varint(&t->v2, exec->object_count);
+	buf_varint(&t->v2, exec->flags);
+	buf_varint(&t->v2, exec->context);
+	buf_add(&t->v1, &cmd, 1);
+	buf_add(&t->v1, exec, sizeof(*exec));
+
+	for (uint32_t i = 0; i < exec->object_count; i++) {
+		const struct trace_exec_object *obj = &objects[i];
+		uint64_t target = 0, roffset = 0, presumed = 0;
+
+		buf_varint(&t->v2, trace_zigzag(obj->handle - handle));
+		buf_varint(&t->v2, obj->relocation_count);
+		buf_varint(&t->v2, obj->alignment);
+		buf_varint(&t->v2, trace_zigzag(obj->offset - offset));
+		buf_varint(&t->v2, obj->flags);
+		buf_varint(&t->v2, obj->rsvd1);
+		buf_varint(&t->v2, obj->rsvd2);
+		buf_add(&t->v1, obj, sizeof(*obj));
+		handle = obj->handle;
+		offset = obj->offset;
+
+		for (uint32_t j = 0; j < obj->relocation_count; j++) {
+			const struct trace_exec_relocation *r = relocs++;
+
+			buf_varint(&t->v2, trace_zigzag(r->target_handle - target));
+			buf_varint(&t->v2, r->delta);
+			buf_varint(&t->v2, trace_zigzag(r->offset - roffset));
+			buf_varint(&t->v2, trace_zigzag(r->presumed_offset - presumed));
+			buf_varint(&t->v2, r->read_domains);
+			buf_varint(&t->v2, r->write_domain);
+			buf_add(&t->v1, r, sizeof(*r));
+			target = r->target_handle;
+			roffset = r->offset;
+			presumed = r->presumed_offset;
+		}
+	}
+}
+
+/* Handles and offsets going down, and wrapping around both ways */
+static void trace_records(struct trace *t)
+{
+	static const struct trace_exec exec = {
+		.object_count = 4, .flags = 0x8000000000000001, .context = 7,
+	};
+	static const struct trace_exec_object objects[] = {
+		{ .handle = 5, .offset = 0xfffffffffffff000,
+		  .relocation_count = 2, .alignment = 4096, .flags = 0x1ff },
+		{ .handle = 2, .offset = 0x1000, .rsvd1 = ~0ull },
+		{ .handle = 0xffffffff, .offset = 0x8000000000000000,
+		  .relocation_count = 1, .rsvd2 = 1 },
+		{ .handle = 1, .offset = 0x7fffffffffffffff },
+	};
+	static const struct trace_exec_relocation relocs[] = {
+		{ .target_handle = 0xffffffff, .delta = 0xfffffffc,
+		  .offset = 0xffffffffffffffff, .presumed_offset = 1,
+		  .read_domains = 2, .write_domain = 2 },
+		{ .target_handle = 3, .delta = 0,
+		  .offset = 8, .presumed_offset = 0xfffffffffffff000 },
+		{ .target_handle = 0, .offset = 0x8000000000000000,
+		  .presumed_offset = 0x7fffffffffffffff },
+	};
+
+	trace_handle(t, ADD_CTX, 7);
+	trace_add(t, 5, 1ull << 40);
+	trace_add(t, 0xffffffff, 4096);
+	trace_exec(t, 1000, &exec, objects, relocs);
+	trace_wait(t, ~0ull >> 1, 5);
+	trace_exec(t, 0, &exec, objects, relocs);
+	trace_handle(t, DEL_BO, 0xffffffff);
+	trace_handle(t, DEL_CTX, 7);
+}
+
+static void write_trace(const char *filename, int blocks)
+{
+	static const struct trace_version version = {
+		.magic = TRACE_MAGIC,
+		.version = 2,
+	};
+	struct trace_block_index index[blocks];
+	struct trace_index idx = {
+		.magic = TRACE_INDEX_MAGIC,
+		.count = blocks,
+	};
+	struct buf file = {};
+	FILE *f;
+
+	buf_add(&file, &version, sizeof(version));
+	for (int i = 0; i < blocks; i++) {
+		struct trace_block blk = { .magic = TRACE_BLOCK_MAGIC };
+		struct trace t = {};
+		size_t bound;
+		ssize_t ret;
+
+		trace_records(&t);
+		for (int j = 0; j < i; j++)
+			trace_records(&t);
+
+		index[i].offset = file.len;
+		index[i].time = 0;
+
+		/* Every other block compressed */
+		blk.raw_size = t.v2.len;
+		bound = igt_lz4_compress_bound(t.v2.len);
+		buf_reserve(&file, sizeof(blk) + bound);
+		ret = i & 1 ? igt_lz4_compress(t.v2.data, t.v2.len,
+					       file.data + file.len + sizeof(blk),
+					       bound) : 0;
+		if (ret > 0) {
+			blk.flags = TRACE_BLOCK_LZ4;
+			blk.size = ret;
+		} else {
+			blk.size = t.v2.len;
+			memcpy(file.data + file.len + sizeof(blk),
+			       t.v2.data, t.v2.len);
+		}
+		memcpy(file.data + file.len, &blk, sizeof(blk));
+		file.len += sizeof(blk) + blk.size;
+
+		free(t.v1.data);
+		free(t.v2.data);
+	}
+
+	idx.offset = file.len;
+	buf_add(&file, index, sizeof(index));
+	buf_add(&file, &idx, sizeof(idx));
+
+	f = fopen(filename, "w");
+	igt_assert(f);
+	igt_assert_eq(fwrite(file.data, 1, file.len, f), file.len);
+	fclose(f);
+	free(file.data);
+}
+
+static void test_read(const char *filename, int blocks, bool threaded)
+{
+	struct trace_reader *r;
+	size_t len;
+	uint8_t *data;
+
+	write_trace(filename, blocks);
+
+	r = trace_reader_open(filename, threaded);
+	igt_assert(r);
+
+	for (int i = 0; i < blocks; i++) {
+		struct trace t = {};
+
+		for (int j = 0; j <= i; j++)
+			trace_records(&t);
+
+		data = trace_reader_next(r, &len);
+		igt_assert(data);
+		igt_assert_eq(len, t.v1.len);
+		igt_assert(!memcmp(data, t.v1.data, len));
+
+		free(t.v1.data);
+		free(t.v2.data);
+	}
+
+	igt_assert(!trace_reader_next(r, &len));
+	igt_assert(!trace_reader_error(r));
+	trace_reader_close(r);
+}
+
+igt_main
+{
+	char filename[] = "/tmp/gem_exec_trace.XXXXXX";
+
+	igt_fixture
+		close(mkstemp(filename));
+
+	igt_subtest("read")
+		test_read(filename, 8, false);
+
+	igt_subtest("read-threaded")
+		test_read(filename, 8, true);
+
+	igt_fixture
+		unlink(filename);
+}
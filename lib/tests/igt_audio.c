@@ -27,6 +27,7 @@
 
 #include <stdlib.h>
 
+#include "igt_aux.h"
 #include "igt_core.h"
 #include "igt_audio.h"
 
@@ -174,6 +175,79 @@ static void test_signal_detect_phaseshift(struct audio_signal *signal)
 	igt_assert(!ok);
 }
 
+static void test_signal_detector_streaming(void)
+{
+	const int channels = 2, hop = BUFFER_LEN / 4, page = 128;
+	struct audio_signal *signal;
+	struct audio_signal_detector *det;
+	double *buf, *channel;
+	int32_t *samples;
+	size_t frames, pushed, detections;
+	bool detected[2];
+	size_t i;
+	int c;
+
+	signal = audio_signal_init(channels, SAMPLING_RATE);
+	for (i = 0; i < test_freqs_len; i++)
+		for (c = 0; c < channels; c++)
+			audio_signal_add_frequency(signal, test_freqs[i] + c * 50,
+						   c);
+	audio_signal_synthesize(signal);
+
+	frames = 4 * BUFFER_LEN;
+	buf = malloc(frames * channels * sizeof(double));
+	samples = malloc(frames * channels * sizeof(int32_t));
+	channel = malloc(BUFFER_LEN * sizeof(double));
+	audio_signal_fill(signal, buf, frames);
+	audio_convert_to(samples, buf, frames * channels, SND_PCM_FORMAT_S32_LE);
+
+	det = audio_signal_detector_init(signal, SAMPLING_RATE, channels,
+					 BUFFER_LEN, hop);
+
+	/* Feed the detector page by page, as a capture would, and check each
+	 * sliding window against a one-shot detection of the same samples. */
+	pushed = 0;
+	detections = 0;
+	while (pushed < frames * channels) {
+		size_t len = min(page * channels, frames * channels - pushed);
+
+		pushed += audio_signal_detector_push_s32_le(det,
+							    &samples[pushed],
+							    len, channels,
+							    NULL);
+		if (!audio_signal_detector_ready(det))
+			continue;
+
+		igt_assert(audio_signal_detector_detect(det, detected));
+		for (c = 0; c < channels; c++) {
+			audio_extract_channel_s32_le(channel, BUFFER_LEN,
+				&samples[pushed - BUFFER_LEN * channels],
+				BUFFER_LEN * channels, channels, c);
+			igt_assert(detected[c]);
+			igt_assert(audio_signal_detect(signal, SAMPLING_RATE, c,
+						       channel, BUFFER_LEN));
+		}
+		detections++;
+	}
+	igt_assert_eq(detections, (frames - BUFFER_LEN) / hop + 1);
+
+	/* Swapped channels must not be detected */
+	audio_signal_detector_reset(det);
+	pushed = 0;
+	while (!audio_signal_detector_ready(det))
+		pushed += audio_signal_detector_push_s32_le(det,
+				&samples[pushed], frames * channels - pushed,
+				channels, (const int[]){ 1, 0 });
+	igt_assert(!audio_signal_detector_detect(det, detected));
+	igt_assert(!detected[0] && !detected[1]);
+
+	audio_signal_detector_fini(det);
+	free(channel);
+	free(samples);
+	free(buf);
+	audio_signal_fini(signal);
+}
+
 igt_main
 {
 	struct audio_signal *signal = NULL;
@@ -219,4 +293,7 @@ igt_main
 			audio_signal_fini(signal);
 		}
 	}
+
+	igt_subtest("signal-detector-streaming")
+		test_signal_detector_streaming();
 }
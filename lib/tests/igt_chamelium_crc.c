@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_chamelium_crc.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+
+IGT_TEST_DESCRIPTION("Check the Chamelium CRC implementations against the original one");
+
+/* As chamelium_xrgb_hash16() used to compute each word, a pass at a time */
+static uint32_t reference_hash16(const unsigned char *buffer, int width,
+				 int height, int k, int m)
+{
+	unsigned char r, g, b;
+	uint64_t sum = 0;
+	uint64_t count = 0;
+	uint64_t value;
+	int index;
+	int i;
+
+	for (i = 0; i < width * height; i++) {
+		if ((i % m) != k)
+			continue;
+
+		index = i * 4;
+
+		r = buffer[index + 2];
+		g = buffer[index + 1];
+		b = buffer[index + 0];
+
+		value = r | (g << 8) | (b << 16);
+		sum += ++count * value;
+	}
+
+	return ((sum >> 0) ^ (sum >> 16) ^ (sum >> 32) ^ (sum >> 48)) & 0xffff;
+}
+
+static void reference_crc(const void *pixels, int width, int height,
+			  uint32_t crc[IGT_CHAMELIUM_CRC_WORDS])
+{
+	for (int i = 0; i < IGT_CHAMELIUM_CRC_WORDS; i++)
+		crc[i] = reference_hash16(pixels, width, height,
+					  IGT_CHAMELIUM_CRC_WORDS - i - 1,
+					  IGT_CHAMELIUM_CRC_WORDS);
+}
+
+static uint32_t *random_frame(size_t count)
+{
+	uint32_t seed = 0x1234;
+	uint32_t *pixels;
+
+	pixels = malloc(count * sizeof(*pixels));
+	igt_assert(pixels);
+
+	for (size_t i = 0; i < count; i++)
+		pixels[i] = hars_petruska_f54_1_random(&seed);
+
+	return pixels;
+}
+
+static void assert_crc_eq(const uint32_t *a, const uint32_t *b)
+{
+	for (int i = 0; i < IGT_CHAMELIUM_CRC_WORDS; i++)
+		igt_assert_eq_u32(a[i], b[i]);
+}
+
+static void test_impl(const struct igt_chamelium_crc_impl *impl)
+{
+	uint32_t *pixels = random_frame(64 * 64);
+	uint32_t crc[IGT_CHAMELIUM_CRC_WORDS];
+	uint32_t ref[IGT_CHAMELIUM_CRC_WORDS];
+
+	igt_require(impl->supported());
+
+	/* Every tail length, from every alignment of the start */
+	for (int off = 0; off < 8; off++) {
+		for (int w = 1; w <= 64; w++) {
+			for (int h = 1; h <= 3; h++) {
+				reference_crc(pixels + off, w, h, ref);
+				impl->crc(pixels + off, w * h, crc);
+				assert_crc_eq(crc, ref);
+			}
+		}
+	}
+
+	/* Saturated pixels, the largest terms of the sums */
+	memset(pixels, 0xff, 64 * 64 * sizeof(*pixels));
+	reference_crc(pixels, 64, 64, ref);
+	impl->crc(pixels, 64 * 64, crc);
+	assert_crc_eq(crc, ref);
+
+	free(pixels);
+}
+
+static void test_frame(int width, int height)
+{
+	size_t count = (size_t)width * height;
+	uint32_t *pixels = random_frame(count);
+	uint32_t crc[IGT_CHAMELIUM_CRC_WORDS];
+	uint32_t ref[IGT_CHAMELIUM_CRC_WORDS];
+
+	reference_crc(pixels, width, height, ref);
+
+	igt_chamelium_xrgb_crc(pixels, count, crc);
+	assert_crc_eq(crc, ref);
+
+	/* At 8k the weighted sums wrap, and must still recombine exactly */
+	igt_chamelium_xrgb_crc_parallel(pixels, count, crc);
+	assert_crc_eq(crc, ref);
+
+	/* A run boundary not on a group of 4 pixels */
+	igt_chamelium_xrgb_crc_parallel(pixels, count - 3, crc);
+	reference_crc(pixels, count - 3, 1, ref);
+	assert_crc_eq(crc, ref);
+
+	free(pixels);
+}
+
+igt_main
+{
+	const struct igt_chamelium_crc_impl *impl;
+
+	igt_subtest_with_dynamic("implementations") {
+		for (impl = igt_chamelium_crc_impls; impl->name; impl++) {
+			igt_dynamic(impl->name)
+				test_impl(impl);
+		}
+	}
+
+	igt_subtest("1080p")
+		test_frame(1920, 1080);
+
+	igt_subtest("8k")
+		test_frame(7680, 4320);
+}
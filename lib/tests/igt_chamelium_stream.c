@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "igt_chamelium_stream.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "chamelium_stream_server.h"
+
+IGT_TEST_DESCRIPTION("Receive frames and CRCs from a stand-in Chamelium stream server");
+
+#define WIDTH 640
+#define HEIGHT 480
+#define FRAMES 3
+
+static unsigned char *frames[FRAMES];
+static igt_crc_t crcs[FRAMES];
+
+static void setup(void)
+{
+	uint32_t seed = 0x1234;
+
+	for (int i = 0; i < FRAMES; i++) {
+		frames[i] = malloc(WIDTH * HEIGHT * 3);
+		igt_assert(frames[i]);
+
+		for (int j = 0; j < WIDTH * HEIGHT * 3; j++)
+			frames[i][j] = hars_petruska_f54_1_random(&seed);
+
+		crcs[i].n_words = 4;
+		for (int j = 0; j < crcs[i].n_words; j++)
+			crcs[i].crc[j] = hars_petruska_f54_1_random(&seed) & 0xffff;
+	}
+}
+
+static void test_captured_frames(struct chamelium_stream *client)
+{
+	unsigned char *buf = NULL, *first = NULL;
+	size_t size = 0;
+	int w, h;
+
+	for (int i = 0; i < FRAMES; i++) {
+		igt_assert(chamelium_stream_read_captured_frame(client, i,
+								&buf, &size,
+								&w, &h));
+		igt_assert_eq(w, WIDTH);
+		igt_assert_eq(h, HEIGHT);
+		igt_assert(!memcmp(buf, frames[i], WIDTH * HEIGHT * 3));
+
+		/* The buffer is received into again, not reallocated */
+		if (!i)
+			first = buf;
+		igt_assert(buf == first);
+	}
+
+	free(buf);
+}
+
+static void test_dump_pixels(struct chamelium_stream *client)
+{
+	unsigned char *buf = NULL;
+	size_t size = 0;
+	int w, h;
+
+	igt_assert(chamelium_stream_dump_pixels(client, 1, 0, 0, 0, 0,
+						&buf, &size, &w, &h));
+	igt_assert_eq(w, WIDTH);
+	igt_assert_eq(h, HEIGHT);
+	igt_assert(!memcmp(buf, frames[0], WIDTH * HEIGHT * 3));
+
+	igt_assert(chamelium_stream_dump_pixels(client, 1, 100, 50, 33, 17,
+						&buf, &size, &w, &h));
+	igt_assert_eq(w, 33);
+	igt_assert_eq(h, 17);
+	for (int y = 0; y < h; y++)
+		igt_assert(!memcmp(buf + y * w * 3,
+				   frames[0] + ((50 + y) * WIDTH + 100) * 3,
+				   w * 3));
+
+	free(buf);
+}
+
+static void test_captured_crcs(struct chamelium_stream *client)
+{
+	igt_crc_t *received;
+	int count;
+
+	received = chamelium_stream_read_captured_crcs(client, &count);
+	igt_assert(received);
+	igt_assert_eq(count, FRAMES);
+
+	for (int i = 0; i < FRAMES; i++) {
+		igt_assert_eq(received[i].frame, i);
+		igt_assert_eq(received[i].n_words, crcs[i].n_words);
+		for (int j = 0; j < crcs[i].n_words; j++)
+			igt_assert_eq_u32(received[i].crc[j], crcs[i].crc[j]);
+	}
+
+	free(received);
+}
+
+static void test_errors(struct chamelium_stream *client)
+{
+	unsigned char *buf = NULL;
+	size_t size = 0;
+	int w, h;
+
+	igt_assert(!chamelium_stream_read_captured_frame(client, FRAMES,
+							 &buf, &size,
+							 &w, &h));
+	igt_assert(!chamelium_stream_dump_pixels(client, 1, WIDTH - 1, 0, 2, 1,
+						 &buf, &size, &w, &h));
+
+	/* The connection is still in sync after an error */
+	igt_assert(chamelium_stream_read_captured_frame(client, FRAMES - 1,
+							&buf, &size,
+							&w, &h));
+	igt_assert(!memcmp(buf, frames[FRAMES - 1], WIDTH * HEIGHT * 3));
+
+	free(buf);
+}
+
+/*
+ * A server answering the version request, then a frame request with a body
+ * not matching the frame size it announces, then a frame request properly.
+ * The wire values are those of the streaming protocol.
+ */
+#define MSG_GET_VERSION 1
+#define MSG_READ_CAPTURED_FRAME 9
+#define MSG_RESPONSE (1 << 8)
+
+static bool bad_server_respond(int fd, uint16_t type, const void *body,
+			       size_t len)
+{
+	uint16_t hdr[4];
+
+	hdr[0] = htons(MSG_RESPONSE | type);
+	hdr[1] = 0;
+	*(uint32_t *)&hdr[2] = htonl(len);
+
+	return send(fd, hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+	       send(fd, body, len, 0) == len;
+}
+
+static bool bad_server_request(int fd)
+{
+	uint32_t hdr[2], body[5];
+	size_t len;
+
+	if (recv(fd, hdr, sizeof(hdr), MSG_WAITALL) != sizeof(hdr))
+		return false;
+
+	len = ntohl(hdr[1]);
+
+	return len <= sizeof(body) &&
+	       (!len || recv(fd, body, len, MSG_WAITALL) == len);
+}
+
+static void *bad_server(void *data)
+{
+	static const uint8_t version[2] = { 1, 1 };
+	uint8_t frame[4 + 5 * 5 * 3];
+	int fd = accept(*(int *)data, NULL, NULL);
+
+	if (fd < 0)
+		return NULL;
+
+	memcpy(frame + 4, frames[0], sizeof(frame) - 4);
+	*(uint16_t *)&frame[0] = htons(4);
+	*(uint16_t *)&frame[2] = htons(4);
+
+	if (bad_server_request(fd) &&
+	    bad_server_respond(fd, MSG_GET_VERSION, version, sizeof(version)) &&
+	    bad_server_request(fd) &&
+	    bad_server_respond(fd, MSG_READ_CAPTURED_FRAME, frame, sizeof(frame)) &&
+	    bad_server_request(fd))
+		bad_server_respond(fd, MSG_READ_CAPTURED_FRAME, frame,
+				   4 + 4 * 4 * 3);
+
+	close(fd);
+
+	return NULL;
+}
+
+static void test_invalid_frame(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	socklen_t addrlen = sizeof(addr);
+	struct chamelium_stream *client;
+	unsigned char *buf = NULL;
+	size_t size = 0;
+	pthread_t thread;
+	int fd, w, h;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	igt_assert(fd >= 0);
+	igt_assert(!bind(fd, (struct sockaddr *)&addr, sizeof(addr)));
+	igt_assert(!listen(fd, 1));
+	igt_assert(!getsockname(fd, (struct sockaddr *)&addr, &addrlen));
+	igt_assert(!pthread_create(&thread, NULL, bad_server, &fd));
+
+	client = chamelium_stream_init_host("127.0.0.1", ntohs(addr.sin_port));
+	igt_assert(client);
+
+	igt_assert(!chamelium_stream_read_captured_frame(client, 0, &buf, &size,
+							 &w, &h));
+
+	/* The body of the invalid frame was skipped */
+	igt_assert(chamelium_stream_read_captured_frame(client, 0, &buf, &size,
+							&w, &h));
+	igt_assert_eq(w, 4);
+	igt_assert_eq(h, 4);
+	igt_assert(!memcmp(buf, frames[0], 4 * 4 * 3));
+
+	chamelium_stream_deinit(client);
+	pthread_join(thread, NULL);
+	close(fd);
+	free(buf);
+}
+
+/* Stopping the server doesn't wait for its client to disconnect */
+static void test_destroy_connected(void)
+{
+	struct chamelium_stream_server *server;
+	struct chamelium_stream *client;
+
+	server = chamelium_stream_server_create(WIDTH, HEIGHT, frames,
+						crcs, FRAMES);
+	igt_assert(server);
+
+	client = chamelium_stream_init_host("127.0.0.1",
+					    chamelium_stream_server_port(server));
+	igt_assert(client);
+
+	chamelium_stream_server_destroy(server);
+	chamelium_stream_deinit(client);
+}
+
+igt_main
+{
+	struct chamelium_stream_server *server;
+	struct chamelium_stream *client;
+
+	igt_fixture {
+		setup();
+
+		server = chamelium_stream_server_create(WIDTH, HEIGHT, frames,
+							crcs, FRAMES);
+		igt_assert(server);
+
+		client = chamelium_stream_init_host("127.0.0.1",
+						    chamelium_stream_server_port(server));
+		igt_assert(client);
+		igt_assert(chamelium_stream_supports_capture(client));
+	}
+
+	igt_subtest("captured-frames")
+		test_captured_frames(client);
+
+	igt_subtest("dump-pixels")
+		test_dump_pixels(client);
+
+	igt_subtest("captured-crcs")
+		test_captured_crcs(client);
+
+	igt_subtest("errors")
+		test_errors(client);
+
+	igt_subtest("invalid-frame")
+		test_invalid_frame();
+
+	igt_subtest("destroy-connected")
+		test_destroy_connected();
+
+	igt_fixture {
+		chamelium_stream_deinit(client);
+		chamelium_stream_server_destroy(server);
+
+		for (int i = 0; i < FRAMES; i++)
+			free(frames[i]);
+	}
+}
@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_codec.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "igt_x86.h"
+
+IGT_TEST_DESCRIPTION("Check the ascii85 and base64 codecs against each other");
+
+enum pattern {
+	RANDOM,
+	SMALL,
+	SPARSE,
+	ZEROES,
+};
+
+#define for_each_impl(impl, table) \
+	for (impl = table; impl->name; impl++) \
+		for_if((igt_x86_features() & impl->features) == impl->features)
+
+static void fill(uint32_t *buf, size_t count, enum pattern pattern,
+		 uint32_t *seed)
+{
+	for (size_t i = 0; i < count; i++) {
+		switch (pattern) {
+		case RANDOM:
+			buf[i] = hars_petruska_f54_1_random(seed);
+			break;
+		case SMALL:
+			buf[i] = hars_petruska_f54_1_random(seed) % 7225;
+			break;
+		case SPARSE:
+			buf[i] = hars_petruska_f54_1_random(seed) % 3 ?
+				0 : hars_petruska_f54_1_random(seed);
+			break;
+		case ZEROES:
+			buf[i] = 0;
+			break;
+		}
+	}
+}
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static void test_ascii85_known(void)
+{
+	static const struct {
+		uint32_t v;
+		const char *s;
+	} known[] = {
+		{ 0, "z" },
+		{ 1, "!!!!\"" },
+		{ 84, "!!!!u" },
+		{ 85, "!!!\"!" },
+		{ 0x4d616e20, "9jqo^" },
+		{ 0xffffffff, "s8W-!" },
+	};
+	const char *in, *text = "z!!!!\"s8W-!\n9jqo^";
+	uint32_t out[8];
+	char buf[8];
+
+	for (int i = 0; i < ARRAY_SIZE(known); i++) {
+		size_t len = igt_ascii85_encode(&known[i].v, 1, buf);
+
+		igt_assert_eq(len, strlen(known[i].s));
+		igt_assert(!memcmp(buf, known[i].s, len));
+
+		in = known[i].s;
+		igt_assert_eq(igt_ascii85_decode(&in, in + len, out, 1), 1);
+		igt_assert_eq_u32(out[0], known[i].v);
+		igt_assert(in == known[i].s + len);
+	}
+
+	/* Decoding stops at the end of the line, and says where */
+	in = text;
+	igt_assert_eq(igt_ascii85_length(text, strlen(text)), 3);
+	igt_assert_eq(igt_ascii85_decode(&in, text + strlen(text),
+					 out, ARRAY_SIZE(out)), 3);
+	igt_assert_eq_u32(out[0], 0);
+	igt_assert_eq_u32(out[1], 1);
+	igt_assert_eq_u32(out[2], 0xffffffff);
+	igt_assert(*in == '\n');
+
+	/* A truncated group is left undecoded */
+	in = text;
+	igt_assert_eq(igt_ascii85_length(text, 9), 2);
+	igt_assert_eq(igt_ascii85_decode(&in, text + 9, out, 8), 2);
+	igt_assert(in == text + 6);
+}
+
+static void test_ascii85_roundtrip(const struct igt_ascii85_impl *impl)
+{
+	const size_t max = 1 << 16;
+	uint32_t *buf = malloc(max * sizeof(*buf));
+	uint32_t *out = malloc((max + 1) * sizeof(*out));
+	char *text = malloc(igt_ascii85_encode_bound(max) + 1);
+	char *ref = malloc(igt_ascii85_encode_bound(max));
+	uint32_t seed = 0x1234;
+	enum pattern pattern;
+
+	igt_assert(buf && out && text && ref);
+
+	for (pattern = RANDOM; pattern <= ZEROES; pattern++) {
+		for (size_t count = 0; count <= max;
+		     count = count < 100 ? count + 1 : count * 4) {
+			size_t len, chunk;
+			const char *in;
+
+			fill(buf, count, pattern, &seed);
+
+			len = impl->encode(buf, count, text);
+			igt_assert_eq(len, igt_ascii85_impls[0].encode(buf, count, ref));
+			igt_assert(!memcmp(text, ref, len));
+			igt_assert_eq(igt_ascii85_length(text, len), count);
+
+			/* As in an error state, followed by a newline */
+			text[len] = '\n';
+			in = text;
+			igt_assert_eq(impl->decode(&in, text + len + 1,
+						   out, count + 1), count);
+			igt_assert(in == text + len);
+			igt_assert(!memcmp(buf, out, count * sizeof(*buf)));
+
+			/* Piecewise, through buffers of all kinds of sizes */
+			for (chunk = 1; chunk < 100; chunk = chunk * 3 + 1) {
+				size_t n = 0, ret;
+
+				in = text;
+				do {
+					ret = impl->decode(&in, text + len,
+							   out + n, min(chunk, count - n));
+					n += ret;
+				} while (ret);
+				igt_assert_eq(n, count);
+				igt_assert(in == text + len);
+				igt_assert(!memcmp(buf, out, count * sizeof(*buf)));
+			}
+		}
+	}
+
+	free(ref);
+	free(text);
+	free(out);
+	free(buf);
+}
+
+static void test_ascii85_invalid(const struct igt_ascii85_impl *impl)
+{
+	static const char chars[] = "!uvyz{~ \n\0\x80\xff";
+	uint32_t buf[256], out[256], ref[256];
+	char text[5 * 256];
+	uint32_t seed = 0x1234;
+
+	fill(buf, ARRAY_SIZE(buf), SPARSE, &seed);
+
+	for (int i = 0; i < 2000; i++) {
+		size_t len = igt_ascii85_encode(buf, ARRAY_SIZE(buf), text);
+		size_t pos = hars_petruska_f54_1_random(&seed) % len;
+		const char *in, *ref_in;
+		size_t n, ref_n;
+
+		text[pos] = chars[hars_petruska_f54_1_random(&seed) % (sizeof(chars) - 1)];
+
+		memset(out, 0xa5, sizeof(out));
+		in = ref_in = text;
+		n = impl->decode(&in, text + len, out, ARRAY_SIZE(out));
+		ref_n = igt_ascii85_impls[0].decode(&ref_in, text + len,
+						     ref, ARRAY_SIZE(ref));
+
+		igt_assert_eq(n, ref_n);
+		igt_assert(in == ref_in);
+		igt_assert(!memcmp(out, ref, n * sizeof(*out)));
+		igt_assert_eq(igt_ascii85_length(text, len), n);
+
+		/* Nothing is written past the decoded dwords */
+		for (size_t j = n; j < ARRAY_SIZE(out); j++)
+			igt_assert_eq_u32(out[j], 0xa5a5a5a5);
+	}
+}
+
+static void test_base64_known(void)
+{
+	static const char * const known[][2] = {
+		{ "", "" },
+		{ "f", "Zg==" },
+		{ "fo", "Zm8=" },
+		{ "foo", "Zm9v" },
+		{ "foob", "Zm9vYg==" },
+		{ "fooba", "Zm9vYmE=" },
+		{ "foobar", "Zm9vYmFy" },
+	};
+	static const char * const invalid[] = {
+		"Zg=", "Zg", "Z===", "Zg==Zg==", "Zm9 v", "Zm9v\n", "Zm=v",
+	};
+	char buf[16];
+
+	for (int i = 0; i < ARRAY_SIZE(known); i++) {
+		size_t len = strlen(known[i][0]);
+
+		igt_assert_eq(igt_base64_encode_length(len), strlen(known[i][1]));
+		igt_assert_eq(igt_base64_encode(known[i][0], len, buf),
+			      strlen(known[i][1]));
+		igt_assert(!memcmp(buf, known[i][1], strlen(known[i][1])));
+
+		igt_assert_eq(igt_base64_decode(known[i][1], strlen(known[i][1]),
+						buf), len);
+		igt_assert(!memcmp(buf, known[i][0], len));
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(invalid); i++)
+		igt_assert_eq(igt_base64_decode(invalid[i], strlen(invalid[i]),
+						buf), -1);
+}
+
+static void test_base64_roundtrip(const struct igt_base64_impl *impl)
+{
+	const size_t max = 1 << 18;
+	uint8_t *buf = malloc(max);
+	uint8_t *out = malloc(max);
+	char *text = malloc(igt_base64_encode_length(max));
+	char *ref = malloc(igt_base64_encode_length(max));
+	uint32_t seed = 0x1234;
+
+	igt_assert(buf && out && text && ref);
+
+	for (size_t i = 0; i < max; i++)
+		buf[i] = hars_petruska_f54_1_random(&seed);
+
+	for (size_t len = 0; len <= max; len = len < 300 ? len + 1 : len * 4) {
+		size_t n = impl->encode(buf, len, text);
+
+		igt_assert_eq(n, igt_base64_encode_length(len));
+		igt_assert_eq(igt_base64_impls[0].encode(buf, len, ref), n);
+		igt_assert(!memcmp(text, ref, n));
+
+		igt_assert_eq(impl->decode(text, n, out), len);
+		igt_assert(!memcmp(buf, out, len));
+	}
+
+	free(ref);
+	free(text);
+	free(out);
+	free(buf);
+}
+
+static void test_base64_invalid(const struct igt_base64_impl *impl)
+{
+	uint8_t buf[192], out[192], ref[192];
+	char text[256];
+	uint32_t seed = 0x1234;
+
+	for (int i = 0; i < sizeof(buf); i++)
+		buf[i] = hars_petruska_f54_1_random(&seed);
+	igt_base64_encode(buf, sizeof(buf), text);
+
+	/* Every byte value in every position of the first SIMD blocks */
+	for (int pos = 0; pos < 80; pos++) {
+		for (int c = 0; c < 256; c++) {
+			char saved = text[pos];
+			ssize_t n, ref_n;
+
+			text[pos] = c;
+			n = impl->decode(text, sizeof(text), out);
+			ref_n = igt_base64_impls[0].decode(text, sizeof(text), ref);
+			text[pos] = saved;
+
+			igt_assert_eq(n, ref_n);
+			igt_assert(n < 0 || !memcmp(out, ref, n));
+		}
+	}
+}
+
+static void test_throughput(void)
+{
+	const size_t count = 4 << 20;
+	const struct igt_ascii85_impl *a85;
+	const struct igt_base64_impl *b64;
+	uint32_t *buf = malloc(count * sizeof(*buf));
+	uint32_t *out = malloc(count * sizeof(*out));
+	char *text = malloc(igt_ascii85_encode_bound(count));
+	struct timespec start, end;
+	uint32_t seed = 0x1234;
+	double enc, dec;
+	size_t len;
+
+	igt_assert(buf && out && text);
+
+	/* Fault everything in up front, not on the first implementation */
+	memset(out, 0, count * sizeof(*out));
+	memset(text, 0, igt_ascii85_encode_bound(count));
+
+	/* As deflated, which is how the error state captures most buffers */
+	fill(buf, count, RANDOM, &seed);
+
+	for_each_impl(a85, igt_ascii85_impls) {
+		const char *in;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		len = a85->encode(buf, count, text);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		enc = elapsed(&start, &end);
+
+		in = text;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		igt_assert_eq(a85->decode(&in, text + len, out, count), count);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		dec = elapsed(&start, &end);
+
+		igt_info("ascii85 %-6s: encode %7.1f MiB/s, decode %7.1f MiB/s of text\n",
+			 a85->name, len / enc / 1048576., len / dec / 1048576.);
+	}
+
+	for_each_impl(b64, igt_base64_impls) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		len = b64->encode(buf, 3 * count, text);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		enc = elapsed(&start, &end);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		igt_assert_eq(b64->decode(text, len, out), 3 * count);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		dec = elapsed(&start, &end);
+
+		igt_info("base64  %-6s: encode %7.1f MiB/s, decode %7.1f MiB/s of text\n",
+			 b64->name, len / enc / 1048576., len / dec / 1048576.);
+	}
+
+	free(text);
+	free(out);
+	free(buf);
+}
+
+igt_main
+{
+	const struct igt_ascii85_impl *a85;
+	const struct igt_base64_impl *b64;
+
+	igt_subtest("ascii85-known")
+		test_ascii85_known();
+
+	igt_subtest_with_dynamic("ascii85-roundtrip") {
+		for_each_impl(a85, igt_ascii85_impls)
+			igt_dynamic(a85->name)
+				test_ascii85_roundtrip(a85);
+	}
+
+	igt_subtest_with_dynamic("ascii85-invalid") {
+		for_each_impl(a85, igt_ascii85_impls)
+			igt_dynamic(a85->name)
+				test_ascii85_invalid(a85);
+	}
+
+	igt_subtest("base64-known")
+		test_base64_known();
+
+	igt_subtest_with_dynamic("base64-roundtrip") {
+		for_each_impl(b64, igt_base64_impls)
+			igt_dynamic(b64->name)
+				test_base64_roundtrip(b64);
+	}
+
+	igt_subtest_with_dynamic("base64-invalid") {
+		for_each_impl(b64, igt_base64_impls)
+			igt_dynamic(b64->name)
+				test_base64_invalid(b64);
+	}
+
+	igt_subtest("throughput")
+		test_throughput();
+}
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <zlib.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_crc.h"
+#include "igt_rand.h"
+
+IGT_TEST_DESCRIPTION("Check the crc32 implementations against each other");
+
+#define LARGE_SIZE (64 << 20)
+
+static uint32_t reference_crc32(const void *buf, size_t size)
+{
+	const uint8_t *p = buf;
+	uint32_t crc = ~0U;
+
+	while (size--)
+		crc = igt_crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+	return crc ^ ~0U;
+}
+
+static uint8_t *random_buffer(size_t size)
+{
+	uint32_t seed = 0x1234;
+	uint8_t *buf;
+	size_t i;
+
+	buf = malloc(size);
+	igt_assert(buf);
+
+	for (i = 0; i < size; i++)
+		buf[i] = hars_petruska_f54_1_random(&seed);
+
+	return buf;
+}
+
+static void test_check_value(void)
+{
+	const char *check = "123456789";
+
+	/* Standard crc32 check value */
+	igt_assert_eq_u32(igt_cpu_crc32(check, 9), 0xcbf43926);
+	igt_assert_eq_u32(igt_cpu_crc32(check, 0), 0);
+	igt_assert_eq_u32(reference_crc32(check, 9), 0xcbf43926);
+}
+
+static void test_impl(const struct igt_crc32_impl *impl)
+{
+	uint8_t *buf = random_buffer(4096);
+	size_t len, off;
+	uint32_t crc;
+
+	igt_require(impl->supported());
+
+	/* Cover the unaligned heads and the tails of every variant */
+	for (off = 0; off < 64; off++) {
+		for (len = 0; len < 1024; len++)
+			igt_assert_eq_u32(impl->update(0, buf + off, len),
+					  reference_crc32(buf + off, len));
+	}
+
+	/* Running crc over several updates */
+	crc = 0;
+	for (off = 0; off < 4096; off += len) {
+		len = min(4096 - off, 17 + off % 253);
+		crc = impl->update(crc, buf + off, len);
+	}
+	igt_assert_eq_u32(crc, reference_crc32(buf, 4096));
+
+	free(buf);
+}
+
+static void test_large(void)
+{
+	uint8_t *buf = random_buffer(LARGE_SIZE);
+	uint32_t expected = reference_crc32(buf, LARGE_SIZE);
+	size_t size;
+
+	igt_assert_eq_u32(igt_cpu_crc32(buf, LARGE_SIZE), expected);
+	igt_assert_eq_u32(crc32(0, buf, LARGE_SIZE), expected);
+
+	for (size = LARGE_SIZE; size > LARGE_SIZE - 256; size -= 61)
+		igt_assert_eq_u32(igt_cpu_crc32_parallel(buf, size),
+				  reference_crc32(buf, size));
+
+	free(buf);
+}
+
+igt_main
+{
+	const struct igt_crc32_impl *impl;
+
+	igt_subtest("check-value")
+		test_check_value();
+
+	igt_subtest_with_dynamic("implementations") {
+		for (impl = igt_crc32_impls; impl->name; impl++) {
+			igt_dynamic(impl->name)
+				test_impl(impl);
+		}
+	}
+
+	igt_subtest("large-parallel")
+		test_large();
+}
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_device_scan.h"
+
+IGT_TEST_DESCRIPTION("Check devices read from the scan cache against udev");
+
+static char dir[] = "/tmp/igt_device_scan.XXXXXX";
+static char path[PATH_MAX];
+
+/*
+ * What lsgpu prints, as a string. Not the details, sysattrs change from one
+ * read to the next.
+ */
+static char *print_devices(void)
+{
+	const struct igt_devices_print_format simple = {
+		.type = IGT_PRINT_SIMPLE,
+	};
+	const struct igt_devices_print_format user = {
+		.type = IGT_PRINT_USER,
+		.option = IGT_PRINT_PCI,
+		.codename = true,
+	};
+	char *buf;
+	FILE *f;
+	int saved;
+	long len;
+
+	f = tmpfile();
+	igt_assert(f);
+
+	fflush(stdout);
+	saved = dup(STDOUT_FILENO);
+	igt_assert(saved >= 0);
+	igt_assert(dup2(fileno(f), STDOUT_FILENO) >= 0);
+
+	igt_devices_print(&simple);
+	igt_devices_print(&user);
+	fflush(stdout);
+
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+
+	len = ftell(f);
+	igt_assert(len >= 0);
+	buf = calloc(1, len + 1);
+	igt_assert(buf);
+	rewind(f);
+	igt_assert_eq(fread(buf, 1, len, f), len);
+	fclose(f);
+
+	return buf;
+}
+
+static char *scan(bool cached)
+{
+	if (cached)
+		setenv("IGT_DEVICE_SCAN_CACHE", path, 1);
+	else
+		unsetenv("IGT_DEVICE_SCAN_CACHE");
+
+	igt_devices_free();
+	igt_devices_scan(false);
+
+	return print_devices();
+}
+
+static void test_roundtrip(void)
+{
+	char *udev, *written, *read;
+	struct stat st;
+
+	unlink(path);
+
+	udev = scan(false);
+	igt_assert(stat(path, &st) && errno == ENOENT);
+
+	written = scan(true);
+	igt_assert_eq(stat(path, &st), 0);
+	read = scan(true);
+
+	igt_assert_f(!strcmp(udev, written) && !strcmp(udev, read),
+		     "Devices read back from the cache differ:\n%s\nfrom udev:\n%s\n",
+		     read, udev);
+
+	free(udev);
+	free(written);
+	free(read);
+}
+
+static void test_corrupt(void)
+{
+	char *udev, *read;
+	struct stat st;
+	off_t size;
+	int fd;
+
+	udev = scan(false);
+
+	/* Not a cache file, scanned again and replaced */
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	igt_assert(fd >= 0);
+	igt_assert_eq(write(fd, "igt-devs", 8), 8);
+	close(fd);
+
+	read = scan(true);
+	igt_assert(!strcmp(udev, read));
+	free(read);
+
+	igt_assert_eq(stat(path, &st), 0);
+	igt_assert_lt(8, st.st_size);
+	size = st.st_size;
+
+	/* Cut short, scanned again and replaced */
+	igt_assert_eq(truncate(path, st.st_size - 1), 0);
+	read = scan(true);
+	igt_assert(!strcmp(udev, read));
+	free(read);
+
+	igt_assert_eq(stat(path, &st), 0);
+	igt_assert_eq(st.st_size, size);
+
+	free(udev);
+}
+
+igt_main
+{
+	igt_fixture {
+		/* Without it, nothing tells when the cache is stale */
+		igt_require(access("/sys/kernel/uevent_seqnum", R_OK) == 0);
+
+		igt_assert(mkdtemp(dir));
+		snprintf(path, sizeof(path), "%s/devices", dir);
+	}
+
+	igt_subtest("roundtrip")
+		test_roundtrip();
+
+	igt_subtest("corrupt")
+		test_corrupt();
+
+	igt_fixture {
+		igt_devices_free();
+		unlink(path);
+		rmdir(dir);
+	}
+}
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_fb_cache.h"
+#include "igt_rand.h"
+#include "intel_chipset.h"
+
+IGT_TEST_DESCRIPTION("Store and find framebuffer contents in the framebuffer cache");
+
+#define SIZE 4096
+
+static unsigned char *random_data(uint32_t seed)
+{
+	unsigned char *data = malloc(SIZE);
+
+	igt_assert(data);
+	for (int i = 0; i < SIZE; i++)
+		data[i] = hars_petruska_f54_1_random(&seed);
+
+	return data;
+}
+
+static void test_memory(void)
+{
+	unsigned char *a = random_data(1), *b = random_data(2);
+	unsigned char buf[SIZE];
+
+	igt_fb_cache_set_limit(1 << 20);
+
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE));
+
+	igt_fb_cache_insert("a", a, SIZE);
+	igt_fb_cache_insert("b", b, SIZE);
+
+	igt_assert(igt_fb_cache_lookup("a", buf, SIZE));
+	igt_assert(!memcmp(buf, a, SIZE));
+	igt_assert(igt_fb_cache_lookup("b", buf, SIZE));
+	igt_assert(!memcmp(buf, b, SIZE));
+
+	/* Only entries of the requested size are hits */
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE / 2));
+
+	/* Inserting again replaces the entry */
+	igt_fb_cache_insert("a", b, SIZE);
+	igt_assert(igt_fb_cache_lookup("a", buf, SIZE));
+	igt_assert(!memcmp(buf, b, SIZE));
+
+	igt_fb_cache_drop();
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE));
+
+	free(a);
+	free(b);
+}
+
+static void test_eviction(void)
+{
+	unsigned char *a = random_data(1), *b = random_data(2);
+	unsigned char *c = random_data(3);
+	unsigned char buf[SIZE];
+
+	igt_fb_cache_drop();
+	igt_fb_cache_set_limit(2 * SIZE);
+
+	igt_fb_cache_insert("a", a, SIZE);
+	igt_fb_cache_insert("b", b, SIZE);
+
+	/* Using a makes b the least recently used entry */
+	igt_assert(igt_fb_cache_lookup("a", buf, SIZE));
+	igt_fb_cache_insert("c", c, SIZE);
+
+	igt_assert(!igt_fb_cache_lookup("b", buf, SIZE));
+	igt_assert(igt_fb_cache_lookup("a", buf, SIZE));
+	igt_assert(!memcmp(buf, a, SIZE));
+	igt_assert(igt_fb_cache_lookup("c", buf, SIZE));
+	igt_assert(!memcmp(buf, c, SIZE));
+
+	/* Entries larger than the cache aren't kept */
+	igt_fb_cache_set_limit(SIZE / 2);
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE));
+	igt_fb_cache_insert("a", a, SIZE);
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE));
+
+	/* A zero limit disables the cache */
+	igt_fb_cache_set_limit(0);
+	igt_fb_cache_insert("d", a, 16);
+	igt_assert(!igt_fb_cache_lookup("d", buf, 16));
+
+	free(a);
+	free(b);
+	free(c);
+}
+
+static void test_disk(void)
+{
+	char dir[] = "/tmp/igt_fb_cache.XXXXXX";
+	char cmd[64];
+	unsigned char *a = random_data(1), *b = random_data(2);
+	unsigned char buf[SIZE];
+
+	igt_assert(mkdtemp(dir));
+	igt_fb_cache_set_limit(1 << 20);
+	igt_fb_cache_set_dir(dir);
+
+	igt_fb_cache_insert("a", a, SIZE);
+	igt_fb_cache_insert("b", b, SIZE);
+
+	/* Entries come back from the disk once dropped from memory */
+	igt_fb_cache_drop();
+	igt_assert(igt_fb_cache_lookup("a", buf, SIZE));
+	igt_assert(!memcmp(buf, a, SIZE));
+	igt_assert(igt_fb_cache_lookup("b", buf, SIZE));
+	igt_assert(!memcmp(buf, b, SIZE));
+
+	igt_fb_cache_drop();
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE / 2));
+	igt_assert(!igt_fb_cache_lookup("c", buf, SIZE));
+
+	/* Not found on disk once the directory is unset */
+	igt_fb_cache_drop();
+	igt_fb_cache_set_dir(NULL);
+	igt_assert(!igt_fb_cache_lookup("a", buf, SIZE));
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+	igt_assert_eq(system(cmd), 0);
+
+	free(a);
+	free(b);
+}
+
+static void assert_fbs_equal(int fd, struct igt_fb *a, struct igt_fb *b)
+{
+	cairo_surface_t *sa = igt_get_cairo_surface(fd, a);
+	cairo_surface_t *sb = igt_get_cairo_surface(fd, b);
+	int sa_stride = cairo_image_surface_get_stride(sa);
+	int sb_stride = cairo_image_surface_get_stride(sb);
+	uint8_t *da = cairo_image_surface_get_data(sa);
+	uint8_t *db = cairo_image_surface_get_data(sb);
+
+	for (int y = 0; y < a->height; y++)
+		igt_assert_f(!memcmp(da + y * sa_stride, db + y * sb_stride,
+				     a->width * 4),
+			     "Row %d differs\n", y);
+}
+
+static void test_ccs(int fd)
+{
+	uint32_t devid = intel_get_drm_devid(fd);
+	struct igt_fb ccs, copy, linear;
+	uint64_t modifier;
+
+	if (HAS_FLATCCS(devid))
+		modifier = I915_FORMAT_MOD_4_TILED_DG2_RC_CCS;
+	else
+		modifier = I915_FORMAT_MOD_Y_TILED_GEN12_RC_CCS;
+
+	igt_fb_cache_drop();
+	igt_fb_cache_set_dir(NULL);
+	igt_fb_cache_set_limit(64 << 20);
+
+	igt_create_pattern_fb(fd, 256, 256, DRM_FORMAT_XRGB8888, modifier,
+			      &ccs);
+	igt_create_fb(fd, 256, 256, DRM_FORMAT_XRGB8888, modifier, &copy);
+	igt_create_fb(fd, 256, 256, DRM_FORMAT_XRGB8888,
+		      DRM_FORMAT_MOD_LINEAR, &linear);
+
+	/* The aux planes aren't part of the cached contents */
+	igt_assert(igt_fb_load_cached(&linear, "pattern"));
+	igt_assert(igt_fb_load_cached(&copy, "pattern"));
+
+	assert_fbs_equal(fd, &ccs, &linear);
+	assert_fbs_equal(fd, &ccs, &copy);
+
+	igt_remove_fb(fd, &linear);
+	igt_remove_fb(fd, &copy);
+	igt_remove_fb(fd, &ccs);
+	igt_fb_cache_drop();
+}
+
+igt_main
+{
+	igt_subtest("memory")
+		test_memory();
+
+	igt_subtest("eviction")
+		test_eviction();
+
+	igt_subtest("disk")
+		test_disk();
+
+	igt_subtest("ccs") {
+		int fd = drm_open_driver(DRIVER_INTEL);
+
+		igt_require(intel_display_ver(intel_get_drm_devid(fd)) >= 12);
+		test_ccs(fd);
+		close(fd);
+	}
+}
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <float.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_rand.h"
+
+IGT_TEST_DESCRIPTION("Check framebuffer conversions to and from the cairo formats against golden hashes");
+
+#define WIDTH 66
+#define HEIGHT 33
+
+/*
+ * FNV-1a hashes of the visible bytes of a framebuffer filled with random data
+ * and converted to the format cairo draws in, and of random cairo contents
+ * converted back to the framebuffer format. They were computed with the
+ * converters taking their layout from get_yuv_parameters(), which the ones
+ * generated from the format lists must match bit for bit.
+ *
+ * The framebuffers are only held in memory, no device is needed.
+ */
+static const struct {
+	uint32_t format;
+	uint32_t from_fb;
+	uint32_t to_fb;
+} golden[] = {
+	{ DRM_FORMAT_NV12, 0xb4bcf496, 0xcd4f17ee },
+	{ DRM_FORMAT_NV16, 0x95fa608d, 0xde913bd1 },
+	{ DRM_FORMAT_NV21, 0x9cc121bb, 0x2a24f499 },
+	{ DRM_FORMAT_NV61, 0xfe0cd3af, 0xe611ffbb },
+	{ DRM_FORMAT_YUV420, 0xdeb40325, 0x5dda170e },
+	{ DRM_FORMAT_YUV422, 0xee7747e7, 0x07e7ec87 },
+	{ DRM_FORMAT_YVU420, 0x37cfd909, 0x3aa90402 },
+	{ DRM_FORMAT_YVU422, 0x4f76e2d9, 0x8ba604da },
+	{ DRM_FORMAT_YUYV, 0x0dfc9257, 0x30a104a4 },
+	{ DRM_FORMAT_YVYU, 0x71792c63, 0xcf14bbfe },
+	{ DRM_FORMAT_UYVY, 0x52c2e0a7, 0x7d630cc5 },
+	{ DRM_FORMAT_VYUY, 0x0a4b6952, 0xce9891b2 },
+	{ DRM_FORMAT_XYUV8888, 0xf7a893c8, 0xfd674eee },
+	{ DRM_FORMAT_P010, 0xef9fa3d2, 0x4d3f749a },
+	{ DRM_FORMAT_P012, 0x951ddbd1, 0xd74faf38 },
+	{ DRM_FORMAT_P016, 0x621e6172, 0x0646bd4c },
+	{ DRM_FORMAT_Y210, 0x85aee0be, 0xf7923685 },
+	{ DRM_FORMAT_Y212, 0x05638185, 0x845e430f },
+	{ DRM_FORMAT_Y216, 0x0b78f38f, 0x51144355 },
+	{ DRM_FORMAT_XVYU12_16161616, 0x68fa34d3, 0xe51d0c8a },
+	{ DRM_FORMAT_XVYU16161616, 0xc8e3b2cf, 0x4aefb58f },
+	{ DRM_FORMAT_Y412, 0x837a4179, 0x2e0c9c2c },
+	{ DRM_FORMAT_Y416, 0x57002e4f, 0x921ac392 },
+	{ DRM_FORMAT_XRGB16161616F, 0xbb9c1389, 0x46043f58 },
+	{ DRM_FORMAT_ARGB16161616F, 0xde8dc4e3, 0x468be450 },
+	{ DRM_FORMAT_XBGR16161616F, 0xf8fed477, 0xa4316b14 },
+	{ DRM_FORMAT_ABGR16161616F, 0xb4b31095, 0xdacc7197 },
+	{ DRM_FORMAT_XRGB16161616, 0xe8066895, 0x37d4401a },
+	{ DRM_FORMAT_ARGB16161616, 0x4166c424, 0x5652f862 },
+	{ DRM_FORMAT_XBGR16161616, 0x4df5c45c, 0x4294b7f1 },
+	{ DRM_FORMAT_ABGR16161616, 0xf3ab61d1, 0xb7283fbd },
+	{ DRM_FORMAT_Y410, 0x10ab5d3f, 0x02f20f26 },
+	{ DRM_FORMAT_XVYU2101010, 0x25bc22a3, 0x3453d2d4 },
+};
+
+#define FNV1A_OFFSET_BIAS 2166136261u
+#define FNV1A_PRIME 16777619u
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+		hash = (hash ^ data[i]) * FNV1A_PRIME;
+
+	return hash;
+}
+
+static bool is_half_float(uint32_t format)
+{
+	return format == DRM_FORMAT_XRGB16161616F ||
+	       format == DRM_FORMAT_ARGB16161616F ||
+	       format == DRM_FORMAT_XBGR16161616F ||
+	       format == DRM_FORMAT_ABGR16161616F;
+}
+
+static int cairo_cpp(cairo_surface_t *surface)
+{
+	switch (cairo_image_surface_get_format(surface)) {
+	case CAIRO_FORMAT_RGB96F:
+		return 12;
+	case CAIRO_FORMAT_RGBA128F:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+static size_t plane_row_size(const struct igt_fb *fb, int plane)
+{
+	return (size_t)fb->plane_width[plane] * fb->plane_bpp[plane] / 8;
+}
+
+/* Half floats are kept in [0, 1], random bits would make NaNs */
+static void fill_fb(struct igt_fb *fb, uint8_t *map, uint32_t *seed)
+{
+	for (int i = 0; i < fb->num_planes; i++) {
+		for (int y = 0; y < fb->plane_height[i]; y++) {
+			uint8_t *row = map + fb->offsets[i] +
+				       (size_t)y * fb->strides[i];
+			size_t len = plane_row_size(fb, i);
+
+			if (is_half_float(fb->drm_format)) {
+				uint16_t *half = (uint16_t *)row;
+
+				for (size_t j = 0; j < len / 2; j++)
+					half[j] = hars_petruska_f54_1_random(seed) % 0x3c01;
+			} else {
+				for (size_t j = 0; j < len; j++)
+					row[j] = hars_petruska_f54_1_random(seed);
+			}
+		}
+	}
+}
+
+static uint32_t hash_fb(struct igt_fb *fb, const uint8_t *map)
+{
+	uint32_t hash = FNV1A_OFFSET_BIAS;
+
+	for (int i = 0; i < fb->num_planes; i++)
+		for (int y = 0; y < fb->plane_height[i]; y++)
+			hash = fnv1a(hash, map + fb->offsets[i] +
+					   (size_t)y * fb->strides[i],
+				     plane_row_size(fb, i));
+
+	return hash;
+}
+
+/* Float channels are kept in [0, 1], like anything cairo draws */
+static void fill_surface(cairo_surface_t *surface, uint32_t *seed)
+{
+	uint8_t *data = cairo_image_surface_get_data(surface);
+	int stride = cairo_image_surface_get_stride(surface);
+	int cpp = cairo_cpp(surface);
+
+	for (int y = 0; y < HEIGHT; y++) {
+		uint8_t *row = data + y * stride;
+
+		if (cpp > 4) {
+			float *f = (float *)row;
+
+			for (int j = 0; j < WIDTH * cpp / 4; j++)
+				f[j] = (hars_petruska_f54_1_random(seed) & 0xffff) / 65535.0f;
+		} else {
+			for (int j = 0; j < WIDTH * cpp; j++)
+				row[j] = hars_petruska_f54_1_random(seed);
+		}
+	}
+}
+
+static uint32_t hash_surface(cairo_surface_t *surface)
+{
+	const uint8_t *data = cairo_image_surface_get_data(surface);
+	int stride = cairo_image_surface_get_stride(surface);
+	uint32_t hash = FNV1A_OFFSET_BIAS;
+
+	for (int y = 0; y < HEIGHT; y++)
+		hash = fnv1a(hash, data + y * stride, WIDTH * cairo_cpp(surface));
+
+	return hash;
+}
+
+/* Linear, with rows padded past the visible bytes */
+static uint8_t *create_fb(struct igt_fb *fb, uint32_t format)
+{
+	uint8_t *map;
+
+	igt_init_fb(fb, -1, WIDTH, HEIGHT, format, DRM_FORMAT_MOD_LINEAR,
+		    IGT_COLOR_YCBCR_BT709, IGT_COLOR_YCBCR_LIMITED_RANGE);
+
+	for (int i = 0; i < fb->num_planes; i++) {
+		fb->strides[i] = ALIGN(plane_row_size(fb, i) + 64, 64);
+		fb->offsets[i] = fb->size;
+		fb->size += (uint64_t)fb->strides[i] * fb->plane_height[i];
+	}
+
+	map = calloc(1, fb->size);
+	igt_assert(map);
+
+	return map;
+}
+
+static void test_convert(uint32_t format, uint32_t from_fb, uint32_t to_fb)
+{
+	cairo_surface_t *surface;
+	uint32_t seed = format;
+	struct igt_fb fb;
+	uint32_t hash;
+	uint8_t *map;
+
+	map = create_fb(&fb, format);
+	fill_fb(&fb, map, &seed);
+
+	surface = igt_fb_convert_to_cairo(&fb, map);
+	hash = hash_surface(surface);
+	igt_assert_f(hash == from_fb,
+		     "Converted from %s: 0x%08x instead of 0x%08x\n",
+		     igt_format_str(format), hash, from_fb);
+
+	fill_surface(surface, &seed);
+	cairo_surface_mark_dirty(surface);
+	igt_fb_convert_from_cairo(&fb, map, surface);
+
+	hash = hash_fb(&fb, map);
+	igt_assert_f(hash == to_fb,
+		     "Converted to %s: 0x%08x instead of 0x%08x\n",
+		     igt_format_str(format), hash, to_fb);
+
+	free(map);
+}
+
+igt_main
+{
+	igt_subtest_with_dynamic("golden") {
+		/*
+		 * With x87 excess precision, as on i386, float results
+		 * depend on when the compiler spills them to memory.
+		 */
+		igt_require_f(FLT_EVAL_METHOD == 0,
+			      "Floats evaluated in a wider precision\n");
+
+		for (int i = 0; i < ARRAY_SIZE(golden); i++)
+			igt_dynamic_f("%s", igt_format_str(golden[i].format))
+				test_convert(golden[i].format,
+					     golden[i].from_fb, golden[i].to_fb);
+	}
+}
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_lz4.h"
+#include "igt_rand.h"
+
+IGT_TEST_DESCRIPTION("Check the LZ4 block codec");
+
+enum pattern {
+	RANDOM,
+	SMALL_ALPHABET,
+	RUNS,
+	ZEROES,
+};
+
+static void fill(uint8_t *buf, size_t size, enum pattern pattern,
+		 uint32_t *seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		switch (pattern) {
+		case RANDOM:
+			buf[i] = hars_petruska_f54_1_random(seed);
+			break;
+		case SMALL_ALPHABET:
+			buf[i] = 'a' + hars_petruska_f54_1_random(seed) % 3;
+			break;
+		case RUNS:
+			buf[i] = i / 37;
+			break;
+		case ZEROES:
+			buf[i] = 0;
+			break;
+		}
+	}
+}
+
+static void roundtrip(const uint8_t *src, size_t len)
+{
+	size_t bound = igt_lz4_compress_bound(len);
+	uint8_t *z = malloc(bound);
+	uint8_t *out = malloc(len + 1);
+	ssize_t zlen, olen;
+
+	igt_assert(z && out);
+
+	zlen = igt_lz4_compress(src, len, z, bound);
+	igt_assert(zlen > 0 && zlen <= bound);
+
+	olen = igt_lz4_decompress(z, zlen, out, len + 1);
+	igt_assert_eq(olen, len);
+	igt_assert(!memcmp(src, out, len));
+
+	/* Exactly sized destinations are fine, one byte short is not. */
+	igt_assert_eq(igt_lz4_decompress(z, zlen, out, len), len);
+	if (len)
+		igt_assert_eq(igt_lz4_decompress(z, zlen, out, len - 1), -1);
+
+	free(out);
+	free(z);
+}
+
+static void test_roundtrip(void)
+{
+	uint32_t seed = 0x1234;
+	enum pattern pattern;
+	uint8_t *buf;
+	size_t len;
+
+	buf = malloc(1 << 20);
+	igt_assert(buf);
+
+	for (pattern = RANDOM; pattern <= ZEROES; pattern++) {
+		for (len = 0; len < 300; len++) {
+			fill(buf, len, pattern, &seed);
+			roundtrip(buf, len);
+		}
+
+		for (len = 4096; len <= 1 << 20; len *= 4) {
+			fill(buf, len, pattern, &seed);
+			roundtrip(buf, len);
+		}
+	}
+
+	free(buf);
+}
+
+static void test_ratio(void)
+{
+	size_t len = 256 << 10;
+	uint8_t *buf = calloc(1, len);
+	uint8_t *z = malloc(len);
+	uint32_t seed = 0x1234;
+
+	igt_assert(buf && z);
+
+	igt_assert(igt_lz4_compress(buf, len, z, len) < len / 100);
+
+	/* Incompressible data does not fit into its own size. */
+	fill(buf, len, RANDOM, &seed);
+	igt_assert_eq(igt_lz4_compress(buf, len, z, len), -1);
+
+	free(z);
+	free(buf);
+}
+
+static void test_known(void)
+{
+	/* A literal, a match overlapping it and the final literals. */
+	static const uint8_t block[] = {
+		0x13, 'a', 0x01, 0x00,
+		0x50, 'b', 'c', 'd', 'e', 'f',
+	};
+	static const char expected[] = "aaaaaaaabcdef";
+	char out[32];
+
+	igt_assert_eq(igt_lz4_decompress(block, sizeof(block),
+					 out, sizeof(out)),
+		      strlen(expected));
+	igt_assert(!memcmp(out, expected, strlen(expected)));
+}
+
+static void test_malformed(void)
+{
+	static const uint8_t zero_offset[] = {
+		0x13, 'a', 0x00, 0x00, 0x00,
+	};
+	static const uint8_t far_offset[] = {
+		0x13, 'a', 0x02, 0x00, 0x00,
+	};
+	static const uint8_t short_literals[] = {
+		0x50, 'a', 'b',
+	};
+	static const uint8_t truncated_length[] = {
+		0xf0, 0xff,
+	};
+	static const uint8_t truncated_offset[] = {
+		0x13, 'a', 0x01,
+	};
+	uint8_t src[4096], z[8192], out[4096];
+	uint32_t seed = 0x1234;
+	ssize_t zlen, i;
+
+	igt_assert_eq(igt_lz4_decompress(zero_offset, sizeof(zero_offset),
+					 out, sizeof(out)), -1);
+	igt_assert_eq(igt_lz4_decompress(far_offset, sizeof(far_offset),
+					 out, sizeof(out)), -1);
+	igt_assert_eq(igt_lz4_decompress(short_literals,
+					 sizeof(short_literals),
+					 out, sizeof(out)), -1);
+	igt_assert_eq(igt_lz4_decompress(truncated_length,
+					 sizeof(truncated_length),
+					 out, sizeof(out)), -1);
+	igt_assert_eq(igt_lz4_decompress(truncated_offset,
+					 sizeof(truncated_offset),
+					 out, sizeof(out)), -1);
+	igt_assert_eq(igt_lz4_decompress(z, 0, out, sizeof(out)), -1);
+
+	/* Every truncation and corruption must be caught or stay in bounds. */
+	fill(src, sizeof(src), SMALL_ALPHABET, &seed);
+	zlen = igt_lz4_compress(src, sizeof(src), z, sizeof(z));
+	igt_assert(zlen > 0);
+
+	for (i = 1; i < zlen; i++)
+		igt_assert(igt_lz4_decompress(z, i, out, sizeof(out)) <
+			   (ssize_t)sizeof(src));
+
+	for (i = 0; i < zlen; i++) {
+		uint8_t saved = z[i];
+
+		z[i] ^= hars_petruska_f54_1_random(&seed) | 1;
+		igt_assert(igt_lz4_decompress(z, zlen, out, sizeof(out)) <=
+			   (ssize_t)sizeof(out));
+		z[i] = saved;
+	}
+}
+
+igt_main
+{
+	igt_subtest("known-block")
+		test_known();
+
+	igt_subtest("roundtrip")
+		test_roundtrip();
+
+	igt_subtest("ratio")
+		test_ratio();
+
+	igt_subtest("malformed")
+		test_malformed();
+}
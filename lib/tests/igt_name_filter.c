@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_name_filter.h"
+#include "igt_rand.h"
+#include "uwildmat/uwildmat.h"
+
+IGT_TEST_DESCRIPTION("Check name filters against uwildmat() and GRegex");
+
+#define ITERATIONS 20000
+#define NAMES 16
+
+static const char *wildmat_tokens[] = {
+	"a", "b", "A", "-", "*", "?", "[ab]", "[^a]", "\\a", "\\,",
+	",", "!", "ab", "b-a", "",
+};
+
+static const char *regex_tokens[] = {
+	"a", "b", "-", "@", ".", ".*", ".+", "(@.*)?", "a?", "(a|b)",
+	"[ab]", "\\.", "ab", "a-b", "(ab)*", "b*", "(?!.*b)", "\\d",
+};
+
+static void random_name(char *name, uint32_t *seed)
+{
+	const char alphabet[] = "abAB-@.1";
+	int len = hars_petruska_f54_1_random(seed) % 8;
+
+	for (int i = 0; i < len; i++)
+		name[i] = alphabet[hars_petruska_f54_1_random(seed) % (sizeof(alphabet) - 1)];
+	name[len] = '\0';
+}
+
+static void random_pattern(char *pattern, const char **tokens, int count,
+			   uint32_t *seed)
+{
+	int len = hars_petruska_f54_1_random(seed) % 8;
+
+	pattern[0] = '\0';
+	for (int i = 0; i < len; i++)
+		strcat(pattern, tokens[hars_petruska_f54_1_random(seed) % count]);
+}
+
+static void test_wildmat(void)
+{
+	uint32_t seed = 0x1234;
+	char expr[128], name[16];
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		struct igt_name_filter *filter = igt_name_filter_create();
+
+		random_pattern(expr, wildmat_tokens,
+			       ARRAY_SIZE(wildmat_tokens), &seed);
+		igt_name_filter_add_wildmat(filter, expr);
+
+		for (int j = 0; j < NAMES; j++) {
+			random_name(name, &seed);
+			igt_assert_f(igt_name_filter_match(filter, name) ==
+				     uwildmat(name, expr),
+				     "'%s' against '%s'\n", name, expr);
+		}
+
+		igt_name_filter_destroy(filter);
+	}
+}
+
+static void test_regex(void)
+{
+	uint32_t seed = 0x5678;
+	char pattern[4][128], name[16];
+	GRegex *regex[4];
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		struct igt_name_filter *filter = igt_name_filter_create();
+		int count = 1 + hars_petruska_f54_1_random(&seed) % 4;
+
+		for (int k = 0; k < count; k++) {
+			char *p = pattern[k];
+
+			if (hars_petruska_f54_1_random(&seed) & 1)
+				*p++ = '^';
+			random_pattern(p, regex_tokens,
+				       ARRAY_SIZE(regex_tokens), &seed);
+			if (hars_petruska_f54_1_random(&seed) & 1)
+				strcat(p, "$");
+
+			regex[k] = g_regex_new(pattern[k], G_REGEX_OPTIMIZE, 0, NULL);
+			igt_assert(regex[k]);
+			igt_name_filter_add_regex(filter, pattern[k], regex[k]);
+		}
+
+		for (int j = 0; j < NAMES; j++) {
+			bool expected = false;
+
+			random_name(name, &seed);
+			/* Names read from files may keep their newline */
+			if (j & 1)
+				strcat(name, "\n");
+
+			for (int k = 0; k < count; k++)
+				expected |= g_regex_match(regex[k], name, 0, NULL);
+
+			igt_assert_f(igt_name_filter_match(filter, name) == expected,
+				     "'%s' against '%s'...\n", name, pattern[0]);
+		}
+
+		igt_name_filter_destroy(filter);
+		for (int k = 0; k < count; k++)
+			g_regex_unref(regex[k]);
+	}
+}
+
+static void test_last_match(void)
+{
+	struct igt_name_filter *filter = igt_name_filter_create();
+
+	igt_name_filter_add_wildmat(filter, "basic-*,!*-hang,basic-busy-hang");
+
+	igt_assert(igt_name_filter_match(filter, "basic-busy"));
+	igt_assert(!igt_name_filter_match(filter, "basic-idle-hang"));
+	igt_assert(igt_name_filter_match(filter, "basic-busy-hang"));
+	igt_assert(!igt_name_filter_match(filter, "busy"));
+	igt_assert(igt_name_filter_match(filter, "BASIC-busy"));
+
+	igt_name_filter_destroy(filter);
+}
+
+igt_main
+{
+	igt_subtest("wildmat")
+		test_wildmat();
+
+	igt_subtest("regex")
+		test_regex();
+
+	igt_subtest("last-match")
+		test_last_match();
+}
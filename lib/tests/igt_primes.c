@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "igt_core.h"
+#include "igt_primes.h"
+
+IGT_TEST_DESCRIPTION("Check the primes found in the sieve against trial division");
+
+static bool is_prime(unsigned long n)
+{
+	if (n < 2)
+		return false;
+
+	for (unsigned long d = 2; d * d <= n; d++)
+		if (n % d == 0)
+			return false;
+
+	return true;
+}
+
+static unsigned long slow_next_prime(unsigned long x)
+{
+	while (!is_prime(++x))
+		;
+
+	return x;
+}
+
+static void test_next(void)
+{
+	/* Across the table, its end, segments and the end of the sieve */
+	static const unsigned long starts[] = {
+		1, IGT_PRIMES_TABLE_LIMIT - 100, 4 * IGT_PRIMES_TABLE_LIMIT,
+#if ULONG_MAX > 0xffffffff
+		0xfffffff0ul,
+		(unsigned long)IGT_PRIMES_TABLE_LIMIT * IGT_PRIMES_TABLE_LIMIT - 100,
+#endif
+	};
+
+	igt_assert_eq(igt_next_prime_number(0), 1);
+
+	/* Nothing fits above the largest prime */
+	if (sizeof(unsigned long) == 4)
+		igt_assert_eq_u64(igt_next_prime_number(4294967291ul), ULONG_MAX);
+	igt_assert_eq_u64(igt_next_prime_number(ULONG_MAX), ULONG_MAX);
+
+	for (int i = 0; i < ARRAY_SIZE(starts); i++) {
+		unsigned long x = starts[i];
+
+		for (int n = 0; n < 20; n++) {
+			unsigned long p = igt_next_prime_number(x);
+
+			igt_assert_eq_u64(p, slow_next_prime(x));
+			x = p;
+		}
+	}
+}
+
+static void test_iter(void)
+{
+	struct igt_primes_iter *it = malloc(sizeof(*it));
+	unsigned long count = 0, last = 0;
+
+	igt_assert(it);
+
+	/* pi(10^7) */
+	for_each_prime_in_range(p, it, 0, 10000000) {
+		igt_assert_lt_u64(last, p);
+		last = p;
+		count++;
+	}
+	igt_assert_eq_u64(count, 664579);
+
+	for_each_prime_in_range(p, it, 7, 8)
+		igt_assert_eq_u64(p, 7);
+
+	/* Primes in [from, to) */
+	last = 1000000 - 1;
+	for_each_prime_in_range(p, it, 1000000, 1001000) {
+		igt_assert_eq_u64(p, slow_next_prime(last));
+		last = p;
+	}
+	igt_assert_eq_u64(slow_next_prime(last), 1001003);
+
+	free(it);
+}
+
+static void *count_primes(void *data)
+{
+	unsigned long count = 0;
+
+	for (unsigned long p = 2; p < 20000000; p = igt_next_prime_number(p))
+		count++;
+
+	return (void *)count;
+}
+
+static void test_threads(void)
+{
+	pthread_t threads[4];
+	void *count;
+
+	for (int i = 0; i < ARRAY_SIZE(threads); i++)
+		pthread_create(&threads[i], NULL, count_primes, NULL);
+
+	for (int i = 0; i < ARRAY_SIZE(threads); i++) {
+		pthread_join(threads[i], &count);
+		igt_assert_eq_u64((unsigned long)count, 1270607);
+	}
+}
+
+igt_main
+{
+	igt_subtest("next")
+		test_next();
+
+	igt_subtest("iter")
+		test_iter();
+
+	igt_subtest("threads")
+		test_threads();
+}
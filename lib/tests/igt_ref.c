@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "i915_drm.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "igt_ref.h"
+#include "igt_tiling.h"
+#include "intel_batchbuffer.h"
+
+IGT_TEST_DESCRIPTION("Check the CPU reference renderer against per pixel loops");
+
+#define WIDTH 1000
+#define STRIDE 4096
+#define HEIGHT 203
+
+static const struct {
+	const char *name;
+	uint32_t tiling;
+	int swizzle;
+} layouts[] = {
+	{ "linear", I915_TILING_NONE, I915_BIT_6_SWIZZLE_NONE },
+	{ "x", I915_TILING_X, I915_BIT_6_SWIZZLE_NONE },
+	{ "x-swizzled", I915_TILING_X, I915_BIT_6_SWIZZLE_9_10 },
+	{ "y", I915_TILING_Y, I915_BIT_6_SWIZZLE_NONE },
+	{ "4", I915_TILING_4, I915_BIT_6_SWIZZLE_NONE },
+};
+
+#define NUM_LAYOUTS (sizeof(layouts) / sizeof(layouts[0]))
+
+/* Whole tile rows are allocated */
+#define SIZE (STRIDE * 224)
+
+static void surface_init(struct igt_ref_surface *s, int layout, uint32_t seed)
+{
+	uint32_t *ptr = malloc(SIZE);
+
+	igt_assert(ptr);
+	for (int i = 0; i < SIZE / 4; i++)
+		ptr[i] = hars_petruska_f54_1_random(&seed);
+
+	*s = (struct igt_ref_surface) {
+		.ptr = ptr,
+		.stride = STRIDE,
+		.cpp = 4,
+		.width = WIDTH,
+		.height = HEIGHT,
+	};
+
+	if (layouts[layout].tiling != I915_TILING_NONE)
+		s->tiling = igt_tiling_create_intel(layouts[layout].tiling,
+						    layouts[layout].swizzle,
+						    STRIDE);
+}
+
+static void surface_fini(struct igt_ref_surface *s)
+{
+	free(s->ptr);
+	igt_ref_surface_fini(s);
+}
+
+/* One pixel at a time, through the address of each */
+static uint32_t *pixel(const struct igt_ref_surface *s, int x, int y)
+{
+	if (!s->tiling)
+		return (uint32_t *)((char *)s->ptr + y * s->stride) + x;
+
+	return (uint32_t *)((char *)s->ptr +
+			    igt_tiling_offset(s->tiling, x * 4, y));
+}
+
+static void to_linear(const struct igt_ref_surface *s, uint32_t *linear)
+{
+	for (int y = 0; y < HEIGHT; y++)
+		for (int x = 0; x < WIDTH; x++)
+			linear[y * WIDTH + x] = *pixel(s, x, y);
+}
+
+static void check_linear(const struct igt_ref_surface *s,
+			 const uint32_t *linear)
+{
+	for (int y = 0; y < HEIGHT; y++)
+		for (int x = 0; x < WIDTH; x++)
+			igt_assert_f(*pixel(s, x, y) == linear[y * WIDTH + x],
+				     "Expected 0x%08x, found 0x%08x at (%d,%d)\n",
+				     linear[y * WIDTH + x], *pixel(s, x, y),
+				     x, y);
+}
+
+static void test_fill(int layout)
+{
+	uint32_t *linear = malloc(WIDTH * HEIGHT * 4);
+	uint32_t color = 0xc4c4c44c;
+	struct igt_ref_surface s;
+
+	igt_assert(linear);
+	surface_init(&s, layout, 1);
+	to_linear(&s, linear);
+
+	igt_ref_fill(&s, 3, 5, 700, 150, &color);
+	for (int y = 5; y < 155; y++)
+		for (int x = 3; x < 703; x++)
+			linear[y * WIDTH + x] = color;
+	check_linear(&s, linear);
+
+	igt_ref_clear(&s, 0, 100, WIDTH, 1);
+	memset(linear + 100 * WIDTH, 0, WIDTH * 4);
+	check_linear(&s, linear);
+
+	surface_fini(&s);
+	free(linear);
+}
+
+static void test_copy(int src_layout, int dst_layout)
+{
+	uint32_t *linear = malloc(WIDTH * HEIGHT * 4);
+	struct igt_ref_surface src, dst;
+
+	igt_assert(linear);
+	surface_init(&src, src_layout, 1);
+	surface_init(&dst, dst_layout, 2);
+	to_linear(&dst, linear);
+
+	igt_ref_copy(&dst, 301, 70, &src, 17, 3, 699, 133);
+	for (int y = 0; y < 133; y++)
+		for (int x = 0; x < 699; x++)
+			linear[(70 + y) * WIDTH + 301 + x] =
+				*pixel(&src, 17 + x, 3 + y);
+	check_linear(&dst, linear);
+
+	surface_fini(&src);
+	surface_fini(&dst);
+	free(linear);
+}
+
+static void test_compare(int a_layout, int b_layout)
+{
+	struct igt_ref_surface a, b;
+	unsigned int x, y;
+	uint32_t value;
+
+	surface_init(&a, a_layout, 1);
+	surface_init(&b, b_layout, 2);
+
+	igt_ref_copy(&b, 0, 0, &a, 0, 0, WIDTH, HEIGHT);
+	igt_assert(!igt_ref_compare(&a, &b, 0, 0, WIDTH, HEIGHT, &x, &y));
+
+	/* The first difference in row major order is reported */
+	*pixel(&b, 900, 150) ^= 1;
+	*pixel(&b, 10, 190) ^= 1;
+	*pixel(&b, 500, 40) ^= 1;
+	igt_assert(igt_ref_compare(&a, &b, 0, 0, WIDTH, HEIGHT, &x, &y));
+	igt_assert_eq(x, 500);
+	igt_assert_eq(y, 40);
+
+	igt_ref_get_pixel(&b, x, y, &value);
+	igt_assert_eq_u32(value, *pixel(&a, x, y) ^ 1);
+
+	igt_assert(igt_ref_compare(&a, &b, 501, 0, 499, HEIGHT, &x, &y));
+	igt_assert_eq(x, 900);
+	igt_assert_eq(y, 150);
+	igt_assert(!igt_ref_compare(&a, &b, 0, 41, 800, 109, &x, &y));
+
+	value = 0x4c4c4c4c;
+	igt_ref_fill(&a, 0, 0, WIDTH, HEIGHT, &value);
+	igt_assert(!igt_ref_check_fill(&a, 0, 0, WIDTH, HEIGHT, &value,
+				       &x, &y));
+	*pixel(&a, WIDTH - 1, HEIGHT - 1) = 0;
+	igt_assert(igt_ref_check_fill(&a, 0, 0, WIDTH, HEIGHT, &value,
+				      &x, &y));
+	igt_assert_eq(x, WIDTH - 1);
+	igt_assert_eq(y, HEIGHT - 1);
+
+	surface_fini(&a);
+	surface_fini(&b);
+}
+
+igt_main
+{
+	igt_subtest_with_dynamic("fill") {
+		for (int i = 0; i < NUM_LAYOUTS; i++)
+			igt_dynamic(layouts[i].name)
+				test_fill(i);
+	}
+
+	igt_subtest_with_dynamic("copy") {
+		for (int i = 0; i < NUM_LAYOUTS; i++)
+			for (int j = 0; j < NUM_LAYOUTS; j++)
+				igt_dynamic_f("%s-to-%s", layouts[i].name,
+					      layouts[j].name)
+					test_copy(i, j);
+	}
+
+	igt_subtest_with_dynamic("compare") {
+		for (int i = 0; i < NUM_LAYOUTS; i++)
+			for (int j = 0; j < NUM_LAYOUTS; j++)
+				igt_dynamic_f("%s-%s", layouts[i].name,
+					      layouts[j].name)
+					test_compare(i, j);
+	}
+}
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_sysfs.h"
+
+IGT_TEST_DESCRIPTION("Read attributes kept open, in a fake sysfs directory");
+
+static char dir_path[] = "/tmp/igt_sysfs_attr.XXXXXX";
+static int dir = -1;
+
+/* Rewritten in place, as sysfs attributes change under their readers */
+static void set_attr(const char *attr, const char *value)
+{
+	int fd = openat(dir, attr, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	igt_assert(fd >= 0);
+	igt_assert_eq(write(fd, value, strlen(value)), strlen(value));
+	close(fd);
+}
+
+static void test_read(void)
+{
+	char buf[16];
+	unsigned int x;
+	int fd;
+
+	set_attr("freq", "300\n");
+	fd = igt_sysfs_attr_open(dir, "freq");
+	igt_assert_lte(0, fd);
+
+	igt_assert_eq(igt_sysfs_attr_read(fd, buf, sizeof(buf)), 3);
+	igt_assert(!strcmp(buf, "300"));
+	igt_assert_eq(igt_sysfs_attr_get_u32(fd), 300);
+
+	/* Every read starts again from the start of the attribute */
+	set_attr("freq", "1200\n");
+	igt_assert_eq(igt_sysfs_attr_get_u32(fd), 1200);
+	igt_assert_eq(igt_sysfs_attr_get_u64(fd), 1200);
+	igt_assert_eq(igt_sysfs_get_u32(dir, "freq"), 1200);
+
+	/* Cut short to the buffer */
+	igt_assert_eq(igt_sysfs_attr_read(fd, buf, 3), 2);
+	igt_assert(!strcmp(buf, "12"));
+
+	set_attr("freq", "event=0x12\n");
+	igt_assert_eq(igt_sysfs_attr_scanf(fd, "event=%x", &x), 1);
+	igt_assert_eq(x, 0x12);
+	igt_assert_eq(igt_sysfs_attr_get_u32(fd), 0);
+
+	close(fd);
+
+	igt_assert_eq(igt_sysfs_attr_open(dir, "missing"), -ENOENT);
+}
+
+static void test_sample(void)
+{
+	const char *attrs[] = { "act", "cur", "bad", "rc6" };
+	uint64_t values[4];
+	int fds[4];
+
+	set_attr("act", "300\n");
+	set_attr("cur", "350\n");
+	set_attr("bad", "N/A\n");
+	set_attr("rc6", "18446744073709551615\n");
+
+	for (int i = 0; i < 4; i++) {
+		fds[i] = igt_sysfs_attr_open(dir, attrs[i]);
+		igt_assert_lte(0, fds[i]);
+	}
+
+	igt_assert_eq(igt_sysfs_attr_sample(fds, 4, values), 3);
+	igt_assert_eq(values[0], 300);
+	igt_assert_eq(values[1], 350);
+	igt_assert_eq(values[2], 0);
+	igt_assert(values[3] == UINT64_MAX);
+
+	for (int i = 0; i < 4; i++)
+		close(fds[i]);
+}
+
+static void test_wait(void)
+{
+	char buf[16];
+	int fd;
+
+	set_attr("state", "idle\n");
+	fd = igt_sysfs_attr_open(dir, "state");
+	igt_assert_lte(0, fd);
+	igt_assert_eq(igt_sysfs_attr_read(fd, buf, sizeof(buf)), 4);
+
+	igt_assert_eq(igt_sysfs_attr_wait(fd, buf, sizeof(buf), 20),
+		      -ETIMEDOUT);
+	igt_assert(!strcmp(buf, "idle"));
+
+	/* Not notified on tmpfs, found by reading it again */
+	igt_fork(child, 1) {
+		usleep(50 * 1000);
+		set_attr("state", "busy\n");
+	}
+
+	igt_assert_eq(igt_sysfs_attr_wait(fd, buf, sizeof(buf), 5000), 4);
+	igt_assert(!strcmp(buf, "busy"));
+	igt_waitchildren();
+
+	/* Emptied contents aren't mistaken for a timeout */
+	set_attr("state", "\n");
+	igt_assert_eq(igt_sysfs_attr_wait(fd, buf, sizeof(buf), 20), 0);
+	igt_assert(!strcmp(buf, ""));
+
+	close(fd);
+}
+
+igt_main
+{
+	char cmd[64];
+
+	igt_fixture {
+		igt_assert(mkdtemp(dir_path));
+		dir = open(dir_path, O_RDONLY | O_DIRECTORY);
+		igt_assert_lte(0, dir);
+	}
+
+	igt_subtest("read")
+		test_read();
+
+	igt_subtest("sample")
+		test_sample();
+
+	igt_subtest("wait")
+		test_wait();
+
+	igt_fixture {
+		close(dir);
+		snprintf(cmd, sizeof(cmd), "rm -rf %s", dir_path);
+		igt_assert_eq(system(cmd), 0);
+	}
+}
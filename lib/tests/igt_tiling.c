@@ -0,0 +1,376 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "drmtest.h"
+#include "igt_amd.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_rand.h"
+#include "igt_tiling.h"
+#include "intel_batchbuffer.h"
+
+IGT_TEST_DESCRIPTION("Check the tiling tables against per-pixel address computations");
+
+/*
+ * The per-pixel address computations igt_draw, igt_vc4 and igt_amd used,
+ * with the stride and bpp of the framebuffer plane.
+ */
+static uint64_t tile(unsigned int x, unsigned int y,
+		     unsigned int x_tile_size, unsigned int y_tile_size,
+		     uint32_t line_size, bool xmajor)
+{
+	unsigned int tiles_per_line = line_size / x_tile_size;
+	unsigned int x_tile_off = x % x_tile_size;
+	unsigned int y_tile_off = y % y_tile_size;
+	uint64_t tile_n;
+
+	tile_n = (uint64_t)(y / y_tile_size) * tiles_per_line + x / x_tile_size;
+
+	if (xmajor)
+		return tile_n * x_tile_size * y_tile_size +
+			y_tile_off * x_tile_size + x_tile_off;
+	else
+		return tile_n * x_tile_size * y_tile_size +
+			x_tile_off * y_tile_size + y_tile_off;
+}
+
+static uint64_t swizzle_bit(unsigned int bit, uint64_t offset)
+{
+	return (offset & (1ull << bit)) >> (bit - 6);
+}
+
+static uint64_t swizzle_addr(uint64_t addr, int swizzle)
+{
+	switch (swizzle) {
+	case I915_BIT_6_SWIZZLE_9:
+		return addr ^ swizzle_bit(9, addr);
+	case I915_BIT_6_SWIZZLE_9_10:
+		return addr ^ swizzle_bit(9, addr) ^ swizzle_bit(10, addr);
+	case I915_BIT_6_SWIZZLE_9_11:
+		return addr ^ swizzle_bit(9, addr) ^ swizzle_bit(11, addr);
+	case I915_BIT_6_SWIZZLE_9_10_11:
+		return addr ^ swizzle_bit(9, addr) ^ swizzle_bit(10, addr) ^
+			swizzle_bit(11, addr);
+	default:
+		return addr;
+	}
+}
+
+static uint64_t ref_x_tiled(const struct igt_fb *fb, int swizzle,
+			    unsigned int x, unsigned int y)
+{
+	x *= fb->plane_bpp[0] / 8;
+
+	return swizzle_addr(tile(x, y, 512, 8, fb->strides[0], true), swizzle);
+}
+
+static uint64_t ref_y_tiled(const struct igt_fb *fb, int swizzle,
+			    unsigned int x, unsigned int y)
+{
+	uint64_t ow;
+
+	x *= fb->plane_bpp[0] / 8;
+	ow = tile(x / 16, y, 128 / 16, 32, fb->strides[0] / 16, false);
+
+	return swizzle_addr(ow * 16 + x % 16, swizzle);
+}
+
+static uint64_t ref_4_tiled(const struct igt_fb *fb, int swizzle,
+			    unsigned int x, unsigned int y)
+{
+	static const int subtile_map[] = {
+		0,  1,  2,  3,  8,  9, 10, 11,
+		4,  5,  6,  7, 12, 13, 14, 15,
+		16, 17, 18, 19, 24, 25, 26, 27,
+		20, 21, 22, 23, 28, 29, 30, 31,
+		32, 33, 34, 35, 40, 41, 42, 43,
+		36, 37, 38, 39, 44, 45, 46, 47,
+		48, 49, 50, 51, 56, 57, 58, 59,
+		52, 53, 54, 55, 60, 61, 62, 63
+	};
+	unsigned int tile_x, tile_y;
+	uint64_t base;
+
+	x *= fb->plane_bpp[0] / 8;
+	base = (uint64_t)(y / 32) * fb->strides[0] * 32 + 4096 * (x / 128);
+	tile_x = x % 128;
+	tile_y = y % 32;
+
+	return base + subtile_map[tile_y / 4 * 8 + tile_x / 16] * 64 +
+		tile_y % 4 * 16 + tile_x % 16;
+}
+
+static uint64_t ref_vc4_t_tiled(const struct igt_fb *fb, int swizzle,
+				unsigned int x, unsigned int y)
+{
+	static const unsigned int t1k_map_even[] = { 0, 3, 1, 2 };
+	static const unsigned int t1k_map_odd[] = { 2, 1, 3, 0 };
+	unsigned int cpp = fb->plane_bpp[0] / 8;
+	unsigned int t4k_t_w = 4096 / 32 / cpp;
+	unsigned int t1k_t_w = 1024 / 16 / cpp;
+	unsigned int t64_t_w = 64 / 4 / cpp;
+	unsigned int t4k_w = fb->strides[0] / cpp / t4k_t_w;
+	unsigned int t4k_x = x / t4k_t_w, t4k_y = y / 32;
+	unsigned int index = 2 * ((y % 32) / 16) + (x % t4k_t_w) / t1k_t_w;
+	uint64_t offset = (uint64_t)t4k_y * t4k_w * 4096;
+
+	if (t4k_y % 2)
+		offset += (t4k_w - t4k_x - 1) * 4096 +
+			t1k_map_odd[index] * 1024;
+	else
+		offset += t4k_x * 4096 + t1k_map_even[index] * 1024;
+
+	offset += ((y % 16) / 4 * (t1k_t_w / t64_t_w) +
+		   (x % t1k_t_w) / t64_t_w) * 64;
+
+	return offset + ((y % 4) * t64_t_w + x % t64_t_w) * cpp;
+}
+
+static uint64_t ref_sand128(const struct igt_fb *fb, int swizzle,
+			    unsigned int x, unsigned int y)
+{
+	unsigned int column_height = fourcc_mod_broadcom_param(fb->modifier);
+	unsigned int column_width = 128 * fb->plane_width[0] / fb->width;
+
+	return (uint64_t)(x / column_width) * 128 * column_height +
+		(column_width * y + x % column_width) * fb->plane_bpp[0] / 8;
+}
+
+static uint64_t ref_amd_64k_s(const struct igt_fb *fb, int swizzle,
+			      unsigned int x, unsigned int y)
+{
+	return igt_amd_fb_tiled_offset(fb->plane_bpp[0], x, y,
+				       fb->plane_width[0]);
+}
+
+static const struct layout {
+	const char *name;
+	uint64_t modifier;
+	unsigned int bpp;
+	uint32_t stride_align;
+	uint64_t (*offset)(const struct igt_fb *fb, int swizzle,
+			   unsigned int x, unsigned int y);
+} layouts[] = {
+	{ "x-tiled", I915_FORMAT_MOD_X_TILED, 32, 512, ref_x_tiled },
+	{ "y-tiled", I915_FORMAT_MOD_Y_TILED, 32, 128, ref_y_tiled },
+	{ "y-tiled-16bpp", I915_FORMAT_MOD_Y_TILED, 16, 128, ref_y_tiled },
+	{ "4-tiled", I915_FORMAT_MOD_4_TILED, 32, 128, ref_4_tiled },
+	{ "vc4-t-tiled", DRM_FORMAT_MOD_BROADCOM_VC4_T_TILED, 32, 128,
+	  ref_vc4_t_tiled },
+	{ "vc4-t-tiled-16bpp", DRM_FORMAT_MOD_BROADCOM_VC4_T_TILED, 16, 128,
+	  ref_vc4_t_tiled },
+	{ "sand128", DRM_FORMAT_MOD_BROADCOM_SAND128_COL_HEIGHT(96), 8, 1,
+	  ref_sand128 },
+	{ "amd-64k-s", AMD_FMT_MOD |
+	  AMD_FMT_MOD_SET(TILE, AMD_FMT_MOD_TILE_GFX9_64K_S) |
+	  AMD_FMT_MOD_SET(TILE_VERSION, AMD_FMT_MOD_TILE_VER_GFX9), 32, 512,
+	  ref_amd_64k_s },
+	{ }
+};
+
+#define WIDTH 300
+#define HEIGHT 90
+
+static void init_fb(struct igt_fb *fb, const struct layout *l)
+{
+	memset(fb, 0, sizeof(*fb));
+
+	fb->modifier = l->modifier;
+	fb->width = fb->plane_width[0] = WIDTH;
+	fb->height = fb->plane_height[0] = HEIGHT;
+	fb->num_planes = 1;
+	fb->plane_bpp[0] = l->bpp;
+	fb->strides[0] = ALIGN(WIDTH * l->bpp / 8, l->stride_align);
+}
+
+static uint64_t fb_size(const struct igt_fb *fb, const struct layout *l,
+			int swizzle)
+{
+	uint64_t size = 0;
+
+	for (unsigned int y = 0; y < HEIGHT; y++)
+		for (unsigned int x = 0; x < WIDTH; x++)
+			size = max(size, l->offset(fb, swizzle, x, y) +
+				   l->bpp / 8);
+
+	return size;
+}
+
+static uint8_t *random_buffer(size_t size, uint32_t seed)
+{
+	uint8_t *buf = malloc(size);
+
+	igt_assert(buf);
+	for (size_t i = 0; i < size; i++)
+		buf[i] = hars_petruska_f54_1_random(&seed);
+
+	return buf;
+}
+
+static void check_offsets(const struct igt_tiling *t, const struct igt_fb *fb,
+			  const struct layout *l, int swizzle)
+{
+	unsigned int cpp = l->bpp / 8;
+
+	for (unsigned int y = 0; y < HEIGHT; y++)
+		for (unsigned int x = 0; x < WIDTH; x++)
+			igt_assert_f(igt_tiling_offset(t, x * cpp, y) ==
+				     l->offset(fb, swizzle, x, y),
+				     "%s: pixel %u,%u\n", l->name, x, y);
+}
+
+/* Copies a rectangle in and out, checking the pixels land where expected */
+static void check_rect(const struct igt_tiling *t, const struct igt_fb *fb,
+		       const struct layout *l, int swizzle,
+		       unsigned int x0, unsigned int y0,
+		       unsigned int w, unsigned int h)
+{
+	uint64_t size = fb_size(fb, l, swizzle);
+	unsigned int cpp = l->bpp / 8;
+	uint32_t stride = WIDTH * cpp;
+	uint8_t *linear = random_buffer(stride * HEIGHT, x0 * 7 + y0);
+	uint8_t *tiled = calloc(1, size);
+	uint8_t *back = calloc(1, stride * HEIGHT);
+
+	igt_assert(tiled && back);
+
+	igt_tiling_to_tiled(t, tiled, linear + y0 * stride + x0 * cpp, stride,
+			    x0 * cpp, y0, w * cpp, h);
+
+	for (unsigned int y = 0; y < HEIGHT; y++) {
+		for (unsigned int x = 0; x < WIDTH; x++) {
+			uint64_t offset = l->offset(fb, swizzle, x, y);
+			bool inside = x >= x0 && x < x0 + w &&
+				      y >= y0 && y < y0 + h;
+
+			for (unsigned int i = 0; i < cpp; i++)
+				igt_assert_f(tiled[offset + i] ==
+					     (inside ? linear[y * stride + x * cpp + i] : 0),
+					     "%s: pixel %u,%u of %ux%u+%u+%u\n",
+					     l->name, x, y, w, h, x0, y0);
+		}
+	}
+
+	igt_tiling_from_tiled(t, back + y0 * stride + x0 * cpp, stride, tiled,
+			      x0 * cpp, y0, w * cpp, h);
+
+	for (unsigned int y = y0; y < y0 + h; y++)
+		igt_assert(!memcmp(back + y * stride + x0 * cpp,
+				   linear + y * stride + x0 * cpp, w * cpp));
+
+	free(back);
+	free(tiled);
+	free(linear);
+}
+
+static void test_layout(const struct layout *l)
+{
+	struct igt_tiling *t;
+	struct igt_fb fb;
+
+	init_fb(&fb, l);
+	t = igt_tiling_create_fb(&fb, 0);
+	igt_assert(t);
+
+	igt_debug("%s: %u byte chunks\n", l->name, igt_tiling_chunk_size(t));
+
+	check_offsets(t, &fb, l, I915_BIT_6_SWIZZLE_NONE);
+
+	check_rect(t, &fb, l, I915_BIT_6_SWIZZLE_NONE, 0, 0, WIDTH, HEIGHT);
+	check_rect(t, &fb, l, I915_BIT_6_SWIZZLE_NONE, 1, 3, 1, 1);
+	check_rect(t, &fb, l, I915_BIT_6_SWIZZLE_NONE, 13, 7, 251, 60);
+	check_rect(t, &fb, l, I915_BIT_6_SWIZZLE_NONE, 129, 33, 40, 57);
+
+	igt_tiling_destroy(t);
+}
+
+static void test_swizzle(uint32_t tiling, int swizzle)
+{
+	const struct layout *l = &layouts[tiling == I915_TILING_X ? 0 : 1];
+	struct igt_tiling *t;
+	struct igt_fb fb;
+
+	init_fb(&fb, l);
+	t = igt_tiling_create_intel(tiling, swizzle, fb.strides[0]);
+
+	/* Bit 6 swizzling only keeps runs of 64 bytes contiguous */
+	igt_assert_eq(igt_tiling_chunk_size(t), tiling == I915_TILING_X ? 64 : 16);
+
+	check_offsets(t, &fb, l, swizzle);
+	check_rect(t, &fb, l, swizzle, 13, 7, 251, 60);
+
+	/* Offsets within the whole buffer, as igt_draw swizzles them */
+	for (uint64_t addr = 0; addr < 1 << 16; addr += 16)
+		igt_assert_eq_u64(igt_tiling_swizzle(addr, swizzle),
+				  swizzle_addr(addr, swizzle));
+
+	igt_tiling_destroy(t);
+}
+
+static void test_fill(void)
+{
+	const struct layout *l = &layouts[0];
+	uint32_t color = 0xdeadbeef, line[40];
+	struct igt_tiling *t;
+	struct igt_fb fb;
+	uint8_t *tiled;
+
+	init_fb(&fb, l);
+	tiled = calloc(1, fb_size(&fb, l, I915_BIT_6_SWIZZLE_NONE));
+	igt_assert(tiled);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(line); i++)
+		line[i] = color;
+
+	/* A zero stride copies the same line to every row */
+	t = igt_tiling_create_fb(&fb, 0);
+	igt_tiling_to_tiled(t, tiled, line, 0, 100 * 4, 5, sizeof(line), 20);
+	igt_tiling_destroy(t);
+
+	for (unsigned int y = 0; y < HEIGHT; y++) {
+		for (unsigned int x = 0; x < WIDTH; x++) {
+			uint32_t pixel;
+
+			memcpy(&pixel, tiled + ref_x_tiled(&fb, 0, x, y), 4);
+			igt_assert_eq_u32(pixel,
+					  x >= 100 && x < 140 && y >= 5 && y < 25 ?
+					  color : 0);
+		}
+	}
+
+	free(tiled);
+}
+
+igt_main
+{
+	static const int swizzles[] = {
+		I915_BIT_6_SWIZZLE_9,
+		I915_BIT_6_SWIZZLE_9_10,
+		I915_BIT_6_SWIZZLE_9_11,
+		I915_BIT_6_SWIZZLE_9_10_11,
+	};
+	const struct layout *l;
+
+	igt_subtest_with_dynamic("layouts") {
+		for (l = layouts; l->name; l++) {
+			igt_dynamic(l->name)
+				test_layout(l);
+		}
+	}
+
+	igt_subtest("swizzle") {
+		for (unsigned int i = 0; i < ARRAY_SIZE(swizzles); i++) {
+			test_swizzle(I915_TILING_X, swizzles[i]);
+			test_swizzle(I915_TILING_Y, swizzles[i]);
+		}
+	}
+
+	igt_subtest("fill")
+		test_fill();
+}
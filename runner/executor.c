@@ -17,6 +17,7 @@
 #include <sys/mman.h>
 #include <sys/select.h>
 #include <sys/poll.h>
+#include <sys/prctl.h>
 #include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -842,6 +843,51 @@ static void write_packet_with_canary(int fd, struct runnerpacket *packet, bool s
 		fdatasync(fd);
 }
 
+/*
+ * In fork server mode subtests are forked by the test binary and
+ * reparented to the runner, which is a child subreaper for that. The
+ * fork servers themselves, and anything a test leaves behind, then
+ * also end up as our children.
+ */
+static bool child_subreaper;
+
+static struct {
+	char *binary;
+	pid_t pid;
+	int sock;
+} fork_server = { .pid = -1, .sock = -1 };
+
+static void forget_fork_server(pid_t pid)
+{
+	if (pid != fork_server.pid)
+		return;
+
+	close(fork_server.sock);
+	fork_server.sock = -1;
+	fork_server.pid = -1;
+}
+
+/*
+ * Reaps exited children other than @child. Returns whether @child
+ * itself has exited and is ready to be reaped.
+ */
+static bool reap_until_child(pid_t child)
+{
+	for (;;) {
+		siginfo_t info = {};
+
+		if (waitid(P_ALL, 0, &info, WEXITED | WNOHANG | WNOWAIT) ||
+		    info.si_pid == 0)
+			return false;
+
+		if (info.si_pid == child)
+			return true;
+
+		waitpid(info.si_pid, NULL, 0);
+		forget_fork_server(info.si_pid);
+	}
+}
+
 /* TODO: Refactor this macro from here and from various tests to lib */
 #define KB(x) ((x) * 1024)
 
@@ -1189,6 +1235,9 @@ static int monitor_output(pid_t child,
 				errf("Error reading from signalfd: %m\n");
 				continue;
 			} else if (siginfo.ssi_signo == SIGCHLD) {
+				if (child_subreaper && !reap_until_child(child))
+					continue;
+
 				if (child != waitpid(child, &status, WNOHANG)) {
 					errf("Failed to reap child\n");
 					status = 9999;
@@ -1450,19 +1499,12 @@ static int monitor_output(pid_t child,
 	return killed;
 }
 
-static void __attribute__((noreturn))
-execute_test_process(int outfd, int errfd, int socketfd,
-		     struct settings *settings,
-		     struct job_list_entry *entry)
+static void build_test_argv(char **argv,
+			    struct settings *settings,
+			    struct job_list_entry *entry)
 {
-	char *argv[6] = {};
 	size_t rootlen;
 
-	dup2(outfd, STDOUT_FILENO);
-	dup2(errfd, STDERR_FILENO);
-
-	setpgid(0, 0);
-
 	rootlen = strlen(settings->test_root);
 	argv[0] = malloc(rootlen + strlen(entry->binary) + 2);
 	strcpy(argv[0], settings->test_root);
@@ -1502,6 +1544,21 @@ execute_test_process(int outfd, int errfd, int socketfd,
 			argsize += sublen + 1;
 		}
 	}
+}
+
+static void __attribute__((noreturn))
+execute_test_process(int outfd, int errfd, int socketfd,
+		     struct settings *settings,
+		     struct job_list_entry *entry)
+{
+	char *argv[6] = {};
+
+	dup2(outfd, STDOUT_FILENO);
+	dup2(errfd, STDERR_FILENO);
+
+	setpgid(0, 0);
+
+	build_test_argv(argv, settings, entry);
 
 	if (socketfd >= 0) {
 		struct runnerpacket *packet;
@@ -1515,6 +1572,221 @@ execute_test_process(int outfd, int errfd, int socketfd,
 	exit(IGT_EXIT_INVALID);
 }
 
+/* Seconds a fork server gets to reach its first subtest */
+#define FORK_SERVER_START_TIMEOUT 60
+/* Seconds a fork server gets to answer a fork request */
+#define FORK_SERVER_REPLY_TIMEOUT 10
+
+static void stop_fork_server(void)
+{
+	pid_t pid = fork_server.pid;
+	int i;
+
+	close(fork_server.sock);
+	fork_server.sock = -1;
+	fork_server.pid = -1;
+
+	if (pid <= 0)
+		return;
+
+	/* Closing the control socket tells the server to exit */
+	for (i = 0; i < 200; i++) {
+		if (waitpid(pid, NULL, WNOHANG) == pid)
+			return;
+		usleep(10 * 1000);
+	}
+
+	kill(-pid, SIGKILL);
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+}
+
+static void reset_fork_server(void)
+{
+	stop_fork_server();
+	free(fork_server.binary);
+	fork_server.binary = NULL;
+}
+
+static struct runnerpacket *fork_server_receive(int timeout)
+{
+	struct pollfd pfd = { .fd = fork_server.sock, .events = POLLIN };
+	struct runnerpacket *packet;
+	int fds[RUNNERPACKET_MAX_FDS];
+	int nfds;
+
+	while (timeout-- > 0) {
+		int ret = poll(&pfd, 1, 1000);
+
+		ping_watchdogs();
+
+		if (ret < 0 && errno != EINTR)
+			return NULL;
+		if (ret <= 0)
+			continue;
+
+		packet = recv_packet_with_fds(fork_server.sock, fds, &nfds);
+		while (nfds--)
+			close(fds[nfds]);
+
+		return packet;
+	}
+
+	return NULL;
+}
+
+static bool start_fork_server(struct settings *settings,
+			      struct job_list_entry *entry,
+			      sigset_t *sigmask)
+{
+	struct runnerpacket *packet;
+	int sv[2];
+	pid_t pid;
+	bool ready;
+
+	/* Failures are remembered until the next binary comes up */
+	reset_fork_server();
+	fork_server.binary = strdup(entry->binary);
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv)) {
+		errf("Error creating fork server socket: %m\n");
+		return false;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid = fork();
+	if (pid < 0) {
+		errf("Failed to fork: %m\n");
+		close(sv[0]);
+		close(sv[1]);
+		return false;
+	} else if (pid == 0) {
+		char *argv[6] = {};
+		char fdstr[16];
+		int nullfd;
+
+		sigprocmask(SIG_UNBLOCK, sigmask, NULL);
+		setpgid(0, 0);
+
+		/* Nothing the test prints before its first subtest is kept */
+		nullfd = open("/dev/null", O_RDWR);
+		dup2(nullfd, STDOUT_FILENO);
+		dup2(nullfd, STDERR_FILENO);
+		setenv("IGT_SENTINEL_ON_STDERR", "1", 1);
+
+		snprintf(fdstr, sizeof(fdstr), "%d", dup(sv[1]));
+		build_test_argv(argv, settings,
+				&(struct job_list_entry){ .binary = entry->binary });
+		argv[1] = strdup("--fork-server");
+		argv[2] = fdstr;
+
+		execv(argv[0], argv);
+		_exit(IGT_EXIT_INVALID);
+	}
+
+	close(sv[1]);
+	fork_server.pid = pid;
+	fork_server.sock = sv[0];
+
+	packet = fork_server_receive(FORK_SERVER_START_TIMEOUT);
+	ready = packet && read_runnerpacket(packet).type == PACKETTYPE_FORK_SERVER_READY;
+	free(packet);
+
+	if (!ready) {
+		if (settings->log_level >= LOG_LEVEL_VERBOSE)
+			outf("Fork server for %s did not start, executing its subtests directly\n",
+			     entry->binary);
+		stop_fork_server();
+		return false;
+	}
+
+	return true;
+}
+
+static bool use_fork_server(struct settings *settings,
+			    struct job_list_entry *entry)
+{
+	return settings->fork_server && child_subreaper &&
+		entry->subtest_count == 1;
+}
+
+/*
+ * Starts the fork server of @entry's binary unless it is already
+ * running. This has to happen before the outputs of @entry are created:
+ * they aren't close-on-exec, so the server would otherwise keep them
+ * open for as long as it runs, and the runner would never see them
+ * reach EOF.
+ */
+static void prepare_fork_server(struct settings *settings,
+				struct job_list_entry *entry,
+				sigset_t *sigmask)
+{
+	if (fork_server.binary && !strcmp(fork_server.binary, entry->binary))
+		return;
+
+	start_fork_server(settings, entry, sigmask);
+}
+
+/*
+ * Asks the fork server of @entry's binary, prepared with
+ * prepare_fork_server(), for a process running @entry's subtest with
+ * the given outputs. Returns the pid of the new process, now a child of
+ * ours, or -1 if the test has to be executed the normal way.
+ */
+static pid_t fork_from_server(struct settings *settings,
+			      struct job_list_entry *entry,
+			      int outfd, int errfd, int *socket)
+{
+	runnerpacket_read_helper helper;
+	struct runnerpacket *packet;
+	char *argv[6] = {};
+	int fds[3] = { outfd, errfd, socket[1] };
+	int nfds;
+	pid_t pid;
+	bool sent;
+	int i;
+
+	if (!fork_server.binary || strcmp(fork_server.binary, entry->binary) ||
+	    fork_server.sock < 0)
+		return -1;
+
+	build_test_argv(argv, settings, entry);
+
+	/* Same as execute_test_process(), the exec packet comes first */
+	packet = runnerpacket_exec(argv);
+	write(socket[1], packet, packet->size);
+	free(packet);
+
+	packet = runnerpacket_fork_request(argv[2], argv[4]);
+	for (i = 0; argv[i]; i++)
+		free(argv[i]);
+
+	nfds = getenv("IGT_RUNNER_DISABLE_SOCKET_COMMUNICATION") ? 2 : 3;
+	sent = send_packet_with_fds(fork_server.sock, packet, fds, nfds);
+	free(packet);
+
+	packet = sent ? fork_server_receive(FORK_SERVER_REPLY_TIMEOUT) : NULL;
+	helper = packet ? read_runnerpacket(packet) : (runnerpacket_read_helper){};
+	pid = helper.type == PACKETTYPE_FORK_SPAWNED ? helper.forkspawned.pid : -1;
+	free(packet);
+
+	if (pid <= 0) {
+		char buf[64];
+
+		errf("Fork server for %s failed, executing its subtests directly\n",
+		     entry->binary);
+		stop_fork_server();
+
+		/* Drop the exec packet, the test process writes its own */
+		recv(socket[0], buf, sizeof(buf), MSG_DONTWAIT);
+		return -1;
+	}
+
+	return pid;
+}
+
 static int digits(size_t num)
 {
 	int ret = 0;
@@ -1598,6 +1870,9 @@ static int execute_next_entry(struct execute_state *state,
 	int result;
 	size_t idx = state->next;
 
+	if (use_fork_server(settings, entry))
+		prepare_fork_server(settings, entry, sigmask);
+
 	snprintf(name, sizeof(name), "%zd", idx);
 	mkdirat(resdirfd, name, 0777);
 	if ((dirfd = openat(resdirfd, name, O_DIRECTORY | O_RDONLY | O_CLOEXEC)) < 0) {
@@ -1662,7 +1937,13 @@ static int execute_next_entry(struct execute_state *state,
 	fflush(stdout);
 	fflush(stderr);
 
-	child = fork();
+	child = -1;
+	if (use_fork_server(settings, entry))
+		child = fork_from_server(settings, entry,
+					 outpipe[1], errpipe[1], socket);
+	if (child < 0)
+		child = fork();
+
 	if (child < 0) {
 		errf("Failed to fork: %m\n");
 		result = -1;
@@ -2018,7 +2299,10 @@ static bool should_die_because_signal(int sigfd)
 		}
 
 		if (siginfo.ssi_signo == SIGCHLD) {
-			errf("Runner got stray SIGCHLD while not executing any tests.\n");
+			if (child_subreaper)
+				reap_until_child(0);
+			else
+				errf("Runner got stray SIGCHLD while not executing any tests.\n");
 		} else {
 			errf("Runner is being killed by %s\n",
 			     strsignal(siginfo.ssi_signo));
@@ -2252,6 +2536,12 @@ bool execute(struct execute_state *state,
 
 	init_watchdogs(settings);
 
+	if (settings->fork_server && !settings->multiple_mode) {
+		child_subreaper = !prctl(PR_SET_CHILD_SUBREAPER, 1);
+		if (!child_subreaper)
+			errf("Cannot become a child subreaper, not using fork servers: %m\n");
+	}
+
 	if (settings->abort_mask & ABORT_PING)
 		ping_config();
 
@@ -2346,6 +2636,7 @@ bool execute(struct execute_state *state,
 		if (result > 0) {
 			double time_left = state->time_left;
 
+			reset_fork_server();
 			close_watchdogs(settings);
 			sigprocmask(SIG_UNBLOCK, &sigmask, NULL);
 			/* make sure that we do not leave any signals unhandled */
@@ -2368,6 +2659,8 @@ bool execute(struct execute_state *state,
 	}
 
  end:
+	reset_fork_server();
+
 	if (settings->enable_code_coverage && !settings->cov_results_per_test) {
 		char *reason = NULL;
 
@@ -2385,6 +2678,10 @@ bool execute(struct execute_state *state,
 	if (should_die_because_signal(sigfd))
 		status = false;
  end_post_signal_restore:
+	if (child_subreaper) {
+		prctl(PR_SET_CHILD_SUBREAPER, 0);
+		child_subreaper = false;
+	}
 	close(sigfd);
 	close(testdirfd);
 	close(resdirfd);
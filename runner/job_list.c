@@ -4,6 +4,7 @@
 #ifdef __linux__
 #include <linux/limits.h>
 #endif
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,18 +13,12 @@
 #include <unistd.h>
 
 #include "job_list.h"
+#include "igt_aux.h"
 #include "igt_core.h"
 
 static bool matches_any(const char *str, struct regex_list *list)
 {
-	size_t i;
-
-	for (i = 0; i < list->size; i++) {
-		if (g_regex_match(list->regexes[i], str, 0, NULL))
-			return true;
-	}
-
-	return false;
+	return list->filter && igt_name_filter_match(list->filter, str);
 }
 
 static void add_job_list_entry(struct job_list *job_list,
@@ -42,19 +37,39 @@ static void add_job_list_entry(struct job_list *job_list,
 	entry->subtest_count = subtest_count;
 }
 
-static void add_subtests(struct job_list *job_list, struct settings *settings,
-			 char *binary,
-			 struct regex_list *include, struct regex_list *exclude)
+/*
+ * Result of running a test binary with --list-subtests. names is
+ * only meaningful when listed is true; a binary that exits with
+ * IGT_EXIT_INVALID has no subtests at all.
+ */
+struct subtest_list {
+	char *binary;
+	char **names;
+	size_t count;
+	bool listed;
+	bool no_subtests;
+};
+
+static void free_subtest_list(struct subtest_list *list)
+{
+	size_t i;
+
+	for (i = 0; i < list->count; i++)
+		free(list->names[i]);
+	free(list->names);
+	list->names = NULL;
+	list->count = 0;
+}
+
+static void list_subtests(struct settings *settings, struct subtest_list *list)
 {
 	FILE *p;
 	char cmd[256] = {};
 	char *subtestname;
-	char **subtests = NULL;
-	size_t num_subtests = 0;
 	int s;
 
 	s = snprintf(cmd, sizeof(cmd), "%s/%s --list-subtests",
-		     settings->test_root, binary);
+		     settings->test_root, list->binary);
 	if (s < 0) {
 		fprintf(stderr, "Failure generating command string, this shouldn't happen.\n");
 		return;
@@ -62,11 +77,12 @@ static void add_subtests(struct job_list *job_list, struct settings *settings,
 
 	if (s >= sizeof(cmd)) {
 		fprintf(stderr, "Path to binary too long, ignoring: %s/%s\n",
-			settings->test_root, binary);
+			settings->test_root, list->binary);
 		return;
 	}
 
-	p = popen(cmd, "r");
+	/* Don't leak our end of the pipe to binaries listed concurrently */
+	p = popen(cmd, "re");
 	if (!p) {
 		fprintf(stderr, "popen failed when executing %s: %s\n",
 			cmd,
@@ -75,19 +91,379 @@ static void add_subtests(struct job_list *job_list, struct settings *settings,
 	}
 
 	while (fscanf(p, "%ms", &subtestname) == 1) {
+		list->count++;
+		list->names = realloc(list->names, list->count * sizeof(*list->names));
+		list->names[list->count - 1] = subtestname;
+	}
+
+	s = pclose(p);
+	if (s == 0) {
+		list->listed = true;
+	} else if (s == -1) {
+		fprintf(stderr, "popen error when executing %s: %s\n", list->binary, strerror(errno));
+	} else if (WIFEXITED(s)) {
+		if (WEXITSTATUS(s) == IGT_EXIT_INVALID) {
+			list->listed = true;
+			list->no_subtests = true;
+		}
+	} else {
+		fprintf(stderr, "Test binary %s died unexpectedly\n", list->binary);
+	}
+
+	if (!list->listed || list->no_subtests)
+		free_subtest_list(list);
+}
+
+static void copy_subtest_names(struct subtest_list *dst,
+			       const struct subtest_list *src)
+{
+	size_t i;
+
+	dst->listed = src->listed;
+	dst->no_subtests = src->no_subtests;
+	dst->count = src->count;
+	dst->names = malloc(src->count * sizeof(*dst->names));
+	for (i = 0; i < src->count; i++)
+		dst->names[i] = strdup(src->names[i]);
+}
+
+#define SUBTEST_CACHE_MAGIC "igt_runner subtest cache 1\n"
+
+/*
+ * Cached --list-subtests output, keyed by the full path of the
+ * binary. Entries are only trusted while the size and modification
+ * time of the binary are unchanged.
+ */
+struct subtest_cache_entry {
+	struct subtest_list list;
+	off_t size;
+	struct timespec mtime;
+};
+
+static char *subtest_cache_path(void)
+{
+	const char *env, *dir;
+	char *path;
+
+	env = getenv("IGT_RUNNER_SUBTEST_CACHE");
+	if (env)
+		return *env ? strdup(env) : NULL;
+
+	if ((dir = getenv("XDG_CACHE_HOME")) != NULL && *dir) {
+		if (asprintf(&path, "%s/igt_runner/subtests", dir) < 0)
+			return NULL;
+	} else if ((dir = getenv("HOME")) != NULL && *dir) {
+		if (asprintf(&path, "%s/.cache/igt_runner/subtests", dir) < 0)
+			return NULL;
+	} else {
+		return NULL;
+	}
+
+	return path;
+}
+
+static void free_subtest_cache_entry(gpointer data)
+{
+	struct subtest_cache_entry *entry = data;
+
+	free_subtest_list(&entry->list);
+	free(entry->list.binary);
+	free(entry);
+}
+
+static bool subtest_cache_entry_valid(const struct subtest_cache_entry *entry,
+				      const struct stat *st)
+{
+	return entry->size == st->st_size &&
+		entry->mtime.tv_sec == st->st_mtim.tv_sec &&
+		entry->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static GHashTable *load_subtest_cache(const char *path)
+{
+	GHashTable *cache;
+	char *line = NULL;
+	size_t line_len = 0;
+	FILE *f;
+
+	cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+				      NULL, free_subtest_cache_entry);
+
+	if (!path || (f = fopen(path, "re")) == NULL)
+		return cache;
+
+	if (getline(&line, &line_len, f) < 0 ||
+	    strcmp(line, SUBTEST_CACHE_MAGIC))
+		goto out;
+
+	while (getline(&line, &line_len, f) > 0) {
+		struct subtest_cache_entry *entry;
+		long long size, sec, nsec;
+		size_t count, i;
+		char kind;
+		int pos = 0;
+
+		if (sscanf(line, "%c %lld %lld %lld %zu %n",
+			   &kind, &size, &sec, &nsec, &count, &pos) != 5 ||
+		    !pos || (kind != 'S' && kind != 'N'))
+			break;
+
+		entry = calloc(1, sizeof(*entry));
+		entry->list.binary = strndup(line + pos, strcspn(line + pos, "\n"));
+		entry->list.listed = true;
+		entry->list.no_subtests = kind == 'N';
+		entry->size = size;
+		entry->mtime.tv_sec = sec;
+		entry->mtime.tv_nsec = nsec;
+
+		for (i = 0; i < count; i++) {
+			char *name;
+
+			if (fscanf(f, "%ms", &name) != 1)
+				break;
+
+			entry->list.count++;
+			entry->list.names = realloc(entry->list.names,
+						    entry->list.count * sizeof(*entry->list.names));
+			entry->list.names[entry->list.count - 1] = name;
+		}
+
+		/* Skip the rest of the last subtest line */
+		if (count && getline(&line, &line_len, f) < 0)
+			i = 0;
+
+		if (i < count) {
+			free_subtest_cache_entry(entry);
+			break;
+		}
+
+		g_hash_table_replace(cache, entry->list.binary, entry);
+	}
+
+out:
+	free(line);
+	fclose(f);
+	return cache;
+}
+
+static void mkdir_parents(const char *path)
+{
+	char *dir = strdup(path);
+	char *slash = dir;
+
+	while ((slash = strchr(slash + 1, '/')) != NULL) {
+		*slash = '\0';
+		mkdir(dir, 0777);
+		*slash = '/';
+	}
+
+	free(dir);
+}
+
+static void save_subtest_cache(const char *path, GHashTable *cache)
+{
+	struct subtest_cache_entry *entry;
+	GHashTableIter iter;
+	char *tmp;
+	FILE *f;
+	int fd;
+
+	mkdir_parents(path);
+
+	if (asprintf(&tmp, "%s.XXXXXX", path) < 0)
+		return;
+
+	fd = mkostemp(tmp, O_CLOEXEC);
+	if (fd < 0) {
+		free(tmp);
+		return;
+	}
+
+	f = fdopen(fd, "w");
+	if (!f) {
+		close(fd);
+		unlink(tmp);
+		free(tmp);
+		return;
+	}
+
+	fputs(SUBTEST_CACHE_MAGIC, f);
+
+	g_hash_table_iter_init(&iter, cache);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&entry)) {
+		struct stat st;
+		size_t i;
+
+		/* Drop entries for binaries that were removed or rebuilt */
+		if (stat(entry->list.binary, &st) ||
+		    !subtest_cache_entry_valid(entry, &st))
+			continue;
+
+		fprintf(f, "%c %lld %lld %lld %zu %s\n",
+			entry->list.no_subtests ? 'N' : 'S',
+			(long long)entry->size,
+			(long long)entry->mtime.tv_sec,
+			(long long)entry->mtime.tv_nsec,
+			entry->list.count,
+			entry->list.binary);
+
+		for (i = 0; i < entry->list.count; i++)
+			fprintf(f, "%s\n", entry->list.names[i]);
+	}
+
+	if (fclose(f) || rename(tmp, path))
+		unlink(tmp);
+
+	free(tmp);
+}
+
+struct list_subtests_state {
+	struct settings *settings;
+	struct subtest_list **lists;
+	size_t count;
+	size_t next;
+};
+
+static void *list_subtests_thread(void *data)
+{
+	struct list_subtests_state *state = data;
+	size_t i;
+
+	while ((i = __atomic_fetch_add(&state->next, 1, __ATOMIC_RELAXED)) < state->count)
+		list_subtests(state->settings, state->lists[i]);
+
+	return NULL;
+}
+
+/*
+ * Fills in the subtests of all the given binaries. Binaries whose
+ * listing is in the subtest cache and are unchanged since are not
+ * executed, the rest are listed concurrently and added to the cache.
+ */
+static void list_all_subtests(struct settings *settings,
+			      struct subtest_list **lists, size_t count)
+{
+	struct list_subtests_state state = { .settings = settings };
+	struct subtest_cache_entry *entry;
+	struct stat *stats;
+	bool *stat_ok;
+	GHashTable *cache;
+	pthread_t *threads;
+	size_t nthreads, i;
+	char *cache_path;
+	long ncpus;
+
+	if (!count)
+		return;
+
+	cache_path = subtest_cache_path();
+	cache = load_subtest_cache(cache_path);
+
+	stats = calloc(count, sizeof(*stats));
+	stat_ok = calloc(count, sizeof(*stat_ok));
+	state.lists = calloc(count, sizeof(*state.lists));
+
+	for (i = 0; i < count; i++) {
+		char path[PATH_MAX];
+
+		snprintf(path, sizeof(path), "%s/%s",
+			 settings->test_root, lists[i]->binary);
+		stat_ok[i] = stat(path, &stats[i]) == 0;
+
+		if (stat_ok[i] &&
+		    (entry = g_hash_table_lookup(cache, path)) != NULL &&
+		    subtest_cache_entry_valid(entry, &stats[i])) {
+			copy_subtest_names(lists[i], &entry->list);
+			continue;
+		}
+
+		state.lists[state.count++] = lists[i];
+	}
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = ncpus > 0 ? min_t(size_t, ncpus, state.count) : 1;
+	threads = calloc(nthreads, sizeof(*threads));
+
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, list_subtests_thread, &state))
+			break;
+	}
+	nthreads = i;
+
+	list_subtests_thread(&state);
+
+	for (i = 1; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+
+	if (cache_path && state.count) {
+		for (i = 0; i < count; i++) {
+			if (!lists[i]->listed || !stat_ok[i])
+				continue;
+
+			entry = calloc(1, sizeof(*entry));
+			if (asprintf(&entry->list.binary, "%s/%s",
+				     settings->test_root, lists[i]->binary) < 0) {
+				free(entry);
+				continue;
+			}
+			copy_subtest_names(&entry->list, lists[i]);
+			entry->size = stats[i].st_size;
+			entry->mtime = stats[i].st_mtim;
+
+			g_hash_table_replace(cache, entry->list.binary, entry);
+		}
+
+		save_subtest_cache(cache_path, cache);
+	}
+
+	free(threads);
+	free(state.lists);
+	free(stat_ok);
+	free(stats);
+	g_hash_table_destroy(cache);
+	free(cache_path);
+}
+
+static void add_subtests(struct job_list *job_list, struct settings *settings,
+			 struct subtest_list *list,
+			 struct regex_list *include, struct regex_list *exclude)
+{
+	char *binary = list->binary;
+	char **subtests = NULL;
+	size_t num_subtests = 0;
+	size_t i;
+
+	if (!list->listed)
+		return;
+
+	if (list->no_subtests) {
+		char piglitname[256];
+
+		generate_piglit_name(binary, NULL,
+				     piglitname, sizeof(piglitname));
+		/* No subtests on this one */
+		if (exclude && exclude->size &&
+		    matches_any(piglitname, exclude)) {
+			return;
+		}
+		if (!include || !include->size ||
+		    matches_any(piglitname, include)) {
+			add_job_list_entry(job_list, strdup(binary), NULL, 0);
+		}
+		return;
+	}
+
+	for (i = 0; i < list->count; i++) {
+		char *subtestname = list->names[i];
 		char piglitname[256];
 
 		generate_piglit_name(binary, subtestname, piglitname, sizeof(piglitname));
 
-		if (exclude && exclude->size && matches_any(piglitname, exclude)) {
-			free(subtestname);
+		if (exclude && exclude->size && matches_any(piglitname, exclude))
 			continue;
-		}
 
-		if (include && include->size && !matches_any(piglitname, include)) {
-			free(subtestname);
+		if (include && include->size && !matches_any(piglitname, include))
 			continue;
-		}
 
 		if (settings->multiple_mode) {
 			num_subtests++;
@@ -99,44 +475,23 @@ static void add_subtests(struct job_list *job_list, struct settings *settings,
 			add_job_list_entry(job_list, strdup(binary), subtests, 1);
 			subtests = NULL;
 		}
-
-		free(subtestname);
 	}
 
 	if (num_subtests)
 		add_job_list_entry(job_list, strdup(binary), subtests, num_subtests);
-
-	s = pclose(p);
-	if (s == 0) {
-		return;
-	} else if (s == -1) {
-		fprintf(stderr, "popen error when executing %s: %s\n", binary, strerror(errno));
-	} else if (WIFEXITED(s)) {
-		if (WEXITSTATUS(s) == IGT_EXIT_INVALID) {
-			char piglitname[256];
-
-			generate_piglit_name(binary, NULL,
-					     piglitname, sizeof(piglitname));
-			/* No subtests on this one */
-			if (exclude && exclude->size &&
-			    matches_any(piglitname, exclude)) {
-				return;
-			}
-			if (!include || !include->size ||
-			    matches_any(piglitname, include)) {
-				add_job_list_entry(job_list, strdup(binary), NULL, 0);
-				return;
-			}
-		}
-	} else {
-		fprintf(stderr, "Test binary %s died unexpectedly\n", binary);
-	}
 }
 
 static bool filtered_job_list(struct job_list *job_list,
 			      struct settings *settings,
 			      int fd)
 {
+	struct subtest_list *lists = NULL, **to_list;
+	enum {
+		ADD_ALL,
+		FILTER_EXCLUDE,
+		FILTER_BOTH,
+	} *modes = NULL;
+	size_t count = 0, num_to_list = 0, i;
 	FILE *f;
 	char buf[128];
 	bool ok;
@@ -149,6 +504,8 @@ static bool filtered_job_list(struct job_list *job_list,
 	f = fdopen(fd, "r");
 
 	while (fscanf(f, "%127s", buf) == 1) {
+		int mode;
+
 		if (!strcmp(buf, "TESTLIST") || !(strcmp(buf, "END")))
 			continue;
 
@@ -171,21 +528,60 @@ static bool filtered_job_list(struct job_list *job_list,
 				 * get to omit executing
 				 * --list-subtests.
 				 */
-				add_job_list_entry(job_list, strdup(buf), NULL, 0);
+				mode = ADD_ALL;
 			else
-				add_subtests(job_list, settings, buf,
-					     NULL, &settings->exclude_regexes);
-			continue;
+				mode = FILTER_EXCLUDE;
+		} else {
+			/*
+			 * Binary name doesn't match exclude or include filters.
+			 */
+			mode = FILTER_BOTH;
 		}
 
-		/*
-		 * Binary name doesn't match exclude or include filters.
-		 */
-		add_subtests(job_list, settings, buf,
-			     &settings->include_regexes,
-			     &settings->exclude_regexes);
+		count++;
+		lists = realloc(lists, count * sizeof(*lists));
+		modes = realloc(modes, count * sizeof(*modes));
+		memset(&lists[count - 1], 0, sizeof(*lists));
+		lists[count - 1].binary = strdup(buf);
+		modes[count - 1] = mode;
 	}
 
+	/*
+	 * Listing the subtests is the expensive part, do it for all
+	 * binaries at once and only then build the job list in
+	 * test-list.txt order.
+	 */
+	to_list = calloc(count, sizeof(*to_list));
+	for (i = 0; i < count; i++) {
+		if (modes[i] != ADD_ALL)
+			to_list[num_to_list++] = &lists[i];
+	}
+	list_all_subtests(settings, to_list, num_to_list);
+	free(to_list);
+
+	for (i = 0; i < count; i++) {
+		switch (modes[i]) {
+		case ADD_ALL:
+			add_job_list_entry(job_list, strdup(lists[i].binary), NULL, 0);
+			break;
+		case FILTER_EXCLUDE:
+			add_subtests(job_list, settings, &lists[i],
+				     NULL, &settings->exclude_regexes);
+			break;
+		case FILTER_BOTH:
+			add_subtests(job_list, settings, &lists[i],
+				     &settings->include_regexes,
+				     &settings->exclude_regexes);
+			break;
+		}
+
+		free_subtest_list(&lists[i]);
+		free(lists[i].binary);
+	}
+
+	free(modes);
+	free(lists);
+
 	ok = job_list->size != 0;
 	if (!ok)
 		fprintf(stderr, "Filter didn't match any job name\n");
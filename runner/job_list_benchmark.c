@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "settings.h"
+#include "job_list.h"
+
+/*
+ * Times job list creation, i.e. enumerating the subtests of every
+ * binary in test-list.txt and filtering them, without the subtest
+ * cache, with a cold cache and with a warm cache.
+ *
+ * Takes the same arguments as igt_runner, e.g.
+ *   runner_job_list_benchmark -L [-t regex] [-x regex] build/tests
+ * Nothing gets executed or written to the results path.
+ */
+
+static double elapsed(const struct timespec *start,
+		      const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) + 1e-9*(end->tv_nsec - start->tv_nsec);
+}
+
+static double time_job_list(struct job_list *job_list,
+			    struct settings *settings)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (!create_job_list(job_list, settings)) {
+		fprintf(stderr, "Creating the job list failed\n");
+		exit(1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return elapsed(&start, &end);
+}
+
+int main(int argc, char **argv)
+{
+	char cachedir[] = "/tmp/igt_job_list.XXXXXX";
+	char cachename[sizeof(cachedir) + 16];
+	struct settings settings;
+	struct job_list job_list;
+	double uncached, cold, warm;
+
+	init_settings(&settings);
+	init_job_list(&job_list);
+
+	if (!parse_options(argc, argv, &settings))
+		return 1;
+
+	if (!mkdtemp(cachedir)) {
+		perror("mkdtemp");
+		return 1;
+	}
+	snprintf(cachename, sizeof(cachename), "%s/subtests", cachedir);
+
+	setenv("IGT_RUNNER_SUBTEST_CACHE", "", 1);
+	uncached = time_job_list(&job_list, &settings);
+
+	setenv("IGT_RUNNER_SUBTEST_CACHE", cachename, 1);
+	cold = time_job_list(&job_list, &settings);
+	warm = time_job_list(&job_list, &settings);
+
+	printf("%zu jobs\n", job_list.size);
+	printf("uncached: %8.3f s\n", uncached);
+	printf("cold:     %8.3f s\n", cold);
+	printf("warm:     %8.3f s\n", warm);
+
+	free_job_list(&job_list);
+	clear_settings(&settings);
+	unlink(cachename);
+	rmdir(cachedir);
+
+	return 0;
+}
@@ -194,6 +194,7 @@ static void assert_settings_equal(struct settings *one, struct settings *two)
 	igt_assert_eq(one->log_level, two->log_level);
 	igt_assert_eq(one->overwrite, two->overwrite);
 	igt_assert_eq(one->multiple_mode, two->multiple_mode);
+	igt_assert_eq(one->fork_server, two->fork_server);
 	igt_assert_eq(one->inactivity_timeout, two->inactivity_timeout);
 	igt_assert_eq(one->per_test_timeout, two->per_test_timeout);
 	igt_assert_eq(one->use_watchdog, two->use_watchdog);
@@ -273,6 +274,13 @@ igt_main
 		for (i = 3; i < 400; i++)
 			close(i);
 
+		/*
+		 * Don't leave subtest caches in the user's home
+		 * directory, the subtests checking the cache set up
+		 * their own.
+		 */
+		setenv("IGT_RUNNER_SUBTEST_CACHE", "", 1);
+
 		init_settings(settings);
 	}
 
@@ -297,6 +305,7 @@ igt_main
 		igt_assert_eq(settings->log_level, LOG_LEVEL_NORMAL);
 		igt_assert(!settings->overwrite);
 		igt_assert(!settings->multiple_mode);
+		igt_assert(!settings->fork_server);
 		igt_assert_eq(settings->inactivity_timeout, 0);
 		igt_assert_eq(settings->per_test_timeout, 0);
 		igt_assert_eq(settings->overall_timeout, 0);
@@ -418,6 +427,7 @@ igt_main
 		igt_assert_eq(settings->log_level, LOG_LEVEL_NORMAL);
 		igt_assert(!settings->overwrite);
 		igt_assert(!settings->multiple_mode);
+		igt_assert(!settings->fork_server);
 		igt_assert_eq(settings->inactivity_timeout, 0);
 		igt_assert_eq(settings->per_test_timeout, 0);
 		igt_assert_eq(settings->overall_timeout, 0);
@@ -455,6 +465,7 @@ igt_main
 				       "-l", "verbose",
 				       "--overwrite",
 				       "--multiple-mode",
+				       "--fork-server",
 				       "--inactivity-timeout", "27",
 				       "--per-test-timeout", "72",
 				       "--overall-timeout", "360",
@@ -507,6 +518,7 @@ igt_main
 		igt_assert_eq(settings->log_level, LOG_LEVEL_VERBOSE);
 		igt_assert(settings->overwrite);
 		igt_assert(settings->multiple_mode);
+		igt_assert(settings->fork_server);
 		igt_assert_eq(settings->inactivity_timeout, 27);
 		igt_assert_eq(settings->per_test_timeout, 72);
 		igt_assert_eq(settings->overall_timeout, 360);
@@ -928,6 +940,77 @@ igt_main
 		}
 	}
 
+	igt_subtest_group {
+		char dirname[] = "tmpdirXXXXXX";
+		char cachename[PATH_MAX];
+		struct job_list *list = malloc(sizeof(*list));
+
+		igt_fixture {
+			igt_require(mkdtemp(dirname) != NULL);
+			snprintf(cachename, sizeof(cachename), "%s/subtests", dirname);
+			setenv("IGT_RUNNER_SUBTEST_CACHE", cachename, 1);
+			init_job_list(list);
+		}
+
+		igt_subtest("job-list-subtest-cache") {
+			const char *argv[] = { "runner",
+					       "-t", "successtest",
+					       testdatadir,
+					       "path-to-results",
+			};
+			char binary[PATH_MAX];
+			struct stat st;
+			FILE *f;
+
+			igt_assert(parse_options(ARRAY_SIZE(argv), (char**)argv, settings));
+
+			/* Cold cache, the binary gets listed and the cache written */
+			igt_assert(create_job_list(list, settings));
+			igt_assert_eq(list->size, 2);
+			igt_assert_eqstr(list->entries[0].subtests[0], "first-subtest");
+			igt_assert_eq(access(cachename, R_OK), 0);
+
+			/* Warm cache, the cached listing is used as is */
+			snprintf(binary, sizeof(binary), "%s/successtest", settings->test_root);
+			igt_assert_eq(stat(binary, &st), 0);
+			igt_assert((f = fopen(cachename, "w")) != NULL);
+			fprintf(f, "igt_runner subtest cache 1\n"
+				"S %lld %lld %lld 1 %s\ncached-subtest\n",
+				(long long)st.st_size,
+				(long long)st.st_mtim.tv_sec,
+				(long long)st.st_mtim.tv_nsec,
+				binary);
+			fclose(f);
+
+			igt_assert(create_job_list(list, settings));
+			igt_assert_eq(list->size, 1);
+			igt_assert_eqstr(list->entries[0].subtests[0], "cached-subtest");
+
+			/* Stale cache, the binary gets listed again */
+			igt_assert((f = fopen(cachename, "w")) != NULL);
+			fprintf(f, "igt_runner subtest cache 1\n"
+				"S %lld %lld %lld 1 %s\ncached-subtest\n",
+				(long long)st.st_size + 1,
+				(long long)st.st_mtim.tv_sec,
+				(long long)st.st_mtim.tv_nsec,
+				binary);
+			fclose(f);
+
+			igt_assert(create_job_list(list, settings));
+			igt_assert_eq(list->size, 2);
+			igt_assert_eqstr(list->entries[0].subtests[0], "first-subtest");
+			igt_assert_eqstr(list->entries[1].subtests[0], "second-subtest");
+		}
+
+		igt_fixture {
+			setenv("IGT_RUNNER_SUBTEST_CACHE", "", 1);
+			unlink(cachename);
+			rmdir(dirname);
+			free_job_list(list);
+			free(list);
+		}
+	}
+
 	igt_subtest_group {
 		char dirname[] = "tmpdirXXXXXX";
 		volatile int dirfd = -1, fd = -1;
@@ -1856,6 +1939,62 @@ igt_main
 		}
 	}
 
+	igt_subtest_group {
+		struct job_list *list = malloc(sizeof(*list));
+		volatile int dirfd = -1;
+		char dirname[] = "tmpdirXXXXXX";
+
+		igt_fixture {
+			igt_require(mkdtemp(dirname) != NULL);
+			rmdir(dirname);
+
+			init_job_list(list);
+		}
+
+		igt_subtest("execute-fork-server") {
+			struct execute_state state;
+			struct json_object *results, *tests;
+			const char *argv[] = { "runner",
+					       "--allow-non-root",
+					       "--fork-server",
+					       "-t", "^successtest$",
+					       "-t", "^skippers$",
+					       "-t", "^dynamic$",
+					       "-t", "^no-subtests$",
+					       testdatadir,
+					       dirname,
+			};
+
+			igt_assert(parse_options(ARRAY_SIZE(argv), (char**)argv, settings));
+			igt_assert(create_job_list(list, settings));
+			igt_assert(initialize_execute_state(&state, settings, list));
+			igt_assert(execute(&state, settings, list));
+
+			igt_assert_f((dirfd = open(dirname, O_DIRECTORY | O_RDONLY)) >= 0,
+				     "Execute didn't create the results directory\n");
+			igt_assert_f((results = generate_results_json(dirfd)) != NULL,
+				     "Results parsing failed\n");
+
+			igt_assert(json_object_object_get_ex(results, "tests", &tests));
+
+			igt_assert_eqstr(igt_get_result(tests, "igt@successtest@first-subtest"), "pass");
+			igt_assert_eqstr(igt_get_result(tests, "igt@successtest@second-subtest"), "pass");
+			igt_assert_eqstr(igt_get_result(tests, "igt@skippers@skip-one"), "skip");
+			igt_assert_eqstr(igt_get_result(tests, "igt@skippers@skip-two"), "skip");
+			igt_assert_eqstr(igt_get_result(tests, "igt@dynamic@dynamic-subtest@passing"), "pass");
+			igt_assert_eqstr(igt_get_result(tests, "igt@dynamic@dynamic-subtest@failing"), "fail");
+			igt_assert_eqstr(igt_get_result(tests, "igt@no-subtests"), "pass");
+
+			igt_assert_eq(json_object_put(results), 1);
+		}
+
+		igt_fixture {
+			close(dirfd);
+			clear_directory(dirname);
+			free_job_list(list);
+		}
+	}
+
 	igt_subtest_group {
 		struct job_list *list = malloc(sizeof(*list));
 		volatile int dirfd = -1;
@@ -30,6 +30,7 @@ enum {
 	OPT_COV_RESULTS_PER_TEST,
 	OPT_VERSION,
 	OPT_PRUNE_MODE,
+	OPT_FORK_SERVER,
 	OPT_HELP = 'h',
 	OPT_NAME = 'n',
 	OPT_DRY_RUN = 'd',
@@ -241,6 +242,11 @@ static const char *usage_str =
 	"                        binary. Note that in that case relative ordering of the\n"
 	"                        subtest execution is dictated by the test binary, not\n"
 	"                        the testlist\n"
+	"  --fork-server         Start each test binary once and fork a new process\n"
+	"                        from it for every subtest, skipping the test's\n"
+	"                        startup for all but the first one. Subtests still\n"
+	"                        get their own process, outputs and timeouts.\n"
+	"                        Ignored in multiple-mode\n"
 	"  --inactivity-timeout <seconds>\n"
 	"                        Kill the running test after <seconds> of inactivity in\n"
 	"                        the test's stdout, stderr, or dmesg\n"
@@ -301,6 +307,14 @@ static const char *usage_str =
 	"  [test_root]           Directory that contains the IGT tests. The environment\n"
 	"                        variable IGT_TEST_ROOT will be used if set, overriding\n"
 	"                        this option if given.\n"
+	"\n"
+	" Environment:\n"
+	"  IGT_RUNNER_SUBTEST_CACHE\n"
+	"                        File caching the subtest lists of test binaries, which\n"
+	"                        are reused while the binary's size and modification\n"
+	"                        time are unchanged. Defaults to\n"
+	"                        $XDG_CACHE_HOME/igt_runner/subtests. Set to an empty\n"
+	"                        string to always list subtests afresh.\n"
 	;
 
 __attribute__ ((format (printf, 2, 3)))
@@ -338,6 +352,10 @@ static bool add_regex(struct regex_list *list, char *new)
 	list->regex_strings[list->size] = new;
 	list->size++;
 
+	if (!list->filter)
+		list->filter = igt_name_filter_create();
+	igt_name_filter_add_regex(list->filter, new, regex);
+
 	return true;
 }
 
@@ -390,6 +408,7 @@ static void free_regexes(struct regex_list *regexes)
 {
 	size_t i;
 
+	igt_name_filter_destroy(regexes->filter);
 	for (i = 0; i < regexes->size; i++) {
 		free(regexes->regex_strings[i]);
 		g_regex_unref(regexes->regexes[i]);
@@ -655,6 +674,7 @@ bool parse_options(int argc, char **argv,
 		{"coverage-per-test", no_argument, NULL, OPT_COV_RESULTS_PER_TEST},
 		{"collect-script", required_argument, NULL, OPT_CODE_COV_SCRIPT},
 		{"multiple-mode", no_argument, NULL, OPT_MULTIPLE},
+		{"fork-server", no_argument, NULL, OPT_FORK_SERVER},
 		{"inactivity-timeout", required_argument, NULL, OPT_TIMEOUT},
 		{"per-test-timeout", required_argument, NULL, OPT_PER_TEST_TIMEOUT},
 		{"overall-timeout", required_argument, NULL, OPT_OVERALL_TIMEOUT},
@@ -744,6 +764,9 @@ bool parse_options(int argc, char **argv,
 		case OPT_MULTIPLE:
 			settings->multiple_mode = true;
 			break;
+		case OPT_FORK_SERVER:
+			settings->fork_server = true;
+			break;
 		case OPT_TIMEOUT:
 			settings->inactivity_timeout = atoi(optarg);
 			break;
@@ -1027,6 +1050,7 @@ bool serialize_settings(struct settings *settings)
 	SERIALIZE_LINE(f, settings, log_level, "%d");
 	SERIALIZE_LINE(f, settings, overwrite, "%d");
 	SERIALIZE_LINE(f, settings, multiple_mode, "%d");
+	SERIALIZE_LINE(f, settings, fork_server, "%d");
 	SERIALIZE_LINE(f, settings, inactivity_timeout, "%d");
 	SERIALIZE_LINE(f, settings, per_test_timeout, "%d");
 	SERIALIZE_LINE(f, settings, overall_timeout, "%d");
@@ -1090,6 +1114,7 @@ bool read_settings_from_file(struct settings *settings, FILE *f)
 		PARSE_LINE(settings, name, val, log_level, numval);
 		PARSE_LINE(settings, name, val, overwrite, numval);
 		PARSE_LINE(settings, name, val, multiple_mode, numval);
+		PARSE_LINE(settings, name, val, fork_server, numval);
 		PARSE_LINE(settings, name, val, inactivity_timeout, numval);
 		PARSE_LINE(settings, name, val, per_test_timeout, numval);
 		PARSE_LINE(settings, name, val, overall_timeout, numval);
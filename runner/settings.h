@@ -8,6 +8,7 @@
 #include <glib.h>
 
 #include "igt_list.h"
+#include "igt_name_filter.h"
 
 enum {
 	LOG_LEVEL_NORMAL = 0,
@@ -36,6 +37,7 @@ enum {
 struct regex_list {
 	char **regex_strings;
 	GRegex **regexes;
+	struct igt_name_filter *filter;
 	size_t size;
 };
 
@@ -59,6 +61,7 @@ struct settings {
 	int log_level;
 	bool overwrite;
 	bool multiple_mode;
+	bool fork_server;
 	int inactivity_timeout;
 	int per_test_timeout;
 	int overall_timeout;
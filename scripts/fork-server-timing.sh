@@ -0,0 +1,52 @@
+#!/bin/sh
+# SPDX-License-Identifier: MIT
+#
+# Compare igt_runner wall time with and without --fork-server.
+#
+# Usage: fork-server-timing.sh TEST_ROOT [igt_runner options...]
+#
+# Runs the selected tests from TEST_ROOT once per mode and prints the
+# elapsed time of each run. TEST_ROOT needs a test-list.txt unless one
+# is given with --test-list. For example, for the core tests of a build
+# directory and for the library self-tests:
+#
+#   fork-server-timing.sh build/tests -t '^core_'
+#   ls build/lib/tests | grep -v '\.' | sed 's/^/igt@/' > /tmp/lib-tests.txt
+#   fork-server-timing.sh build/lib/tests --allow-non-root \
+#           --test-list /tmp/lib-tests.txt
+
+set -e
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 TEST_ROOT [igt_runner options...]" >&2
+	exit 1
+fi
+
+ROOT="`dirname $0`"
+ROOT="`readlink -f $ROOT/..`"
+TEST_ROOT="$1"
+shift
+
+IGT_RUNNER="${IGT_RUNNER:-`ls $ROOT/build/runner/igt_runner 2> /dev/null || which igt_runner`}"
+if [ ! -x "$IGT_RUNNER" ]; then
+	echo "igt_runner not found, set IGT_RUNNER" >&2
+	exit 1
+fi
+
+RESULTS="`mktemp -d`"
+trap 'rm -rf "$RESULTS"' EXIT
+
+now() {
+	date +%s.%N
+}
+
+for mode in exec fork-server; do
+	opt=
+	[ $mode = fork-server ] && opt=--fork-server
+
+	start=`now`
+	"$IGT_RUNNER" -l quiet $opt "$@" "$TEST_ROOT" "$RESULTS/$mode" || true
+	end=`now`
+
+	echo "$mode: `echo "$end - $start" | bc` s"
+done
@@ -1509,13 +1509,13 @@ audio_output_frequencies_callback(void *data, void *buffer, int samples)
 
 static bool test_audio_frequencies(struct audio_state *state)
 {
+	struct audio_signal_detector *det;
+	bool detected[CHAMELIUM_MAX_AUDIO_CHANNELS];
 	int freq, step;
-	int32_t *recv, *buf;
-	double *channel;
+	int32_t *recv;
 	size_t i, j, streak;
-	size_t recv_len, buf_len, buf_cap, channel_len;
+	size_t recv_len, consumed;
 	bool success;
-	int capture_chan;
 
 	state->signal = audio_signal_init(state->playback.channels,
 					  state->playback.rate);
@@ -1561,12 +1561,15 @@ static bool test_audio_frequencies(struct audio_state *state)
 	 * sines. For lower sampling rates, the capture duration will be
 	 * longer.
 	 */
-	channel_len = CAPTURE_SAMPLES;
-	channel = malloc(sizeof(double) * channel_len);
-
-	buf_cap = state->capture.channels * channel_len;
-	buf = malloc(sizeof(int32_t) * buf_cap);
-	buf_len = 0;
+	det = audio_signal_detector_init(state->signal, state->capture.rate,
+					 state->playback.channels,
+					 CAPTURE_SAMPLES, CAPTURE_SAMPLES);
+
+	for (j = 0; j < state->playback.channels; j++) {
+		igt_assert(state->channel_mapping[j] >= 0);
+		igt_debug("Processing channel %zu (captured as channel %d)\n",
+			  j, state->channel_mapping[j]);
+	}
 
 	recv = NULL;
 	recv_len = 0;
@@ -1576,44 +1579,34 @@ static bool test_audio_frequencies(struct audio_state *state)
 	while (!success && state->msec < AUDIO_TIMEOUT) {
 		audio_state_receive(state, &recv, &recv_len);
 
-		memcpy(&buf[buf_len], recv, recv_len * sizeof(int32_t));
-		buf_len += recv_len;
-
-		if (buf_len < buf_cap)
-			continue;
-		igt_assert(buf_len == buf_cap);
+		consumed = 0;
+		while (!success && consumed < recv_len) {
+			consumed += audio_signal_detector_push_s32_le(det,
+					&recv[consumed], recv_len - consumed,
+					state->capture.channels,
+					state->channel_mapping);
+			if (!audio_signal_detector_ready(det))
+				continue;
 
-		igt_debug("Detecting audio signal, t=%d msec\n", state->msec);
+			igt_debug("Detecting audio signal, t=%d msec\n",
+				  state->msec);
 
-		for (j = 0; j < state->playback.channels; j++) {
-			capture_chan = state->channel_mapping[j];
-			igt_assert(capture_chan >= 0);
-			igt_debug("Processing channel %zu (captured as "
-				  "channel %d)\n", j, capture_chan);
-
-			audio_extract_channel_s32_le(channel, channel_len,
-						     buf, buf_len,
-						     state->capture.channels,
-						     capture_chan);
+			audio_signal_detector_detect(det, detected);
+			for (j = 0; j < state->playback.channels; j++) {
+				if (detected[j])
+					streak++;
+				else
+					streak = 0;
+			}
 
-			if (audio_signal_detect(state->signal,
-						state->capture.rate, j,
-						channel, channel_len))
-				streak++;
-			else
-				streak = 0;
+			success = streak == MIN_STREAK * state->playback.channels;
 		}
-
-		buf_len = 0;
-
-		success = streak == MIN_STREAK * state->playback.channels;
 	}
 
 	audio_state_stop(state, success);
 
 	free(recv);
-	free(buf);
-	free(channel);
+	audio_signal_detector_fini(det);
 	audio_signal_fini(state->signal);
 
 	check_audio_infoframe(state);
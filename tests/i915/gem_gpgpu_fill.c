@@ -45,6 +45,7 @@
 #include "drm.h"
 #include "i915/gem.h"
 #include "igt.h"
+#include "igt_ref.h"
 #include "igt_collection.h"
 #include "intel_bufops.h"
 #include "i915/intel_memory_region.h"
@@ -93,38 +94,40 @@ create_buf(data_t *data, int width, int height, uint8_t color, uint32_t region)
 	return buf;
 }
 
-static void buf_check(uint8_t *ptr, int x, int y, uint8_t color)
+static void buf_check(uint8_t *ptr, int x, int y, int width, int height,
+		      uint8_t color)
 {
-	uint8_t val;
-
-	val = ptr[y * WIDTH + x];
-	igt_assert_f(val == color,
+	struct igt_ref_surface s = {
+		.ptr = ptr,
+		.stride = WIDTH,
+		.cpp = 1,
+		.width = WIDTH,
+		.height = HEIGHT,
+	};
+	unsigned int bad_x, bad_y;
+
+	igt_assert_f(!igt_ref_check_fill(&s, x, y, width, height, &color,
+					 &bad_x, &bad_y),
 		     "Expected 0x%02x, found 0x%02x at (%d,%d)\n",
-		     color, val, x, y);
+		     color, ptr[bad_y * WIDTH + bad_x], bad_x, bad_y);
 }
 
 static void gpgpu_fill(data_t *data, igt_fillfunc_t fill, uint32_t region)
 {
 	struct intel_buf *buf;
 	uint8_t *ptr;
-	int i, j;
 
 	buf = create_buf(data, WIDTH, HEIGHT, COLOR_C4, region);
 	ptr = gem_mmap__device_coherent(data->drm_fd, buf->handle, 0,
 					buf->surface[0].size, PROT_READ);
 
-	for (i = 0; i < WIDTH; i++)
-		for (j = 0; j < HEIGHT; j++)
-			buf_check(ptr, i, j, COLOR_C4);
+	buf_check(ptr, 0, 0, WIDTH, HEIGHT, COLOR_C4);
 
 	fill(data->drm_fd, buf, 0, 0, WIDTH / 2, HEIGHT / 2, COLOR_4C);
 
-	for (i = 0; i < WIDTH; i++)
-		for (j = 0; j < HEIGHT; j++)
-			if (i < WIDTH / 2 && j < HEIGHT / 2)
-				buf_check(ptr, i, j, COLOR_4C);
-			else
-				buf_check(ptr, i, j, COLOR_C4);
+	buf_check(ptr, 0, 0, WIDTH / 2, HEIGHT / 2, COLOR_4C);
+	buf_check(ptr, WIDTH / 2, 0, WIDTH / 2, HEIGHT / 2, COLOR_C4);
+	buf_check(ptr, 0, HEIGHT / 2, WIDTH, HEIGHT / 2, COLOR_C4);
 
 	munmap(ptr, buf->surface[0].size);
 }
@@ -46,6 +46,7 @@
 
 #include "i915/gem.h"
 #include "igt.h"
+#include "igt_ref.h"
 #include "igt_x86.h"
 #include "intel_bufops.h"
 
@@ -194,6 +195,25 @@ scratch_buf_copy(data_t *data,
 	h = min(h, height - sy);
 	h = min(h, height - dy);
 
+	/* Straight into the layout of dst, without converting either */
+	if (igt_ref_intel_buf_supported(src) &&
+	    igt_ref_intel_buf_supported(dst)) {
+		struct igt_ref_surface s, d;
+
+		intel_buf_device_map(src, false);
+		intel_buf_device_map(dst, true);
+		igt_ref_surface_init_intel_buf(&s, src);
+		igt_ref_surface_init_intel_buf(&d, dst);
+
+		igt_ref_copy(&d, dx, dy, &s, sx, sy, w, h);
+
+		igt_ref_surface_fini(&d);
+		igt_ref_surface_fini(&s);
+		intel_buf_unmap(dst);
+		intel_buf_unmap(src);
+		return;
+	}
+
 	linear_dst = alloc_aligned(intel_buf_size(dst));
 	linear_src = alloc_aligned(intel_buf_size(src));
 	intel_buf_to_linear(data->bops, src, linear_src);
@@ -272,6 +292,35 @@ scratch_buf_check_all(data_t *data,
 	igt_assert_eq(intel_buf_height(buf), intel_buf_height(ref));
 	igt_assert_eq(buf->surface[0].size, ref->surface[0].size);
 
+	if (igt_ref_intel_buf_supported(buf) &&
+	    igt_ref_intel_buf_supported(ref)) {
+		struct igt_ref_surface b, r;
+		uint32_t buf_val = 0, ref_val = 0;
+		unsigned int x, y;
+		bool differ;
+
+		intel_buf_device_map(buf, false);
+		intel_buf_device_map(ref, false);
+		igt_ref_surface_init_intel_buf(&b, buf);
+		igt_ref_surface_init_intel_buf(&r, ref);
+
+		differ = igt_ref_compare(&b, &r, 0, 0, width, height, &x, &y);
+		if (differ) {
+			igt_ref_get_pixel(&b, x, y, &buf_val);
+			igt_ref_get_pixel(&r, x, y, &ref_val);
+		}
+
+		igt_ref_surface_fini(&r);
+		igt_ref_surface_fini(&b);
+		intel_buf_unmap(ref);
+		intel_buf_unmap(buf);
+
+		igt_assert_f(!differ,
+			     "Expected 0x%08x, found 0x%08x at (%d,%d)\n",
+			     ref_val, buf_val, x, y);
+		return;
+	}
+
 	linear_buf = alloc_aligned(buf->surface[0].size);
 	linear_ref = alloc_aligned(ref->surface[0].size);
 	intel_buf_to_linear(data->bops, buf, linear_buf);
@@ -0,0 +1,352 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "drmtest.h"
+#include "igt_codec.h"
+#include "intel_error_blob.h"
+
+struct buffer {
+	void *ptr;
+	size_t size;
+};
+
+/* Per worker, reused from one blob to the next */
+struct scratch {
+	uint32_t chunk[16384]; /* ascii85 decoded on its way into inflate() */
+	struct buffer inflated;
+};
+
+struct error_blob_pool {
+	pthread_mutex_t mutex;
+	pthread_cond_t queued;
+	pthread_cond_t done;
+	struct error_blob *head, **tail;
+	struct scratch scratch; /* for decoding inline without threads */
+	bool quit;
+	unsigned int nthreads;
+	pthread_t threads[];
+};
+
+static bool buffer_reserve(struct buffer *b, size_t size)
+{
+	void *ptr;
+
+	if (size <= b->size)
+		return true;
+
+	ptr = realloc(b->ptr, size);
+	if (!ptr)
+		return false;
+
+	b->ptr = ptr;
+	b->size = size;
+	return true;
+}
+
+static void scratch_fini(struct scratch *scratch)
+{
+	free(scratch->inflated.ptr);
+}
+
+/*
+ * Decodes the ascii85 a chunk at a time straight into inflate(), which
+ * writes to the scratch buffer, only ever growing, and copies the result
+ * out once its size is known.
+ */
+static int zlib_inflate(const char *in, const char *end,
+			uint32_t **out, struct scratch *scratch)
+{
+	struct z_stream_s zstream;
+
+	memset(&zstream, 0, sizeof(zstream));
+
+	if (inflateInit(&zstream) != Z_OK)
+		return 0;
+
+	if (!buffer_reserve(&scratch->inflated, 128*4096)) { /* approximate obj size */
+		inflateEnd(&zstream);
+		return 0;
+	}
+	zstream.next_out = scratch->inflated.ptr;
+	zstream.avail_out = scratch->inflated.size;
+
+	do {
+		if (!zstream.avail_out) {
+			if (!buffer_reserve(&scratch->inflated,
+					    2*scratch->inflated.size)) {
+				inflateEnd(&zstream);
+				return 0;
+			}
+
+			zstream.next_out = (unsigned char *)scratch->inflated.ptr + zstream.total_out;
+			zstream.avail_out = scratch->inflated.size - zstream.total_out;
+		} else if (!zstream.avail_in) {
+			size_t count = igt_ascii85_decode(&in, end, scratch->chunk,
+							  ARRAY_SIZE(scratch->chunk));
+
+			if (!count) /* a truncated stream ends with its input */
+				break;
+
+			zstream.next_in = (unsigned char *)scratch->chunk;
+			zstream.avail_in = 4*count;
+		}
+
+		switch (inflate(&zstream, Z_SYNC_FLUSH)) {
+		case Z_STREAM_END:
+			goto end;
+		case Z_OK:
+		case Z_BUF_ERROR: /* needs more input or more space */
+			break;
+		default:
+			inflateEnd(&zstream);
+			return 0;
+		}
+	} while (1);
+end:
+	inflateEnd(&zstream);
+
+	*out = malloc(zstream.total_out);
+	if (!*out)
+		return 0;
+
+	memcpy(*out, scratch->inflated.ptr, zstream.total_out);
+	return zstream.total_out / 4;
+}
+
+static void decode_blob(struct error_blob *blob, struct scratch *scratch)
+{
+	const char *in = blob->in, *end = in + blob->len;
+
+	if (blob->inflate) {
+		blob->count = zlib_inflate(in, end, &blob->data, scratch);
+	} else {
+		size_t count = igt_ascii85_length(in, blob->len);
+
+		if (!count)
+			return;
+
+		blob->data = malloc(4*count);
+		if (!blob->data)
+			return;
+
+		blob->count = igt_ascii85_decode(&in, end, blob->data, count);
+	}
+
+	if (blob->count && blob->want_dump) {
+		FILE *f = open_memstream(&blob->dump, &blob->dump_size);
+
+		if (f) {
+			error_blob_print(f, blob->data, blob->count);
+			fclose(f);
+		}
+	}
+}
+
+static void *worker(void *arg)
+{
+	struct error_blob_pool *pool = arg;
+	struct scratch scratch = {};
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		struct error_blob *blob;
+
+		while (!pool->head && !pool->quit)
+			pthread_cond_wait(&pool->queued, &pool->mutex);
+		if (!pool->head)
+			break;
+
+		blob = pool->head;
+		pool->head = blob->next;
+		if (!pool->head)
+			pool->tail = &pool->head;
+		pthread_mutex_unlock(&pool->mutex);
+
+		decode_blob(blob, &scratch);
+
+		pthread_mutex_lock(&pool->mutex);
+		blob->done = true;
+		pthread_cond_broadcast(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	scratch_fini(&scratch);
+	return NULL;
+}
+
+/**
+ * error_blob_pool_create:
+ * @nthreads: number of worker threads
+ *
+ * Creates the pool decoding the submitted blobs. With no threads, or if
+ * none could be started, blobs are decoded as they are submitted.
+ */
+struct error_blob_pool *error_blob_pool_create(unsigned int nthreads)
+{
+	struct error_blob_pool *pool;
+
+	pool = calloc(1, sizeof(*pool) + nthreads * sizeof(pool->threads[0]));
+	if (!pool)
+		return NULL;
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->queued, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->tail = &pool->head;
+
+	for (pool->nthreads = 0; pool->nthreads < nthreads; pool->nthreads++)
+		if (pthread_create(&pool->threads[pool->nthreads], NULL,
+				   worker, pool))
+			break;
+
+	return pool;
+}
+
+/**
+ * error_blob_pool_destroy:
+ * @pool: the pool
+ *
+ * Waits for the outstanding blobs to be decoded and stops the workers.
+ * The blobs themselves are still to be freed by the caller.
+ */
+void error_blob_pool_destroy(struct error_blob_pool *pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->queued);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (unsigned int i = 0; i < pool->nthreads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->queued);
+	pthread_mutex_destroy(&pool->mutex);
+	scratch_fini(&pool->scratch);
+	free(pool);
+}
+
+/**
+ * error_blob_submit:
+ * @pool: the pool
+ * @in: ascii85 text, following the ':' or '~' marker
+ * @len: length of @in
+ * @inflate: whether the decoded data is to be inflated
+ * @dump: whether to preformat the decoded data with error_blob_print()
+ *
+ * Queues @in for decoding. @in must stay valid until error_blob_wait()
+ * has returned for the blob.
+ *
+ * Returns: the blob, or NULL if out of memory.
+ */
+struct error_blob *error_blob_submit(struct error_blob_pool *pool,
+				     const char *in, size_t len,
+				     bool inflate, bool dump)
+{
+	struct error_blob *blob;
+
+	blob = calloc(1, sizeof(*blob));
+	if (!blob)
+		return NULL;
+
+	blob->in = in;
+	blob->len = len;
+	blob->inflate = inflate;
+	blob->want_dump = dump;
+
+	if (!pool->nthreads) {
+		decode_blob(blob, &pool->scratch);
+		blob->done = true;
+		return blob;
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	*pool->tail = blob;
+	pool->tail = &blob->next;
+	pthread_cond_signal(&pool->queued);
+	pthread_mutex_unlock(&pool->mutex);
+
+	return blob;
+}
+
+/**
+ * error_blob_wait:
+ * @pool: the pool
+ * @blob: a blob submitted to @pool
+ *
+ * Waits for @blob to be decoded.
+ */
+void error_blob_wait(struct error_blob_pool *pool, struct error_blob *blob)
+{
+	pthread_mutex_lock(&pool->mutex);
+	while (!blob->done)
+		pthread_cond_wait(&pool->done, &pool->mutex);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void error_blob_free(struct error_blob *blob)
+{
+	if (!blob)
+		return;
+
+	free(blob->data);
+	free(blob->dump);
+	free(blob);
+}
+
+static bool maybe_ascii(const void *data, int check)
+{
+	const char *c = data;
+	while (check--) {
+		if (!isprint(*c++))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * error_blob_print:
+ * @out: stream to print to
+ * @data: buffer contents
+ * @count: number of dwords in @data
+ *
+ * Prints a buffer that is not decoded as commands, either as text or as
+ * a hexdump.
+ */
+void error_blob_print(FILE *out, const uint32_t *data, int count)
+{
+	if (maybe_ascii(data, count < 4 ? 4 * count : 16)) {
+		fprintf(out, "%.*s\n", 4 * count, (const char *)data);
+	} else {
+		for (int i = 0; i + 4 <= count; i += 4)
+			fprintf(out, "[%04x] %08x %08x %08x %08x\n",
+				4*i, data[i], data[i+1], data[i+2], data[i+3]);
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#ifndef INTEL_ERROR_BLOB_H
+#define INTEL_ERROR_BLOB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Buffer contents are dumped into the error state as a single line of
+ * ascii85, prefixed with ':' if the data was deflated and '~' if not.
+ * Decoding those lines dominates the time taken to read a large error
+ * state, so they are handed to a pool of worker threads as soon as they
+ * are read, and picked up again in dump order once the decoder gets to
+ * them.
+ */
+
+struct error_blob {
+	/* Decoded buffer, exactly count dwords; count is 0 on failure */
+	uint32_t *data;
+	int count;
+
+	/* Preformatted error_blob_print() output, if it was asked for */
+	char *dump;
+	size_t dump_size;
+
+	/* private */
+	const char *in;
+	size_t len;
+	bool inflate;
+	bool want_dump;
+	bool done;
+	struct error_blob *next;
+};
+
+struct error_blob_pool;
+
+struct error_blob_pool *error_blob_pool_create(unsigned int nthreads);
+void error_blob_pool_destroy(struct error_blob_pool *pool);
+
+struct error_blob *error_blob_submit(struct error_blob_pool *pool,
+				     const char *in, size_t len,
+				     bool inflate, bool dump);
+void error_blob_wait(struct error_blob_pool *pool, struct error_blob *blob);
+void error_blob_free(struct error_blob *blob);
+
+void error_blob_print(FILE *out, const uint32_t *data, int count);
+
+#endif /* INTEL_ERROR_BLOB_H */
@@ -50,14 +50,13 @@
 #include <err.h>
 #include <assert.h>
 #include <intel_bufmgr.h>
-#include <zlib.h>
-#include <ctype.h>
 
 #include "intel_chipset.h"
 #include "intel_io.h"
 #include "instdone.h"
 #include "intel_reg.h"
 #include "drmtest.h"
+#include "intel_error_blob.h"
 
 static uint32_t
 print_head(unsigned int reg)
@@ -435,14 +434,51 @@ print_fault_data(unsigned devid, uint32_t data1, uint32_t data0)
 
 #define MAX_RINGS 10 /* I really hope this never... */
 
-static bool maybe_ascii(const void *data, int check)
+static const struct buffer_type {
+	const char *match;
+	const char *name;
+	int do_decode;
+} buffers[] = {
+	{ "ring", "ring", 1 },
+	{ "batch", "batch", 1 },
+	{ "ringbuffer", "ring", 1 },
+	{ "gtt_offset", "batch", 1 },
+	{ "NULL context", "NULL context", 0 },
+	{ "hw context", "HW context", 1 },
+	{ "hw status", "HW status", 0 },
+	{ "wa context", "WA context", 1 },
+	{ "wa batchbuffer", "WA batch", 1 },
+	{ "user", "user", 0 },
+	{ "semaphores", "semaphores", 0 },
+	{ "guc log buffer", "GuC log", 0 },
+	{ },
+};
+
+static const struct buffer_type *find_buffer(const char *name)
 {
-	const char *c = data;
-	while (check--) {
-		if (!isprint(*c++))
-			return false;
+	const struct buffer_type *b;
+
+	for (b = buffers; b->match; b++) {
+		if (!strncasecmp(name, b->match, strlen(b->match)))
+			return b;
 	}
-	return true;
+
+	return NULL;
+}
+
+static void print_buffer_header(const char *buffer_name,
+				const char *ring_name,
+				uint64_t gtt_offset,
+				uint32_t head_offset)
+{
+	printf("%s (%s) at 0x%08x_%08x", buffer_name, ring_name,
+	       (unsigned)(gtt_offset >> 32),
+	       (unsigned)(gtt_offset & 0xffffffff));
+	if (head_offset != -1)
+		printf("; HEAD points to: 0x%08x_%08x",
+		       (unsigned)((head_offset + gtt_offset) >> 32),
+		       (unsigned)((head_offset + gtt_offset) & 0xffffffff));
+	printf("\n");
 }
 
 static void decode(struct drm_intel_decode *ctx,
@@ -456,111 +492,192 @@ static void decode(struct drm_intel_decode *ctx,
 	if (!*count)
 		return;
 
-	printf("%s (%s) at 0x%08x_%08x", buffer_name, ring_name,
-	       (unsigned)(gtt_offset >> 32),
-	       (unsigned)(gtt_offset & 0xffffffff));
-	if (head_offset != -1)
-		printf("; HEAD points to: 0x%08x_%08x",
-		       (unsigned)((head_offset + gtt_offset) >> 32),
-		       (unsigned)((head_offset + gtt_offset) & 0xffffffff));
-	printf("\n");
+	print_buffer_header(buffer_name, ring_name, gtt_offset, head_offset);
 
 	if (decode && ctx) {
 		drm_intel_decode_set_batch_pointer(ctx, data, gtt_offset,
 						   *count);
 		drm_intel_decode(ctx);
-	} else if (maybe_ascii(data, 16)) {
-		printf("%*s\n", 4 * *count, (char *)data);
 	} else {
-		for (int i = 0; i + 4 <= *count; i += 4)
-			printf("[%04x] %08x %08x %08x %08x\n",
-			       4*i, data[i], data[i+1], data[i+2], data[i+3]);
+		error_blob_print(stdout, data, *count);
 	}
 	*count = 0;
 }
 
-static int zlib_inflate(uint32_t **ptr, int len)
+/*
+ * As decode(), but for a buffer decoded by the worker pool, which has
+ * also formatted its dump if the buffer is not decoded as commands.
+ */
+static void decode_blob(struct drm_intel_decode *ctx,
+			const char *buffer_name,
+			const char *ring_name,
+			uint64_t gtt_offset,
+			uint32_t head_offset,
+			struct error_blob *blob,
+			int do_decode)
 {
-	struct z_stream_s zstream;
-	void *out;
-
-	memset(&zstream, 0, sizeof(zstream));
-
-	zstream.next_in = (unsigned char *)*ptr;
-	zstream.avail_in = 4*len;
-
-	if (inflateInit(&zstream) != Z_OK)
-		return 0;
-
-	out = malloc(128*4096); /* approximate obj size */
-	zstream.next_out = out;
-	zstream.avail_out = 128*4096;
-
-	do {
-		switch (inflate(&zstream, Z_SYNC_FLUSH)) {
-		case Z_STREAM_END:
-			goto end;
-		case Z_OK:
-			break;
-		default:
-			inflateEnd(&zstream);
-			return 0;
-		}
+	if (blob->dump && !(do_decode && ctx)) {
+		print_buffer_header(buffer_name, ring_name,
+				    gtt_offset, head_offset);
+		fwrite(blob->dump, 1, blob->dump_size, stdout);
+		return;
+	}
 
-		if (zstream.avail_out)
-			break;
+	decode(ctx, buffer_name, ring_name, gtt_offset, head_offset,
+	       blob->data, &blob->count, do_decode);
+}
 
-		out = realloc(out, 2*zstream.total_out);
-		if (out == NULL) {
-			inflateEnd(&zstream);
-			return 0;
-		}
+/*
+ * The reader runs ahead of the decoder, handing each buffer to the worker
+ * pool as soon as its line is read, so that the buffers are decoded in
+ * parallel and are usually ready by the time the decoder reaches them.
+ * The lines are still returned in order, and the read ahead is bounded
+ * both in buffers and in bytes.
+ */
+#define READ_AHEAD_BYTES (128 << 20)
+
+struct pending_line {
+	char *line;
+	size_t len;
+	struct error_blob *blob;
+};
+
+struct reader {
+	FILE *file;
+	struct error_blob_pool *pool;
+
+	struct pending_line *pending;
+	unsigned int head, tail, size;
+	unsigned int blobs, max_blobs;
+	size_t bytes;
+
+	struct pending_line current;
+	int do_decode;
+	bool eof;
+};
+
+static void reader_init(struct reader *r, FILE *file)
+{
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	memset(r, 0, sizeof(*r));
+	r->file = file;
+	r->do_decode = 1;
+
+	if (ncpus < 1)
+		ncpus = 1;
+	r->pool = error_blob_pool_create(ncpus);
+	if (!r->pool) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+	r->max_blobs = 2 * ncpus;
+}
+
+static void reader_fini(struct reader *r)
+{
+	while (r->head != r->tail) {
+		struct pending_line *p = &r->pending[r->head++ & (r->size - 1)];
+
+		if (p->blob)
+			error_blob_wait(r->pool, p->blob);
+		error_blob_free(p->blob);
+		free(p->line);
+	}
+
+	error_blob_free(r->current.blob);
+	free(r->current.line);
+	free(r->pending);
 
-		zstream.next_out = (unsigned char *)out + zstream.total_out;
-		zstream.avail_out = zstream.total_out;
-	} while (1);
-end:
-	inflateEnd(&zstream);
-	free(*ptr);
-	*ptr = out;
-	return zstream.total_out / 4;
+	error_blob_pool_destroy(r->pool);
 }
 
-static int ascii85_decode(const char *in, uint32_t **out, bool inflate)
+static void read_ahead(struct reader *r)
 {
-	int len = 0, size = 1024;
+	const struct buffer_type *b;
+	struct pending_line *p;
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
 
-	*out = realloc(*out, sizeof(uint32_t)*size);
-	if (*out == NULL)
-		return 0;
+	len = getline(&line, &size, r->file);
+	if (len <= 0) {
+		free(line);
+		r->eof = true;
+		return;
+	}
 
-	while (*in >= '!' && *in <= 'z') {
-		uint32_t v = 0;
+	if (r->tail - r->head == r->size) {
+		unsigned int count = r->tail - r->head;
+		unsigned int new_size = r->size ? 2 * r->size : 64;
+		struct pending_line *pending;
 
-		if (len == size) {
-			size *= 2;
-			*out = realloc(*out, sizeof(uint32_t)*size);
-			if (*out == NULL)
-				return 0;
+		pending = malloc(new_size * sizeof(*pending));
+		if (pending == NULL) {
+			fprintf(stderr, "Out of memory.\n");
+			exit(1);
 		}
 
-		if (*in == 'z') {
-			in++;
-		} else {
-			v += in[0] - 33; v *= 85;
-			v += in[1] - 33; v *= 85;
-			v += in[2] - 33; v *= 85;
-			v += in[3] - 33; v *= 85;
-			v += in[4] - 33;
-			in += 5;
-		}
-		(*out)[len++] = v;
+		for (unsigned int i = 0; i < count; i++)
+			pending[i] = r->pending[(r->head + i) & (r->size - 1)];
+
+		free(r->pending);
+		r->pending = pending;
+		r->size = new_size;
+		r->head = 0;
+		r->tail = count;
 	}
 
-	if (!inflate)
-		return len;
+	p = &r->pending[r->tail++ & (r->size - 1)];
+	p->line = line;
+	p->len = len;
+	p->blob = NULL;
+	r->bytes += len;
+
+	if (line[0] == ':' || line[0] == '~') {
+		/* Only the dump of buffers not decoded as commands is
+		 * preformatted, following read_data_file() */
+		p->blob = error_blob_submit(r->pool, line + 1, len - 1,
+					    line[0] == ':', !r->do_decode);
+		r->blobs++;
+		return;
+	}
 
-	return zlib_inflate(out, len);
+	line = strstr(line, "---");
+	if (line) {
+		line += 4;
+		b = find_buffer(line);
+		if (b && strchr(line, '='))
+			r->do_decode = b->do_decode;
+	}
+}
+
+static char *reader_next(struct reader *r, struct error_blob **blob)
+{
+	struct pending_line *p;
+
+	error_blob_free(r->current.blob);
+	free(r->current.line);
+	memset(&r->current, 0, sizeof(r->current));
+
+	while (!r->eof &&
+	       (r->head == r->tail ||
+		(r->blobs < r->max_blobs && r->bytes < READ_AHEAD_BYTES)))
+		read_ahead(r);
+
+	if (r->head == r->tail)
+		return NULL;
+
+	p = &r->pending[r->head++ & (r->size - 1)];
+	r->bytes -= p->len;
+	if (p->blob) {
+		r->blobs--;
+		error_blob_wait(r->pool, p->blob);
+	}
+
+	r->current = *p;
+	*blob = p->blob;
+	return p->line;
 }
 
 static void
@@ -570,12 +687,13 @@ read_data_file(FILE *file)
 	uint32_t devid = PCI_CHIP_I855_GM;
 	uint32_t *data = NULL;
 	uint32_t head[MAX_RINGS];
+	struct error_blob *blob;
+	struct reader reader;
 	int head_idx = 0;
 	int num_rings = 0;
 	long long unsigned fence;
 	int data_size = 0, count = 0, matched;
-	char *line = NULL;
-	size_t line_size;
+	char *line;
 	uint32_t offset, value, ring_length = 0;
 	uint64_t gtt_offset = 0;
 	uint32_t head_offset = -1;
@@ -583,42 +701,27 @@ read_data_file(FILE *file)
 	char *ring_name = NULL;
 	int do_decode = 1;
 
-	while (getline(&line, &line_size, file) > 0) {
+	reader_init(&reader, file);
+
+	while ((line = reader_next(&reader, &blob))) {
 		char *dashes;
 
 		if (line[0] == ':' || line[0] == '~') {
-			count = ascii85_decode(line+1, &data, line[0] == ':');
-			if (count == 0)
+			if (!blob || blob->count == 0) {
 				fprintf(stderr, "ASCII85 decode failed (%s - %s).\n",
 					ring_name, buffer_name);
-			decode(decode_ctx,
-			       buffer_name, ring_name,
-			       gtt_offset, head_offset,
-			       data, &count, do_decode);
+				continue;
+			}
+			decode_blob(decode_ctx,
+				    buffer_name, ring_name,
+				    gtt_offset, head_offset,
+				    blob, do_decode);
 			continue;
 		}
 
 		dashes = strstr(line, "---");
 		if (dashes) {
-			const struct {
-				const char *match;
-				const char *name;
-				int do_decode;
-			} buffers[] = {
-				{ "ring", "ring", 1 },
-				{ "batch", "batch", 1 },
-				{ "ringbuffer", "ring", 1 },
-				{ "gtt_offset", "batch", 1 },
-				{ "NULL context", "NULL context", 0 },
-				{ "hw context", "HW context", 1 },
-				{ "hw status", "HW status", 0 },
-				{ "wa context", "WA context", 1 },
-				{ "wa batchbuffer", "WA batch", 1 },
-				{ "user", "user", 0 },
-				{ "semaphores", "semaphores", 0 },
-				{ "guc log buffer", "GuC log", 0 },
-				{ },
-			}, *b;
+			const struct buffer_type *b;
 			char *new_ring_name;
 
 			new_ring_name = malloc(dashes - line);
@@ -636,16 +739,13 @@ read_data_file(FILE *file)
 			ring_name = new_ring_name;
 
 			dashes += 4;
-			for (b = buffers; b->match; b++) {
+			b = find_buffer(dashes);
+			if (b) {
 				uint32_t lo, hi;
 
-				if (strncasecmp(dashes, b->match,
-						strlen(b->match)))
-					continue;
-
 				dashes = strchr(dashes, '=');
 				if (!dashes)
-					break;
+					continue;
 
 				matched = sscanf(dashes, "= 0x%08x %08x\n",
 						 &hi, &lo);
@@ -661,7 +761,6 @@ read_data_file(FILE *file)
 				buffer_name = b->name;
 				if (b == buffers)
 					head_offset = head[head_idx++];
-				break;
 			}
 
 			continue;
@@ -763,8 +862,8 @@ read_data_file(FILE *file)
 	       gtt_offset, head_offset,
 	       data, &count, do_decode);
 
+	reader_fini(&reader);
 	free(data);
-	free(line);
 	free(ring_name);
 }
 
@@ -83,6 +83,9 @@ struct config {
 	struct reg *regs;
 	ssize_t regcount;
 
+	/* precompiled register spec, regs are only loaded on demand */
+	struct reg_db *db;
+
 	int verbosity;
 };
 
@@ -97,6 +100,19 @@ static int set_reg_by_addr(struct config *config, struct reg *reg,
 		free(reg->name);
 	reg->name = NULL;
 
+	if (config->db) {
+		struct reg r;
+
+		if (intel_reg_db_find_addr(config->db, reg->port_desc.port,
+					   addr + reg->mmio_offset, &r) == 0) {
+			reg->mmio_offset = r.mmio_offset;
+			reg->addr = r.addr;
+			reg->name = strdup(r.name);
+		}
+
+		return 0;
+	}
+
 	for (i = 0; i < config->regcount; i++) {
 		struct reg *r = &config->regs[i];
 
@@ -126,6 +142,20 @@ static int set_reg_by_name(struct config *config, struct reg *reg,
 	reg->name = strdup(name);
 	reg->addr = 0;
 
+	if (config->db) {
+		struct reg r;
+
+		if (intel_reg_db_find_name(config->db, reg->port_desc.port,
+					   name, &r))
+			return -1;
+
+		reg->addr = r.addr;
+		if (!reg->mmio_offset && r.mmio_offset)
+			reg->mmio_offset = r.mmio_offset;
+
+		return 0;
+	}
+
 	for (i = 0; i < config->regcount; i++) {
 		struct reg *r = &config->regs[i];
 
@@ -616,11 +646,26 @@ static int intel_reg_write(struct config *config, int argc, char *argv[])
 	return EXIT_SUCCESS;
 }
 
+/*
+ * Get all register definitions, for commands walking the whole spec rather
+ * than looking registers up.
+ */
+static int load_regs(struct config *config)
+{
+	if (config->db && !config->regs)
+		config->regcount = intel_reg_db_regs(config->db, &config->regs);
+
+	return config->regcount < 0 ? -1 : 0;
+}
+
 static int intel_reg_dump(struct config *config, int argc, char *argv[])
 {
 	struct reg *reg;
 	int i;
 
+	if (load_regs(config))
+		return EXIT_FAILURE;
+
 	if (config->mmiofile)
 		intel_mmio_use_dump_file(&config->mmio_data, config->mmiofile);
 	else
@@ -703,6 +748,9 @@ static int intel_reg_list(struct config *config, int argc, char *argv[])
 {
 	int i;
 
+	if (load_regs(config))
+		return EXIT_FAILURE;
+
 	for (i = 0; i < config->regcount; i++) {
 		printf("%s\n", config->regs[i].name);
 	}
@@ -848,6 +896,49 @@ static int get_reg_spec_file(char *buf, size_t buflen, const char *dir,
 	return -ENOENT;
 }
 
+/*
+ * Map the precompiled register spec, either given directly or built next to
+ * the spec file. A database is ignored if the spec file, or any file it
+ * includes, has been edited since it was compiled. Return 0 if found,
+ * negative error code otherwise.
+ */
+static int read_reg_db(struct config *config, const char *path)
+{
+	char buf[PATH_MAX];
+	const char *stale;
+	int ret;
+
+	config->db = intel_reg_db_open(path);
+	if (config->db)
+		return 0;
+
+	if (snprintf(buf, sizeof(buf), "%s" REG_DB_SUFFIX, path) >= sizeof(buf))
+		return -ENAMETOOLONG;
+
+	config->db = intel_reg_db_open(buf);
+	if (!config->db) {
+		if (access(buf, F_OK) == 0)
+			fprintf(stderr, "Warning: ignoring '%s', not a "
+				"compatible register database.\n", buf);
+		return -ENOENT;
+	}
+
+	ret = intel_reg_db_check_sources(config->db, path, &stale);
+	if (ret) {
+		if (ret == -ESTALE)
+			fprintf(stderr, "Warning: ignoring '%s', '%s' changed "
+				"since it was compiled.\n", buf, stale);
+		else
+			fprintf(stderr, "Warning: ignoring '%s', reading "
+				"'%s' failed: %s.\n", buf, stale,
+				strerror(-ret));
+		intel_reg_db_close(config->db);
+		config->db = NULL;
+	}
+
+	return ret;
+}
+
 /*
  * Read register spec.
  */
@@ -883,6 +974,9 @@ static int read_reg_spec(struct config *config)
 		path = buf;
 	}
 
+	if (read_reg_db(config, path) == 0)
+		return 0;
+
 	config->regcount = intel_reg_spec_file(&config->regs, path);
 	if (config->regcount <= 0) {
 		fprintf(stderr, "Warning: reading '%s' failed. "
@@ -1049,6 +1143,7 @@ int main(int argc, char *argv[])
 	ret = command->function(&config, argc, argv);
 
 	free(config.mmiofile);
+	intel_reg_db_close(config.db);
 
 	if (config.fd >= 0)
 		close(config.fd);
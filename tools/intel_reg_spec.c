@@ -29,6 +29,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "intel_reg_spec.h"
 
@@ -248,8 +254,62 @@ static int parse_line(struct reg *reg, const char *line)
 	return ret;
 }
 
+struct spec_sources {
+	struct reg_spec_source *sources;
+	size_t count;
+};
+
+/*
+ * FNV-1a of the contents of a source, so that a database stays valid across
+ * installs and checkouts that only change modification times.
+ */
+static int hash_source(int fd, uint64_t *size, uint64_t *hash)
+{
+	char buf[4096];
+	ssize_t len, i;
+
+	*size = 0;
+	*hash = 14695981039346656037ull;
+
+	while ((len = pread(fd, buf, sizeof(buf), *size)) > 0) {
+		for (i = 0; i < len; i++) {
+			*hash ^= (unsigned char)buf[i];
+			*hash *= 1099511628211ull;
+		}
+		*size += len;
+	}
+
+	return len < 0 ? -1 : 0;
+}
+
+static int add_source(struct spec_sources *s, const char *filename, FILE *file)
+{
+	struct reg_spec_source *tmp;
+	uint64_t size, hash;
+
+	if (hash_source(fileno(file), &size, &hash))
+		return -1;
+
+	tmp = realloc(s->sources, (s->count + 1) * sizeof(*tmp));
+	if (!tmp)
+		return -1;
+	s->sources = tmp;
+
+	tmp = &s->sources[s->count];
+	tmp->filename = strdup(filename);
+	tmp->size = size;
+	tmp->hash = hash;
+	if (!tmp->filename)
+		return -1;
+
+	s->count++;
+
+	return 0;
+}
+
 static ssize_t parse_file(struct reg **regs, size_t *nregs,
-			  ssize_t index, const char *filename)
+			  ssize_t index, const char *filename,
+			  struct spec_sources *sources)
 {
 	FILE *file;
 	char *line = NULL, *include;
@@ -264,6 +324,11 @@ static ssize_t parse_file(struct reg **regs, size_t *nregs,
 		return -1;
 	}
 
+	if (sources && add_source(sources, filename, file)) {
+		fprintf(stderr, "Error: %s: %s\n", filename, strerror(errno));
+		goto out;
+	}
+
 	while (getline(&line, &linesize, file) != -1) {
 		struct reg reg = {};
 
@@ -274,7 +339,8 @@ static ssize_t parse_file(struct reg **regs, size_t *nregs,
 
 		include = include_file(line, filename);
 		if (include) {
-			index = parse_file(regs, nregs, index, include);
+			index = parse_file(regs, nregs, index, include,
+					   sources);
 			free(include);
 			if (index < 0) {
 				fprintf(stderr, "Error: %s:%d: %s",
@@ -326,7 +392,48 @@ ssize_t intel_reg_spec_file(struct reg **regs, const char *file)
 	size_t nregs = 0;
 	*regs = NULL;
 
-	return parse_file(regs, &nregs, 0, file);
+	return parse_file(regs, &nregs, 0, file, NULL);
+}
+
+/*
+ * Get register definitions from file, along with the files read for them:
+ * the file itself and everything it includes. Their names are relative to
+ * the directory of the file, unless they are outside of it. The sources are
+ * freed with intel_reg_spec_sources_free(), also on failure.
+ */
+ssize_t intel_reg_spec_file_sources(struct reg **regs, const char *file,
+				    struct reg_spec_source **sources,
+				    size_t *nsources)
+{
+	struct spec_sources s = {};
+	const char *dir = strrchr(file, '/');
+	size_t nregs = 0, i, len;
+	ssize_t ret;
+
+	*regs = NULL;
+	ret = parse_file(regs, &nregs, 0, file, &s);
+
+	len = dir ? dir - file + 1 : 0;
+	for (i = 0; i < s.count; i++) {
+		char *name = s.sources[i].filename;
+
+		if (len && !strncmp(name, file, len))
+			memmove(name, name + len, strlen(name + len) + 1);
+	}
+
+	*sources = s.sources;
+	*nsources = s.count;
+
+	return ret;
+}
+
+void intel_reg_spec_sources_free(struct reg_spec_source *sources, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		free(sources[i].filename);
+	free(sources);
 }
 
 /*
@@ -349,3 +456,511 @@ void intel_reg_spec_print_ports(void)
 	for (i = 0; i < ARRAY_SIZE(port_descs); i++)
 		printf("%s%s", i == 0 ? "" : ", ", port_descs[i].name);
 }
+
+/*
+ * The database is a header, the register entries in spec file order, the
+ * sources it was compiled from, the name and address indices, and the
+ * register and source names. Each source is stamped with the size and a
+ * 64-bit FNV-1a hash of its contents when compiled, a database with any
+ * source since changed or gone being stale. The indices are open
+ * addressed tables of entry index + 1, probed linearly, so that of several
+ * entries with the same key the one first in the spec is found first, as
+ * with the linear search of the parsed spec.
+ */
+#define REG_DB_MAGIC "IGTREGDB"
+#define REG_DB_VERSION 3
+#define REG_DB_BYTE_ORDER 0x01020304
+
+struct reg_db_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t count;
+	uint32_t index_size;
+	uint32_t strings_size;
+	uint32_t sources;
+};
+
+struct reg_db_entry {
+	uint32_t name;
+	uint32_t addr;
+	uint32_t mmio_offset;
+	uint32_t port_desc;
+};
+
+struct reg_db_source {
+	uint64_t size;
+	uint64_t hash;
+	uint32_t name;
+	uint32_t reserved;
+};
+
+struct reg_db {
+	void *map;
+	size_t size;
+	const struct reg_db_header *header;
+	const struct reg_db_entry *entries;
+	const struct reg_db_source *sources;
+	const uint32_t *name_index;
+	const uint32_t *addr_index;
+	const char *strings;
+};
+
+static uint32_t hash_name(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= tolower((unsigned char)*name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static uint32_t hash_addr(enum port_addr port, uint32_t addr)
+{
+	uint64_t key = (uint64_t)(uint32_t)port << 32 | addr;
+
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+
+	return key;
+}
+
+static uint32_t index_size(size_t n)
+{
+	uint32_t size = 16;
+
+	/* Keep the load factor at or below a half */
+	while (size < 2 * n)
+		size *= 2;
+
+	return size;
+}
+
+static void index_insert(uint32_t *index, uint32_t size, uint32_t hash,
+			 uint32_t value)
+{
+	uint32_t i = hash & (size - 1);
+
+	while (index[i])
+		i = (i + 1) & (size - 1);
+
+	index[i] = value;
+}
+
+static int port_desc_index(const struct port_desc *desc)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(port_descs); i++)
+		if (port_descs[i].port == desc->port &&
+		    strcmp(port_descs[i].name, desc->name) == 0)
+			return i;
+
+	return -1;
+}
+
+static int add_string(char **strings, size_t *size, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *tmp;
+	int offset;
+
+	tmp = realloc(*strings, *size + len);
+	if (!tmp)
+		return -1;
+	*strings = tmp;
+	memcpy(*strings + *size, str, len);
+
+	offset = *size;
+	*size += len;
+
+	return offset;
+}
+
+/*
+ * Write register definitions to a database file, stamped with the sources
+ * they were read from.
+ */
+int intel_reg_db_write(const char *filename, const struct reg *regs, size_t n,
+		       const struct reg_spec_source *sources, size_t nsources)
+{
+	struct reg_db_header header = {
+		.magic = REG_DB_MAGIC,
+		.version = REG_DB_VERSION,
+		.byte_order = REG_DB_BYTE_ORDER,
+		.count = n,
+		.index_size = index_size(n),
+		.sources = nsources,
+	};
+	struct reg_db_entry *entries;
+	struct reg_db_source *db_sources;
+	uint32_t *name_index, *addr_index;
+	char *strings = NULL;
+	size_t i, strings_size = 0;
+	FILE *file;
+	int ret = -1;
+
+	entries = calloc(n, sizeof(*entries));
+	db_sources = calloc(nsources, sizeof(*db_sources));
+	name_index = calloc(header.index_size, sizeof(*name_index));
+	addr_index = calloc(header.index_size, sizeof(*addr_index));
+	if (!entries || (nsources && !db_sources) || !name_index || !addr_index)
+		goto out;
+
+	for (i = 0; i < n; i++) {
+		const struct reg *reg = &regs[i];
+		int desc = port_desc_index(&reg->port_desc);
+		int name;
+
+		if (desc < 0)
+			goto out;
+
+		name = add_string(&strings, &strings_size,
+				  reg->name ? reg->name : "");
+		if (name < 0)
+			goto out;
+
+		entries[i].name = name;
+		entries[i].addr = reg->addr;
+		entries[i].mmio_offset = reg->mmio_offset;
+		entries[i].port_desc = desc;
+
+		if (reg->name)
+			index_insert(name_index, header.index_size,
+				     hash_name(reg->name), i + 1);
+		index_insert(addr_index, header.index_size,
+			     hash_addr(reg->port_desc.port,
+				       reg->addr + reg->mmio_offset), i + 1);
+	}
+
+	for (i = 0; i < nsources; i++) {
+		int name = add_string(&strings, &strings_size,
+				      sources[i].filename);
+
+		if (name < 0)
+			goto out;
+
+		db_sources[i].name = name;
+		db_sources[i].size = sources[i].size;
+		db_sources[i].hash = sources[i].hash;
+	}
+	header.strings_size = strings_size;
+
+	file = fopen(filename, "w");
+	if (!file) {
+		fprintf(stderr, "Error: fopen '%s': %s\n",
+			filename, strerror(errno));
+		goto out;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, file) == 1 &&
+	    fwrite(entries, sizeof(*entries), n, file) == n &&
+	    fwrite(db_sources, sizeof(*db_sources), nsources,
+		   file) == nsources &&
+	    fwrite(name_index, sizeof(*name_index), header.index_size,
+		   file) == header.index_size &&
+	    fwrite(addr_index, sizeof(*addr_index), header.index_size,
+		   file) == header.index_size &&
+	    fwrite(strings, 1, strings_size, file) == strings_size)
+		ret = 0;
+
+	if (fclose(file))
+		ret = -1;
+	if (ret) {
+		fprintf(stderr, "Error: writing '%s' failed\n", filename);
+		unlink(filename);
+	}
+
+out:
+	free(strings);
+	free(addr_index);
+	free(name_index);
+	free(db_sources);
+	free(entries);
+
+	return ret;
+}
+
+/*
+ * Map a register database. Returns NULL if the file is missing or was not
+ * written by a compatible intel_reg_spec_compile.
+ */
+struct reg_db *intel_reg_db_open(const char *filename)
+{
+	const struct reg_db_header *header;
+	struct reg_db *db;
+	struct stat st;
+	size_t size;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) || st.st_size < sizeof(*header)) {
+		close(fd);
+		return NULL;
+	}
+
+	db = calloc(1, sizeof(*db));
+	if (!db) {
+		close(fd);
+		return NULL;
+	}
+
+	db->size = st.st_size;
+	db->map = mmap(NULL, db->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (db->map == MAP_FAILED)
+		goto err_free;
+
+	header = db->map;
+	if (memcmp(header->magic, REG_DB_MAGIC, sizeof(header->magic)) ||
+	    header->version != REG_DB_VERSION ||
+	    header->byte_order != REG_DB_BYTE_ORDER)
+		goto err_unmap;
+
+	size = sizeof(*header) +
+		(size_t)header->count * sizeof(struct reg_db_entry) +
+		(size_t)header->sources * sizeof(struct reg_db_source) +
+		(size_t)header->index_size * 2 * sizeof(uint32_t) +
+		header->strings_size;
+	if (size != db->size ||
+	    header->index_size < 2 * (size_t)header->count ||
+	    header->index_size & (header->index_size - 1))
+		goto err_unmap;
+
+	if (header->strings_size &&
+	    ((const char *)db->map)[db->size - 1] != '\0')
+		goto err_unmap;
+
+	db->header = header;
+	db->entries = (const void *)(header + 1);
+	db->sources = (const void *)(db->entries + header->count);
+	db->name_index = (const void *)(db->sources + header->sources);
+	db->addr_index = db->name_index + header->index_size;
+	db->strings = (const void *)(db->addr_index + header->index_size);
+
+	return db;
+
+err_unmap:
+	munmap(db->map, db->size);
+err_free:
+	free(db);
+	return NULL;
+}
+
+void intel_reg_db_close(struct reg_db *db)
+{
+	if (!db)
+		return;
+
+	munmap(db->map, db->size);
+	free(db);
+}
+
+static const char *db_string(const struct reg_db *db, uint32_t offset)
+{
+	if (offset >= db->header->strings_size)
+		return NULL;
+
+	return db->strings + offset;
+}
+
+static const char *db_name(const struct reg_db *db,
+			   const struct reg_db_entry *e)
+{
+	return db_string(db, e->name);
+}
+
+/*
+ * Check that the sources of a database, looked up next to the spec file,
+ * have the contents it was compiled from. Returns 0 if so, -ESTALE if any
+ * of them was changed since, or the error reading it, with the name of
+ * that source in stale, pointing into the database.
+ */
+int intel_reg_db_check_sources(const struct reg_db *db, const char *spec,
+			       const char **stale)
+{
+	const char *dir = strrchr(spec, '/');
+	int len = dir ? dir - spec + 1 : 0;
+	char path[PATH_MAX];
+	uint64_t size, hash;
+	uint32_t i;
+	int fd, ret;
+
+	for (i = 0; i < db->header->sources; i++) {
+		const char *name = db_string(db, db->sources[i].name);
+
+		*stale = name ? name : "?";
+		if (!name)
+			return -ESTALE;
+
+		if (*name == '/')
+			snprintf(path, sizeof(path), "%s", name);
+		else
+			snprintf(path, sizeof(path), "%.*s%s", len, spec, name);
+
+		fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return -errno;
+
+		ret = hash_source(fd, &size, &hash) ? -errno : 0;
+		close(fd);
+		if (ret)
+			return ret;
+
+		if (size != db->sources[i].size || hash != db->sources[i].hash)
+			return -ESTALE;
+	}
+
+	*stale = NULL;
+
+	return 0;
+}
+
+static const struct port_desc *db_port_desc(const struct reg_db_entry *e)
+{
+	if (e->port_desc >= ARRAY_SIZE(port_descs))
+		return &port_descs[0];
+
+	return &port_descs[e->port_desc];
+}
+
+/* Entries with their name out of the strings are rejected */
+static int db_entry_to_reg(const struct reg_db *db,
+			   const struct reg_db_entry *e, struct reg *reg)
+{
+	const char *name = db_name(db, e);
+
+	if (!name)
+		return -1;
+
+	reg->port_desc = *db_port_desc(e);
+	reg->addr = e->addr;
+	reg->mmio_offset = e->mmio_offset;
+	reg->name = (char *)name;
+
+	return 0;
+}
+
+static const struct reg_db_entry *
+db_lookup(const struct reg_db *db, const uint32_t *index, uint32_t hash,
+	  bool (*match)(const struct reg_db *db,
+			const struct reg_db_entry *e, const void *key),
+	  const void *key)
+{
+	uint32_t mask = db->header->index_size - 1;
+	uint32_t i;
+
+	for (i = hash & mask; index[i]; i = (i + 1) & mask) {
+		const struct reg_db_entry *e;
+
+		if (index[i] > db->header->count)
+			break;
+
+		e = &db->entries[index[i] - 1];
+		if (match(db, e, key))
+			return e;
+	}
+
+	return NULL;
+}
+
+struct name_key {
+	enum port_addr port;
+	const char *name;
+};
+
+static bool match_name(const struct reg_db *db,
+		       const struct reg_db_entry *e, const void *data)
+{
+	const struct name_key *key = data;
+	const char *name = db_name(db, e);
+
+	return db_port_desc(e)->port == key->port &&
+		name && strcasecmp(name, key->name) == 0;
+}
+
+/*
+ * Look up a register by name, as set_reg_by_name() in intel_reg would.
+ * On success, reg->name points into the database.
+ */
+int intel_reg_db_find_name(const struct reg_db *db, enum port_addr port,
+			   const char *name, struct reg *reg)
+{
+	struct name_key key = { port, name };
+	const struct reg_db_entry *e;
+
+	e = db_lookup(db, db->name_index, hash_name(name), match_name, &key);
+	if (!e)
+		return -1;
+
+	return db_entry_to_reg(db, e, reg);
+}
+
+struct addr_key {
+	enum port_addr port;
+	uint32_t addr;
+};
+
+static bool match_addr(const struct reg_db *db,
+		       const struct reg_db_entry *e, const void *data)
+{
+	const struct addr_key *key = data;
+
+	return db_port_desc(e)->port == key->port &&
+		e->addr + e->mmio_offset == key->addr;
+}
+
+/*
+ * Look up a register by port and address, including any MMIO offset.
+ * On success, reg->name points into the database.
+ */
+int intel_reg_db_find_addr(const struct reg_db *db, enum port_addr port,
+			   uint32_t addr, struct reg *reg)
+{
+	struct addr_key key = { port, addr };
+	const struct reg_db_entry *e;
+
+	e = db_lookup(db, db->addr_index, hash_addr(port, addr),
+		      match_addr, &key);
+	if (!e)
+		return -1;
+
+	return db_entry_to_reg(db, e, reg);
+}
+
+/*
+ * Get all register definitions from a database, in spec file order, to be
+ * freed with intel_reg_spec_free().
+ */
+ssize_t intel_reg_db_regs(const struct reg_db *db, struct reg **regs)
+{
+	size_t i, n = db->header->count;
+
+	*regs = calloc(n ? n : 1, sizeof(**regs));
+	if (!*regs)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		const struct reg_db_entry *e = &db->entries[i];
+
+		if (db_entry_to_reg(db, e, &(*regs)[i]))
+			goto err;
+		(*regs)[i].name = strdup(db_name(db, e));
+		if (!(*regs)[i].name)
+			goto err;
+	}
+
+	return n;
+
+err:
+	intel_reg_spec_free(*regs, i);
+	*regs = NULL;
+	return -1;
+}
@@ -71,9 +71,41 @@ static inline void *recalloc(void *ptr, size_t nmemb, size_t size)
 int parse_port_desc(struct reg *reg, const char *s);
 ssize_t intel_reg_spec_builtin(struct reg **regs, uint32_t devid);
 ssize_t intel_reg_spec_file(struct reg **regs, const char *filename);
+
+struct reg_spec_source {
+	char *filename;
+	uint64_t size;
+	uint64_t hash;
+};
+
+ssize_t intel_reg_spec_file_sources(struct reg **regs, const char *filename,
+				    struct reg_spec_source **sources,
+				    size_t *nsources);
+void intel_reg_spec_sources_free(struct reg_spec_source *sources, size_t n);
 void intel_reg_spec_free(struct reg *regs, size_t n);
 int intel_reg_spec_decode(char *buf, size_t bufsize, const struct reg *reg,
 			  uint32_t val, uint32_t devid);
 void intel_reg_spec_print_ports(void);
 
+/*
+ * Precompiled register spec, as written by intel_reg_spec_compile at build
+ * time next to each platform spec file, with hash indices by name and by
+ * port and address.
+ */
+#define REG_DB_SUFFIX ".regdb"
+
+struct reg_db;
+
+int intel_reg_db_write(const char *filename, const struct reg *regs, size_t n,
+		       const struct reg_spec_source *sources, size_t nsources);
+struct reg_db *intel_reg_db_open(const char *filename);
+void intel_reg_db_close(struct reg_db *db);
+int intel_reg_db_check_sources(const struct reg_db *db, const char *spec,
+			       const char **stale);
+int intel_reg_db_find_name(const struct reg_db *db, enum port_addr port,
+			   const char *name, struct reg *reg);
+int intel_reg_db_find_addr(const struct reg_db *db, enum port_addr port,
+			   uint32_t addr, struct reg *reg);
+ssize_t intel_reg_db_regs(const struct reg_db *db, struct reg **regs);
+
 #endif /* __INTEL_REG_SPEC_H__ */
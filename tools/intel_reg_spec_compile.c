@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Build time helper compiling a register spec file, and everything it
+ * includes, into the database intel_reg maps instead of parsing the spec.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "intel_reg_spec.h"
+
+int main(int argc, char *argv[])
+{
+	struct reg_spec_source *sources;
+	struct reg *regs;
+	size_t nsources;
+	ssize_t count;
+	int ret;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s SPEC DATABASE\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	count = intel_reg_spec_file_sources(&regs, argv[1],
+					    &sources, &nsources);
+	if (count <= 0) {
+		fprintf(stderr, "Error: reading '%s' failed\n", argv[1]);
+		intel_reg_spec_sources_free(sources, nsources);
+		return EXIT_FAILURE;
+	}
+
+	ret = intel_reg_db_write(argv[2], regs, count, sources, nsources);
+	intel_reg_spec_free(regs, count);
+	intel_reg_spec_sources_free(sources, nsources);
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}